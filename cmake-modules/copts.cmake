@@ -1,11 +1,30 @@
 list(APPEND LLVM_FLAGS
     "-Wno-gnu-anonymous-struct"
     "-Wno-nested-anon-types"
-    "-mavx"
     "-Wall"
     "-Werror"
 )
 
+list(APPEND LLVM_AVX_FLAGS
+    "-mavx"
+)
+
+list(APPEND LLVM_SSE42_FLAGS
+    "-msse4.2"
+)
+
+list(APPEND LLVM_AVX2_FLAGS
+    "-mavx2"
+)
+
+list(APPEND LLVM_AVX512_FLAGS
+    "-mavx512f"
+)
+
+list(APPEND LLVM_FP_CONTRACT_OFF_FLAGS
+    "-ffp-contract=off"
+)
+
 list(APPEND MSVC_FLAGS
     "/W3"
     "/WX"
@@ -17,6 +36,18 @@ list(APPEND MSVC_FLAGS
 	"/std:c++latest"
 )
 
+list(APPEND MSVC_AVX2_FLAGS
+    "/arch:AVX2"
+)
+
+list(APPEND MSVC_AVX512_FLAGS
+    "/arch:AVX512"
+)
+
+list(APPEND MSVC_FP_CONTRACT_OFF_FLAGS
+    "/fp:precise"
+)
+
 macro(fix_default_compiler_settings_)
   if (MSVC)
     # For MSVC, CMake sets certain flags to defaults we want to override.
@@ -57,7 +57,7 @@ function(mg_cc_executable)
         ${NAME}
         ${MG_CC_SRCS}
     )
-    message(${MG_CC_DEFS})
+    message("${MG_CC_DEFS}")
     target_compile_definitions(${NAME} PUBLIC ${MG_CC_DEFS})
     target_include_directories(${NAME} PUBLIC ${MG_CC_DEPS_DIR})
     target_link_libraries(${NAME} PUBLIC ${MG_CC_DEPS})
@@ -1,5 +1,11 @@
 if(WIN32)
+    set(BASE_CPP_FLAGS ${MSVC_FLAGS})
     set(CPP_FLAGS ${MSVC_FLAGS})
+    # sse4.2 intrinsics need no flag on x64
+    set(SSE42_FLAGS "")
+    set(AVX2_FLAGS ${MSVC_AVX2_FLAGS})
+    set(AVX512_FLAGS ${MSVC_AVX512_FLAGS})
+    set(FP_CONTRACT_OFF_FLAGS ${MSVC_FP_CONTRACT_OFF_FLAGS})
     set(VULKAN_LIB "$ENV{VULKAN_SDK}/Lib/vulkan-1.lib")
     set(PLATFORM_LIB "")
 else()
@@ -14,7 +20,15 @@ else()
         set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -g -O2 -std=c++17")
     endif()
 
-    set(CPP_FLAGS ${LLVM_FLAGS})
+    # BASE_CPP_FLAGS targets the baseline x86-64 cpu, for code that picks its instruction set at runtime
+    set(BASE_CPP_FLAGS ${LLVM_FLAGS})
+    set(CPP_FLAGS ${LLVM_FLAGS} ${LLVM_AVX_FLAGS})
+    set(SSE42_FLAGS ${LLVM_SSE42_FLAGS})
+    set(AVX2_FLAGS ${LLVM_AVX2_FLAGS})
+    set(AVX512_FLAGS ${LLVM_AVX512_FLAGS})
+    # no a * b + c fused into an fma, for code that has to round the same in its scalar and simd paths
+    set(FP_CONTRACT_OFF_FLAGS ${LLVM_FP_CONTRACT_OFF_FLAGS})
     set(VULKAN_LIB "$ENV{VULKAN_SDK}/lib/libvulkan.so")
     set(PLATFORM_LIB "stdc++fs")
 endif()
+find_package(Threads REQUIRED)
@@ -1,7 +0,0 @@
-echo -n Starting compile and transfer
-source ./shaders.sh
-
-echo -n Copying shaderPipelineInput
-cp shaderPipelineInput.h ../../src/engine/vulkan 
-
-echo -n finish
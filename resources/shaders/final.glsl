@@ -3,18 +3,6 @@
 #extension GL_ARB_shading_language_420pack : enable
 #extension GL_ARB_separate_shader_objects : enable
 
-struct Light {
-	vec4 position;
-	vec4 color;
-};
-const int lightCount = 32;
-
-layout (set = 0, binding = 0) uniform Ubo  {
-	mat4 projection;
-	mat4 view;
-	Light lights[lightCount];
-} ubo;
-
 @vert
 layout (location = 0) out vec2 outUV;
 
@@ -28,15 +16,25 @@ void main() {
 
 @frag
 #include "utils.hglsl"
+#include "clusteredLighting.hglsl"
+
+layout (set = 0, binding = 0) uniform Ubo  {
+	mat4 projection;
+	ClusterGrid grid;
+} ubo;
 
 layout(set = 1, binding = 0) uniform sampler samplers[2];
 layout(set = 1, binding = 1) uniform texture2D textures[128];
 
+// the lights of every cluster, written by clusterLights.comp
+layout(set = 2, binding = 0) readonly buffer Counts { uint values[]; } counts;
+layout(set = 3, binding = 0) readonly buffer Indices { uint values[]; } indices;
+
 layout(push_constant) uniform TextureIndices {
 	int normalIndex;
 	int diffuseIndex;
   int ssaoBluredIndex;
-  int worldViewPostionIndex;
+  int depthIndex;
 }pc;
 
 layout (location = 0) in vec2 inUV;
@@ -55,19 +53,26 @@ void main()  {
 	vec2 textCoord = inUV;
 	textCoord.y = 1.0 - textCoord.y;
 
-	vec3 N = normalize(sphericalToCartesian(texture(sampler2D(textures[pc.normalIndex], samplers[linearBorder]), textCoord).xy));
+	const float depth = texelFetch(sampler2D(textures[pc.depthIndex], samplers[linearBorder]), ivec2(gl_FragCoord.xy), 0).r;
+	if (depth >= 1.0) {
+		outFragcolor = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+	vec3 N = octahedralDecode(texture(sampler2D(textures[pc.normalIndex], samplers[linearBorder]), textCoord).xy);
 	vec4 diffuse_material = texture(sampler2D(textures[pc.diffuseIndex], samplers[linearBorder]), textCoord);
-	float ssao = texture(sampler2D(textures[pc.ssaoBluredIndex], samplers[linearBorder]), textCoord).r;	
-	vec3 V = texture(sampler2D(textures[pc.worldViewPostionIndex], samplers[linearBorder]), textCoord).xyz;
+	float ssao = texture(sampler2D(textures[pc.ssaoBluredIndex], samplers[linearBorder]), textCoord).r * diffuse_material.a;
+	vec3 V = viewPositionFromDepth(textCoord, depth, ubo.projection);
+
+	const uint cluster = clusterOfPixel(textCoord, V.z, ubo.grid);
+	const uint firstIndex = cluster * ubo.grid.size.w;
+	const uint count = counts.values[cluster];
 
 	vec3 outputColor = vec3(0.0);
-	for(int i = 0; i < lightCount; i++) {
-		Light light = ubo.lights[i];
-		const float ambient = 0.0;
-		vec3 lightPos = (ubo.view * light.position).xyz;
-		vec3 lightDir = lightPos - V;
+	for(uint i = 0; i < count; i++) {
+		PointLight light = lights.lights[indices.values[firstIndex + i]];
+		vec3 lightDir = light.positionRange.xyz - V;
 
-		float atten = light.color.w / (pow(length(lightDir), 2.0) + 1.0);
+		float atten = lightAttenuation(length(lightDir), light);
 
 		vec3 L = normalize(lightDir);
 		vec3 H = normalize(V + L);
@@ -80,7 +85,7 @@ void main()  {
 		vec3 color = diffuseColor * diffuse(N, L);
 		color += specularColor * specularBlinnPhong(N, H, specularPower);
 
-		outputColor += lin2srgb(color) * atten * light.color.xyz;
+		outputColor += lin2srgb(color) * atten * light.colorIntensity.xyz;
 	}
 	outFragcolor = vec4(outputColor * ssao, 1.0);
 }
\ No newline at end of file
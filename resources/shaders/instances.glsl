@@ -0,0 +1,61 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout (set = 0, binding = 0) uniform Ubo {
+	mat4 viewProjection;
+	uint capacity; // the length of every instance stream
+} ubo;
+
+// the color of the draw, it tints the colors of its instances
+layout(push_constant) uniform Material {
+	vec4 color;
+	uint lit; // 0 for flat primitives, 1 shades the faces by their normal
+} material;
+
+@vert
+
+// the streams x, y, z, size, color and draw one after the other
+layout(set = 1, binding = 0) readonly buffer Instances {
+	uint values[];
+} instances;
+
+// the instances that survived cullInstances.comp, the draw starts at its own list with firstInstance
+layout(set = 2, binding = 0) readonly buffer Visible {
+	uint values[];
+} visible;
+
+layout (location = 0) in vec3 in_position;
+layout (location = 0) out vec3 out_world;
+layout (location = 1) flat out vec4 out_color;
+
+out gl_PerVertex {
+	vec4 gl_Position;
+};
+
+void main() {
+	const uint index = visible.values[gl_InstanceIndex];
+	const vec3 position = vec3(uintBitsToFloat(instances.values[index]),
+	                           uintBitsToFloat(instances.values[ubo.capacity + index]),
+	                           uintBitsToFloat(instances.values[ubo.capacity * 2 + index]));
+	const float size = uintBitsToFloat(instances.values[ubo.capacity * 3 + index]);
+
+	out_world = position + in_position * size;
+	out_color = unpackUnorm4x8(instances.values[ubo.capacity * 4 + index]) * material.color;
+	gl_Position = ubo.viewProjection * vec4(out_world, 1.0);
+}
+
+@frag
+layout (location = 0) in vec3 in_world;
+layout (location = 1) flat in vec4 in_color;
+layout (location = 0) out vec4 out_frag_color;
+
+void main() {
+	float shade = 1.0;
+	if (material.lit != 0) {
+		// the cube has no normals, a face is flat so the derivatives of the position give its normal
+		const vec3 normal = normalize(cross(dFdx(in_world), dFdy(in_world)));
+		shade = 0.35 + 0.65 * abs(dot(normal, normalize(vec3(0.4, 0.8, -0.45))));
+	}
+	out_frag_color = vec4(in_color.rgb * shade, in_color.a);
+}
@@ -14,31 +14,32 @@ layout (binding = 0) uniform Ubo {
 	mat4 mNormal;
 } ubo;
 
-layout (location = 0) out vec3 outWorldViewPosition;
-layout (location = 1) out vec3 outNormal;
+// the diffuse color of every draw, draws are drawn with their index as the instance
+layout (set = 1, binding = 0) readonly buffer DrawMaterials {
+	vec4 diffuse[];
+} drawMaterials;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) flat out vec4 outDiffuse;
 
 void main()  {
 	gl_Position = ubo.projection * ubo.view * ubo.model * vec4(position, 1.0);
-	outWorldViewPosition = (ubo.view * ubo.model * vec4(position, 1.0)).xyz;
 	outNormal = mat3(ubo.view) * normal;
+	outDiffuse = drawMaterials.diffuse[gl_InstanceIndex];
 }
 
 @frag
 #include "utils.hglsl"
 
-layout (location = 0) in vec3 inWorldPos;
-layout (location = 1) in vec3 inNormal;
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) flat in vec4 inDiffuse;
 
+// the view space position is not stored, the passes reconstruct it from the depth buffer
 layout (location = 0) out vec2 outNormal;
+// rgb albedo, a the occlusion baked into the material
 layout (location = 1) out vec4 outAlbedo;
-layout (location = 2) out vec4 outWordViewPosition;
-
-layout(push_constant) uniform Material {
-	vec4 diffuse;
-} material;
 
 void main() {
-	outNormal = cartesianToSpherical(normalize(inNormal));
-	outAlbedo = material.diffuse;
-	outWordViewPosition = vec4(inWorldPos, 1);
+	outNormal = octahedralEncode(normalize(inNormal));
+	outAlbedo = vec4(inDiffuse.rgb, 1.0);
 }
\ No newline at end of file
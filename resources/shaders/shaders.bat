@@ -1,32 +1,9 @@
 @echo off
 
-SET buildDir=%~dp0%build
-
-if not exist %buildDir% (
-	@echo on
-	echo Creating directory build
-	@echo.
-	mkdir %buildDir%
-)
+rem Compiles the shaders and regenerates their headers, usage: shaders.bat [cmake build directory]
+SET buildDir=%~dp0..\..\build
+if not -%1-==-- SET buildDir=%1
 
 @echo Compiling shaders
-@echo.
-
-@echo off
-if not -%1-==-- glsl-compiler.exe %1 %2
-if -%1-==-- for %%f in (*.glsl) do glsl-compiler.exe %%f	
-if -%1-==-- for %%f in (*.comp) do glsl-compiler.exe %%f	
-if -%1-==-- for %%f in (*.ray) do glsl-compiler.exe %%f	
-
-@echo on
-
-@echo.
+cmake --build %buildDir% --target mg-shaders || exit /b 1
 @echo Finished compiling shaders
-@echo.
-
-
-@echo Creating shaderPipelineInput.h
-@echo off
-spirv-reflection.exe build
-@echo on
-@echo Finish
@@ -1,10 +1,6 @@
-echo -n "Compiling shaders"
+# Compiles the shaders and regenerates their headers, usage: shaders.sh [cmake build directory]
+buildDir="${1:-../../build}"
 
-mkdir -c build
-
-for filename in ./*.glsl ./*.comp ./*.ray; do
-	./glsl-compiler "${filename}" 
-done
-
-echo -n "Finish compiling shaders"
-echo -n ""
+echo "Compiling shaders"
+cmake --build "${buildDir}" --target mg-shaders || exit 1
+echo "Finished compiling shaders"
@@ -29,7 +29,7 @@ layout(set = 1, binding = 1) uniform texture2D textures[128];
 
 layout(push_constant) uniform TextureIndices {
 	int normalIndex;
-    int wordViewPositionIndex;
+    int depthIndex;
     int noiseIndex;
 }pc;
 
@@ -44,9 +44,11 @@ void main()  {
 	vec2 textCoord = inUV;
 	textCoord.y = 1.0 - textCoord.y;
 
-	// get fragPosition from depth value
-	vec3 fragPos = texture(sampler2D(textures[pc.wordViewPositionIndex], samplers[linearBorder]), textCoord).xyz;
-	vec3 normal = sphericalToCartesian(texture(sampler2D(textures[pc.normalIndex], samplers[linearBorder]), textCoord).xy).xyz;
+	// get fragPosition from depth value, depth formats can not be filtered so the depths are fetched
+	const ivec2 size = textureSize(sampler2D(textures[pc.depthIndex], samplers[linearBorder]), 0);
+	const float depth = texelFetch(sampler2D(textures[pc.depthIndex], samplers[linearBorder]), ivec2(textCoord * size), 0).r;
+	vec3 fragPos = viewPositionFromDepth(textCoord, depth, ubo.projection);
+	vec3 normal = octahedralDecode(texture(sampler2D(textures[pc.normalIndex], samplers[linearBorder]), textCoord).xy);
 	vec3 randomVec = texture(sampler2D(textures[pc.noiseIndex], samplers[linearRepeat]), textCoord * ubo.noiseScale).xyz;
 	
 	// create TBN change-of-basis matrix: from tangent-space to view-space
@@ -68,8 +70,9 @@ void main()  {
         
         // get sample depth
 		offset.y = 1.0-offset.y;
-        const float sampleDepth = texture(sampler2D(textures[pc.wordViewPositionIndex], samplers[linearBorder]
-        ), offset.xy).z; // get depth value of kernel sample
+        const ivec2 sampleTexel = clamp(ivec2(offset.xy * size), ivec2(0), size - 1);
+        const float sampleDepth = viewDepth(texelFetch(sampler2D(textures[pc.depthIndex], samplers[linearBorder]
+        ), sampleTexel, 0).r, ubo.projection); // get depth value of kernel sample
         
         // range check & accumulate
 		const float depthDiff = max(abs(fragPos.z - sampleDepth), 0.00001);
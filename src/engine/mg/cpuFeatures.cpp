@@ -0,0 +1,68 @@
+#include "cpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace mg {
+
+namespace {
+
+struct CpuidRegisters {
+  uint32_t eax, ebx, ecx, edx;
+};
+
+CpuidRegisters cpuid(uint32_t leaf, uint32_t subleaf) {
+  CpuidRegisters registers = {};
+#if defined(_MSC_VER)
+  int32_t values[4];
+  __cpuidex(values, int32_t(leaf), int32_t(subleaf));
+  registers = {uint32_t(values[0]), uint32_t(values[1]), uint32_t(values[2]), uint32_t(values[3])};
+#elif defined(__x86_64__) || defined(__i386__)
+  if (leaf <= __get_cpuid_max(0, nullptr))
+    __cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+#endif
+  return registers;
+}
+
+// the register state the os saves on context switches, XCR0
+uint64_t enabledRegisterState() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386__)
+  uint32_t eax, edx;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (uint64_t(edx) << 32) | eax;
+#else
+  return 0;
+#endif
+}
+
+bool hasBit(uint32_t value, uint32_t bit) { return (value >> bit) & 1; }
+
+CpuFeatures detectCpuFeatures() {
+  CpuFeatures features = {};
+  const auto registers = cpuid(1, 0);
+  features.sse42 = hasBit(registers.ecx, 20);
+  // xgetbv is only there when the os has enabled it
+  if (!hasBit(registers.ecx, 27))
+    return features;
+  const auto extendedRegisters = cpuid(7, 0);
+  const bool osSavesYmm = (enabledRegisterState() & 0x6) == 0x6;
+  const bool osSavesZmm = osSavesYmm && (enabledRegisterState() & 0xe0) == 0xe0;
+  features.avx2 = osSavesYmm && hasBit(registers.ecx, 28) && hasBit(extendedRegisters.ebx, 5);
+  features.avx512 = features.avx2 && osSavesZmm && hasBit(extendedRegisters.ebx, 16);
+  return features;
+}
+
+} // namespace
+
+const CpuFeatures &cpuFeatures() {
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+
+} // namespace mg
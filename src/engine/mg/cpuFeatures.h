@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace mg {
+
+// The instruction sets the cpu has and the os saves the registers of, kernels compiled for one of them are only picked
+// at runtime when it is set here.
+struct CpuFeatures {
+  bool sse42;
+  bool avx2;   // with the ymm registers saved
+  bool avx512; // avx512f with the opmask and zmm registers saved
+};
+
+// detected with cpuid and xgetbv on the first call
+const CpuFeatures &cpuFeatures();
+
+#if defined(__AVX2__)
+// lanes below count are set, masked loads read 0 in the other lanes and masked stores leave them untouched
+inline __m256i tailMask(uint32_t count) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(int32_t(count)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+#endif
+
+} // namespace mg
@@ -0,0 +1,141 @@
+#include "fileWatcher.h"
+
+#include "mg/logger.h"
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace mg {
+
+namespace {
+
+bool hasExtension(const std::string &fileName, const std::string &extension) {
+  return fileName.size() >= extension.size() &&
+         fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+#if !defined(__linux__)
+constexpr auto SCAN_INTERVAL = std::chrono::milliseconds(250);
+
+std::unordered_map<std::string, int64_t> scanWriteTimes(const std::string &directory, const std::string &extension) {
+  namespace fs = std::filesystem;
+  std::unordered_map<std::string, int64_t> writeTimes;
+  std::error_code error;
+  for (auto &file : fs::directory_iterator(directory, error)) {
+    auto fileName = file.path().filename().generic_string();
+    if (!hasExtension(fileName, extension))
+      continue;
+    const auto writeTime = file.last_write_time(error);
+    if (!error)
+      writeTimes[fileName] = int64_t(writeTime.time_since_epoch().count());
+  }
+  return writeTimes;
+}
+#endif
+
+} // namespace
+
+bool FileWatcher::open(const std::string &directory, const std::string &extension, float settleSeconds) {
+  mgAssert(!_isOpen);
+  _directory = directory;
+  _extension = extension;
+  _settle = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(settleSeconds));
+  _changed.clear();
+#if defined(__linux__)
+  _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_fd < 0)
+    return false;
+  // a compiler either writes the file in place or renames a temporary file over it
+  _watch = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (_watch < 0) {
+    ::close(_fd);
+    _fd = -1;
+    return false;
+  }
+#else
+  std::error_code error;
+  if (!std::filesystem::is_directory(directory, error))
+    return false;
+  _writeTimes = scanWriteTimes(directory, extension);
+  _lastScan = Clock::now();
+#endif
+  _isOpen = true;
+  return true;
+}
+
+void FileWatcher::close() {
+  if (!_isOpen)
+    return;
+#if defined(__linux__)
+  inotify_rm_watch(_fd, _watch);
+  ::close(_fd);
+  _fd = -1;
+  _watch = -1;
+#else
+  _writeTimes.clear();
+#endif
+  _changed.clear();
+  _isOpen = false;
+}
+
+FileWatcher::~FileWatcher() { close(); }
+
+void FileWatcher::readChanges() {
+#if defined(__linux__)
+  alignas(inotify_event) char buffer[4096];
+  for (;;) {
+    const auto length = read(_fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      break;
+    for (auto offset = decltype(length)(0); offset < length;) {
+      const auto event = (const inotify_event *)(buffer + offset);
+      offset += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW)
+        LOG("file watcher queue overflow in " << _directory << ", changes were lost");
+      if (event->len == 0)
+        continue;
+      const std::string fileName = event->name;
+      if (hasExtension(fileName, _extension)) {
+        _changed.push_back(fileName);
+        _lastChange = Clock::now();
+      }
+    }
+  }
+#else
+  const auto now = Clock::now();
+  if (now - _lastScan < SCAN_INTERVAL)
+    return;
+  _lastScan = now;
+  auto writeTimes = scanWriteTimes(_directory, _extension);
+  for (const auto &writeTime : writeTimes) {
+    const auto it = _writeTimes.find(writeTime.first);
+    if (it == _writeTimes.end() || it->second != writeTime.second) {
+      _changed.push_back(writeTime.first);
+      _lastChange = now;
+    }
+  }
+  _writeTimes = std::move(writeTimes);
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll() {
+  if (!_isOpen)
+    return {};
+  readChanges();
+  if (_changed.empty() || Clock::now() - _lastChange < _settle)
+    return {};
+
+  std::sort(std::begin(_changed), std::end(_changed));
+  _changed.erase(std::unique(std::begin(_changed), std::end(_changed)), std::end(_changed));
+  auto changed = std::move(_changed);
+  _changed.clear();
+  return changed;
+}
+
+} // namespace mg
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "mg/mgUtils.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mg {
+
+// Reports the files in one directory, not its sub directories, that were written or moved into it. inotify on Linux,
+// elsewhere the directory's time stamps are compared a few times a second.
+class FileWatcher : mg::nonCopyable {
+public:
+  // a compiler writes a file at a time, the changes are reported once the directory has been quiet for settleSeconds
+  bool open(const std::string &directory, const std::string &extension, float settleSeconds = 0.1f);
+  void close();
+  bool isOpen() const { return _isOpen; }
+
+  // file names that changed since the previous call that returned any, never blocks
+  std::vector<std::string> poll();
+
+  ~FileWatcher();
+
+private:
+  void readChanges();
+
+  using Clock = std::chrono::steady_clock;
+
+  bool _isOpen = false;
+  std::string _directory;
+  std::string _extension;
+  Clock::duration _settle = {};
+  Clock::time_point _lastChange = {};
+  std::vector<std::string> _changed;
+#if defined(__linux__)
+  int _fd = -1;
+  int _watch = -1;
+#else
+  Clock::time_point _lastScan = {};
+  std::unordered_map<std::string, int64_t> _writeTimes;
+#endif
+};
+
+} // namespace mg
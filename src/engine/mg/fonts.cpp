@@ -20,8 +20,8 @@ static const uint32_t verticalDpi = 96;
 void validateTexts(const mg::Texts &texts) {
   const auto &fontsToTexts = texts.fontsToTexts;
   for (uint32_t i = 0; i < uint32_t(mg::FONT_TYPE::SIZE); ++i) {
-    for (auto &text : fontsToTexts[i]) {
-      mg::mgSystem.fonts.validateFontCharacters((mg::FONT_TYPE)i, text.text);
+    for (uint32_t j = 0; j < texts.textsPerFont[i]; ++j) {
+      mg::mgSystem.fonts.validateFontCharacters((mg::FONT_TYPE)i, fontsToTexts[i][j].text);
     }
   }
 }
@@ -46,10 +46,11 @@ void Fonts::destroy() {
   FT_Done_FreeType(_ftLibrary);
 }
 
-void Fonts::validateFontCharacters(FONT_TYPE fontType, const std::string& text) {
+void Fonts::validateFontCharacters(FONT_TYPE fontType, const char *text) {
   Font* font = accessFont(fontType);
 
-  for(const auto& character : text) {
+  for(const char *c = text; *c; ++c) {
+    const char character = *c;
     const auto characterIt = font->characters.find(character);
     if(characterIt == std::end(font->characters))
       loadFontCharacter(font, character, font->fontMapSize.x, true);
@@ -103,11 +104,11 @@ float Fonts::getFontAscender(FONT_TYPE fontType) const {
   return font.ascender;
 }
 
-float Fonts::calcTextWidth(const std::string& text, FONT_TYPE fontType) const {
+float Fonts::calcTextWidth(const char *text, FONT_TYPE fontType) const {
   float textWidth = 0.0f;
   const auto &font = getFont(fontType);
-  for(uint32_t i = 0; i < uint32_t(text.size()); ++i) {  
-    const auto &character = getFontCharacter(font, text[i]);
+  for(const char *c = text; *c; ++c) {
+    const auto &character = getFontCharacter(font, *c);
     textWidth += float(character.advance);
   }
   return textWidth;
@@ -29,7 +29,7 @@ public:
   void init();    // Needed because vulkan has not been initialized before scene is created
   void destroy(); // Needed because vulkan has been destoyed before scene is destroyed
 
-  void validateFontCharacters(FONT_TYPE fontType, const std::string &text);
+  void validateFontCharacters(FONT_TYPE fontType, const char *text);
   float getFontLineHeight(FONT_TYPE fontType) const;
   glm::vec4 getFontBbox(FONT_TYPE fontType) const;
   float getFontAscender(FONT_TYPE fontType) const;
@@ -39,7 +39,7 @@ public:
   glm::uvec2 getFontMapSize(FONT_TYPE fontType) const;
   mg::TextureId getFontGlyphMap(FONT_TYPE fontType) const;
 
-  float calcTextWidth(const std::string &text, FONT_TYPE fontType) const;
+  float calcTextWidth(const char *text, FONT_TYPE fontType) const;
 
 private:
   struct Font {
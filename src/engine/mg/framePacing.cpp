@@ -0,0 +1,159 @@
+#include "framePacing.h"
+
+#include "mg/logger.h"
+#include "mg/mgAssert.h"
+#include "mg/mgUtils.h"
+#include "vulkan/swapChain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace mg {
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr uint32_t NR_OF_FRAME_SAMPLES = 120;
+// sleep_for overshoots by up to a scheduler tick, the rest of the wait spins
+constexpr double SPIN_SECONDS = 0.002;
+
+struct FramePacing {
+  Clock::time_point start;
+  double frameStart = 0.0;
+  double nextFrameStart = 0.0;
+  float smoothedFrameTime = 0.0f;
+
+  float frameTimes[NR_OF_FRAME_SAMPLES] = {};
+  uint32_t nrOfFrameTimes = 0;
+  uint32_t frameTimeIndex = 0;
+
+  double inputSampled = 0.0;
+  double inputSampledPerSlot[MAX_FRAMES_IN_FLIGHT] = {};
+  float gpuWait = 0.0f;
+  float limiterSleep = 0.0f;
+  float inputToGpuComplete = 0.0f;
+} framePacing;
+
+double secondsSinceStart() {
+  return std::chrono::duration<double>(Clock::now() - framePacing.start).count();
+}
+
+void waitUntil(double time) {
+  const double sleepTime = time - secondsSinceStart() - SPIN_SECONDS;
+  if (sleepTime > 0.0)
+    std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
+  while (secondsSinceStart() < time)
+    std::this_thread::yield();
+}
+
+void limitFrameRate() {
+  const auto maxFps = vkContext.framePacing.maxFps;
+  framePacing.limiterSleep = 0.0f;
+  if (maxFps == 0)
+    return;
+  const double period = 1.0 / maxFps;
+  const double now = secondsSinceStart();
+  // a frame that ran long moves the schedule instead of letting the following frames catch up in a burst
+  if (now > framePacing.nextFrameStart + period)
+    framePacing.nextFrameStart = now;
+  if (now < framePacing.nextFrameStart) {
+    waitUntil(framePacing.nextFrameStart);
+    framePacing.limiterSleep = float(secondsSinceStart() - now);
+  }
+  framePacing.nextFrameStart += period;
+}
+
+} // namespace
+
+void initFramePacing(const FramePacingSettings &settings) {
+  auto &pacing = vkContext.framePacing;
+  pacing = settings;
+  pacing.framesInFlight = std::min(std::max(pacing.framesInFlight, 1u), MAX_FRAMES_IN_FLIGHT);
+  pacing.swapChainImages = std::max(pacing.swapChainImages, 1u);
+  vkContext.commandBuffers.nrOfBuffers = pacing.framesInFlight;
+
+  framePacing = {};
+  framePacing.start = Clock::now();
+  LOG("Frames in flight: " << pacing.framesInFlight << ", present mode " << presentModeName(pacing.presentMode)
+                           << ", max fps " << pacing.maxFps);
+}
+
+void beginFramePacing() {
+  limitFrameRate();
+
+  const double now = secondsSinceStart();
+  const auto frameTime = float(now - framePacing.frameStart);
+  framePacing.frameStart = now;
+  if (framePacing.nrOfFrameTimes == 0 && framePacing.smoothedFrameTime == 0.0f) {
+    // the first frame has no previous frame
+    framePacing.smoothedFrameTime = 1.0f / 60.0f;
+    return;
+  }
+  framePacing.smoothedFrameTime = framePacing.smoothedFrameTime * 0.9f + frameTime * 0.1f;
+  framePacing.frameTimes[framePacing.frameTimeIndex] = frameTime;
+  framePacing.frameTimeIndex = (framePacing.frameTimeIndex + 1) % NR_OF_FRAME_SAMPLES;
+  framePacing.nrOfFrameTimes = std::min(framePacing.nrOfFrameTimes + 1, NR_OF_FRAME_SAMPLES);
+}
+
+double getFrameClock() { return secondsSinceStart(); }
+
+float getSmoothedFrameTime() { return framePacing.smoothedFrameTime; }
+
+FrameTimings getFrameTimings() {
+  FrameTimings timings = {};
+  const uint32_t count = framePacing.nrOfFrameTimes;
+  timings.nrOfSamples = count;
+  timings.gpuWaitMs = framePacing.gpuWait * 1000.0f;
+  timings.limiterSleepMs = framePacing.limiterSleep * 1000.0f;
+  timings.inputToGpuCompleteMs = framePacing.inputToGpuComplete * 1000.0f;
+  if (count == 0)
+    return timings;
+
+  const uint32_t latest = (framePacing.frameTimeIndex + NR_OF_FRAME_SAMPLES - 1) % NR_OF_FRAME_SAMPLES;
+  timings.frameTimeMs = framePacing.frameTimes[latest] * 1000.0f;
+  double sum = 0.0, squaredSum = 0.0;
+  float maxFrameTime = 0.0f;
+  for (uint32_t i = 0; i < count; i++) {
+    const double frameTime = framePacing.frameTimes[i];
+    sum += frameTime;
+    squaredSum += frameTime * frameTime;
+    maxFrameTime = std::max(maxFrameTime, framePacing.frameTimes[i]);
+  }
+  const double average = sum / count;
+  timings.averageFrameTimeMs = float(average * 1000.0);
+  timings.frameTimeDeviationMs = float(std::sqrt(std::max(0.0, squaredSum / count - average * average)) * 1000.0);
+  timings.maxFrameTimeMs = maxFrameTime * 1000.0f;
+  return timings;
+}
+
+void setPresentMode(PRESENT_MODE presentMode) {
+  if (vkContext.framePacing.presentMode == presentMode)
+    return;
+  vkContext.framePacing.presentMode = presentMode;
+  if (vkContext.swapChain)
+    vkContext.swapChain->recreate = true;
+}
+
+void setMaxFps(uint32_t maxFps) {
+  vkContext.framePacing.maxFps = maxFps;
+  framePacing.nextFrameStart = secondsSinceStart();
+}
+
+const char *presentModeName(PRESENT_MODE presentMode) {
+  const char *names[] = {"FIFO", "MAILBOX", "IMMEDIATE"};
+  mgAssert(uint32_t(presentMode) < mg::countof(names));
+  return names[uint32_t(presentMode)];
+}
+
+void framePacingInputSampled() { framePacing.inputSampled = secondsSinceStart(); }
+
+void framePacingFrameSubmitted(uint32_t slot) { framePacing.inputSampledPerSlot[slot] = framePacing.inputSampled; }
+
+void framePacingFrameCompleted(uint32_t slot, double waitSeconds) {
+  framePacing.gpuWait = float(waitSeconds);
+  framePacing.inputToGpuComplete = float(secondsSinceStart() - framePacing.inputSampledPerSlot[slot]);
+}
+
+} // namespace mg
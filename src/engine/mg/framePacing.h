@@ -0,0 +1,42 @@
+#pragma once
+
+#include "vulkan/vkContext.h"
+#include <cstdint>
+
+namespace mg {
+
+struct FrameTimings {
+  float frameTimeMs; // start of the previous frame to the start of this one
+  float averageFrameTimeMs;
+  float frameTimeDeviationMs; // standard deviation, the frame time variance the user sees as stutter
+  float maxFrameTimeMs;
+  float gpuWaitMs;      // the cpu blocked on a frame fence in the latest frame
+  float limiterSleepMs; // the cpu slept to hold maxFps in the latest frame
+  // input polled until the cpu saw the gpu finish that frame, the part of input to photon latency the engine controls,
+  // the display adds up to one refresh more
+  float inputToGpuCompleteMs;
+  uint32_t nrOfSamples; // frames the averages are over
+};
+
+// clamps the settings, stores them in vkContext and starts the frame clock, called by initWindow before initVulkan
+void initFramePacing(const FramePacingSettings &settings);
+// sleeps for the frame limiter and ticks the frame clock, called by startFrame
+void beginFramePacing();
+
+// seconds since initFramePacing on a monotonic clock
+double getFrameClock();
+// seconds between the last two frame starts, exponentially smoothed
+float getSmoothedFrameTime();
+FrameTimings getFrameTimings();
+
+// the swap chain is recreated before the next acquire
+void setPresentMode(PRESENT_MODE presentMode);
+void setMaxFps(uint32_t maxFps);
+const char *presentModeName(PRESENT_MODE presentMode);
+
+// called by the renderer, slot is the command buffer index
+void framePacingInputSampled();
+void framePacingFrameSubmitted(uint32_t slot);
+void framePacingFrameCompleted(uint32_t slot, double waitSeconds);
+
+} // namespace mg
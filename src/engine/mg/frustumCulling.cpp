@@ -0,0 +1,104 @@
+#include "frustumCulling.h"
+
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace mg {
+
+MeshBounds computeMeshBounds(const void *vertices, uint32_t nrOfVertices, uint32_t stride) {
+  MeshBounds bounds = {};
+  if (!nrOfVertices)
+    return bounds;
+
+  const auto position = [&](uint32_t i) {
+    glm::vec3 p;
+    std::memcpy(&p, (const char *)vertices + size_t(i) * stride, sizeof(p));
+    return p;
+  };
+  glm::vec3 minimum = position(0), maximum = minimum;
+  for (uint32_t i = 1; i < nrOfVertices; i++) {
+    minimum = glm::min(minimum, position(i));
+    maximum = glm::max(maximum, position(i));
+  }
+  // the box center is not the tightest center but it needs no second pass to find one
+  const glm::vec3 center = (minimum + maximum) * 0.5f;
+  float radius2 = 0.0f;
+  for (uint32_t i = 0; i < nrOfVertices; i++) {
+    const auto offset = position(i) - center;
+    radius2 = std::max(radius2, glm::dot(offset, offset));
+  }
+  bounds.sphere = {center, std::sqrt(radius2)};
+  bounds.minimum = {minimum, 0.0f};
+  bounds.maximum = {maximum, 0.0f};
+  return bounds;
+}
+
+Frustum createFrustum(const glm::mat4 &viewProjection) {
+  const auto row = [&](int i) {
+    return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+  };
+  Frustum frustum = {};
+  frustum.planes[0] = row(3) + row(0);
+  frustum.planes[1] = row(3) - row(0);
+  frustum.planes[2] = row(3) + row(1);
+  frustum.planes[3] = row(3) - row(1);
+  frustum.planes[4] = row(3) + row(2);
+  frustum.planes[5] = row(3) - row(2);
+  for (auto &plane : frustum.planes) {
+    const float length = glm::length(glm::vec3(plane));
+    mgAssert(length > 0.0f);
+    plane /= length;
+  }
+  return frustum;
+}
+
+bool isSphereInFrustum(const Frustum &frustum, const glm::vec4 &sphere) {
+  for (const auto &plane : frustum.planes) {
+    if (plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w < -sphere.w)
+      return false;
+  }
+  return true;
+}
+
+uint32_t cullSpheres(const Frustum &frustum, const MeshBounds *bounds, uint32_t nrOfBounds, uint32_t *visible) {
+  uint32_t nrOfVisible = 0;
+  uint32_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  // the same multiplies and adds in the same order as isSphereInFrustum, so both agree on every sphere
+  for (; i + 4 <= nrOfBounds; i += 4) {
+    __m128 x = _mm_loadu_ps(&bounds[i + 0].sphere.x);
+    __m128 y = _mm_loadu_ps(&bounds[i + 1].sphere.x);
+    __m128 z = _mm_loadu_ps(&bounds[i + 2].sphere.x);
+    __m128 radius = _mm_loadu_ps(&bounds[i + 3].sphere.x);
+    _MM_TRANSPOSE4_PS(x, y, z, radius);
+    const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const auto &plane : frustum.planes) {
+      __m128 distance = _mm_mul_ps(_mm_set1_ps(plane.x), x);
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+      distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+    }
+    const int mask = _mm_movemask_ps(inside);
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      if (mask & (1 << lane))
+        visible[nrOfVisible++] = i + lane;
+    }
+  }
+#endif
+  for (; i < nrOfBounds; i++) {
+    if (isSphereInFrustum(frustum, bounds[i].sphere))
+      visible[nrOfVisible++] = i;
+  }
+  return nrOfVisible;
+}
+
+} // namespace mg
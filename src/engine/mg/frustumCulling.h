@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+// The bounds of a mesh in model space. The sphere is centered in the box, it is what the frustum is tested against and
+// the box is projected for occlusion tests.
+struct MeshBounds {
+  glm::vec4 sphere; // xyz center, w radius
+  glm::vec4 minimum, maximum;
+};
+
+// A point is inside when dot(plane.xyz, point) + plane.w >= 0 for all planes: left, right, bottom, top, near and far.
+// The planes are normalized so the distance can be compared with a radius.
+struct Frustum {
+  glm::vec4 planes[6];
+};
+
+// The vertices are nrOfVertices positions of 3 floats, stride bytes apart
+MeshBounds computeMeshBounds(const void *vertices, uint32_t nrOfVertices, uint32_t stride);
+// The near plane is the one of a -1 to 1 depth range, with a 0 to 1 projection it is a bit behind the real one
+Frustum createFrustum(const glm::mat4 &viewProjection);
+bool isSphereInFrustum(const Frustum &frustum, const glm::vec4 &sphere);
+// Writes the indices of the bounds whose sphere touches the frustum to visible in ascending order, four spheres at a
+// time with sse. Returns the number of visible bounds.
+uint32_t cullSpheres(const Frustum &frustum, const MeshBounds *bounds, uint32_t nrOfBounds, uint32_t *visible);
+
+} // namespace mg
@@ -0,0 +1,203 @@
+#include "mg/geometryQueries.h"
+
+#include "mg/cpuFeatures.h"
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace mg {
+
+namespace {
+
+// The scalar kernels do the same operations in the same order as the avx2 ones, min and max pick like minps and maxps
+// when a value is NaN, so both give the same bits.
+float minimum(float a, float b) { return a < b ? a : b; }
+float maximum(float a, float b) { return a > b ? a : b; }
+
+template <typename Test> void writeMask(uint32_t size, uint32_t *mask, Test test) {
+  for (uint32_t word = 0; word < bitmaskWords(size); word++) {
+    const uint32_t end = std::min(size - word * 32, 32u);
+    uint32_t bits = 0;
+    for (uint32_t bit = 0; bit < end; bit++)
+      bits |= uint32_t(test(word * 32 + bit)) << bit;
+    mask[word] = bits;
+  }
+}
+
+void raySpheres(const QueryRay &ray, const SphereArrays &spheres, uint32_t *hits, float *distances) {
+  const float *o = ray.origin, *d = ray.direction;
+  writeMask(spheres.size, hits, [&](uint32_t i) {
+    const float ocx = spheres.x[i] - o[0], ocy = spheres.y[i] - o[1], ocz = spheres.z[i] - o[2];
+    const float tca = ocx * d[0] + ocy * d[1] + ocz * d[2];
+    // the distance of the center from the ray, from the perpendicular so it stays precise for grazing rays
+    const float px = ocx - d[0] * tca, py = ocy - d[1] * tca, pz = ocz - d[2] * tca;
+    const float d2 = px * px + py * py + pz * pz;
+    const float r2 = spheres.radius[i] * spheres.radius[i];
+    const float thc = std::sqrt(r2 - d2);
+    const float t0 = tca - thc, t1 = tca + thc;
+    // the origin is inside when the near intersection is behind it
+    const float t = t0 >= 0.0f ? t0 : t1;
+    const bool hit = d2 <= r2 && t >= 0.0f && t <= ray.maxDistance;
+    if (distances)
+      distances[i] = hit ? t : FLT_MAX;
+    return hit;
+  });
+}
+
+void rayAabbs(const QueryRay &ray, const AabbArrays &aabbs, uint32_t *hits, float *distances) {
+  const float *o = ray.origin, *id = ray.inverseDirection;
+  writeMask(aabbs.size, hits, [&](uint32_t i) {
+    const float tx1 = (aabbs.minX[i] - o[0]) * id[0], tx2 = (aabbs.maxX[i] - o[0]) * id[0];
+    const float ty1 = (aabbs.minY[i] - o[1]) * id[1], ty2 = (aabbs.maxY[i] - o[1]) * id[1];
+    const float tz1 = (aabbs.minZ[i] - o[2]) * id[2], tz2 = (aabbs.maxZ[i] - o[2]) * id[2];
+    float tNear = maximum(minimum(tx1, tx2), minimum(ty1, ty2));
+    tNear = maximum(maximum(tNear, minimum(tz1, tz2)), 0.0f);
+    float tFar = minimum(maximum(tx1, tx2), maximum(ty1, ty2));
+    tFar = minimum(minimum(tFar, maximum(tz1, tz2)), ray.maxDistance);
+    const bool hit = tNear <= tFar;
+    if (distances)
+      distances[i] = hit ? tNear : FLT_MAX;
+    return hit;
+  });
+}
+
+// Moller-Trumbore
+void rayTriangles(const QueryRay &ray, const TriangleArrays &triangles, uint32_t *hits, float *distances) {
+  const float *o = ray.origin, *d = ray.direction;
+  const auto &tr = triangles;
+  writeMask(tr.size, hits, [&](uint32_t i) {
+    const float e1x = tr.x2[i] - tr.x1[i], e1y = tr.y2[i] - tr.y1[i], e1z = tr.z2[i] - tr.z1[i];
+    const float e2x = tr.x3[i] - tr.x1[i], e2y = tr.y3[i] - tr.y1[i], e2z = tr.z3[i] - tr.z1[i];
+    const float px = d[1] * e2z - d[2] * e2y, py = d[2] * e2x - d[0] * e2z, pz = d[0] * e2y - d[1] * e2x;
+    const float det = e1x * px + e1y * py + e1z * pz;
+    const float inverseDet = 1.0f / det;
+    const float tx = o[0] - tr.x1[i], ty = o[1] - tr.y1[i], tz = o[2] - tr.z1[i];
+    const float u = (tx * px + ty * py + tz * pz) * inverseDet;
+    const float qx = ty * e1z - tz * e1y, qy = tz * e1x - tx * e1z, qz = tx * e1y - ty * e1x;
+    const float v = (d[0] * qx + d[1] * qy + d[2] * qz) * inverseDet;
+    const float t = (e2x * qx + e2y * qy + e2z * qz) * inverseDet;
+    const bool hit = det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= ray.maxDistance;
+    if (distances)
+      distances[i] = hit ? t : FLT_MAX;
+    return hit;
+  });
+}
+
+void frustumSpheres(const float *planes, const SphereArrays &spheres, uint32_t *inside) {
+  writeMask(spheres.size, inside, [&](uint32_t i) {
+    bool isInside = true;
+    for (uint32_t p = 0; p < 6; p++) {
+      const float *plane = planes + p * 4;
+      const float distance = plane[0] * spheres.x[i] + plane[1] * spheres.y[i] + plane[2] * spheres.z[i] + plane[3];
+      isInside = isInside && distance >= -spheres.radius[i];
+    }
+    return isInside;
+  });
+}
+
+void frustumAabbs(const float *planes, const AabbArrays &aabbs, uint32_t *inside) {
+  writeMask(aabbs.size, inside, [&](uint32_t i) {
+    bool isInside = true;
+    for (uint32_t p = 0; p < 6; p++) {
+      // the corner farthest along the normal
+      const float *plane = planes + p * 4;
+      const float x = plane[0] >= 0.0f ? aabbs.maxX[i] : aabbs.minX[i];
+      const float y = plane[1] >= 0.0f ? aabbs.maxY[i] : aabbs.minY[i];
+      const float z = plane[2] >= 0.0f ? aabbs.maxZ[i] : aabbs.minZ[i];
+      isInside = isInside && plane[0] * x + plane[1] * y + plane[2] * z + plane[3] >= 0.0f;
+    }
+    return isInside;
+  });
+}
+
+void classifySpheres(const float *plane, const SphereArrays &spheres, uint32_t *front, uint32_t *back) {
+  const auto distance = [&](uint32_t i) {
+    return (spheres.x[i] * plane[0] + spheres.y[i] * plane[1] + spheres.z[i] * plane[2]) - plane[3];
+  };
+  writeMask(spheres.size, front, [&](uint32_t i) { return distance(i) > spheres.radius[i]; });
+  writeMask(spheres.size, back, [&](uint32_t i) { return distance(i) < -spheres.radius[i]; });
+}
+
+void sphereSpheres(const float *sphere, const SphereArrays &spheres, uint32_t *overlaps) {
+  writeMask(spheres.size, overlaps, [&](uint32_t i) {
+    const float dx = spheres.x[i] - sphere[0], dy = spheres.y[i] - sphere[1], dz = spheres.z[i] - sphere[2];
+    const float radius = spheres.radius[i] + sphere[3];
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+  });
+}
+
+const GeometryQueryKernels scalarKernels = {GEOMETRY_ISA::SCALAR, raySpheres,      rayAabbs,      rayTriangles,
+                                            frustumSpheres,       frustumAabbs,    classifySpheres, sphereSpheres};
+
+const char *isaNames[] = {"scalar", "avx2"};
+static_assert(sizeof(isaNames) / sizeof(isaNames[0]) == size_t(GEOMETRY_ISA::SIZE), "missing instruction set name");
+
+QueryRay toQueryRay(const Ray &ray) {
+  mgAssertDesc(std::abs(glm::length(ray.direction) - 1.0f) < 1e-4f, "the ray direction is not normalized");
+  const auto inverseDirection = 1.0f / ray.direction;
+  return {{ray.origin.x, ray.origin.y, ray.origin.z},
+          {ray.direction.x, ray.direction.y, ray.direction.z},
+          {inverseDirection.x, inverseDirection.y, inverseDirection.z},
+          ray.maxDistance};
+}
+
+} // namespace
+
+void raySpheres(const Ray &ray, const SphereArrays &spheres, uint32_t *hits, float *distances) {
+  geometryQueryKernels().raySpheres(toQueryRay(ray), spheres, hits, distances);
+}
+
+void rayAabbs(const Ray &ray, const AabbArrays &aabbs, uint32_t *hits, float *distances) {
+  geometryQueryKernels().rayAabbs(toQueryRay(ray), aabbs, hits, distances);
+}
+
+void rayTriangles(const Ray &ray, const TriangleArrays &triangles, uint32_t *hits, float *distances) {
+  geometryQueryKernels().rayTriangles(toQueryRay(ray), triangles, hits, distances);
+}
+
+void frustumSpheres(const Frustum &frustum, const SphereArrays &spheres, uint32_t *inside) {
+  geometryQueryKernels().frustumSpheres(&frustum.planes[0].x, spheres, inside);
+}
+
+void frustumAabbs(const Frustum &frustum, const AabbArrays &aabbs, uint32_t *inside) {
+  geometryQueryKernels().frustumAabbs(&frustum.planes[0].x, aabbs, inside);
+}
+
+void classifySpheres(const Plane &plane, const SphereArrays &spheres, uint32_t *front, uint32_t *back) {
+  const auto normalLength = glm::length(plane.normal);
+  mgAssertDesc(normalLength > (1.0 - 1e-5) && normalLength < (1.0 + 1e-5), "float length error");
+  const float normalDistance[4] = {plane.normal.x, plane.normal.y, plane.normal.z,
+                                   glm::dot(plane.position, plane.normal)};
+  geometryQueryKernels().classifySpheres(normalDistance, spheres, front, back);
+}
+
+void sphereSpheres(const glm::vec4 &sphere, const SphereArrays &spheres, uint32_t *overlaps) {
+  geometryQueryKernels().sphereSpheres(&sphere.x, spheres, overlaps);
+}
+
+const char *geometryIsaName(GEOMETRY_ISA isa) {
+  mgAssert(isa < GEOMETRY_ISA::SIZE);
+  return isaNames[uint32_t(isa)];
+}
+
+const GeometryQueryKernels *getGeometryQueryKernels(GEOMETRY_ISA isa) {
+  switch (isa) {
+  case GEOMETRY_ISA::SCALAR:
+    return &scalarKernels;
+  case GEOMETRY_ISA::AVX2:
+    return cpuFeatures().avx2 ? avx2GeometryQueryKernels() : nullptr;
+  default:
+    return nullptr;
+  }
+}
+
+const GeometryQueryKernels &geometryQueryKernels() {
+  static const GeometryQueryKernels *kernels = [] {
+    const auto avx2 = getGeometryQueryKernels(GEOMETRY_ISA::AVX2);
+    return avx2 ? avx2 : &scalarKernels;
+  }();
+  return *kernels;
+}
+
+} // namespace mg
@@ -0,0 +1,44 @@
+#pragma once
+#include "mg/frustumCulling.h"
+#include "mg/geometryQueryKernels.h"
+#include "mg/geometryUtils.h"
+#include <glm/glm.hpp>
+
+namespace mg {
+
+// Batched geometry queries, one ray, frustum, plane or sphere against arrays of spheres, boxes or triangles. The
+// results are bitmasks, see GeometryQueryKernels. The kernels are picked with cpuid at the first query, avx2 processes
+// 8 elements at a time and gives the same results as the scalar kernels.
+
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction; // normalized
+  float maxDistance;
+};
+
+inline uint32_t bitmaskWords(uint32_t size) { return (size + 31) / 32; }
+inline bool isBitSet(const uint32_t *mask, uint32_t i) { return (mask[i / 32] >> (i % 32)) & 1; }
+
+// hits where the ray enters the sphere within maxDistance, or starts inside it
+void raySpheres(const Ray &ray, const SphereArrays &spheres, uint32_t *hits, float *distances = nullptr);
+void rayAabbs(const Ray &ray, const AabbArrays &aabbs, uint32_t *hits, float *distances = nullptr);
+// both sides of the triangles are hit
+void rayTriangles(const Ray &ray, const TriangleArrays &triangles, uint32_t *hits, float *distances = nullptr);
+
+// the same test as isSphereInFrustum
+void frustumSpheres(const Frustum &frustum, const SphereArrays &spheres, uint32_t *inside);
+// a box is outside when all its corners are behind one plane, boxes next to a frustum corner can be inside
+void frustumAabbs(const Frustum &frustum, const AabbArrays &aabbs, uint32_t *inside);
+
+// front are the spheres entirely on the side the normal points to and back the ones entirely behind, the rest are
+// intersected by the plane as in intersectionPlaneSpheres
+void classifySpheres(const Plane &plane, const SphereArrays &spheres, uint32_t *front, uint32_t *back);
+void sphereSpheres(const glm::vec4 &sphere, const SphereArrays &spheres, uint32_t *overlaps);
+
+const char *geometryIsaName(GEOMETRY_ISA isa); // scalar or avx2
+// the kernels for isa, or nullptr if they are not compiled in or the cpu does not support them
+const GeometryQueryKernels *getGeometryQueryKernels(GEOMETRY_ISA isa);
+// the kernels the queries use, the best supported ones
+const GeometryQueryKernels &geometryQueryKernels();
+
+} // namespace mg
@@ -0,0 +1,220 @@
+#include "mg/cpuFeatures.h"
+#include "mg/geometryQueryKernels.h"
+#include <cfloat>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace mg {
+
+namespace {
+
+constexpr uint32_t NR_OF_FLOATS = 8;
+
+// Loads 8 elements from index, or the ones before size at the end of the arrays
+struct Lanes {
+  uint32_t index;
+  bool isFull;
+  __m256i mask;
+
+  __m256 load(const float *values) const {
+    return isFull ? _mm256_loadu_ps(values + index) : _mm256_maskload_ps(values + index, mask);
+  }
+  void store(float *values, __m256 v) const {
+    if (isFull)
+      _mm256_storeu_ps(values + index, v);
+    else
+      _mm256_maskstore_ps(values + index, mask, v);
+  }
+};
+
+// test returns the lanes that pass as a mask of all bits set, four calls fill a word
+template <typename Test> void writeMask(uint32_t size, uint32_t *mask, Test test) {
+  for (uint32_t word = 0; word * 32 < size; word++) {
+    uint32_t bits = 0;
+    for (uint32_t index = word * 32; index < size && index < (word + 1) * 32; index += NR_OF_FLOATS) {
+      Lanes lanes = {index, index + NR_OF_FLOATS <= size, {}};
+      uint32_t laneBits = 0xff;
+      if (!lanes.isFull) {
+        lanes.mask = tailMask(size - index);
+        laneBits = (1u << (size - index)) - 1;
+      }
+      bits |= (uint32_t(_mm256_movemask_ps(test(lanes))) & laneBits) << (index % 32);
+    }
+    mask[word] = bits;
+  }
+}
+
+__m256 negate(__m256 v) { return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f)); }
+
+__m256 dot(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+  __m256 d = _mm256_mul_ps(ax, bx);
+  d = _mm256_add_ps(d, _mm256_mul_ps(ay, by));
+  return _mm256_add_ps(d, _mm256_mul_ps(az, bz));
+}
+
+__m256 ge(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+__m256 le(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+
+void raySpheres(const QueryRay &ray, const SphereArrays &spheres, uint32_t *hits, float *distances) {
+  const __m256 ox = _mm256_set1_ps(ray.origin[0]), oy = _mm256_set1_ps(ray.origin[1]),
+               oz = _mm256_set1_ps(ray.origin[2]);
+  const __m256 dx = _mm256_set1_ps(ray.direction[0]), dy = _mm256_set1_ps(ray.direction[1]),
+               dz = _mm256_set1_ps(ray.direction[2]);
+  const __m256 maxDistance = _mm256_set1_ps(ray.maxDistance);
+  const __m256 zero = _mm256_setzero_ps();
+  writeMask(spheres.size, hits, [&](const Lanes &lanes) {
+    const __m256 ocx = _mm256_sub_ps(lanes.load(spheres.x), ox);
+    const __m256 ocy = _mm256_sub_ps(lanes.load(spheres.y), oy);
+    const __m256 ocz = _mm256_sub_ps(lanes.load(spheres.z), oz);
+    const __m256 radius = lanes.load(spheres.radius);
+    const __m256 tca = dot(ocx, ocy, ocz, dx, dy, dz);
+    const __m256 px = _mm256_sub_ps(ocx, _mm256_mul_ps(dx, tca));
+    const __m256 py = _mm256_sub_ps(ocy, _mm256_mul_ps(dy, tca));
+    const __m256 pz = _mm256_sub_ps(ocz, _mm256_mul_ps(dz, tca));
+    const __m256 d2 = dot(px, py, pz, px, py, pz);
+    const __m256 r2 = _mm256_mul_ps(radius, radius);
+    const __m256 thc = _mm256_sqrt_ps(_mm256_sub_ps(r2, d2));
+    const __m256 t0 = _mm256_sub_ps(tca, thc), t1 = _mm256_add_ps(tca, thc);
+    const __m256 t = _mm256_blendv_ps(t1, t0, ge(t0, zero));
+    const __m256 hit = _mm256_and_ps(_mm256_and_ps(le(d2, r2), ge(t, zero)), le(t, maxDistance));
+    if (distances)
+      lanes.store(distances, _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), t, hit));
+    return hit;
+  });
+}
+
+void rayAabbs(const QueryRay &ray, const AabbArrays &aabbs, uint32_t *hits, float *distances) {
+  const __m256 ox = _mm256_set1_ps(ray.origin[0]), oy = _mm256_set1_ps(ray.origin[1]),
+               oz = _mm256_set1_ps(ray.origin[2]);
+  const __m256 ix = _mm256_set1_ps(ray.inverseDirection[0]), iy = _mm256_set1_ps(ray.inverseDirection[1]),
+               iz = _mm256_set1_ps(ray.inverseDirection[2]);
+  const __m256 maxDistance = _mm256_set1_ps(ray.maxDistance);
+  writeMask(aabbs.size, hits, [&](const Lanes &lanes) {
+    const __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.minX), ox), ix);
+    const __m256 tx2 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.maxX), ox), ix);
+    const __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.minY), oy), iy);
+    const __m256 ty2 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.maxY), oy), iy);
+    const __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.minZ), oz), iz);
+    const __m256 tz2 = _mm256_mul_ps(_mm256_sub_ps(lanes.load(aabbs.maxZ), oz), iz);
+    __m256 tNear = _mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_min_ps(ty1, ty2));
+    tNear = _mm256_max_ps(_mm256_max_ps(tNear, _mm256_min_ps(tz1, tz2)), _mm256_setzero_ps());
+    __m256 tFar = _mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_max_ps(ty1, ty2));
+    tFar = _mm256_min_ps(_mm256_min_ps(tFar, _mm256_max_ps(tz1, tz2)), maxDistance);
+    const __m256 hit = le(tNear, tFar);
+    if (distances)
+      lanes.store(distances, _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), tNear, hit));
+    return hit;
+  });
+}
+
+__m256 crossComponent(__m256 a1, __m256 b2, __m256 a2, __m256 b1) {
+  return _mm256_sub_ps(_mm256_mul_ps(a1, b2), _mm256_mul_ps(a2, b1));
+}
+
+void rayTriangles(const QueryRay &ray, const TriangleArrays &triangles, uint32_t *hits, float *distances) {
+  const __m256 ox = _mm256_set1_ps(ray.origin[0]), oy = _mm256_set1_ps(ray.origin[1]),
+               oz = _mm256_set1_ps(ray.origin[2]);
+  const __m256 dx = _mm256_set1_ps(ray.direction[0]), dy = _mm256_set1_ps(ray.direction[1]),
+               dz = _mm256_set1_ps(ray.direction[2]);
+  const __m256 maxDistance = _mm256_set1_ps(ray.maxDistance);
+  const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+  const auto &tr = triangles;
+  writeMask(tr.size, hits, [&](const Lanes &lanes) {
+    const __m256 x1 = lanes.load(tr.x1), y1 = lanes.load(tr.y1), z1 = lanes.load(tr.z1);
+    const __m256 e1x = _mm256_sub_ps(lanes.load(tr.x2), x1), e1y = _mm256_sub_ps(lanes.load(tr.y2), y1),
+                 e1z = _mm256_sub_ps(lanes.load(tr.z2), z1);
+    const __m256 e2x = _mm256_sub_ps(lanes.load(tr.x3), x1), e2y = _mm256_sub_ps(lanes.load(tr.y3), y1),
+                 e2z = _mm256_sub_ps(lanes.load(tr.z3), z1);
+    const __m256 px = crossComponent(dy, e2z, dz, e2y), py = crossComponent(dz, e2x, dx, e2z),
+                 pz = crossComponent(dx, e2y, dy, e2x);
+    const __m256 det = dot(e1x, e1y, e1z, px, py, pz);
+    const __m256 inverseDet = _mm256_div_ps(one, det);
+    const __m256 tx = _mm256_sub_ps(ox, x1), ty = _mm256_sub_ps(oy, y1), tz = _mm256_sub_ps(oz, z1);
+    const __m256 u = _mm256_mul_ps(dot(tx, ty, tz, px, py, pz), inverseDet);
+    const __m256 qx = crossComponent(ty, e1z, tz, e1y), qy = crossComponent(tz, e1x, tx, e1z),
+                 qz = crossComponent(tx, e1y, ty, e1x);
+    const __m256 v = _mm256_mul_ps(dot(dx, dy, dz, qx, qy, qz), inverseDet);
+    const __m256 t = _mm256_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), inverseDet);
+    __m256 hit = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+    hit = _mm256_and_ps(hit, _mm256_and_ps(ge(u, zero), ge(v, zero)));
+    hit = _mm256_and_ps(hit, le(_mm256_add_ps(u, v), one));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(ge(t, zero), le(t, maxDistance)));
+    if (distances)
+      lanes.store(distances, _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), t, hit));
+    return hit;
+  });
+}
+
+void frustumSpheres(const float *planes, const SphereArrays &spheres, uint32_t *inside) {
+  writeMask(spheres.size, inside, [&](const Lanes &lanes) {
+    const __m256 x = lanes.load(spheres.x), y = lanes.load(spheres.y), z = lanes.load(spheres.z);
+    const __m256 negativeRadius = negate(lanes.load(spheres.radius));
+    __m256 isInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (uint32_t p = 0; p < 6; p++) {
+      const float *plane = planes + p * 4;
+      const __m256 distance = _mm256_add_ps(
+          dot(_mm256_set1_ps(plane[0]), _mm256_set1_ps(plane[1]), _mm256_set1_ps(plane[2]), x, y, z),
+          _mm256_set1_ps(plane[3]));
+      isInside = _mm256_and_ps(isInside, ge(distance, negativeRadius));
+    }
+    return isInside;
+  });
+}
+
+void frustumAabbs(const float *planes, const AabbArrays &aabbs, uint32_t *inside) {
+  writeMask(aabbs.size, inside, [&](const Lanes &lanes) {
+    __m256 isInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (uint32_t p = 0; p < 6; p++) {
+      // the corner farthest along the normal
+      const float *plane = planes + p * 4;
+      const __m256 x = lanes.load(plane[0] >= 0.0f ? aabbs.maxX : aabbs.minX);
+      const __m256 y = lanes.load(plane[1] >= 0.0f ? aabbs.maxY : aabbs.minY);
+      const __m256 z = lanes.load(plane[2] >= 0.0f ? aabbs.maxZ : aabbs.minZ);
+      const __m256 distance = _mm256_add_ps(
+          dot(_mm256_set1_ps(plane[0]), _mm256_set1_ps(plane[1]), _mm256_set1_ps(plane[2]), x, y, z),
+          _mm256_set1_ps(plane[3]));
+      isInside = _mm256_and_ps(isInside, ge(distance, _mm256_setzero_ps()));
+    }
+    return isInside;
+  });
+}
+
+void classifySpheres(const float *plane, const SphereArrays &spheres, uint32_t *front, uint32_t *back) {
+  const __m256 nx = _mm256_set1_ps(plane[0]), ny = _mm256_set1_ps(plane[1]), nz = _mm256_set1_ps(plane[2]);
+  const __m256 planeDistance = _mm256_set1_ps(plane[3]);
+  const auto distance = [&](const Lanes &lanes) {
+    return _mm256_sub_ps(dot(lanes.load(spheres.x), lanes.load(spheres.y), lanes.load(spheres.z), nx, ny, nz),
+                         planeDistance);
+  };
+  writeMask(spheres.size, front, [&](const Lanes &lanes) {
+    return _mm256_cmp_ps(distance(lanes), lanes.load(spheres.radius), _CMP_GT_OQ);
+  });
+  writeMask(spheres.size, back, [&](const Lanes &lanes) {
+    return _mm256_cmp_ps(distance(lanes), negate(lanes.load(spheres.radius)), _CMP_LT_OQ);
+  });
+}
+
+void sphereSpheres(const float *sphere, const SphereArrays &spheres, uint32_t *overlaps) {
+  const __m256 cx = _mm256_set1_ps(sphere[0]), cy = _mm256_set1_ps(sphere[1]), cz = _mm256_set1_ps(sphere[2]);
+  const __m256 cr = _mm256_set1_ps(sphere[3]);
+  writeMask(spheres.size, overlaps, [&](const Lanes &lanes) {
+    const __m256 dx = _mm256_sub_ps(lanes.load(spheres.x), cx);
+    const __m256 dy = _mm256_sub_ps(lanes.load(spheres.y), cy);
+    const __m256 dz = _mm256_sub_ps(lanes.load(spheres.z), cz);
+    const __m256 radius = _mm256_add_ps(lanes.load(spheres.radius), cr);
+    return le(dot(dx, dy, dz, dx, dy, dz), _mm256_mul_ps(radius, radius));
+  });
+}
+
+const GeometryQueryKernels kernels = {GEOMETRY_ISA::AVX2, raySpheres,   rayAabbs,        rayTriangles,
+                                      frustumSpheres,     frustumAabbs, classifySpheres, sphereSpheres};
+
+} // namespace
+
+const GeometryQueryKernels *avx2GeometryQueryKernels() { return &kernels; }
+
+} // namespace mg
+#else
+const mg::GeometryQueryKernels *mg::avx2GeometryQueryKernels() { return nullptr; }
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+// The kernels behind geometryQueries.h, one table per instruction set. The avx2 table is compiled in its own
+// translation unit with -mavx2, so this header must not include glm or anything else with inline functions, the
+// linker could keep the avx2 copy of one for the whole program.
+
+namespace mg {
+
+// Structure of arrays views of primitives, every array has size elements
+struct SphereArrays {
+  const float *x, *y, *z, *radius;
+  uint32_t size;
+};
+struct AabbArrays {
+  const float *minX, *minY, *minZ;
+  const float *maxX, *maxY, *maxZ;
+  uint32_t size;
+};
+// the corners of triangle i are (x1, y1, z1)[i], (x2, y2, z2)[i] and (x3, y3, z3)[i]
+struct TriangleArrays {
+  const float *x1, *y1, *z1;
+  const float *x2, *y2, *z2;
+  const float *x3, *y3, *z3;
+  uint32_t size;
+};
+
+enum class GEOMETRY_ISA { SCALAR, AVX2, SIZE };
+
+// the direction is normalized, inverseDirection is 1 / direction with infinities for zero components
+struct QueryRay {
+  float origin[3];
+  float direction[3];
+  float inverseDirection[3];
+  float maxDistance;
+};
+
+// Bit i of a mask is bit i % 32 of word i / 32, every word up to (size + 31) / 32 is written and the bits past size are
+// 0. Distances may be nullptr, otherwise they are written for every element, FLT_MAX where there is no hit.
+struct GeometryQueryKernels {
+  GEOMETRY_ISA isa;
+  void (*raySpheres)(const QueryRay &ray, const SphereArrays &spheres, uint32_t *hits, float *distances);
+  void (*rayAabbs)(const QueryRay &ray, const AabbArrays &aabbs, uint32_t *hits, float *distances);
+  void (*rayTriangles)(const QueryRay &ray, const TriangleArrays &triangles, uint32_t *hits, float *distances);
+  // planes are 6 normalized planes of 4 floats, see Frustum
+  void (*frustumSpheres)(const float *planes, const SphereArrays &spheres, uint32_t *inside);
+  void (*frustumAabbs)(const float *planes, const AabbArrays &aabbs, uint32_t *inside);
+  // plane is a normalized normal and its distance from the origin
+  void (*classifySpheres)(const float *plane, const SphereArrays &spheres, uint32_t *front, uint32_t *back);
+  // sphere is a center and a radius
+  void (*sphereSpheres)(const float *sphere, const SphereArrays &spheres, uint32_t *overlaps);
+};
+
+// defined in geometryQueriesAvx2.cpp, nullptr when the compiler did not get the avx2 flags
+const GeometryQueryKernels *avx2GeometryQueryKernels();
+
+} // namespace mg
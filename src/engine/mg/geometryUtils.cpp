@@ -4,7 +4,7 @@
 #include "mg/mgUtils.h"
 #include <glm/geometric.hpp>
 
-namespace gm {
+namespace mg {
 
 // Consider the line extending the segment, parameterized as v + t (w - v)
 // We find projection of point p onto the line
@@ -122,4 +122,4 @@ mg::Line intersectionPlanePlane(const mg::Plane &plane1, const mg::Plane &plane2
   return res;
 }
 
-} // namespace gm
+} // namespace mg
@@ -23,6 +23,7 @@ float distancePointToPlane(const glm::vec3 &point, const mg::Plane &plane);
 glm::vec3 projectPointOnPlane(const glm::vec3 &point, const mg::Plane &plane);
 
 bool intersectionLinePlane(glm::vec3 *out, const Line &line, const Plane &plane);
+// the scalar reference of classifySpheres in geometryQueries.h, which tests arrays of spheres 8 at a time
 std::vector<bool> intersectionPlaneSpheres(const Plane &plane, const std::vector<glm::vec3> &centerPositions,
                                            const std::vector<float> &sphereRadius);
 
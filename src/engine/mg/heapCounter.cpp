@@ -0,0 +1,52 @@
+#include "memory.h"
+#include <cstdlib>
+#include <new>
+
+// Counting replacements of the global allocation functions, the count is per thread so it costs no synchronization.
+// They are in their own object library, mg-heap-counter, so only the executables that link it pay for them.
+
+namespace {
+
+const bool isCounting = (mg::startCountingHeapAllocations(), true);
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  mg::countHeapAllocation();
+  if (void *data = malloc(size ? size : 1))
+    return data;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  mg::countHeapAllocation();
+  return malloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  mg::countHeapAllocation();
+  if (void *data = mg::alignedMalloc(size, size_t(alignment)))
+    return data;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  mg::countHeapAllocation();
+  return mg::alignedMalloc(size, size_t(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept {
+  return operator new(size, alignment, tag);
+}
+
+void operator delete(void *data) noexcept { free(data); }
+void operator delete[](void *data) noexcept { free(data); }
+void operator delete(void *data, std::size_t) noexcept { free(data); }
+void operator delete[](void *data, std::size_t) noexcept { free(data); }
+void operator delete(void *data, const std::nothrow_t &) noexcept { free(data); }
+void operator delete[](void *data, const std::nothrow_t &) noexcept { free(data); }
+void operator delete(void *data, std::align_val_t) noexcept { mg::alignedFree(data); }
+void operator delete[](void *data, std::align_val_t) noexcept { mg::alignedFree(data); }
+void operator delete(void *data, std::size_t, std::align_val_t) noexcept { mg::alignedFree(data); }
+void operator delete[](void *data, std::size_t, std::align_val_t) noexcept { mg::alignedFree(data); }
+void operator delete(void *data, std::align_val_t, const std::nothrow_t &) noexcept { mg::alignedFree(data); }
+void operator delete[](void *data, std::align_val_t, const std::nothrow_t &) noexcept { mg::alignedFree(data); }
@@ -0,0 +1,28 @@
+#include "instanceCulling.h"
+
+#include "mg/mgAssert.h"
+#include <cmath>
+
+namespace mg {
+
+glm::vec4 primitiveBounds(PRIMITIVE primitive) {
+  mgAssert(primitive < PRIMITIVE::COUNT);
+  if (primitive == PRIMITIVE::CUBE)
+    return {0.0f, 0.0f, 0.0f, std::sqrt(3.0f) * 0.5f};
+  return {0.5f, 0.5f, 0.0f, std::sqrt(2.0f) * 0.5f};
+}
+
+uint32_t cullInstances(const Frustum &frustum, PRIMITIVE primitive, const InstanceStreams &streams, uint32_t *visible) {
+  mgAssert(streams.x && streams.y);
+  const auto bounds = primitiveBounds(primitive);
+  uint32_t nrOfVisible = 0;
+  for (uint32_t i = 0; i < streams.count; i++) {
+    const glm::vec3 position = {streams.x[i], streams.y[i], streams.z ? streams.z[i] : 0.0f};
+    const float size = streams.sizes ? streams.sizes[i] : streams.size;
+    if (isSphereInFrustum(frustum, glm::vec4(position + glm::vec3(bounds) * size, bounds.w * size)))
+      visible[nrOfVisible++] = i;
+  }
+  return nrOfVisible;
+}
+
+} // namespace mg
@@ -0,0 +1,27 @@
+#pragma once
+#include "mg/frustumCulling.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace mg {
+
+// the cube is centered on the position of its instance, the quad lies in z = 0 with its lower left corner there
+enum class PRIMITIVE { CUBE, QUAD, COUNT };
+
+// count instances as a structure of arrays, only x and y are required. Without z the instances are at z 0, without
+// sizes all have size and without colors they are white. The colors are packed rgba8, see glm::packUnorm4x8.
+struct InstanceStreams {
+  const float *x, *y, *z;
+  const float *sizes;
+  float size = 1.0f;
+  const uint32_t *colors;
+  uint32_t count;
+};
+
+// the sphere around a primitive of size 1, xyz is the center relative to the position of the instance and w the radius
+glm::vec4 primitiveBounds(PRIMITIVE primitive);
+// The cpu version of cullInstances.comp. Writes the indices of the instances whose sphere touches the frustum to
+// visible in ascending order, returns their number.
+uint32_t cullInstances(const Frustum &frustum, PRIMITIVE primitive, const InstanceStreams &streams, uint32_t *visible);
+
+} // namespace mg
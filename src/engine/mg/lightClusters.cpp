@@ -0,0 +1,79 @@
+#include "lightClusters.h"
+
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mg {
+
+ClusterGrid createClusterGrid(const ClusterGridInfo &info) {
+  mgAssert(info.nearDepth > 0.0f && info.farDepth > info.nearDepth);
+  const float logRange = std::log(info.farDepth / info.nearDepth);
+
+  ClusterGrid grid = {};
+  grid.size = glm::uvec4(info.size, info.maxLightsPerCluster);
+  grid.slices.x = float(info.size.z) / logRange;
+  grid.slices.y = -float(info.size.z) * std::log(info.nearDepth) / logRange;
+  grid.slices.z = info.nearDepth;
+  grid.slices.w = info.farDepth;
+  return grid;
+}
+
+// the same math as sliceDepth in the shaders
+static float sliceDepth(uint32_t slice, const ClusterGrid &grid) {
+  return grid.slices.z * std::pow(grid.slices.w / grid.slices.z, float(slice) / float(grid.size.z));
+}
+
+glm::vec3 viewPosition(const glm::vec2 &uv, float viewDepth, const glm::mat4 &projection) {
+  const glm::vec2 ndc = {uv.x * 2.0f - 1.0f, 1.0f - uv.y * 2.0f};
+  return {ndc.x * viewDepth / projection[0][0], ndc.y * viewDepth / projection[1][1], viewDepth};
+}
+
+uint32_t clusterOfPixel(const glm::vec2 &uv, float viewDepth, const ClusterGrid &grid) {
+  const glm::ivec2 tile = glm::clamp(glm::ivec2(uv * glm::vec2(grid.size.x, grid.size.y)), glm::ivec2(0),
+                                     glm::ivec2(grid.size.x, grid.size.y) - 1);
+  const float slice = std::log(std::max(viewDepth, 1e-6f)) * grid.slices.x + grid.slices.y;
+  const uint32_t z = uint32_t(std::clamp(slice, 0.0f, float(grid.size.z - 1)));
+  return uint32_t(tile.x) + grid.size.x * (uint32_t(tile.y) + grid.size.y * z);
+}
+
+std::vector<ClusterBounds> computeClusterBounds(const ClusterGrid &grid, const glm::mat4 &projection) {
+  std::vector<ClusterBounds> bounds(nrOfClusters(grid));
+  for (uint32_t i = 0; i < bounds.size(); i++) {
+    const glm::uvec3 coordinate = {i % grid.size.x, (i / grid.size.x) % grid.size.y, i / (grid.size.x * grid.size.y)};
+    const glm::vec2 uvMin = glm::vec2(coordinate.x, coordinate.y) / glm::vec2(grid.size.x, grid.size.y);
+    const glm::vec2 uvMax = glm::vec2(coordinate.x + 1, coordinate.y + 1) / glm::vec2(grid.size.x, grid.size.y);
+    const float depths[2] = {sliceDepth(coordinate.z, grid), sliceDepth(coordinate.z + 1, grid)};
+
+    glm::vec3 minimum(1e30f), maximum(-1e30f);
+    for (uint32_t corner = 0; corner < 8; corner++) {
+      const glm::vec2 uv = {corner & 1 ? uvMax.x : uvMin.x, corner & 2 ? uvMax.y : uvMin.y};
+      const auto position = viewPosition(uv, depths[corner >> 2], projection);
+      minimum = glm::min(minimum, position);
+      maximum = glm::max(maximum, position);
+    }
+    bounds[i] = {glm::vec4(minimum, 0.0f), glm::vec4(maximum, 0.0f)};
+  }
+  return bounds;
+}
+
+void assignLightsToClusters(const ClusterGrid &grid, const std::vector<ClusterBounds> &bounds,
+                            const PointLight *lights, uint32_t nrOfLights, std::vector<uint32_t> *counts,
+                            std::vector<uint32_t> *indices) {
+  const uint32_t maxLights = grid.size.w;
+  counts->assign(nrOfClusters(grid), 0);
+  indices->assign(size_t(nrOfClusters(grid)) * maxLights, 0);
+  for (uint32_t cluster = 0; cluster < bounds.size(); cluster++) {
+    const auto &box = bounds[cluster];
+    auto &count = (*counts)[cluster];
+    for (uint32_t i = 0; i < nrOfLights && count < maxLights; i++) {
+      const glm::vec3 center = lights[i].positionRange;
+      const float radius = lights[i].positionRange.w;
+      const auto offset = glm::clamp(center, glm::vec3(box.minimum), glm::vec3(box.maximum)) - center;
+      if (glm::dot(offset, offset) <= radius * radius)
+        (*indices)[size_t(cluster) * maxLights + count++] = i;
+    }
+  }
+}
+
+} // namespace mg
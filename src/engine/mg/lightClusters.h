@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+// PointLight, ClusterGrid and ClusterBounds have the layout of their structs in clusteredLighting.hglsl
+struct PointLight {
+  glm::vec4 positionRange; // view space position, w is the distance where the light has faded out
+  glm::vec4 colorIntensity;
+};
+
+// size.w is the most lights a cluster keeps, slices.xy the scale and bias from log(view depth) to the slice and
+// slices.zw the depth range of the grid
+struct ClusterGrid {
+  glm::uvec4 size;
+  glm::vec4 slices;
+};
+
+struct ClusterBounds {
+  glm::vec4 minimum, maximum;
+};
+
+struct ClusterGridInfo {
+  glm::uvec3 size = {16, 9, 24};
+  // the depth range the slices cover, usually the near and far plane of the projection
+  float nearDepth = 0.1f, farDepth = 1000.0f;
+  uint32_t maxLightsPerCluster = 128;
+};
+
+inline uint32_t nrOfClusters(const ClusterGrid &grid) { return grid.size.x * grid.size.y * grid.size.z; }
+
+ClusterGrid createClusterGrid(const ClusterGridInfo &info);
+// The cpu versions of clusterBounds.comp and clusterLights.comp. The lights of cluster i are
+// indices[i * grid.size.w, i * grid.size.w + counts[i]), in ascending order.
+std::vector<ClusterBounds> computeClusterBounds(const ClusterGrid &grid, const glm::mat4 &projection);
+void assignLightsToClusters(const ClusterGrid &grid, const std::vector<ClusterBounds> &bounds,
+                            const PointLight *lights, uint32_t nrOfLights, std::vector<uint32_t> *counts,
+                            std::vector<uint32_t> *indices);
+// The cpu versions of clusterOfPixel and viewPosition in the shaders, uv is a texture coordinate
+uint32_t clusterOfPixel(const glm::vec2 &uv, float viewDepth, const ClusterGrid &grid);
+glm::vec3 viewPosition(const glm::vec2 &uv, float viewDepth, const glm::mat4 &projection);
+
+} // namespace mg
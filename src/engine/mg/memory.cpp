@@ -0,0 +1,268 @@
+#include "memory.h"
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace {
+
+thread_local uint64_t threadHeapAllocations = 0;
+bool isCountingHeapAllocations = false;
+
+constexpr size_t BLOCK_ALIGNMENT = 64;
+constexpr size_t SCRATCH_CAPACITY = 1 << 20;
+
+size_t alignUp(size_t value, size_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+size_t nextPowerOfTwo(size_t value) {
+  size_t powerOfTwo = 1;
+  while (powerOfTwo < value)
+    powerOfTwo <<= 1;
+  return powerOfTwo;
+}
+
+struct OverflowBlock {
+  OverflowBlock *next;
+  size_t size;
+};
+
+struct ThreadScratch {
+  mg::Arena arena;
+  ThreadScratch() { arena.create(SCRATCH_CAPACITY); }
+};
+thread_local ThreadScratch threadScratch;
+
+mg::Arena frameArenas[2];
+uint32_t currentFrameArena = 0;
+uint64_t frameStartHeapAllocations = 0;
+uint64_t lastFrameHeapAllocations = 0;
+
+} // namespace
+
+namespace mg {
+
+void *alignedMalloc(size_t size, size_t alignment) {
+#if defined(_WIN32)
+  return _aligned_malloc(size ? size : 1, alignment);
+#else
+  void *data = nullptr;
+  return posix_memalign(&data, std::max(alignment, sizeof(void *)), size ? size : 1) == 0 ? data : nullptr;
+#endif
+}
+
+void alignedFree(void *data) {
+#if defined(_WIN32)
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+void Arena::create(size_t capacity) {
+  mgAssert(_data == nullptr);
+  mgAssert(capacity > 0);
+  _capacity = alignUp(capacity, BLOCK_ALIGNMENT);
+  _data = (uint8_t *)alignedMalloc(_capacity, BLOCK_ALIGNMENT);
+  mgAssert(_data);
+  _offset = 0;
+  _highWaterMark = 0;
+  _nrOfOverflows = 0;
+  _last = nullptr;
+}
+
+void Arena::destroy() {
+  freeOverflowBlocks(nullptr);
+  alignedFree(_data);
+  _data = nullptr;
+  _capacity = 0;
+  _offset = 0;
+  _last = nullptr;
+}
+
+Arena::~Arena() { destroy(); }
+
+void *Arena::allocate(size_t size, size_t alignment) {
+  mgAssert(_data);
+  mgAssert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+  const size_t offset = alignUp(_offset, alignment);
+  if (offset + size > _capacity || alignment > BLOCK_ALIGNMENT) {
+    _last = allocateOverflow(size, alignment);
+  } else {
+    _offset = offset + size;
+    _last = _data + offset;
+  }
+  _highWaterMark = std::max(_highWaterMark, used());
+  return _last;
+}
+
+void *Arena::allocateOverflow(size_t size, size_t alignment) {
+  const size_t headerSize = alignUp(sizeof(OverflowBlock), alignment);
+  auto block = (OverflowBlock *)alignedMalloc(headerSize + size, std::max(alignment, alignof(OverflowBlock)));
+  mgAssert(block);
+  block->next = (OverflowBlock *)_overflowBlocks;
+  block->size = headerSize + size;
+  _overflowBlocks = block;
+  _overflowSize += block->size;
+  _nrOfOverflows++;
+  return (uint8_t *)block + headerSize;
+}
+
+void Arena::freeOverflowBlocks(void *until) {
+  while (_overflowBlocks != until) {
+    auto block = (OverflowBlock *)_overflowBlocks;
+    _overflowBlocks = block->next;
+    _overflowSize -= block->size;
+    alignedFree(block);
+  }
+}
+
+void Arena::deallocate(void *data, size_t size) {
+  if (data == nullptr || data != _last)
+    return;
+  if ((uint8_t *)data + size == _data + _offset)
+    _offset -= size;
+  _last = nullptr;
+}
+
+void *Arena::reallocate(void *data, size_t oldSize, size_t newSize, size_t alignment) {
+  if (data == nullptr)
+    return allocate(newSize, alignment);
+  const bool isLastInBlock = data == _last && (uint8_t *)data + oldSize == _data + _offset;
+  if (isLastInBlock && size_t((uint8_t *)data - _data) + newSize <= _capacity) {
+    _offset = size_t((uint8_t *)data - _data) + newSize;
+    _highWaterMark = std::max(_highWaterMark, used());
+    return data;
+  }
+  void *newData = allocate(newSize, alignment);
+  memcpy(newData, data, std::min(oldSize, newSize));
+  return newData;
+}
+
+Arena::Mark Arena::mark() const { return {_offset, _overflowBlocks}; }
+
+void Arena::rewind(Mark mark) {
+  mgAssert(mark.offset <= _offset);
+  if (mark.offset == 0 && mark.overflowBlocks == nullptr) {
+    reset();
+    return;
+  }
+  freeOverflowBlocks(mark.overflowBlocks);
+  _offset = mark.offset;
+  _last = nullptr;
+}
+
+void Arena::reset() {
+  const bool overflowed = _overflowBlocks != nullptr;
+  freeOverflowBlocks(nullptr);
+  _offset = 0;
+  _last = nullptr;
+  if (overflowed && _highWaterMark > _capacity) {
+    alignedFree(_data);
+    _capacity = nextPowerOfTwo(_highWaterMark);
+    _data = (uint8_t *)alignedMalloc(_capacity, BLOCK_ALIGNMENT);
+    mgAssert(_data);
+  }
+}
+
+size_t Arena::used() const { return _offset + _overflowSize; }
+
+void createFrameArenas(size_t capacity) {
+  for (auto &arena : frameArenas)
+    arena.create(capacity);
+  currentFrameArena = 0;
+  frameStartHeapAllocations = threadHeapAllocations;
+}
+
+void destroyFrameArenas() {
+  for (auto &arena : frameArenas)
+    arena.destroy();
+}
+
+void beginMemoryFrame() {
+  lastFrameHeapAllocations = threadHeapAllocations - frameStartHeapAllocations;
+  currentFrameArena = (currentFrameArena + 1) % mg::countof(frameArenas);
+  frameArenas[currentFrameArena].reset();
+  frameStartHeapAllocations = threadHeapAllocations;
+}
+
+Arena &frameArena() { return frameArenas[currentFrameArena]; }
+
+ScratchScope::ScratchScope() : _arena(&threadScratch.arena), _mark(threadScratch.arena.mark()) {}
+
+ScratchScope::~ScratchScope() { _arena->rewind(_mark); }
+
+void Pool::create(uint32_t blockSize, uint32_t blockAlignment, uint32_t blocksPerChunk) {
+  mgAssert(_chunks.empty());
+  mgAssert(blocksPerChunk > 0);
+  mgAssert(blockAlignment > 0 && (blockAlignment & (blockAlignment - 1)) == 0);
+  // a free block holds the pointer to the next free block
+  _blockAlignment = std::max(blockAlignment, uint32_t(alignof(void *)));
+  _blockSize = uint32_t(alignUp(std::max(blockSize, uint32_t(sizeof(void *))), _blockAlignment));
+  _blocksPerChunk = blocksPerChunk;
+  _nrOfAllocatedBlocks = 0;
+  _freeList = nullptr;
+}
+
+void Pool::destroy() {
+  for (auto chunk : _chunks)
+    alignedFree(chunk);
+  _chunks.clear();
+  _freeList = nullptr;
+  _nrOfAllocatedBlocks = 0;
+}
+
+Pool::~Pool() { destroy(); }
+
+void Pool::addChunk() {
+  auto chunk = (uint8_t *)alignedMalloc(size_t(_blockSize) * _blocksPerChunk, _blockAlignment);
+  mgAssert(chunk);
+  _chunks.push_back(chunk);
+  // thread the new blocks in address order in front of the free list
+  for (uint32_t i = _blocksPerChunk; i-- > 0;) {
+    void *block = chunk + size_t(i) * _blockSize;
+    *(void **)block = _freeList;
+    _freeList = block;
+  }
+}
+
+void *Pool::allocate() {
+  mgAssert(_blockSize > 0);
+  if (!_freeList)
+    addChunk();
+  void *block = _freeList;
+  _freeList = *(void **)block;
+  _nrOfAllocatedBlocks++;
+  return block;
+}
+
+void Pool::deallocate(void *block) {
+  if (block == nullptr)
+    return;
+  mgAssert(_nrOfAllocatedBlocks > 0);
+  *(void **)block = _freeList;
+  _freeList = block;
+  _nrOfAllocatedBlocks--;
+}
+
+MemoryStats getMemoryStats() {
+  const auto &arena = frameArena();
+  MemoryStats stats = {};
+  stats.isCountingHeapAllocations = isCountingHeapAllocations;
+  stats.heapAllocations = lastFrameHeapAllocations;
+  stats.frameArenaUsed = arena.used();
+  stats.frameArenaCapacity = arena.capacity();
+  stats.frameArenaOverflows = arena.nrOfOverflows();
+  return stats;
+}
+
+uint64_t getHeapAllocationCount() { return threadHeapAllocations; }
+
+void startCountingHeapAllocations() { isCountingHeapAllocations = true; }
+
+void countHeapAllocation() { threadHeapAllocations++; }
+
+} // namespace mg
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "mg/mgUtils.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace mg {
+
+void *alignedMalloc(size_t size, size_t alignment);
+void alignedFree(void *data);
+
+// Bump allocator over one block. When the block is full the allocation comes from an overflow block on the heap so an
+// arena never runs out, and the next reset grows the block to the high water mark, a frame that repeats the
+// allocations of the previous one does not touch the heap.
+class Arena : mg::nonCopyable {
+public:
+  struct Mark {
+    size_t offset;
+    void *overflowBlocks;
+  };
+
+  void create(size_t capacity);
+  void destroy();
+
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+  template <typename T> T *allocate(size_t count) { return (T *)allocate(count * sizeof(T), alignof(T)); }
+  // gives the memory back if it is the latest allocation, otherwise it stays until the arena is rewound
+  void deallocate(void *data, size_t size);
+  // grows the latest allocation in place when it fits, otherwise allocates and copies oldSize bytes
+  void *reallocate(void *data, size_t oldSize, size_t newSize, size_t alignment = alignof(std::max_align_t));
+
+  Mark mark() const;
+  void rewind(Mark mark);
+  void reset();
+
+  size_t used() const;
+  size_t capacity() const { return _capacity; }
+  size_t highWaterMark() const { return _highWaterMark; }
+  uint32_t nrOfOverflows() const { return _nrOfOverflows; }
+
+  ~Arena();
+
+private:
+  void *allocateOverflow(size_t size, size_t alignment);
+  void freeOverflowBlocks(void *until);
+
+  uint8_t *_data = nullptr;
+  size_t _capacity = 0;
+  size_t _offset = 0;
+  void *_overflowBlocks = nullptr; // newest first
+  size_t _overflowSize = 0;
+  size_t _highWaterMark = 0;
+  uint32_t _nrOfOverflows = 0;
+  void *_last = nullptr; // the latest allocation, the only one that can grow or be given back
+};
+
+// Two arenas that take turns frame by frame, memory from the frame arena lives until the end of the next frame so
+// the previous frame's data can still be read. Only for the thread that calls startFrame.
+void createFrameArenas(size_t capacity);
+void destroyFrameArenas();
+void beginMemoryFrame(); // called by mg::startFrame
+Arena &frameArena();
+
+// Per thread stack for temporaries, everything allocated through a scope is freed when the scope ends.
+class ScratchScope : mg::nonCopyable {
+public:
+  ScratchScope();
+  ~ScratchScope();
+
+  Arena &arena() { return *_arena; }
+  template <typename T> T *allocate(size_t count) { return _arena->allocate<T>(count); }
+
+private:
+  Arena *_arena;
+  Arena::Mark _mark;
+};
+
+// Fixed size blocks carved from chunks of blocksPerChunk, freed blocks are reused first.
+class Pool : mg::nonCopyable {
+public:
+  void create(uint32_t blockSize, uint32_t blockAlignment, uint32_t blocksPerChunk);
+  void destroy();
+
+  void *allocate();
+  void deallocate(void *block);
+  uint32_t nrOfAllocatedBlocks() const { return _nrOfAllocatedBlocks; }
+
+  ~Pool();
+
+private:
+  void addChunk();
+
+  uint32_t _blockSize = 0;
+  uint32_t _blockAlignment = 0;
+  uint32_t _blocksPerChunk = 0;
+  uint32_t _nrOfAllocatedBlocks = 0;
+  void *_freeList = nullptr;
+  std::vector<void *> _chunks;
+};
+
+template <typename T> class ObjectPool : mg::nonCopyable {
+public:
+  void create(uint32_t objectsPerChunk) { _pool.create(sizeof(T), alignof(T), objectsPerChunk); }
+  void destroy() { _pool.destroy(); }
+
+  template <typename... Args> T *construct(Args &&... args) {
+    return new (_pool.allocate()) T(std::forward<Args>(args)...);
+  }
+  void destruct(T *object) {
+    object->~T();
+    _pool.deallocate(object);
+  }
+  uint32_t size() const { return _pool.nrOfAllocatedBlocks(); }
+
+private:
+  Pool _pool;
+};
+
+// Lets standard containers allocate from an arena, std::vector<T, ArenaAllocator<T>>(ArenaAllocator<T>(&arena)).
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+  template <typename U> ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t count) { return arena->allocate<T>(count); }
+  void deallocate(T *data, size_t count) { arena->deallocate(data, count * sizeof(T)); }
+
+  Arena *arena;
+};
+
+template <typename T, typename U> bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+template <typename T, typename U> bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename T> ArenaVector<T> createFrameVector(size_t capacity = 0) {
+  ArenaVector<T> vector{ArenaAllocator<T>(&frameArena())};
+  vector.reserve(capacity);
+  return vector;
+}
+
+struct MemoryStats {
+  bool isCountingHeapAllocations; // the executable links mg-heap-counter
+  uint64_t heapAllocations;       // operator new calls by the frame thread during the last frame
+  size_t frameArenaUsed;
+  size_t frameArenaCapacity;
+  uint32_t frameArenaOverflows;
+};
+
+MemoryStats getMemoryStats();
+// operator new calls by the calling thread since it started
+uint64_t getHeapAllocationCount();
+
+// Heap allocations are only counted in executables that link mg-heap-counter, it replaces the global operator new
+// with one that calls countHeapAllocation and starts counting before main.
+void startCountingHeapAllocations();
+void countHeapAllocation();
+
+} // namespace mg
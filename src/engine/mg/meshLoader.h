@@ -1,5 +1,8 @@
 #pragma once
 #include "meshContainer.h"
+#include "mg/frustumCulling.h"
+#include "mg/meshSimplification.h"
+#include "mg/meshlets.h"
 #include "vulkan/shaderPipelineInput.h"
 #include <vector>
 #include <glm/glm.hpp>
@@ -41,9 +44,29 @@ struct ObjMaterial {
   glm::vec4 diffuse;
 };
 
+// the triangles of a level of detail in the index buffer all meshes of an obj file share
+struct ObjMeshLod {
+  uint32_t firstIndex, indexCount;
+  float error; // object space, see createMeshLods
+};
+
+// the vertices of a mesh in the vertex buffer all meshes of an obj file share, the indices of its levels of detail are
+// into the whole vertex buffer. Level 0 is the mesh as it is in the file.
+struct ObjMeshRange {
+  uint32_t firstVertex, vertexCount;
+  uint32_t nrOfLods;
+  ObjMeshLod lods[MAX_MESH_LODS];
+};
+
 struct ObjMeshes {
   std::vector<ObjMaterial> materials;
+  // one vertex and index buffer for all meshes, so they can be drawn by one indirect draw. ranges and bounds are
+  // parallel to meshes.
   std::vector<ObjMesh> meshes;
+  std::vector<ObjMeshRange> ranges;
+  std::vector<MeshBounds> bounds;
+  // of level 0 of all meshes, Meshlet::meshIndex is into meshes
+  Meshlets meshlets;
 };
 
 GltfMeshes parseGltf(const std::string &id, const std::string &path, const std::string &name);
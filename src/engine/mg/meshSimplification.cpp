@@ -0,0 +1,499 @@
+#include "meshSimplification.h"
+
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace mg {
+
+namespace {
+
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+// the planes through the border and seam edges count this much more than the planes of the triangles
+constexpr double BOUNDARY_WEIGHT = 10.0;
+
+uint32_t hashFloats(const float *values, uint32_t nrOfFloats) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < nrOfFloats; i++) {
+    uint32_t bits;
+    std::memcpy(&bits, values + i, sizeof(bits));
+    hash = (hash ^ bits) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+uint32_t tableSize(uint32_t nrOfEntries) {
+  uint32_t size = 16;
+  while (size < nrOfEntries * 2)
+    size *= 2;
+  return size;
+}
+
+// for every vertex the first vertex with the same first nrOfFloats floats, bit for bit
+std::vector<uint32_t> findFirstEqual(const float *vertices, uint32_t nrOfVertices, uint32_t stride,
+                                     uint32_t nrOfFloats) {
+  std::vector<uint32_t> table(tableSize(nrOfVertices), NO_INDEX);
+  const uint32_t mask = uint32_t(table.size()) - 1;
+  std::vector<uint32_t> firstEqual(nrOfVertices);
+  for (uint32_t v = 0; v < nrOfVertices; v++) {
+    const float *vertex = vertices + size_t(v) * stride;
+    uint32_t slot = hashFloats(vertex, nrOfFloats) & mask;
+    while (table[slot] != NO_INDEX &&
+           std::memcmp(vertices + size_t(table[slot]) * stride, vertex, nrOfFloats * sizeof(float)) != 0)
+      slot = (slot + 1) & mask;
+    if (table[slot] == NO_INDEX)
+      table[slot] = v;
+    firstEqual[v] = table[slot];
+  }
+  return firstEqual;
+}
+
+// An edge between two positions and what the triangles on it say about it
+struct Edge {
+  uint32_t a, b; // positions, a < b
+  uint32_t count;
+  uint32_t wedgeA, wedgeB; // the vertices of the first triangle at a and b
+  uint32_t triangle, group;
+  bool isSeam;          // the triangles use different vertices at a or b
+  bool isGroupBoundary; // the triangles are in different groups
+  bool isBorder() const { return count == 1 || isGroupBoundary; }
+};
+
+class EdgeTable {
+public:
+  explicit EdgeTable(uint32_t nrOfEdges) : _slots(tableSize(nrOfEdges), NO_INDEX) { _edges.reserve(nrOfEdges); }
+
+  void add(uint32_t positionA, uint32_t positionB, uint32_t wedgeA, uint32_t wedgeB, uint32_t triangle,
+           uint32_t group) {
+    if (positionA > positionB) {
+      std::swap(positionA, positionB);
+      std::swap(wedgeA, wedgeB);
+    }
+    const uint32_t mask = uint32_t(_slots.size()) - 1;
+    uint32_t slot = ((positionA * 0x9e3779b1u) ^ (positionB * 0x85ebca77u)) & mask;
+    while (_slots[slot] != NO_INDEX) {
+      auto &edge = _edges[_slots[slot]];
+      if (edge.a == positionA && edge.b == positionB) {
+        edge.count++;
+        edge.isSeam = edge.isSeam || edge.wedgeA != wedgeA || edge.wedgeB != wedgeB;
+        edge.isGroupBoundary = edge.isGroupBoundary || edge.group != group;
+        return;
+      }
+      slot = (slot + 1) & mask;
+    }
+    _slots[slot] = uint32_t(_edges.size());
+    _edges.push_back({positionA, positionB, 1, wedgeA, wedgeB, triangle, group, false, false});
+  }
+
+  const std::vector<Edge> &edges() const { return _edges; }
+
+private:
+  std::vector<uint32_t> _slots;
+  std::vector<Edge> _edges;
+};
+
+// the sum of weighted squared distances to planes, x^T A x + 2 b^T x + c
+struct Quadric {
+  double a00, a01, a02, a11, a12, a22;
+  double b0, b1, b2;
+  double c;
+  double weight; // the area of the triangles, the errors are divided by it
+};
+
+Quadric planeQuadric(const glm::dvec3 &normal, double distance, double weight) {
+  const auto &n = normal;
+  return {weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z,      weight * n.y * n.y,
+          weight * n.y * n.z, weight * n.z * n.z, weight * n.x * distance, weight * n.y * distance,
+          weight * n.z * distance, weight * distance * distance, 0.0};
+}
+
+void add(Quadric *quadric, const Quadric &other) {
+  auto &q = *quadric;
+  q.a00 += other.a00, q.a01 += other.a01, q.a02 += other.a02;
+  q.a11 += other.a11, q.a12 += other.a12, q.a22 += other.a22;
+  q.b0 += other.b0, q.b1 += other.b1, q.b2 += other.b2;
+  q.c += other.c;
+  q.weight += other.weight;
+}
+
+double evaluate(const Quadric &q, const glm::dvec3 &p) {
+  const double ax = q.a00 * p.x + q.a01 * p.y + q.a02 * p.z;
+  const double ay = q.a01 * p.x + q.a11 * p.y + q.a12 * p.z;
+  const double az = q.a02 * p.x + q.a12 * p.y + q.a22 * p.z;
+  return std::max(p.x * ax + p.y * ay + p.z * az + 2.0 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c, 0.0);
+}
+
+enum class VERTEX_KIND : uint8_t {
+  MANIFOLD, // moves into any neighbor
+  SEAM,     // moves along its two seam edges
+  BORDER,   // moves along its two border edges
+  LOCKED,   // corners of borders and seams and non manifold vertices
+};
+
+struct Collapse {
+  uint32_t from, to; // positions
+  float error;
+};
+
+class Simplifier {
+public:
+  explicit Simplifier(const MeshGeometry &geometry)
+      : _geometry(geometry), _indices(geometry.indices, geometry.indices + geometry.nrOfIndices) {
+    _position = findFirstEqual(geometry.vertices, geometry.nrOfVertices, geometry.nrOfFloats, 3);
+    _groups.resize(geometry.nrOfIndices / 3, 0);
+    if (geometry.triangleGroups)
+      _groups.assign(geometry.triangleGroups, geometry.triangleGroups + geometry.nrOfIndices / 3);
+    const auto edgeTable = findEdges();
+    classifyVertices(edgeTable);
+    computeQuadrics(edgeTable);
+  }
+
+  float simplify(uint32_t targetNrOfIndices, float maxError) {
+    float error = 0.0f;
+    while (_indices.size() > targetNrOfIndices) {
+      const auto edges = findEdges();
+      auto collapses = findCollapses(edges);
+      std::sort(collapses.begin(), collapses.end(),
+                [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+      // every collapse removes about two triangles, the collapses of a pass do not share a position
+      const uint32_t nrOfTrianglesToRemove = uint32_t(_indices.size() - targetNrOfIndices) / 3;
+      uint32_t nrOfRemoved = 0, nrOfCollapses = 0;
+      buildAdjacency();
+      std::vector<bool> isTouched(_geometry.nrOfVertices, false);
+      for (const auto &collapse : collapses) {
+        if (collapse.error > maxError || nrOfRemoved >= nrOfTrianglesToRemove)
+          break;
+        if (isTouched[collapse.from] || isTouched[collapse.to])
+          continue;
+        const uint32_t removed = tryCollapse(collapse);
+        if (removed == NO_INDEX)
+          continue;
+        isTouched[collapse.from] = isTouched[collapse.to] = true;
+        nrOfRemoved += removed;
+        nrOfCollapses++;
+        error = std::max(error, collapse.error);
+      }
+      removeDegenerateTriangles();
+      if (!nrOfCollapses)
+        break;
+    }
+    return error;
+  }
+
+  const std::vector<uint32_t> &indices() const { return _indices; }
+  const std::vector<uint32_t> &groups() const { return _groups; }
+
+private:
+  glm::dvec3 position(uint32_t vertex) const {
+    const float *p = _geometry.vertices + size_t(vertex) * _geometry.nrOfFloats;
+    return {p[0], p[1], p[2]};
+  }
+
+  EdgeTable findEdges() const {
+    EdgeTable edgeTable(uint32_t(_indices.size()));
+    for (uint32_t t = 0; t < _indices.size() / 3; t++) {
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t a = _indices[t * 3 + corner], b = _indices[t * 3 + (corner + 1) % 3];
+        edgeTable.add(_position[a], _position[b], a, b, t, _groups[t]);
+      }
+    }
+    return edgeTable;
+  }
+
+  void classifyVertices(const EdgeTable &edgeTable) {
+    std::vector<uint32_t> nrOfBorderEdges(_geometry.nrOfVertices, 0), nrOfSeamEdges(_geometry.nrOfVertices, 0);
+    std::vector<bool> isNonManifold(_geometry.nrOfVertices, false);
+    for (const auto &edge : edgeTable.edges()) {
+      for (const auto p : {edge.a, edge.b}) {
+        nrOfBorderEdges[p] += edge.isBorder();
+        nrOfSeamEdges[p] += edge.isSeam && !edge.isBorder();
+        isNonManifold[p] = isNonManifold[p] || edge.count > 2;
+      }
+    }
+    _kinds.resize(_geometry.nrOfVertices, VERTEX_KIND::MANIFOLD);
+    for (uint32_t p = 0; p < _geometry.nrOfVertices; p++) {
+      if (isNonManifold[p] || (nrOfBorderEdges[p] && nrOfSeamEdges[p]))
+        _kinds[p] = VERTEX_KIND::LOCKED;
+      else if (nrOfBorderEdges[p])
+        _kinds[p] = nrOfBorderEdges[p] == 2 ? VERTEX_KIND::BORDER : VERTEX_KIND::LOCKED;
+      else if (nrOfSeamEdges[p])
+        _kinds[p] = nrOfSeamEdges[p] == 2 ? VERTEX_KIND::SEAM : VERTEX_KIND::LOCKED;
+    }
+  }
+
+  glm::dvec3 triangleNormal(uint32_t triangle) const {
+    const auto p0 = position(_indices[triangle * 3]), p1 = position(_indices[triangle * 3 + 1]),
+               p2 = position(_indices[triangle * 3 + 2]);
+    return glm::cross(p1 - p0, p2 - p0);
+  }
+
+  void computeQuadrics(const EdgeTable &edgeTable) {
+    _quadrics.resize(_geometry.nrOfVertices, {});
+    for (uint32_t t = 0; t < _indices.size() / 3; t++) {
+      const auto normal = triangleNormal(t);
+      const double length = glm::length(normal);
+      if (length == 0.0)
+        continue;
+      const auto n = normal / length;
+      const double area = length * 0.5;
+      auto quadric = planeQuadric(n, -glm::dot(n, position(_indices[t * 3])), area);
+      quadric.weight = area;
+      for (uint32_t corner = 0; corner < 3; corner++)
+        add(&_quadrics[_position[_indices[t * 3 + corner]]], quadric);
+    }
+
+    // a plane through the border and seam edges, perpendicular to a triangle, keeps their vertices on the line
+    for (const auto &edge : edgeTable.edges()) {
+      if (!edge.isBorder() && !edge.isSeam)
+        continue;
+      const auto pa = position(edge.a), pb = position(edge.b);
+      const auto edgeNormal = glm::cross(pb - pa, triangleNormal(edge.triangle));
+      const double length = glm::length(edgeNormal);
+      if (length == 0.0)
+        continue;
+      const auto n = edgeNormal / length;
+      const double edgeLength = glm::length(pb - pa);
+      const auto quadric = planeQuadric(n, -glm::dot(n, pa), BOUNDARY_WEIGHT * edgeLength * edgeLength);
+      add(&_quadrics[edge.a], quadric);
+      add(&_quadrics[edge.b], quadric);
+    }
+  }
+
+  bool canMove(uint32_t from, const Edge &edge) const {
+    switch (_kinds[from]) {
+    case VERTEX_KIND::MANIFOLD:
+      return true;
+    case VERTEX_KIND::SEAM:
+      return edge.isSeam && !edge.isBorder();
+    case VERTEX_KIND::BORDER:
+      return edge.isBorder();
+    default:
+      return false;
+    }
+  }
+
+  float collapseError(uint32_t from, uint32_t to) const {
+    Quadric quadric = _quadrics[from];
+    add(&quadric, _quadrics[to]);
+    if (quadric.weight <= 0.0)
+      return 0.0f;
+    return float(std::sqrt(evaluate(quadric, position(to)) / quadric.weight));
+  }
+
+  std::vector<Collapse> findCollapses(const EdgeTable &edgeTable) const {
+    std::vector<Collapse> collapses;
+    collapses.reserve(edgeTable.edges().size());
+    for (const auto &edge : edgeTable.edges()) {
+      Collapse best = {NO_INDEX, NO_INDEX, FLT_MAX};
+      if (canMove(edge.a, edge))
+        best = {edge.a, edge.b, collapseError(edge.a, edge.b)};
+      if (canMove(edge.b, edge)) {
+        const float error = collapseError(edge.b, edge.a);
+        if (error < best.error)
+          best = {edge.b, edge.a, error};
+      }
+      if (best.from != NO_INDEX)
+        collapses.push_back(best);
+    }
+    return collapses;
+  }
+
+  // the triangles around every position
+  void buildAdjacency() {
+    _firstTriangle.assign(_geometry.nrOfVertices + 1, 0);
+    for (const auto index : _indices)
+      _firstTriangle[_position[index] + 1]++;
+    for (uint32_t p = 0; p < _geometry.nrOfVertices; p++)
+      _firstTriangle[p + 1] += _firstTriangle[p];
+    _triangles.resize(_indices.size());
+    std::vector<uint32_t> offsets(_firstTriangle.begin(), _firstTriangle.end() - 1);
+    for (uint32_t i = 0; i < _indices.size(); i++)
+      _triangles[offsets[_position[_indices[i]]]++] = i / 3;
+  }
+
+  bool hasPosition(uint32_t triangle, uint32_t p) const {
+    return _position[_indices[triangle * 3]] == p || _position[_indices[triangle * 3 + 1]] == p ||
+           _position[_indices[triangle * 3 + 2]] == p;
+  }
+
+  // Returns the number of triangles removed or NO_INDEX when the collapse would tear a seam or flip a triangle
+  uint32_t tryCollapse(const Collapse &collapse) {
+    const uint32_t from = collapse.from, to = collapse.to;
+    // every vertex at from moves to the vertex at to it shares a triangle with, it has to be exactly one
+    _wedgeMap.clear();
+    for (uint32_t i = _firstTriangle[from]; i < _firstTriangle[from + 1]; i++) {
+      const uint32_t t = _triangles[i];
+      uint32_t wedgeFrom = NO_INDEX, wedgeTo = NO_INDEX;
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t v = _indices[t * 3 + corner];
+        if (_position[v] == from)
+          wedgeFrom = v;
+        else if (_position[v] == to)
+          wedgeTo = v;
+      }
+      if (wedgeTo == NO_INDEX)
+        continue;
+      auto mapped = std::find_if(_wedgeMap.begin(), _wedgeMap.end(),
+                                 [&](const std::pair<uint32_t, uint32_t> &m) { return m.first == wedgeFrom; });
+      if (mapped == _wedgeMap.end())
+        _wedgeMap.push_back({wedgeFrom, wedgeTo});
+      else if (mapped->second != wedgeTo)
+        return NO_INDEX;
+    }
+    for (uint32_t i = _firstTriangle[from]; i < _firstTriangle[from + 1]; i++) {
+      const uint32_t t = _triangles[i];
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t v = _indices[t * 3 + corner];
+        if (_position[v] == from &&
+            std::none_of(_wedgeMap.begin(), _wedgeMap.end(),
+                         [&](const std::pair<uint32_t, uint32_t> &m) { return m.first == v; }))
+          return NO_INDEX;
+      }
+    }
+
+    // the triangles that stay must keep facing about the same way, a steeper fold stands slivers on the borders
+    const auto target = position(to);
+    for (uint32_t i = _firstTriangle[from]; i < _firstTriangle[from + 1]; i++) {
+      const uint32_t t = _triangles[i];
+      if (hasPosition(t, to))
+        continue;
+      glm::dvec3 corners[3], moved[3];
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t v = _indices[t * 3 + corner];
+        corners[corner] = position(v);
+        moved[corner] = _position[v] == from ? target : corners[corner];
+      }
+      const auto normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      const auto movedNormal = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+      if (glm::dot(normal, movedNormal) <= 0.25 * glm::length(normal) * glm::length(movedNormal))
+        return NO_INDEX;
+    }
+
+    uint32_t nrOfRemoved = 0;
+    for (uint32_t i = _firstTriangle[from]; i < _firstTriangle[from + 1]; i++) {
+      const uint32_t t = _triangles[i];
+      nrOfRemoved += hasPosition(t, to);
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        auto &v = _indices[t * 3 + corner];
+        if (_position[v] != from)
+          continue;
+        for (const auto &m : _wedgeMap) {
+          if (m.first == v) {
+            v = m.second;
+            break;
+          }
+        }
+      }
+    }
+    add(&_quadrics[to], _quadrics[from]);
+    return nrOfRemoved;
+  }
+
+  void removeDegenerateTriangles() {
+    uint32_t nrOfTriangles = 0;
+    for (uint32_t t = 0; t < _indices.size() / 3; t++) {
+      const uint32_t p0 = _position[_indices[t * 3]], p1 = _position[_indices[t * 3 + 1]],
+                     p2 = _position[_indices[t * 3 + 2]];
+      if (p0 == p1 || p1 == p2 || p2 == p0)
+        continue;
+      for (uint32_t corner = 0; corner < 3; corner++)
+        _indices[nrOfTriangles * 3 + corner] = _indices[t * 3 + corner];
+      _groups[nrOfTriangles] = _groups[t];
+      nrOfTriangles++;
+    }
+    _indices.resize(nrOfTriangles * 3);
+    _groups.resize(nrOfTriangles);
+  }
+
+  const MeshGeometry &_geometry;
+  std::vector<uint32_t> _indices;
+  std::vector<uint32_t> _groups;
+  // positions are the first vertex with the position, everything per position is indexed by it
+  std::vector<uint32_t> _position;
+  std::vector<VERTEX_KIND> _kinds;
+  std::vector<Quadric> _quadrics;
+  std::vector<uint32_t> _firstTriangle, _triangles;
+  std::vector<std::pair<uint32_t, uint32_t>> _wedgeMap;
+};
+
+} // namespace
+
+void weldVertices(const float *vertices, uint32_t nrOfVertices, uint32_t nrOfFloats,
+                  std::vector<float> *weldedVertices, std::vector<uint32_t> *indices) {
+  const auto firstEqual = findFirstEqual(vertices, nrOfVertices, nrOfFloats, nrOfFloats);
+  std::vector<uint32_t> remap(nrOfVertices, NO_INDEX);
+  weldedVertices->clear();
+  indices->resize(nrOfVertices);
+  uint32_t nrOfWelded = 0;
+  for (uint32_t v = 0; v < nrOfVertices; v++) {
+    const uint32_t first = firstEqual[v];
+    if (remap[first] == NO_INDEX) {
+      remap[first] = nrOfWelded++;
+      weldedVertices->insert(weldedVertices->end(), vertices + size_t(first) * nrOfFloats,
+                             vertices + size_t(first + 1) * nrOfFloats);
+    }
+    (*indices)[v] = remap[first];
+  }
+}
+
+float simplifyMesh(const MeshGeometry &geometry, uint32_t targetNrOfIndices, float maxError,
+                   std::vector<uint32_t> *indices) {
+  mgAssert(geometry.nrOfIndices % 3 == 0);
+  mgAssert(geometry.nrOfFloats >= 3);
+  Simplifier simplifier(geometry);
+  const float error = simplifier.simplify(targetNrOfIndices, maxError);
+  *indices = simplifier.indices();
+  return error;
+}
+
+std::vector<MeshLod> createMeshLods(const MeshGeometry &geometry, uint32_t minNrOfTriangles) {
+  mgAssert(geometry.nrOfIndices % 3 == 0);
+  mgAssert(geometry.nrOfFloats >= 3);
+  std::vector<MeshLod> lods(1);
+  lods[0].indices.assign(geometry.indices, geometry.indices + geometry.nrOfIndices);
+  lods[0].error = 0.0f;
+  std::vector<uint32_t> groups;
+  if (geometry.triangleGroups)
+    groups.assign(geometry.triangleGroups, geometry.triangleGroups + geometry.nrOfIndices / 3);
+  while (lods.size() < MAX_MESH_LODS) {
+    const auto &last = lods.back();
+    const uint32_t nrOfIndices = uint32_t(last.indices.size());
+    if (nrOfIndices / 3 < minNrOfTriangles * 2)
+      break;
+    MeshGeometry lastGeometry = geometry;
+    lastGeometry.indices = last.indices.data();
+    lastGeometry.nrOfIndices = nrOfIndices;
+    lastGeometry.triangleGroups = groups.empty() ? nullptr : groups.data();
+
+    Simplifier simplifier(lastGeometry);
+    const float error = simplifier.simplify(nrOfIndices / 6 * 3, FLT_MAX);
+    // less than a tenth fewer triangles is not worth a level
+    if (simplifier.indices().size() * 10 > size_t(nrOfIndices) * 9)
+      break;
+    if (!groups.empty())
+      groups = simplifier.groups();
+    lods.push_back({simplifier.indices(), last.error + error});
+  }
+  return lods;
+}
+
+float lodScale(const glm::mat4 &projection, uint32_t screenHeight) {
+  return projection[1][1] * float(screenHeight) * 0.5f;
+}
+
+uint32_t selectMeshLod(const LodSelection &lodSelection, const glm::vec4 &sphere, const float *errors,
+                       uint32_t nrOfLods) {
+  if (lodSelection.threshold <= 0.0f)
+    return 0;
+  const float distance =
+      std::max(glm::distance(glm::vec3(sphere), lodSelection.cameraPosition) - sphere.w, 1e-3f);
+  uint32_t lod = 0;
+  while (lod + 1 < nrOfLods && errors[lod + 1] * lodSelection.scale <= lodSelection.threshold * distance)
+    lod++;
+  return lod;
+}
+
+} // namespace mg
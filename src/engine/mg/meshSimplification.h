@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+constexpr uint32_t MAX_MESH_LODS = 5;
+
+// Merges vertices that are equal in every float, a triangle soup becomes indexed triangles. Vertices have nrOfFloats
+// floats.
+void weldVertices(const float *vertices, uint32_t nrOfVertices, uint32_t nrOfFloats,
+                  std::vector<float> *weldedVertices, std::vector<uint32_t> *indices);
+
+struct MeshGeometry {
+  const float *vertices; // nrOfFloats per vertex, the position first
+  uint32_t nrOfVertices;
+  uint32_t nrOfFloats;
+  const uint32_t *indices;
+  uint32_t nrOfIndices;
+  // one per triangle or nullptr, the edges between triangles of different groups such as materials stay in place
+  const uint32_t *triangleGroups;
+};
+
+// Quadric error metric simplification with half edge collapses, the cheapest edges are collapsed until there are
+// targetNrOfIndices or the next collapse would move the surface more than maxError. The simplified triangles use a
+// subset of the vertices. Vertices with the same position and different attributes are a seam, a seam vertex only
+// moves along the seam into a vertex with the same attributes on each side, so uv and normal seams stay intact, and
+// the same holds for the borders of the mesh and of the triangle groups. Returns the distance the surface moved, an
+// area weighted root mean square of the distances to the planes of the removed triangles at the worst collapse.
+float simplifyMesh(const MeshGeometry &geometry, uint32_t targetNrOfIndices, float maxError,
+                   std::vector<uint32_t> *indices);
+
+struct MeshLod {
+  std::vector<uint32_t> indices;
+  float error; // object space, 0 for level 0
+};
+
+// Level 0 is the geometry, every next level is simplified from the one before it to half its triangles and adds its
+// error to the error of that level. Ends at MAX_MESH_LODS levels, below minNrOfTriangles or when a level no longer
+// gets simpler.
+std::vector<MeshLod> createMeshLods(const MeshGeometry &geometry, uint32_t minNrOfTriangles);
+
+// threshold is the error in pixels a level may have on screen, 0 always selects level 0
+struct LodSelection {
+  glm::vec3 cameraPosition;
+  float scale; // pixels per unit of error at a distance of 1, see lodScale
+  float threshold;
+};
+
+float lodScale(const glm::mat4 &projection, uint32_t screenHeight);
+// the coarsest level whose error projected at the nearest point of the sphere is within the threshold, the errors of
+// the levels grow with the level
+uint32_t selectMeshLod(const LodSelection &lodSelection, const glm::vec4 &sphere, const float *errors,
+                       uint32_t nrOfLods);
+
+} // namespace mg
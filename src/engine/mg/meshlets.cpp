@@ -0,0 +1,202 @@
+#include "meshlets.h"
+
+#include "mg/mgAssert.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mg {
+
+namespace {
+
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+constexpr uint8_t NO_SLOT = 0xff;
+
+glm::vec3 position(const float *vertices, uint32_t nrOfFloats, uint32_t vertex) {
+  const float *p = vertices + size_t(vertex) * nrOfFloats;
+  return {p[0], p[1], p[2]};
+}
+
+// the triangles around every vertex, the vertices are minimum to maximum of the indices
+struct Adjacency {
+  uint32_t minimum;
+  std::vector<uint32_t> firstTriangle, triangles;
+};
+
+Adjacency createAdjacency(const uint32_t *indices, uint32_t nrOfIndices) {
+  Adjacency adjacency = {};
+  const auto range = std::minmax_element(indices, indices + nrOfIndices);
+  adjacency.minimum = *range.first;
+  const uint32_t nrOfVertices = *range.second - *range.first + 1;
+  adjacency.firstTriangle.assign(nrOfVertices + 1, 0);
+  for (uint32_t i = 0; i < nrOfIndices; i++)
+    adjacency.firstTriangle[indices[i] - adjacency.minimum + 1]++;
+  for (uint32_t v = 0; v < nrOfVertices; v++)
+    adjacency.firstTriangle[v + 1] += adjacency.firstTriangle[v];
+  adjacency.triangles.resize(nrOfIndices);
+  std::vector<uint32_t> offsets(adjacency.firstTriangle.begin(), adjacency.firstTriangle.end() - 1);
+  for (uint32_t i = 0; i < nrOfIndices; i++)
+    adjacency.triangles[offsets[indices[i] - adjacency.minimum]++] = i / 3;
+  return adjacency;
+}
+
+// the sphere around the box of the vertices and the cone of the triangle normals
+void computeMeshletBounds(const float *vertices, uint32_t nrOfFloats, const Meshlets &meshlets, Meshlet *meshlet) {
+  const uint32_t *meshletVertices = meshlets.vertices.data() + meshlet->firstVertex;
+  glm::vec3 minimum = position(vertices, nrOfFloats, meshletVertices[0]), maximum = minimum;
+  for (uint32_t i = 1; i < meshlet->vertexCount; i++) {
+    const auto p = position(vertices, nrOfFloats, meshletVertices[i]);
+    minimum = glm::min(minimum, p);
+    maximum = glm::max(maximum, p);
+  }
+  const glm::vec3 center = (minimum + maximum) * 0.5f;
+  float radius = 0.0f;
+  for (uint32_t i = 0; i < meshlet->vertexCount; i++)
+    radius = std::max(radius, glm::distance(center, position(vertices, nrOfFloats, meshletVertices[i])));
+  meshlet->sphere = glm::vec4(center, radius);
+
+  std::vector<glm::vec3> normals;
+  normals.reserve(meshlet->triangleCount);
+  glm::vec3 axis = {};
+  for (uint32_t t = 0; t < meshlet->triangleCount; t++) {
+    const uint32_t triangle = meshlets.triangles[meshlet->firstTriangle + t];
+    const auto p0 = position(vertices, nrOfFloats, meshletVertices[triangle & 0xff]);
+    const auto p1 = position(vertices, nrOfFloats, meshletVertices[(triangle >> 8) & 0xff]);
+    const auto p2 = position(vertices, nrOfFloats, meshletVertices[(triangle >> 16) & 0xff]);
+    const auto normal = glm::cross(p1 - p0, p2 - p0);
+    const float length = glm::length(normal);
+    // a degenerate triangle covers no pixels whichever way it faces
+    if (length == 0.0f)
+      continue;
+    normals.push_back(normal / length);
+    axis += normals.back();
+  }
+  const float axisLength = glm::length(axis);
+  if (axisLength == 0.0f) {
+    meshlet->cone = {0.0f, 0.0f, 0.0f, 1.0f};
+    return;
+  }
+  axis /= axisLength;
+  float minimumDot = 1.0f;
+  for (const auto &normal : normals)
+    minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+  // the camera has to be behind all triangles, that is inside the cone of the normals widened by 90 degrees and
+  // flipped, its half angle is 90 degrees minus the one of the normals and the cutoff its cosine, the sine of theirs
+  const float cutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+  meshlet->cone = glm::vec4(axis, cutoff);
+}
+
+} // namespace
+
+void buildMeshlets(const float *vertices, uint32_t nrOfFloats, const uint32_t *indices, uint32_t nrOfIndices,
+                   uint32_t firstIndex, uint32_t meshIndex, Meshlets *meshlets, uint32_t *orderedIndices) {
+  mgAssert(nrOfIndices % 3 == 0);
+  if (!nrOfIndices)
+    return;
+  const uint32_t nrOfTriangles = nrOfIndices / 3;
+  const auto adjacency = createAdjacency(indices, nrOfIndices);
+  std::vector<bool> isEmitted(nrOfTriangles, false);
+  // the slot of a vertex in the current meshlet
+  std::vector<uint8_t> slots(adjacency.firstTriangle.size() - 1, NO_SLOT);
+  // the meshlet a triangle was last made a candidate for, so it is added to the candidates once
+  std::vector<uint32_t> candidateOf(nrOfTriangles, NO_INDEX);
+  std::vector<uint32_t> candidates;
+
+  uint32_t nrOfOrdered = 0, seed = 0;
+  while (nrOfOrdered < nrOfTriangles) {
+    Meshlet meshlet = {};
+    meshlet.firstVertex = uint32_t(meshlets->vertices.size());
+    meshlet.firstTriangle = uint32_t(meshlets->triangles.size());
+    meshlet.firstIndex = firstIndex + nrOfOrdered * 3;
+    meshlet.meshIndex = meshIndex;
+    const uint32_t meshletIndex = uint32_t(meshlets->meshlets.size());
+
+    while (isEmitted[seed])
+      seed++;
+    uint32_t next = seed;
+    candidates.clear();
+    while (next != NO_INDEX) {
+      // add the triangle and make its neighbors candidates
+      const uint32_t *triangle = indices + size_t(next) * 3;
+      uint32_t packed = 0;
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        auto &slot = slots[triangle[corner] - adjacency.minimum];
+        if (slot == NO_SLOT) {
+          slot = uint8_t(meshlet.vertexCount++);
+          meshlets->vertices.push_back(triangle[corner]);
+        }
+        packed |= uint32_t(slot) << (corner * 8);
+        const uint32_t v = triangle[corner] - adjacency.minimum;
+        for (uint32_t i = adjacency.firstTriangle[v]; i < adjacency.firstTriangle[v + 1]; i++) {
+          const uint32_t neighbor = adjacency.triangles[i];
+          if (!isEmitted[neighbor] && candidateOf[neighbor] != meshletIndex) {
+            candidateOf[neighbor] = meshletIndex;
+            candidates.push_back(neighbor);
+          }
+        }
+      }
+      meshlets->triangles.push_back(packed);
+      std::copy(triangle, triangle + 3, orderedIndices + size_t(nrOfOrdered) * 3);
+      isEmitted[next] = true;
+      nrOfOrdered++;
+      meshlet.triangleCount++;
+      if (meshlet.triangleCount == MAX_MESHLET_TRIANGLES)
+        break;
+
+      // the candidate that adds the fewest vertices and still fits, the emitted ones are dropped on the way
+      next = NO_INDEX;
+      uint32_t fewestNewVertices = 4, nrOfCandidates = 0;
+      for (const auto candidate : candidates) {
+        if (isEmitted[candidate])
+          continue;
+        candidates[nrOfCandidates++] = candidate;
+        const uint32_t *corners = indices + size_t(candidate) * 3;
+        uint32_t newVertices = 0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+          newVertices += slots[corners[corner] - adjacency.minimum] == NO_SLOT;
+        if (newVertices < fewestNewVertices && meshlet.vertexCount + newVertices <= MAX_MESHLET_VERTICES) {
+          fewestNewVertices = newVertices;
+          next = candidate;
+        }
+      }
+      candidates.resize(nrOfCandidates);
+    }
+
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+      slots[meshlets->vertices[meshlet.firstVertex + i] - adjacency.minimum] = NO_SLOT;
+    computeMeshletBounds(vertices, nrOfFloats, *meshlets, &meshlet);
+    meshlets->meshlets.push_back(meshlet);
+  }
+}
+
+bool isMeshletBackFacing(const Meshlet &meshlet, const glm::vec3 &cameraPosition) {
+  const glm::vec3 toMeshlet = glm::vec3(meshlet.sphere) - cameraPosition;
+  return glm::dot(toMeshlet, glm::vec3(meshlet.cone)) >= meshlet.cone.w * glm::length(toMeshlet) + meshlet.sphere.w;
+}
+
+uint32_t cullMeshlets(const Frustum &frustum, const glm::vec3 &cameraPosition, const Meshlet *meshlets,
+                      uint32_t nrOfMeshlets, uint32_t *visible) {
+  uint32_t nrOfVisible = 0;
+  for (uint32_t i = 0; i < nrOfMeshlets; i++) {
+    if (isSphereInFrustum(frustum, meshlets[i].sphere) && !isMeshletBackFacing(meshlets[i], cameraPosition))
+      visible[nrOfVisible++] = i;
+  }
+  return nrOfVisible;
+}
+
+uint32_t writeMeshletIndices(const Meshlets &meshlets, const uint32_t *visible, uint32_t nrOfVisible,
+                             uint32_t *indices) {
+  uint32_t nrOfIndices = 0;
+  for (uint32_t i = 0; i < nrOfVisible; i++) {
+    const auto &meshlet = meshlets.meshlets[visible[i]];
+    const uint32_t *meshletVertices = meshlets.vertices.data() + meshlet.firstVertex;
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+      const uint32_t triangle = meshlets.triangles[meshlet.firstTriangle + t];
+      indices[nrOfIndices++] = meshletVertices[triangle & 0xff];
+      indices[nrOfIndices++] = meshletVertices[(triangle >> 8) & 0xff];
+      indices[nrOfIndices++] = meshletVertices[(triangle >> 16) & 0xff];
+    }
+  }
+  return nrOfIndices;
+}
+
+} // namespace mg
@@ -0,0 +1,56 @@
+#pragma once
+#include "mg/frustumCulling.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+// A cluster of neighboring triangles, the layout of Meshlet in cullMeshlets.comp
+struct Meshlet {
+  glm::vec4 sphere; // xyz center, w radius
+  // xyz the average normal, w the cutoff of the cone of the normals, 1 when the normals spread too far to cull
+  glm::vec4 cone;
+  uint32_t firstVertex, vertexCount;     // in Meshlets::vertices
+  uint32_t firstTriangle, triangleCount; // in Meshlets::triangles
+  // the triangles are also in this order in the index buffer of the mesh
+  uint32_t firstIndex;
+  uint32_t meshIndex;
+  uint32_t pad[2];
+};
+
+struct Meshlets {
+  std::vector<Meshlet> meshlets;
+  // indices into the vertex buffer
+  std::vector<uint32_t> vertices;
+  // three 8 bit indices into the vertices of the meshlet, the first in the low byte
+  std::vector<uint32_t> triangles;
+};
+
+// Appends the meshlets of the triangles to meshlets, at most MAX_MESHLET_VERTICES vertices and MAX_MESHLET_TRIANGLES
+// triangles each. A meshlet grows by the neighboring triangle that adds the fewest vertices and starts a new one when
+// none fits. The triangles are written to orderedIndices in meshlet order, firstIndex is where they are in the index
+// buffer of the mesh. The vertices have nrOfFloats floats with the position first, and a triangle faces the side its
+// counter clockwise winding does.
+void buildMeshlets(const float *vertices, uint32_t nrOfFloats, const uint32_t *indices, uint32_t nrOfIndices,
+                   uint32_t firstIndex, uint32_t meshIndex, Meshlets *meshlets, uint32_t *orderedIndices);
+
+// true when every triangle of the meshlet faces away from the camera
+bool isMeshletBackFacing(const Meshlet &meshlet, const glm::vec3 &cameraPosition);
+
+// meshlet i culled by the frustum has no bit set, the gpu pass also sets VISIBLE when the hi-z did not hide it
+enum MESHLET_VISIBILITY : uint32_t { MESHLET_IN_FRUSTUM = 1, MESHLET_FRONT_FACING = 2, MESHLET_VISIBLE = 4 };
+
+// The cpu version of the cull pass without the hi-z. Writes the indices of the meshlets that are in the frustum and
+// not facing away from the camera to visible in ascending order, returns their number.
+uint32_t cullMeshlets(const Frustum &frustum, const glm::vec3 &cameraPosition, const Meshlet *meshlets,
+                      uint32_t nrOfMeshlets, uint32_t *visible);
+// The index stream of the cull pass, the vertex buffer indices of the triangles of the visible meshlets one meshlet
+// after the other. indices has room for all their triangles, returns the number of indices.
+uint32_t writeMeshletIndices(const Meshlets &meshlets, const uint32_t *visible, uint32_t nrOfVisible,
+                             uint32_t *indices);
+
+} // namespace mg
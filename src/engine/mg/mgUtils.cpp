@@ -12,6 +12,17 @@
 
 #include "mgAssert.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <glm/glm.hpp>
 
 namespace mg {
@@ -102,6 +113,59 @@ std::vector<uint8_t> readBinaryFromDisc(const std::string &fileName) {
   return std::vector<uint8_t>();
 }
 
+bool MappedFile::open(const std::string &fileName) {
+  close();
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER fileSize = {};
+  GetFileSizeEx(file, &fileSize);
+  HANDLE mapping = fileSize.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  // the mapping keeps the file open
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+  _data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!_data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  _mapping = mapping;
+  _size = size_t(fileSize.QuadPart);
+#else
+  const int file = ::open(fileName.c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+  struct stat fileStat = {};
+  void *data = MAP_FAILED;
+  if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+    data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+  // the mapping keeps the file open
+  ::close(file);
+  if (data == MAP_FAILED)
+    return false;
+  _data = (const uint8_t *)data;
+  _size = size_t(fileStat.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::close() {
+  if (!_data)
+    return;
+#if defined(_WIN32)
+  UnmapViewOfFile(_data);
+  CloseHandle(_mapping);
+#else
+  munmap((void *)_data, _size);
+#endif
+  _data = nullptr;
+  _size = 0;
+  _mapping = nullptr;
+}
+
 std::vector<char> readBinaryCharVecFromDisc(const std::string &fileName) {
   std::ifstream file(fileName, std::ios::binary | std::ios::ate);
   mgAssertDesc(file.is_open(), "could not open file " + fileName);
@@ -156,7 +220,8 @@ std::string toLower(std::string str) {
 
 std::string getFontsPath() { return "../../../resources/fonts/"; }
 std::string getTexturePath() { return "../../../resources/textures/"; }
-std::string getShaderPath() { return "../../../resources/shaders/build/"; }
+// the build compiles the shaders into its binary directory, see MG_SPIRV_DIR in the top CMakeLists.txt
+std::string getShaderPath() { return MG_SPIRV_DIR; }
 std::string getDataPath() { return "../../../resources/data/"; }
 std::string getTransferFunctionPath() { return "../../../resources/transferFunctions/"; }
 
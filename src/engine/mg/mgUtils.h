@@ -69,6 +69,9 @@ inline Time now() {
 inline uint64_t durationInMs(const Time &start, const Time &end) {
   return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
 }
+inline uint64_t durationInUs(const Time &start, const Time &end) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
 }
 
 std::string rtrim(const std::string &s);
@@ -82,6 +85,22 @@ std::vector<uint8_t> readBinaryFromDisc(const std::string &name);
 std::vector<char> readBinaryCharVecFromDisc(const std::string &name);
 std::string readStringFromDisc(const std::string &fileName);
 
+// Read only memory map of a whole file, pages are read on first touch and shared with the os file cache.
+class MappedFile : nonCopyable {
+public:
+  bool open(const std::string &fileName);
+  void close();
+  bool isOpen() const { return _data != nullptr; }
+  const uint8_t *data() const { return _data; }
+  size_t size() const { return _size; }
+  ~MappedFile() { close(); }
+
+private:
+  const uint8_t *_data = nullptr;
+  size_t _size = 0;
+  void *_mapping = nullptr; // windows file mapping handle
+};
+
 template <typename Iter>
 int32_t indexOf(Iter first, Iter last, const typename std::iterator_traits<Iter>::value_type& x) {
   int32_t i = 0;
@@ -149,11 +149,46 @@ static void computeSmoothingNormals(const tinyobj::attrib_t &attrib, const tinyo
   }
 }
 
-static ObjMeshes readObjFromBinary(std::ifstream &offsets, const std::string &name) {
+constexpr uint32_t OBJ_VERTEX_FLOATS = 3 + 3 + 2; // position, normal, texture coordinate
+constexpr uint32_t OBJ_VERTEX_SIZE = sizeof(float) * OBJ_VERTEX_FLOATS;
+// meshes with fewer triangles are not simplified further
+constexpr uint32_t MIN_LOD_TRIANGLES = 64;
+
+// creates the vertex and index buffer of all meshes and their bounds, the ranges are set
+static void createSharedMesh(const std::string &name, const unsigned char *vertices, uint32_t verticesSizeInBytes,
+                             const uint32_t *indices, uint32_t nrOfIndices, ObjMeshes *objMeshes) {
+  mgAssert(objMeshes->ranges.size() == objMeshes->meshes.size());
+  mg::MeshId meshId = {};
+  if (verticesSizeInBytes) {
+    mg::CreateMeshInfo createMeshInfo = {};
+    createMeshInfo.id = name;
+    createMeshInfo.vertices = (unsigned char *)vertices;
+    createMeshInfo.verticesSizeInBytes = verticesSizeInBytes;
+    createMeshInfo.indices = (unsigned char *)indices;
+    createMeshInfo.indicesSizeInBytes = nrOfIndices * sizeof(uint32_t);
+    createMeshInfo.nrOfIndices = nrOfIndices;
+    meshId = mg::mgSystem.meshContainer.createMesh(createMeshInfo);
+  }
+
+  objMeshes->bounds.resize(objMeshes->meshes.size());
+  for (uint32_t i = 0; i < objMeshes->meshes.size(); i++) {
+    const auto &range = objMeshes->ranges[i];
+    objMeshes->meshes[i].id = meshId;
+    objMeshes->bounds[i] = computeMeshBounds(vertices + size_t(range.firstVertex) * OBJ_VERTEX_SIZE,
+                                             range.vertexCount, OBJ_VERTEX_SIZE);
+  }
+}
+
+static ObjMeshes readObjFromBinary(const std::string &name) {
   ObjMeshes objMeshes = {};
   const auto binary = mg::readBinaryFromDisc(name + ".bin");
+  const auto indices = mg::readBinaryFromDisc(name + ".idx");
+  const auto ranges = mg::readBinaryFromDisc(name + ".ranges");
   const auto materials = mg::readBinaryFromDisc(name + ".mat");
   const auto mesh = mg::readBinaryFromDisc(name + ".mesh");
+  const auto meshlets = mg::readBinaryFromDisc(name + ".meshlets");
+  const auto meshletVertices = mg::readBinaryFromDisc(name + ".meshletVertices");
+  const auto meshletTriangles = mg::readBinaryFromDisc(name + ".meshletTriangles");
 
   objMeshes.materials.resize(materials.size() / sizeof(ObjMaterial));
   std::memcpy(objMeshes.materials.data(), materials.data(), mg::sizeofContainerInBytes(materials));
@@ -161,28 +196,38 @@ static ObjMeshes readObjFromBinary(std::ifstream &offsets, const std::string &na
   objMeshes.meshes.resize(mesh.size() / sizeof(ObjMesh));
   std::memcpy(objMeshes.meshes.data(), mesh.data(), mg::sizeofContainerInBytes(mesh));
 
-  uint32_t currentOffset = 0;
-  for (uint32_t i = 0; i < objMeshes.meshes.size(); i++) {
-    uint32_t vertexsize;
-    char delimiter;
-    offsets >> vertexsize >> delimiter;
-    mgAssert((currentOffset + vertexsize) <= binary.size());
-    mg::CreateMeshInfo createMeshInfo = {};
-    createMeshInfo.id = "mesh" + std::to_string(i);
-    createMeshInfo.vertices = (unsigned char *)&binary[currentOffset];
-    createMeshInfo.verticesSizeInBytes = vertexsize;
-    createMeshInfo.nrOfIndices = vertexsize / (sizeof(float) * (3 + 3 + 2));
-
-    currentOffset += vertexsize;
-
-    const auto meshId = mg::mgSystem.meshContainer.createMesh(createMeshInfo);
-    objMeshes.meshes[i].id = meshId;
+  objMeshes.ranges.resize(ranges.size() / sizeof(ObjMeshRange));
+  std::memcpy(objMeshes.ranges.data(), ranges.data(), mg::sizeofContainerInBytes(ranges));
+  mgAssert(objMeshes.ranges.size() == objMeshes.meshes.size());
+
+  objMeshes.meshlets.meshlets.resize(meshlets.size() / sizeof(Meshlet));
+  std::memcpy(objMeshes.meshlets.meshlets.data(), meshlets.data(), mg::sizeofContainerInBytes(meshlets));
+  objMeshes.meshlets.vertices.resize(meshletVertices.size() / sizeof(uint32_t));
+  std::memcpy(objMeshes.meshlets.vertices.data(), meshletVertices.data(), mg::sizeofContainerInBytes(meshletVertices));
+  objMeshes.meshlets.triangles.resize(meshletTriangles.size() / sizeof(uint32_t));
+  std::memcpy(objMeshes.meshlets.triangles.data(), meshletTriangles.data(),
+              mg::sizeofContainerInBytes(meshletTriangles));
+
+  std::vector<uint32_t> indices32(indices.size() / sizeof(uint32_t));
+  std::memcpy(indices32.data(), indices.data(), mg::sizeofContainerInBytes(indices));
+  for (const auto &range : objMeshes.ranges) {
+    mgAssert(size_t(range.firstVertex + range.vertexCount) * OBJ_VERTEX_SIZE <= binary.size());
+    mgAssert(range.nrOfLods >= 1 && range.nrOfLods <= MAX_MESH_LODS);
+    mgAssert(range.lods[range.nrOfLods - 1].firstIndex + range.lods[range.nrOfLods - 1].indexCount <=
+             indices32.size());
+  }
+  for (const auto &meshlet : objMeshes.meshlets.meshlets) {
+    mgAssert(meshlet.meshIndex < objMeshes.meshes.size());
+    mgAssert(meshlet.firstTriangle + meshlet.triangleCount <= objMeshes.meshlets.triangles.size());
+    mgAssert(meshlet.firstIndex + meshlet.triangleCount * 3 <= indices32.size());
   }
+  createSharedMesh(name, (const unsigned char *)binary.data(), mg::sizeofContainerInBytes(binary), indices32.data(),
+                   uint32_t(indices32.size()), &objMeshes);
   return objMeshes;
 }
 
 struct Outputs {
-  std::ofstream binary, sizes, materials, mesh;
+  std::ofstream binary, indices, ranges, materials, mesh, meshlets, meshletVertices, meshletTriangles;
 };
 
 inline bool exists(const std::string &name) {
@@ -202,14 +247,17 @@ ObjMeshes loadObjFromFile(const std::string &filename) {
 
 
   const auto name = getName(filename);
-  std::ifstream ifText(name + ".txt");
-  if (ifText.good()) {
-    return readObjFromBinary(ifText, name);
+  if (exists(name + ".ranges") && exists(name + ".meshlets")) {
+    return readObjFromBinary(name);
   } else {
     outputs.binary.open(name + ".bin", std::fstream::binary);
-    outputs.sizes.open(name + ".txt");
+    outputs.indices.open(name + ".idx", std::fstream::binary);
+    outputs.ranges.open(name + ".ranges", std::fstream::binary);
     outputs.materials.open(name + ".mat", std::fstream::binary);
     outputs.mesh.open(name + ".mesh", std::fstream::binary);
+    outputs.meshlets.open(name + ".meshlets", std::fstream::binary);
+    outputs.meshletVertices.open(name + ".meshletVertices", std::fstream::binary);
+    outputs.meshletTriangles.open(name + ".meshletTriangles", std::fstream::binary);
   }
 
   std::vector<tinyobj::material_t> materials;
@@ -312,10 +360,15 @@ ObjMeshes loadObjFromFile(const std::string &filename) {
     }
   }
 
+  std::vector<float> vertices;
+  std::vector<uint32_t> indices;
+  uint32_t nrOfLodTriangles[MAX_MESH_LODS] = {};
+  const auto simplifyStart = mg::timer::now();
   {
     for (uint32_t s = 0; s < uint32_t(shapes.size()); s++) {
       ObjMesh o = {};
       std::vector<float> buffer; // pos(3float), normal(3float)
+      std::vector<uint32_t> faceMaterials;
 
       // Check for smoothing group and compute smoothing normals
       std::map<int, glm::vec3> smoothVertexNormals;
@@ -336,6 +389,7 @@ ObjMeshes loadObjFromFile(const std::string &filename) {
           current_material_id =
               int32_t(materials.size()) - 1; // Default material is added to the last item in `materials`.
         }
+        faceMaterials.push_back(uint32_t(current_material_id));
         float diffuse[3];
         for (size_t i = 0; i < 3; i++) {
           diffuse[i] = materials[current_material_id].diffuse[i];
@@ -468,25 +522,63 @@ ObjMeshes loadObjFromFile(const std::string &filename) {
       }
       printf("shape[%d] material_id %d\n", int(s), int(o.materialId));
 
-      if (buffer.size() > 0) {
-        const auto nrOfIndices = buffer.size() / (3 + 3 + 2); // 3:vtx, 3:normal, 2:texcoord
-
-        mg::CreateMeshInfo createMeshInfo = {};
-        createMeshInfo.vertices = (uint8_t *)buffer.data();
-        createMeshInfo.verticesSizeInBytes = mg::sizeofContainerInBytes(buffer);
-        createMeshInfo.nrOfIndices = uint32_t(nrOfIndices);
-
-        o.id = mg::mgSystem.meshContainer.createMesh(createMeshInfo);
-        printf("shape[%d] # of triangles = %d\n", static_cast<int>(s), static_cast<int>(nrOfIndices));
-
-        outputs.binary.write((char *)buffer.data(), mg::sizeofContainerInBytes(buffer));
-        outputs.sizes << mg::sizeofContainerInBytes(buffer) << '/';
+      const auto nrOfIndices = uint32_t(buffer.size() / OBJ_VERTEX_FLOATS);
+      if (buffer.size() > 0)
+        printf("shape[%d] # of triangles = %d\n", static_cast<int>(s), static_cast<int>(nrOfIndices / 3));
+
+      // the faces are welded into indexed vertices and simplified, the boundaries between their materials stay
+      std::vector<float> welded;
+      std::vector<uint32_t> weldedIndices;
+      weldVertices(buffer.data(), nrOfIndices, OBJ_VERTEX_FLOATS, &welded, &weldedIndices);
+      MeshGeometry geometry = {};
+      geometry.vertices = welded.data();
+      geometry.nrOfVertices = uint32_t(welded.size() / OBJ_VERTEX_FLOATS);
+      geometry.nrOfFloats = OBJ_VERTEX_FLOATS;
+      geometry.indices = weldedIndices.data();
+      geometry.nrOfIndices = nrOfIndices;
+      geometry.triangleGroups = faceMaterials.data();
+      const auto lods = createMeshLods(geometry, MIN_LOD_TRIANGLES);
+
+      ObjMeshRange range = {};
+      range.firstVertex = uint32_t(vertices.size() / OBJ_VERTEX_FLOATS);
+      range.vertexCount = geometry.nrOfVertices;
+      range.nrOfLods = uint32_t(lods.size());
+      for (uint32_t l = 0; l < MAX_MESH_LODS; l++) {
+        const auto &lod = lods[std::min(l, range.nrOfLods - 1)];
+        nrOfLodTriangles[l] += uint32_t(lod.indices.size() / 3);
+        if (l >= range.nrOfLods)
+          continue;
+        range.lods[l] = {uint32_t(indices.size()), uint32_t(lod.indices.size()), lod.error};
+        for (const auto index : lod.indices)
+          indices.push_back(range.firstVertex + index);
       }
 
+      // level 0 is also drawn meshlet by meshlet, its triangles are reordered so every meshlet is a range of indices
+      auto &meshlets = tinyObjMeshes.meshlets;
+      const auto firstMeshletVertex = meshlets.vertices.size();
+      std::vector<uint32_t> meshletIndices(lods[0].indices.size());
+      buildMeshlets(welded.data(), OBJ_VERTEX_FLOATS, lods[0].indices.data(), uint32_t(lods[0].indices.size()),
+                    range.lods[0].firstIndex, s, &meshlets, meshletIndices.data());
+      for (auto i = firstMeshletVertex; i < meshlets.vertices.size(); i++)
+        meshlets.vertices[i] += range.firstVertex;
+      for (uint32_t i = 0; i < meshletIndices.size(); i++)
+        indices[range.lods[0].firstIndex + i] = range.firstVertex + meshletIndices[i];
+
+      tinyObjMeshes.ranges.push_back(range);
+      vertices.insert(vertices.end(), welded.begin(), welded.end());
       tinyObjMeshes.meshes.push_back(o);
     }
   }
 
+  const auto simplifyEnd = mg::timer::now();
+  printf("Simplification time: %llu [ms]\n",
+         (unsigned long long)(mg::timer::durationInMs(simplifyStart, simplifyEnd)));
+  // a level of a mesh without that level counts its last level
+  for (uint32_t l = 0; l < MAX_MESH_LODS; l++)
+    printf("lod %u # of triangles = %u\n", l, nrOfLodTriangles[l]);
+  printf("# of meshlets = %u, %.1f triangles each\n", uint32_t(tinyObjMeshes.meshlets.meshlets.size()),
+         double(nrOfLodTriangles[0]) / std::max(size_t(1), tinyObjMeshes.meshlets.meshlets.size()));
+
   for (uint32_t i = 0; i < materials.size(); i++) {
     ObjMaterial material = {};
     const auto &m = materials[i];
@@ -494,8 +586,18 @@ ObjMeshes loadObjFromFile(const std::string &filename) {
     tinyObjMeshes.materials.push_back(material);
   }
 
+  createSharedMesh(name, (const unsigned char *)vertices.data(), mg::sizeofContainerInBytes(vertices), indices.data(),
+                   uint32_t(indices.size()), &tinyObjMeshes);
+
+  outputs.binary.write((char *)vertices.data(), mg::sizeofContainerInBytes(vertices));
+  outputs.indices.write((char *)indices.data(), mg::sizeofContainerInBytes(indices));
+  outputs.ranges.write((char *)tinyObjMeshes.ranges.data(), mg::sizeofContainerInBytes(tinyObjMeshes.ranges));
   outputs.materials.write((char *)tinyObjMeshes.materials.data(), mg::sizeofContainerInBytes(tinyObjMeshes.materials));
   outputs.mesh.write((char *)tinyObjMeshes.meshes.data(), mg::sizeofContainerInBytes(tinyObjMeshes.meshes));
+  const auto &meshlets = tinyObjMeshes.meshlets;
+  outputs.meshlets.write((char *)meshlets.meshlets.data(), mg::sizeofContainerInBytes(meshlets.meshlets));
+  outputs.meshletVertices.write((char *)meshlets.vertices.data(), mg::sizeofContainerInBytes(meshlets.vertices));
+  outputs.meshletTriangles.write((char *)meshlets.triangles.data(), mg::sizeofContainerInBytes(meshlets.triangles));
 
   return tinyObjMeshes;
 }
@@ -73,8 +73,8 @@ StorageId StorageContainer::_createStorage(void *data, uint32_t sizeInBytes, VkB
                                  _storageData.heapAllocation.deviceMemory, _storageData.heapAllocation.offset));
 
   if (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
-    mgAssert(data != nullptr);
-    stageData(&_storageData, data, sizeInBytes);
+    if (data != nullptr)
+      stageData(&_storageData, data, sizeInBytes);
   } else {
     mgAssert(data == nullptr);
   }
@@ -110,17 +110,18 @@ StorageId StorageContainer::_createStorage(void *data, uint32_t sizeInBytes, VkB
   return storageId;
 }
 
-StorageId StorageContainer::createStorage(void *data, uint32_t sizeInBytes) {
+StorageId StorageContainer::createStorage(void *data, uint32_t sizeInBytes, VkBufferUsageFlags additionalUsage) {
   auto storageId = _createStorage(data, sizeInBytes,
                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
-                                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | additionalUsage,
                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   return storageId;
 }
 
 StorageId StorageContainer::createEmptyStorage(uint32_t sizeInBytes) {
-  auto storageId = _createStorage(nullptr, sizeInBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+  auto storageId = _createStorage(nullptr, sizeInBytes,
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
   return storageId;
 }
@@ -258,6 +259,24 @@ StorageData StorageContainer::getStorage(StorageId storageId) const {
   return _idToStorage[storageId.index].storage;
 }
 
+void *StorageContainer::mapStorage(StorageId storageId) {
+  mgAssert(storageId.index < _idToStorage.size());
+  mgAssert(storageId.generation == _generations[storageId.index]);
+  const auto &storageData = _idToStorage[storageId.index];
+  mgAssert(storageData.storage.image == VK_NULL_HANDLE);
+
+  void *data = nullptr;
+  checkResult(vkMapMemory(mg::vkContext.device, storageData.heapAllocation.deviceMemory,
+                          storageData.heapAllocation.offset, storageData.storage.size, 0, &data));
+  return data;
+}
+
+void StorageContainer::unmapStorage(StorageId storageId) {
+  mgAssert(storageId.index < _idToStorage.size());
+  mgAssert(storageId.generation == _generations[storageId.index]);
+  vkUnmapMemory(mg::vkContext.device, _idToStorage[storageId.index].heapAllocation.deviceMemory);
+}
+
 void StorageContainer::removeStorage(StorageId storageId) {
   mgAssert(storageId.index < _idToStorage.size());
   mgAssert(storageId.generation == _generations[storageId.index]);
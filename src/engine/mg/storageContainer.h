@@ -33,11 +33,17 @@ struct CreateImageStorageInfo {
 class StorageContainer : mg::nonCopyable {
 public:
   void createStorageContainer() {}
+  // host visible buffer, it can be mapped to read what the gpu wrote or copied to it
   StorageId createEmptyStorage(uint32_t sizeInBytes);
-  StorageId createStorage(void *data, uint32_t sizeInBytes);
+  // device local buffer, additionalUsage is added to the storage, transfer and vertex buffer usage. Without data the
+  // content is undefined until the gpu writes it
+  StorageId createStorage(void *data, uint32_t sizeInBytes, VkBufferUsageFlags additionalUsage = 0);
   StorageId createImageStorage(const CreateImageStorageInfo &info);
 
   StorageData getStorage(StorageId storageId) const;
+  // only storages from createEmptyStorage, and only one storage at a time since they share device memory
+  void *mapStorage(StorageId storageId);
+  void unmapStorage(StorageId storageId);
 
   void removeStorage(StorageId storageId);
 
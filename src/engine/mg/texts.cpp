@@ -1,6 +1,8 @@
 #include "texts.h"
 
+#include "memory.h"
 #include "mgAssert.h"
+#include <cstring>
 
 #include "vulkan/vkContext.h"
 #include "mg/mgSystem.h"
@@ -74,7 +76,11 @@ void pushText(Texts *texts, mg::Text text) {
   const auto fontType = (uint32_t)text.fontType;
   mgAssert(texts->textsPerFont[fontType] + 1 < Texts::maxTextPerFont);
 
-  _Text _text = {text.text, text.position, text.color};
+  const auto length = uint32_t(strlen(text.text));
+  auto textCopy = mg::frameArena().allocate<char>(length + 1);
+  memcpy(textCopy, text.text, length + 1);
+
+  _Text _text = {textCopy, length, text.position, text.color};
   texts->fontsToTexts[(uint32_t)text.fontType][texts->textsPerFont[fontType]++] = _text;
 }
 
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <array>
-#include <string>
 #include <vector>
 
 #include "fonts.h"
@@ -12,7 +11,7 @@ enum class VIEW_ALIGNMENT { TOP_LEFT, BOTTOM_LEFT, TOP_RIGHT, BOTTOM_RIGHT, NONE
 enum class TEXT_ALIGNMENT { LEFT, RIGHT, SIZE };
 
 struct Text {
-  std::string text;
+  const char *text; // copied by pushText
   glm::vec2 position;
   glm::vec4 color = {1, 1, 1, 1};
   mg::FONT_TYPE fontType = FONT_TYPE::MICRO_SS_11;
@@ -20,7 +19,8 @@ struct Text {
   VIEW_ALIGNMENT viewAlignment = VIEW_ALIGNMENT::TOP_LEFT;
 };
 struct _Text {
-  std::string text;
+  const char *text; // in the frame arena
+  uint32_t length;
   glm::vec2 position;
   glm::vec4 color;
 };
@@ -202,12 +202,7 @@ void TextureContainer::destroyTextureContainer() {
   vkFreeDescriptorSets(vkContext.device, vkContext.descriptorPool, 1, &_descriptorSet3D);
 }
 
-TextureId TextureContainer::createTexture(const CreateTextureInfo &textureInfo) {
-  const auto imageInfo = createImageInfoFromType(textureInfo.type);
-
-  mg::_TextureData texture = {};
-  texture.imageType = imageInfo.vkImageType;
-  texture.format = textureInfo.format;
+static VkImage createImage(const CreateTextureInfo &textureInfo, const ImageInfo &imageInfo) {
   VkImageCreateInfo imageCreateInfo = {};
   imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageCreateInfo.imageType = imageInfo.vkImageType;
@@ -220,16 +215,48 @@ TextureId TextureContainer::createTexture(const CreateTextureInfo &textureInfo)
   imageCreateInfo.usage = imageInfo.vkImageUsageFlags;
   imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // // buffer is exclusive to a single queue family at a time.
   imageCreateInfo.initialLayout = imageInfo.vkImageLayout;
-  checkResult(vkCreateImage(mg::vkContext.device, &imageCreateInfo, nullptr, &texture.image));
+  VkImage image;
+  checkResult(vkCreateImage(mg::vkContext.device, &imageCreateInfo, nullptr, &image));
+  return image;
+}
 
+VkMemoryRequirements TextureContainer::getMemoryRequirements(const CreateTextureInfo &textureInfo) {
+  const auto image = createImage(textureInfo, createImageInfoFromType(textureInfo.type));
   VkMemoryRequirements vkMemoryRequirements;
-  vkGetImageMemoryRequirements(mg::vkContext.device, texture.image, &vkMemoryRequirements);
-  const auto memoryIndex =
-      findMemoryTypeIndex(mg::vkContext.physicalDeviceMemoryProperties, vkMemoryRequirements.memoryTypeBits,
-                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  vkGetImageMemoryRequirements(mg::vkContext.device, image, &vkMemoryRequirements);
+  vkDestroyImage(mg::vkContext.device, image, nullptr);
+  return vkMemoryRequirements;
+}
+
+TextureId TextureContainer::createTexture(const CreateTextureInfo &textureInfo) {
+  return createTexture(textureInfo, nullptr);
+}
 
-  texture.heapAllocation = mg::mgSystem.textureDeviceMemoryAllocator.allocateDeviceOnlyMemory(
-      memoryIndex, vkMemoryRequirements.size, vkMemoryRequirements.alignment);
+TextureId TextureContainer::createTexture(const CreateTextureInfo &textureInfo, const DeviceHeapAllocation &memory) {
+  return createTexture(textureInfo, &memory);
+}
+
+TextureId TextureContainer::createTexture(const CreateTextureInfo &textureInfo, const DeviceHeapAllocation *memory) {
+  const auto imageInfo = createImageInfoFromType(textureInfo.type);
+
+  mg::_TextureData texture = {};
+  texture.imageType = imageInfo.vkImageType;
+  texture.format = textureInfo.format;
+  texture.image = createImage(textureInfo, imageInfo);
+  texture.ownsMemory = memory == nullptr;
+
+  if (memory) {
+    texture.heapAllocation = *memory;
+  } else {
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetImageMemoryRequirements(mg::vkContext.device, texture.image, &vkMemoryRequirements);
+    const auto memoryIndex =
+        findMemoryTypeIndex(mg::vkContext.physicalDeviceMemoryProperties, vkMemoryRequirements.memoryTypeBits,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    texture.heapAllocation = mg::mgSystem.textureDeviceMemoryAllocator.allocateDeviceOnlyMemory(
+        memoryIndex, vkMemoryRequirements.size, vkMemoryRequirements.alignment);
+  }
   checkResult(vkBindImageMemory(mg::vkContext.device, texture.image, texture.heapAllocation.deviceMemory,
                                 texture.heapAllocation.offset));
 
@@ -289,6 +316,38 @@ uint32_t TextureContainer::getTexture3DDescriptorIndex(TextureId textureId) {
   return _idToDescriptorIndex3D[textureId.index];
 }
 
+VkDescriptorSet TextureContainer::getStorageDescriptorSet(TextureId textureId) {
+  mgAssert(textureId.index < _idToTexture.size());
+  mgAssert(textureId.generation == _generations[textureId.index]);
+  mgAssert(_isAlive[textureId.index]);
+
+  auto &texture = _idToTexture[textureId.index];
+  if (texture.storageDescriptorSet)
+    return texture.storageDescriptorSet;
+
+  VkDescriptorSetAllocateInfo vkDescriptorSetAllocateInfo = {};
+  vkDescriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  vkDescriptorSetAllocateInfo.descriptorPool = mg::vkContext.descriptorPool;
+  vkDescriptorSetAllocateInfo.descriptorSetCount = 1;
+  vkDescriptorSetAllocateInfo.pSetLayouts = &mg::vkContext.descriptorSetLayout.storageImage;
+  checkResult(vkAllocateDescriptorSets(mg::vkContext.device, &vkDescriptorSetAllocateInfo, &texture.storageDescriptorSet));
+
+  VkDescriptorImageInfo descriptorImageInfo = {};
+  descriptorImageInfo.imageView = texture.imageView;
+  descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+  VkWriteDescriptorSet writeDescriptorSet = {};
+  writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  writeDescriptorSet.dstSet = texture.storageDescriptorSet;
+  writeDescriptorSet.dstBinding = 0;
+  writeDescriptorSet.descriptorCount = 1;
+  writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  writeDescriptorSet.pImageInfo = &descriptorImageInfo;
+  vkUpdateDescriptorSets(mg::vkContext.device, 1, &writeDescriptorSet, 0, nullptr);
+
+  return texture.storageDescriptorSet;
+}
+
 Texture TextureContainer::getTexture(TextureId textureId) {
   mgAssert(textureId.index < _idToTexture.size());
   mgAssert(textureId.generation == _generations[textureId.index]);
@@ -297,6 +356,7 @@ Texture TextureContainer::getTexture(TextureId textureId) {
   const auto &textureData = _idToTexture[textureId.index];
 
   Texture texture = {};
+  texture.image = textureData.image;
   texture.imageView = textureData.imageView;
   texture.format = textureData.format;
   return texture;
@@ -310,7 +370,10 @@ void TextureContainer::removeTexture(TextureId textureId) {
   const auto &texture = _idToTexture[textureId.index];
   vkDestroyImage(mg::vkContext.device, texture.image, nullptr);
   vkDestroyImageView(mg::vkContext.device, texture.imageView, nullptr);
-  mgSystem.textureDeviceMemoryAllocator.freeDeviceOnlyMemory(texture.heapAllocation);
+  if (texture.ownsMemory)
+    mgSystem.textureDeviceMemoryAllocator.freeDeviceOnlyMemory(texture.heapAllocation);
+  if (texture.storageDescriptorSet)
+    vkFreeDescriptorSets(mg::vkContext.device, mg::vkContext.descriptorPool, 1, &texture.storageDescriptorSet);
   _generations[textureId.index]++;
   _isAlive[textureId.index] = false;
   _freeIndices.push_back(textureId.index);
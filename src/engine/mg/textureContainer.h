@@ -21,6 +21,8 @@ struct _TextureData {
   mg::DeviceHeapAllocation heapAllocation;
   VkFormat format;
   VkImageType imageType;
+  bool ownsMemory; // false when the memory is shared with other textures and freed by its owner
+  VkDescriptorSet storageDescriptorSet; // created by the first getStorageDescriptorSet
 };
 
 struct CreateTextureInfo {
@@ -33,6 +35,7 @@ struct CreateTextureInfo {
 };
 
 struct Texture {
+  VkImage image;
   VkImageView imageView;
   VkFormat format;
   std::string id;
@@ -42,7 +45,12 @@ class TextureContainer : mg::nonCopyable {
 public:
   void createTextureContainer();
   TextureId createTexture(const CreateTextureInfo &textureInfo);
+  // binds the texture to memory allocated by the caller, textures whose use never overlaps can share it
+  TextureId createTexture(const CreateTextureInfo &textureInfo, const DeviceHeapAllocation &memory);
+  VkMemoryRequirements getMemoryRequirements(const CreateTextureInfo &textureInfo);
   uint32_t getTexture2DDescriptorIndex(TextureId textureId);
+  // the texture as the storage image of a descriptorSetLayout.storageImage set, in VK_IMAGE_LAYOUT_GENERAL
+  VkDescriptorSet getStorageDescriptorSet(TextureId textureId);
   uint32_t getTexture3DDescriptorIndex(TextureId textureId);
 
 
@@ -69,6 +77,7 @@ private:
   std::vector<uint32_t> _idToDescriptorIndex2D;
   std::vector<uint32_t> _idToDescriptorIndex3D;
 
+  TextureId createTexture(const CreateTextureInfo &textureInfo, const DeviceHeapAllocation *memory);
 
 };
 
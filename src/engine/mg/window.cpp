@@ -1,10 +1,13 @@
 #include "window.h"
 
+#include "mg/framePacing.h"
 #include "mg/logger.h"
+#include "mg/memory.h"
 #include "mg/mgAssert.h"
 #include "mg/mgSystem.h"
 #include "mg/mgUtils.h"
 #include "vulkan/vkContext.h"
+#include "vulkan/vkUtils.h"
 #include "vulkan/vkWindow.h"
 #include <GLFW/glfw3.h>
 #include <cassert>
@@ -24,13 +27,8 @@ glm::vec2 cursorPosition(uint32_t width, uint32_t height) {
   return {xpos / float(width), 1.0f - ypos / float(height)};
 }
 
-static uint64_t getCurrentTimeUs() {
-  auto t0 = std::chrono::high_resolution_clock::now();
-  auto nanosec = t0.time_since_epoch();
-  return std::chrono::duration_cast<std::chrono::microseconds>(nanosec).count();
-}
-
-void initWindow(uint32_t width, uint32_t height) {
+void initWindow(uint32_t width, uint32_t height, const FramePacingSettings &framePacingSettings) {
+  initFramePacing(framePacingSettings);
   mgAssertDesc(glfwInit(), "could not init glfw");
   glfwSetErrorCallback(glfwErrorCallback);
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -47,15 +45,23 @@ void initWindow(uint32_t width, uint32_t height) {
   prevXY = cursorPosition(width, height);
 
   mg::createMgSystem(&mgSystem);
+  mg::createFrameArenas(1 << 20);
 }
 
 void destroyWindow() {
+  mg::destroyFrameArenas();
   mg::destroyMgSystem(&mgSystem);
   mg::destroyVulkan();
 }
 
 bool startFrame() {
+  beginMemoryFrame();
+  beginFramePacing();
+  if (vkContext.framePacing.waitForGpuBeforeInput)
+    waitForFrameSlot();
   glfwPollEvents();
+  framePacingInputSampled();
+  mgSystem.pipelineContainer.reloadChangedShaders();
   return !glfwWindowShouldClose(window);
 }
 float getTime() { return float(glfwGetTime()); }
@@ -63,22 +69,19 @@ void endFrame() { glfwPollEvents(); }
 
 FrameData getFrameData() {
   FrameData frameData = {};
-  static uint64_t currentTime = getCurrentTimeUs();
-  static uint64_t prevTime = getCurrentTimeUs();
-  static uint64_t totalDelta = 0;
+  static double fpsStart = getFrameClock();
   static uint32_t frames = 0;
   frames++;
 
-  currentTime = getCurrentTimeUs();
-  const auto newDt = (currentTime - prevTime);
-  totalDelta += newDt;
-  frameData.dt = frameData.dt * 0.99f + 0.01f * (newDt / 100000.0f);
-  prevTime = getCurrentTimeUs();
+  frameData.time = getFrameClock();
+  frameData.frameTime = getSmoothedFrameTime();
+  // the scenes are tuned for a step of a tenth of the frame time
+  frameData.dt = frameData.frameTime * 0.1f;
 
   frameData.fps = fps;
-  if (totalDelta >= 1000000) {
+  if (frameData.time - fpsStart >= 1.0) {
     fps = frames;
-    totalDelta -= 1000000;
+    fpsStart += 1.0;
     frames = 0;
   }
 
@@ -100,6 +103,9 @@ FrameData getFrameData() {
   frameData.keys.r = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
   frameData.keys.n = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
   frameData.keys.m = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+  frameData.keys.c = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+  frameData.keys.l = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+  frameData.keys.v = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
 
   frameData.keys.left = glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS;
   frameData.keys.right = glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS;
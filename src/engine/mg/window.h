@@ -1,6 +1,7 @@
 #pragma once
 
 #include "tools.h"
+#include "vulkan/vkContext.h"
 #include <cstdint>
 #include <glm/glm.hpp>
 
@@ -14,15 +15,17 @@ struct FrameData {
     bool left, middle, right;
   } mouse;
   struct {
-    bool r,n,m;
+    bool r,n,m,c,l,v;
     bool left, right, space;
   } keys;
   mg::Tool tool;
-  float dt;
+  double time;     // seconds on a monotonic clock
+  float frameTime; // seconds, smoothed over the last frames
+  float dt;        // simulation step, a tenth of frameTime
   uint32_t fps;
 };
 
-void initWindow(uint32_t width, uint32_t height);
+void initWindow(uint32_t width, uint32_t height, const FramePacingSettings &framePacingSettings = {});
 void destroyWindow();
 
 bool startFrame();
@@ -0,0 +1,83 @@
+#include "workerPool.h"
+
+#include "mg/mgAssert.h"
+#include <algorithm>
+
+namespace mg {
+
+void WorkerPool::create(uint32_t nrOfThreads) {
+  mgAssert(_threads.empty());
+  if (nrOfThreads == 0)
+    nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  _quit = false;
+  for (uint32_t i = 1; i < nrOfThreads; i++)
+    _threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+void WorkerPool::destroy() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _startCondition.notify_all();
+  for (auto &thread : _threads)
+    thread.join();
+  _threads.clear();
+}
+
+WorkerPool::~WorkerPool() { destroy(); }
+
+void WorkerPool::runChunks(uint32_t threadIndex) {
+  for (uint32_t chunk = _next++; uint64_t(chunk) * _grainSize < _count; chunk = _next++) {
+    const uint32_t begin = chunk * _grainSize;
+    _runChunk(_context, begin, begin + std::min(_grainSize, _count - begin), threadIndex);
+  }
+}
+
+void WorkerPool::workerLoop(uint32_t threadIndex) {
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _startCondition.wait(lock, [&] { return _quit || _generation != generation; });
+      if (_quit)
+        return;
+      generation = _generation;
+    }
+    runChunks(threadIndex);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (--_nrOfBusyThreads == 0)
+        _doneCondition.notify_one();
+    }
+  }
+}
+
+void WorkerPool::run(uint32_t count, uint32_t grainSize, const void *context, RunChunk runChunk) {
+  mgAssert(grainSize > 0);
+  if (count == 0)
+    return;
+  if (_threads.empty() || count <= grainSize) {
+    for (uint32_t begin = 0; begin < count; begin += std::min(grainSize, count - begin))
+      runChunk(context, begin, begin + std::min(grainSize, count - begin), 0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _context = context;
+    _runChunk = runChunk;
+    _count = count;
+    _grainSize = grainSize;
+    _next = 0;
+    _nrOfBusyThreads = uint32_t(_threads.size());
+    _generation++;
+  }
+  _startCondition.notify_all();
+  runChunks(0);
+  std::unique_lock<std::mutex> lock(_mutex);
+  _doneCondition.wait(lock, [&] { return _nrOfBusyThreads == 0; });
+  _context = nullptr;
+  _runChunk = nullptr;
+}
+
+} // namespace mg
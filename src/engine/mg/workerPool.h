@@ -0,0 +1,53 @@
+#pragma once
+
+#include "mg/mgUtils.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mg {
+
+// Persistent threads for data parallel loops, the calling thread takes chunks as well. The chunks are handed out in
+// order but finish in any order, a job that has to be deterministic writes only to its own chunk or to the slot of
+// its thread index and the caller merges them afterwards.
+class WorkerPool : mg::nonCopyable {
+public:
+  // 0 uses all hardware threads, the calling thread counts as one of them
+  void create(uint32_t nrOfThreads);
+  void destroy();
+  uint32_t nrOfThreads() const { return uint32_t(_threads.size()) + 1; }
+
+  // job(begin, end, threadIndex) over [0, count) in chunks of grainSize, returns when all chunks are done. threadIndex
+  // is below nrOfThreads(), the calling thread is 0. Nothing is allocated, the job is only referenced while it runs.
+  template <typename Job> void parallelFor(uint32_t count, uint32_t grainSize, const Job &job) {
+    run(count, grainSize, &job, [](const void *context, uint32_t begin, uint32_t end, uint32_t threadIndex) {
+      (*(const Job *)context)(begin, end, threadIndex);
+    });
+  }
+
+  ~WorkerPool();
+
+private:
+  using RunChunk = void (*)(const void *context, uint32_t begin, uint32_t end, uint32_t threadIndex);
+
+  void run(uint32_t count, uint32_t grainSize, const void *context, RunChunk runChunk);
+  void runChunks(uint32_t threadIndex);
+  void workerLoop(uint32_t threadIndex);
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _startCondition, _doneCondition;
+  const void *_context = nullptr;
+  RunChunk _runChunk = nullptr;
+  uint32_t _count = 0;
+  uint32_t _grainSize = 0;
+  std::atomic<uint32_t> _next = {0};
+  uint32_t _nrOfBusyThreads = 0;
+  uint64_t _generation = 0;
+  bool _quit = false;
+};
+
+} // namespace mg
@@ -0,0 +1,235 @@
+#include "clusteredLighting.h"
+
+#include "mg/logger.h"
+#include "mg/mgSystem.h"
+#include "shaders/clusterBounds.h"
+#include "shaders/clusterLights.h"
+#include "vulkan/pipelineContainer.h"
+#include "vulkan/vkUtils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mg {
+
+static_assert(sizeof(PointLight) == sizeof(shaders::clusterLights::Lights::PointLight),
+              "PointLight does not match clusteredLighting.hglsl");
+static_assert(sizeof(ClusterGrid) == sizeof(shaders::clusterLights::Ubo::ClusterGrid),
+              "ClusterGrid does not match clusteredLighting.hglsl");
+static_assert(sizeof(ClusterBounds) == sizeof(shaders::clusterBounds::Bounds::ClusterBounds),
+              "ClusterBounds does not match clusteredLighting.hglsl");
+
+static void computeBarrier(VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags dstStages) {
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = srcAccess;
+  memoryBarrier.dstAccessMask = dstAccess;
+  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0, 1,
+                       &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+static mg::Pipeline createClusterPipeline(const char *shader) {
+  mg::PipelineStateDesc pipelineStateDesc = {};
+  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+  return mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+}
+
+ClusteredLighting::~ClusteredLighting() { mgAssert(!_isCreated); }
+
+void ClusteredLighting::create(const ClusterGridInfo &info) {
+  mgAssert(!_isCreated);
+  _grid = createClusterGrid(info);
+  createBuffers(&_buffers, false);
+  _hasBounds = false;
+  _isCreated = true;
+}
+
+void ClusteredLighting::destroy() {
+  if (!_isCreated)
+    return;
+  removeBuffers(&_buffers);
+  if (_hasValidationBuffers)
+    removeBuffers(&_validationBuffers);
+  _hasValidationBuffers = false;
+  _validation = VALIDATION::NONE;
+  _isCreated = false;
+}
+
+void ClusteredLighting::createBuffers(Buffers *buffers, bool hostVisible) {
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  const auto create = [&](uint32_t sizeInBytes) {
+    return hostVisible ? storageContainer.createEmptyStorage(sizeInBytes)
+                       : storageContainer.createStorage(nullptr, sizeInBytes);
+  };
+  buffers->bounds = create(nrOfClusters(_grid) * sizeof(ClusterBounds));
+  buffers->counts = create(nrOfClusters(_grid) * sizeof(uint32_t));
+  buffers->indices = create(nrOfClusters(_grid) * _grid.size.w * sizeof(uint32_t));
+}
+
+void ClusteredLighting::removeBuffers(Buffers *buffers) {
+  mg::mgSystem.storageContainer.removeStorage(buffers->bounds);
+  mg::mgSystem.storageContainer.removeStorage(buffers->counts);
+  mg::mgSystem.storageContainer.removeStorage(buffers->indices);
+}
+
+void ClusteredLighting::setLights(const PointLight *lights, uint32_t nrOfLights) {
+  VkBuffer storageBuffer;
+  VkDescriptorSet storageSet;
+  auto *storage = (PointLight *)mg::mgSystem.linearHeapAllocator.allocateStorage(
+      sizeof(PointLight) * std::max(nrOfLights, 1u), &storageBuffer, &_lightsOffset, &storageSet);
+  std::memcpy(storage, lights, sizeof(PointLight) * nrOfLights);
+  _nrOfLights = nrOfLights;
+
+  if (_validation == VALIDATION::REQUESTED)
+    _validationLights.assign(lights, lights + nrOfLights);
+}
+
+void ClusteredLighting::computeBounds(const Buffers &buffers, const glm::mat4 &projection) {
+  using namespace mg::shaders::clusterBounds;
+
+  const auto pipeline = createClusterPipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->projection = projection;
+  std::memcpy(&ubo->grid, &_grid, sizeof(_grid));
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.bounds = mg::mgSystem.storageContainer.getStorage(buffers.bounds).descriptorSet;
+
+  // the last assignment may still read the bounds
+  computeBarrier(VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  uint32_t dynamicOffsets[] = {uniformOffset, _lightsOffset};
+  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                          dynamicOffsets);
+  vkCmdDispatch(mg::vkContext.commandBuffer, (nrOfClusters(_grid) + 63) / 64, 1, 1);
+  computeBarrier(VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
+void ClusteredLighting::assignLights(const Buffers &buffers) {
+  using namespace mg::shaders::clusterLights;
+
+  const auto pipeline = createClusterPipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  std::memcpy(&ubo->grid, &_grid, sizeof(_grid));
+  ubo->nrOfLights = _nrOfLights;
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.bounds = mg::mgSystem.storageContainer.getStorage(buffers.bounds).descriptorSet;
+  descriptorSets.counts = mg::mgSystem.storageContainer.getStorage(buffers.counts).descriptorSet;
+  descriptorSets.indices = mg::mgSystem.storageContainer.getStorage(buffers.indices).descriptorSet;
+
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  uint32_t dynamicOffsets[] = {uniformOffset, _lightsOffset};
+  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                          dynamicOffsets);
+  vkCmdDispatch(mg::vkContext.commandBuffer, (nrOfClusters(_grid) + 63) / 64, 1, 1);
+}
+
+void ClusteredLighting::cullLights(const glm::mat4 &projection) {
+  mgAssert(_isCreated);
+  if (!_hasBounds || projection != _boundsProjection) {
+    computeBounds(_buffers, projection);
+    _boundsProjection = projection;
+    _hasBounds = true;
+  }
+  assignLights(_buffers);
+
+  if (_validation == VALIDATION::REQUESTED) {
+    if (!_hasValidationBuffers)
+      createBuffers(&_validationBuffers, true);
+    _hasValidationBuffers = true;
+    computeBounds(_validationBuffers, projection);
+    assignLights(_validationBuffers);
+    computeBarrier(VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+    _validationProjection = projection;
+    _validation = VALIDATION::PENDING;
+  }
+}
+
+ClusterShading ClusteredLighting::getShading() const {
+  ClusterShading shading = {};
+  shading.grid = _grid;
+  shading.nrOfLights = _nrOfLights;
+  shading.lightsOffset = _lightsOffset;
+  shading.counts = mg::mgSystem.storageContainer.getStorage(_buffers.counts).descriptorSet;
+  shading.indices = mg::mgSystem.storageContainer.getStorage(_buffers.indices).descriptorSet;
+  return shading;
+}
+
+VkBuffer ClusteredLighting::countsBuffer() const {
+  return mg::mgSystem.storageContainer.getStorage(_buffers.counts).buffer;
+}
+
+VkBuffer ClusteredLighting::indicesBuffer() const {
+  return mg::mgSystem.storageContainer.getStorage(_buffers.indices).buffer;
+}
+
+void ClusteredLighting::requestValidation() {
+  if (_validation == VALIDATION::NONE)
+    _validation = VALIDATION::REQUESTED;
+}
+
+bool ClusteredLighting::isValidationPending() const { return _validation == VALIDATION::PENDING; }
+
+template <typename T> static std::vector<T> readStorage(StorageId storageId, size_t count) {
+  std::vector<T> values(count);
+  const auto *data = mg::mgSystem.storageContainer.mapStorage(storageId);
+  std::memcpy(values.data(), data, sizeof(T) * count);
+  mg::mgSystem.storageContainer.unmapStorage(storageId);
+  return values;
+}
+
+uint32_t ClusteredLighting::validate() {
+  mgAssert(_validation == VALIDATION::PENDING);
+  mg::waitForDeviceIdle();
+  _validation = VALIDATION::NONE;
+
+  const auto clusters = nrOfClusters(_grid);
+  const auto maxLights = _grid.size.w;
+  const auto bounds = readStorage<ClusterBounds>(_validationBuffers.bounds, clusters);
+  const auto counts = readStorage<uint32_t>(_validationBuffers.counts, clusters);
+  const auto indices = readStorage<uint32_t>(_validationBuffers.indices, size_t(clusters) * maxLights);
+
+  // the bounds are compared with a tolerance, the gpu may round pow and the divisions differently. The light lists
+  // are compared exactly against the reference assignment on the gpu bounds.
+  float boundsError = 0.0f;
+  const auto referenceBounds = computeClusterBounds(_grid, _validationProjection);
+  for (uint32_t i = 0; i < clusters; i++) {
+    const auto scale = std::max(1.0f, glm::length(glm::vec3(referenceBounds[i].maximum)));
+    boundsError = std::max(boundsError, glm::length(glm::vec3(bounds[i].minimum - referenceBounds[i].minimum)) / scale);
+    boundsError = std::max(boundsError, glm::length(glm::vec3(bounds[i].maximum - referenceBounds[i].maximum)) / scale);
+  }
+
+  std::vector<uint32_t> referenceCounts, referenceIndices;
+  assignLightsToClusters(_grid, bounds, _validationLights.data(), uint32_t(_validationLights.size()),
+                         &referenceCounts, &referenceIndices);
+  uint32_t mismatches = 0;
+  uint64_t nrOfAssignments = 0;
+  for (uint32_t i = 0; i < clusters; i++) {
+    nrOfAssignments += referenceCounts[i];
+    const auto first = indices.begin() + size_t(i) * maxLights;
+    const auto referenceFirst = referenceIndices.begin() + size_t(i) * maxLights;
+    if (counts[i] != referenceCounts[i] || !std::equal(first, first + counts[i], referenceFirst))
+      mismatches++;
+  }
+  LOG("clustered lighting validation: " << _validationLights.size() << " lights, " << nrOfAssignments
+                                        << " assignments, " << mismatches << " of " << clusters
+                                        << " clusters differ from the cpu reference, relative bounds error "
+                                        << boundsError);
+  return mismatches;
+}
+
+} // namespace mg
@@ -0,0 +1,73 @@
+#pragma once
+#include "mg/lightClusters.h"
+#include "mg/mgUtils.h"
+#include "mg/storageContainer.h"
+#include "vulkan/vkContext.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+// What a shading pass binds to loop over the lights of its cluster: the lights at lightsOffset in the dynamic storage
+// buffer of set 0 and counts and indices as set 2 and 3, the sets of pipelineLayoutTexturesStorage
+struct ClusterShading {
+  ClusterGrid grid;
+  uint32_t nrOfLights;
+  uint32_t lightsOffset;
+  VkDescriptorSet counts, indices;
+};
+
+// Light culling for forward and deferred shading. The view frustum is cut into clusters, every frame a compute pass
+// lists the lights that reach each cluster and a shading pass only loops over the lights of the cluster of its pixel.
+// The projection is the one the shading pass reconstructs view space positions with, the cluster bounds are rebuilt
+// when it changes.
+class ClusteredLighting : mg::nonCopyable {
+public:
+  void create(const ClusterGridInfo &info);
+  void destroy();
+
+  // copies the view space lights of this frame to the dynamic storage buffer
+  void setLights(const PointLight *lights, uint32_t nrOfLights);
+  // records the compute passes outside of a render pass, the counts and indices buffers are written
+  void cullLights(const glm::mat4 &projection);
+  ClusterShading getShading() const;
+  VkBuffer countsBuffer() const;
+  VkBuffer indicesBuffer() const;
+
+  // Requested before setLights, the next cullLights also rebuilds the bounds and assigns the lights into host visible
+  // buffers. validate waits for the device after that frame was submitted and compares them with the cpu reference, it
+  // returns the number of clusters whose light lists differ.
+  void requestValidation();
+  bool isValidationPending() const;
+  uint32_t validate();
+
+  ~ClusteredLighting();
+
+private:
+  struct Buffers {
+    StorageId bounds, counts, indices;
+  };
+  void createBuffers(Buffers *buffers, bool hostVisible);
+  void removeBuffers(Buffers *buffers);
+  void computeBounds(const Buffers &buffers, const glm::mat4 &projection);
+  void assignLights(const Buffers &buffers);
+
+  ClusterGrid _grid = {};
+  Buffers _buffers = {};
+  Buffers _validationBuffers = {};
+  bool _hasValidationBuffers = false;
+  bool _isCreated = false;
+
+  glm::mat4 _boundsProjection;
+  bool _hasBounds = false;
+
+  uint32_t _nrOfLights = 0;
+  uint32_t _lightsOffset = 0;
+
+  enum class VALIDATION { NONE, REQUESTED, PENDING };
+  VALIDATION _validation = VALIDATION::NONE;
+  std::vector<PointLight> _validationLights;
+  glm::mat4 _validationProjection;
+};
+
+} // namespace mg
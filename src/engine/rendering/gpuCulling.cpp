@@ -0,0 +1,454 @@
+#include "gpuCulling.h"
+
+#include "mg/logger.h"
+#include "mg/mgSystem.h"
+#include "shaders/cullDraws.h"
+#include "shaders/cullMeshlets.h"
+#include "shaders/hiZ.h"
+#include "vulkan/pipelineContainer.h"
+#include "vulkan/vkUtils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mg {
+
+static_assert(sizeof(CullingDraw) == sizeof(shaders::cullDraws::Draws::Draw),
+              "CullingDraw does not match cullDraws.comp");
+static_assert(sizeof(Meshlet) == sizeof(shaders::cullMeshlets::Meshlets::Meshlet),
+              "Meshlet does not match cullMeshlets.comp");
+
+// the draw count and the number of triangles in front of the commands, the meshlet commands also count the indices
+constexpr VkDeviceSize COMMANDS_OFFSET = 16;
+constexpr VkDeviceSize STATISTICS_SIZE = 2 * sizeof(uint32_t);
+constexpr VkDeviceSize MESHLET_COUNTERS_SIZE = 3 * sizeof(uint32_t);
+
+static void cullingBarrier(VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages,
+                           VkAccessFlags dstAccess) {
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = srcAccess;
+  memoryBarrier.dstAccessMask = dstAccess;
+  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, srcStages, dstStages, 0, 1, &memoryBarrier, 0, nullptr, 0,
+                       nullptr);
+}
+
+bool GpuCulling::isSupported() { return mg::vkContext.enabledFeatures.multiDrawIndirect; }
+
+GpuCulling::~GpuCulling() { mgAssert(!_isCreated); }
+
+void GpuCulling::create(const CullingDraw *draws, uint32_t nrOfDraws) {
+  mgAssert(!_isCreated);
+  mgAssert(nrOfDraws > 0);
+  _nrOfDraws = nrOfDraws;
+  _bounds.resize(nrOfDraws);
+  for (uint32_t i = 0; i < nrOfDraws; i++)
+    _bounds[i] = draws[i].bounds;
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  _draws = storageContainer.createStorage((void *)draws, uint32_t(sizeof(CullingDraw) * nrOfDraws));
+  _commands = storageContainer.createStorage(
+      nullptr, uint32_t(COMMANDS_OFFSET + sizeof(VkDrawIndexedIndirectCommand) * nrOfDraws),
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+  _visibility = storageContainer.createStorage(nullptr, sizeof(uint32_t) * nrOfDraws);
+  _statistics = storageContainer.createEmptyStorage(uint32_t(STATISTICS_SIZE * MAX_FRAMES_IN_FLIGHT));
+  std::fill(std::begin(_hasStatistics), std::end(_hasStatistics), false);
+  _drawnTriangles = 0;
+  createHiZ();
+  _isCreated = true;
+}
+
+void GpuCulling::destroy() {
+  if (!_isCreated)
+    return;
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  storageContainer.removeStorage(_draws);
+  storageContainer.removeStorage(_commands);
+  storageContainer.removeStorage(_visibility);
+  storageContainer.removeStorage(_statistics);
+  storageContainer.removeStorage(_hiZ);
+  if (_nrOfMeshlets) {
+    storageContainer.removeStorage(_meshletBuffer);
+    storageContainer.removeStorage(_meshletData);
+    storageContainer.removeStorage(_meshletIndices);
+    storageContainer.removeStorage(_meshletCommands);
+    storageContainer.removeStorage(_meshletVisibility);
+  }
+  _nrOfMeshlets = 0;
+  _meshlets.clear();
+  if (_hasValidationVisibility)
+    storageContainer.removeStorage(_validationVisibility);
+  _hasValidationVisibility = false;
+  _validation = VALIDATION::NONE;
+  _isCreated = false;
+}
+
+void GpuCulling::createMeshlets(const Meshlets &meshlets) {
+  mgAssert(_isCreated);
+  mgAssert(!_nrOfMeshlets);
+  mgAssert(!meshlets.meshlets.empty());
+  _nrOfMeshlets = uint32_t(meshlets.meshlets.size());
+  _meshlets = meshlets.meshlets;
+
+  std::vector<uint32_t> data;
+  data.reserve(meshlets.vertices.size() + meshlets.triangles.size());
+  data.insert(data.end(), meshlets.vertices.begin(), meshlets.vertices.end());
+  data.insert(data.end(), meshlets.triangles.begin(), meshlets.triangles.end());
+  _meshletTrianglesOffset = uint32_t(meshlets.vertices.size());
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  _meshletBuffer = storageContainer.createStorage((void *)_meshlets.data(), mg::sizeofContainerInBytes(_meshlets));
+  _meshletData = storageContainer.createStorage((void *)data.data(), mg::sizeofContainerInBytes(data));
+  _meshletIndices = storageContainer.createStorage(
+      nullptr, uint32_t(meshlets.triangles.size() * 3 * sizeof(uint32_t)), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+  _meshletCommands = storageContainer.createStorage(
+      nullptr, uint32_t(COMMANDS_OFFSET + sizeof(VkDrawIndexedIndirectCommand) * _nrOfMeshlets),
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+  _meshletVisibility = storageContainer.createStorage(nullptr, sizeof(uint32_t) * _nrOfMeshlets);
+  // the validation buffer is created again with room for the meshlets
+  if (_hasValidationVisibility)
+    storageContainer.removeStorage(_validationVisibility);
+  _hasValidationVisibility = false;
+}
+
+void GpuCulling::createHiZ() {
+  _hiZLevels.clear();
+  glm::ivec2 size = {std::max((mg::vkContext.screen.width + 1) / 2, 1u),
+                     std::max((mg::vkContext.screen.height + 1) / 2, 1u)};
+  uint32_t offset = 0;
+  while (true) {
+    _hiZLevels.push_back({size, offset});
+    offset += size.x * size.y;
+    if (size.x == 1 && size.y == 1)
+      break;
+    size = (size + 1) / 2;
+  }
+  _hiZ = mg::mgSystem.storageContainer.createStorage(nullptr, offset * sizeof(float));
+  _hasHiZ = false;
+}
+
+bool GpuCulling::resize() {
+  mgAssert(_isCreated);
+  const glm::ivec2 size = {std::max((mg::vkContext.screen.width + 1) / 2, 1u),
+                           std::max((mg::vkContext.screen.height + 1) / 2, 1u)};
+  if (size == _hiZLevels.front().size)
+    return false;
+  mg::waitForDeviceIdle();
+  mg::mgSystem.storageContainer.removeStorage(_hiZ);
+  createHiZ();
+  return true;
+}
+
+void GpuCulling::cull(const glm::mat4 &viewProjection, bool occlusion, const LodSelection &lodSelection) {
+  using namespace mg::shaders::cullDraws;
+  mgAssert(_isCreated);
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  const uint32_t frameSlot = mg::vkContext.commandBuffers.currentIndex;
+  readStatistics(frameSlot);
+
+  mg::PipelineStateDesc pipelineStateDesc = {};
+  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+  const auto pipeline =
+      mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  const auto frustum = createFrustum(viewProjection);
+  std::memcpy(ubo->planes, frustum.planes, sizeof(frustum.planes));
+  ubo->hiZViewProjection = _hiZViewProjection;
+  ubo->hiZSize = glm::uvec4(_hiZLevels.front().size, _hiZLevels.size(), occlusion && _hasHiZ);
+  ubo->lod = glm::vec4(lodSelection.cameraPosition, lodSelection.scale);
+  ubo->nrOfDraws = _nrOfDraws;
+  ubo->compact = mg::vkContext.enabledFeatures.drawIndirectCount;
+  ubo->lodThreshold = lodSelection.threshold;
+
+  const bool validating = prepareValidation();
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.draws = storageContainer.getStorage(_draws).descriptorSet;
+  descriptorSets.hiZ = storageContainer.getStorage(_hiZ).descriptorSet;
+  descriptorSets.commands = storageContainer.getStorage(_commands).descriptorSet;
+  descriptorSets.visibility =
+      storageContainer.getStorage(validating ? _validationVisibility : _visibility).descriptorSet;
+
+  // the count is cleared after the draws and the statistics copy of the last frame read it
+  const auto commandsBuffer = storageContainer.getStorage(_commands).buffer;
+  cullingBarrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 0, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+  vkCmdFillBuffer(mg::vkContext.commandBuffer, commandsBuffer, 0, STATISTICS_SIZE, 0);
+  cullingBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  uint32_t dynamicOffsets[] = {uniformOffset, 0};
+  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                          dynamicOffsets);
+  vkCmdDispatch(mg::vkContext.commandBuffer, (_nrOfDraws + 63) / 64, 1, 1);
+  copyStatistics(commandsBuffer, frameSlot);
+
+  if (validating) {
+    cullingBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                   VK_ACCESS_HOST_READ_BIT);
+    _validationViewProjection = viewProjection;
+    _isValidatingMeshlets = false;
+    _validation = VALIDATION::PENDING;
+  }
+}
+
+// a requested validation gets a visibility buffer the cull pass writes
+bool GpuCulling::prepareValidation() {
+  if (_validation != VALIDATION::REQUESTED)
+    return false;
+  if (!_hasValidationVisibility) {
+    _validationVisibility =
+        mg::mgSystem.storageContainer.createEmptyStorage(sizeof(uint32_t) * std::max(_nrOfDraws, _nrOfMeshlets));
+  }
+  _hasValidationVisibility = true;
+  return true;
+}
+
+// the commands buffer of this frame slot finished before it is recorded again
+void GpuCulling::readStatistics(uint32_t frameSlot) {
+  if (!_hasStatistics[frameSlot])
+    return;
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  uint32_t statistics[2];
+  std::memcpy(statistics, (char *)storageContainer.mapStorage(_statistics) + frameSlot * STATISTICS_SIZE,
+              sizeof(statistics));
+  storageContainer.unmapStorage(_statistics);
+  _drawnTriangles = statistics[1];
+}
+
+void GpuCulling::copyStatistics(VkBuffer commands, uint32_t frameSlot) {
+  cullingBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 VK_ACCESS_TRANSFER_READ_BIT);
+  VkBufferCopy statisticsCopy = {};
+  statisticsCopy.size = STATISTICS_SIZE;
+  statisticsCopy.dstOffset = frameSlot * STATISTICS_SIZE;
+  vkCmdCopyBuffer(mg::vkContext.commandBuffer, commands, mg::mgSystem.storageContainer.getStorage(_statistics).buffer,
+                  1, &statisticsCopy);
+  cullingBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                 VK_ACCESS_HOST_READ_BIT);
+  _hasStatistics[frameSlot] = true;
+}
+
+void GpuCulling::cullMeshlets(const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition, bool occlusion) {
+  using namespace mg::shaders::cullMeshlets;
+  mgAssert(_isCreated);
+  mgAssert(_nrOfMeshlets);
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  const uint32_t frameSlot = mg::vkContext.commandBuffers.currentIndex;
+  readStatistics(frameSlot);
+
+  mg::PipelineStateDesc pipelineStateDesc = {};
+  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage6;
+  const auto pipeline =
+      mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  const auto frustum = createFrustum(viewProjection);
+  std::memcpy(ubo->planes, frustum.planes, sizeof(frustum.planes));
+  ubo->hiZViewProjection = _hiZViewProjection;
+  ubo->hiZSize = glm::uvec4(_hiZLevels.front().size, _hiZLevels.size(), occlusion && _hasHiZ);
+  ubo->cameraPosition = glm::vec4(cameraPosition, 1.0f);
+  ubo->nrOfMeshlets = _nrOfMeshlets;
+  ubo->compact = mg::vkContext.enabledFeatures.drawIndirectCount;
+  ubo->trianglesOffset = _meshletTrianglesOffset;
+
+  const bool validating = prepareValidation();
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.meshlets = storageContainer.getStorage(_meshletBuffer).descriptorSet;
+  descriptorSets.hiZ = storageContainer.getStorage(_hiZ).descriptorSet;
+  descriptorSets.meshletData = storageContainer.getStorage(_meshletData).descriptorSet;
+  descriptorSets.indices = storageContainer.getStorage(_meshletIndices).descriptorSet;
+  descriptorSets.commands = storageContainer.getStorage(_meshletCommands).descriptorSet;
+  descriptorSets.visibility =
+      storageContainer.getStorage(validating ? _validationVisibility : _meshletVisibility).descriptorSet;
+
+  // the counters are cleared and the index stream is written after the draws of the last frame read them
+  const auto commandsBuffer = storageContainer.getStorage(_meshletCommands).buffer;
+  cullingBarrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 0, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+  vkCmdFillBuffer(mg::vkContext.commandBuffer, commandsBuffer, 0, MESHLET_COUNTERS_SIZE, 0);
+  cullingBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  uint32_t dynamicOffsets[] = {uniformOffset, 0};
+  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                          dynamicOffsets);
+  vkCmdDispatch(mg::vkContext.commandBuffer, (_nrOfMeshlets + 63) / 64, 1, 1);
+  copyStatistics(commandsBuffer, frameSlot);
+
+  if (validating) {
+    cullingBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                   VK_ACCESS_HOST_READ_BIT);
+    _validationViewProjection = viewProjection;
+    _validationCameraPosition = cameraPosition;
+    _isValidatingMeshlets = true;
+    _validation = VALIDATION::PENDING;
+  }
+}
+
+void GpuCulling::draw() const {
+  mgAssert(_isCreated);
+  const auto buffer = mg::mgSystem.storageContainer.getStorage(_commands).buffer;
+  if (mg::vkContext.enabledFeatures.drawIndirectCount) {
+    khr::vkCmdDrawIndexedIndirectCountKHR(mg::vkContext.commandBuffer, buffer, COMMANDS_OFFSET, buffer, 0,
+                                          _nrOfDraws, sizeof(VkDrawIndexedIndirectCommand));
+  } else {
+    vkCmdDrawIndexedIndirect(mg::vkContext.commandBuffer, buffer, COMMANDS_OFFSET, _nrOfDraws,
+                             sizeof(VkDrawIndexedIndirectCommand));
+  }
+}
+
+void GpuCulling::drawMeshlets() const {
+  mgAssert(_nrOfMeshlets);
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  vkCmdBindIndexBuffer(mg::vkContext.commandBuffer, storageContainer.getStorage(_meshletIndices).buffer, 0,
+                       VK_INDEX_TYPE_UINT32);
+  const auto buffer = storageContainer.getStorage(_meshletCommands).buffer;
+  if (mg::vkContext.enabledFeatures.drawIndirectCount) {
+    khr::vkCmdDrawIndexedIndirectCountKHR(mg::vkContext.commandBuffer, buffer, COMMANDS_OFFSET, buffer, 0,
+                                          _nrOfMeshlets, sizeof(VkDrawIndexedIndirectCommand));
+  } else {
+    vkCmdDrawIndexedIndirect(mg::vkContext.commandBuffer, buffer, COMMANDS_OFFSET, _nrOfMeshlets,
+                             sizeof(VkDrawIndexedIndirectCommand));
+  }
+}
+
+void GpuCulling::buildHiZ(TextureId depth, const glm::mat4 &viewProjection) {
+  using namespace mg::shaders::hiZ;
+  mgAssert(_isCreated);
+
+  mg::PipelineStateDesc pipelineStateDesc = {};
+  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutTexturesStorage;
+  const auto pipeline =
+      mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+
+  TextureIndices textureIndices = {};
+  textureIndices.depthIndex = mg::getTexture2DDescriptorIndex(depth);
+  vkCmdPushConstants(mg::vkContext.commandBuffer, pipeline.layout, VK_SHADER_STAGE_ALL, 0, sizeof(TextureIndices),
+                     &textureIndices);
+
+  const glm::ivec2 depthSize = {mg::vkContext.screen.width, mg::vkContext.screen.height};
+  for (uint32_t level = 0; level < _hiZLevels.size(); level++) {
+    VkBuffer uniformBuffer;
+    uint32_t uniformOffset;
+    VkDescriptorSet uboSet;
+    Ubo *ubo =
+        (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+    ubo->sourceSize = level ? _hiZLevels[level - 1].size : depthSize;
+    ubo->targetSize = _hiZLevels[level].size;
+    ubo->sourceOffset = level ? _hiZLevels[level - 1].offset : 0;
+    ubo->targetOffset = _hiZLevels[level].offset;
+    ubo->level = int32_t(level);
+
+    DescriptorSets descriptorSets = {};
+    descriptorSets.ubo = uboSet;
+    descriptorSets.textures = mg::getTextureDescriptorSet();
+    descriptorSets.hiZ = mg::mgSystem.storageContainer.getStorage(_hiZ).descriptorSet;
+
+    uint32_t dynamicOffsets[] = {uniformOffset, 0};
+    vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                            mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                            dynamicOffsets);
+    vkCmdDispatch(mg::vkContext.commandBuffer, (ubo->targetSize.x + 7) / 8, (ubo->targetSize.y + 7) / 8, 1);
+    // the next level reads this one
+    if (level + 1 < _hiZLevels.size())
+      cullingBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+  }
+  _hiZViewProjection = viewProjection;
+  _hasHiZ = true;
+}
+
+VkBuffer GpuCulling::commandsBuffer() const { return mg::mgSystem.storageContainer.getStorage(_commands).buffer; }
+
+VkBuffer GpuCulling::hiZBuffer() const { return mg::mgSystem.storageContainer.getStorage(_hiZ).buffer; }
+
+VkBuffer GpuCulling::meshletCommandsBuffer() const {
+  return mg::mgSystem.storageContainer.getStorage(_meshletCommands).buffer;
+}
+
+VkBuffer GpuCulling::meshletIndicesBuffer() const {
+  return mg::mgSystem.storageContainer.getStorage(_meshletIndices).buffer;
+}
+
+void GpuCulling::requestValidation() {
+  if (_validation == VALIDATION::NONE)
+    _validation = VALIDATION::REQUESTED;
+}
+
+bool GpuCulling::isValidationPending() const { return _validation == VALIDATION::PENDING; }
+
+uint32_t GpuCulling::validate() {
+  mgAssert(_validation == VALIDATION::PENDING);
+  mg::waitForDeviceIdle();
+  _validation = VALIDATION::NONE;
+
+  std::vector<uint32_t> visibility(_isValidatingMeshlets ? _nrOfMeshlets : _nrOfDraws);
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  std::memcpy(visibility.data(), storageContainer.mapStorage(_validationVisibility),
+              mg::sizeofContainerInBytes(visibility));
+  storageContainer.unmapStorage(_validationVisibility);
+  if (_isValidatingMeshlets)
+    return validateMeshlets(visibility);
+
+  std::vector<uint32_t> visible(_nrOfDraws);
+  const auto nrOfVisible =
+      cullSpheres(createFrustum(_validationViewProjection), _bounds.data(), _nrOfDraws, visible.data());
+  std::vector<bool> isVisible(_nrOfDraws, false);
+  for (uint32_t i = 0; i < nrOfVisible; i++)
+    isVisible[visible[i]] = true;
+
+  uint32_t mismatches = 0, nrOfOccluded = 0;
+  for (uint32_t i = 0; i < _nrOfDraws; i++) {
+    mismatches += isVisible[i] != bool(visibility[i] & CULLING_IN_FRUSTUM);
+    nrOfOccluded += (visibility[i] & CULLING_IN_FRUSTUM) && !(visibility[i] & CULLING_VISIBLE);
+  }
+  LOG("gpu culling validation: " << _nrOfDraws << " draws, " << nrOfVisible << " in the frustum on the cpu, "
+                                 << nrOfOccluded << " of them hidden by the hi-z, " << mismatches
+                                 << " frustum tests differ from the cpu");
+  return mismatches;
+}
+
+// the meshlets that pass the frustum and the cone test on the gpu are the ones cullMeshlets keeps
+uint32_t GpuCulling::validateMeshlets(const std::vector<uint32_t> &visibility) {
+  std::vector<uint32_t> visible(_nrOfMeshlets);
+  const auto nrOfVisible = mg::cullMeshlets(createFrustum(_validationViewProjection), _validationCameraPosition,
+                                            _meshlets.data(), _nrOfMeshlets, visible.data());
+  std::vector<bool> isVisible(_nrOfMeshlets, false);
+  for (uint32_t i = 0; i < nrOfVisible; i++)
+    isVisible[visible[i]] = true;
+
+  const uint32_t passed = MESHLET_IN_FRUSTUM | MESHLET_FRONT_FACING;
+  uint32_t mismatches = 0, nrOfOccluded = 0;
+  for (uint32_t i = 0; i < _nrOfMeshlets; i++) {
+    mismatches += isVisible[i] != ((visibility[i] & passed) == passed);
+    nrOfOccluded += (visibility[i] & passed) == passed && !(visibility[i] & MESHLET_VISIBLE);
+  }
+  LOG("gpu meshlet culling validation: " << _nrOfMeshlets << " meshlets, " << nrOfVisible
+                                         << " in the frustum and facing the camera on the cpu, " << nrOfOccluded
+                                         << " of them hidden by the hi-z, " << mismatches
+                                         << " tests differ from the cpu");
+  return mismatches;
+}
+
+} // namespace mg
@@ -0,0 +1,134 @@
+#pragma once
+#include "mg/frustumCulling.h"
+#include "mg/meshSimplification.h"
+#include "mg/meshlets.h"
+#include "mg/mgUtils.h"
+#include "mg/storageContainer.h"
+#include "mg/textureContainer.h"
+#include "vulkan/vkContext.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+// the layout of Lod and Draw in cullDraws.comp, the indices of a level are into the whole vertex buffer
+struct CullingLod {
+  uint32_t firstIndex, indexCount;
+  float error; // object space
+  uint32_t pad;
+};
+
+struct CullingDraw {
+  MeshBounds bounds;
+  uint32_t nrOfLods;
+  uint32_t pad[3];
+  CullingLod lods[MAX_MESH_LODS];
+};
+
+// draw i culled by the frustum has no bit set, VISIBLE also says the hi-z did not hide it
+enum CULLING_VISIBILITY : uint32_t { CULLING_IN_FRUSTUM = 1, CULLING_VISIBLE = 2 };
+
+// Culls the draws of static geometry on the gpu. A compute pass tests the bounds of every draw against the frustum
+// and against a hierarchical z buffer of the last frame, selects a level of detail for the survivors and appends them
+// to an indirect buffer that is drawn with vkCmdDrawIndexedIndirectCountKHR. Draw i is drawn with firstInstance i so
+// shaders find its data by gl_InstanceIndex. Without VK_KHR_draw_indirect_count every draw keeps its slot and culled
+// ones get no instances.
+//
+// The meshlets of the geometry are culled the same way by a second pass, which also tests their normal cones and
+// writes the triangles of the survivors to an index stream of its own. Every survivor gets an indirect draw of its
+// triangles with firstInstance set to its mesh index.
+//
+// The hi-z is a max depth pyramid in a storage buffer, level 0 has half the size of the depth buffer and every level
+// halves it down to 1x1. It is built after the depth pass from the depth buffer of the frame, the projection must map
+// depth to 0..1.
+class GpuCulling : mg::nonCopyable {
+public:
+  // needs multiDrawIndirect and drawIndirectFirstInstance
+  static bool isSupported();
+
+  // the bounds are in world space
+  void create(const CullingDraw *draws, uint32_t nrOfDraws);
+  void destroy();
+  // the hi-z has the screen size, returns true when its buffer was recreated
+  bool resize();
+
+  // records the cull pass outside of a render pass, the commands are written and the hi-z is read
+  void cull(const glm::mat4 &viewProjection, bool occlusion, const LodSelection &lodSelection);
+  // records the draws of the survivors, the pipeline and the vertex and index buffer are bound
+  void draw() const;
+  // the triangles the last cull in this frame slot drew, MAX_FRAMES_IN_FLIGHT frames late
+  uint32_t drawnTriangles() const { return _drawnTriangles; }
+  void createMeshlets(const Meshlets &meshlets);
+  bool hasMeshlets() const { return _nrOfMeshlets > 0; }
+  // records the meshlet cull pass outside of a render pass, like cull
+  void cullMeshlets(const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition, bool occlusion);
+  // records the draws of the surviving meshlets and binds the index stream, the pipeline and the vertex buffer are
+  // bound
+  void drawMeshlets() const;
+  // records the hi-z of a depth texture with the screen size after the depth pass, viewProjection is the one it was
+  // rendered with
+  void buildHiZ(TextureId depth, const glm::mat4 &viewProjection);
+
+  VkBuffer commandsBuffer() const;
+  VkBuffer hiZBuffer() const;
+  VkBuffer meshletCommandsBuffer() const;
+  VkBuffer meshletIndicesBuffer() const;
+  uint32_t nrOfDraws() const { return _nrOfDraws; }
+
+  // Requested before cull or cullMeshlets, the next one also writes the visibility of every draw or meshlet to a host
+  // visible buffer. validate waits for the device after that frame was submitted and compares the frustum test with
+  // cullSpheres, or the frustum and cone tests with cullMeshlets, it returns the number they disagree on.
+  void requestValidation();
+  bool isValidationPending() const;
+  uint32_t validate();
+
+  ~GpuCulling();
+
+private:
+  struct HiZLevel {
+    glm::ivec2 size;
+    uint32_t offset;
+  };
+  void createHiZ();
+  bool prepareValidation();
+  void readStatistics(uint32_t frameSlot);
+  void copyStatistics(VkBuffer commands, uint32_t frameSlot);
+  uint32_t validateMeshlets(const std::vector<uint32_t> &visibility);
+
+  uint32_t _nrOfDraws = 0;
+  StorageId _draws = {};
+  StorageId _commands = {};
+  StorageId _visibility = {};
+  // the count and triangles of the commands copied in every frame slot
+  StorageId _statistics = {};
+  bool _hasStatistics[MAX_FRAMES_IN_FLIGHT] = {};
+  uint32_t _drawnTriangles = 0;
+  // the cpu copies the validation culls with
+  std::vector<MeshBounds> _bounds;
+
+  uint32_t _nrOfMeshlets = 0;
+  std::vector<Meshlet> _meshlets;
+  StorageId _meshletBuffer = {};
+  // the vertices of all meshlets followed by their triangles
+  StorageId _meshletData = {};
+  uint32_t _meshletTrianglesOffset = 0;
+  StorageId _meshletIndices = {};
+  StorageId _meshletCommands = {};
+  StorageId _meshletVisibility = {};
+  bool _isCreated = false;
+
+  StorageId _hiZ = {};
+  std::vector<HiZLevel> _hiZLevels;
+  glm::mat4 _hiZViewProjection;
+  bool _hasHiZ = false;
+
+  enum class VALIDATION { NONE, REQUESTED, PENDING };
+  VALIDATION _validation = VALIDATION::NONE;
+  StorageId _validationVisibility = {};
+  bool _hasValidationVisibility = false;
+  glm::mat4 _validationViewProjection;
+  glm::vec3 _validationCameraPosition;
+  bool _isValidatingMeshlets = false;
+};
+
+} // namespace mg
@@ -0,0 +1,382 @@
+#include "instanceRendering.h"
+
+#include "mg/frustumCulling.h"
+#include "mg/meshUtils.h"
+#include "mg/mgSystem.h"
+#include "shaders/cullInstances.h"
+#include "shaders/instances.h"
+#include "vulkan/pipelineContainer.h"
+#include "vulkan/vkUtils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mg {
+
+// MAX_DRAWS in cullInstances.comp, a draw is primitive * MAX_INSTANCE_MATERIALS + material
+constexpr uint32_t MAX_INSTANCE_DRAWS = uint32_t(PRIMITIVE::COUNT) * MAX_INSTANCE_MATERIALS;
+static_assert(MAX_INSTANCE_DRAWS == 32, "MAX_DRAWS in cullInstances.comp");
+static_assert(sizeof(shaders::cullInstances::Ubo::bounds) == sizeof(glm::vec4) * uint32_t(PRIMITIVE::COUNT),
+              "the primitives do not match cullInstances.comp");
+
+// the streams of the instances one after the other in the ring buffer, capacity values each
+enum STREAM : uint32_t { STREAM_X, STREAM_Y, STREAM_Z, STREAM_SIZE, STREAM_COLOR, STREAM_DRAW, NR_OF_STREAMS };
+constexpr VkDeviceSize COMMANDS_SIZE = sizeof(VkDrawIndexedIndirectCommand) * MAX_INSTANCE_DRAWS;
+
+static const glm::vec3 quadVertices[4] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+constexpr uint32_t quadIndices[6] = {0, 1, 2, 2, 3, 0};
+constexpr uint32_t cubeVertexCount = sizeof(VolumeCube::vertices) / sizeof(glm::vec3);
+constexpr uint32_t cubeIndexCount = sizeof(VolumeCube::indices) / sizeof(uint32_t);
+
+// where the primitives are in the mesh and the sphere around them for a size of 1, see primitiveBounds
+struct Primitive {
+  uint32_t indexCount, firstIndex;
+  int32_t vertexOffset;
+  glm::vec4 bounds;
+};
+
+static Primitive getPrimitive(PRIMITIVE primitive) {
+  if (primitive == PRIMITIVE::CUBE)
+    return {cubeIndexCount, 0, 0, primitiveBounds(primitive)};
+  return {mg::countof(quadIndices), cubeIndexCount, int32_t(cubeVertexCount), primitiveBounds(primitive)};
+}
+
+static void instanceBarrier(VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages,
+                            VkAccessFlags dstAccess) {
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = srcAccess;
+  memoryBarrier.dstAccessMask = dstAccess;
+  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, srcStages, dstStages, 0, 1, &memoryBarrier, 0, nullptr, 0,
+                       nullptr);
+}
+
+InstanceRenderer::~InstanceRenderer() { mgAssert(!_isCreated); }
+
+void InstanceRenderer::create(uint32_t maxNrOfInstances) {
+  mgAssert(!_isCreated);
+  mgAssert(maxNrOfInstances > 0);
+  _capacity = maxNrOfInstances;
+  createRing();
+
+  const auto cube = mg::createVolumeCube({-0.5f, -0.5f, -0.5f}, {1, 1, 1});
+  glm::vec3 vertices[cubeVertexCount + mg::countof(quadVertices)];
+  uint32_t indices[cubeIndexCount + mg::countof(quadIndices)];
+  std::copy(std::begin(cube.vertices), std::end(cube.vertices), vertices);
+  std::copy(std::begin(quadVertices), std::end(quadVertices), vertices + cubeVertexCount);
+  std::copy(std::begin(cube.indices), std::end(cube.indices), indices);
+  std::copy(std::begin(quadIndices), std::end(quadIndices), indices + cubeIndexCount);
+  mg::CreateMeshInfo createMeshInfo = {.id = "instancePrimitives",
+                                       .vertices = (uint8_t *)vertices,
+                                       .indices = (uint8_t *)indices,
+                                       .verticesSizeInBytes = mg::sizeofArrayInBytes(vertices),
+                                       .indicesSizeInBytes = mg::sizeofArrayInBytes(indices),
+                                       .nrOfIndices = mg::countof(indices)};
+  _primitives = mg::mgSystem.meshContainer.createMesh(createMeshInfo);
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  _commands = storageContainer.createStorage(nullptr, uint32_t(COMMANDS_SIZE), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+  _visible = storageContainer.createStorage(nullptr, uint32_t(sizeof(uint32_t) * _capacity));
+  _statistics = storageContainer.createEmptyStorage(uint32_t(COMMANDS_SIZE * MAX_FRAMES_IN_FLIGHT));
+  std::fill(std::begin(_hasStatistics), std::end(_hasStatistics), false);
+  _drawnInstances = 0;
+  _nrOfDrawCalls = 0;
+  _nrOfInstances = 0;
+  _drawCounts.assign(MAX_INSTANCE_DRAWS, 0);
+  _materials.clear();
+  _isCulled = false;
+  _isCreated = true;
+}
+
+void InstanceRenderer::destroy() {
+  if (!_isCreated)
+    return;
+  destroyRing();
+  mg::mgSystem.meshContainer.removeMesh(_primitives);
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  storageContainer.removeStorage(_commands);
+  storageContainer.removeStorage(_visible);
+  storageContainer.removeStorage(_statistics);
+  _isCreated = false;
+}
+
+// one buffer per frame slot in one allocation that stays mapped, like the buffers of the linear heap allocator
+void InstanceRenderer::createRing() {
+  const uint32_t nrOfBuffers = mg::vkContext.commandBuffers.nrOfBuffers;
+  _ring = {};
+  VkBufferCreateInfo bufferCreateInfo = {};
+  bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferCreateInfo.size = VkDeviceSize(_capacity) * NR_OF_STREAMS * sizeof(uint32_t);
+  bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  for (uint32_t i = 0; i < nrOfBuffers; i++)
+    checkResult(vkCreateBuffer(mg::vkContext.device, &bufferCreateInfo, nullptr, &_ring.buffers[i]));
+
+  VkMemoryRequirements memoryRequirements = {};
+  for (uint32_t i = 0; i < nrOfBuffers; i++)
+    vkGetBufferMemoryRequirements(mg::vkContext.device, _ring.buffers[i], &memoryRequirements);
+  // with resizable bar the gpu reads the streams from its own memory
+  const auto memoryTypeIndex = findMemoryTypeIndex(
+      mg::vkContext.physicalDeviceMemoryProperties, memoryRequirements.memoryTypeBits,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  const auto alignedSize = mg::alignUpPowerOfTwo(memoryRequirements.size, memoryRequirements.alignment);
+
+  VkMemoryAllocateInfo memoryAllocateInfo = {};
+  memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  memoryAllocateInfo.allocationSize = alignedSize * nrOfBuffers;
+  memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+  checkResult(vkAllocateMemory(mg::vkContext.device, &memoryAllocateInfo, nullptr, &_ring.deviceMemory));
+
+  void *data = nullptr;
+  checkResult(vkMapMemory(mg::vkContext.device, _ring.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data));
+
+  VkDescriptorSetLayout layouts[MAX_FRAMES_IN_FLIGHT];
+  std::fill_n(layouts, nrOfBuffers, mg::vkContext.descriptorSetLayout.storage);
+  VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+  descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  descriptorSetAllocateInfo.descriptorPool = mg::vkContext.descriptorPool;
+  descriptorSetAllocateInfo.descriptorSetCount = nrOfBuffers;
+  descriptorSetAllocateInfo.pSetLayouts = layouts;
+  checkResult(vkAllocateDescriptorSets(mg::vkContext.device, &descriptorSetAllocateInfo, _ring.descriptorSets));
+
+  for (uint32_t i = 0; i < nrOfBuffers; i++) {
+    checkResult(vkBindBufferMemory(mg::vkContext.device, _ring.buffers[i], _ring.deviceMemory, alignedSize * i));
+    _ring.data[i] = (char *)data + alignedSize * i;
+
+    VkDescriptorBufferInfo descriptorBufferInfo = {};
+    descriptorBufferInfo.buffer = _ring.buffers[i];
+    descriptorBufferInfo.range = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet writeDescriptorSet = {};
+    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet = _ring.descriptorSets[i];
+    writeDescriptorSet.dstBinding = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo = &descriptorBufferInfo;
+    vkUpdateDescriptorSets(mg::vkContext.device, 1, &writeDescriptorSet, 0, nullptr);
+  }
+}
+
+void InstanceRenderer::destroyRing() {
+  const uint32_t nrOfBuffers = mg::vkContext.commandBuffers.nrOfBuffers;
+  vkFreeDescriptorSets(mg::vkContext.device, mg::vkContext.descriptorPool, nrOfBuffers, _ring.descriptorSets);
+  vkUnmapMemory(mg::vkContext.device, _ring.deviceMemory);
+  for (uint32_t i = 0; i < nrOfBuffers; i++)
+    vkDestroyBuffer(mg::vkContext.device, _ring.buffers[i], nullptr);
+  vkFreeMemory(mg::vkContext.device, _ring.deviceMemory, nullptr);
+  _ring = {};
+}
+
+uint32_t InstanceRenderer::createMaterial(const glm::vec4 &color) {
+  mgAssert(_isCreated);
+  mgAssert(_materials.size() < MAX_INSTANCE_MATERIALS);
+  _materials.push_back(color);
+  return uint32_t(_materials.size() - 1);
+}
+
+void InstanceRenderer::setMaterialColor(uint32_t material, const glm::vec4 &color) {
+  mgAssert(material < _materials.size());
+  _materials[material] = color;
+}
+
+// after beginRendering has waited for the frame slot, its ring buffer and statistics are free again
+void InstanceRenderer::begin() {
+  mgAssert(_isCreated);
+  _frameSlot = mg::vkContext.commandBuffers.currentIndex;
+  readStatistics(_frameSlot);
+  _nrOfInstances = 0;
+  std::fill(_drawCounts.begin(), _drawCounts.end(), 0);
+  _isCulled = false;
+}
+
+void InstanceRenderer::add(PRIMITIVE primitive, uint32_t material, const InstanceStreams &streams) {
+  mgAssert(!_isCulled);
+  mgAssert(primitive < PRIMITIVE::COUNT);
+  mgAssert(material < _materials.size());
+  mgAssert(streams.x && streams.y);
+  mgAssert(_nrOfInstances + streams.count <= _capacity);
+  const uint32_t count = streams.count;
+  const auto stream = [&](STREAM s) {
+    return (uint32_t *)_ring.data[_frameSlot] + size_t(s) * _capacity + _nrOfInstances;
+  };
+  // the mapped memory is write combined, every stream is written front to back once
+  std::memcpy(stream(STREAM_X), streams.x, sizeof(float) * count);
+  std::memcpy(stream(STREAM_Y), streams.y, sizeof(float) * count);
+  if (streams.z)
+    std::memcpy(stream(STREAM_Z), streams.z, sizeof(float) * count);
+  else
+    std::fill_n((float *)stream(STREAM_Z), count, 0.0f);
+  if (streams.sizes)
+    std::memcpy(stream(STREAM_SIZE), streams.sizes, sizeof(float) * count);
+  else
+    std::fill_n((float *)stream(STREAM_SIZE), count, streams.size);
+  if (streams.colors)
+    std::memcpy(stream(STREAM_COLOR), streams.colors, sizeof(uint32_t) * count);
+  else
+    std::fill_n(stream(STREAM_COLOR), count, 0xffffffffu);
+  const uint32_t draw = drawIndex(primitive, material);
+  std::fill_n(stream(STREAM_DRAW), count, draw);
+
+  _drawCounts[draw] += count;
+  _nrOfInstances += count;
+}
+
+void InstanceRenderer::cull(const glm::mat4 &viewProjection) {
+  using namespace mg::shaders::cullInstances;
+  mgAssert(_isCreated);
+  mgAssert(!_isCulled);
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  // every draw gets the range of the visible list its instances could fill, the cull pass counts the survivors
+  VkDrawIndexedIndirectCommand commands[MAX_INSTANCE_DRAWS] = {};
+  uint32_t firstInstance = 0;
+  for (uint32_t d = 0; d < MAX_INSTANCE_DRAWS; d++) {
+    const auto primitive = getPrimitive(PRIMITIVE(d / MAX_INSTANCE_MATERIALS));
+    commands[d].indexCount = primitive.indexCount;
+    commands[d].firstIndex = primitive.firstIndex;
+    commands[d].vertexOffset = primitive.vertexOffset;
+    commands[d].firstInstance = firstInstance;
+    firstInstance += _drawCounts[d];
+  }
+
+  // the commands and the visible list are written after the draws and the statistics copy of the last frame read them
+  const auto commandsBuffer = storageContainer.getStorage(_commands).buffer;
+  instanceBarrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  0, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+  vkCmdUpdateBuffer(mg::vkContext.commandBuffer, commandsBuffer, 0, sizeof(commands), commands);
+  instanceBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+  if (_nrOfInstances) {
+    mg::PipelineStateDesc pipelineStateDesc = {};
+    pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+    const auto pipeline =
+        mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+
+    VkBuffer uniformBuffer;
+    uint32_t uniformOffset;
+    VkDescriptorSet uboSet;
+    Ubo *ubo = (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset,
+                                                                        &uboSet);
+    const auto frustum = createFrustum(viewProjection);
+    std::memcpy(ubo->planes, frustum.planes, sizeof(frustum.planes));
+    for (uint32_t p = 0; p < uint32_t(PRIMITIVE::COUNT); p++)
+      ubo->bounds[p] = getPrimitive(PRIMITIVE(p)).bounds;
+    ubo->nrOfInstances = _nrOfInstances;
+    ubo->capacity = _capacity;
+    ubo->nrOfMaterials = MAX_INSTANCE_MATERIALS;
+
+    DescriptorSets descriptorSets = {};
+    descriptorSets.ubo = uboSet;
+    descriptorSets.instances = _ring.descriptorSets[_frameSlot];
+    descriptorSets.commands = storageContainer.getStorage(_commands).descriptorSet;
+    descriptorSets.visible = storageContainer.getStorage(_visible).descriptorSet;
+
+    vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    uint32_t dynamicOffsets[] = {uniformOffset, 0};
+    vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                            mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                            dynamicOffsets);
+    vkCmdDispatch(mg::vkContext.commandBuffer, (_nrOfInstances + 255) / 256, 1, 1);
+  }
+
+  instanceBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+  VkBufferCopy statisticsCopy = {};
+  statisticsCopy.size = COMMANDS_SIZE;
+  statisticsCopy.dstOffset = _frameSlot * COMMANDS_SIZE;
+  vkCmdCopyBuffer(mg::vkContext.commandBuffer, commandsBuffer, storageContainer.getStorage(_statistics).buffer, 1,
+                  &statisticsCopy);
+  instanceBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                  VK_ACCESS_HOST_READ_BIT);
+  _hasStatistics[_frameSlot] = true;
+  _isCulled = true;
+}
+
+// the commands of this frame slot were copied by a frame that has finished
+void InstanceRenderer::readStatistics(uint32_t frameSlot) {
+  if (!_hasStatistics[frameSlot])
+    return;
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  VkDrawIndexedIndirectCommand commands[MAX_INSTANCE_DRAWS];
+  std::memcpy(commands, (char *)storageContainer.mapStorage(_statistics) + frameSlot * COMMANDS_SIZE,
+              sizeof(commands));
+  storageContainer.unmapStorage(_statistics);
+  _drawnInstances = 0;
+  for (const auto &command : commands)
+    _drawnInstances += command.instanceCount;
+}
+
+void InstanceRenderer::draw(const mg::RenderContext &renderContext) {
+  using namespace mg::shaders::instances;
+  mgAssert(_isCulled);
+  _nrOfDrawCalls = 0;
+  if (!_nrOfInstances)
+    return;
+
+  auto &storageContainer = mg::mgSystem.storageContainer;
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->viewProjection = renderContext.projection * renderContext.view;
+  ubo->capacity = _capacity;
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.instances = _ring.descriptorSets[_frameSlot];
+  descriptorSets.visible = storageContainer.getStorage(_visible).descriptorSet;
+
+  const auto mesh = mg::getMesh(_primitives);
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(mg::vkContext.commandBuffer, 0, 1, &mesh.buffer, &offset);
+  vkCmdBindIndexBuffer(mg::vkContext.commandBuffer, mesh.buffer, mesh.indicesOffset, VK_INDEX_TYPE_UINT32);
+  const auto commandsBuffer = storageContainer.getStorage(_commands).buffer;
+
+  for (uint32_t p = 0; p < uint32_t(PRIMITIVE::COUNT); p++) {
+    const auto first = _drawCounts.begin() + p * MAX_INSTANCE_MATERIALS;
+    if (std::all_of(first, first + MAX_INSTANCE_MATERIALS, [](uint32_t count) { return count == 0; }))
+      continue;
+
+    mg::PipelineStateDesc pipelineStateDesc = {};
+    pipelineStateDesc.rasterization.vkRenderPass = renderContext.renderPass;
+    pipelineStateDesc.rasterization.vkPipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+    pipelineStateDesc.rasterization.graphics.subpass = renderContext.subpass;
+    if (PRIMITIVE(p) == PRIMITIVE::QUAD) {
+      pipelineStateDesc.rasterization.depth.TestEnable = VK_FALSE;
+      pipelineStateDesc.rasterization.rasterization.cullMode = VK_CULL_MODE_NONE;
+    }
+
+    mg::CreatePipelineInfo createPipelineInfo = {};
+    createPipelineInfo.shaderName = shader;
+    createPipelineInfo.vertexInputState = InputAssembler::vertexInputState;
+    createPipelineInfo.vertexInputStateCount = mg::countof(InputAssembler::vertexInputState);
+    const auto pipeline = mg::mgSystem.pipelineContainer.createPipeline(pipelineStateDesc, createPipelineInfo);
+
+    vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    uint32_t dynamicOffsets[] = {uniformOffset, 0};
+    vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0,
+                            mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
+                            dynamicOffsets);
+
+    for (uint32_t m = 0; m < _materials.size(); m++) {
+      const uint32_t draw = drawIndex(PRIMITIVE(p), m);
+      if (!_drawCounts[draw])
+        continue;
+      Material material = {};
+      material.color = _materials[m];
+      material.lit = PRIMITIVE(p) == PRIMITIVE::CUBE;
+      vkCmdPushConstants(mg::vkContext.commandBuffer, pipeline.layout, VK_SHADER_STAGE_ALL, 0, sizeof(Material),
+                         &material);
+      vkCmdDrawIndexedIndirect(mg::vkContext.commandBuffer, commandsBuffer,
+                               draw * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+      _nrOfDrawCalls++;
+    }
+  }
+}
+
+} // namespace mg
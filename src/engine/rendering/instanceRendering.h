@@ -0,0 +1,80 @@
+#pragma once
+#include "mg/instanceCulling.h"
+#include "mg/meshContainer.h"
+#include "mg/mgUtils.h"
+#include "mg/storageContainer.h"
+#include "rendering/rendering.h"
+#include "vulkan/vkContext.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+
+constexpr uint32_t MAX_INSTANCE_MATERIALS = 16;
+
+// Draws large numbers of cubes and quads with one indirect draw per primitive and material. The streams are copied
+// into a persistently mapped buffer of the frame slot, there is one per frame in flight so the copy never waits for
+// the gpu. A compute pass tests the sphere of every instance against the frustum and appends the survivors to a
+// visible list per draw, the vertex shader reads the instance of gl_InstanceIndex from there.
+//
+// A frame is begin after beginRendering, add for every stream, cull outside of a render pass and draw inside of it.
+class InstanceRenderer : mg::nonCopyable {
+public:
+  // the instances added in a frame, the buffers take 24 bytes per instance and frame in flight
+  void create(uint32_t maxNrOfInstances);
+  void destroy();
+
+  // the color of a material tints the colors of its instances
+  uint32_t createMaterial(const glm::vec4 &color);
+  void setMaterialColor(uint32_t material, const glm::vec4 &color);
+
+  void begin();
+  void add(PRIMITIVE primitive, uint32_t material, const InstanceStreams &streams);
+  void cull(const glm::mat4 &viewProjection);
+  // the cubes are depth tested, the quads are not
+  void draw(const mg::RenderContext &renderContext);
+
+  uint32_t nrOfInstances() const { return _nrOfInstances; }
+  uint32_t maxNrOfInstances() const { return _capacity; }
+  // the draw calls recorded by the last draw
+  uint32_t nrOfDrawCalls() const { return _nrOfDrawCalls; }
+  // the instances the last cull in this frame slot let through, MAX_FRAMES_IN_FLIGHT frames late
+  uint32_t drawnInstances() const { return _drawnInstances; }
+
+  ~InstanceRenderer();
+
+private:
+  struct Ring {
+    VkDeviceMemory deviceMemory;
+    VkBuffer buffers[MAX_FRAMES_IN_FLIGHT];
+    VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT];
+    char *data[MAX_FRAMES_IN_FLIGHT];
+  };
+  void createRing();
+  void destroyRing();
+  void readStatistics(uint32_t frameSlot);
+  uint32_t drawIndex(PRIMITIVE primitive, uint32_t material) const {
+    return uint32_t(primitive) * MAX_INSTANCE_MATERIALS + material;
+  }
+
+  uint32_t _capacity = 0;
+  uint32_t _nrOfInstances = 0;
+  uint32_t _frameSlot = 0;
+  Ring _ring = {};
+  std::vector<glm::vec4> _materials;
+  // the instances of every draw this frame
+  std::vector<uint32_t> _drawCounts;
+
+  MeshId _primitives = {};
+  StorageId _commands = {};
+  StorageId _visible = {};
+  // the commands copied in every frame slot
+  StorageId _statistics = {};
+  bool _hasStatistics[MAX_FRAMES_IN_FLIGHT] = {};
+  uint32_t _drawnInstances = 0;
+  uint32_t _nrOfDrawCalls = 0;
+  bool _isCulled = false;
+  bool _isCreated = false;
+};
+
+} // namespace mg
@@ -3,6 +3,7 @@
 #include "mg/fonts.h"
 #include "mg/mgSystem.h"
 #include "mg/texts.h"
+#include "shaders/fontRendering.h"
 #include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -27,21 +28,23 @@ static mg::Pipeline createFontPipeline(const mg::RenderContext &renderContext) {
   return pipeline;
 }
 
-static std::vector<glm::vec4> getTextsVertexBufferData(mg::FONT_TYPE fontType, const _Text texts[Texts::maxTextPerFont],
-                                                       uint32_t count, const mg::Fonts &fonts) {
-  size_t charVectorSize = 0;
+static uint32_t countCharacters(const _Text texts[Texts::maxTextPerFont], uint32_t count) {
+  uint32_t nrOfCharacters = 0;
   for (uint32_t i = 0; i < count; i++) {
-    charVectorSize += texts[i].text.size();
+    nrOfCharacters += texts[i].length;
   }
+  return nrOfCharacters;
+}
 
-  std::vector<glm::vec4> charVectorData;
-  charVectorData.reserve(charVectorSize * 24);
-
+// writes a position and a color per vertex, six vertices per character
+static void writeTextsVertexBufferData(mg::FONT_TYPE fontType, const _Text texts[Texts::maxTextPerFont],
+                                       uint32_t count, const mg::Fonts &fonts, glm::vec4 *charVectorData) {
   for (uint32_t i = 0; i < count; i++) {
-    const auto text = texts[i];
+    const auto &text = texts[i];
     auto position = glm::vec2{floorf(text.position.x), floorf(text.position.y)};
     // Iterate through all characters
-    for (const auto &textChar : text.text) {
+    for (uint32_t c = 0; c < text.length; c++) {
+      const char textChar = text.text[c];
       const auto &character = fonts.getFontCharacter(fontType, textChar);
 
       const glm::vec2 corner_pos = {position.x + float(character.bearing.x),
@@ -53,28 +56,26 @@ static std::vector<glm::vec4> getTextsVertexBufferData(mg::FONT_TYPE fontType, c
       const auto glyphWidth = float(character.size.x) / float(fontMapSize.x);
       const auto glyphHeight = float(character.size.y) / float(fontMapSize.y);
 
-      charVectorData.push_back(glm::vec4{corner_pos.x, corner_pos.y + size.y, glyphPosition, 0.0f});
-      charVectorData.push_back(text.color);
-      charVectorData.push_back(glm::vec4{corner_pos.x, corner_pos.y, glyphPosition, glyphHeight});
-      charVectorData.push_back(text.color);
-      charVectorData.push_back(glm::vec4{corner_pos.x + size.x, corner_pos.y, glyphPosition + glyphWidth, glyphHeight});
-      charVectorData.push_back(text.color);
-      charVectorData.push_back(glm::vec4{corner_pos.x, corner_pos.y + size.y, glyphPosition, 0.0f});
-      charVectorData.push_back(text.color);
-      charVectorData.push_back(glm::vec4{corner_pos.x + size.x, corner_pos.y, glyphPosition + glyphWidth, glyphHeight});
-      charVectorData.push_back(text.color);
-      charVectorData.push_back(
-          glm::vec4{corner_pos.x + size.x, corner_pos.y + size.y, glyphPosition + glyphWidth, 0.0f});
-      charVectorData.push_back(text.color);
+      *charVectorData++ = glm::vec4{corner_pos.x, corner_pos.y + size.y, glyphPosition, 0.0f};
+      *charVectorData++ = text.color;
+      *charVectorData++ = glm::vec4{corner_pos.x, corner_pos.y, glyphPosition, glyphHeight};
+      *charVectorData++ = text.color;
+      *charVectorData++ = glm::vec4{corner_pos.x + size.x, corner_pos.y, glyphPosition + glyphWidth, glyphHeight};
+      *charVectorData++ = text.color;
+      *charVectorData++ = glm::vec4{corner_pos.x, corner_pos.y + size.y, glyphPosition, 0.0f};
+      *charVectorData++ = text.color;
+      *charVectorData++ = glm::vec4{corner_pos.x + size.x, corner_pos.y, glyphPosition + glyphWidth, glyphHeight};
+      *charVectorData++ = text.color;
+      *charVectorData++ = glm::vec4{corner_pos.x + size.x, corner_pos.y + size.y, glyphPosition + glyphWidth, 0.0f};
+      *charVectorData++ = text.color;
       // Now advance cursors for next glyph
       position.x += character.advance;
     }
   }
-  return charVectorData;
 }
 
 static void renderCharacters(const mg::RenderContext &renderContext, const mg::FONT_TYPE fontType,
-                             const std::vector<glm::vec4> &charVectorData, const mg::Fonts &fonts) {
+                             const _Text texts[Texts::maxTextPerFont], uint32_t count, const mg::Fonts &fonts) {
   auto pipeline = createFontPipeline(renderContext);
 
   using namespace mg::shaders::fontRendering;
@@ -108,11 +109,12 @@ static void renderCharacters(const mg::RenderContext &renderContext, const mg::F
 
   VkBuffer buffer;
   VkDeviceSize buffer_offset;
-  const uint32_t vertexCount = uint32_t(charVectorData.size() / 2); // positions and colors
+  const uint32_t vertexCount = countCharacters(texts, count) * 6;
   uint32_t totalSize = sizeof(VertexInputData) * vertexCount;
-  auto *vertices =
-      (VertexInputData *)mg::mgSystem.linearHeapAllocator.allocateBuffer(totalSize, &buffer, &buffer_offset);
-  memcpy(vertices, charVectorData.data(), totalSize);
+  static_assert(sizeof(VertexInputData) == 2 * sizeof(glm::vec4), "a vertex is a position and a color");
+  auto *vertices = (glm::vec4 *)mg::mgSystem.linearHeapAllocator.allocateBuffer(totalSize, &buffer, &buffer_offset);
+  // straight into the mapped buffer, no staging vector
+  writeTextsVertexBufferData(fontType, texts, count, fonts, vertices);
 
   vkCmdBindVertexBuffers(mg::vkContext.commandBuffer, 0, 1, &buffer, &buffer_offset);
   vkCmdDraw(mg::vkContext.commandBuffer, vertexCount, 1, 0, 0);
@@ -125,10 +127,9 @@ void renderText(const mg::RenderContext &renderContext, const mg::Texts &texts)
       continue;
 
     const auto fontType = (mg::FONT_TYPE)i;
-    const auto &vertexBufferData =
-        getTextsVertexBufferData(fontType, fontsToTexts[i], texts.textsPerFont[i], mg::mgSystem.fonts);
-    mgAssert(vertexBufferData.size() != 0);
-    renderCharacters(renderContext, fontType, vertexBufferData, mg::mgSystem.fonts);
+    if (countCharacters(fontsToTexts[i], texts.textsPerFont[i]) == 0)
+      continue;
+    renderCharacters(renderContext, fontType, fontsToTexts[i], texts.textsPerFont[i], mg::mgSystem.fonts);
   }
 }
 
@@ -0,0 +1,884 @@
+#include "frameGraph.h"
+
+#include "mg/logger.h"
+#include "mg/mgAssert.h"
+#include "mg/mgSystem.h"
+#include "rendering/rendering.h"
+#include "vkUtils.h"
+#include <algorithm>
+
+namespace mg {
+
+namespace {
+
+// color and depth attachments next to the FRAME_GRAPH_ACCESS uses
+enum class USAGE { COLOR, DEPTH, SAMPLED, INPUT_ATTACHMENT, STORAGE_READ, STORAGE_WRITE, VERTEX, INDIRECT };
+
+struct PassUse {
+  uint32_t resource;
+  USAGE usage;
+  VkPipelineStageFlags stages;
+  bool clear;
+};
+
+constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                                       VK_ACCESS_MEMORY_WRITE_BIT;
+constexpr VkPipelineStageFlags DEPTH_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+USAGE usageOf(FRAME_GRAPH_ACCESS access) {
+  switch (access) {
+  case FRAME_GRAPH_ACCESS::SAMPLED:
+    return USAGE::SAMPLED;
+  case FRAME_GRAPH_ACCESS::INPUT_ATTACHMENT:
+    return USAGE::INPUT_ATTACHMENT;
+  case FRAME_GRAPH_ACCESS::STORAGE_READ:
+    return USAGE::STORAGE_READ;
+  case FRAME_GRAPH_ACCESS::STORAGE_WRITE:
+    return USAGE::STORAGE_WRITE;
+  case FRAME_GRAPH_ACCESS::VERTEX:
+    return USAGE::VERTEX;
+  case FRAME_GRAPH_ACCESS::INDIRECT:
+    return USAGE::INDIRECT;
+  }
+  return USAGE::SAMPLED;
+}
+
+bool isWrite(USAGE usage) { return usage == USAGE::COLOR || usage == USAGE::DEPTH || usage == USAGE::STORAGE_WRITE; }
+bool isAttachment(USAGE usage) { return usage == USAGE::COLOR || usage == USAGE::DEPTH; }
+// reads the content the resource had before the pass
+bool readsContent(const PassUse &use) { return !(isAttachment(use.usage) && use.clear) && use.usage != USAGE::STORAGE_WRITE; }
+
+// uses is a std::vector while compiling and a scratch ArenaVector while recording a frame
+template <typename Uses> void appendUsesOf(const FrameGraphPassInfo &pass, Uses *uses) {
+  for (const auto &attachment : pass.colorAttachments)
+    uses->push_back(
+        {attachment.resource.index, USAGE::COLOR, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, attachment.clear});
+  if (pass.depthAttachment.resource.index != UINT32_MAX)
+    uses->push_back({pass.depthAttachment.resource.index, USAGE::DEPTH, DEPTH_STAGES, pass.depthAttachment.clear});
+  for (const auto &use : pass.uses) {
+    const auto usage = usageOf(use.access);
+    VkPipelineStageFlags stages = pass.type == FRAME_GRAPH_PASS::COMPUTE ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                                                                         : use.stages;
+    if (usage == USAGE::VERTEX)
+      stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    else if (usage == USAGE::INDIRECT)
+      stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+    uses->push_back({use.resource.index, usage, stages, false});
+  }
+}
+
+std::vector<PassUse> usesOf(const FrameGraphPassInfo &pass) {
+  std::vector<PassUse> uses;
+  appendUsesOf(pass, &uses);
+  return uses;
+}
+
+VkAccessFlags accessOf(USAGE usage) {
+  switch (usage) {
+  case USAGE::COLOR:
+    return VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  case USAGE::DEPTH:
+    return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  case USAGE::SAMPLED:
+  case USAGE::STORAGE_READ:
+    return VK_ACCESS_SHADER_READ_BIT;
+  case USAGE::INPUT_ATTACHMENT:
+    return VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+  case USAGE::STORAGE_WRITE:
+    return VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  case USAGE::VERTEX:
+    return VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+  case USAGE::INDIRECT:
+    return VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  }
+  return 0;
+}
+
+VkImageLayout layoutOf(USAGE usage) {
+  switch (usage) {
+  case USAGE::COLOR:
+    return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  case USAGE::DEPTH:
+    return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  case USAGE::STORAGE_READ:
+  case USAGE::STORAGE_WRITE:
+    return VK_IMAGE_LAYOUT_GENERAL;
+  default:
+    // the texture descriptor set is written with this layout for every 2D texture
+    return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  }
+}
+
+bool isDepthFormat(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_D16_UNORM:
+  case VK_FORMAT_X8_D24_UNORM_PACK32:
+  case VK_FORMAT_D32_SFLOAT:
+  case VK_FORMAT_D16_UNORM_S8_UINT:
+  case VK_FORMAT_D24_UNORM_S8_UINT:
+  case VK_FORMAT_D32_SFLOAT_S8_UINT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool operator==(VkExtent2D a, VkExtent2D b) { return a.width == b.width && a.height == b.height; }
+
+// a viewport flipped like setViewPort for render targets that are not the size of the screen
+void setTargetViewport(VkExtent2D extent) {
+  VkViewport viewport = {};
+  viewport.y = float(extent.height);
+  viewport.width = float(extent.width);
+  viewport.height = -float(extent.height);
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(vkContext.commandBuffer, 0, 1, &viewport);
+  VkRect2D scissor = {{0, 0}, extent};
+  vkCmdSetScissor(vkContext.commandBuffer, 0, 1, &scissor);
+}
+
+} // namespace
+
+FrameGraph::~FrameGraph() { mgAssert(!_isCompiled); }
+
+FrameGraphResourceId FrameGraph::createImage(const FrameGraphImageInfo &imageInfo) {
+  mgAssert(!_isCompiled);
+  Resource resource = {};
+  resource.id = imageInfo.id;
+  resource.type = RESOURCE_TYPE::IMAGE;
+  resource.imageInfo = imageInfo;
+  _resources.push_back(resource);
+  return {uint32_t(_resources.size() - 1)};
+}
+
+FrameGraphResourceId FrameGraph::importSwapChain() {
+  mgAssert(!_isCompiled);
+  Resource resource = {};
+  resource.id = "swap chain";
+  resource.type = RESOURCE_TYPE::SWAP_CHAIN;
+  _resources.push_back(resource);
+  return {uint32_t(_resources.size() - 1)};
+}
+
+FrameGraphResourceId FrameGraph::importTexture(TextureId textureId, VkImageLayout layout) {
+  mgAssert(!_isCompiled);
+  Resource resource = {};
+  resource.id = "imported texture";
+  resource.type = RESOURCE_TYPE::IMPORTED_TEXTURE;
+  resource.textureId = textureId;
+  resource.importedLayout = layout;
+  resource.state.layout = layout;
+  _resources.push_back(resource);
+  return {uint32_t(_resources.size() - 1)};
+}
+
+FrameGraphResourceId FrameGraph::importBuffer(const std::string &id, VkBuffer buffer) {
+  mgAssert(!_isCompiled);
+  Resource resource = {};
+  resource.id = id;
+  resource.type = RESOURCE_TYPE::BUFFER;
+  resource.buffer = buffer;
+  _resources.push_back(resource);
+  return {uint32_t(_resources.size() - 1)};
+}
+
+void FrameGraph::addPass(const FrameGraphPassInfo &passInfo) {
+  mgAssert(!_isCompiled);
+  mgAssertDesc(passInfo.execute, "frame graph pass " << passInfo.id << " has nothing to execute");
+  for (const auto &use : usesOf(passInfo)) {
+    mgAssertDesc(use.resource < _resources.size(), "frame graph pass " << passInfo.id << " uses an unknown resource");
+    mgAssertDesc(!isAttachment(use.usage) || passInfo.type == FRAME_GRAPH_PASS::RASTER,
+                 "compute pass " << passInfo.id << " has attachments");
+  }
+  _passes.push_back(passInfo);
+}
+
+VkExtent2D FrameGraph::extentOf(const Resource &resource) const {
+  switch (resource.type) {
+  case RESOURCE_TYPE::IMAGE:
+    if (resource.imageInfo.size.width)
+      return resource.imageInfo.size;
+    return {std::max(uint32_t(vkContext.screen.width * resource.imageInfo.screenScale), 1u),
+            std::max(uint32_t(vkContext.screen.height * resource.imageInfo.screenScale), 1u)};
+  default:
+    return {vkContext.screen.width, vkContext.screen.height};
+  }
+}
+
+VkImage FrameGraph::imageOf(const Resource &resource) const {
+  if (resource.type == RESOURCE_TYPE::SWAP_CHAIN)
+    return vkContext.swapChain->images[vkContext.swapChain->currentSwapChainIndex];
+  return mg::getTexture(resource.textureId).image;
+}
+
+VkImageView FrameGraph::imageViewOf(const Resource &resource) const {
+  return mg::getTexture(resource.textureId).imageView;
+}
+
+VkFormat FrameGraph::formatOf(const Resource &resource) const {
+  switch (resource.type) {
+  case RESOURCE_TYPE::IMAGE:
+    return resource.imageInfo.format;
+  case RESOURCE_TYPE::SWAP_CHAIN:
+    return vkContext.swapChain->format;
+  default:
+    return mg::getTexture(resource.textureId).format;
+  }
+}
+
+bool FrameGraph::isTransient(const Resource &resource) const {
+  return resource.type == RESOURCE_TYPE::IMAGE && !resource.imageInfo.persistent;
+}
+
+bool FrameGraph::isDepth(const Resource &resource) const {
+  return resource.type != RESOURCE_TYPE::BUFFER && isDepthFormat(formatOf(resource));
+}
+
+// Walks the passes backwards, a pass lives when a living pass after it reads what it writes
+void FrameGraph::cullPasses() {
+  _isPassAlive.assign(_passes.size(), false);
+  std::vector<bool> isRead(_resources.size(), false);
+  for (uint32_t i = uint32_t(_passes.size()); i-- > 0;) {
+    const auto uses = usesOf(_passes[i]);
+    bool isAlive = _passes[i].hasSideEffects;
+    for (const auto &use : uses) {
+      if (isWrite(use.usage))
+        isAlive |= isRead[use.resource] || !isTransient(_resources[use.resource]);
+    }
+    if (!isAlive)
+      continue;
+    _isPassAlive[i] = true;
+    for (const auto &use : uses) {
+      if (isAttachment(use.usage) && use.clear)
+        isRead[use.resource] = false;
+    }
+    for (const auto &use : uses) {
+      if (readsContent(use))
+        isRead[use.resource] = true;
+    }
+  }
+}
+
+// Consecutive raster passes of the same size share a render pass unless a pass writes an attachment that an earlier
+// subpass read, or needs a resource written in the render pass outside of an attachment
+void FrameGraph::createBatches() {
+  _batches.clear();
+  std::vector<bool> isWritten(_resources.size()), isUsed(_resources.size()), isReadInBatch(_resources.size());
+  for (uint32_t i = 0; i < _passes.size(); i++) {
+    if (!_isPassAlive[i])
+      continue;
+    const auto &pass = _passes[i];
+    const auto uses = usesOf(pass);
+    const bool isRaster = pass.type == FRAME_GRAPH_PASS::RASTER;
+
+    VkExtent2D extent = {};
+    for (const auto &use : uses) {
+      if (!isAttachment(use.usage))
+        continue;
+      const auto attachmentExtent = extentOf(_resources[use.resource]);
+      mgAssertDesc(extent.width == 0 || extent == attachmentExtent,
+                   "the attachments of frame graph pass " << pass.id << " differ in size");
+      extent = attachmentExtent;
+    }
+    mgAssertDesc(!isRaster || extent.width, "frame graph raster pass " << pass.id << " has no attachments");
+
+    bool canMerge = isRaster && !_batches.empty() && _batches.back().isRaster && _batches.back().extent == extent;
+    for (const auto &use : uses) {
+      if (!canMerge)
+        break;
+      if (isAttachment(use.usage))
+        canMerge = !isReadInBatch[use.resource] && (!isUsed[use.resource] || !use.clear);
+      else if (use.usage == USAGE::STORAGE_WRITE)
+        canMerge = !isUsed[use.resource];
+      else if (use.usage != USAGE::SAMPLED && use.usage != USAGE::INPUT_ATTACHMENT)
+        canMerge = !isWritten[use.resource];
+    }
+    if (!canMerge) {
+      _batches.push_back({});
+      _batches.back().isRaster = isRaster;
+      _batches.back().extent = extent;
+      std::fill(isWritten.begin(), isWritten.end(), false);
+      std::fill(isUsed.begin(), isUsed.end(), false);
+      std::fill(isReadInBatch.begin(), isReadInBatch.end(), false);
+    }
+    for (const auto &use : uses) {
+      for (const auto &other : uses) {
+        mgAssertDesc(!isAttachment(use.usage) || isAttachment(other.usage) || use.resource != other.resource,
+                     "frame graph pass " << pass.id << " reads its own attachment " << _resources[use.resource].id);
+      }
+      isWritten[use.resource] = isWritten[use.resource] || isWrite(use.usage);
+      isReadInBatch[use.resource] = isReadInBatch[use.resource] || !isWrite(use.usage);
+      isUsed[use.resource] = true;
+    }
+    _batches.back().passes.push_back(i);
+  }
+
+  for (auto &resource : _resources) {
+    resource.firstBatch = UINT32_MAX;
+    resource.lastBatch = 0;
+  }
+  for (uint32_t i = 0; i < _batches.size(); i++) {
+    for (const auto passIndex : _batches[i].passes) {
+      for (const auto &use : usesOf(_passes[passIndex])) {
+        auto &resource = _resources[use.resource];
+        if (resource.firstBatch == UINT32_MAX) {
+          mgAssertDesc(!isTransient(resource) || isWrite(use.usage),
+                       "frame graph image " << resource.id << " is read before it is written");
+        }
+        resource.firstBatch = std::min(resource.firstBatch, i);
+        resource.lastBatch = std::max(resource.lastBatch, i);
+      }
+    }
+  }
+}
+
+void FrameGraph::createRenderPass(Batch *batch) {
+  const auto batchIndex = uint32_t(batch - _batches.data());
+  const auto subpassCount = uint32_t(batch->passes.size());
+
+  // an attachment for every color and depth target and for every read of one written in an earlier subpass
+  std::vector<uint32_t> attachmentIndex(_resources.size(), UINT32_MAX);
+  std::vector<uint32_t> writtenInSubpass(_resources.size(), UINT32_MAX);
+  std::vector<std::vector<PassUse>> subpassUses(subpassCount);
+  batch->attachments.clear();
+  for (uint32_t subpass = 0; subpass < subpassCount; subpass++) {
+    for (const auto &use : usesOf(_passes[batch->passes[subpass]])) {
+      const bool isInput = (use.usage == USAGE::SAMPLED || use.usage == USAGE::INPUT_ATTACHMENT) &&
+                           writtenInSubpass[use.resource] != UINT32_MAX;
+      if (!isAttachment(use.usage) && !isInput)
+        continue;
+      if (attachmentIndex[use.resource] == UINT32_MAX) {
+        attachmentIndex[use.resource] = uint32_t(batch->attachments.size());
+        batch->attachments.push_back(use.resource);
+      }
+      subpassUses[subpass].push_back(use);
+    }
+    for (const auto &use : subpassUses[subpass]) {
+      if (isAttachment(use.usage))
+        writtenInSubpass[use.resource] = subpass;
+    }
+  }
+
+  const auto attachmentCount = uint32_t(batch->attachments.size());
+  std::vector<VkAttachmentDescription> descriptions(attachmentCount);
+  std::vector<uint32_t> firstSubpass(attachmentCount, UINT32_MAX), lastSubpass(attachmentCount, 0);
+  std::vector<VkImageLayout> lastLayout(attachmentCount);
+  batch->clearValues.assign(attachmentCount, {});
+  batch->initialLayouts.assign(attachmentCount, VK_IMAGE_LAYOUT_UNDEFINED);
+  batch->finalLayouts.assign(attachmentCount, VK_IMAGE_LAYOUT_UNDEFINED);
+  for (uint32_t subpass = 0; subpass < subpassCount; subpass++) {
+    const auto &pass = _passes[batch->passes[subpass]];
+    for (const auto &use : subpassUses[subpass]) {
+      const auto index = attachmentIndex[use.resource];
+      const auto &resource = _resources[use.resource];
+      auto &description = descriptions[index];
+      if (firstSubpass[index] == UINT32_MAX) {
+        firstSubpass[index] = subpass;
+        // a transient image has no content before its first batch, the swap chain none before the frame
+        const bool hasContent = resource.type == RESOURCE_TYPE::IMPORTED_TEXTURE || resource.imageInfo.persistent ||
+                                resource.firstBatch < batchIndex;
+        description.format = formatOf(resource);
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                                       : hasContent ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = isAttachment(use.usage) ? layoutOf(use.usage) : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (use.clear) {
+          const auto &attachments = pass.colorAttachments;
+          const auto found = std::find_if(attachments.begin(), attachments.end(),
+                                          [&](const FrameGraphAttachment &a) { return a.resource.index == use.resource; });
+          batch->clearValues[index] =
+              found != attachments.end() ? found->clearValue : pass.depthAttachment.clearValue;
+        }
+      }
+      lastSubpass[index] = subpass;
+      lastLayout[index] = isAttachment(use.usage) ? layoutOf(use.usage) : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+  }
+  for (uint32_t i = 0; i < attachmentCount; i++) {
+    const auto &resource = _resources[batch->attachments[i]];
+    const bool isKept = !isTransient(resource) || resource.lastBatch > batchIndex;
+    auto &description = descriptions[i];
+    description.storeOp = isKept ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    description.finalLayout = lastLayout[i];
+    if (resource.lastBatch == batchIndex && resource.type == RESOURCE_TYPE::SWAP_CHAIN)
+      description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    else if (resource.lastBatch == batchIndex && resource.type == RESOURCE_TYPE::IMPORTED_TEXTURE)
+      description.finalLayout = resource.importedLayout;
+    if (isKept)
+      lastSubpass[i] = subpassCount - 1;
+    batch->initialLayouts[i] = description.initialLayout;
+    batch->finalLayouts[i] = description.finalLayout;
+  }
+
+  // references, the vectors are sized up front so the pointers into them stay valid
+  std::vector<std::vector<VkAttachmentReference>> colorReferences(subpassCount), inputReferences(subpassCount);
+  std::vector<VkAttachmentReference> depthReferences(subpassCount);
+  std::vector<std::vector<uint32_t>> preserved(subpassCount);
+  std::vector<VkSubpassDescription> subpasses(subpassCount);
+  std::vector<VkSubpassDependency> dependencies;
+  std::fill(writtenInSubpass.begin(), writtenInSubpass.end(), UINT32_MAX);
+  for (uint32_t subpass = 0; subpass < subpassCount; subpass++) {
+    auto &description = subpasses[subpass];
+    description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    std::vector<bool> isReferenced(attachmentCount, false);
+    for (const auto &use : subpassUses[subpass]) {
+      const auto index = attachmentIndex[use.resource];
+      isReferenced[index] = true;
+      if (use.usage == USAGE::COLOR)
+        colorReferences[subpass].push_back({index, layoutOf(use.usage)});
+      else if (use.usage == USAGE::DEPTH)
+        depthReferences[subpass] = {index, layoutOf(use.usage)};
+      else
+        inputReferences[subpass].push_back({index, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+
+      // waits for the subpass that wrote it last, a read through a sampler may touch any pixel of it
+      const auto writer = writtenInSubpass[use.resource];
+      if (writer != UINT32_MAX) {
+        const bool writerIsDepth = isDepth(_resources[use.resource]);
+        VkSubpassDependency dependency = {};
+        dependency.srcSubpass = writer;
+        dependency.dstSubpass = subpass;
+        dependency.srcStageMask = writerIsDepth ? DEPTH_STAGES : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependency.srcAccessMask = writerIsDepth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                                 : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = use.stages;
+        dependency.dstAccessMask = accessOf(use.usage);
+        dependency.dependencyFlags = use.usage == USAGE::SAMPLED ? 0 : VK_DEPENDENCY_BY_REGION_BIT;
+        auto existing = std::find_if(dependencies.begin(), dependencies.end(), [&](const VkSubpassDependency &d) {
+          return d.srcSubpass == writer && d.dstSubpass == subpass;
+        });
+        if (existing == dependencies.end()) {
+          dependencies.push_back(dependency);
+        } else {
+          existing->srcStageMask |= dependency.srcStageMask;
+          existing->srcAccessMask |= dependency.srcAccessMask;
+          existing->dstStageMask |= dependency.dstStageMask;
+          existing->dstAccessMask |= dependency.dstAccessMask;
+          existing->dependencyFlags &= dependency.dependencyFlags;
+        }
+      }
+    }
+    for (const auto &use : subpassUses[subpass]) {
+      if (isAttachment(use.usage))
+        writtenInSubpass[use.resource] = subpass;
+    }
+    for (uint32_t i = 0; i < attachmentCount; i++) {
+      if (!isReferenced[i] && firstSubpass[i] < subpass && subpass < lastSubpass[i])
+        preserved[subpass].push_back(i);
+    }
+    description.colorAttachmentCount = uint32_t(colorReferences[subpass].size());
+    description.pColorAttachments = colorReferences[subpass].data();
+    description.inputAttachmentCount = uint32_t(inputReferences[subpass].size());
+    description.pInputAttachments = inputReferences[subpass].data();
+    description.pDepthStencilAttachment =
+        _passes[batch->passes[subpass]].depthAttachment.resource.index != UINT32_MAX ? &depthReferences[subpass]
+                                                                                       : nullptr;
+    description.preserveAttachmentCount = uint32_t(preserved[subpass].size());
+    description.pPreserveAttachments = preserved[subpass].data();
+  }
+
+  VkRenderPassCreateInfo renderPassInfo = {};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = attachmentCount;
+  renderPassInfo.pAttachments = descriptions.data();
+  renderPassInfo.subpassCount = subpassCount;
+  renderPassInfo.pSubpasses = subpasses.data();
+  renderPassInfo.dependencyCount = uint32_t(dependencies.size());
+  renderPassInfo.pDependencies = dependencies.data();
+  checkResult(vkCreateRenderPass(vkContext.device, &renderPassInfo, nullptr, &batch->renderPass));
+}
+
+// Images whose batches do not overlap share a memory block, the biggest images are placed first
+void FrameGraph::createImages() {
+  std::vector<uint32_t> images;
+  for (auto &resource : _resources)
+    resource.memorySize = 0;
+  std::vector<CreateTextureInfo> textureInfos(_resources.size());
+  std::vector<VkMemoryRequirements> requirements(_resources.size());
+  for (uint32_t i = 0; i < _resources.size(); i++) {
+    auto &resource = _resources[i];
+    if (resource.type != RESOURCE_TYPE::IMAGE || resource.firstBatch > resource.lastBatch)
+      continue;
+    const auto extent = extentOf(resource);
+    auto &textureInfo = textureInfos[i];
+    textureInfo.id = resource.id;
+    textureInfo.format = resource.imageInfo.format;
+    textureInfo.size = {extent.width, extent.height, 1};
+    textureInfo.type = isDepthFormat(textureInfo.format) ? TEXTURE_TYPE::DEPTH : TEXTURE_TYPE::ATTACHMENT;
+    requirements[i] = mgSystem.textureContainer.getMemoryRequirements(textureInfo);
+    images.push_back(i);
+  }
+  std::stable_sort(images.begin(), images.end(),
+                   [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+  _memoryBlocks.clear();
+  for (const auto i : images) {
+    auto &resource = _resources[i];
+    const auto &requirement = requirements[i];
+    for (uint32_t j = 0; j < _memoryBlocks.size() && resource.memoryBlock == UINT32_MAX; j++) {
+      auto &block = _memoryBlocks[j];
+      bool fits = (block.memoryTypeBits & requirement.memoryTypeBits) != 0 && !resource.imageInfo.persistent;
+      for (const auto other : block.resources) {
+        const auto &otherResource = _resources[other];
+        fits = fits && !otherResource.imageInfo.persistent &&
+               (otherResource.lastBatch < resource.firstBatch || resource.lastBatch < otherResource.firstBatch);
+      }
+      if (fits)
+        resource.memoryBlock = j;
+    }
+    if (resource.memoryBlock == UINT32_MAX) {
+      resource.memoryBlock = uint32_t(_memoryBlocks.size());
+      _memoryBlocks.push_back({});
+      _memoryBlocks.back().memoryTypeBits = requirement.memoryTypeBits;
+    }
+    auto &block = _memoryBlocks[resource.memoryBlock];
+    block.size = std::max(block.size, requirement.size);
+    block.alignment = std::max(block.alignment, requirement.alignment);
+    block.memoryTypeBits &= requirement.memoryTypeBits;
+    block.resources.push_back(i);
+    resource.memorySize = requirement.size;
+  }
+
+  for (auto &block : _memoryBlocks) {
+    const auto memoryIndex = findMemoryTypeIndex(vkContext.physicalDeviceMemoryProperties, block.memoryTypeBits,
+                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    block.allocation =
+        mgSystem.textureDeviceMemoryAllocator.allocateDeviceOnlyMemory(memoryIndex, block.size, block.alignment);
+    for (const auto i : block.resources) {
+      _resources[i].textureId = mgSystem.textureContainer.createTexture(textureInfos[i], block.allocation);
+      _resources[i].state = {};
+    }
+  }
+}
+
+void FrameGraph::createFramebuffers(Batch *batch) {
+  bool hasSwapChain = false;
+  std::vector<VkImageView> imageViews(batch->attachments.size());
+  for (uint32_t i = 0; i < batch->attachments.size(); i++) {
+    const auto &resource = _resources[batch->attachments[i]];
+    hasSwapChain |= resource.type == RESOURCE_TYPE::SWAP_CHAIN;
+    if (resource.type != RESOURCE_TYPE::SWAP_CHAIN)
+      imageViews[i] = imageViewOf(resource);
+  }
+
+  batch->extent = extentOf(_resources[batch->attachments.front()]);
+  batch->nrOfFramebuffers = hasSwapChain ? vkContext.swapChain->numOfImages : 1;
+  for (uint32_t i = 0; i < batch->nrOfFramebuffers; i++) {
+    for (uint32_t j = 0; j < batch->attachments.size(); j++) {
+      if (_resources[batch->attachments[j]].type == RESOURCE_TYPE::SWAP_CHAIN)
+        imageViews[j] = vkContext.swapChain->imageViews[i];
+    }
+    VkFramebufferCreateInfo framebufferCreateInfo = {};
+    framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferCreateInfo.renderPass = batch->renderPass;
+    framebufferCreateInfo.attachmentCount = uint32_t(imageViews.size());
+    framebufferCreateInfo.pAttachments = imageViews.data();
+    framebufferCreateInfo.width = batch->extent.width;
+    framebufferCreateInfo.height = batch->extent.height;
+    framebufferCreateInfo.layers = 1;
+    checkResult(vkCreateFramebuffer(vkContext.device, &framebufferCreateInfo, nullptr, &batch->framebuffers[i]));
+  }
+}
+
+void FrameGraph::compile() {
+  mgAssert(!_isCompiled);
+  cullPasses();
+  createBatches();
+  createImages();
+  for (auto &batch : _batches) {
+    if (!batch.isRaster)
+      continue;
+    createRenderPass(&batch);
+    createFramebuffers(&batch);
+  }
+  _isCompiled = true;
+
+  VkDeviceSize unaliasedSize = 0;
+  for (const auto &resource : _resources)
+    unaliasedSize += resource.memorySize;
+  LOG("Frame graph: " << _passes.size() << " passes, " << nrOfCulledPasses() << " culled, " << nrOfRenderPasses()
+                      << " render passes, " << transientMemorySize() / (1024 * 1024) << " MB transient memory, "
+                      << unaliasedSize / (1024 * 1024) << " MB without aliasing");
+}
+
+void FrameGraph::destroyFramebuffers() {
+  for (auto &batch : _batches) {
+    for (uint32_t i = 0; i < batch.nrOfFramebuffers; i++)
+      vkDestroyFramebuffer(vkContext.device, batch.framebuffers[i], nullptr);
+    batch.nrOfFramebuffers = 0;
+  }
+}
+
+void FrameGraph::destroyImages() {
+  for (auto &resource : _resources) {
+    if (resource.type == RESOURCE_TYPE::IMAGE && resource.memoryBlock != UINT32_MAX) {
+      mg::removeTexture(resource.textureId);
+      resource.memoryBlock = UINT32_MAX;
+    }
+  }
+  for (const auto &block : _memoryBlocks)
+    mgSystem.textureDeviceMemoryAllocator.freeDeviceOnlyMemory(block.allocation);
+  _memoryBlocks.clear();
+}
+
+// the render passes only depend on the formats, they survive the resize
+void FrameGraph::resize() {
+  mgAssert(_isCompiled);
+  destroyFramebuffers();
+  destroyImages();
+  createImages();
+  for (auto &batch : _batches) {
+    if (batch.isRaster)
+      createFramebuffers(&batch);
+  }
+}
+
+void FrameGraph::destroy() {
+  if (!_isCompiled)
+    return;
+  destroyFramebuffers();
+  destroyImages();
+  for (const auto &batch : _batches) {
+    if (batch.renderPass)
+      vkDestroyRenderPass(vkContext.device, batch.renderPass, nullptr);
+  }
+  _batches.clear();
+  _passes.clear();
+  _resources.clear();
+  _isPassAlive.clear();
+  _isCompiled = false;
+}
+
+// Adds what the next access needs to barrier: every earlier access before a write or a layout transition, the last
+// write before a read from a stage it has not been made visible to yet. discard drops the content, an image that
+// shares memory then also waits for the image that used the memory before it.
+void FrameGraph::use(uint32_t resourceIndex, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access,
+                     bool discard, Barrier *barrier) {
+  auto &resource = _resources[resourceIndex];
+  auto &state = resource.state;
+  const bool isImage = resource.type != RESOURCE_TYPE::BUFFER;
+  const bool isWriteAccess = (access & WRITE_ACCESS) != 0;
+
+  ResourceState previous = state;
+  if (discard && resource.memoryBlock != UINT32_MAX) {
+    auto &block = _memoryBlocks[resource.memoryBlock];
+    if (block.lastResource != UINT32_MAX && block.lastResource != resourceIndex)
+      previous = _resources[block.lastResource].state;
+    block.lastResource = resourceIndex;
+  }
+  const auto oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : previous.layout;
+  const bool isTransition = isImage && (discard || oldLayout != layout);
+
+  VkPipelineStageFlags srcStages = 0;
+  VkAccessFlags srcAccess = 0;
+  bool needsBarrier = false;
+  if (isWriteAccess || isTransition) {
+    srcStages = previous.writeStages | previous.readStages;
+    srcAccess = previous.writeAccess;
+    needsBarrier = srcStages != 0 || isTransition;
+  } else if (previous.writeStages && (stages & ~previous.visibleStages)) {
+    srcStages = previous.writeStages;
+    srcAccess = previous.writeAccess;
+    needsBarrier = true;
+  }
+
+  if (needsBarrier) {
+    barrier->srcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    barrier->dstStages |= stages;
+    if (isTransition) {
+      VkImageMemoryBarrier imageBarrier = {};
+      imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      imageBarrier.srcAccessMask = srcAccess;
+      imageBarrier.dstAccessMask = access;
+      imageBarrier.oldLayout = oldLayout;
+      imageBarrier.newLayout = layout;
+      imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      imageBarrier.image = imageOf(resource);
+      imageBarrier.subresourceRange = {
+          VkImageAspectFlags(isDepth(resource) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT), 0, 1, 0, 1};
+      barrier->imageBarriers.push_back(imageBarrier);
+    } else {
+      barrier->memoryBarrier.srcAccessMask |= srcAccess;
+      barrier->memoryBarrier.dstAccessMask |= access;
+    }
+  }
+
+  if (isWriteAccess || isTransition) {
+    // a layout transition is a write that the stages of this access wait for
+    state.writeStages = stages;
+    state.writeAccess = access & WRITE_ACCESS;
+    state.readStages = isWriteAccess ? 0 : stages;
+    state.visibleStages = isWriteAccess ? 0 : stages;
+  } else {
+    state.readStages |= stages;
+    state.visibleStages |= stages;
+  }
+  state.layout = layout;
+}
+
+void FrameGraph::executePass(uint32_t passIndex, const RenderContext &renderContext, GpuTimer *gpuTimer) {
+  if (gpuTimer)
+    gpuTimer->begin(_passes[passIndex].id.c_str());
+  _passes[passIndex].execute(renderContext);
+  if (gpuTimer)
+    gpuTimer->end();
+}
+
+void FrameGraph::recordBatch(const Batch &batch, const RenderContext &renderContext, GpuTimer *gpuTimer) {
+  const auto batchIndex = uint32_t(&batch - _batches.data());
+  // recording runs every frame, its temporaries come from the scratch arena instead of the heap
+  ScratchScope scratch;
+  Barrier barrier(&scratch.arena());
+  barrier.imageBarriers.reserve(_resources.size());
+  ArenaVector<PassUse> uses{ArenaAllocator<PassUse>(&scratch.arena())};
+  auto isAttachmentOfBatch = scratch.allocate<bool>(_resources.size());
+  std::fill_n(isAttachmentOfBatch, _resources.size(), false);
+  for (const auto resource : batch.attachments)
+    isAttachmentOfBatch[resource] = true;
+
+  // the first use of every attachment, the render pass starts in the layout it is referenced with first
+  for (uint32_t i = 0; i < batch.attachments.size(); i++) {
+    const auto resourceIndex = batch.attachments[i];
+    VkPipelineStageFlags stages = 0;
+    VkAccessFlags access = 0;
+    bool discard = false;
+    for (const auto passIndex : batch.passes) {
+      uses.clear();
+      appendUsesOf(_passes[passIndex], &uses);
+      for (const auto &use : uses) {
+        if (use.resource != resourceIndex || stages)
+          continue;
+        stages = use.stages;
+        access = accessOf(use.usage);
+        const auto &resource = _resources[resourceIndex];
+        const bool hasFrameContent = resource.type == RESOURCE_TYPE::IMPORTED_TEXTURE || resource.imageInfo.persistent;
+        discard = use.clear || (!hasFrameContent && resource.firstBatch == batchIndex);
+      }
+    }
+    use(resourceIndex, batch.initialLayouts[i], stages, access, discard, &barrier);
+  }
+  for (const auto passIndex : batch.passes) {
+    uses.clear();
+    appendUsesOf(_passes[passIndex], &uses);
+    for (const auto &passUse : uses) {
+      if (isAttachmentOfBatch[passUse.resource])
+        continue;
+      const auto &resource = _resources[passUse.resource];
+      const bool discard = isTransient(resource) && resource.firstBatch == batchIndex &&
+                           passUse.usage == USAGE::STORAGE_WRITE;
+      use(passUse.resource, layoutOf(passUse.usage), passUse.stages, accessOf(passUse.usage), discard, &barrier);
+    }
+  }
+
+  const auto commandBuffer = vkContext.commandBuffer;
+  if (barrier.dstStages) {
+    barrier.memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    const bool hasMemoryBarrier = barrier.memoryBarrier.srcAccessMask || barrier.memoryBarrier.dstAccessMask;
+    vkCmdPipelineBarrier(commandBuffer, barrier.srcStages, barrier.dstStages, 0, hasMemoryBarrier ? 1 : 0,
+                         &barrier.memoryBarrier, 0, nullptr, uint32_t(barrier.imageBarriers.size()),
+                         barrier.imageBarriers.data());
+  }
+
+  auto passContext = renderContext;
+  if (!batch.isRaster) {
+    passContext.renderPass = VK_NULL_HANDLE;
+    passContext.subpass = 0;
+    executePass(batch.passes.front(), passContext, gpuTimer);
+    return;
+  }
+
+  const bool isScreenSized = batch.extent == VkExtent2D{vkContext.screen.width, vkContext.screen.height};
+  VkRenderPassBeginInfo renderPassBeginInfo = {};
+  renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassBeginInfo.renderPass = batch.renderPass;
+  renderPassBeginInfo.framebuffer =
+      batch.framebuffers[batch.nrOfFramebuffers > 1 ? vkContext.swapChain->currentSwapChainIndex : 0];
+  renderPassBeginInfo.renderArea.extent = batch.extent;
+  renderPassBeginInfo.clearValueCount = uint32_t(batch.clearValues.size());
+  renderPassBeginInfo.pClearValues = batch.clearValues.data();
+  vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+  if (!isScreenSized)
+    setTargetViewport(batch.extent);
+
+  passContext.renderPass = batch.renderPass;
+  for (uint32_t subpass = 0; subpass < batch.passes.size(); subpass++) {
+    if (subpass > 0)
+      vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    passContext.subpass = subpass;
+    executePass(batch.passes[subpass], passContext, gpuTimer);
+  }
+  vkCmdEndRenderPass(commandBuffer);
+  if (!isScreenSized)
+    setFullscreenViewport();
+
+  // the render pass leaves the attachments in their final layout, waiting on its output stage also waits on the
+  // reads of the subpasses before it
+  for (uint32_t i = 0; i < batch.attachments.size(); i++) {
+    auto &state = _resources[batch.attachments[i]].state;
+    const bool attachmentIsDepth = isDepth(_resources[batch.attachments[i]]);
+    state.layout = batch.finalLayouts[i];
+    state.writeStages = attachmentIsDepth ? DEPTH_STAGES : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    state.writeAccess =
+        attachmentIsDepth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    state.readStages = 0;
+    state.visibleStages = 0;
+  }
+}
+
+void FrameGraph::execute(const RenderContext &renderContext, GpuTimer *gpuTimer) {
+  mgAssert(_isCompiled);
+  for (auto &resource : _resources) {
+    // the presentation engine hands over the image at the color output stage through the acquire semaphore
+    if (resource.type == RESOURCE_TYPE::SWAP_CHAIN)
+      resource.state = {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, 0};
+  }
+  for (const auto &batch : _batches)
+    recordBatch(batch, renderContext, gpuTimer);
+
+  // imported images go back to the layout they came in, the swap chain to the presentation engine
+  ScratchScope scratch;
+  Barrier barrier(&scratch.arena());
+  for (uint32_t i = 0; i < _resources.size(); i++) {
+    const auto &resource = _resources[i];
+    if (resource.type == RESOURCE_TYPE::IMPORTED_TEXTURE && resource.state.layout != resource.importedLayout)
+      use(i, resource.importedLayout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+          VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, false, &barrier);
+    else if (resource.type == RESOURCE_TYPE::SWAP_CHAIN && resource.firstBatch <= resource.lastBatch &&
+             resource.state.layout != VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+      use(i, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, false, &barrier);
+  }
+  if (barrier.dstStages) {
+    vkCmdPipelineBarrier(vkContext.commandBuffer, barrier.srcStages, barrier.dstStages, 0, 0, nullptr, 0, nullptr,
+                         uint32_t(barrier.imageBarriers.size()), barrier.imageBarriers.data());
+  }
+}
+
+TextureId FrameGraph::getTexture(FrameGraphResourceId resourceId) const {
+  mgAssert(_isCompiled && resourceId.index < _resources.size());
+  const auto &resource = _resources[resourceId.index];
+  mgAssertDesc(resource.type != RESOURCE_TYPE::IMAGE || resource.memoryBlock != UINT32_MAX,
+               "frame graph image " << resource.id << " is not used by any pass");
+  return resource.textureId;
+}
+
+uint32_t FrameGraph::nrOfRenderPasses() const {
+  return uint32_t(std::count_if(_batches.begin(), _batches.end(), [](const Batch &batch) { return batch.isRaster; }));
+}
+
+uint32_t FrameGraph::nrOfCulledPasses() const {
+  return uint32_t(std::count(_isPassAlive.begin(), _isPassAlive.end(), false));
+}
+
+VkDeviceSize FrameGraph::transientMemorySize() const {
+  VkDeviceSize size = 0;
+  for (const auto &block : _memoryBlocks)
+    size += block.size;
+  return size;
+}
+
+} // namespace mg
@@ -0,0 +1,176 @@
+#pragma once
+#include "mg/memory.h"
+#include "mg/mgUtils.h"
+#include "mg/textureContainer.h"
+#include "vulkan/deviceAllocator.h"
+#include "vulkan/gpuTimer.h"
+#include "vulkan/swapChain.h"
+#include "vulkan/vkContext.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mg {
+
+struct RenderContext;
+
+struct FrameGraphResourceId {
+  uint32_t index = UINT32_MAX;
+};
+
+// Images created by the graph, the size is the screen size times screenScale unless size is set
+struct FrameGraphImageInfo {
+  std::string id;
+  VkFormat format;
+  float screenScale = 1.0f;
+  VkExtent2D size = {};
+  // keeps its content from one frame to the next, like a history for temporal filters, and never shares memory
+  bool persistent = false;
+};
+
+enum class FRAME_GRAPH_PASS { RASTER, COMPUTE };
+
+// How a pass uses a resource besides as a color or depth attachment
+enum class FRAME_GRAPH_ACCESS {
+  SAMPLED,          // read through a sampler or the texture descriptor set, anywhere in the image
+  INPUT_ATTACHMENT, // read at the pixel that is written
+  STORAGE_READ,
+  STORAGE_WRITE,
+  VERTEX,   // vertex or index buffer
+  INDIRECT, // draw or dispatch arguments
+};
+
+struct FrameGraphAttachment {
+  FrameGraphResourceId resource;
+  bool clear = true; // loads the content otherwise
+  VkClearValue clearValue = {};
+};
+
+struct FrameGraphUse {
+  FrameGraphResourceId resource;
+  FRAME_GRAPH_ACCESS access;
+  VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+};
+
+struct FrameGraphPassInfo {
+  std::string id;
+  FRAME_GRAPH_PASS type = FRAME_GRAPH_PASS::RASTER;
+  std::vector<FrameGraphAttachment> colorAttachments;
+  FrameGraphAttachment depthAttachment; // no depth attachment while the resource is not set
+  std::vector<FrameGraphUse> uses;
+  // a pass is culled when nothing reads what it writes and it writes no imported resource
+  bool hasSideEffects = false;
+  // renderContext.renderPass and subpass are set for raster passes
+  std::function<void(const RenderContext &renderContext)> execute;
+};
+
+// Passes are added in execution order and declare what they read and write. compile() culls the passes that
+// contribute nothing, merges consecutive raster passes with the same size into subpasses of one render pass, places
+// transient images whose lifetimes do not overlap in the same memory and derives the barriers, layout transitions,
+// load and store ops. The declaration is kept over a resize, only the images and framebuffers are recreated.
+class FrameGraph : mg::nonCopyable {
+public:
+  FrameGraphResourceId createImage(const FrameGraphImageInfo &imageInfo);
+  // the current swap chain image, it is presented after the frame
+  FrameGraphResourceId importSwapChain();
+  // a texture owned by someone else, it is in layout before and after the frame
+  FrameGraphResourceId importTexture(TextureId textureId, VkImageLayout layout);
+  FrameGraphResourceId importBuffer(const std::string &id, VkBuffer buffer);
+  void addPass(const FrameGraphPassInfo &passInfo);
+
+  void compile();
+  void resize();
+  // gpuTimer times every pass under its id
+  void execute(const RenderContext &renderContext, GpuTimer *gpuTimer = nullptr);
+  void destroy();
+
+  TextureId getTexture(FrameGraphResourceId resourceId) const;
+  uint32_t nrOfRenderPasses() const;
+  uint32_t nrOfCulledPasses() const;
+  VkDeviceSize transientMemorySize() const;
+
+  ~FrameGraph();
+
+private:
+  enum class RESOURCE_TYPE { IMAGE, SWAP_CHAIN, IMPORTED_TEXTURE, BUFFER };
+
+  struct ResourceState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags writeStages = 0;
+    VkAccessFlags writeAccess = 0;
+    VkPipelineStageFlags readStages = 0;   // read since the last write
+    VkPipelineStageFlags visibleStages = 0; // the last write has been made visible to
+  };
+
+  struct Resource {
+    std::string id;
+    RESOURCE_TYPE type;
+    FrameGraphImageInfo imageInfo;
+    TextureId textureId;
+    VkBuffer buffer;
+    VkImageLayout importedLayout;
+    uint32_t memoryBlock = UINT32_MAX;
+    VkDeviceSize memorySize = 0; // without aliasing
+    uint32_t firstBatch, lastBatch; // lifetime in batches, firstBatch > lastBatch when it is unused
+    ResourceState state;
+  };
+
+  // a render pass with one subpass per raster pass, or one compute pass
+  struct Batch {
+    std::vector<uint32_t> passes;
+    bool isRaster;
+    VkExtent2D extent;
+    std::vector<uint32_t> attachments; // resources
+    std::vector<VkClearValue> clearValues;
+    std::vector<VkImageLayout> initialLayouts, finalLayouts;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffers[MAX_SWAP_CHAIN_IMAGES] = {};
+    uint32_t nrOfFramebuffers = 0;
+  };
+
+  struct MemoryBlock {
+    DeviceHeapAllocation allocation;
+    VkDeviceSize size, alignment;
+    uint32_t memoryTypeBits;
+    std::vector<uint32_t> resources;
+    uint32_t lastResource = UINT32_MAX; // used the memory last, its accesses are waited on before the next
+  };
+
+  // lives in the scratch arena of the frame it is recorded in
+  struct Barrier {
+    explicit Barrier(Arena *arena) : imageBarriers(ArenaAllocator<VkImageMemoryBarrier>(arena)) {}
+
+    VkPipelineStageFlags srcStages = 0, dstStages = 0;
+    VkMemoryBarrier memoryBarrier = {};
+    ArenaVector<VkImageMemoryBarrier> imageBarriers;
+  };
+
+  void cullPasses();
+  void createBatches();
+  void createRenderPass(Batch *batch);
+  void createImages();
+  void createFramebuffers(Batch *batch);
+  void destroyImages();
+  void destroyFramebuffers();
+
+  VkExtent2D extentOf(const Resource &resource) const;
+  VkImage imageOf(const Resource &resource) const;
+  VkImageView imageViewOf(const Resource &resource) const;
+  VkFormat formatOf(const Resource &resource) const;
+  bool isDepth(const Resource &resource) const;
+  bool isTransient(const Resource &resource) const;
+
+  void use(uint32_t resourceIndex, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access,
+           bool discard, Barrier *barrier);
+  void recordBatch(const Batch &batch, const RenderContext &renderContext, GpuTimer *gpuTimer);
+  void executePass(uint32_t passIndex, const RenderContext &renderContext, GpuTimer *gpuTimer);
+
+  std::vector<Resource> _resources;
+  std::vector<FrameGraphPassInfo> _passes;
+  std::vector<bool> _isPassAlive;
+  std::vector<Batch> _batches;
+  std::vector<MemoryBlock> _memoryBlocks;
+  bool _isCompiled = false;
+};
+
+} // namespace mg
@@ -0,0 +1,94 @@
+#include "gpuTimer.h"
+
+#include "mg/mgAssert.h"
+#include "vkUtils.h"
+#include <cstdio>
+#include <cstring>
+
+namespace mg {
+
+void GpuTimer::create(uint32_t maxNrOfSections) {
+  mgAssert(_queryPool == VK_NULL_HANDLE);
+  if (!vkContext.physicalDeviceProperties.limits.timestampComputeAndGraphics)
+    return;
+  _maxNrOfSections = maxNrOfSections;
+  for (auto &sections : _sections)
+    sections.reserve(maxNrOfSections);
+  _openSections.reserve(maxNrOfSections);
+  _timestamps.resize(2 * maxNrOfSections);
+  _timings.reserve(maxNrOfSections);
+
+  VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+  queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryPoolCreateInfo.queryCount = 2 * maxNrOfSections * MAX_FRAMES_IN_FLIGHT;
+  checkResult(vkCreateQueryPool(vkContext.device, &queryPoolCreateInfo, nullptr, &_queryPool));
+}
+
+void GpuTimer::destroy() {
+  if (_queryPool)
+    vkDestroyQueryPool(vkContext.device, _queryPool, nullptr);
+  _queryPool = VK_NULL_HANDLE;
+  for (auto &sections : _sections)
+    sections.clear();
+  _timings.clear();
+}
+
+GpuTimer::~GpuTimer() { mgAssert(_queryPool == VK_NULL_HANDLE); }
+
+void GpuTimer::beginFrame() {
+  if (!_queryPool)
+    return;
+  mgAssertDesc(_openSections.empty(), "gpu timer section is not ended");
+  _frameIndex = vkContext.commandBuffers.currentIndex;
+  const uint32_t firstQuery = 2 * _maxNrOfSections * _frameIndex;
+  auto &sections = _sections[_frameIndex];
+
+  if (!sections.empty()) {
+    const auto nrOfQueries = 2 * uint32_t(sections.size());
+    const auto result = vkGetQueryPoolResults(vkContext.device, _queryPool, firstQuery, nrOfQueries,
+                                              nrOfQueries * sizeof(uint64_t), _timestamps.data(), sizeof(uint64_t),
+                                              VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+      const float nanoseconds = vkContext.physicalDeviceProperties.limits.timestampPeriod;
+      _timings.assign(sections.begin(), sections.end());
+      for (uint32_t i = 0; i < sections.size(); i++)
+        _timings[i].milliseconds = float(_timestamps[2 * i + 1] - _timestamps[2 * i]) * nanoseconds * 1e-6f;
+    }
+  }
+  sections.clear();
+  vkCmdResetQueryPool(vkContext.commandBuffer, _queryPool, firstQuery, 2 * _maxNrOfSections);
+}
+
+void GpuTimer::begin(const char *id) {
+  if (!_queryPool)
+    return;
+  auto &sections = _sections[_frameIndex];
+  mgAssertDesc(sections.size() < _maxNrOfSections, "more than " << _maxNrOfSections << " gpu timer sections");
+  _openSections.push_back(uint32_t(sections.size()));
+  vkCmdWriteTimestamp(vkContext.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool,
+                      2 * (_maxNrOfSections * _frameIndex + uint32_t(sections.size())));
+  GpuTiming section = {};
+  snprintf(section.id, sizeof(section.id), "%s", id);
+  sections.push_back(section);
+}
+
+void GpuTimer::end() {
+  if (!_queryPool)
+    return;
+  mgAssert(!_openSections.empty());
+  const auto section = _openSections.back();
+  _openSections.pop_back();
+  vkCmdWriteTimestamp(vkContext.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool,
+                      2 * (_maxNrOfSections * _frameIndex + section) + 1);
+}
+
+float GpuTimer::getMilliseconds(const char *id) const {
+  for (const auto &timing : _timings) {
+    if (strcmp(timing.id, id) == 0)
+      return timing.milliseconds;
+  }
+  return 0.0f;
+}
+
+} // namespace mg
@@ -0,0 +1,43 @@
+#pragma once
+#include "mg/mgUtils.h"
+#include "vulkan/vkContext.h"
+#include <vector>
+
+namespace mg {
+
+struct GpuTiming {
+  char id[32]; // cut to fit, so a section costs no allocation
+  float milliseconds;
+};
+
+// Timestamps around sections of the frame. Every frame in flight has its own queries, they are read when the frame
+// slot comes around again and its fence has been waited on, so the timings are a few frames old and reading them
+// never stalls.
+class GpuTimer : mg::nonCopyable {
+public:
+  void create(uint32_t maxNrOfSections);
+  void destroy();
+
+  // after beginRendering and outside of a render pass
+  void beginFrame();
+  void begin(const char *id);
+  void end();
+
+  // the sections of the last frame whose timings are back, empty when the queue can not write timestamps
+  const std::vector<GpuTiming> &getTimings() const { return _timings; }
+  float getMilliseconds(const char *id) const;
+
+  ~GpuTimer();
+
+private:
+  VkQueryPool _queryPool = VK_NULL_HANDLE;
+  uint32_t _maxNrOfSections = 0;
+  uint32_t _frameIndex = 0;
+  // every vector has room for maxNrOfSections from create on
+  std::vector<GpuTiming> _sections[MAX_FRAMES_IN_FLIGHT];
+  std::vector<uint32_t> _openSections;
+  std::vector<uint64_t> _timestamps;
+  std::vector<GpuTiming> _timings;
+};
+
+} // namespace mg
@@ -1,9 +1,13 @@
 #include "imguiOverlay.h"
 #include "mg/textureContainer.h"
 #include "pipelineContainer.h"
+#include "shaders/imgui.h"
+#include "swapChain.h"
 #include "rendering/rendering.h"
 #include "vkUtils.h"
 
+#include "mg/framePacing.h"
+#include "mg/memory.h"
 #include "mg/mgSystem.h"
 #include "mg/tools.h"
 #include "mg/window.h"
@@ -214,7 +218,7 @@ void Imgui::drawUI(const mg::FrameData &frameData) const {
   io.MouseDown[0] = frameData.mouse.left;
 
   ImGui::NewFrame();
-  enum class MenuIems { Allocations, Console };
+  enum class MenuIems { Allocations, FramePacing, Console };
   static MenuIems menuIem = MenuIems::Allocations;
 
   if (ImGui::Begin("Mongoose", nullptr, {1024.0f, 512.0f}, -1.0f,
@@ -223,6 +227,9 @@ void Imgui::drawUI(const mg::FrameData &frameData) const {
       if (ImGui::Button("Allocations")) {
         menuIem = MenuIems::Allocations;
       }
+      if (ImGui::Button("Frame pacing")) {
+        menuIem = MenuIems::FramePacing;
+      }
       if (ImGui::Button("Console")) {
         menuIem = MenuIems::Console;
       }
@@ -233,6 +240,9 @@ void Imgui::drawUI(const mg::FrameData &frameData) const {
     case MenuIems::Allocations:
       drawAllocations();
       break;
+    case MenuIems::FramePacing:
+      drawFramePacing();
+      break;
     case MenuIems::Console:
       drawLog();
       break;
@@ -257,6 +267,33 @@ void Imgui::drawLog() const {
   ImGui::EndChild();
 }
 
+void Imgui::drawFramePacing() const {
+  const auto timings = mg::getFrameTimings();
+  const auto &framePacing = mg::vkContext.framePacing;
+  ImGui::Separator();
+  ImGui::Text("Frames in flight: %u, swap chain images: %u", framePacing.framesInFlight,
+              mg::vkContext.swapChain->numOfImages);
+  ImGui::Text("Frame time: %.2f ms, average %.2f ms, deviation %.2f ms, max %.2f ms over %u frames",
+              timings.frameTimeMs, timings.averageFrameTimeMs, timings.frameTimeDeviationMs, timings.maxFrameTimeMs,
+              timings.nrOfSamples);
+  ImGui::Text("Gpu wait: %.2f ms, limiter sleep: %.2f ms", timings.gpuWaitMs, timings.limiterSleepMs);
+  ImGui::Text("Input to gpu complete: %.2f ms", timings.inputToGpuCompleteMs);
+  ImGui::Separator();
+
+  ImGui::Text("Present mode (%s):", mg::presentModeName(framePacing.presentMode));
+  for (const auto presentMode : {mg::PRESENT_MODE::FIFO, mg::PRESENT_MODE::MAILBOX, mg::PRESENT_MODE::IMMEDIATE}) {
+    ImGui::SameLine();
+    if (ImGui::Button(mg::presentModeName(presentMode)))
+      mg::setPresentMode(presentMode);
+  }
+  int maxFps = int(framePacing.maxFps);
+  if (ImGui::SliderInt("Max fps (0 no limit)", &maxFps, 0, 240))
+    mg::setMaxFps(uint32_t(maxFps));
+  bool waitForGpuBeforeInput = framePacing.waitForGpuBeforeInput;
+  if (ImGui::Checkbox("Wait for gpu before input", &waitForGpuBeforeInput))
+    mg::vkContext.framePacing.waitForGpuBeforeInput = waitForGpuBeforeInput;
+}
+
 enum class TYPE { FIRST_FIT, LINEAR };
 static void drawAllocation(const GuiAllocation guiElement, const char *title, TYPE type) {
   ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 2));
@@ -306,6 +343,16 @@ static void drawAllocation(const GuiAllocation guiElement, const char *title, TY
 }
 
 void Imgui::drawAllocations() const {
+  {
+    const auto memoryStats = mg::getMemoryStats();
+    ImGui::Separator();
+    if (memoryStats.isCountingHeapAllocations)
+      ImGui::Text("Heap allocations last frame: %llu", (unsigned long long)memoryStats.heapAllocations);
+    else
+      ImGui::Text("Heap allocations are counted when the executable links mg-heap-counter");
+    ImGui::Text("Frame arena: %.1f / %.1f KB, %u overflows", memoryStats.frameArenaUsed / 1024.0f,
+                memoryStats.frameArenaCapacity / 1024.0f, memoryStats.frameArenaOverflows);
+  }
   ImGui::Separator();
   ImGui::Text("Device only first fit allocations:");
   ImGui::Separator();
@@ -22,6 +22,7 @@ private:
   void drawUI(const FrameData &frameData) const;
   void drawLog() const;
   void drawAllocations() const;
+  void drawFramePacing() const;
 
   mg::TextureId _fontId;
 
@@ -23,6 +23,8 @@ static constexpr struct {
 
 namespace mg {
 
+static uint32_t nrOfFrameBuffers() { return mg::vkContext.commandBuffers.nrOfBuffers; }
+
 static mg::_Buffer _createLinearBuffer(uint32_t bufferSizeInBytes, VkBufferUsageFlags vkBufferUsageFlags,
                                        VkMemoryPropertyFlags requiredProperties,
                                        VkMemoryPropertyFlags preferredProperties) {
@@ -33,13 +35,13 @@ static mg::_Buffer _createLinearBuffer(uint32_t bufferSizeInBytes, VkBufferUsage
   vkBufferCreateInfo.usage = vkBufferUsageFlags;
   vkBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // buffer is exclusive to a single queue family at a time.
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     checkResult(vkCreateBuffer(mg::vkContext.device, &vkBufferCreateInfo, nullptr, &buffer.bufferViews[i].vkBuffer));
   }
 
   // validation gives a warning if vkGetBufferMemoryRequirements has not been called on all buffers
   VkMemoryRequirements vkMemoryRequirements = {};
-  for (uint32_t i = 0; i < NrOfBuffers; i++)
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++)
     vkGetBufferMemoryRequirements(mg::vkContext.device, buffer.bufferViews[i].vkBuffer, &vkMemoryRequirements);
 
   // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT is not cached and does not need be flushed
@@ -51,19 +53,19 @@ static mg::_Buffer _createLinearBuffer(uint32_t bufferSizeInBytes, VkBufferUsage
 
   VkMemoryAllocateInfo vkMemoryAllocateInfo = {};
   vkMemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  vkMemoryAllocateInfo.allocationSize = alignedSize * NrOfBuffers;
+  vkMemoryAllocateInfo.allocationSize = alignedSize * nrOfFrameBuffers();
   vkMemoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
 
   checkResult(vkAllocateMemory(mg::vkContext.device, &vkMemoryAllocateInfo, nullptr, &buffer.deviceMemory));
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++)
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++)
     checkResult(
         vkBindBufferMemory(mg::vkContext.device, buffer.bufferViews[i].vkBuffer, buffer.deviceMemory, alignedSize * i));
 
   void *data = nullptr;
   checkResult(vkMapMemory(mg::vkContext.device, buffer.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data));
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     buffer.bufferViews[i].data = (char *)data + alignedSize * i;
     buffer.bufferViews[i].offset = 0;
   }
@@ -72,7 +74,7 @@ static mg::_Buffer _createLinearBuffer(uint32_t bufferSizeInBytes, VkBufferUsage
 
 static void destroyLinearBuffer(mg::_Buffer *dynamicBuffer) {
   vkUnmapMemory(mg::vkContext.device, dynamicBuffer->deviceMemory);
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     vkDestroyBuffer(mg::vkContext.device, dynamicBuffer->bufferViews[i].vkBuffer, nullptr);
     dynamicBuffer->bufferViews[i].vkBuffer = VK_NULL_HANDLE;
   }
@@ -87,7 +89,7 @@ static _UniformBuffer createUniformBuffer(VkDeviceSize bufferSizeInBytes, VkMemo
   dynamicUniformBuffer.buffer = _createLinearBuffer(uniformBufferSizeInBytes, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                                     requiredProperties, preferredProperties);
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     VkDescriptorBufferInfo vkDescriptorBufferInfo = {};
     vkDescriptorBufferInfo.buffer = dynamicUniformBuffer.buffer.bufferViews[i].vkBuffer;
     vkDescriptorBufferInfo.range = VK_WHOLE_SIZE;
@@ -112,7 +114,7 @@ static _StorageBuffer createStorageBuffers(VkDeviceSize bufferSizeInBytes, VkMem
   dynamicStorageBuffer.buffer = _createLinearBuffer(storageBufferSizeInBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                                                     requiredProperties, preferredProperties);
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     VkDescriptorBufferInfo vkDescriptorBufferInfo = {};
     vkDescriptorBufferInfo.buffer = dynamicStorageBuffer.buffer.bufferViews[i].vkBuffer;
     vkDescriptorBufferInfo.range = VK_WHOLE_SIZE;
@@ -277,11 +279,10 @@ void LinearHeapAllocator::create() {
   VkDescriptorSetAllocateInfo vkDescriptorSetAllocateInfo = {};
   vkDescriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   vkDescriptorSetAllocateInfo.descriptorPool = mg::vkContext.descriptorPool;
-  vkDescriptorSetAllocateInfo.descriptorSetCount = NrOfBuffers;
   vkDescriptorSetAllocateInfo.pSetLayouts = &mg::vkContext.descriptorSetLayout.dynamic;
   vkDescriptorSetAllocateInfo.descriptorSetCount = 1;
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     vkAllocateDescriptorSets(mg::vkContext.device, &vkDescriptorSetAllocateInfo, &_vkDescriptorSets[i]);
   }
 
@@ -294,7 +295,7 @@ void LinearHeapAllocator::create() {
   VkCommandBufferAllocateInfo vkCommandBufferAllocateInfo = {};
   vkCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   vkCommandBufferAllocateInfo.commandPool = mg::vkContext.commandPool;
-  vkCommandBufferAllocateInfo.commandBufferCount = 2;
+  vkCommandBufferAllocateInfo.commandBufferCount = nrOfFrameBuffers();
   vkCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
   checkResult(
@@ -308,7 +309,7 @@ void LinearHeapAllocator::create() {
   VkFenceCreateInfo vkFenceCreateInfo = {};
   vkFenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
   vkFenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-  for (uint32_t i = 0; i < NrOfBuffers; i++)
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++)
     checkResult(vkCreateFence(mg::vkContext.device, &vkFenceCreateInfo, nullptr, &_stagingBuffer.vkFences[i]));
 }
 
@@ -318,7 +319,7 @@ void LinearHeapAllocator::destroy() {
   destroyLinearBuffer(&_stagingBuffer.buffer);
   destroyLinearBuffer(&_storageBuffer.buffer);
 
-  for (uint32_t i = 0; i < NrOfBuffers; i++) {
+  for (uint32_t i = 0; i < nrOfFrameBuffers(); i++) {
     vkDestroyFence(mg::vkContext.device, _stagingBuffer.vkFences[i], nullptr);
     _stagingBuffer.vkFences[i] = VK_NULL_HANDLE;
   }
@@ -379,7 +380,7 @@ void LinearHeapAllocator::swapLinearHeapBuffers() {
   _stagingBuffer.buffer.bufferViews[_currentBufferIndex].offset = 0;
   _storageBuffer.buffer.bufferViews[_currentBufferIndex].offset = 0;
 
-  _currentBufferIndex = (_currentBufferIndex + 1) % NrOfBuffers;
+  _currentBufferIndex = (_currentBufferIndex + 1) % nrOfFrameBuffers();
 }
 
 std::vector<GuiAllocation> LinearHeapAllocator::getAllocationForGUI() {
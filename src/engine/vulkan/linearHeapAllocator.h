@@ -5,7 +5,8 @@
 
 namespace mg {
 
-enum { NrOfBuffers = 2 };
+// one buffer per frame in flight, the arrays are sized for the most frames in flight
+enum { NrOfBuffers = MAX_FRAMES_IN_FLIGHT };
 
 struct _Buffer {
   VkDeviceMemory deviceMemory;
@@ -6,7 +6,10 @@
 #include "singleRenderpass.h"
 #include "vkContext.h"
 #include "vkUtils.h"
+#include "mg/logger.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -87,7 +90,7 @@ PipelineStateDesc &PipelineStateDesc::operator=(const PipelineStateDesc &other)
   return *this;
 }
 
-static Pipeline _createPipeline(const _PipelineDesc &pipelineDesc) {
+static VkResult createGraphicsPipeline(const _PipelineDesc &pipelineDesc, const Shader &shader, Pipeline *pipeline) {
   VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
   VkPipelineRasterizationStateCreateInfo rasterizationState = {};
   std::array<VkPipelineColorBlendAttachmentState, 5> blendAttachmentState = {};
@@ -165,8 +168,6 @@ static Pipeline _createPipeline(const _PipelineDesc &pipelineDesc) {
   pipelineCreateInfo.renderPass = pipelineDesc.state.rasterization.vkRenderPass;
   pipelineCreateInfo.subpass = pipelineDesc.state.rasterization.graphics.subpass;
 
-  const auto shader = mg::getShader(pipelineDesc.shaderName);
-
   VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
   vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
@@ -205,24 +206,88 @@ static Pipeline _createPipeline(const _PipelineDesc &pipelineDesc) {
   pipelineCreateInfo.stageCount = shader.count;
   pipelineCreateInfo.pStages = shader.stageCreateInfo;
 
-  Pipeline pipeline = {};
-  pipeline.layout = pipelineDesc.state.rasterization.vkPipelineLayout;
+  pipeline->layout = pipelineDesc.state.rasterization.vkPipelineLayout;
+  return vkCreateGraphicsPipelines(mg::vkContext.device, mg::vkContext.pipelineCache, 1, &pipelineCreateInfo, nullptr,
+                                   &pipeline->pipeline);
+}
 
-  checkResult(vkCreateGraphicsPipelines(mg::vkContext.device, mg::vkContext.pipelineCache, 1, &pipelineCreateInfo,
-                                        nullptr, &pipeline.pipeline));
-  return pipeline;
+static VkResult createComputePipeline(const _PipelineDesc &pipelineDesc, const Shader &shader, Pipeline *pipeline) {
+  VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
+  shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shaderStageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  mgAssert(shader.count == 1);
+  shaderStageCreateInfo.module = shader.stageCreateInfo[0].module;
+  shaderStageCreateInfo.pName = "main";
+
+  VkComputePipelineCreateInfo pipelineCreateInfo = {};
+  pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineCreateInfo.stage = shaderStageCreateInfo;
+  pipelineCreateInfo.layout = pipelineDesc.state.compute.pipelineLayout;
+
+  pipeline->layout = pipelineDesc.state.compute.pipelineLayout;
+  return vkCreateComputePipelines(vkContext.device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr,
+                                  &pipeline->pipeline);
 }
 
-void PipelineContainer::createPipelineContainer() { mg::createShaders(); }
+static VkResult createRayTracingPipeline(const _PipelineDesc &pipelineDesc, const Shader &shader, Pipeline *pipeline) {
+  const auto &fToI = shader.fileNameToIndex;
+  const auto &rayTracing = pipelineDesc.state.rayTracing;
+  enum { MAX_SHADER_STAGES = 10 };
+  VkPipelineShaderStageCreateInfo shaderStageCreateInfo[MAX_SHADER_STAGES];
+  mgAssert(MAX_SHADER_STAGES >= rayTracing.shaderCount);
+  for (uint32_t i = 0; i < rayTracing.shaderCount; i++) {
+    const auto shaderIndex = fToI.at(rayTracing.shaders[i]);
+    mgAssert(shaderIndex < shader.count);
+    shaderStageCreateInfo[i] = shader.stageCreateInfo[shaderIndex];
+  }
+
+  VkRayTracingPipelineCreateInfoNV rayPipelineInfo{};
+  rayPipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_NV;
+  rayPipelineInfo.stageCount = rayTracing.shaderCount;
+  rayPipelineInfo.pStages = shaderStageCreateInfo;
+  rayPipelineInfo.pGroups = rayTracing.groups;
+  rayPipelineInfo.groupCount = rayTracing.groupCount;
+  rayPipelineInfo.layout = rayTracing.pipelineLayout;
+  rayPipelineInfo.maxRecursionDepth = 1;
+
+  pipeline->layout = rayTracing.pipelineLayout;
+  return nv::vkCreateRayTracingPipelinesNV(mg::vkContext.device, VK_NULL_HANDLE, 1, &rayPipelineInfo, nullptr,
+                                           &pipeline->pipeline);
+}
+
+static VkResult createPipelineOfType(PIPELINE_TYPE type, const _PipelineDesc &pipelineDesc, const Shader &shader,
+                                     Pipeline *pipeline) {
+  switch (type) {
+  case PIPELINE_TYPE::GRAPHICS:
+    return createGraphicsPipeline(pipelineDesc, shader, pipeline);
+  case PIPELINE_TYPE::COMPUTE:
+    return createComputePipeline(pipelineDesc, shader, pipeline);
+  case PIPELINE_TYPE::RAY_TRACING:
+    return createRayTracingPipeline(pipelineDesc, shader, pipeline);
+  }
+  return VK_ERROR_INITIALIZATION_FAILED;
+}
+
+void PipelineContainer::createPipelineContainer() {
+  mg::createShaders();
+  if (!_shaderWatcher.open(mg::getShaderPath(), ".spv"))
+    LOG("Could not watch " << mg::getShaderPath() << ", press R to reload the shaders");
+}
 
 PipelineContainer::~PipelineContainer() { mgAssert(_idToPipeline.empty()); }
 
 void PipelineContainer::destroyPipelineContainer() {
   waitForDeviceIdle();
-  for (auto pipelineIt : _idToPipeline) {
-    vkDestroyPipeline(mg::vkContext.device, pipelineIt.second.pipeline, nullptr);
+  if (_rebuild.valid()) {
+    for (const auto &rebuilt : _rebuild.get())
+      vkDestroyPipeline(mg::vkContext.device, rebuilt.pipeline.pipeline, nullptr);
+  }
+  destroyRetiredPipelines(true);
+  for (auto &pipelineIt : _idToPipeline) {
+    vkDestroyPipeline(mg::vkContext.device, pipelineIt.second.pipeline.pipeline, nullptr);
   }
   _idToPipeline.clear();
+  _shaderWatcher.close();
   mg::deleteShaders();
 }
 
@@ -232,16 +297,96 @@ void PipelineContainer::resetPipelineContainer() {
   createPipelineContainer();
 }
 
+void PipelineContainer::reloadChangedShaders() {
+  _frame++;
+  destroyRetiredPipelines(false);
+
+  if (_rebuild.valid()) {
+    if (_rebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return;
+    // the old pipelines can still be in command buffers that are in flight
+    const auto rebuilt = _rebuild.get();
+    for (const auto &pipeline : rebuilt) {
+      auto &entry = _idToPipeline.at(pipeline.id);
+      _retiredPipelines.push_back({entry.pipeline.pipeline, _frame});
+      entry.pipeline = pipeline.pipeline;
+    }
+    LOG("Rebuilt " << rebuilt.size() << " pipelines");
+  }
+
+  const auto changedFiles = _shaderWatcher.poll();
+  if (changedFiles.empty())
+    return;
+  const auto shaderNames = mg::reloadShaders(changedFiles);
+
+  // the worker gets copies of the descs and shaders, getShader and the map are only used by this thread
+  struct Job {
+    uint64_t id;
+    PIPELINE_TYPE type;
+    _PipelineDesc desc;
+    Shader shader;
+  };
+  std::vector<Job> jobs;
+  for (const auto &shaderName : shaderNames) {
+    const auto shader = mg::getShader(shaderName);
+    for (const auto &pipelineIt : _idToPipeline) {
+      const auto &entry = pipelineIt.second;
+      if (shaderName != entry.desc->shaderName)
+        continue;
+      // a ray tracing pipeline is kept by its scene together with its shader binding table
+      if (entry.type == PIPELINE_TYPE::RAY_TRACING) {
+        LOG("Press R to rebuild the ray tracing pipeline of " << shaderName);
+        continue;
+      }
+      jobs.push_back({pipelineIt.first, entry.type, *entry.desc, shader});
+    }
+  }
+  LOG("Reloaded " << changedFiles.size() << " shader files, rebuilding " << jobs.size() << " pipelines");
+  if (jobs.empty())
+    return;
+
+  _rebuild = std::async(std::launch::async, [jobs = std::move(jobs)] {
+    std::vector<RebuiltPipeline> rebuilt;
+    for (const auto &job : jobs) {
+      Pipeline pipeline = {};
+      const auto result = createPipelineOfType(job.type, job.desc, job.shader, &pipeline);
+      if (result == VK_SUCCESS)
+        rebuilt.push_back({job.id, pipeline});
+      else
+        LOG("Could not rebuild a pipeline of " << job.desc.shaderName << ": " << errorString(result));
+    }
+    return rebuilt;
+  });
+}
+
+void PipelineContainer::destroyRetiredPipelines(bool all) {
+  const uint64_t framesInFlight = mg::vkContext.commandBuffers.nrOfBuffers;
+  auto it = std::remove_if(std::begin(_retiredPipelines), std::end(_retiredPipelines), [&](const auto &retired) {
+    if (!all && _frame <= retired.frame + framesInFlight)
+      return false;
+    vkDestroyPipeline(mg::vkContext.device, retired.pipeline, nullptr);
+    return true;
+  });
+  _retiredPipelines.erase(it, std::end(_retiredPipelines));
+}
+
+Pipeline PipelineContainer::addPipeline(uint64_t id, PIPELINE_TYPE type, const _PipelineDesc &pipelineDesc) {
+  Pipeline pipeline = {};
+  checkResult(createPipelineOfType(type, pipelineDesc, mg::getShader(pipelineDesc.shaderName), &pipeline));
+  _idToPipeline.emplace(id, PipelineEntry{pipeline, type, std::make_shared<const _PipelineDesc>(pipelineDesc)});
+  return pipeline;
+}
+
 Pipeline PipelineContainer::createPipeline(const PipelineStateDesc &pipelineDesc,
                                            const CreatePipelineInfo &createPipelineInfo) {
   _PipelineDesc _pipelineDesc = {};
   _pipelineDesc.state = pipelineDesc;
-  mgAssert(createPipelineInfo.shaderName.size() + 1 < mg::countof(_pipelineDesc.shaderName));
+  mgAssert(strlen(createPipelineInfo.shaderName) + 1 < mg::countof(_pipelineDesc.shaderName));
   mgAssert(createPipelineInfo.vertexInputStateCount < mg::countof(_pipelineDesc.vertexInputState));
 
   const auto vertexInputState = createPipelineInfo.vertexInputState;
 
-  strncpy(_pipelineDesc.shaderName, createPipelineInfo.shaderName.c_str(), sizeof(_pipelineDesc.shaderName));
+  strncpy(_pipelineDesc.shaderName, createPipelineInfo.shaderName, sizeof(_pipelineDesc.shaderName) - 1);
   _pipelineDesc.vertexInputStateCount = createPipelineInfo.vertexInputStateCount;
   for (uint32_t i = 0; i < createPipelineInfo.vertexInputStateCount; i++) {
     _pipelineDesc.vertexInputState[i].binding = vertexInputState[i].binding;
@@ -256,11 +401,9 @@ Pipeline PipelineContainer::createPipeline(const PipelineStateDesc &pipelineDesc
 
   auto it = _idToPipeline.find(hashValue);
   if (it != std::end(_idToPipeline)) {
-    return it->second;
+    return it->second.pipeline;
   }
-  auto pipeline = _createPipeline(_pipelineDesc);
-  _idToPipeline.emplace(hashValue, pipeline);
-  return pipeline;
+  return addPipeline(hashValue, PIPELINE_TYPE::GRAPHICS, _pipelineDesc);
 }
 
 Pipeline PipelineContainer::createComputePipeline(const PipelineStateDesc &pipelineDesc,
@@ -268,84 +411,34 @@ Pipeline PipelineContainer::createComputePipeline(const PipelineStateDesc &pipel
 
   _PipelineDesc _pipelineDesc = {};
   _pipelineDesc.state = pipelineDesc;
-  mgAssert(createComputePipelineInfo.shaderName.size() + 1 < mg::countof(_pipelineDesc.shaderName));
-  strncpy(_pipelineDesc.shaderName, createComputePipelineInfo.shaderName.c_str(), sizeof(_pipelineDesc.shaderName));
+  mgAssert(strlen(createComputePipelineInfo.shaderName) + 1 < mg::countof(_pipelineDesc.shaderName));
+  strncpy(_pipelineDesc.shaderName, createComputePipelineInfo.shaderName, sizeof(_pipelineDesc.shaderName) - 1);
 
   auto startAdress = (const unsigned char *)((&_pipelineDesc));
   auto hashValue = hashBytes(startAdress, startAdress + sizeof(_pipelineDesc));
 
   auto it = _idToPipeline.find(hashValue);
   if (it != std::end(_idToPipeline)) {
-    return it->second;
+    return it->second.pipeline;
   }
-
-  // create new pipeline
-  const auto shader = mg::getShader(createComputePipelineInfo.shaderName);
-
-  VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
-  shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  shaderStageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-  mgAssert(shader.count == 1);
-  shaderStageCreateInfo.module = shader.stageCreateInfo[0].module;
-  shaderStageCreateInfo.pName = "main";
-
-  VkComputePipelineCreateInfo pipelineCreateInfo = {};
-  pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-  pipelineCreateInfo.stage = shaderStageCreateInfo;
-  pipelineCreateInfo.layout = pipelineDesc.compute.pipelineLayout;
-
-  Pipeline pipeline = {};
-  pipeline.layout = pipelineDesc.compute.pipelineLayout;
-  checkResult(
-      vkCreateComputePipelines(vkContext.device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline.pipeline));
-
-  _idToPipeline.emplace(hashValue, pipeline);
-  return pipeline;
+  return addPipeline(hashValue, PIPELINE_TYPE::COMPUTE, _pipelineDesc);
 }
 
 Pipeline PipelineContainer::createRayTracingPipeline(const PipelineStateDesc &pipelineDesc,
                                                      const CreateRayTracingPipelineInfo &createRayTracingPipelineInfo) {
   _PipelineDesc _pipelineDesc = {};
   _pipelineDesc.state = pipelineDesc;
-  mgAssert(createRayTracingPipelineInfo.shaderName.size() + 1 < mg::countof(_pipelineDesc.shaderName));
-  strncpy(_pipelineDesc.shaderName, createRayTracingPipelineInfo.shaderName.c_str(), sizeof(_pipelineDesc.shaderName));
+  mgAssert(strlen(createRayTracingPipelineInfo.shaderName) + 1 < mg::countof(_pipelineDesc.shaderName));
+  strncpy(_pipelineDesc.shaderName, createRayTracingPipelineInfo.shaderName, sizeof(_pipelineDesc.shaderName) - 1);
 
   auto startAdress = (const unsigned char *)((&_pipelineDesc));
   auto hashValue = hashBytes(startAdress, startAdress + sizeof(_pipelineDesc));
 
   auto it = _idToPipeline.find(hashValue);
   if (it != std::end(_idToPipeline)) {
-    return it->second;
-  }
-
-  const auto &shader = mg::getShader(createRayTracingPipelineInfo.shaderName);
-  const auto &fToI = shader.fileNameToIndex;
-  const auto &rayTracing = pipelineDesc.rayTracing;
-  enum { MAX_SHADER_STAGES = 10 };
-  VkPipelineShaderStageCreateInfo shaderStageCreateInfo[MAX_SHADER_STAGES];
-  mgAssert(MAX_SHADER_STAGES >= rayTracing.shaderCount);
-  for (uint32_t i = 0; i < rayTracing.shaderCount; i++) {
-    const auto shaderIndex = fToI.at(rayTracing.shaders[i]);
-    mgAssert(shaderIndex < shader.count);
-    shaderStageCreateInfo[i] = shader.stageCreateInfo[shaderIndex];
+    return it->second.pipeline;
   }
+  return addPipeline(hashValue, PIPELINE_TYPE::RAY_TRACING, _pipelineDesc);
+}
 
-  VkRayTracingPipelineCreateInfoNV rayPipelineInfo{};
-  rayPipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_NV;
-  rayPipelineInfo.stageCount = pipelineDesc.rayTracing.shaderCount;
-  rayPipelineInfo.pStages = shaderStageCreateInfo;
-  rayPipelineInfo.pGroups = pipelineDesc.rayTracing.groups;
-  rayPipelineInfo.groupCount = pipelineDesc.rayTracing.groupCount;
-  rayPipelineInfo.layout = pipelineDesc.rayTracing.pipelineLayout;
-  rayPipelineInfo.maxRecursionDepth = 1;
-
-  Pipeline pipeline = {};
-  pipeline.layout = pipelineDesc.rayTracing.pipelineLayout;
-  checkResult(nv::vkCreateRayTracingPipelinesNV(mg::vkContext.device, VK_NULL_HANDLE, 1, &rayPipelineInfo, nullptr,
-                                                &pipeline.pipeline));
-
-  _idToPipeline.emplace(hashValue, pipeline);
-  return pipeline;
 } // namespace mg
-
-} // namespace mg
\ No newline at end of file
@@ -3,8 +3,12 @@
 #include "shaderPipelineInput.h"
 #include "vkContext.h"
 
+#include "mg/fileWatcher.h"
 #include "mg/mgAssert.h"
+#include <future>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace mg {
 
@@ -65,19 +69,23 @@ struct Pipeline {
 };
 
 struct CreatePipelineInfo {
-  std::string shaderName;
+  const char *shaderName;
   mg::shaders::VertexInputState *vertexInputState;
   uint32_t vertexInputStateCount;
 };
 
 struct CreateComputePipelineInfo {
-  std::string shaderName;
+  const char *shaderName;
 };
 
 struct CreateRayTracingPipelineInfo {
-  std::string shaderName;
+  const char *shaderName;
 };
 
+enum class PIPELINE_TYPE { GRAPHICS, COMPUTE, RAY_TRACING };
+
+struct _PipelineDesc;
+
 class PipelineContainer : mg::nonCopyable {
 public:
   void createPipelineContainer();
@@ -90,10 +98,37 @@ public:
                                  const CreateComputePipelineInfo &createComputePipelineInfo);
   Pipeline createRayTracingPipeline(const PipelineStateDesc &pipelineDesc,
                                     const CreateRayTracingPipelineInfo &CreateRayTracingPipelineInfo);
+  // Shaders compiled again while running get new modules and the pipelines made from them are rebuilt on a worker
+  // thread, the new pipelines replace the old ones at the start of a later frame. Called by mg::startFrame.
+  // A replaced pipeline is destroyed once the frames in flight are done with it, so a Pipeline returned by the create
+  // functions must be looked up again every frame instead of being kept.
+  void reloadChangedShaders();
+
   ~PipelineContainer();
 
 private:
-  std::unordered_map<uint64_t, Pipeline> _idToPipeline;
+  struct PipelineEntry {
+    Pipeline pipeline;
+    PIPELINE_TYPE type;
+    std::shared_ptr<const _PipelineDesc> desc;
+  };
+  struct RebuiltPipeline {
+    uint64_t id;
+    Pipeline pipeline;
+  };
+  struct RetiredPipeline {
+    VkPipeline pipeline;
+    uint64_t frame;
+  };
+
+  Pipeline addPipeline(uint64_t id, PIPELINE_TYPE type, const _PipelineDesc &pipelineDesc);
+  void destroyRetiredPipelines(bool all);
+
+  std::unordered_map<uint64_t, PipelineEntry> _idToPipeline;
+  FileWatcher _shaderWatcher;
+  std::future<std::vector<RebuiltPipeline>> _rebuild;
+  std::vector<RetiredPipeline> _retiredPipelines;
+  uint64_t _frame = 0;
 };
 
 struct Pipelines {
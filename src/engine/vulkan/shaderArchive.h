@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// shaders.pack holds every compiled stage of the mg-shaders target, it is written by mg-shader-compiler --pack at build
+// time and mapped by the engine. A header, the entries sorted by file name and then the SPIR-V words, 4 byte aligned so
+// the modules are created straight from the mapped file.
+namespace mg {
+
+constexpr uint32_t shaderArchiveMagic = 0x5053474d; // MGSP
+constexpr uint32_t shaderArchiveVersion = 1;
+constexpr const char *shaderArchiveName = "shaders.pack";
+
+struct ShaderArchiveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nrOfEntries;
+  uint32_t reserved;
+};
+
+struct ShaderArchiveEntry {
+  char fileName[56];
+  uint32_t offset;
+  uint32_t size;
+};
+
+} // namespace mg
@@ -1,12 +1,17 @@
 #include "shaders.h"
 
+#include "mg/logger.h"
 #include "mg/mgAssert.h"
 #include "mg/mgUtils.h"
+#include "shaderArchive.h"
 #include "vkContext.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace mg {
 
@@ -38,83 +43,167 @@ static ShaderType getShaderType(const std::string &fileName) {
   }
 }
 
-static mg::Shaders getShaderFiles() {
-  mg::Shaders shaders = {};
+static struct {
+  MappedFile file;
+  const ShaderArchiveEntry *entries = nullptr;
+  uint32_t nrOfEntries = 0;
+} _archive;
 
-  namespace fs = std::filesystem;
-  const auto shaderPath = mg::getShaderPath();
-  for (auto &file : fs::directory_iterator(shaderPath)) {
-    const auto path = fs::path(file);
-    auto fileName = path.filename().generic_string();
-    auto nameIt = fileName.find_first_of('.');
-    auto name = fileName.substr(0, nameIt);
-    auto &fileNames = shaders.nameToShaderFiles[name];
-    const auto shaderType = getShaderType(fileName);
-    fileNames.files.push_back({fileName, shaderType.stage, shaderType.isProcedural});
-  }
+static std::string getShaderArchivePath() { return mg::getShaderPath() + shaderArchiveName; }
 
-  for (auto &files : shaders.nameToShaderFiles) {
-    std::stable_sort(std::begin(files.second.files), std::end(files.second.files),
-                     [](const auto &a, const auto &b) { return a.stageFlag < b.stageFlag; });
+static bool openShaderArchive(const std::string &archivePath) {
+  if (!_archive.file.open(archivePath))
+    return false;
+  const auto data = _archive.file.data();
+  const auto size = _archive.file.size();
+  const auto header = (const ShaderArchiveHeader *)data;
+  if (size < sizeof(ShaderArchiveHeader) || header->magic != shaderArchiveMagic ||
+      header->version != shaderArchiveVersion ||
+      size < sizeof(ShaderArchiveHeader) + sizeof(ShaderArchiveEntry) * size_t(header->nrOfEntries)) {
+    _archive.file.close();
+    return false;
   }
-  return shaders;
+  _archive.entries = (const ShaderArchiveEntry *)(data + sizeof(ShaderArchiveHeader));
+  _archive.nrOfEntries = header->nrOfEntries;
+  for (uint32_t i = 0; i < _archive.nrOfEntries; i++)
+    mgAssertDesc(size_t(_archive.entries[i].offset) + _archive.entries[i].size <= size, "corrupt " << archivePath);
+  return true;
 }
 
-static VkShaderModule loadShader(const char *fileName, VkDevice device, VkShaderStageFlagBits stageFlag) {
-  auto shaderCode = mg::readBinaryFromDisc(fileName);
-  VkShaderModule shaderModule;
-  VkShaderModuleCreateInfo moduleCreateInfo;
-  VkResult err;
+// shaders that were compiled again while running are read from the build directory, the archive has the old code
+static std::unordered_set<std::string> _changedShaders;
 
+struct ShaderFile {
+  std::string fileName;
+  const uint8_t *code;
+  uint32_t size;
+};
+
+static VkShaderModule loadShader(const ShaderFile &file, VkDevice device) {
+  VkShaderModuleCreateInfo moduleCreateInfo = {};
   moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  moduleCreateInfo.pNext = nullptr;
+  moduleCreateInfo.codeSize = file.size;
+  moduleCreateInfo.pCode = (const uint32_t *)file.code;
 
-  moduleCreateInfo.codeSize = shaderCode.size();
-  moduleCreateInfo.pCode = (uint32_t *)shaderCode.data();
-  moduleCreateInfo.flags = 0;
-  err = vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule);
+  VkShaderModule shaderModule;
+  const auto err = vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule);
   mgAssert(!err);
   return shaderModule;
 }
-static VkPipelineShaderStageCreateInfo createShader(std::string fileName, VkShaderStageFlagBits stage) {
+
+static VkPipelineShaderStageCreateInfo createShader(const ShaderFile &file, VkShaderStageFlagBits stage) {
   VkPipelineShaderStageCreateInfo shaderStage = {};
   shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   shaderStage.stage = stage;
 
-  shaderStage.module = loadShader((fileName).c_str(), mg::vkContext.device, stage);
+  shaderStage.module = loadShader(file, mg::vkContext.device);
   shaderStage.pName = "main";
   mgAssert(shaderStage.module != 0);
   return shaderStage;
 }
 
-void createShaders() {
-  const auto shaderFiles = getShaderFiles();
-  for (const auto &files : shaderFiles.nameToShaderFiles) {
-    Shader shader = {};
-    shader.name = files.first;
-    for (uint32_t i = 0; i < files.second.files.size(); i++) {
-      VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo =
-          createShader(mg::getShaderPath() + files.second.files[i].name, files.second.files[i].stageFlag);
-      shader.isProcedural[shader.count] = files.second.files[i].isProcedural;
-      shader.fileNameToIndex[files.second.files[i].name] = shader.count;
-      shader.stageCreateInfo[shader.count++] = pipelineShaderStageCreateInfo;
-    }
-    _shaders.insert(make_pair(files.first, shader));
+static Shader createShaderModules(const std::string &name, const std::vector<ShaderFile> &shaderFiles) {
+  std::vector<std::pair<const ShaderFile *, ShaderType>> files;
+  for (const auto &file : shaderFiles)
+    files.push_back({&file, getShaderType(file.fileName)});
+  std::stable_sort(std::begin(files), std::end(files),
+                   [](const auto &a, const auto &b) { return a.second.stage < b.second.stage; });
+
+  Shader shader = {};
+  shader.name = name;
+  mgAssert(files.size() <= mg::countof(shader.stageCreateInfo));
+  for (const auto &file : files) {
+    shader.isProcedural[shader.count] = file.second.isProcedural;
+    shader.fileNameToIndex[file.first->fileName] = shader.count;
+    shader.stageCreateInfo[shader.count++] = createShader(*file.first, file.second.stage);
+  }
+  return shader;
+}
+
+// the entries of a shader are the files name.*.spv, contiguous since the entries are sorted
+static Shader loadShaderFromArchive(const std::string &name) {
+  const auto prefix = name + ".";
+  const auto begin = _archive.entries, end = _archive.entries + _archive.nrOfEntries;
+  auto it = std::lower_bound(begin, end, prefix,
+                             [](const ShaderArchiveEntry &entry, const std::string &key) { return entry.fileName < key; });
+
+  std::vector<ShaderFile> files;
+  for (; it != end && strncmp(it->fileName, prefix.c_str(), prefix.size()) == 0; ++it)
+    files.push_back({it->fileName, _archive.file.data() + it->offset, it->size});
+  mgAssertDesc(!files.empty(), "no shader named " << name << " in " << getShaderArchivePath());
+  return createShaderModules(name, files);
+}
+
+static Shader loadShaderFromDirectory(const std::string &name) {
+  namespace fs = std::filesystem;
+  const auto prefix = name + ".";
+  std::vector<std::vector<uint8_t>> codes;
+  std::vector<std::string> fileNames;
+  for (auto &file : fs::directory_iterator(mg::getShaderPath())) {
+    const auto path = fs::path(file);
+    auto fileName = path.filename().generic_string();
+    if (path.extension() != ".spv" || fileName.compare(0, prefix.size(), prefix) != 0)
+      continue;
+    codes.push_back(mg::readBinaryFromDisc(path.generic_string()));
+    fileNames.push_back(fileName);
   }
+  mgAssertDesc(!codes.empty(), "no shader named " << name << " in " << mg::getShaderPath());
+
+  std::vector<ShaderFile> files;
+  for (size_t i = 0; i < codes.size(); i++)
+    files.push_back({fileNames[i], codes[i].data(), uint32_t(codes[i].size())});
+  return createShaderModules(name, files);
+}
+
+static void destroyShaderModules(const Shader &shader) {
+  for (uint32_t i = 0; i < shader.count; i++) {
+    vkDestroyShaderModule(mg::vkContext.device, shader.stageCreateInfo[i].module, nullptr);
+  }
+}
+
+void createShaders() {
+  const auto archivePath = getShaderArchivePath();
+  mgAssertDesc(openShaderArchive(archivePath), "could not open " << archivePath << ", build the mg-shaders target");
 }
 
 Shader getShader(const std::string &name) {
   auto res = _shaders.find(name);
-  mgAssert(res != _shaders.end());
+  if (res == _shaders.end()) {
+    const bool changed = _changedShaders.count(name) != 0;
+    res = _shaders.insert(std::make_pair(name, changed ? loadShaderFromDirectory(name) : loadShaderFromArchive(name)))
+              .first;
+  }
   return res->second;
 }
-void deleteShaders() {
-  for (auto &_shader : _shaders) {
-    auto shader = _shader.second;
-    for (uint32_t i = 0; i < shader.count; i++) {
-      vkDestroyShaderModule(mg::vkContext.device, shader.stageCreateInfo[i].module, nullptr);
-    }
+
+std::vector<std::string> reloadShaders(const std::vector<std::string> &fileNames) {
+  std::vector<std::string> names;
+  for (const auto &fileName : fileNames)
+    names.push_back(fileName.substr(0, fileName.find_first_of('.')));
+  std::sort(std::begin(names), std::end(names));
+  names.erase(std::unique(std::begin(names), std::end(names)), std::end(names));
+
+  std::vector<std::string> reloaded;
+  for (const auto &name : names) {
+    _changedShaders.insert(name);
+    const auto it = _shaders.find(name);
+    if (it == _shaders.end())
+      continue;
+    // the pipelines made from the old modules keep working, a module is only needed while a pipeline is created
+    destroyShaderModules(it->second);
+    it->second = loadShaderFromDirectory(name);
+    reloaded.push_back(name);
   }
+  return reloaded;
+}
+
+void deleteShaders() {
+  for (auto &shader : _shaders)
+    destroyShaderModules(shader.second);
   _shaders.clear();
+  _changedShaders.clear();
+  _archive.file.close();
+  _archive.entries = nullptr;
+  _archive.nrOfEntries = 0;
 }
 } // namespace mg
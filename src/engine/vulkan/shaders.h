@@ -5,18 +5,6 @@
 #include <vector>
 namespace mg {
 
-struct Shaders {
-  struct File {
-    std::string name;
-    VkShaderStageFlagBits stageFlag;
-    bool isProcedural;
-  };
-  struct ShaderFiles {
-    std::vector<File> files;
-  };
-  std::unordered_map<std::string, ShaderFiles> nameToShaderFiles;
-};
-
 struct Shader {
   std::string name;
   uint32_t count;
@@ -25,8 +13,13 @@ struct Shader {
   std::unordered_map<std::string, uint32_t> fileNameToIndex;
 
 };
+// maps the shader archive the build packed into the shader directory
 void createShaders();
+// creates the shader modules of name on the first call
 Shader getShader(const std::string &name);
+// the .spv files were compiled again, reads them from the shader build directory and replaces the modules of the
+// shaders that are loaded, returns their names
+std::vector<std::string> reloadShaders(const std::vector<std::string> &fileNames);
 
 void deleteShaders();
 
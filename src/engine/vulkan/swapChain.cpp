@@ -53,6 +53,26 @@ static VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatK
   return availableFormats[0];
 }
 
+static VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes,
+                                          PRESENT_MODE presentMode) {
+  auto isAvailable = [&availablePresentModes](VkPresentModeKHR mode) {
+    return std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end();
+  };
+  // immediate falls back to mailbox, both fall back to FIFO which is always supported
+  if (presentMode == PRESENT_MODE::IMMEDIATE && isAvailable(VK_PRESENT_MODE_IMMEDIATE_KHR))
+    return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  if (presentMode != PRESENT_MODE::FIFO && isAvailable(VK_PRESENT_MODE_MAILBOX_KHR))
+    return VK_PRESENT_MODE_MAILBOX_KHR;
+  return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+static uint32_t chooseMinImageCount(const VkSurfaceCapabilitiesKHR &surfaceCapabilities, uint32_t swapChainImages) {
+  // maxImageCount 0 means no limit
+  const uint32_t maxImageCount = surfaceCapabilities.maxImageCount ? surfaceCapabilities.maxImageCount : UINT32_MAX;
+  return std::min(std::max(swapChainImages, surfaceCapabilities.minImageCount),
+                  std::min(maxImageCount, MAX_SWAP_CHAIN_IMAGES - 1));
+}
+
 void SwapChain::createImageViews() {
   for (size_t i = 0; i < numOfImages; i++) {
     VkImageViewCreateInfo vkImageViewCreateInfo = {};
@@ -109,13 +129,7 @@ void SwapChain::createImages() {
   } else {
     surfaceTransform = surfaceCapabilities.currentTransform;
   }
-  // VK_PRESENT_MODE_FIFO_KHR is always supported
-  VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-  for (const auto &mode : presentModes) {
-    if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-      presentMode = mode;
-    }
-  }
+  const auto presentMode = choosePresentMode(presentModes, mg::vkContext.framePacing.presentMode);
   switch (presentMode) {
   case VK_PRESENT_MODE_FIFO_KHR:
     LOG("Using FIFO present mode");
@@ -139,7 +153,7 @@ void SwapChain::createImages() {
   VkSwapchainCreateInfoKHR createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
   createInfo.surface = mg::vkContext.windowSurface;
-  createInfo.minImageCount = 2;
+  createInfo.minImageCount = chooseMinImageCount(surfaceCapabilities, mg::vkContext.framePacing.swapChainImages);
   createInfo.imageFormat = surfaceFormat.format;
   createInfo.imageColorSpace = surfaceFormat.colorSpace;
   createInfo.imageExtent = swapChainExtent;
@@ -167,6 +181,7 @@ void SwapChain::createImages() {
   checkResult(vkGetSwapchainImagesKHR(mg::vkContext.device, swapChain, &numOfImages, nullptr));
   mgAssert(numOfImages > 0 && numOfImages < MAX_SWAP_CHAIN_IMAGES);
   checkResult(vkGetSwapchainImagesKHR(mg::vkContext.device, swapChain, &numOfImages, images));
+  vkPresentMode = presentMode;
   LOG("NumOfSwapChainImages: " << numOfImages);
 }
 
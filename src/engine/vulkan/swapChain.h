@@ -14,6 +14,8 @@ struct SwapChain {
 
   uint32_t numOfImages;
   uint32_t currentSwapChainIndex;
+  VkPresentModeKHR vkPresentMode = VK_PRESENT_MODE_FIFO_KHR; // the mode the surface gave us
+  bool recreate = false; // suboptimal for the surface, recreated after the next present
   void init();
   void resize();
   void destroy();
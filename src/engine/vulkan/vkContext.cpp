@@ -28,6 +28,9 @@ void destroyVulkan() {
   vkDestroyPipelineCache(mg::vkContext.device, mg::vkContext.pipelineCache, nullptr);
   vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayout, nullptr);
   vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayoutStorage, nullptr);
+  vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayoutStorageImage, nullptr);
+  vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayoutTexturesStorage, nullptr);
+  vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayoutStorage6, nullptr);
   vkDestroyPipelineLayout(mg::vkContext.device, mg::vkContext.pipelineLayouts.pipelineLayoutRayTracing, nullptr);
 
   vkDestroyDescriptorSetLayout(mg::vkContext.device, mg::vkContext.descriptorSetLayout.dynamic, nullptr);
@@ -225,6 +228,72 @@ static void createPipelineLayout() {
     checkResult(vkCreatePipelineLayout(mg::vkContext.device, &layoutCreateInfo, nullptr,
                                        &mg::vkContext.pipelineLayouts.pipelineLayoutStorage));
   }
+  {
+    VkDescriptorSetLayout descriptorSetLayouts[] = {
+        mg::vkContext.descriptorSetLayout.dynamic,
+        mg::vkContext.descriptorSetLayout.textures,
+        mg::vkContext.descriptorSetLayout.storageImage,
+        mg::vkContext.descriptorSetLayout.storageImage,
+    };
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = mg::countof(descriptorSetLayouts);
+    layoutCreateInfo.pSetLayouts = descriptorSetLayouts;
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+    pushConstantRange.size = 256;
+
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    layoutCreateInfo.pushConstantRangeCount = 1;
+    checkResult(vkCreatePipelineLayout(mg::vkContext.device, &layoutCreateInfo, nullptr,
+                                       &mg::vkContext.pipelineLayouts.pipelineLayoutStorageImage));
+  }
+  {
+    VkDescriptorSetLayout descriptorSetLayouts[] = {
+        mg::vkContext.descriptorSetLayout.dynamic,
+        mg::vkContext.descriptorSetLayout.textures,
+        mg::vkContext.descriptorSetLayout.storage,
+        mg::vkContext.descriptorSetLayout.storage,
+    };
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = mg::countof(descriptorSetLayouts);
+    layoutCreateInfo.pSetLayouts = descriptorSetLayouts;
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+    pushConstantRange.size = 256;
+
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    layoutCreateInfo.pushConstantRangeCount = 1;
+    checkResult(vkCreatePipelineLayout(mg::vkContext.device, &layoutCreateInfo, nullptr,
+                                       &mg::vkContext.pipelineLayouts.pipelineLayoutTexturesStorage));
+  }
+  {
+    VkDescriptorSetLayout descriptorSetLayouts[] = {
+        mg::vkContext.descriptorSetLayout.dynamic, mg::vkContext.descriptorSetLayout.storage,
+        mg::vkContext.descriptorSetLayout.storage, mg::vkContext.descriptorSetLayout.storage,
+        mg::vkContext.descriptorSetLayout.storage, mg::vkContext.descriptorSetLayout.storage,
+        mg::vkContext.descriptorSetLayout.storage,
+    };
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = mg::countof(descriptorSetLayouts);
+    layoutCreateInfo.pSetLayouts = descriptorSetLayouts;
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+    pushConstantRange.size = 256;
+
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    layoutCreateInfo.pushConstantRangeCount = 1;
+    checkResult(vkCreatePipelineLayout(mg::vkContext.device, &layoutCreateInfo, nullptr,
+                                       &mg::vkContext.pipelineLayouts.pipelineLayoutStorage6));
+  }
   // raytracing
   {
     VkDescriptorSetLayout descriptorSetLayoutsStorages[5] = {
@@ -262,7 +331,7 @@ static void createCommandPool() {
 }
 
 static void createDescriptorPool() {
-  VkDescriptorPoolSize descriptorPoolSizes[3] = {};
+  VkDescriptorPoolSize descriptorPoolSizes[5] = {};
 
   descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
   descriptorPoolSizes[0].descriptorCount = 1;
@@ -273,11 +342,17 @@ static void createDescriptorPool() {
   descriptorPoolSizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
   descriptorPoolSizes[2].descriptorCount = MAX_NR_OF_2D_TEXTURES;
 
+  descriptorPoolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  descriptorPoolSizes[3].descriptorCount = 32;
+
+  descriptorPoolSizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptorPoolSizes[4].descriptorCount = 32;
+
   VkDescriptorPoolCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   createInfo.poolSizeCount = mg::countof(descriptorPoolSizes);
   createInfo.pPoolSizes = descriptorPoolSizes;
-  createInfo.maxSets = MAX_NR_OF_2D_TEXTURES + 32;
+  createInfo.maxSets = MAX_NR_OF_2D_TEXTURES + 64;
   createInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
   checkResult(vkCreateDescriptorPool(mg::vkContext.device, &createInfo, nullptr, &mg::vkContext.descriptorPool));
@@ -364,6 +439,16 @@ static void initNvidiaFunctions() {
 }
 } // namespace nv
 
+namespace khr {
+PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR = nullptr;
+
+static void initDrawIndirectCount() {
+  if (mg::vkContext.enabledFeatures.drawIndirectCount)
+    vkCmdDrawIndexedIndirectCountKHR = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+        vkGetDeviceProcAddr(mg::vkContext.device, "vkCmdDrawIndexedIndirectCountKHR"));
+}
+} // namespace khr
+
 bool initVulkan(GLFWwindow *window) {
   if (!createVulkanContext(window))
     return false;
@@ -380,6 +465,7 @@ bool initVulkan(GLFWwindow *window) {
 
   initSampler();
   nv::initNvidiaFunctions();
+  khr::initDrawIndirectCount();
   return true;
 }
 
@@ -14,6 +14,24 @@ namespace mg {
 
 constexpr uint32_t MAX_NR_OF_2D_TEXTURES = 128;
 constexpr uint32_t MAX_NR_OF_3D_TEXTURES = 5;
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+// FIFO waits for vblank and never tears, MAILBOX replaces the queued image with the newest one for lower latency
+// without tearing, IMMEDIATE presents right away and may tear. Modes the surface lacks fall back towards FIFO.
+enum class PRESENT_MODE { FIFO, MAILBOX, IMMEDIATE };
+
+struct FramePacingSettings {
+  // frames the cpu may record ahead of the gpu, more gives throughput and costs a frame of latency each
+  uint32_t framesInFlight = 2;
+  // minimum swap chain images, clamped to what the surface supports
+  uint32_t swapChainImages = 2;
+  PRESENT_MODE presentMode = PRESENT_MODE::MAILBOX;
+  // waits for the gpu to finish the frame that used the same slot before input is polled instead of before
+  // recording, the cpu then samples input as late as possible
+  bool waitForGpuBeforeInput = false;
+  // the cpu sleeps so frames start no faster than this, 0 for no limit
+  uint32_t maxFps = 0;
+};
 
 struct SwapChain;
 
@@ -31,6 +49,12 @@ struct VulkanContext {
   struct {
     VkPipelineLayout pipelineLayout;
     VkPipelineLayout pipelineLayoutStorage;
+    // compute passes on images: the uniform buffer, the 2D textures and two storage images to write
+    VkPipelineLayout pipelineLayoutStorageImage;
+    // fragment passes that read storage: the uniform buffer, the 2D textures and two storage buffers
+    VkPipelineLayout pipelineLayoutTexturesStorage;
+    // compute passes with more buffers: the uniform buffer and six storage buffers
+    VkPipelineLayout pipelineLayoutStorage6;
     VkPipelineLayout pipelineLayoutRayTracing;
 
   } pipelineLayouts;
@@ -51,6 +75,11 @@ struct VulkanContext {
 
   VkPhysicalDeviceProperties physicalDeviceProperties;
   VkPhysicalDeviceFeatures physicalDeviceFeatures;
+  // optional features that were found and enabled on the device
+  struct {
+    bool multiDrawIndirect; // together with drawIndirectFirstInstance
+    bool drawIndirectCount; // VK_KHR_draw_indirect_count, khr::vkCmdDrawIndexedIndirectCountKHR is loaded
+  } enabledFeatures;
   VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
 
   VkDebugUtilsMessengerEXT callback;
@@ -63,15 +92,18 @@ struct VulkanContext {
   } formats;
   VkCommandBuffer commandBuffer;
   struct CommandBuffers {
-    static constexpr uint32_t nrOfBuffers = 2;
+    uint32_t nrOfBuffers = 2; // frames in flight
     uint32_t currentIndex = 0;
-    VkCommandBuffer buffers[nrOfBuffers] = {};
-    VkFence fences[nrOfBuffers] = {};
-    bool submitted[nrOfBuffers] = {};
-    VkSemaphore imageAquiredSemaphore[nrOfBuffers] = {};
-    VkSemaphore renderCompleteSemaphore[nrOfBuffers] = {};
+    VkCommandBuffer buffers[MAX_FRAMES_IN_FLIGHT] = {};
+    VkFence fences[MAX_FRAMES_IN_FLIGHT] = {};
+    bool submitted[MAX_FRAMES_IN_FLIGHT] = {};
+    bool waited[MAX_FRAMES_IN_FLIGHT] = {}; // the fence has been waited on since the last submit
+    VkSemaphore imageAquiredSemaphore[MAX_FRAMES_IN_FLIGHT] = {};
+    VkSemaphore renderCompleteSemaphore[MAX_FRAMES_IN_FLIGHT] = {};
   } commandBuffers;
 
+  FramePacingSettings framePacing;
+
   std::unique_ptr<SwapChain> swapChain;
 
   VkInstance instance = VK_NULL_HANDLE;
@@ -100,4 +132,8 @@ extern PFN_vkCmdTraceRaysNV vkCmdTraceRaysNV;
 
 } // namespace nv
 
+namespace khr {
+extern PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR;
+} // namespace khr
+
 } // namespace mg
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "vkUtils.h"
+#include "mg/framePacing.h"
 #include "mg/mgSystem.h"
 #include "mg/mgUtils.h"
+#include "swapChain.h"
 #include "vkContext.h"
+#include <chrono>
 #include <lodepng.h>
 
 namespace mg {
@@ -71,14 +74,23 @@ void waitForDeviceIdle() {
   checkResult(vkDeviceWaitIdle(vkContext.device));
 }
 
+void waitForFrameSlot() {
+  auto &commandBuffers = vkContext.commandBuffers;
+  const auto index = commandBuffers.currentIndex;
+  if (!commandBuffers.submitted[index] || commandBuffers.waited[index])
+    return;
+  const auto start = std::chrono::steady_clock::now();
+  checkResult(vkWaitForFences(vkContext.device, 1, &commandBuffers.fences[index], VK_TRUE, UINT64_MAX));
+  framePacingFrameCompleted(index, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  commandBuffers.waited[index] = true;
+}
+
 void beginRendering() {
   vkContext.commandBuffer = vkContext.commandBuffers.buffers[vkContext.commandBuffers.currentIndex];
 
-  if (vkContext.commandBuffers.submitted[vkContext.commandBuffers.currentIndex]) {
-    checkResult(vkWaitForFences(vkContext.device, 1,
-                                &vkContext.commandBuffers.fences[vkContext.commandBuffers.currentIndex], VK_TRUE,
-                                UINT64_MAX));
-  }
+  waitForFrameSlot();
+  if (vkContext.swapChain->recreate)
+    resizeWindow();
   checkResult(
       vkResetFences(vkContext.device, 1, &vkContext.commandBuffers.fences[vkContext.commandBuffers.currentIndex]));
 
@@ -87,30 +99,38 @@ void beginRendering() {
   vkCommandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
   checkResult(vkBeginCommandBuffer(vkContext.commandBuffer, &vkCommandBufferBeginInfo));
 
-  
   setFullscreenViewport();
   acquireNextSwapChainImage();
 }
 
 static bool acquireNextSwapChainImage() {
+  // a finite timeout so a lost surface shows up in the log instead of as a hang
+  constexpr uint64_t timeoutNs = 1000000000;
   uint32_t count = 0;
   VkResult res = VK_TIMEOUT;
-  while(res != VK_SUCCESS) {
-    res = vkAcquireNextImageKHR(vkContext.device, vkContext.swapChain->swapChain, UINT64_MAX,
-                            vkContext.commandBuffers.imageAquiredSemaphore[vkContext.commandBuffers.currentIndex],
-                            VK_NULL_HANDLE, &vkContext.swapChain->currentSwapChainIndex);
-    
+  while (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
+    res = vkAcquireNextImageKHR(vkContext.device, vkContext.swapChain->swapChain, timeoutNs,
+                                vkContext.commandBuffers.imageAquiredSemaphore[vkContext.commandBuffers.currentIndex],
+                                VK_NULL_HANDLE, &vkContext.swapChain->currentSwapChainIndex);
+
     switch (res) {
     case VK_SUCCESS:
-        break;
-      case VK_ERROR_OUT_OF_DATE_KHR:
-      case VK_SUBOPTIMAL_KHR:
-        count++;
-        resizeWindow();
-        break;
-      default:
-        checkResult(res);
-        exit(1);
+      break;
+    case VK_SUBOPTIMAL_KHR:
+      // the image is acquired and the semaphore will be signaled, render it and recreate after the present
+      vkContext.swapChain->recreate = true;
+      break;
+    case VK_ERROR_OUT_OF_DATE_KHR:
+      count++;
+      resizeWindow();
+      break;
+    case VK_TIMEOUT:
+    case VK_NOT_READY:
+      LOG("vkAcquireNextImageKHR timed out, retrying");
+      break;
+    default:
+      checkResult(res);
+      exit(1);
     }
   }
   return count > 0;
@@ -125,6 +145,7 @@ void resizeWindow() {
   mg::vkContext.screen.width = surfaceCapabilities.currentExtent.width;
   mg::vkContext.screen.height = surfaceCapabilities.currentExtent.height;
   vkContext.swapChain->resize();
+  vkContext.swapChain->recreate = false;
   waitForDeviceIdle();
 }
 
@@ -158,14 +179,15 @@ void endRendering() {
   presentInfo.pResults = nullptr;
 
   const auto result = vkQueuePresentKHR(vkContext.queue, &presentInfo);
-  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vkContext.swapChain->recreate) {
     resizeWindow();
   } else {
     checkResult(result);
   }
-  
 
+  framePacingFrameSubmitted(commandBufferIndex);
   vkContext.commandBuffers.submitted[commandBufferIndex] = true;
+  vkContext.commandBuffers.waited[commandBufferIndex] = false;
   vkContext.commandBuffers.currentIndex =
       (vkContext.commandBuffers.currentIndex + 1) % vkContext.commandBuffers.nrOfBuffers;
 }
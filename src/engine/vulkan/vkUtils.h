@@ -18,6 +18,9 @@ int32_t findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties &memoryProper
 void setViewPort(float x, float y, float width, float height, float minDepth, float maxDepth);
 void setFullscreenViewport();
 
+// waits for the gpu to finish the last frame recorded into the current command buffer, beginRendering calls it if
+// startFrame did not
+void waitForFrameSlot();
 void beginRendering();
 void endRendering();
 void waitForDeviceIdle();
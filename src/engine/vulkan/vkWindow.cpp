@@ -9,6 +9,7 @@
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -26,7 +27,7 @@ namespace mg {
 static char *DEBUG_LAYER = (char *)"VK_LAYER_LUNARG_standard_validation";
 
 void createCommandBuffers() {
-  for (int i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; ++i) {
+  for (uint32_t i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; ++i) {
     VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
     commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     commandBufferAllocateInfo.commandPool = mg::vkContext.commandPool;
@@ -41,12 +42,12 @@ void createCommandBufferFences() {
   VkFenceCreateInfo fenceCreateInfo = {};
   fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 
-  for (int i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; ++i) {
+  for (uint32_t i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; ++i) {
     checkResult(vkCreateFence(mg::vkContext.device, &fenceCreateInfo, NULL, &mg::vkContext.commandBuffers.fences[i]));
   }
 }
 void createCommandBufferSemaphores() {
-  for (size_t i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; i++) {
+  for (uint32_t i = 0; i < mg::vkContext.commandBuffers.nrOfBuffers; i++) {
     VkSemaphoreCreateInfo semaphoreCreateInfo = {};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     checkResult(vkCreateSemaphore(mg::vkContext.device, &semaphoreCreateInfo, nullptr,
@@ -291,15 +292,29 @@ static void createLogicalDevice() {
   enabledFeatures.shaderClipDistance = VK_TRUE;
   enabledFeatures.shaderCullDistance = VK_TRUE;
 
-  const char *deviceExtensions[5] = {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
-                                     VK_KHR_MAINTENANCE3_EXTENSION_NAME,
-                                     VK_KHR_MAINTENANCE1_EXTENSION_NAME,
-                                     VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-                                     VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
-                                     };
+  // gpu driven rendering writes many draws with their index as firstInstance into one indirect buffer
+  const auto &deviceFeatures = mg::vkContext.physicalDeviceFeatures;
+  mg::vkContext.enabledFeatures = {};
+  if (deviceFeatures.multiDrawIndirect && deviceFeatures.drawIndirectFirstInstance) {
+    enabledFeatures.multiDrawIndirect = VK_TRUE;
+    enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+    mg::vkContext.enabledFeatures.multiDrawIndirect = true;
+  }
+
+  std::vector<const char *> deviceExtensions = {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+                                                VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+                                                VK_KHR_MAINTENANCE1_EXTENSION_NAME,
+                                                VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+                                                VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME};
+  for (const auto &extension : availableExtensions) {
+    if (std::strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) {
+      deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+      mg::vkContext.enabledFeatures.drawIndirectCount = true;
+    }
+  }
 
-  deviceCreateInfo.enabledExtensionCount = mg::countof(deviceExtensions);
-  deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
+  deviceCreateInfo.enabledExtensionCount = uint32_t(deviceExtensions.size());
+  deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
   deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
   checkResult(vkCreateDevice(mg::vkContext.physicalDevice, &deviceCreateInfo, nullptr, &mg::vkContext.device));
@@ -1,38 +1,88 @@
 #include "cube_scene.h"
 
 #include "mg/camera.h"
-#include "mg/meshUtils.h"
+#include "mg/logger.h"
 #include "mg/mgSystem.h"
+#include "mg/texts.h"
 #include "mg/window.h"
+#include "rendering/instanceRendering.h"
 #include "rendering/rendering.h"
 #include "vulkan/singleRenderpass.h"
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <vector>
+
+// A field of cubes drawn by the instance renderer, space steps through the instance counts of the benchmark and the
+// averages of a count are logged when it is left.
 
 static mg::Camera camera;
 static mg::SingleRenderPass singleRenderPass;
-static mg::MeshId meshId;
+static mg::InstanceRenderer instanceRenderer;
+static mg::Texts texts;
+
+static constexpr uint32_t instanceCounts[] = {10000, 100000, 1000000};
+static uint32_t instanceCountIndex = 0;
+static bool spaceWasDown = false;
+static uint32_t materials[2];
+
+// the transform and color streams of the cubes, the y stream is animated every frame
+static struct {
+  std::vector<float> x, y, z, sizes, baseY;
+  std::vector<uint32_t> colors;
+  float spacing;
+} cubes;
+
+static struct {
+  double updateMilliseconds, submitMilliseconds, frameMilliseconds;
+  uint32_t nrOfFrames;
+} timings;
 
 static void resizeCallback() {
   mg::resizeSingleRenderPass(&singleRenderPass);
   mg::mgSystem.textureContainer.setupDescriptorSets();
 }
 
-void initScene() {
-  mg::initSingleRenderPass(&singleRenderPass);
-
-  camera = mg::create3DCamera(glm::vec3{0.0f, 0.0f, -5.0f}, glm::vec3{0.0f, 0.0f, 0.0f},
+// a cube of side cubes with the color running over the field
+static void createCubes(uint32_t count) {
+  const uint32_t side = uint32_t(std::ceil(std::cbrt(double(count))));
+  cubes.spacing = 1.5f;
+  const float half = (side - 1) * cubes.spacing * 0.5f;
+  for (auto *stream : {&cubes.x, &cubes.y, &cubes.z, &cubes.sizes, &cubes.baseY})
+    stream->resize(count);
+  cubes.colors.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const glm::uvec3 cell = {i % side, (i / side) % side, i / (side * side)};
+    const glm::vec3 t = glm::vec3(cell) / float(std::max(side - 1, 1u));
+    cubes.x[i] = cell.x * cubes.spacing - half;
+    cubes.baseY[i] = cell.y * cubes.spacing - half;
+    cubes.z[i] = cell.z * cubes.spacing - half;
+    cubes.sizes[i] = 0.6f + 0.4f * t.y;
+    cubes.colors[i] = glm::packUnorm4x8(glm::vec4(0.3f + 0.7f * t.x, 0.3f + 0.7f * t.y, 0.3f + 0.7f * t.z, 1.0f));
+  }
+  cubes.y = cubes.baseY;
+  camera = mg::create3DCamera(glm::vec3{0.0f, half * 0.5f, -half * 2.5f - 5.0f}, glm::vec3{0.0f, 0.0f, 0.0f},
                               glm::vec3{0.0f, 1.0f, 0.0f});
+  timings = {};
+}
 
-  const auto cube = mg::createVolumeCube({-0.5f, -0.5f, -0.5f}, {1, 1, 1});
+static void logTimings() {
+  if (!timings.nrOfFrames)
+    return;
+  LOG(instanceRenderer.nrOfInstances()
+      << " instances: " << instanceRenderer.nrOfDrawCalls() << " draw calls, "
+      << instanceRenderer.drawnInstances() << " drawn, cpu update " << timings.updateMilliseconds / timings.nrOfFrames
+      << " ms, cpu submit " << timings.submitMilliseconds / timings.nrOfFrames << " ms, frame "
+      << timings.frameMilliseconds / timings.nrOfFrames << " ms");
+}
 
-  mg::CreateMeshInfo createMeshInfo = {.id = "box",
-                                       .vertices = (uint8_t *)cube.vertices,
-                                       .indices = (uint8_t *)cube.indices,
-                                       .verticesSizeInBytes = mg::sizeofArrayInBytes(cube.vertices),
-                                       .indicesSizeInBytes = mg::sizeofArrayInBytes(cube.indices),
-                                       .nrOfIndices = mg::countof(cube.indices)};
+void initScene() {
+  mg::initSingleRenderPass(&singleRenderPass);
 
-  meshId = mg::mgSystem.meshContainer.createMesh(createMeshInfo);
+  instanceRenderer.create(instanceCounts[mg::countof(instanceCounts) - 1]);
+  materials[0] = instanceRenderer.createMaterial({1.0f, 0.85f, 0.7f, 1.0f});
+  materials[1] = instanceRenderer.createMaterial({0.7f, 0.85f, 1.0f, 1.0f});
+  createCubes(instanceCounts[instanceCountIndex]);
 
   mg::mgSystem.textureContainer.setupDescriptorSets();
   mg::vkContext.swapChain->resizeCallack = resizeCallback;
@@ -40,6 +90,8 @@ void initScene() {
 
 void destroyScene() {
   mg::waitForDeviceIdle();
+  logTimings();
+  instanceRenderer.destroy();
   destroySingleRenderPass(&singleRenderPass);
 }
 
@@ -47,33 +99,73 @@ void updateScene(const mg::FrameData &frameData) {
   if (frameData.keys.r) {
     mg::mgSystem.pipelineContainer.resetPipelineContainer();
   }
+  if (frameData.keys.space && !spaceWasDown) {
+    logTimings();
+    instanceCountIndex = (instanceCountIndex + 1) % mg::countof(instanceCounts);
+    createCubes(instanceCounts[instanceCountIndex]);
+  }
+  spaceWasDown = frameData.keys.space;
   if (frameData.mouse.left)
     mg::handleTools(frameData, &camera);
   mg::setCameraTransformation(&camera);
+
+  const auto start = mg::timer::now();
+  const float time = float(frameData.time);
+  const uint32_t count = uint32_t(cubes.x.size());
+  for (uint32_t i = 0; i < count; i++)
+    cubes.y[i] = cubes.baseY[i] + 0.25f * cubes.spacing * std::sin(time * 2.0f + cubes.x[i] * 0.3f + cubes.z[i] * 0.2f);
+  timings.updateMilliseconds += mg::timer::durationInUs(start, mg::timer::now()) / 1000.0;
+  timings.frameMilliseconds += frameData.frameTime * 1000.0;
+  timings.nrOfFrames++;
 }
 
 void renderScene(const mg::FrameData &frameData) {
+  texts = {};
+  char instanceText[160];
+  const uint32_t nrOfFrames = std::max(timings.nrOfFrames, 1u);
+  snprintf(instanceText, sizeof(instanceText),
+           "%u cubes (space for more): %u draw calls, %u drawn, cpu update %.2f ms, cpu submit %.2f ms, frame %.2f ms",
+           uint32_t(cubes.x.size()), instanceRenderer.nrOfDrawCalls(), instanceRenderer.drawnInstances(),
+           timings.updateMilliseconds / nrOfFrames, timings.submitMilliseconds / nrOfFrames,
+           timings.frameMilliseconds / nrOfFrames);
+  mg::Text text = {instanceText};
+  mg::pushText(&texts, text);
+
   mg::beginRendering();
   mg::setFullscreenViewport();
 
+  mg::RenderContext renderContext = {};
+  renderContext.renderPass = singleRenderPass.vkRenderPass;
+  renderContext.projection = glm::perspective(
+      glm::radians(camera.fov), mg::vkContext.screen.width / float(mg::vkContext.screen.height), 0.1f, 1000.f);
+  renderContext.view = glm::lookAt(camera.position, camera.aim, camera.up);
+
+  // the cpu cost of the instances, the copy into the ring buffer and the recording of the cull pass and the draws
+  const auto start = mg::timer::now();
+  const uint32_t count = uint32_t(cubes.x.size());
+  const uint32_t half = count / 2;
+  instanceRenderer.begin();
+  for (uint32_t m = 0; m < mg::countof(materials); m++) {
+    const uint32_t first = m ? half : 0;
+    mg::InstanceStreams streams = {};
+    streams.x = cubes.x.data() + first;
+    streams.y = cubes.y.data() + first;
+    streams.z = cubes.z.data() + first;
+    streams.sizes = cubes.sizes.data() + first;
+    streams.colors = cubes.colors.data() + first;
+    streams.count = m ? count - half : half;
+    instanceRenderer.add(mg::PRIMITIVE::CUBE, materials[m], streams);
+  }
+  instanceRenderer.cull(renderContext.projection * renderContext.view);
+
   mg::beginSingleRenderPass(singleRenderPass);
   {
-    mg::RenderContext renderContext = {};
-    renderContext.renderPass = singleRenderPass.vkRenderPass;
-
-    renderContext.projection = glm::perspective(
-        glm::radians(camera.fov), mg::vkContext.screen.width / float(mg::vkContext.screen.height),
-        0.1f, 1000.f);
-    renderContext.view = glm::lookAt(camera.position, camera.aim, camera.up);
-
-    renderContext.renderPass = singleRenderPass.vkRenderPass;
-
-    static float rotAngle = 0;
-    rotAngle += frameData.dt * 20.0f;
-    glm::mat4 rotation = glm::rotate(glm::mat4(1), rotAngle, {1, 1, 0});
-    renderCube(renderContext, meshId, rotation, {1, 0, 0, 1});
+    instanceRenderer.draw(renderContext);
+    timings.submitMilliseconds += mg::timer::durationInUs(start, mg::timer::now()) / 1000.0;
+    mg::validateTexts(texts);
+    mg::renderText(renderContext, texts);
   }
   mg::endSingleRenderPass();
 
   mg::endRendering();
-}
\ No newline at end of file
+}
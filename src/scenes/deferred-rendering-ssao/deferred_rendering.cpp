@@ -1,26 +1,36 @@
 #include "deferred_rendering.h"
 
-#include "deferred_renderpass.h"
 #include "deferred_utils.h"
 #include "mg/camera.h"
 #include "mg/meshLoader.h"
 #include "mg/mgSystem.h"
+#include "rendering/clusteredLighting.h"
+#include "rendering/gpuCulling.h"
 #include "rendering/rendering.h"
+#include "shaders/final.h"
+#include "shaders/mrt.h"
+#include "shaders/ssao.h"
+#include "shaders/ssaoBilateral.h"
+#include "shaders/ssaoBlur.h"
+#include "shaders/ssaoDownsample.h"
+#include "shaders/ssaoHalf.h"
+#include "shaders/ssaoTemporal.h"
+#include "shaders/ssaoUpsample.h"
 #include "vulkan/pipelineContainer.h"
 #include "vulkan/vkContext.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <random>
+#include <algorithm>
 
 static mg::Pipeline createMRTPipeline(const mg::RenderContext &renderContext) {
   using namespace mg::shaders::mrt;
 
   mg::PipelineStateDesc pipelineStateDesc = {};
   pipelineStateDesc.rasterization.vkRenderPass = renderContext.renderPass;
-  pipelineStateDesc.rasterization.vkPipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayout;
+  pipelineStateDesc.rasterization.vkPipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
   pipelineStateDesc.rasterization.rasterization.cullMode = VK_CULL_MODE_FRONT_BIT;
   pipelineStateDesc.rasterization.graphics.subpass = renderContext.subpass;
-  pipelineStateDesc.rasterization.graphics.nrOfColorAttachments = 3;
+  pipelineStateDesc.rasterization.graphics.nrOfColorAttachments = 2;
   pipelineStateDesc.rasterization.blend.blendEnable = VK_FALSE;
 
   mg::CreatePipelineInfo createPipelineInfo = {};
@@ -32,7 +42,7 @@ static mg::Pipeline createMRTPipeline(const mg::RenderContext &renderContext) {
   return mrtPipeline;
 }
 
-void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objMeshes) {
+void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objMeshes, const MRTDraws &draws) {
   using namespace mg::shaders::mrt;
 
   const auto mrtPipeline = createMRTPipeline(renderContext);
@@ -50,6 +60,7 @@ void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objM
 
   DescriptorSets descriptorSets = {};
   descriptorSets.ubo = uboSet;
+  descriptorSets.drawMaterials = draws.materials;
 
   uint32_t dynamicOffsets[] = {uniformOffset, 0};
   vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mrtPipeline.layout, 0,
@@ -57,16 +68,34 @@ void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objM
                           dynamicOffsets);
   vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mrtPipeline.pipeline);
 
-  for (uint32_t i = 0; i < objMeshes.meshes.size(); i++) {
-    const auto mesh = mg::getMesh(objMeshes.meshes[i].id);
-    mgAssert(objMeshes.meshes[i].materialId < objMeshes.materials.size());
-    const auto material = objMeshes.materials[objMeshes.meshes[i].materialId];
-
-    VkDeviceSize offset = 0;
-    vkCmdBindVertexBuffers(mg::vkContext.commandBuffer, 0, 1, &mesh.buffer, &offset);
-    vkCmdPushConstants(mg::vkContext.commandBuffer, mrtPipeline.layout, VK_SHADER_STAGE_ALL, 0,
-                       sizeof(material.diffuse), (void *)&material.diffuse);
-    vkCmdDraw(mg::vkContext.commandBuffer, mesh.indexCount, 1, 0, 0);
+  if (objMeshes.meshes.empty())
+    return;
+  // the meshes share one vertex and index buffer
+  const auto mesh = mg::getMesh(objMeshes.meshes.front().id);
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(mg::vkContext.commandBuffer, 0, 1, &mesh.buffer, &offset);
+  vkCmdBindIndexBuffer(mg::vkContext.commandBuffer, mesh.buffer, mesh.indicesOffset, VK_INDEX_TYPE_UINT32);
+
+  if (draws.gpuCulling) {
+    if (draws.meshlets)
+      draws.gpuCulling->drawMeshlets();
+    else
+      draws.gpuCulling->draw();
+    return;
+  }
+  if (draws.visibleMeshlets) {
+    for (uint32_t i = 0; i < draws.nrOfVisibleMeshlets; i++) {
+      const auto &meshlet = objMeshes.meshlets.meshlets[draws.visibleMeshlets[i]];
+      vkCmdDrawIndexed(mg::vkContext.commandBuffer, meshlet.triangleCount * 3, 1, meshlet.firstIndex, 0,
+                       meshlet.meshIndex);
+    }
+    return;
+  }
+  for (uint32_t i = 0; i < draws.nrOfVisible; i++) {
+    const auto meshIndex = draws.visible[i];
+    const auto &lod = objMeshes.ranges[meshIndex].lods[draws.lods[i]];
+    if (lod.indexCount)
+      vkCmdDrawIndexed(mg::vkContext.commandBuffer, lod.indexCount, 1, lod.firstIndex, 0, meshIndex);
   }
 }
 
@@ -86,7 +115,7 @@ static mg::Pipeline createSSAOPipeline(const mg::RenderContext &renderContext) {
   return ssaoPipeline;
 }
 
-void renderSSAO(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass,
+void renderSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
                 const Noise &noise) {
   using namespace mg::shaders::ssao;
 
@@ -112,8 +141,8 @@ void renderSSAO(const mg::RenderContext &renderContext, const DeferredRenderPass
                           dynamicOffsets);
 
   TextureIndices textureIndices = {};
-  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.normal);
-  textureIndices.wordViewPositionIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.worldViewPosition);
+  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.normal);
+  textureIndices.depthIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depth);
   textureIndices.noiseIndex = mg::getTexture2DDescriptorIndex(noise.noiseTexture);
   vkCmdPushConstants(mg::vkContext.commandBuffer, ssaoPipeline.layout, VK_SHADER_STAGE_ALL, 0, sizeof(TextureIndices),
                      &textureIndices);
@@ -138,7 +167,7 @@ static mg::Pipeline createSSAOBlurPipeline(const mg::RenderContext &renderContex
   return pipeline;
 }
 
-void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass) {
+void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures) {
   using namespace mg::shaders::ssaoBlur;
   auto ssaoBlurPipeline = createSSAOBlurPipeline(renderContext);
 
@@ -149,7 +178,7 @@ void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredRender
       (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
   dynamic->size = glm::vec2(mg::vkContext.screen.width, mg::vkContext.screen.height);
 
-  const auto ssaoTexture = mg::getTexture(deferredRenderPass.ssao);
+  const auto ssaoTexture = mg::getTexture(deferredTextures.ssao);
 
   DescriptorSets descriptorSets = {};
   descriptorSets.ubo = uboSet;
@@ -161,7 +190,7 @@ void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredRender
                           dynamicOffsets);
 
   TextureIndices textureIndices = {};
-  textureIndices.ssaoIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.ssao);
+  textureIndices.ssaoIndex = mg::getTexture2DDescriptorIndex(deferredTextures.ssao);
   vkCmdPushConstants(mg::vkContext.commandBuffer, ssaoBlurPipeline.layout, VK_SHADER_STAGE_ALL, 0,
                      sizeof(TextureIndices), &textureIndices);
 
@@ -169,12 +198,189 @@ void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredRender
   vkCmdDraw(mg::vkContext.commandBuffer, 3, 1, 0, 0);
 }
 
+// the size the frame graph gives its images with a screenScale of 0.5
+static glm::ivec2 halfResolution() {
+  return {std::max(uint32_t(mg::vkContext.screen.width * 0.5f), 1u),
+          std::max(uint32_t(mg::vkContext.screen.height * 0.5f), 1u)};
+}
+
+static mg::Pipeline createSSAOComputePipeline(const char *shader) {
+  mg::PipelineStateDesc pipelineStateDesc = {};
+  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorageImage;
+  return mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+}
+
+static void dispatchSSAOCompute(const mg::Pipeline &pipeline, uint32_t uniformOffset, VkDescriptorSet *descriptorSets,
+                                uint32_t nrOfDescriptorSets, const void *pushConstants, uint32_t pushConstantsSize,
+                                const glm::ivec2 &size, uint32_t workgroupSize) {
+  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+
+  uint32_t dynamicOffsets[] = {uniformOffset, 0};
+  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
+                          nrOfDescriptorSets, descriptorSets, mg::countof(dynamicOffsets), dynamicOffsets);
+  vkCmdPushConstants(mg::vkContext.commandBuffer, pipeline.layout, VK_SHADER_STAGE_ALL, 0, pushConstantsSize,
+                     pushConstants);
+
+  vkCmdDispatch(mg::vkContext.commandBuffer, (size.x + workgroupSize - 1) / workgroupSize,
+                (size.y + workgroupSize - 1) / workgroupSize, 1);
+}
+
+void computeSSAODownsample(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures) {
+  using namespace mg::shaders::ssaoDownsample;
+
+  const auto pipeline = createSSAOComputePipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->projection = renderContext.projection;
+  ubo->size = halfResolution();
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.depthNormal = mg::mgSystem.textureContainer.getStorageDescriptorSet(deferredTextures.depthNormal);
+
+  TextureIndices textureIndices = {};
+  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.normal);
+  textureIndices.depthIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depth);
+
+  dispatchSSAOCompute(pipeline, uniformOffset, descriptorSets.values, mg::countof(descriptorSets.values),
+                      &textureIndices, sizeof(textureIndices), ubo->size, 8);
+}
+
+void computeHalfResolutionSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                               const Noise &noise, const HalfResolutionSSAO &halfResolutionSSAO) {
+  using namespace mg::shaders::ssaoHalf;
+
+  const auto pipeline = createSSAOComputePipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->projection = renderContext.projection;
+  std::memcpy(ubo->kernel, noise.ssaoKernel.kernel, mg::sizeofArrayInBytes(noise.ssaoKernel.kernel));
+  ubo->size = halfResolution();
+  ubo->nrOfSamples = int32_t(halfResolutionSSAO.nrOfSamples);
+  ubo->frame = int32_t(halfResolutionSSAO.frame);
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.ao = mg::mgSystem.textureContainer.getStorageDescriptorSet(deferredTextures.halfSSAO);
+
+  TextureIndices textureIndices = {};
+  textureIndices.depthNormalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depthNormal);
+
+  dispatchSSAOCompute(pipeline, uniformOffset, descriptorSets.values, mg::countof(descriptorSets.values),
+                      &textureIndices, sizeof(textureIndices), ubo->size, 16);
+}
+
+void computeSSAOTemporal(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         const HalfResolutionSSAO &halfResolutionSSAO) {
+  using namespace mg::shaders::ssaoTemporal;
+
+  const auto pipeline = createSSAOComputePipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->projection = renderContext.projection;
+  ubo->reprojection = halfResolutionSSAO.reprojection;
+  ubo->size = halfResolution();
+  ubo->blend = 0.1f;
+  ubo->historyValid = halfResolutionSSAO.historyValid;
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.resolved = mg::mgSystem.textureContainer.getStorageDescriptorSet(deferredTextures.halfSSAOResolved);
+
+  TextureIndices textureIndices = {};
+  textureIndices.aoIndex = mg::getTexture2DDescriptorIndex(deferredTextures.halfSSAO);
+  textureIndices.historyIndex = mg::getTexture2DDescriptorIndex(deferredTextures.ssaoHistory);
+
+  dispatchSSAOCompute(pipeline, uniformOffset, descriptorSets.values, mg::countof(descriptorSets.values),
+                      &textureIndices, sizeof(textureIndices), ubo->size, 8);
+}
+
+void computeSSAOBilateralBlur(const DeferredTextures &deferredTextures, mg::TextureId input, mg::TextureId output,
+                              const glm::ivec2 &direction, const mg::TextureId *history) {
+  using namespace mg::shaders::ssaoBilateral;
+
+  const auto pipeline = createSSAOComputePipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->size = halfResolution();
+  ubo->direction = direction;
+  ubo->depthSharpness = 16.0f;
+  ubo->normalSharpness = 8.0f;
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.blurred = mg::mgSystem.textureContainer.getStorageDescriptorSet(output);
+  // the set has to be bound even when the shader does not write it
+  descriptorSets.history =
+      history ? mg::mgSystem.textureContainer.getStorageDescriptorSet(*history) : descriptorSets.blurred;
+
+  TextureIndices textureIndices = {};
+  textureIndices.aoIndex = mg::getTexture2DDescriptorIndex(input);
+  textureIndices.depthNormalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depthNormal);
+  textureIndices.writeHistory = history != nullptr;
+
+  dispatchSSAOCompute(pipeline, uniformOffset, descriptorSets.values, mg::countof(descriptorSets.values),
+                      &textureIndices, sizeof(textureIndices), ubo->size, 8);
+}
+
+void computeSSAOUpsample(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         mg::TextureId input) {
+  using namespace mg::shaders::ssaoUpsample;
+
+  const auto pipeline = createSSAOComputePipeline(shader);
+
+  VkBuffer uniformBuffer;
+  uint32_t uniformOffset;
+  VkDescriptorSet uboSet;
+  Ubo *ubo =
+      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
+  ubo->projection = renderContext.projection;
+  ubo->size = glm::ivec2(mg::vkContext.screen.width, mg::vkContext.screen.height);
+  ubo->halfSize = halfResolution();
+  ubo->depthSharpness = 32.0f;
+  ubo->normalSharpness = 8.0f;
+
+  DescriptorSets descriptorSets = {};
+  descriptorSets.ubo = uboSet;
+  descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.ssao = mg::mgSystem.textureContainer.getStorageDescriptorSet(deferredTextures.ssaoBlur);
+
+  TextureIndices textureIndices = {};
+  textureIndices.aoIndex = mg::getTexture2DDescriptorIndex(input);
+  textureIndices.depthNormalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depthNormal);
+  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.normal);
+  textureIndices.depthIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depth);
+
+  dispatchSSAOCompute(pipeline, uniformOffset, descriptorSets.values, mg::countof(descriptorSets.values),
+                      &textureIndices, sizeof(textureIndices), ubo->size, 8);
+}
+
 static mg::Pipeline createFinalDeferred(const mg::RenderContext &renderContext) {
   using namespace mg::shaders::final;
 
   mg::PipelineStateDesc pipelineStateDesc = {};
   pipelineStateDesc.rasterization.vkRenderPass = renderContext.renderPass;
-  pipelineStateDesc.rasterization.vkPipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayout;
+  pipelineStateDesc.rasterization.vkPipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutTexturesStorage;
   pipelineStateDesc.rasterization.graphics.subpass = renderContext.subpass;
   pipelineStateDesc.rasterization.rasterization.cullMode = VK_CULL_MODE_NONE;
 
@@ -185,23 +391,8 @@ static mg::Pipeline createFinalDeferred(const mg::RenderContext &renderContext)
   return pipeline;
 }
 
-static void setLightPositions(mg::shaders::final::Ubo *dynamic) {
-  std::uniform_real_distribution<float> x(-300.0, 300.0);
-  std::uniform_real_distribution<float> y(40, 60);
-  std::uniform_real_distribution<float> z(-200, 200);
-
-  std::uniform_real_distribution<float> color(0.0, 1.0);
-  std::uniform_real_distribution<float> radius(1000, 3000);
-
-  std::default_random_engine random(101);
-
-  for (uint32_t i = 0; i < 32; i++) {
-    dynamic->lights[i].position = glm::vec4(x(random), y(random), z(random), 1.0f);
-    dynamic->lights[i].color = glm::vec4(color(random), color(random), color(random), radius((random)));
-  }
-}
-
-void renderFinalDeferred(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass) {
+void renderFinalDeferred(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         const mg::ClusterShading &clusterShading) {
   using namespace mg::shaders::final;
 
   const auto deferredPipeline = createFinalDeferred(renderContext);
@@ -212,29 +403,25 @@ void renderFinalDeferred(const mg::RenderContext &renderContext, const DeferredR
   Ubo *dynamic =
       (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
 
-  dynamic->view = renderContext.view;
   dynamic->projection = renderContext.projection;
-  setLightPositions(dynamic);
-
-  const auto normalTexture = mg::getTexture(deferredRenderPass.normal);
-  const auto albedoTexture = mg::getTexture(deferredRenderPass.albedo);
-  const auto ssaoBlured = mg::getTexture(deferredRenderPass.ssaoBlur);
-  const auto wordViewPosition = mg::getTexture(deferredRenderPass.worldViewPosition);
+  std::memcpy(&dynamic->grid, &clusterShading.grid, sizeof(clusterShading.grid));
 
   DescriptorSets descriptorSets = {};
   descriptorSets.ubo = uboSet;
   descriptorSets.textures = mg::getTextureDescriptorSet();
+  descriptorSets.counts = clusterShading.counts;
+  descriptorSets.indices = clusterShading.indices;
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
+  uint32_t dynamicOffsets[] = {uniformOffset, clusterShading.lightsOffset};
   vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredPipeline.layout, 0,
                           mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
                           dynamicOffsets);
 
   TextureIndices textureIndices = {};
-  textureIndices.diffuseIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.albedo);
-  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.normal);
-  textureIndices.ssaoBluredIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.ssaoBlur);
-  textureIndices.worldViewPostionIndex = mg::getTexture2DDescriptorIndex(deferredRenderPass.worldViewPosition);
+  textureIndices.diffuseIndex = mg::getTexture2DDescriptorIndex(deferredTextures.albedo);
+  textureIndices.normalIndex = mg::getTexture2DDescriptorIndex(deferredTextures.normal);
+  textureIndices.ssaoBluredIndex = mg::getTexture2DDescriptorIndex(deferredTextures.ssaoBlur);
+  textureIndices.depthIndex = mg::getTexture2DDescriptorIndex(deferredTextures.depth);
 
   vkCmdPushConstants(mg::vkContext.commandBuffer, deferredPipeline.layout, VK_SHADER_STAGE_ALL, 0,
                      sizeof(TextureIndices), &textureIndices);
@@ -1,15 +1,59 @@
 #pragma once
+#include "mg/textureContainer.h"
 #include <glm/glm.hpp>
 
 namespace mg {
 struct RenderContext;
 struct Camera;
 struct ObjMeshes;
+struct ClusterShading;
+class GpuCulling;
 } // namespace mg
 
-struct DeferredRenderPass;
+// the frame graph images the passes sample, the view space position is reconstructed from depth
+struct DeferredTextures {
+  mg::TextureId normal, albedo, ssao, ssaoBlur, depth;
+  // the half resolution compute path, ssao is not used and its result is upsampled into ssaoBlur
+  mg::TextureId depthNormal, halfSSAO, halfSSAOResolved, halfSSAOBlur[2], ssaoHistory;
+};
+
+struct HalfResolutionSSAO {
+  uint32_t nrOfSamples; // a divisor of the 64 kernel samples
+  uint32_t frame;       // rotates the samples from frame to frame, 0 without temporal accumulation
+  bool historyValid;      // false on the first frame after the history was created
+  glm::mat4 reprojection; // from the view space of this frame to the clip space of the last
+};
+
+// Every mesh is drawn with its index as the instance, the mrt shader finds its color at that index in materials
+struct MRTDraws {
+  VkDescriptorSet materials;
+  // the meshes to draw without gpu culling and their levels of detail
+  const uint32_t *visible;
+  const uint32_t *lods;
+  uint32_t nrOfVisible;
+  // the meshlets of objMeshes to draw instead of the meshes when set, each is a range of the index buffer
+  const uint32_t *visibleMeshlets;
+  uint32_t nrOfVisibleMeshlets;
+  // draws the survivors of its culling pass when set, of the meshlet pass with meshlets
+  const mg::GpuCulling *gpuCulling;
+  bool meshlets;
+};
+
 struct Noise;
-void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objMeshes);
-void renderSSAO(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass, const Noise &noise);
-void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass);
-void renderFinalDeferred(const mg::RenderContext &renderContext, const DeferredRenderPass &deferredRenderPass);
+void renderMRT(const mg::RenderContext &renderContext, const mg::ObjMeshes &objMeshes, const MRTDraws &draws);
+void renderSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures, const Noise &noise);
+void renderBlurSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures);
+
+void computeSSAODownsample(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures);
+void computeHalfResolutionSSAO(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                               const Noise &noise, const HalfResolutionSSAO &halfResolutionSSAO);
+void computeSSAOTemporal(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         const HalfResolutionSSAO &halfResolutionSSAO);
+// the second direction also writes the history when it is set
+void computeSSAOBilateralBlur(const DeferredTextures &deferredTextures, mg::TextureId input, mg::TextureId output,
+                              const glm::ivec2 &direction, const mg::TextureId *history);
+void computeSSAOUpsample(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         mg::TextureId input);
+// shades every pixel with the lights of its cluster
+void renderFinalDeferred(const mg::RenderContext &renderContext, const DeferredTextures &deferredTextures,
+                         const mg::ClusterShading &clusterShading);
@@ -1,39 +1,548 @@
 #include "deferred_scene.h"
 
 #include "deferred_rendering.h"
-#include "deferred_renderpass.h"
 #include "mg/camera.h"
+#include "mg/logger.h"
 #include "mg/meshLoader.h"
 #include "mg/mgAssert.h"
 #include "mg/mgSystem.h"
 #include "mg/texts.h"
 #include "mg/tools.h"
 #include "mg/window.h"
+#include "rendering/clusteredLighting.h"
+#include "rendering/gpuCulling.h"
 #include "rendering/rendering.h"
+#include "vulkan/frameGraph.h"
+#include "vulkan/gpuTimer.h"
+#include <algorithm>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 #include <lodepng.h>
 #include "deferred_utils.h"
 
 static mg::Camera camera;
-static DeferredRenderPass deferredRenderPass;
+static mg::FrameGraph frameGraph;
+static DeferredTextures deferredTextures;
 static Noise noise;
 static mg::ObjMeshes objMeshes;
+static mg::Texts texts;
+static const mg::FrameData *currentFrameData;
+static mg::GpuTimer gpuTimer;
+static mg::ClusteredLighting clusteredLighting;
+static std::vector<AnimatedLight> animatedLights;
+static std::vector<mg::PointLight> viewSpaceLights;
+static const float nearDepth = 0.1f, farDepth = 1000.0f;
+
+// c steps through the culling of the meshes: none, the frustum on the cpu, the frustum and the normal cones of the
+// meshlets on the cpu, the frustum on the gpu, the frustum and the hi-z of the last frame on the gpu and the frustum,
+// the normal cones and the hi-z of the meshlets on the gpu. The meshlet modes draw level 0. The gpu modes need multi
+// draw indirect and are skipped without it.
+enum class CULLING { NONE, CPU_FRUSTUM, CPU_MESHLETS, GPU_FRUSTUM, GPU_OCCLUSION, GPU_MESHLETS, COUNT };
+static const char *cullingNames[] = {"no culling",           "cpu frustum",         "cpu meshlets", "gpu frustum",
+                                     "gpu frustum and hi-z", "gpu meshlets and hi-z"};
+static CULLING culling = CULLING::GPU_OCCLUSION;
+static bool cWasDown = false;
+static mg::GpuCulling gpuCulling;
+static bool hasGpuCulling = false;
+static mg::StorageId drawMaterials;
+static std::vector<uint32_t> visibleMeshes;
+static uint32_t nrOfVisibleMeshes = 0;
+static std::vector<uint32_t> visibleMeshlets;
+static uint32_t nrOfVisibleMeshlets = 0;
+static float cpuCullMilliseconds = 0.0f;
+
+// l steps through the level of detail selection: always level 0, at most one pixel and at most four pixels of error
+// on screen. The drawn triangles and the mrt and frame times are averaged for every combination of culling and level of
+// detail and logged when either changes.
+static const float lodThresholds[] = {0.0f, 1.0f, 4.0f};
+static const char *lodNames[] = {"lod off", "lod 1 px", "lod 4 px"};
+static uint32_t lodIndex = 1;
+static bool lWasDown = false;
+static mg::LodSelection lodSelection;
+// parallel to visibleMeshes
+static std::vector<uint32_t> visibleLods;
+static uint32_t cpuDrawnTriangles = 0;
+struct LodStatistics {
+  double triangles, mrtMilliseconds, frameMilliseconds;
+  uint32_t nrOfFrames;
+};
+static LodStatistics lodStatistics;
+// the gpu triangle count is MAX_FRAMES_IN_FLIGHT frames late, that many frames after a change are left out
+static uint32_t lodFramesToSkip = mg::MAX_FRAMES_IN_FLIGHT;
+static double lastFrameTime = 0.0;
+
+struct DeferredImages {
+  mg::FrameGraphResourceId normal, albedo, ssao, ssaoBlur, depth;
+  mg::FrameGraphResourceId depthNormal, halfSSAO, halfSSAOResolved, halfSSAOBlur[2], ssaoHistory;
+};
+static DeferredImages deferredImages;
+
+// n computes the ssao at half resolution, m renders it at full resolution with fragment shaders, left and right turn
+// the temporal accumulation of the half resolution path off and on
+static bool halfResolutionSSAO = true;
+static bool temporalSSAO = true;
+static HalfResolutionSSAO halfResolutionSettings;
+static glm::mat4 lastViewProjection;
+static uint32_t frameNumber = 0;
+// the last gpu time of the ssao passes of each path, indexed by halfResolutionSSAO
+static float ssaoMilliseconds[2];
+
+// space steps through the light counts, the gpu time of the light culling and of the shading is averaged for each
+// count and logged when the count changes
+static const uint32_t lightCounts[] = {32, 256, 1024, 4096, 16384};
+static uint32_t lightCountIndex = 2;
+static bool spaceWasDown = false;
+struct LightingTimings {
+  float cullMilliseconds, shadeMilliseconds;
+  uint32_t nrOfFrames;
+};
+static LightingTimings lightingTimings;
+
+// v reads back the light lists of the next frame and, with gpu culling, the visibility of its draws or meshlets and
+// logs how many differ from assignLightsToClusters, cullSpheres and cullMeshlets
+static bool vWasDown = false;
+
+static bool isGpuCulling(CULLING mode) {
+  return mode == CULLING::GPU_FRUSTUM || mode == CULLING::GPU_OCCLUSION || mode == CULLING::GPU_MESHLETS;
+}
+static bool isGpuCulling() { return isGpuCulling(culling); }
+static bool isMeshletCulling() { return culling == CULLING::CPU_MESHLETS || culling == CULLING::GPU_MESHLETS; }
+static bool isOcclusionCulling() { return culling == CULLING::GPU_OCCLUSION || culling == CULLING::GPU_MESHLETS; }
 
 using namespace std;
 
+static void getDeferredTextures() {
+  deferredTextures.normal = frameGraph.getTexture(deferredImages.normal);
+  deferredTextures.albedo = frameGraph.getTexture(deferredImages.albedo);
+  deferredTextures.ssaoBlur = frameGraph.getTexture(deferredImages.ssaoBlur);
+  deferredTextures.depth = frameGraph.getTexture(deferredImages.depth);
+  if (!halfResolutionSSAO) {
+    deferredTextures.ssao = frameGraph.getTexture(deferredImages.ssao);
+  } else {
+    deferredTextures.depthNormal = frameGraph.getTexture(deferredImages.depthNormal);
+    deferredTextures.halfSSAO = frameGraph.getTexture(deferredImages.halfSSAO);
+    deferredTextures.halfSSAOBlur[0] = frameGraph.getTexture(deferredImages.halfSSAOBlur[0]);
+    deferredTextures.halfSSAOBlur[1] = frameGraph.getTexture(deferredImages.halfSSAOBlur[1]);
+    if (temporalSSAO) {
+      deferredTextures.halfSSAOResolved = frameGraph.getTexture(deferredImages.halfSSAOResolved);
+      deferredTextures.ssaoHistory = frameGraph.getTexture(deferredImages.ssaoHistory);
+    }
+  }
+  // the images are new, the history has no content yet
+  halfResolutionSettings.historyValid = false;
+}
+
+static void renderDebugAndOverlay(mg::RenderContext renderContext) {
+  mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f, -0.9f, 0.3f, 0.3f}, deferredTextures.albedo);
+  mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f * 2.0f, -0.9f, 0.3f, 0.3f}, deferredTextures.ssaoBlur);
+  mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f * 3.0f, -0.9f, 0.3f, 0.3f}, deferredTextures.normal);
+  mg::renderBoxWithDepthTexture(renderContext, {-0.98f + 0.32f * 4.0f, -0.9f, 0.3f, 0.3f}, deferredTextures.depth);
+
+  mg::validateTexts(texts);
+  mg::renderText(renderContext, texts);
+
+  mg::mgSystem.imguiOverlay.draw(renderContext, *currentFrameData);
+}
+
+// The ssao and its blur as fragment passes at full resolution
+static void addFullResolutionSSAOPasses() {
+  VkClearValue clearColor = {};
+  deferredImages.ssao = frameGraph.createImage({"ssao", VK_FORMAT_R16G16B16A16_SFLOAT});
+
+  mg::FrameGraphPassInfo ssao = {};
+  ssao.id = "ssao";
+  ssao.colorAttachments = {{deferredImages.ssao, true, clearColor}};
+  ssao.uses = {{deferredImages.normal, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+               {deferredImages.depth, mg::FRAME_GRAPH_ACCESS::SAMPLED}};
+  ssao.execute = [](const mg::RenderContext &renderContext) { renderSSAO(renderContext, deferredTextures, noise); };
+  frameGraph.addPass(ssao);
+
+  mg::FrameGraphPassInfo ssaoBlur = {};
+  ssaoBlur.id = "ssao blur";
+  ssaoBlur.colorAttachments = {{deferredImages.ssaoBlur, true, clearColor}};
+  ssaoBlur.uses = {{deferredImages.ssao, mg::FRAME_GRAPH_ACCESS::SAMPLED}};
+  ssaoBlur.execute = [](const mg::RenderContext &renderContext) { renderBlurSSAO(renderContext, deferredTextures); };
+  frameGraph.addPass(ssaoBlur);
+}
+
+// The ssao as compute passes on half resolution depths and normals, optionally accumulated over frames, blurred
+// without crossing edges and upsampled into ssaoBlur. rgba16f is the only one of the used formats that every device
+// can store to.
+static void addHalfResolutionSSAOPasses() {
+  const auto halfImage = [](const char *id) {
+    return frameGraph.createImage({id, VK_FORMAT_R16G16B16A16_SFLOAT, 0.5f});
+  };
+  deferredImages.depthNormal = halfImage("ssao depth normal");
+  deferredImages.halfSSAO = halfImage("half ssao");
+  deferredImages.halfSSAOBlur[0] = halfImage("half ssao blur horizontal");
+  deferredImages.halfSSAOBlur[1] = halfImage("half ssao blur vertical");
+
+  const auto storageWrite = [](mg::FrameGraphResourceId resource) {
+    return mg::FrameGraphUse{resource, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  };
+  const auto sampled = [](mg::FrameGraphResourceId resource) {
+    return mg::FrameGraphUse{resource, mg::FRAME_GRAPH_ACCESS::SAMPLED, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  };
+
+  mg::FrameGraphPassInfo downsample = {};
+  downsample.id = "ssao downsample";
+  downsample.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  downsample.uses = {sampled(deferredImages.normal), sampled(deferredImages.depth),
+                     storageWrite(deferredImages.depthNormal)};
+  downsample.execute = [](const mg::RenderContext &renderContext) {
+    computeSSAODownsample(renderContext, deferredTextures);
+  };
+  frameGraph.addPass(downsample);
+
+  mg::FrameGraphPassInfo ssao = {};
+  ssao.id = "ssao";
+  ssao.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  ssao.uses = {sampled(deferredImages.depthNormal), storageWrite(deferredImages.halfSSAO)};
+  ssao.execute = [](const mg::RenderContext &renderContext) {
+    computeHalfResolutionSSAO(renderContext, deferredTextures, noise, halfResolutionSettings);
+  };
+  frameGraph.addPass(ssao);
+
+  auto blurInput = deferredImages.halfSSAO;
+  if (temporalSSAO) {
+    deferredImages.halfSSAOResolved = halfImage("half ssao resolved");
+    deferredImages.ssaoHistory =
+        frameGraph.createImage({"ssao history", VK_FORMAT_R16G16B16A16_SFLOAT, 0.5f, {}, true});
+    mg::FrameGraphPassInfo temporal = {};
+    temporal.id = "ssao temporal";
+    temporal.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+    temporal.uses = {sampled(deferredImages.halfSSAO), sampled(deferredImages.ssaoHistory),
+                     storageWrite(deferredImages.halfSSAOResolved)};
+    temporal.execute = [](const mg::RenderContext &renderContext) {
+      computeSSAOTemporal(renderContext, deferredTextures, halfResolutionSettings);
+    };
+    frameGraph.addPass(temporal);
+    blurInput = deferredImages.halfSSAOResolved;
+  }
+
+  mg::FrameGraphPassInfo blurHorizontal = {};
+  blurHorizontal.id = "ssao blur horizontal";
+  blurHorizontal.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  blurHorizontal.uses = {sampled(blurInput), sampled(deferredImages.depthNormal),
+                         storageWrite(deferredImages.halfSSAOBlur[0])};
+  blurHorizontal.execute = [](const mg::RenderContext &) {
+    const auto input = temporalSSAO ? deferredTextures.halfSSAOResolved : deferredTextures.halfSSAO;
+    computeSSAOBilateralBlur(deferredTextures, input, deferredTextures.halfSSAOBlur[0], {1, 0}, nullptr);
+  };
+  frameGraph.addPass(blurHorizontal);
+
+  mg::FrameGraphPassInfo blurVertical = {};
+  blurVertical.id = "ssao blur vertical";
+  blurVertical.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  blurVertical.uses = {sampled(deferredImages.halfSSAOBlur[0]), sampled(deferredImages.depthNormal),
+                       storageWrite(deferredImages.halfSSAOBlur[1])};
+  if (temporalSSAO)
+    blurVertical.uses.push_back(storageWrite(deferredImages.ssaoHistory));
+  blurVertical.execute = [](const mg::RenderContext &) {
+    computeSSAOBilateralBlur(deferredTextures, deferredTextures.halfSSAOBlur[0], deferredTextures.halfSSAOBlur[1],
+                             {0, 1}, temporalSSAO ? &deferredTextures.ssaoHistory : nullptr);
+  };
+  frameGraph.addPass(blurVertical);
+
+  mg::FrameGraphPassInfo upsample = {};
+  upsample.id = "ssao upsample";
+  upsample.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  upsample.uses = {sampled(deferredImages.halfSSAOBlur[1]), sampled(deferredImages.depthNormal),
+                   sampled(deferredImages.normal), sampled(deferredImages.depth),
+                   storageWrite(deferredImages.ssaoBlur)};
+  upsample.execute = [](const mg::RenderContext &renderContext) {
+    computeSSAOUpsample(renderContext, deferredTextures, deferredTextures.halfSSAOBlur[1]);
+  };
+  frameGraph.addPass(upsample);
+}
+
+// The fragment passes are merged into render passes with a subpass each, only the swap chain is stored
+static void createFrameGraph() {
+  VkClearValue clearColor = {};
+  VkClearValue clearDepth = {};
+  clearDepth.depthStencil = {1.0f, 0};
+
+  deferredImages.normal = frameGraph.createImage({"normal", VK_FORMAT_R16G16_SFLOAT});
+  deferredImages.albedo = frameGraph.createImage({"albedo", VK_FORMAT_R8G8B8A8_UNORM});
+  deferredImages.ssaoBlur = frameGraph.createImage({"ssaoblur", VK_FORMAT_R16G16B16A16_SFLOAT});
+  deferredImages.depth = frameGraph.createImage({"depth", mg::vkContext.formats.depth});
+  const auto swapChain = frameGraph.importSwapChain();
+  const auto clusterCounts = frameGraph.importBuffer("cluster counts", clusteredLighting.countsBuffer());
+  const auto clusterIndices = frameGraph.importBuffer("cluster indices", clusteredLighting.indicesBuffer());
+
+  mg::FrameGraphPassInfo clusterLights = {};
+  clusterLights.id = "cluster lights";
+  clusterLights.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+  clusterLights.uses = {
+      {clusterCounts, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT},
+      {clusterIndices, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT}};
+  clusterLights.execute = [](const mg::RenderContext &renderContext) {
+    clusteredLighting.cullLights(renderContext.projection);
+  };
+  frameGraph.addPass(clusterLights);
+
+  // the cull pass reads the hi-z the last frame wrote after its mrt pass, the meshlet pass also writes an index stream
+  mg::FrameGraphResourceId cullingCommands, meshletIndices, hiZ;
+  if (isGpuCulling()) {
+    const bool meshlets = culling == CULLING::GPU_MESHLETS;
+    cullingCommands = frameGraph.importBuffer(
+        "culling commands", meshlets ? gpuCulling.meshletCommandsBuffer() : gpuCulling.commandsBuffer());
+    hiZ = frameGraph.importBuffer("hi-z", gpuCulling.hiZBuffer());
+
+    mg::FrameGraphPassInfo cull = {};
+    cull.id = "cull";
+    cull.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+    cull.uses = {{cullingCommands, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE},
+                 {hiZ, mg::FRAME_GRAPH_ACCESS::STORAGE_READ}};
+    if (meshlets) {
+      meshletIndices = frameGraph.importBuffer("meshlet indices", gpuCulling.meshletIndicesBuffer());
+      cull.uses.push_back({meshletIndices, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE});
+      cull.execute = [](const mg::RenderContext &renderContext) {
+        gpuCulling.cullMeshlets(renderContext.projection * renderContext.view, lodSelection.cameraPosition, true);
+      };
+    } else {
+      cull.execute = [](const mg::RenderContext &renderContext) {
+        gpuCulling.cull(renderContext.projection * renderContext.view, culling == CULLING::GPU_OCCLUSION,
+                        lodSelection);
+      };
+    }
+    frameGraph.addPass(cull);
+  }
+
+  mg::FrameGraphPassInfo mrt = {};
+  mrt.id = "mrt";
+  mrt.colorAttachments = {{deferredImages.normal, true, clearColor}, {deferredImages.albedo, true, clearColor}};
+  mrt.depthAttachment = {deferredImages.depth, true, clearDepth};
+  if (isGpuCulling())
+    mrt.uses = {{cullingCommands, mg::FRAME_GRAPH_ACCESS::INDIRECT}};
+  if (culling == CULLING::GPU_MESHLETS)
+    mrt.uses.push_back({meshletIndices, mg::FRAME_GRAPH_ACCESS::VERTEX});
+  mrt.execute = [](const mg::RenderContext &renderContext) {
+    MRTDraws draws = {};
+    draws.materials = mg::mgSystem.storageContainer.getStorage(drawMaterials).descriptorSet;
+    draws.visible = visibleMeshes.data();
+    draws.lods = visibleLods.data();
+    draws.nrOfVisible = nrOfVisibleMeshes;
+    draws.visibleMeshlets = culling == CULLING::CPU_MESHLETS ? visibleMeshlets.data() : nullptr;
+    draws.nrOfVisibleMeshlets = nrOfVisibleMeshlets;
+    draws.gpuCulling = isGpuCulling() ? &gpuCulling : nullptr;
+    draws.meshlets = culling == CULLING::GPU_MESHLETS;
+    renderMRT(renderContext, objMeshes, draws);
+  };
+  frameGraph.addPass(mrt);
+
+  if (isOcclusionCulling()) {
+    mg::FrameGraphPassInfo buildHiZ = {};
+    buildHiZ.id = "hi-z";
+    buildHiZ.type = mg::FRAME_GRAPH_PASS::COMPUTE;
+    buildHiZ.uses = {{deferredImages.depth, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+                     {hiZ, mg::FRAME_GRAPH_ACCESS::STORAGE_WRITE}};
+    buildHiZ.execute = [](const mg::RenderContext &renderContext) {
+      gpuCulling.buildHiZ(deferredTextures.depth, renderContext.projection * renderContext.view);
+    };
+    frameGraph.addPass(buildHiZ);
+  }
+
+  if (halfResolutionSSAO)
+    addHalfResolutionSSAOPasses();
+  else
+    addFullResolutionSSAOPasses();
+
+  mg::FrameGraphPassInfo finalPass = {};
+  finalPass.id = "final";
+  finalPass.colorAttachments = {{swapChain, true, clearColor}};
+  finalPass.uses = {{deferredImages.albedo, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+                {deferredImages.normal, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+                {deferredImages.ssaoBlur, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+                {deferredImages.depth, mg::FRAME_GRAPH_ACCESS::SAMPLED},
+                {clusterCounts, mg::FRAME_GRAPH_ACCESS::STORAGE_READ},
+                {clusterIndices, mg::FRAME_GRAPH_ACCESS::STORAGE_READ}};
+  finalPass.execute = [](const mg::RenderContext &renderContext) {
+    renderFinalDeferred(renderContext, deferredTextures, clusteredLighting.getShading());
+    renderDebugAndOverlay(renderContext);
+  };
+  frameGraph.addPass(finalPass);
+
+  frameGraph.compile();
+  getDeferredTextures();
+}
+
 static void resizeCallback() {
-  resizeDeferredRenderPass(&deferredRenderPass);
+  // a new hi-z buffer has to be imported into a new graph
+  if (hasGpuCulling && gpuCulling.resize()) {
+    frameGraph.destroy();
+    createFrameGraph();
+  } else {
+    frameGraph.resize();
+  }
+  getDeferredTextures();
+  mg::mgSystem.textureContainer.setupDescriptorSets();
+}
+
+static void rebuildFrameGraph() {
+  mg::waitForDeviceIdle();
+  frameGraph.destroy();
+  createFrameGraph();
   mg::mgSystem.textureContainer.setupDescriptorSets();
 }
 
+// the sum of the ssao passes in the timings that are back, they belong to the path the frame was recorded with
+static void updateSSAOMilliseconds() {
+  float milliseconds = 0.0f;
+  bool hasTimings = false;
+  bool isHalfResolution = false;
+  for (const auto &timing : gpuTimer.getTimings()) {
+    if (strncmp(timing.id, "ssao", 4) != 0)
+      continue;
+    milliseconds += timing.milliseconds;
+    hasTimings = true;
+    isHalfResolution |= strcmp(timing.id, "ssao upsample") == 0;
+  }
+  if (hasTimings)
+    ssaoMilliseconds[isHalfResolution] = milliseconds;
+}
+
+static void updateLightingMilliseconds() {
+  for (const auto &timing : gpuTimer.getTimings()) {
+    if (strcmp(timing.id, "cluster lights") == 0) {
+      lightingTimings.cullMilliseconds += timing.milliseconds;
+      lightingTimings.nrOfFrames++;
+    } else if (strcmp(timing.id, "final") == 0) {
+      lightingTimings.shadeMilliseconds += timing.milliseconds;
+    }
+  }
+}
+
+static uint32_t drawnTriangles() { return isGpuCulling() ? gpuCulling.drawnTriangles() : cpuDrawnTriangles; }
+
+static float mrtMilliseconds() {
+  for (const auto &timing : gpuTimer.getTimings()) {
+    if (strcmp(timing.id, "mrt") == 0)
+      return timing.milliseconds;
+  }
+  return 0.0f;
+}
+
+// the meshlets are built from level 0
+static const char *lodName() { return isMeshletCulling() ? "lod off" : lodNames[lodIndex]; }
+
+static void logLodStatistics() {
+  if (lodStatistics.nrOfFrames) {
+    const auto n = lodStatistics.nrOfFrames;
+    LOG(cullingNames[uint32_t(culling)] << ", " << lodName() << ": " << uint64_t(lodStatistics.triangles / n)
+                                        << " triangles, mrt " << lodStatistics.mrtMilliseconds / n << " ms, frame "
+                                        << lodStatistics.frameMilliseconds / n << " ms over " << n << " frames");
+  }
+  lodStatistics = {};
+  lodFramesToSkip = mg::MAX_FRAMES_IN_FLIGHT;
+}
+
+static void updateLodStatistics(const mg::FrameData &frameData, char *text, size_t size) {
+  if (lodFramesToSkip) {
+    lodFramesToSkip--;
+  } else {
+    lodStatistics.triangles += drawnTriangles();
+    lodStatistics.mrtMilliseconds += mrtMilliseconds();
+    lodStatistics.frameMilliseconds += (frameData.time - lastFrameTime) * 1000.0;
+    lodStatistics.nrOfFrames++;
+  }
+  lastFrameTime = frameData.time;
+  const auto n = std::max(lodStatistics.nrOfFrames, 1u);
+  snprintf(text, size, "%s (l to change): %u triangles, mrt %.2f ms, frame %.2f ms",
+           lodName(), drawnTriangles(), lodStatistics.mrtMilliseconds / n, lodStatistics.frameMilliseconds / n);
+}
+
+static void updateCullingMilliseconds(char *text, size_t size) {
+  float cullMilliseconds = 0.0f, hiZMilliseconds = 0.0f, mrtMilliseconds = 0.0f;
+  for (const auto &timing : gpuTimer.getTimings()) {
+    if (strcmp(timing.id, "cull") == 0)
+      cullMilliseconds = timing.milliseconds;
+    else if (strcmp(timing.id, "hi-z") == 0)
+      hiZMilliseconds = timing.milliseconds;
+    else if (strcmp(timing.id, "mrt") == 0)
+      mrtMilliseconds = timing.milliseconds;
+  }
+  if (culling == CULLING::GPU_MESHLETS) {
+    snprintf(text, size, "%s (c to change): %u meshlets, cull %.3f ms, hi-z %.3f ms, mrt %.2f ms",
+             cullingNames[uint32_t(culling)], uint32_t(objMeshes.meshlets.meshlets.size()), cullMilliseconds,
+             hiZMilliseconds, mrtMilliseconds);
+  } else if (isGpuCulling()) {
+    snprintf(text, size, "%s (c to change): %u meshes, cull %.3f ms, hi-z %.3f ms, mrt %.2f ms",
+             cullingNames[uint32_t(culling)], uint32_t(objMeshes.meshes.size()), cullMilliseconds, hiZMilliseconds,
+             mrtMilliseconds);
+  } else if (culling == CULLING::CPU_MESHLETS) {
+    snprintf(text, size, "%s (c to change): %u of %u meshlets, cpu cull %.3f ms, mrt %.2f ms",
+             cullingNames[uint32_t(culling)], nrOfVisibleMeshlets, uint32_t(objMeshes.meshlets.meshlets.size()),
+             cpuCullMilliseconds, mrtMilliseconds);
+  } else {
+    snprintf(text, size, "%s (c to change): %u of %u meshes, cpu cull %.3f ms, mrt %.2f ms",
+             cullingNames[uint32_t(culling)], nrOfVisibleMeshes, uint32_t(objMeshes.meshes.size()),
+             cpuCullMilliseconds, mrtMilliseconds);
+  }
+}
+
+static void setCulling(CULLING newCulling) {
+  logLodStatistics();
+  culling = newCulling;
+  rebuildFrameGraph();
+}
+
+// The vertices of all meshes are in one buffer and mesh i is drawn with instance i, the mrt shader reads its color
+// from a buffer and the gpu culling writes the draws of all meshes into one indirect buffer
+static void createMeshDraws() {
+  std::vector<glm::vec4> diffuse(objMeshes.meshes.size());
+  std::vector<mg::CullingDraw> draws(objMeshes.meshes.size());
+  for (uint32_t i = 0; i < objMeshes.meshes.size(); i++) {
+    mgAssert(objMeshes.meshes[i].materialId < objMeshes.materials.size());
+    diffuse[i] = objMeshes.materials[objMeshes.meshes[i].materialId].diffuse;
+    const auto &range = objMeshes.ranges[i];
+    draws[i] = {objMeshes.bounds[i], range.nrOfLods, {}, {}};
+    for (uint32_t l = 0; l < range.nrOfLods; l++)
+      draws[i].lods[l] = {range.lods[l].firstIndex, range.lods[l].indexCount, range.lods[l].error, 0};
+  }
+  drawMaterials = mg::mgSystem.storageContainer.createStorage(
+      diffuse.data(), uint32_t(mg::sizeofContainerInBytes(diffuse)));
+  visibleMeshes.resize(objMeshes.meshes.size());
+  visibleLods.resize(objMeshes.meshes.size());
+  visibleMeshlets.resize(objMeshes.meshlets.meshlets.size());
+
+  hasGpuCulling = mg::GpuCulling::isSupported() && !draws.empty();
+  if (hasGpuCulling) {
+    gpuCulling.create(draws.data(), uint32_t(draws.size()));
+    if (!objMeshes.meshlets.meshlets.empty())
+      gpuCulling.createMeshlets(objMeshes.meshlets);
+  } else {
+    LOG("multi draw indirect is not supported, the meshes are culled on the cpu");
+    culling = CULLING::CPU_FRUSTUM;
+  }
+}
+
+static void setLightCount(uint32_t index) {
+  if (lightingTimings.nrOfFrames) {
+    LOG(animatedLights.size() << " lights: culling " << lightingTimings.cullMilliseconds / lightingTimings.nrOfFrames
+                              << " ms, shading " << lightingTimings.shadeMilliseconds / lightingTimings.nrOfFrames
+                              << " ms over " << lightingTimings.nrOfFrames << " frames");
+  }
+  lightingTimings = {};
+  lightCountIndex = index;
+  animatedLights = createAnimatedLights(lightCounts[index]);
+}
+
 void initScene() {
 
   camera = mg::create3DCamera(glm::vec3(0.5, 200, 470), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
   //camera = mg::create3DCamera(glm::vec3(0.5, 1.0, 4), glm::vec3(0, 1.0, 0), glm::vec3(0, 1, 0));
   objMeshes = mg::loadObjFromFile(mg::getDataPath() + "rungholt_obj/rungholt.obj");
   //objMeshes = mg::loadObjFromFile(mg::getDataPath() + "CornellBox_obj/CornellBox-Original.obj");
-  initDeferredRenderPass(&deferredRenderPass);
+  createMeshDraws();
+  mg::ClusterGridInfo clusterGridInfo = {};
+  clusterGridInfo.nearDepth = nearDepth;
+  clusterGridInfo.farDepth = farDepth;
+  clusteredLighting.create(clusterGridInfo);
+  setLightCount(lightCountIndex);
+  createFrameGraph();
   noise = createNoise();
+  gpuTimer.create(16);
 
   mg::mgSystem.textureContainer.setupDescriptorSets();
   mg::vkContext.swapChain->resizeCallack = resizeCallback;
@@ -42,13 +551,49 @@ void initScene() {
 void destroyScene() {
   mg::waitForDeviceIdle();
   mg::removeTexture(noise.noiseTexture);
-  destroyDeferredRenderPass(&deferredRenderPass);
+  frameGraph.destroy();
+  gpuTimer.destroy();
+  clusteredLighting.destroy();
+  gpuCulling.destroy();
+  mg::mgSystem.storageContainer.removeStorage(drawMaterials);
 }
 
 void updateScene(const mg::FrameData &frameData) {
   if (frameData.keys.r) {
     mg::mgSystem.pipelineContainer.resetPipelineContainer();
   }
+  if (frameData.keys.n != frameData.keys.m && halfResolutionSSAO != frameData.keys.n) {
+    halfResolutionSSAO = frameData.keys.n;
+    rebuildFrameGraph();
+  }
+  if (halfResolutionSSAO && frameData.keys.left != frameData.keys.right && temporalSSAO != frameData.keys.right) {
+    temporalSSAO = frameData.keys.right;
+    rebuildFrameGraph();
+  }
+  if (frameData.keys.space && !spaceWasDown)
+    setLightCount((lightCountIndex + 1) % mg::countof(lightCounts));
+  spaceWasDown = frameData.keys.space;
+  if (frameData.keys.c && !cWasDown) {
+    auto next = CULLING((uint32_t(culling) + 1) % uint32_t(CULLING::COUNT));
+    // without gpu culling only the cpu modes are stepped through
+    if (!hasGpuCulling && isGpuCulling(next))
+      next = CULLING::NONE;
+    if (next == CULLING::GPU_MESHLETS && !gpuCulling.hasMeshlets())
+      next = CULLING::NONE;
+    setCulling(next);
+  }
+  cWasDown = frameData.keys.c;
+  if (frameData.keys.l && !lWasDown) {
+    logLodStatistics();
+    lodIndex = (lodIndex + 1) % mg::countof(lodThresholds);
+  }
+  lWasDown = frameData.keys.l;
+  if (frameData.keys.v && !vWasDown) {
+    clusteredLighting.requestValidation();
+    if (isGpuCulling())
+      gpuCulling.requestValidation();
+  }
+  vWasDown = frameData.keys.v;
   if (frameData.mouse.xy.x >= 0 && frameData.mouse.xy.x < 1.0f && frameData.mouse.xy.y >= 0 && frameData.mouse.xy.y < 1.0f) {
     if (frameData.mouse.left) {
       mg::handleTools(frameData, &camera);
@@ -58,47 +603,102 @@ void updateScene(const mg::FrameData &frameData) {
 }
 
 void renderScene(const mg::FrameData &frameData) {
-  mg::Texts texts = {};
+  texts = {};
   mg::Text text = {"Rungholt"};
-
   mg::pushText(&texts, text);
 
+  updateSSAOMilliseconds();
+  char ssaoTimings[128];
+  snprintf(ssaoTimings, sizeof(ssaoTimings), "SSAO %s: full resolution %.2f ms, half resolution %.2f ms",
+           halfResolutionSSAO ? (temporalSSAO ? "half resolution temporal" : "half resolution") : "full resolution",
+           ssaoMilliseconds[0], ssaoMilliseconds[1]);
+  mg::Text timingText = {ssaoTimings};
+  mg::pushText(&texts, timingText);
+
+  updateLightingMilliseconds();
+  char lightingTimingText[128];
+  const auto nrOfFrames = std::max(lightingTimings.nrOfFrames, 1u);
+  snprintf(lightingTimingText, sizeof(lightingTimingText),
+           "%u clustered lights (space for more): culling %.2f ms, shading %.2f ms", lightCounts[lightCountIndex],
+           lightingTimings.cullMilliseconds / nrOfFrames, lightingTimings.shadeMilliseconds / nrOfFrames);
+  mg::Text lightingText = {lightingTimingText};
+  mg::pushText(&texts, lightingText);
+
+  char cullingText[160];
+  updateCullingMilliseconds(cullingText, sizeof(cullingText));
+  mg::Text cullingTimingText = {cullingText};
+  mg::pushText(&texts, cullingTimingText);
+
+  char lodText[128];
+  updateLodStatistics(frameData, lodText, sizeof(lodText));
+  mg::Text lodTimingText = {lodText};
+  mg::pushText(&texts, lodTimingText);
+  currentFrameData = &frameData;
+
   mg::beginRendering();
+  gpuTimer.beginFrame();
 
   mg::RenderContext renderContext = {};
-  renderContext.renderPass = deferredRenderPass.vkRenderPass;
-
-  renderContext.projection =
-      glm::perspective(glm::radians(camera.fov), mg::vkContext.screen.width / float(mg::vkContext.screen.height), 0.1f, 1000.f);
+  renderContext.projection = glm::perspective(
+      glm::radians(camera.fov), mg::vkContext.screen.width / float(mg::vkContext.screen.height), nearDepth, farDepth);
   renderContext.view = glm::lookAt(camera.position, camera.aim, camera.up);
 
-  beginDeferredRenderPass(deferredRenderPass);
-  {
-    renderContext.subpass = 0;
-    renderMRT(renderContext, objMeshes);
-
-    vkCmdNextSubpass(mg::vkContext.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
-    renderContext.subpass = 1;
-    renderSSAO(renderContext, deferredRenderPass, noise);
+  // the meshes are in world space, the cpu culling tests their spheres against the frustum of this frame
+  const auto cameraPosition = glm::vec3(glm::inverse(renderContext.view)[3]);
+  const auto cullStart = mg::timer::now();
+  if (culling == CULLING::CPU_FRUSTUM) {
+    const auto frustum = mg::createFrustum(renderContext.projection * renderContext.view);
+    nrOfVisibleMeshes = mg::cullSpheres(frustum, objMeshes.bounds.data(), uint32_t(objMeshes.bounds.size()),
+                                        visibleMeshes.data());
+  } else if (culling == CULLING::CPU_MESHLETS) {
+    const auto frustum = mg::createFrustum(renderContext.projection * renderContext.view);
+    const auto &meshlets = objMeshes.meshlets.meshlets;
+    nrOfVisibleMeshlets =
+        mg::cullMeshlets(frustum, cameraPosition, meshlets.data(), uint32_t(meshlets.size()), visibleMeshlets.data());
+    nrOfVisibleMeshes = 0;
+  } else if (culling == CULLING::NONE) {
+    for (uint32_t i = 0; i < visibleMeshes.size(); i++)
+      visibleMeshes[i] = i;
+    nrOfVisibleMeshes = uint32_t(visibleMeshes.size());
+  }
+  cpuCullMilliseconds = mg::timer::durationInUs(cullStart, mg::timer::now()) / 1000.0f;
 
-    vkCmdNextSubpass(mg::vkContext.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
-    renderContext.subpass = 2;
-    renderBlurSSAO(renderContext, deferredRenderPass);
+  // the levels of detail are selected by their error in pixels, the gpu culling selects its own with the same rule
+  lodSelection.cameraPosition = cameraPosition;
+  lodSelection.scale = mg::lodScale(renderContext.projection, mg::vkContext.screen.height);
+  lodSelection.threshold = lodThresholds[lodIndex];
+  cpuDrawnTriangles = 0;
+  for (uint32_t i = 0; culling == CULLING::CPU_MESHLETS && i < nrOfVisibleMeshlets; i++)
+    cpuDrawnTriangles += objMeshes.meshlets.meshlets[visibleMeshlets[i]].triangleCount;
+  if (!isGpuCulling()) {
+    for (uint32_t i = 0; i < nrOfVisibleMeshes; i++) {
+      const auto &range = objMeshes.ranges[visibleMeshes[i]];
+      float errors[mg::MAX_MESH_LODS];
+      for (uint32_t l = 0; l < range.nrOfLods; l++)
+        errors[l] = range.lods[l].error;
+      visibleLods[i] = mg::selectMeshLod(lodSelection, objMeshes.bounds[visibleMeshes[i]].sphere, errors,
+                                         range.nrOfLods);
+      cpuDrawnTriangles += range.lods[visibleLods[i]].indexCount / 3;
+    }
+  }
 
-    vkCmdNextSubpass(mg::vkContext.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
-    renderContext.subpass = 3;
-    renderFinalDeferred(renderContext, deferredRenderPass);
+  animateLights(animatedLights, frameData.time, renderContext.view, &viewSpaceLights);
+  clusteredLighting.setLights(viewSpaceLights.data(), uint32_t(viewSpaceLights.size()));
 
-    mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f, -0.9f, 0.3f, 0.3f}, deferredRenderPass.albedo);
-    mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f * 2.0f, -0.9f, 0.3f, 0.3f}, deferredRenderPass.ssaoBlur);
-    mg::renderBoxWithTexture(renderContext, {-0.98f + 0.32f * 3.0f, -0.9f, 0.3f, 0.3f}, deferredRenderPass.normal);
-    mg::renderBoxWithDepthTexture(renderContext, {-0.98f + 0.32f * 4.0f, -0.9f, 0.3f, 0.3f}, deferredRenderPass.depth);
+  // the reprojection into the last frame for the temporal accumulation, the samples rotate every frame
+  const auto viewProjection = renderContext.projection * renderContext.view;
+  halfResolutionSettings.frame = temporalSSAO ? frameNumber++ : 0;
+  halfResolutionSettings.nrOfSamples = temporalSSAO ? 16 : 32;
+  halfResolutionSettings.reprojection = lastViewProjection * glm::inverse(renderContext.view);
+  lastViewProjection = viewProjection;
 
-    mg::validateTexts(texts);
-    mg::renderText(renderContext, texts);
+  frameGraph.execute(renderContext, &gpuTimer);
+  // the blur wrote the history of the next frame
+  halfResolutionSettings.historyValid = halfResolutionSSAO && temporalSSAO;
 
-    mg::mgSystem.imguiOverlay.draw(renderContext, frameData);
-  }
-  endDeferredRenderPass();
   mg::endRendering();
+  if (clusteredLighting.isValidationPending())
+    clusteredLighting.validate();
+  if (gpuCulling.isValidationPending())
+    gpuCulling.validate();
 }
@@ -1,6 +1,7 @@
 #include "deferred_utils.h"
 #include "mg/mgSystem.h"
 #include "mg/textureContainer.h"
+#include <cmath>
 #include <random>
 
 static float lerp(float a, float b, float f) {
@@ -47,4 +48,41 @@ Noise createNoise() {
 
 
   return noise;
-}
\ No newline at end of file
+}
+
+std::vector<AnimatedLight> createAnimatedLights(uint32_t count) {
+  std::uniform_real_distribution<float> x(-300.0f, 300.0f);
+  std::uniform_real_distribution<float> y(5.0f, 60.0f);
+  std::uniform_real_distribution<float> z(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> orbitRadius(2.0f, 20.0f);
+  std::uniform_real_distribution<float> angularSpeed(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+  std::uniform_real_distribution<float> range(15.0f, 40.0f);
+  std::uniform_real_distribution<float> color(0.0f, 1.0f);
+  std::default_random_engine random(101);
+
+  std::vector<AnimatedLight> lights(count);
+  for (auto &light : lights) {
+    light.center = {x(random), y(random), z(random)};
+    light.orbitRadius = orbitRadius(random);
+    light.angularSpeed = angularSpeed(random);
+    light.phase = phase(random);
+    light.range = range(random);
+    // about a quarter of the light reaches half the range
+    light.colorIntensity = {color(random), color(random), color(random), 0.25f * light.range * light.range};
+  }
+  return lights;
+}
+
+void animateLights(const std::vector<AnimatedLight> &animatedLights, double time, const glm::mat4 &view,
+                   std::vector<mg::PointLight> *lights) {
+  lights->resize(animatedLights.size());
+  for (size_t i = 0; i < animatedLights.size(); i++) {
+    const auto &light = animatedLights[i];
+    const float angle = float(std::fmod(light.angularSpeed * time + light.phase, 6.2831853));
+    const glm::vec3 position =
+        light.center + light.orbitRadius * glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+    (*lights)[i].positionRange = glm::vec4(glm::vec3(view * glm::vec4(position, 1.0f)), light.range);
+    (*lights)[i].colorIntensity = light.colorIntensity;
+  }
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <glm/glm.hpp>
 #include "mg/textureContainer.h"
+#include "rendering/clusteredLighting.h"
+#include <vector>
 
 struct SSAOKernel {
   glm::vec4 kernel[64];
@@ -12,4 +14,17 @@ struct Noise {
   mg::TextureId noiseTexture;
 };
 
-Noise createNoise();
\ No newline at end of file
+Noise createNoise();
+
+// A point light that circles around its center above the city
+struct AnimatedLight {
+  glm::vec3 center;
+  float orbitRadius, angularSpeed, phase;
+  float range;
+  glm::vec4 colorIntensity;
+};
+
+std::vector<AnimatedLight> createAnimatedLights(uint32_t count);
+// the view space lights at time
+void animateLights(const std::vector<AnimatedLight> &animatedLights, double time, const glm::mat4 &view,
+                   std::vector<mg::PointLight> *lights);
@@ -0,0 +1,112 @@
+#include "mg/logger.h"
+#include "mg/workerPool.h"
+#include "navier_stoke_cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <lodepng.h>
+#include <string>
+
+// Headless cpu simulation of the fluid scene, no window or gpu is needed.
+// fluid-cpu [--size=N] [--steps=N] [--threads=N] [--iterations=N] [--scalar] [--verify] [--output=file.png]
+// --verify runs a single threaded scalar solver next to the benchmarked one and returns 1 if any step differs.
+
+// a source circling the center of the grid, the same for every run
+static void addSources(CpuFluid *fluid, uint32_t step) {
+  const float angle = step * 0.05f;
+  const glm::vec2 direction = {std::cos(angle), std::sin(angle)};
+  const float radius = fluid->N * 0.25f;
+  const int32_t i = int32_t(fluid->N / 2 + radius * direction.x);
+  const int32_t j = int32_t(fluid->N / 2 + radius * direction.y);
+  addSourceCpu(fluid, i, j, glm::vec2{-direction.y, direction.x});
+}
+
+static bool isEqual(const CpuFluid &a, const CpuFluid &b) {
+  const size_t size = a.d.size() * sizeof(float);
+  return memcmp(a.u.data(), b.u.data(), size) == 0 && memcmp(a.v.data(), b.v.data(), size) == 0 &&
+         memcmp(a.d.data(), b.d.data(), size) == 0;
+}
+
+int main(int argc, char **argv) {
+  std::string outputPath;
+  uint32_t N = 1024;
+  uint32_t nrOfSteps = 100;
+  uint32_t nrOfThreads = 0;
+  bool useSimd = true;
+  bool verify = false;
+  CpuFluidSettings settings = {};
+  settings.visc = 0.0001f;
+  settings.diff = 0.0001f;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--output=", 0) == 0)
+      outputPath = arg.substr(strlen("--output="));
+    else if (arg.rfind("--size=", 0) == 0)
+      N = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--size=")))));
+    else if (arg.rfind("--steps=", 0) == 0)
+      nrOfSteps = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--steps=")))));
+    else if (arg.rfind("--threads=", 0) == 0)
+      nrOfThreads = uint32_t(std::stoul(arg.substr(strlen("--threads="))));
+    else if (arg.rfind("--iterations=", 0) == 0)
+      settings.iterations = uint32_t(std::stoul(arg.substr(strlen("--iterations="))));
+    else if (arg == "--scalar")
+      useSimd = false;
+    else if (arg == "--verify")
+      verify = true;
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  mg::WorkerPool workers, referenceWorkers;
+  workers.create(nrOfThreads);
+  auto fluid = createCpuFluid(N, &workers, useSimd);
+  CpuFluid reference = {};
+  if (verify) {
+    referenceWorkers.create(1);
+    reference = createCpuFluid(N, &referenceWorkers, false);
+  }
+
+  double totalMs = 0, bestMs = 1e30;
+  bool isValid = true;
+  for (uint32_t step = 0; step < nrOfSteps && isValid; step++) {
+    addSources(&fluid, step);
+    const auto start = std::chrono::high_resolution_clock::now();
+    stepCpu(&fluid, settings);
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    totalMs += ms;
+    bestMs = std::min(bestMs, ms);
+
+    if (verify) {
+      addSources(&reference, step);
+      stepCpu(&reference, settings);
+      isValid = isEqual(fluid, reference);
+      if (!isValid)
+        LOG("step " << step << " differs from the scalar reference");
+    }
+  }
+
+  const double nrOfCells = double(N) * N;
+  LOG((useSimd ? "simd" : "scalar") << " " << N << "x" << N << ": " << totalMs / nrOfSteps << " ms/step, best "
+                                    << bestMs << " ms, " << nrOfCells / (bestMs * 1e3) << " Mcells/s");
+
+  if (!outputPath.empty()) {
+    std::vector<uint8_t> pixels(size_t(N) * N);
+    for (uint32_t j = 0; j < N; j++) {
+      for (uint32_t i = 0; i < N; i++) {
+        const float density = fluid.d[(i + 1) + size_t(j + 1) * (N + 2)];
+        pixels[i + size_t(N - 1 - j) * N] = uint8_t(std::min(std::max(density, 0.0f), 1.0f) * 255.0f);
+      }
+    }
+    const auto encodeError = lodepng::encode(outputPath, pixels, N, N, LCT_GREY);
+    if (encodeError)
+      LOG("encoder error " << encodeError << ": " << lodepng_error_text(encodeError));
+  }
+
+  if (verify)
+    destroyCpuFluid(&reference);
+  destroyCpuFluid(&fluid);
+  return isValid ? 0 : 1;
+}
@@ -13,7 +13,8 @@
 static mg::Camera camera;
 static mg::SingleRenderPass singleRenderPass;
 static mg::MeshId meshId;
-static mg::Storages storages;
+static mg::FluidSolver fluidSolver;
+static mg::NavierStokeSettings navierStokeSettings;
 static uint32_t N = 1024;
 
 static void resizeCallback() {
@@ -27,14 +28,14 @@ void initScene() {
   camera = mg::create3DCamera(glm::vec3{0.0f, 0.0f, -5.0f}, glm::vec3{0.0f, 0.0f, 0.0f},
                               glm::vec3{0.0f, 1.0f, 0.0f});
 
-  storages = mg::createStorages(N);
+  fluidSolver = mg::createFluidSolver(N);
   mg::mgSystem.textureContainer.setupDescriptorSets();
   mg::vkContext.swapChain->resizeCallack = resizeCallback;
 }
 
 void destroyScene() {
   mg::waitForDeviceIdle();
-  mg::destroyStorages(&storages);
+  mg::destroyFluidSolver(&fluidSolver);
   destroySingleRenderPass(&singleRenderPass);
 }
 
@@ -61,14 +62,14 @@ void renderScene(const mg::FrameData &frameData) {
   mg::beginRendering();
   mg::setFullscreenViewport();
 
-  mg::simulateNavierStoke(storages, frameData, N);
+  mg::simulateNavierStoke(fluidSolver, navierStokeSettings, frameData);
 
   mg::beginSingleRenderPass(singleRenderPass);
   {
     mg::RenderContext renderContext = {};
     renderContext.renderPass = singleRenderPass.vkRenderPass;
 
-    mg::renderNavierStoke(renderContext, storages);
+    mg::renderNavierStoke(renderContext, fluidSolver);
     mg::validateTexts(texts);
     mg::renderText(renderContext, texts);
   }
@@ -0,0 +1,287 @@
+#include "mg/logger.h"
+#include "multigrid_settings.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Convergence per millisecond of a cpu port of the fluid compute shaders on one thread, not of the gpu FluidSolver:
+// the multigrid V-cycles of navier_stoke.cpp with the default NavierStokeSettings against the Jacobi sweeps that
+// diffuse.comp and project.comp ran before, 5 per frame and as many as fit in the time of the multigrid solve. The
+// milliseconds are those of the port, they only compare the two solvers, the residuals match what the shaders reach.
+// fluid-solver-bench [--size=N] [--visc=v] [--dt=t]
+// Without --size it runs N = 256, 512, 1024 and 2048.
+
+namespace {
+
+size_t IX(uint32_t N, uint32_t i, uint32_t j) { return i + size_t(j) * (N + 2); }
+
+// c * x - a * (sum of the four neighbours) = rhs, with the ghost cells mirroring the boundary cells as in set_bnd
+struct LinearSystem {
+  int32_t b;
+  float a, c;
+};
+
+LinearSystem coarsen(const LinearSystem &system) {
+  const float diagonal = system.c - 4 * system.a;
+  const float a = system.a * 0.25f;
+  return {system.b, a, diagonal + 4 * a};
+}
+
+struct Level {
+  uint32_t N;
+  std::vector<float> x, rhs, residual;
+};
+
+// the neighbours of a cell with the ghost cells folded into the diagonal, as in redBlackSmooth.comp
+float relax(uint32_t N, const LinearSystem &system, const float *x, const float *rhs, uint32_t i, uint32_t j) {
+  const float sx = system.b == 1 ? -1.0f : 1.0f;
+  const float sy = system.b == 2 ? -1.0f : 1.0f;
+  float sum = 0;
+  float diagonal = system.c;
+  if (i > 1) sum += x[IX(N, i - 1, j)]; else diagonal -= system.a * sx;
+  if (i < N) sum += x[IX(N, i + 1, j)]; else diagonal -= system.a * sx;
+  if (j > 1) sum += x[IX(N, i, j - 1)]; else diagonal -= system.a * sy;
+  if (j < N) sum += x[IX(N, i, j + 1)]; else diagonal -= system.a * sy;
+  return (rhs[IX(N, i, j)] + system.a * sum) / diagonal;
+}
+
+void smooth(uint32_t N, const LinearSystem &system, float *x, const float *rhs, uint32_t iterations) {
+  for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+    for (uint32_t color = 0; color < 2; color++) {
+      for (uint32_t j = 1; j <= N; j++) {
+        for (uint32_t i = 1 + ((j + 1 + color) & 1); i <= N; i += 2)
+          x[IX(N, i, j)] = relax(N, system, x, rhs, i, j);
+      }
+    }
+  }
+}
+
+// the max norm of the residual, as multigridResidual.comp tracks it on the finest level
+float computeResidual(uint32_t N, const LinearSystem &system, const float *x, const float *rhs, float *residual) {
+  const float sx = system.b == 1 ? -1.0f : 1.0f;
+  const float sy = system.b == 2 ? -1.0f : 1.0f;
+  float norm = 0;
+  for (uint32_t j = 1; j <= N; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const float center = x[IX(N, i, j)];
+      const float sum = (i > 1 ? x[IX(N, i - 1, j)] : sx * center) + (i < N ? x[IX(N, i + 1, j)] : sx * center) +
+                        (j > 1 ? x[IX(N, i, j - 1)] : sy * center) + (j < N ? x[IX(N, i, j + 1)] : sy * center);
+      const float r = rhs[IX(N, i, j)] - (system.c * center - system.a * sum);
+      if (residual)
+        residual[IX(N, i, j)] = r;
+      norm = std::max(norm, std::abs(r));
+    }
+  }
+  return norm;
+}
+
+void restrictResidual(const Level &fine, Level *coarse) {
+  const uint32_t N = coarse->N;
+  for (uint32_t j = 1; j <= N; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const uint32_t fi = 2 * i - 1, fj = 2 * j - 1;
+      const auto &r = fine.residual;
+      coarse->rhs[IX(N, i, j)] = 0.25f * (r[IX(fine.N, fi, fj)] + r[IX(fine.N, fi + 1, fj)] +
+                                          r[IX(fine.N, fi, fj + 1)] + r[IX(fine.N, fi + 1, fj + 1)]);
+      coarse->x[IX(N, i, j)] = 0;
+    }
+  }
+}
+
+void prolongate(uint32_t N, int32_t b, float *x, const float *coarseX) {
+  const int32_t coarseN = int32_t(N / 2);
+  const auto coarseValue = [&](int32_t i, int32_t j) {
+    float s = 1.0f;
+    if (i < 1 || i > coarseN) {
+      i = std::clamp(i, 1, coarseN);
+      s *= b == 1 ? -1.0f : 1.0f;
+    }
+    if (j < 1 || j > coarseN) {
+      j = std::clamp(j, 1, coarseN);
+      s *= b == 2 ? -1.0f : 1.0f;
+    }
+    return s * coarseX[IX(uint32_t(coarseN), uint32_t(i), uint32_t(j))];
+  };
+  for (uint32_t j = 1; j <= N; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const int32_t ci = int32_t(i + 1) / 2, cj = int32_t(j + 1) / 2;
+      const int32_t ni = (i & 1) ? ci - 1 : ci + 1, nj = (j & 1) ? cj - 1 : cj + 1;
+      x[IX(N, i, j)] += (9 * coarseValue(ci, cj) + 3 * coarseValue(ni, cj) + 3 * coarseValue(ci, nj) +
+                         coarseValue(ni, nj)) / 16;
+    }
+  }
+}
+
+// levels are halved while the grid stays even and above the coarsest size, as createMultigrid does
+std::vector<Level> createLevels(uint32_t N) {
+  std::vector<Level> levels;
+  levels.push_back({N, {}, {}, std::vector<float>((N + 2) * (N + 2))});
+  while (N % 2 == 0 && N / 2 >= 8) {
+    N /= 2;
+    const size_t size = (N + 2) * (N + 2);
+    levels.push_back({N, std::vector<float>(size), std::vector<float>(size), std::vector<float>(size)});
+  }
+  return levels;
+}
+
+struct SolveState {
+  float initialResidual;
+  uint32_t cycles;
+  bool converged;
+};
+
+void vCycle(std::vector<Level> &levels, uint32_t levelIndex, const mg::MultigridSettings &settings,
+            const LinearSystem &system, float *x, const float *rhs, SolveState *state) {
+  auto &level = levels[levelIndex];
+  if (levelIndex + 1 == levels.size()) {
+    smooth(level.N, system, x, rhs, settings.coarseIterations);
+    return;
+  }
+  smooth(level.N, system, x, rhs, settings.preSmoothIterations);
+  const float residual = computeResidual(level.N, system, x, rhs, level.residual.data());
+  if (levelIndex == 0) {
+    // multigridConvergence.comp, the passes after it return early once the solve has converged
+    if (state->cycles++ == 0)
+      state->initialResidual = residual;
+    state->converged = residual <= settings.tolerance * state->initialResidual;
+    if (state->converged)
+      return;
+  }
+  auto &coarse = levels[levelIndex + 1];
+  restrictResidual(level, &coarse);
+  vCycle(levels, levelIndex + 1, settings, coarsen(system), coarse.x.data(), coarse.rhs.data(), state);
+  prolongate(level.N, system.b, x, coarse.x.data());
+  smooth(level.N, system, x, rhs, settings.postSmoothIterations);
+}
+
+void solveMultigrid(std::vector<Level> &levels, const mg::MultigridSettings &settings, const LinearSystem &system,
+                    float *x, const float *rhs) {
+  SolveState state = {};
+  for (uint32_t i = 0; i < settings.maxCycles && !state.converged; i++)
+    vCycle(levels, 0, settings, system, x, rhs, &state);
+}
+
+void jacobi(uint32_t N, const LinearSystem &system, float *x, const float *rhs, float *scratch, uint32_t sweeps) {
+  for (uint32_t sweep = 0; sweep < sweeps; sweep++) {
+    for (uint32_t j = 1; j <= N; j++) {
+      for (uint32_t i = 1; i <= N; i++)
+        scratch[IX(N, i, j)] = relax(N, system, x, rhs, i, j);
+    }
+    for (uint32_t j = 1; j <= N; j++)
+      memcpy(&x[IX(N, 1, j)], &scratch[IX(N, 1, j)], N * sizeof(float));
+  }
+}
+
+double milliseconds(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// a velocity component made of a few smooth modes plus noise
+std::vector<float> createField(uint32_t N, std::mt19937 &generator) {
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::vector<float> field((N + 2) * (N + 2), 0.0f);
+  const float pi = 3.14159265f;
+  const float phase = pi * unit(generator);
+  for (uint32_t j = 1; j <= N; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const float x = (i - 0.5f) / N, y = (j - 0.5f) / N;
+      field[IX(N, i, j)] = std::sin(2 * pi * x + phase) * std::cos(3 * pi * y) + 0.5f * std::cos(7 * pi * x) +
+                           0.25f * std::sin(19 * pi * y + phase) + 0.1f * unit(generator);
+    }
+  }
+  return field;
+}
+
+// the right side of the pressure solve as preProject.comp computes it, the walls negate the normal velocity
+std::vector<float> computeDivergence(uint32_t N, std::vector<float> u, std::vector<float> v) {
+  for (uint32_t k = 1; k <= N; k++) {
+    u[IX(N, 0, k)] = -u[IX(N, 1, k)];
+    u[IX(N, N + 1, k)] = -u[IX(N, N, k)];
+    v[IX(N, k, 0)] = -v[IX(N, k, 1)];
+    v[IX(N, k, N + 1)] = -v[IX(N, k, N)];
+    u[IX(N, k, 0)] = u[IX(N, k, 1)];
+    u[IX(N, k, N + 1)] = u[IX(N, k, N)];
+    v[IX(N, 0, k)] = v[IX(N, 1, k)];
+    v[IX(N, N + 1, k)] = v[IX(N, N, k)];
+  }
+  std::vector<float> div(u.size(), 0.0f);
+  const float h = 1.0f / N;
+  for (uint32_t j = 1; j <= N; j++) {
+    for (uint32_t i = 1; i <= N; i++)
+      div[IX(N, i, j)] = -0.5f * h *
+                         (u[IX(N, i + 1, j)] - u[IX(N, i - 1, j)] + v[IX(N, i, j + 1)] - v[IX(N, i, j - 1)]);
+  }
+  return div;
+}
+
+struct Measurement {
+  double ms;
+  float reduction; // initial residual / final residual
+  double decadesPerMs() const { return std::log10(std::max(reduction, 1.0f)) / std::max(ms, 1e-6); }
+};
+
+template <typename Solve>
+Measurement measure(uint32_t N, const LinearSystem &system, const std::vector<float> &x0, const std::vector<float> &rhs,
+                    const Solve &solve) {
+  auto x = x0;
+  const float initialResidual = computeResidual(N, system, x.data(), rhs.data(), nullptr);
+  const auto start = std::chrono::high_resolution_clock::now();
+  solve(x.data());
+  const double ms = milliseconds(start);
+  return {ms, initialResidual / computeResidual(N, system, x.data(), rhs.data(), nullptr)};
+}
+
+void run(const char *name, uint32_t N, const LinearSystem &system, const mg::MultigridSettings &settings,
+         const std::vector<float> &x0, const std::vector<float> &rhs) {
+  auto levels = createLevels(N);
+  std::vector<float> scratch(rhs.size());
+  const auto multigrid = measure(N, system, x0, rhs, [&](float *x) {
+    solveMultigrid(levels, settings, system, x, rhs.data());
+  });
+  const auto oldFrame = measure(N, system, x0, rhs, [&](float *x) {
+    jacobi(N, system, x, rhs.data(), scratch.data(), 5);
+  });
+  const auto sweeps = std::max(1u, uint32_t(multigrid.ms / (oldFrame.ms / 5)));
+  const auto equalTime = measure(N, system, x0, rhs, [&](float *x) {
+    jacobi(N, system, x, rhs.data(), scratch.data(), sweeps);
+  });
+
+  LOG(name << " N=" << N << " a=" << system.a << ": multigrid " << multigrid.ms << " ms, residual / "
+           << multigrid.reduction << ", " << multigrid.decadesPerMs() << " decades per ms | jacobi 5 sweeps "
+           << oldFrame.ms << " ms, residual / " << oldFrame.reduction << ", " << oldFrame.decadesPerMs()
+           << " decades per ms | jacobi " << sweeps << " sweeps " << equalTime.ms << " ms, residual / "
+           << equalTime.reduction << ", " << equalTime.decadesPerMs() << " decades per ms");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::vector<uint32_t> sizes = {256, 512, 1024, 2048};
+  float visc = 0.0001f, dt = 0.1f;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--size=", 0) == 0)
+      sizes = {std::max(16u, uint32_t(std::stoul(arg.substr(strlen("--size=")))))};
+    else if (arg.rfind("--visc=", 0) == 0)
+      visc = std::stof(arg.substr(strlen("--visc=")));
+    else if (arg.rfind("--dt=", 0) == 0)
+      dt = std::stof(arg.substr(strlen("--dt=")));
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  const mg::NavierStokeSettings settings;
+  std::mt19937 generator(1);
+  for (const auto N : sizes) {
+    // diffusion of u starts from the field it diffuses, the pressure from zero with the divergence on the right side
+    const auto u = createField(N, generator), v = createField(N, generator);
+    const float a = dt * visc * N * N;
+    run("diffusion", N, {1, a, 1 + 4 * a}, settings.diffusion, u, u);
+    run("pressure", N, {0, 1, 4}, settings.pressure, std::vector<float>(u.size(), 0.0f), computeDivergence(N, u, v));
+  }
+  return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Kept apart from navier_stoke.h so the cpu solver benchmark can use the same defaults without vulkan
+namespace mg {
+
+struct MultigridSettings {
+  uint32_t maxCycles;
+  uint32_t preSmoothIterations;
+  uint32_t postSmoothIterations;
+  uint32_t coarseIterations;
+  float tolerance; // relative to the residual of the first cycle
+};
+
+struct NavierStokeSettings {
+  MultigridSettings pressure = {.maxCycles = 4,
+                                .preSmoothIterations = 2,
+                                .postSmoothIterations = 2,
+                                .coarseIterations = 16,
+                                .tolerance = 1e-3f};
+  MultigridSettings diffusion = {.maxCycles = 2,
+                                 .preSmoothIterations = 2,
+                                 .postSmoothIterations = 2,
+                                 .coarseIterations = 8,
+                                 .tolerance = 1e-4f};
+};
+
+} // namespace mg
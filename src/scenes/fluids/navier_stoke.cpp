@@ -3,6 +3,17 @@
 #include "mg/mgSystem.h"
 #include "mg/window.h"
 #include "rendering/rendering.h"
+#include "shaders/addSource.h"
+#include "shaders/advec.h"
+#include "shaders/advectVelocity.h"
+#include "shaders/multigridConvergence.h"
+#include "shaders/multigridProlongate.h"
+#include "shaders/multigridResidual.h"
+#include "shaders/multigridRestrict.h"
+#include "shaders/postProject.h"
+#include "shaders/preProject.h"
+#include "shaders/redBlackSmooth.h"
+#include "shaders/setBoundary.h"
 #include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -11,231 +22,345 @@
 
 namespace mg {
 
-static size_t gridSize(size_t N) { return (N + 2) * (N + 2); }
-
-static void diffuse(int32_t N, int32_t b, mg::StorageId x, mg::StorageId x0, float diff, float dt) {
-  using namespace mg::shaders::diffuse;
-
-  mg::PipelineStateDesc pipelineStateDesc = {};
-  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
-
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
-
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->dt = dt;
-  ubo->N = N;
-  ubo->diff = diff;
-  ubo->b = b;
-
-  DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.x = mg::mgSystem.storageContainer.getStorage(x).descriptorSet;
-  descriptorSets.x0 = mg::mgSystem.storageContainer.getStorage(x0).descriptorSet;
-
-  vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+// diffusion of u, v and the density plus two projections
+enum { MaxNrOfSolvesPerStep = 8 };
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+struct SolveState {
+  uint32_t residual;
+  uint32_t initialResidual;
+  uint32_t converged;
+  uint32_t cycles;
+};
 
-  vkCmdDispatch(mg::vkContext.commandBuffer, uint32_t(gridSize(N)) / 256, 1, 1);
+static size_t gridSize(size_t N) { return (N + 2) * (N + 2); }
+static uint32_t nrOfGroups(uint32_t nrOfInvocations, uint32_t groupSize) {
+  return (nrOfInvocations + groupSize - 1) / groupSize;
+}
 
-  // setup a memory barrier, device memory has to be finished with writing when reading occurs on
-  // the host
+struct FluidPipelines {
+  mg::Pipeline addSource, advect, advectVelocity, preProject, postProject;
+  mg::Pipeline redBlackSmooth, residual, restriction, prolongate, convergence, setBoundary;
+};
+
+// Commands of a step, the pipeline is only bound when it changes
+struct StepRecorder {
+  VkCommandBuffer commandBuffer;
+  VkPipeline boundPipeline;
+  uint32_t nrOfSolves;
+  FluidPipelines pipelines;
+};
+
+// All passes of a step share one barrier, it covers both the compute passes and the buffer copies and fills
+static void barrier(StepRecorder *recorder) {
   VkMemoryBarrier memoryBarrier = {};
   memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT |
+                                VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+  vkCmdPipelineBarrier(recorder->commandBuffer, stages, stages, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
 }
 
-static void advect(int32_t N, int32_t b, mg::StorageId d, mg::StorageId d0, mg::StorageId u, mg::StorageId v, float dt) {
-  using namespace mg::shaders::advec;
-
-  mg::PipelineStateDesc pipelineStateDesc = {};
-  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
-
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+// the fluid passes only use push constants, set 0 (the uniform buffer) is left unbound
+static void dispatch(StepRecorder *recorder, const mg::Pipeline &pipeline, const VkDescriptorSet *descriptorSets,
+                     uint32_t nrOfDescriptorSets, const void *pushConstants, uint32_t pushConstantsSize,
+                     uint32_t groupCountX, uint32_t groupCountY = 1) {
+  if (recorder->boundPipeline != pipeline.pipeline) {
+    vkCmdBindPipeline(recorder->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    recorder->boundPipeline = pipeline.pipeline;
+  }
+  vkCmdBindDescriptorSets(recorder->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 1,
+                          nrOfDescriptorSets, descriptorSets, 0, nullptr);
+  vkCmdPushConstants(recorder->commandBuffer, pipeline.layout, VK_SHADER_STAGE_ALL, 0, pushConstantsSize,
+                     pushConstants);
+  vkCmdDispatch(recorder->commandBuffer, groupCountX, groupCountY, 1);
+}
 
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->dt = dt;
-  ubo->N = N;
-  ubo->b = b;
+static void copyBuffer(StepRecorder *recorder, uint32_t N, const FluidBuffer &dst, const FluidBuffer &src) {
+  VkBufferCopy region = {};
+  region.size = gridSize(N) * sizeof(float);
+  vkCmdCopyBuffer(recorder->commandBuffer, src.buffer, dst.buffer, 1, &region);
+}
 
-  DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.u = mg::mgSystem.storageContainer.getStorage(u).descriptorSet;
-  descriptorSets.v = mg::mgSystem.storageContainer.getStorage(v).descriptorSet;
-  descriptorSets.d = mg::mgSystem.storageContainer.getStorage(d).descriptorSet;
-  descriptorSets.d0 = mg::mgSystem.storageContainer.getStorage(d0).descriptorSet;
+// c * x - a * (sum of the four neighbours) = rhs, with the ghost cells mirroring the boundary cells as in set_bnd
+struct LinearSystem {
+  int32_t b;
+  float a, c;
+};
+
+// Cell centered coarsening halves the grid spacing, which scales the neighbour coupling by 1/4 per level
+static LinearSystem coarsen(const LinearSystem &system) {
+  const float diagonal = system.c - 4 * system.a;
+  const float a = system.a * 0.25f;
+  return {.b = system.b, .a = a, .c = diagonal + 4 * a};
+}
 
-  vkCmdBindPipeline(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+struct Solve {
+  const FluidSolver &fluidSolver;
+  const MultigridSettings &settings;
+  uint32_t index;
+};
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+static void smooth(StepRecorder *recorder, const Solve &solve, uint32_t N, const LinearSystem &system,
+                   const FluidBuffer &x, const FluidBuffer &rhs, uint32_t iterations) {
+  using namespace mg::shaders::redBlackSmooth;
 
-  vkCmdDispatch(vkContext.commandBuffer, uint32_t(gridSize(N)) / 256, 1, 1);
+  DescriptorSets descriptorSets = {};
+  descriptorSets.x = x.descriptorSet;
+  descriptorSets.rhs = rhs.descriptorSet;
+  descriptorSets.state = solve.fluidSolver.multigrid.states.descriptorSet;
+
+  const uint32_t groupCount = nrOfGroups(N * ((N + 1) / 2), 256);
+  for (uint32_t i = 0; i < iterations; i++) {
+    for (uint32_t color = 0; color < 2; color++) {
+      Level level = {
+          .N = N, .b = uint32_t(system.b), .color = color, .a = system.a, .c = system.c, .solve = solve.index};
+      dispatch(recorder, recorder->pipelines.redBlackSmooth, descriptorSets.values,
+               mg::countof(descriptorSets.values), &level, sizeof(level), groupCount);
+      barrier(recorder);
+    }
+  }
+}
 
-  VkMemoryBarrier memoryBarrier = {};
-  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+static void residual(StepRecorder *recorder, const Solve &solve, uint32_t N, const LinearSystem &system,
+                     const FluidBuffer &x, const FluidBuffer &rhs, const FluidBuffer &residual, bool trackResidual) {
+  using namespace mg::shaders::multigridResidual;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  DescriptorSets descriptorSets = {};
+  descriptorSets.x = x.descriptorSet;
+  descriptorSets.rhs = rhs.descriptorSet;
+  descriptorSets.residual = residual.descriptorSet;
+  descriptorSets.state = solve.fluidSolver.multigrid.states.descriptorSet;
+
+  Level level = {.N = N,
+                 .b = uint32_t(system.b),
+                 .trackResidual = trackResidual,
+                 .a = system.a,
+                 .c = system.c,
+                 .solve = solve.index};
+  dispatch(recorder, recorder->pipelines.residual, descriptorSets.values, mg::countof(descriptorSets.values),
+           &level, sizeof(level), nrOfGroups(N * N, 256));
+  barrier(recorder);
 }
 
-static void preProjectCompute(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId p, mg::StorageId div) {
-  using namespace mg::shaders::preProject;
+static void checkConvergence(StepRecorder *recorder, const Solve &solve) {
+  using namespace mg::shaders::multigridConvergence;
 
-  mg::PipelineStateDesc pipelineStateDesc = {};
-  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+  DescriptorSets descriptorSets = {};
+  descriptorSets.state = solve.fluidSolver.multigrid.states.descriptorSet;
 
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+  Level level = {.solve = solve.index, .tolerance = solve.settings.tolerance};
+  dispatch(recorder, recorder->pipelines.convergence, descriptorSets.values,
+           mg::countof(descriptorSets.values), &level, sizeof(level), 1);
+  barrier(recorder);
+}
 
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->N = N;
+static void restrictResidual(StepRecorder *recorder, const Solve &solve, const FluidBuffer &residual,
+                             const MultigridLevel &coarse) {
+  using namespace mg::shaders::multigridRestrict;
 
   DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.u = mg::mgSystem.storageContainer.getStorage(u).descriptorSet;
-  descriptorSets.v = mg::mgSystem.storageContainer.getStorage(v).descriptorSet;
-  descriptorSets.p = mg::mgSystem.storageContainer.getStorage(p).descriptorSet;
-  descriptorSets.div = mg::mgSystem.storageContainer.getStorage(div).descriptorSet;
+  descriptorSets.residual = residual.descriptorSet;
+  descriptorSets.rhs = coarse.rhs.descriptorSet;
+  descriptorSets.x = coarse.x.descriptorSet;
+  descriptorSets.state = solve.fluidSolver.multigrid.states.descriptorSet;
+
+  Level level = {.N = coarse.N, .solve = solve.index};
+  dispatch(recorder, recorder->pipelines.restriction, descriptorSets.values,
+           mg::countof(descriptorSets.values), &level, sizeof(level), nrOfGroups(coarse.N * coarse.N, 256));
+  barrier(recorder);
+}
 
-  vkCmdBindPipeline(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+static void prolongate(StepRecorder *recorder, const Solve &solve, uint32_t N, int32_t b, const FluidBuffer &x,
+                       const FluidBuffer &coarseX) {
+  using namespace mg::shaders::multigridProlongate;
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+  DescriptorSets descriptorSets = {};
+  descriptorSets.x = x.descriptorSet;
+  descriptorSets.coarse = coarseX.descriptorSet;
+  descriptorSets.state = solve.fluidSolver.multigrid.states.descriptorSet;
+
+  Level level = {.N = N, .b = uint32_t(b), .solve = solve.index};
+  dispatch(recorder, recorder->pipelines.prolongate, descriptorSets.values,
+           mg::countof(descriptorSets.values), &level, sizeof(level), nrOfGroups(N * N, 256));
+  barrier(recorder);
+}
 
-  vkCmdDispatch(vkContext.commandBuffer, uint32_t(gridSize(N)) / 256, 1, 1);
+static void setBoundary(StepRecorder *recorder, const FluidSolver &fluidSolver, int32_t b, const FluidBuffer &x) {
+  using namespace mg::shaders::setBoundary;
 
-  VkMemoryBarrier memoryBarrier = {};
-  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+  DescriptorSets descriptorSets = {};
+  descriptorSets.x = x.descriptorSet;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  Level level = {.N = fluidSolver.N, .b = uint32_t(b)};
+  dispatch(recorder, recorder->pipelines.setBoundary, descriptorSets.values, mg::countof(descriptorSets.values),
+           &level, sizeof(level), nrOfGroups(fluidSolver.N, 256));
+  barrier(recorder);
 }
-static void projectCompute(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId p, mg::StorageId div) {
-  using namespace mg::shaders::project;
 
-  mg::PipelineStateDesc pipelineStateDesc = {};
-  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+static void vCycle(StepRecorder *recorder, const Solve &solve, uint32_t levelIndex, const LinearSystem &system,
+                   const FluidBuffer &x, const FluidBuffer &rhs) {
+  const auto &levels = solve.fluidSolver.multigrid.levels;
+  const auto &level = levels[levelIndex];
+  const bool isFinest = levelIndex == 0;
 
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+  if (levelIndex + 1 == levels.size()) {
+    smooth(recorder, solve, level.N, system, x, rhs, solve.settings.coarseIterations);
+    return;
+  }
+  const auto &coarse = levels[levelIndex + 1];
 
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->N = N;
+  smooth(recorder, solve, level.N, system, x, rhs, solve.settings.preSmoothIterations);
+  residual(recorder, solve, level.N, system, x, rhs, level.residual, isFinest);
+  if (isFinest)
+    checkConvergence(recorder, solve);
 
-  DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.u = mg::mgSystem.storageContainer.getStorage(u).descriptorSet;
-  descriptorSets.v = mg::mgSystem.storageContainer.getStorage(v).descriptorSet;
-  descriptorSets.p = mg::mgSystem.storageContainer.getStorage(p).descriptorSet;
-  descriptorSets.div = mg::mgSystem.storageContainer.getStorage(div).descriptorSet;
+  restrictResidual(recorder, solve, level.residual, coarse);
+  vCycle(recorder, solve, levelIndex + 1, coarsen(system), coarse.x, coarse.rhs);
+  prolongate(recorder, solve, level.N, system.b, x, coarse.x);
 
-  vkCmdBindPipeline(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  smooth(recorder, solve, level.N, system, x, rhs, solve.settings.postSmoothIterations);
+}
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+// Runs V-cycles until the max norm of the finest residual has dropped below the tolerance or maxCycles is reached.
+// The convergence test is done on the gpu, the passes of the remaining cycles return early instead of stalling the
+// cpu on a read back. The ghost cells of x are not written.
+static void solveMultigrid(StepRecorder *recorder, const FluidSolver &fluidSolver, const MultigridSettings &settings,
+                           const LinearSystem &system, const FluidBuffer &x, const FluidBuffer &rhs) {
+  mgAssert(recorder->nrOfSolves < MaxNrOfSolvesPerStep);
+  const Solve solve = {.fluidSolver = fluidSolver, .settings = settings, .index = recorder->nrOfSolves++};
+
+  for (uint32_t i = 0; i < settings.maxCycles; i++) {
+    vCycle(recorder, solve, 0, system, x, rhs);
+  }
+}
 
-  vkCmdDispatch(vkContext.commandBuffer, uint32_t(gridSize(N)) / 256, 1, 1);
+// x0 is also the initial guess, and the exact solution when there is no diffusion
+static void diffuse(StepRecorder *recorder, const FluidSolver &fluidSolver, const MultigridSettings &settings,
+                    int32_t b, const FluidBuffer &x, const FluidBuffer &x0, float diff, float dt) {
+  const auto N = fluidSolver.N;
+  const float a = dt * diff * N * N;
 
-  VkMemoryBarrier memoryBarrier = {};
-  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+  copyBuffer(recorder, N, x, x0);
+  if (a == 0.0f)
+    return;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+  barrier(recorder);
+  solveMultigrid(recorder, fluidSolver, settings, {.b = b, .a = a, .c = 1 + 4 * a}, x, x0);
+  setBoundary(recorder, fluidSolver, b, x);
 }
 
-static void postProjectCompute(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId p, mg::StorageId div) {
-  using namespace mg::shaders::postProject;
-
-  mg::PipelineStateDesc pipelineStateDesc = {};
-  pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
+static void advect(StepRecorder *recorder, const FluidSolver &fluidSolver, int32_t b, const FluidBuffer &d,
+                   const FluidBuffer &d0, const FluidBuffer &u, const FluidBuffer &v, float dt) {
+  using namespace mg::shaders::advec;
 
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
+  DescriptorSets descriptorSets = {};
+  descriptorSets.u = u.descriptorSet;
+  descriptorSets.v = v.descriptorSet;
+  descriptorSets.d = d.descriptorSet;
+  descriptorSets.d0 = d0.descriptorSet;
+
+  Advect advect = {.N = fluidSolver.N, .b = uint32_t(b), .dt = dt};
+  dispatch(recorder, recorder->pipelines.advect, descriptorSets.values, mg::countof(descriptorSets.values), &advect,
+           sizeof(advect), nrOfGroups(fluidSolver.N * fluidSolver.N, 256));
+}
 
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->N = N;
+static void advectVelocity(StepRecorder *recorder, const FluidSolver &fluidSolver, const FluidBuffer &u,
+                           const FluidBuffer &v, const FluidBuffer &u0, const FluidBuffer &v0, float dt) {
+  using namespace mg::shaders::advectVelocity;
 
   DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.u = mg::mgSystem.storageContainer.getStorage(u).descriptorSet;
-  descriptorSets.v = mg::mgSystem.storageContainer.getStorage(v).descriptorSet;
-  descriptorSets.p = mg::mgSystem.storageContainer.getStorage(p).descriptorSet;
-  descriptorSets.div = mg::mgSystem.storageContainer.getStorage(div).descriptorSet;
+  descriptorSets.u = u.descriptorSet;
+  descriptorSets.v = v.descriptorSet;
+  descriptorSets.u0 = u0.descriptorSet;
+  descriptorSets.v0 = v0.descriptorSet;
+
+  Advect advect = {.N = fluidSolver.N, .dt = dt};
+  dispatch(recorder, recorder->pipelines.advectVelocity, descriptorSets.values, mg::countof(descriptorSets.values),
+           &advect, sizeof(advect), nrOfGroups(fluidSolver.N * fluidSolver.N, 256));
+}
 
-  vkCmdBindPipeline(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+static void project(StepRecorder *recorder, const FluidSolver &fluidSolver, const MultigridSettings &settings,
+                    const FluidBuffer &u, const FluidBuffer &v, const FluidBuffer &p, const FluidBuffer &div) {
+  const auto N = fluidSolver.N;
+  const auto tileCount = nrOfGroups(N, 16);
+  {
+    using namespace mg::shaders::preProject;
+    DescriptorSets descriptorSets = {};
+    descriptorSets.u = u.descriptorSet;
+    descriptorSets.v = v.descriptorSet;
+    descriptorSets.p = p.descriptorSet;
+    descriptorSets.div = div.descriptorSet;
+
+    Project project = {.N = N};
+    dispatch(recorder, recorder->pipelines.preProject, descriptorSets.values, mg::countof(descriptorSets.values),
+             &project, sizeof(project), tileCount, tileCount);
+    barrier(recorder);
+  }
+
+  // postProject mirrors the pressure at the walls itself, so the solve does not need a boundary pass
+  solveMultigrid(recorder, fluidSolver, settings, {.b = 0, .a = 1, .c = 4}, p, div);
+
+  {
+    using namespace mg::shaders::postProject;
+    DescriptorSets descriptorSets = {};
+    descriptorSets.u = u.descriptorSet;
+    descriptorSets.v = v.descriptorSet;
+    descriptorSets.p = p.descriptorSet;
+
+    Project project = {.N = N};
+    dispatch(recorder, recorder->pipelines.postProject, descriptorSets.values, mg::countof(descriptorSets.values),
+             &project, sizeof(project), tileCount, tileCount);
+    barrier(recorder);
+  }
+}
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+static void addSource(StepRecorder *recorder, const FluidSolver &fluidSolver, const mg::FrameData &frameData) {
+  using namespace mg::shaders::addSource;
+  const auto N = fluidSolver.N;
+  const auto &storages = fluidSolver.storages;
 
-  vkCmdDispatch(vkContext.commandBuffer, uint32_t(gridSize(N)) / 256, 1, 1);
+  DescriptorSets descriptorSets = {};
+  descriptorSets.u = storages.u.descriptorSet;
+  descriptorSets.v = storages.v.descriptorSet;
+  descriptorSets.d = storages.d.descriptorSet;
+
+  Source source = {};
+  source.delta = frameData.mouse.xy - frameData.mouse.prevXY;
+  source.i = int32_t(frameData.mouse.xy.x * N);
+  source.j = int32_t((1.0f - frameData.mouse.xy.y) * N);
+  source.N = N;
+  dispatch(recorder, recorder->pipelines.addSource, descriptorSets.values, mg::countof(descriptorSets.values),
+           &source, sizeof(source), 1);
+}
 
-  VkMemoryBarrier memoryBarrier = {};
-  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+static void step(StepRecorder *recorder, const FluidSolver &fluidSolver, const NavierStokeSettings &settings,
+                 const mg::FrameData &frameData, float visc, float dt) {
+  const auto &[u, v, u0, v0, d, s] = fluidSolver.storages;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
-}
+  // the previous step may still read the solve states
+  barrier(recorder);
+  vkCmdFillBuffer(recorder->commandBuffer, fluidSolver.multigrid.states.buffer, 0, VK_WHOLE_SIZE, 0);
+  if (frameData.mouse.left)
+    addSource(recorder, fluidSolver, frameData);
+  barrier(recorder);
 
-static void project(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId p, mg::StorageId div) {
-  preProjectCompute(N, u, v, p, div);
-  projectCompute(N, u, v, p, div);
-  postProjectCompute(N, u, v, p, div);
-}
+  // independent outputs, so both diffusions share the barrier
+  diffuse(recorder, fluidSolver, settings.diffusion, 1, u0, u, visc, dt);
+  diffuse(recorder, fluidSolver, settings.diffusion, 2, v0, v, visc, dt);
+  barrier(recorder);
 
-static void step(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId u0, mg::StorageId v0, mg::StorageId d,
-                 mg::StorageId s, float visc, float dt) {
-  diffuse(N, 1, u0, u, visc, dt);
-  diffuse(N, 2, v0, v, visc, dt);
+  project(recorder, fluidSolver, settings.pressure, u0, v0, u, v);
 
-  project(N, u0, v0, u, v);
+  advectVelocity(recorder, fluidSolver, u, v, u0, v0, dt);
+  barrier(recorder);
 
-  advect(N, 1, u, u0, u0, v0, dt);
-  advect(N, 2, v, v0, u0, v0, dt);
+  project(recorder, fluidSolver, settings.pressure, u, v, u0, v0);
 
-  project(N, u, v, u0, v0);
-  diffuse(N, 0, s, d, 0, dt);
-  advect(N, 0, d, s, u, v, dt);
+  diffuse(recorder, fluidSolver, settings.diffusion, 0, s, d, 0, dt);
+  barrier(recorder);
+  advect(recorder, fluidSolver, 0, d, s, u, v, dt);
 
   // barrier for fragment shader to read compute shader output
   VkMemoryBarrier memoryBarrier = {};
@@ -243,87 +368,115 @@ static void step(int32_t N, mg::StorageId u, mg::StorageId v, mg::StorageId u0,
   memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
   memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+  vkCmdPipelineBarrier(recorder->commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
 }
 
-static void updateFromGui(int32_t N, mg::StorageId d, mg::StorageId u, mg::StorageId v, const mg::FrameData &frameData) {
-  int32_t i = int(frameData.mouse.xy.x * N);
-  int32_t j = int((1.0f - frameData.mouse.xy.y) * N);
-  auto delta = frameData.mouse.xy - frameData.mouse.prevXY;
-
-  using namespace mg::shaders::addSource;
-
+// looked up every frame, a shader that is hot reloaded replaces its pipeline and the old one is destroyed a few frames
+// later
+static FluidPipelines getFluidPipelines() {
   mg::PipelineStateDesc pipelineStateDesc = {};
   pipelineStateDesc.compute.pipelineLayout = mg::vkContext.pipelineLayouts.pipelineLayoutStorage;
 
-  const auto pipeline = mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shader});
-
-  VkBuffer uniformBuffer;
-  uint32_t uniformOffset;
-  VkDescriptorSet uboSet;
-  Ubo *ubo =
-      (Ubo *)mg::mgSystem.linearHeapAllocator.allocateUniform(sizeof(Ubo), &uniformBuffer, &uniformOffset, &uboSet);
-  ubo->N = N;
-  ubo->i = i;
-  ubo->j = j;
-  ubo->delta = delta;
-
-  DescriptorSets descriptorSets = {};
-  descriptorSets.ubo = uboSet;
-  descriptorSets.u = mg::mgSystem.storageContainer.getStorage(u).descriptorSet;
-  descriptorSets.v = mg::mgSystem.storageContainer.getStorage(v).descriptorSet;
-  descriptorSets.d = mg::mgSystem.storageContainer.getStorage(d).descriptorSet;
-
-  vkCmdBindPipeline(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  auto create = [&pipelineStateDesc](const char *shaderName) {
+    return mg::mgSystem.pipelineContainer.createComputePipeline(pipelineStateDesc, {.shaderName = shaderName});
+  };
+
+  FluidPipelines pipelines = {};
+  pipelines.addSource = create(mg::shaders::addSource::shader);
+  pipelines.advect = create(mg::shaders::advec::shader);
+  pipelines.advectVelocity = create(mg::shaders::advectVelocity::shader);
+  pipelines.preProject = create(mg::shaders::preProject::shader);
+  pipelines.postProject = create(mg::shaders::postProject::shader);
+  pipelines.redBlackSmooth = create(mg::shaders::redBlackSmooth::shader);
+  pipelines.residual = create(mg::shaders::multigridResidual::shader);
+  pipelines.restriction = create(mg::shaders::multigridRestrict::shader);
+  pipelines.prolongate = create(mg::shaders::multigridProlongate::shader);
+  pipelines.convergence = create(mg::shaders::multigridConvergence::shader);
+  pipelines.setBoundary = create(mg::shaders::setBoundary::shader);
+  return pipelines;
+}
 
-  uint32_t dynamicOffsets[] = {uniformOffset, 0};
-  vkCmdBindDescriptorSets(vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0,
-                          mg::countof(descriptorSets.values), descriptorSets.values, mg::countof(dynamicOffsets),
-                          dynamicOffsets);
+void simulateNavierStoke(const FluidSolver &fluidSolver, const NavierStokeSettings &settings,
+                         const mg::FrameData &frameData) {
+  const float dt = 0.1f;
+  StepRecorder recorder = {.commandBuffer = mg::vkContext.commandBuffer, .boundPipeline = VK_NULL_HANDLE,
+                           .nrOfSolves = 0, .pipelines = getFluidPipelines()};
+  step(&recorder, fluidSolver, settings, frameData, 0, dt);
+}
 
-  vkCmdDispatch(vkContext.commandBuffer, 1, 1, 1);
+void renderNavierStoke(const mg::RenderContext &renderContext, const FluidSolver &fluidSolver) {
+  renderFluid(renderContext, fluidSolver.storages.d.id);
+}
 
-  VkMemoryBarrier memoryBarrier = {};
-  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-  memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+static FluidBuffer createFluidBuffer(void *data, uint32_t sizeInBytes) {
+  FluidBuffer fluidBuffer = {};
+  fluidBuffer.id = mg::mgSystem.storageContainer.createStorage(data, sizeInBytes);
+  const auto storage = mg::mgSystem.storageContainer.getStorage(fluidBuffer.id);
+  fluidBuffer.buffer = storage.buffer;
+  fluidBuffer.descriptorSet = storage.descriptorSet;
+  return fluidBuffer;
+}
 
-  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+static FluidBuffer createGrid(uint32_t N) {
+  std::vector<float> empty(gridSize(N));
+  return createFluidBuffer(empty.data(), mg::sizeofContainerInBytes(empty));
 }
 
-void simulateNavierStoke(const Storages &storages, const mg::FrameData &frameData, uint32_t N) {
-  const float dt = 0.1f;
-  if (frameData.mouse.left)
-    updateFromGui(N, storages.d, storages.u, storages.v, frameData);
-  step(N, storages.u, storages.v, storages.u0, storages.v0, storages.d, storages.s, 0, dt);
+// levels are halved while the grid stays even and above the coarsest size
+static Multigrid createMultigrid(uint32_t N) {
+  constexpr uint32_t minCoarseN = 8;
+
+  Multigrid multigrid = {};
+  multigrid.levels.push_back({.N = N, .x = {}, .rhs = {}, .residual = createGrid(N)});
+  while (N % 2 == 0 && N / 2 >= minCoarseN) {
+    N /= 2;
+    multigrid.levels.push_back({.N = N, .x = createGrid(N), .rhs = createGrid(N), .residual = {}});
+  }
+  // only the coarsest level is solved directly and does not need a residual
+  mgAssert(multigrid.levels.size() > 1);
+  for (size_t i = 1; i + 1 < multigrid.levels.size(); i++)
+    multigrid.levels[i].residual = createGrid(multigrid.levels[i].N);
+
+  SolveState states[MaxNrOfSolvesPerStep] = {};
+  multigrid.states = createFluidBuffer(states, sizeof(states));
+  return multigrid;
 }
 
-void renderNavierStoke(const mg::RenderContext &renderContext, const Storages &storages) {
-  renderFluid(renderContext, storages.d);
+static void destroyMultigrid(Multigrid *multigrid) {
+  for (size_t i = 0; i < multigrid->levels.size(); i++) {
+    const auto &level = multigrid->levels[i];
+    if (i > 0) {
+      mg::mgSystem.storageContainer.removeStorage(level.x.id);
+      mg::mgSystem.storageContainer.removeStorage(level.rhs.id);
+    }
+    if (i + 1 < multigrid->levels.size())
+      mg::mgSystem.storageContainer.removeStorage(level.residual.id);
+  }
+  mg::mgSystem.storageContainer.removeStorage(multigrid->states.id);
+  *multigrid = {};
 }
 
-Storages createStorages(size_t N) {
-  std::vector<float> empty(gridSize(N));
-  const auto sizeInBytes = mg::sizeofContainerInBytes(empty);
-
-  return {.u = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes),
-          .v = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes),
-          .u0 = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes),
-          .v0 = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes),
-          .d = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes),
-          .s = mg::mgSystem.storageContainer.createStorage(empty.data(), sizeInBytes)};
+FluidSolver createFluidSolver(uint32_t N) {
+  FluidSolver fluidSolver = {};
+  fluidSolver.N = N;
+  fluidSolver.storages = {.u = createGrid(N),
+                          .v = createGrid(N),
+                          .u0 = createGrid(N),
+                          .v0 = createGrid(N),
+                          .d = createGrid(N),
+                          .s = createGrid(N)};
+  fluidSolver.multigrid = createMultigrid(N);
+  return fluidSolver;
 }
 
-void destroyStorages(Storages *storages) {
-  mg::mgSystem.storageContainer.removeStorage(storages->u);
-  mg::mgSystem.storageContainer.removeStorage(storages->v);
-  mg::mgSystem.storageContainer.removeStorage(storages->u0);
-  mg::mgSystem.storageContainer.removeStorage(storages->v0);
-  mg::mgSystem.storageContainer.removeStorage(storages->d);
-  mg::mgSystem.storageContainer.removeStorage(storages->s);
-  *storages = {};
+void destroyFluidSolver(FluidSolver *fluidSolver) {
+  auto &storages = fluidSolver->storages;
+  for (const auto &fluidBuffer : {storages.u, storages.v, storages.u0, storages.v0, storages.d, storages.s}) {
+    mg::mgSystem.storageContainer.removeStorage(fluidBuffer.id);
+  }
+  destroyMultigrid(&fluidSolver->multigrid);
+  *fluidSolver = {};
 }
 
-} // namespace mg
\ No newline at end of file
+} // namespace mg
@@ -1,17 +1,46 @@
 #pragma once
 #include "mg/storageContainer.h"
+#include "multigrid_settings.h"
+#include "vulkan/pipelineContainer.h"
 #include <cstdint>
+#include <vector>
 
 namespace mg {
 struct FrameData;
 struct RenderContext;
 
+// the buffer and descriptor set are looked up once when the storage is created
+struct FluidBuffer {
+  mg::StorageId id;
+  VkBuffer buffer;
+  VkDescriptorSet descriptorSet;
+};
+
+// the finest level solves directly into the caller's x and rhs, so only its residual is owned here
+struct MultigridLevel {
+  uint32_t N;
+  FluidBuffer x, rhs, residual;
+};
+
+struct Multigrid {
+  std::vector<MultigridLevel> levels;
+  FluidBuffer states; // residual norm and convergence flag, one entry per solve in a step
+};
+
 struct Storages {
-  mg::StorageId u, v, u0, v0, d, s;
+  FluidBuffer u, v, u0, v0, d, s;
+};
+
+// The buffers of a step are created up front, its pipelines are looked up when the step is recorded
+struct FluidSolver {
+  uint32_t N;
+  Storages storages;
+  Multigrid multigrid;
 };
 
-Storages createStorages(size_t N);
-void destroyStorages(Storages *storages);
-void simulateNavierStoke(const Storages &storages, const mg::FrameData &frameData, uint32_t N);
-void renderNavierStoke(const mg::RenderContext &renderContext, const Storages &storages);
-} // namespace mg
\ No newline at end of file
+FluidSolver createFluidSolver(uint32_t N);
+void destroyFluidSolver(FluidSolver *fluidSolver);
+void simulateNavierStoke(const FluidSolver &fluidSolver, const NavierStokeSettings &settings,
+                         const mg::FrameData &frameData);
+void renderNavierStoke(const mg::RenderContext &renderContext, const FluidSolver &fluidSolver);
+} // namespace mg
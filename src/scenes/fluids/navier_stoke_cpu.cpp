@@ -0,0 +1,378 @@
+#include "navier_stoke_cpu.h"
+#include "mg/mgAssert.h"
+#include "mg/workerPool.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include <pmmintrin.h>
+
+static constexpr uint32_t SIMD_NR_FLOATS = 8;
+static constexpr uint32_t MIN_ROWS_PER_BAND = 8;
+
+// The fields decay towards zero far from the sources, denormals there would slow down every pass many times over.
+// Both the scalar and the simd path run with the same mode, so they still give the same results.
+static constexpr uint32_t FLUSH_DENORMALS = _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON;
+
+// job(rowBegin, rowEnd) is called for the bands firstBand, firstBand + bandStep, ... of the interior rows [1, N].
+// The pool threads do not share the floating point mode of the caller, so every chunk sets it.
+template <typename Job>
+static void parallelBands(mg::WorkerPool *workers, uint32_t N, uint32_t firstBand, uint32_t bandStep, const Job &job) {
+  const uint32_t rowsPerBand = std::max(MIN_ROWS_PER_BAND, N / (workers->nrOfThreads() * 8));
+  const uint32_t nrOfBands = (N + rowsPerBand - 1) / rowsPerBand;
+  if (firstBand >= nrOfBands)
+    return;
+  const uint32_t count = (nrOfBands - firstBand + bandStep - 1) / bandStep;
+  workers->parallelFor(count, 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+    const auto csr = _mm_getcsr();
+    _mm_setcsr(csr | FLUSH_DENORMALS);
+    for (uint32_t band = begin; band < end; band++) {
+      const uint32_t row = 1 + (firstBand + band * bandStep) * rowsPerBand;
+      job(row, std::min(row + rowsPerBand, N + 1));
+    }
+    _mm_setcsr(csr);
+  });
+}
+
+// every pass other than the linear solve reads only cells that no row of the same pass writes
+template <typename Job> static void parallelRows(mg::WorkerPool *workers, uint32_t N, const Job &job) {
+  parallelBands(workers, N, 0, 1, job);
+}
+
+static size_t IX(uint32_t N, uint32_t i, uint32_t j) { return i + size_t(j) * (N + 2); }
+
+static void setBoundary(uint32_t N, int32_t b, float *x) {
+  for (uint32_t i = 1; i <= N; i++) {
+    x[IX(N, 0, i)] = b == 1 ? -x[IX(N, 1, i)] : x[IX(N, 1, i)];
+    x[IX(N, N + 1, i)] = b == 1 ? -x[IX(N, N, i)] : x[IX(N, N, i)];
+    x[IX(N, i, 0)] = b == 2 ? -x[IX(N, i, 1)] : x[IX(N, i, 1)];
+    x[IX(N, i, N + 1)] = b == 2 ? -x[IX(N, i, N)] : x[IX(N, i, N)];
+  }
+  x[IX(N, 0, 0)] = 0.5f * (x[IX(N, 1, 0)] + x[IX(N, 0, 1)]);
+  x[IX(N, 0, N + 1)] = 0.5f * (x[IX(N, 1, N + 1)] + x[IX(N, 0, N)]);
+  x[IX(N, N + 1, 0)] = 0.5f * (x[IX(N, N, 0)] + x[IX(N, N + 1, 1)]);
+  x[IX(N, N + 1, N + 1)] = 0.5f * (x[IX(N, N, N + 1)] + x[IX(N, N + 1, N)]);
+}
+
+// The scalar and simd kernels below evaluate every expression in the same order, so both round identically.
+// They are compiled without fma contraction, which would otherwise change the rounding of a * b + c.
+
+// one color of a red-black Gauss-Seidel sweep, the cells where (i + j) % 2 == color
+static void linSolveRowsScalar(uint32_t N, uint32_t color, float *x, const float *x0, float a, float c,
+                               uint32_t j0, uint32_t j1) {
+  const size_t stride = N + 2;
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1 + ((j + 1 + color) & 1); i <= N; i += 2) {
+      const size_t index = IX(N, i, j);
+      x[index] = (x0[index] + a * (((x[index - 1] + x[index + 1]) + x[index - stride]) + x[index + stride])) / c;
+    }
+  }
+}
+
+static void advectRowsScalar(uint32_t N, float *d, const float *d0, const float *u, const float *v, float dt0,
+                             uint32_t j0, uint32_t j1) {
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const size_t index = IX(N, i, j);
+      float prevX = float(i) - dt0 * u[index];
+      float prevY = float(j) - dt0 * v[index];
+      prevX = std::min(std::max(prevX, 0.5f), float(N) + 0.5f);
+      prevY = std::min(std::max(prevY, 0.5f), float(N) + 0.5f);
+      const int32_t i0 = int32_t(prevX);
+      const int32_t k0 = int32_t(prevY);
+
+      const float s1 = prevX - float(i0);
+      const float s0 = 1.0f - s1;
+      const float t1 = prevY - float(k0);
+      const float t0 = 1.0f - t1;
+      const size_t index00 = IX(N, i0, k0);
+      const size_t index01 = index00 + N + 2;
+      d[index] = s0 * (t0 * d0[index00] + t1 * d0[index01]) + s1 * (t0 * d0[index00 + 1] + t1 * d0[index01 + 1]);
+    }
+  }
+}
+
+static void divergenceRowsScalar(uint32_t N, const float *u, const float *v, float *p, float *div, uint32_t j0,
+                                 uint32_t j1) {
+  const size_t stride = N + 2;
+  const float scale = -0.5f * (1.0f / N);
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const size_t index = IX(N, i, j);
+      div[index] = scale * (((u[index + 1] - u[index - 1]) + v[index + stride]) - v[index - stride]);
+      p[index] = 0.0f;
+    }
+  }
+}
+
+static void gradientRowsScalar(uint32_t N, float *u, float *v, const float *p, uint32_t j0, uint32_t j1) {
+  const size_t stride = N + 2;
+  const float h = 1.0f / N;
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1; i <= N; i++) {
+      const size_t index = IX(N, i, j);
+      u[index] = u[index] - (0.5f * (p[index + 1] - p[index - 1])) / h;
+      v[index] = v[index] - (0.5f * (p[index + stride] - p[index - stride])) / h;
+    }
+  }
+}
+
+#if defined(__AVX2__)
+
+// The rows are processed 8 cells at a time from i = 1, the cells left over at the end of a row use the scalar kernel
+
+static void linSolveRowsSimd(uint32_t N, uint32_t color, float *x, const float *x0, float a, float c, uint32_t j0,
+                             uint32_t j1) {
+  const size_t stride = N + 2;
+  const __m256 va = _mm256_set1_ps(a);
+  const __m256 vc = _mm256_set1_ps(c);
+  // lanes 0, 2, 4, 6 have the same parity as the first cell of the packet
+  const __m256i evenLanes = _mm256_setr_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+  const __m256i oddLanes = _mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+  const uint32_t simdEnd = 1 + (N / SIMD_NR_FLOATS) * SIMD_NR_FLOATS;
+
+  // A store followed by an overlapping load of the next packet stalls store forwarding, so a row is first computed
+  // into a scratch row and then written back.
+  thread_local std::vector<float> scratch;
+  scratch.resize(N);
+
+  for (uint32_t j = j0; j < j1; j++) {
+    const __m256i updateMask = ((1 + j) & 1) == color ? evenLanes : oddLanes;
+    for (uint32_t i = 1; i < simdEnd; i += SIMD_NR_FLOATS) {
+      const float *center = x + IX(N, i, j);
+      const __m256 sum = _mm256_add_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(center - 1), _mm256_loadu_ps(center + 1)),
+                        _mm256_loadu_ps(center - stride)),
+          _mm256_loadu_ps(center + stride));
+      const __m256 rhs = _mm256_loadu_ps(x0 + IX(N, i, j));
+      _mm256_storeu_ps(scratch.data() + i - 1, _mm256_div_ps(_mm256_add_ps(rhs, _mm256_mul_ps(va, sum)), vc));
+    }
+    // the cells of the other color are read by the neighbouring rows, so they are not written
+    for (uint32_t i = 1; i < simdEnd; i += SIMD_NR_FLOATS)
+      _mm256_maskstore_ps(x + IX(N, i, j), updateMask, _mm256_loadu_ps(scratch.data() + i - 1));
+    for (uint32_t i = simdEnd + ((j + simdEnd + color) & 1); i <= N; i += 2) {
+      const size_t index = IX(N, i, j);
+      x[index] = (x0[index] + a * (((x[index - 1] + x[index + 1]) + x[index - stride]) + x[index + stride])) / c;
+    }
+  }
+}
+
+static void advectRowsSimd(uint32_t N, float *d, const float *d0, const float *u, const float *v, float dt0,
+                           uint32_t j0, uint32_t j1) {
+  const __m256 vdt0 = _mm256_set1_ps(dt0);
+  const __m256 minCoordinate = _mm256_set1_ps(0.5f);
+  const __m256 maxCoordinate = _mm256_set1_ps(float(N) + 0.5f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256i stride = _mm256_set1_epi32(int32_t(N + 2));
+  const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const uint32_t simdEnd = 1 + (N / SIMD_NR_FLOATS) * SIMD_NR_FLOATS;
+
+  for (uint32_t j = j0; j < j1; j++) {
+    const __m256 y = _mm256_set1_ps(float(j));
+    for (uint32_t i = 1; i < simdEnd; i += SIMD_NR_FLOATS) {
+      const size_t index = IX(N, i, j);
+      const __m256 x = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(int32_t(i)), laneOffsets));
+      __m256 prevX = _mm256_sub_ps(x, _mm256_mul_ps(vdt0, _mm256_loadu_ps(u + index)));
+      __m256 prevY = _mm256_sub_ps(y, _mm256_mul_ps(vdt0, _mm256_loadu_ps(v + index)));
+      prevX = _mm256_min_ps(_mm256_max_ps(prevX, minCoordinate), maxCoordinate);
+      prevY = _mm256_min_ps(_mm256_max_ps(prevY, minCoordinate), maxCoordinate);
+      const __m256i i0 = _mm256_cvttps_epi32(prevX);
+      const __m256i k0 = _mm256_cvttps_epi32(prevY);
+
+      const __m256 s1 = _mm256_sub_ps(prevX, _mm256_cvtepi32_ps(i0));
+      const __m256 s0 = _mm256_sub_ps(one, s1);
+      const __m256 t1 = _mm256_sub_ps(prevY, _mm256_cvtepi32_ps(k0));
+      const __m256 t0 = _mm256_sub_ps(one, t1);
+
+      const __m256i index00 = _mm256_add_epi32(i0, _mm256_mullo_epi32(k0, stride));
+      const __m256i index01 = _mm256_add_epi32(index00, stride);
+      const __m256 d00 = _mm256_i32gather_ps(d0, index00, 4);
+      const __m256 d01 = _mm256_i32gather_ps(d0, index01, 4);
+      const __m256 d10 = _mm256_i32gather_ps(d0 + 1, index00, 4);
+      const __m256 d11 = _mm256_i32gather_ps(d0 + 1, index01, 4);
+
+      const __m256 left = _mm256_mul_ps(s0, _mm256_add_ps(_mm256_mul_ps(t0, d00), _mm256_mul_ps(t1, d01)));
+      const __m256 right = _mm256_mul_ps(s1, _mm256_add_ps(_mm256_mul_ps(t0, d10), _mm256_mul_ps(t1, d11)));
+      _mm256_storeu_ps(d + index, _mm256_add_ps(left, right));
+    }
+    if (simdEnd <= N)
+      advectRowsScalar(N, d, d0, u, v, dt0, j, j + 1);
+  }
+}
+
+static void divergenceRowsSimd(uint32_t N, const float *u, const float *v, float *p, float *div, uint32_t j0,
+                               uint32_t j1) {
+  const size_t stride = N + 2;
+  const __m256 scale = _mm256_set1_ps(-0.5f * (1.0f / N));
+  const uint32_t simdEnd = 1 + (N / SIMD_NR_FLOATS) * SIMD_NR_FLOATS;
+
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1; i < simdEnd; i += SIMD_NR_FLOATS) {
+      const size_t index = IX(N, i, j);
+      const __m256 du = _mm256_sub_ps(_mm256_loadu_ps(u + index + 1), _mm256_loadu_ps(u + index - 1));
+      const __m256 sum = _mm256_sub_ps(_mm256_add_ps(du, _mm256_loadu_ps(v + index + stride)),
+                                       _mm256_loadu_ps(v + index - stride));
+      _mm256_storeu_ps(div + index, _mm256_mul_ps(scale, sum));
+      _mm256_storeu_ps(p + index, _mm256_setzero_ps());
+    }
+    for (uint32_t i = simdEnd; i <= N; i++) {
+      const size_t index = IX(N, i, j);
+      div[index] = (-0.5f * (1.0f / N)) * (((u[index + 1] - u[index - 1]) + v[index + stride]) - v[index - stride]);
+      p[index] = 0.0f;
+    }
+  }
+}
+
+static void gradientRowsSimd(uint32_t N, float *u, float *v, const float *p, uint32_t j0, uint32_t j1) {
+  const size_t stride = N + 2;
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 h = _mm256_set1_ps(1.0f / N);
+  const uint32_t simdEnd = 1 + (N / SIMD_NR_FLOATS) * SIMD_NR_FLOATS;
+
+  for (uint32_t j = j0; j < j1; j++) {
+    for (uint32_t i = 1; i < simdEnd; i += SIMD_NR_FLOATS) {
+      const size_t index = IX(N, i, j);
+      const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(p + index + 1), _mm256_loadu_ps(p + index - 1));
+      const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(p + index + stride), _mm256_loadu_ps(p + index - stride));
+      _mm256_storeu_ps(u + index, _mm256_sub_ps(_mm256_loadu_ps(u + index), _mm256_div_ps(_mm256_mul_ps(half, dx), h)));
+      _mm256_storeu_ps(v + index, _mm256_sub_ps(_mm256_loadu_ps(v + index), _mm256_div_ps(_mm256_mul_ps(half, dy), h)));
+    }
+    if (simdEnd <= N) {
+      const float hs = 1.0f / N;
+      for (uint32_t i = simdEnd; i <= N; i++) {
+        const size_t index = IX(N, i, j);
+        u[index] = u[index] - (0.5f * (p[index + 1] - p[index - 1])) / hs;
+        v[index] = v[index] - (0.5f * (p[index + stride] - p[index - stride])) / hs;
+      }
+    }
+  }
+}
+
+#endif
+
+struct Kernels {
+  decltype(&linSolveRowsScalar) linSolveRows;
+  decltype(&advectRowsScalar) advectRows;
+  decltype(&divergenceRowsScalar) divergenceRows;
+  decltype(&gradientRowsScalar) gradientRows;
+};
+
+static Kernels selectKernels(bool useSimd) {
+#if defined(__AVX2__)
+  if (useSimd)
+    return {linSolveRowsSimd, advectRowsSimd, divergenceRowsSimd, gradientRowsSimd};
+#else
+  (void)useSimd;
+#endif
+  return {linSolveRowsScalar, advectRowsScalar, divergenceRowsScalar, gradientRowsScalar};
+}
+
+static void linSolve(CpuFluid *fluid, const Kernels &kernels, int32_t b, float *x, const float *x0, float a,
+                     float c, uint32_t iterations) {
+  const auto N = fluid->N;
+  // A color only reads the cells of the other color, but the simd kernel computes all lanes of a packet and so also
+  // loads the cells of the neighbouring rows that are being updated. Neighbouring bands are never in flight at the
+  // same time: the even bands of a color run first and the odd ones after the pool has joined.
+  for (uint32_t k = 0; k < iterations; k++) {
+    for (uint32_t color = 0; color < 2; color++) {
+      for (uint32_t firstBand = 0; firstBand < 2; firstBand++) {
+        parallelBands(fluid->workers, N, firstBand, 2,
+                      [&](uint32_t j0, uint32_t j1) { kernels.linSolveRows(N, color, x, x0, a, c, j0, j1); });
+      }
+    }
+    setBoundary(N, b, x);
+  }
+}
+
+static void diffuse(CpuFluid *fluid, const Kernels &kernels, int32_t b, std::vector<float> *x,
+                    const std::vector<float> &x0, float diff, float dt, uint32_t iterations) {
+  const auto N = fluid->N;
+  const float a = dt * diff * N * N;
+  // x0 is the initial guess, and the exact solution when there is no diffusion
+  *x = x0;
+  if (a == 0.0f) {
+    setBoundary(N, b, x->data());
+    return;
+  }
+  linSolve(fluid, kernels, b, x->data(), x0.data(), a, 1 + 4 * a, iterations);
+}
+
+static void advect(CpuFluid *fluid, const Kernels &kernels, int32_t b, std::vector<float> *d,
+                   const std::vector<float> &d0, const std::vector<float> &u, const std::vector<float> &v, float dt) {
+  const auto N = fluid->N;
+  const float dt0 = dt * N;
+  parallelRows(fluid->workers, N, [&](uint32_t j0, uint32_t j1) {
+    kernels.advectRows(N, d->data(), d0.data(), u.data(), v.data(), dt0, j0, j1);
+  });
+  setBoundary(N, b, d->data());
+}
+
+static void project(CpuFluid *fluid, const Kernels &kernels, std::vector<float> *u, std::vector<float> *v,
+                    std::vector<float> *p, std::vector<float> *div, uint32_t iterations) {
+  const auto N = fluid->N;
+  parallelRows(fluid->workers, N, [&](uint32_t j0, uint32_t j1) {
+    kernels.divergenceRows(N, u->data(), v->data(), p->data(), div->data(), j0, j1);
+  });
+  setBoundary(N, 0, div->data());
+  setBoundary(N, 0, p->data());
+
+  linSolve(fluid, kernels, 0, p->data(), div->data(), 1, 4, iterations);
+
+  parallelRows(fluid->workers, N, [&](uint32_t j0, uint32_t j1) {
+    kernels.gradientRows(N, u->data(), v->data(), p->data(), j0, j1);
+  });
+  setBoundary(N, 1, u->data());
+  setBoundary(N, 2, v->data());
+}
+
+CpuFluid createCpuFluid(uint32_t N, mg::WorkerPool *workers, bool useSimd) {
+  mgAssert(N > 0);
+  const size_t size = size_t(N + 2) * (N + 2);
+
+  CpuFluid fluid = {};
+  fluid.N = N;
+  for (auto *grid : {&fluid.u, &fluid.v, &fluid.u0, &fluid.v0, &fluid.d, &fluid.s})
+    grid->assign(size, 0.0f);
+  fluid.workers = workers;
+  fluid.useSimd = useSimd;
+  return fluid;
+}
+
+void destroyCpuFluid(CpuFluid *fluid) { *fluid = {}; }
+
+void addSourceCpu(CpuFluid *fluid, int32_t i, int32_t j, const glm::vec2 &delta) {
+  const int32_t N = int32_t(fluid->N);
+  for (int32_t y = std::max(j - 4, 1); y <= std::min(j + 4, N); y++) {
+    for (int32_t x = std::max(i - 4, 1); x <= std::min(i + 4, N); x++) {
+      const size_t index = IX(fluid->N, x, y);
+      fluid->u[index] += 50.0f * delta.x;
+      fluid->v[index] += 50.0f * (-1.0f * delta.y);
+      fluid->d[index] += 0.5f;
+    }
+  }
+}
+
+// same order of passes as step() in navier_stoke.cpp
+void stepCpu(CpuFluid *fluid, const CpuFluidSettings &settings) {
+  const auto kernels = selectKernels(fluid->useSimd);
+  const auto csr = _mm_getcsr();
+  _mm_setcsr(csr | FLUSH_DENORMALS);
+  const auto iterations = settings.iterations;
+  const auto dt = settings.dt;
+
+  diffuse(fluid, kernels, 1, &fluid->u0, fluid->u, settings.visc, dt, iterations);
+  diffuse(fluid, kernels, 2, &fluid->v0, fluid->v, settings.visc, dt, iterations);
+
+  project(fluid, kernels, &fluid->u0, &fluid->v0, &fluid->u, &fluid->v, iterations);
+
+  advect(fluid, kernels, 1, &fluid->u, fluid->u0, fluid->u0, fluid->v0, dt);
+  advect(fluid, kernels, 2, &fluid->v, fluid->v0, fluid->u0, fluid->v0, dt);
+
+  project(fluid, kernels, &fluid->u, &fluid->v, &fluid->u0, &fluid->v0, iterations);
+
+  diffuse(fluid, kernels, 0, &fluid->s, fluid->d, settings.diff, dt, iterations);
+  advect(fluid, kernels, 0, &fluid->d, fluid->s, fluid->u, fluid->v, dt);
+  _mm_setcsr(csr);
+}
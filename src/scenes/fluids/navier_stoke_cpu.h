@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Cpu version of the fluid solver over the same (N+2)^2 grid layout as the compute shaders, used as a gpu free
+// benchmark, as a correctness reference and for simulating on headless machines.
+// The simd and scalar paths give bit identical results for any number of threads.
+namespace mg {
+class WorkerPool;
+}
+
+struct CpuFluidSettings {
+  float visc = 0.0f;
+  float diff = 0.0f;
+  float dt = 0.1f;
+  uint32_t iterations = 20; // red-black Gauss-Seidel iterations per linear solve
+};
+
+struct CpuFluid {
+  uint32_t N;
+  std::vector<float> u, v, u0, v0, d, s;
+  mg::WorkerPool *workers;
+  bool useSimd;
+};
+
+CpuFluid createCpuFluid(uint32_t N, mg::WorkerPool *workers, bool useSimd);
+void destroyCpuFluid(CpuFluid *fluid);
+
+// same 9x9 brush as addSource.comp
+void addSourceCpu(CpuFluid *fluid, int32_t i, int32_t j, const glm::vec2 &delta);
+void stepCpu(CpuFluid *fluid, const CpuFluidSettings &settings);
@@ -3,6 +3,7 @@
 #include "mg/mgSystem.h"
 #include "mg/mgUtils.h"
 #include "rendering/rendering.h"
+#include "shaders/gltf.h"
 #include "vulkan/pipelineContainer.h"
 #include "vulkan/singleRenderpass.h"
 
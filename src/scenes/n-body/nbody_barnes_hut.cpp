@@ -0,0 +1,495 @@
+#include "nbody_barnes_hut.h"
+#include "mg/mgAssert.h"
+#include "mg/workerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static constexpr uint32_t SIMD_NR_FLOATS = 8;
+static constexpr uint32_t MORTON_BITS_PER_AXIS = 10;
+static constexpr uint32_t MAX_LEVEL = MORTON_BITS_PER_AXIS;
+static constexpr uint32_t RADIX_BITS = 10;
+static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+
+using Clock = std::chrono::high_resolution_clock;
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static uint32_t spreadBits(uint32_t v) {
+  v = (v | (v << 16)) & 0x030000FF;
+  v = (v | (v << 8)) & 0x0300F00F;
+  v = (v | (v << 4)) & 0x030C30C3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+static uint32_t mortonCode(const glm::vec3 &position, const glm::vec3 &rootMin, float scale) {
+  const auto cell = glm::clamp(glm::ivec3((position - rootMin) * scale), glm::ivec3(0),
+                               glm::ivec3((1 << MORTON_BITS_PER_AXIS) - 1));
+  return (spreadBits(uint32_t(cell.x)) << 2) | (spreadBits(uint32_t(cell.y)) << 1) | spreadBits(uint32_t(cell.z));
+}
+
+static uint32_t codeOf(uint64_t key) { return uint32_t(key >> 32); }
+static uint32_t octantOf(uint64_t key, uint32_t level) { return (codeOf(key) >> (3 * (MAX_LEVEL - 1 - level))) & 7; }
+
+// Stable LSD radix sort on the morton code, every thread histograms and scatters its own contiguous chunk
+static void radixSort(mg::WorkerPool *workers, std::vector<uint64_t> *keys, std::vector<uint64_t> *scratch) {
+  const uint32_t nrOfThreads = workers->nrOfThreads();
+  const uint32_t count = uint32_t(keys->size());
+  const uint32_t chunkSize = std::max(4096u, (count + nrOfThreads - 1) / nrOfThreads);
+  const uint32_t nrOfChunks = (count + chunkSize - 1) / chunkSize;
+  std::vector<uint32_t> offsets(size_t(nrOfChunks) * RADIX_SIZE);
+  scratch->resize(count);
+
+  for (uint32_t shift = 32; shift < 32 + 3 * MORTON_BITS_PER_AXIS; shift += RADIX_BITS) {
+    const uint64_t *src = keys->data();
+    uint64_t *dst = scratch->data();
+
+    workers->parallelFor(nrOfChunks, 1, [&](uint32_t chunk, uint32_t, uint32_t) {
+      uint32_t *histogram = &offsets[size_t(chunk) * RADIX_SIZE];
+      std::fill(histogram, histogram + RADIX_SIZE, 0);
+      for (uint32_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); i++)
+        histogram[(src[i] >> shift) & (RADIX_SIZE - 1)]++;
+    });
+    // exclusive prefix sum over digits first and chunks second keeps the sort stable
+    uint32_t sum = 0;
+    for (uint32_t digit = 0; digit < RADIX_SIZE; digit++) {
+      for (uint32_t chunk = 0; chunk < nrOfChunks; chunk++) {
+        const auto histogramCount = offsets[size_t(chunk) * RADIX_SIZE + digit];
+        offsets[size_t(chunk) * RADIX_SIZE + digit] = sum;
+        sum += histogramCount;
+      }
+    }
+    workers->parallelFor(nrOfChunks, 1, [&](uint32_t chunk, uint32_t, uint32_t) {
+      uint32_t *offset = &offsets[size_t(chunk) * RADIX_SIZE];
+      for (uint32_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); i++)
+        dst[offset[(src[i] >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+    });
+    keys->swap(*scratch);
+  }
+}
+
+// The center of a cell is weighted by the absolute mass since the particles from createParticles can have negative
+// mass, the monopole uses the signed total mass.
+struct MassMoment {
+  glm::vec3 weightedPosition = {};
+  float absoluteMass = 0.0f;
+  float mass = 0.0f;
+};
+
+static void addMoment(MassMoment *moment, const glm::vec3 &position, float mass) {
+  moment->weightedPosition += position * std::abs(mass);
+  moment->absoluteMass += std::abs(mass);
+  moment->mass += mass;
+}
+
+static glm::vec4 centerOfMass(const MassMoment &moment, const glm::vec3 &fallback) {
+  const auto center = moment.absoluteMass > 0.0f ? moment.weightedPosition / moment.absoluteMass : fallback;
+  return {center, moment.mass};
+}
+
+struct TreeBuilder {
+  const BarnesHut *barnesHut;
+  uint32_t maxParticlesPerLeaf;
+  float rootSize;
+
+  float sizeSquared(uint32_t level) const {
+    const float size = std::ldexp(rootSize, -int32_t(level));
+    return size * size;
+  }
+  bool isLeaf(uint32_t begin, uint32_t end, uint32_t level) const {
+    return end - begin <= maxParticlesPerLeaf || level == MAX_LEVEL;
+  }
+  // first index in [begin, end) that belongs to an octant after the given one
+  uint32_t octantEnd(uint32_t begin, uint32_t end, uint32_t level, uint32_t octant) const {
+    const auto &keys = barnesHut->keys;
+    return uint32_t(std::partition_point(keys.begin() + begin, keys.begin() + end,
+                                         [&](uint64_t key) { return octantOf(key, level) <= octant; }) -
+                    keys.begin());
+  }
+};
+
+// appends the subtree in depth first order, next is relative to the start of nodes
+static MassMoment buildSubtree(const TreeBuilder &builder, uint32_t begin, uint32_t end, uint32_t level,
+                               std::vector<BarnesHutNode> *nodes) {
+  const auto &barnesHut = *builder.barnesHut;
+  const uint32_t index = uint32_t(nodes->size());
+  nodes->push_back({});
+
+  MassMoment moment = {};
+  if (builder.isLeaf(begin, end, level)) {
+    for (uint32_t i = begin; i < end; i++)
+      addMoment(&moment, {barnesHut.x[i], barnesHut.y[i], barnesHut.z[i]}, barnesHut.mass[i]);
+  } else {
+    for (uint32_t octant = 0, childBegin = begin; octant < 8 && childBegin < end; octant++) {
+      const uint32_t childEnd = builder.octantEnd(childBegin, end, level, octant);
+      if (childEnd == childBegin)
+        continue;
+      const auto childMoment = buildSubtree(builder, childBegin, childEnd, level + 1, nodes);
+      moment.weightedPosition += childMoment.weightedPosition;
+      moment.absoluteMass += childMoment.absoluteMass;
+      moment.mass += childMoment.mass;
+      childBegin = childEnd;
+    }
+  }
+  auto &node = (*nodes)[index];
+  node.centerOfMass = centerOfMass(moment, {barnesHut.x[begin], barnesHut.y[begin], barnesHut.z[begin]});
+  node.sizeSquared = builder.sizeSquared(level);
+  node.next = uint32_t(nodes->size());
+  node.begin = begin;
+  node.end = end;
+  return moment;
+}
+
+// The top of the tree is split serially into chunks in depth first order, a chunk is either a single top node or a
+// subtree that is built by one thread. The chunks are then concatenated into the final tree.
+struct TreeChunk {
+  uint32_t begin, end, level;
+  bool isSubtree;
+  std::vector<BarnesHutNode> nodes;
+  MassMoment moment;
+};
+
+static void splitTop(const TreeBuilder &builder, uint32_t begin, uint32_t end, uint32_t level, uint32_t minTaskSize,
+                     std::vector<TreeChunk> *chunks) {
+  const bool isSubtree = end - begin <= minTaskSize || builder.isLeaf(begin, end, level);
+  chunks->push_back({begin, end, level, isSubtree, {}, {}});
+  if (isSubtree)
+    return;
+  for (uint32_t octant = 0, childBegin = begin; octant < 8 && childBegin < end; octant++) {
+    const uint32_t childEnd = builder.octantEnd(childBegin, end, level, octant);
+    if (childEnd != childBegin)
+      splitTop(builder, childBegin, childEnd, level + 1, minTaskSize, chunks);
+    childBegin = childEnd;
+  }
+}
+
+static MassMoment assembleTree(const TreeBuilder &builder, std::vector<TreeChunk> *chunks, uint32_t *chunkIndex,
+                               std::vector<BarnesHutNode> *nodes) {
+  auto &chunk = (*chunks)[(*chunkIndex)++];
+  const uint32_t base = uint32_t(nodes->size());
+  if (chunk.isSubtree) {
+    for (auto node : chunk.nodes) {
+      node.next += base;
+      nodes->push_back(node);
+    }
+    return chunk.moment;
+  }
+
+  nodes->push_back({});
+  MassMoment moment = {};
+  while (*chunkIndex < chunks->size() && (*chunks)[*chunkIndex].begin < chunk.end) {
+    const auto childMoment = assembleTree(builder, chunks, chunkIndex, nodes);
+    moment.weightedPosition += childMoment.weightedPosition;
+    moment.absoluteMass += childMoment.absoluteMass;
+    moment.mass += childMoment.mass;
+  }
+  const auto &barnesHut = *builder.barnesHut;
+  const glm::vec3 first = {barnesHut.x[chunk.begin], barnesHut.y[chunk.begin], barnesHut.z[chunk.begin]};
+  auto &node = (*nodes)[base];
+  node.centerOfMass = centerOfMass(moment, first);
+  node.sizeSquared = builder.sizeSquared(chunk.level);
+  node.next = uint32_t(nodes->size());
+  node.begin = chunk.begin;
+  node.end = chunk.end;
+  return moment;
+}
+
+BarnesHut createBarnesHut(const std::vector<Particle> &particles, mg::WorkerPool *workers, bool useSimd) {
+  mgAssert(particles.size() > 0);
+  BarnesHut barnesHut = {};
+  barnesHut.particles = particles;
+  barnesHut.workers = workers;
+  barnesHut.useSimd = useSimd;
+  return barnesHut;
+}
+
+void buildBarnesHutTree(BarnesHut *barnesHut, const BarnesHutSettings &settings, BarnesHutStats *stats) {
+  auto *workers = barnesHut->workers;
+  const auto nrOfThreads = workers->nrOfThreads();
+  const uint32_t count = uint32_t(barnesHut->particles.size());
+  const uint32_t grainSize = 16 * 1024;
+  auto start = Clock::now();
+
+  std::vector<glm::vec3> threadMin(nrOfThreads, glm::vec3(INFINITY)), threadMax(nrOfThreads, glm::vec3(-INFINITY));
+  workers->parallelFor(count, grainSize, [&](uint32_t begin, uint32_t end, uint32_t threadIndex) {
+    for (uint32_t i = begin; i < end; i++) {
+      threadMin[threadIndex] = glm::min(threadMin[threadIndex], glm::vec3(barnesHut->particles[i].position));
+      threadMax[threadIndex] = glm::max(threadMax[threadIndex], glm::vec3(barnesHut->particles[i].position));
+    }
+  });
+  glm::vec3 min = threadMin[0], max = threadMax[0];
+  for (uint32_t i = 1; i < nrOfThreads; i++) {
+    min = glm::min(min, threadMin[i]);
+    max = glm::max(max, threadMax[i]);
+  }
+  // cubic root cell slightly larger than the bounds so that the particles on the max side get the last cell
+  const float rootSize = std::max(glm::max(max.x - min.x, max.y - min.y), std::max(max.z - min.z, 1e-6f)) * 1.0001f;
+  const glm::vec3 rootMin = (min + max) * 0.5f - rootSize * 0.5f;
+  const float scale = float(1 << MORTON_BITS_PER_AXIS) / rootSize;
+
+  barnesHut->keys.resize(count);
+  workers->parallelFor(count, grainSize, [&](uint32_t begin, uint32_t end, uint32_t) {
+    for (uint32_t i = begin; i < end; i++)
+      barnesHut->keys[i] = uint64_t(mortonCode(barnesHut->particles[i].position, rootMin, scale)) << 32 | i;
+  });
+  radixSort(workers, &barnesHut->keys, &barnesHut->unsortedKeys);
+
+  // reorder the particles, the previous order is almost sorted so the gather is mostly sequential
+  const uint32_t paddedCount = (count + SIMD_NR_FLOATS - 1) / SIMD_NR_FLOATS * SIMD_NR_FLOATS;
+  barnesHut->particles.swap(barnesHut->unsortedParticles);
+  barnesHut->particles.resize(count);
+  for (auto *values : {&barnesHut->x, &barnesHut->y, &barnesHut->z, &barnesHut->mass})
+    values->assign(paddedCount, 0.0f);
+  workers->parallelFor(count, grainSize, [&](uint32_t begin, uint32_t end, uint32_t) {
+    for (uint32_t i = begin; i < end; i++) {
+      const auto &particle = barnesHut->unsortedParticles[uint32_t(barnesHut->keys[i])];
+      barnesHut->particles[i] = particle;
+      barnesHut->x[i] = particle.position.x;
+      barnesHut->y[i] = particle.position.y;
+      barnesHut->z[i] = particle.position.z;
+      barnesHut->mass[i] = particle.position.w;
+    }
+  });
+  stats->sortMs = msSince(start);
+  start = Clock::now();
+
+  TreeBuilder builder = {barnesHut, std::max(1u, settings.maxParticlesPerLeaf), rootSize};
+  std::vector<TreeChunk> chunks;
+  splitTop(builder, 0, count, 0, std::max(builder.maxParticlesPerLeaf, count / (nrOfThreads * 16)), &chunks);
+
+  std::vector<uint32_t> subtrees;
+  for (uint32_t i = 0; i < chunks.size(); i++) {
+    if (chunks[i].isSubtree)
+      subtrees.push_back(i);
+  }
+  workers->parallelFor(uint32_t(subtrees.size()), 1, [&](uint32_t begin, uint32_t, uint32_t) {
+    auto &chunk = chunks[subtrees[begin]];
+    chunk.moment = buildSubtree(builder, chunk.begin, chunk.end, chunk.level, &chunk.nodes);
+  });
+
+  barnesHut->nodes.clear();
+  uint32_t chunkIndex = 0;
+  assembleTree(builder, &chunks, &chunkIndex, &barnesHut->nodes);
+  mgAssert(chunkIndex == chunks.size());
+
+  stats->buildMs = msSince(start);
+  stats->nrOfNodes = uint32_t(barnesHut->nodes.size());
+}
+
+// sources in structure of arrays layout, the particles of an opened leaf are copied as one range
+struct InteractionList {
+  std::vector<float> x, y, z, mass;
+  uint32_t count;
+
+  void reserve(uint32_t capacity) {
+    if (capacity <= x.size())
+      return;
+    capacity = std::max(capacity, uint32_t(x.size()) * 2);
+    for (auto *values : {&x, &y, &z, &mass})
+      values->resize(capacity);
+  }
+  void push(float px, float py, float pz, float m) {
+    reserve(count + 1);
+    x[count] = px;
+    y[count] = py;
+    z[count] = pz;
+    mass[count] = m;
+    count++;
+  }
+  void pushRange(const BarnesHut &barnesHut, uint32_t begin, uint32_t end) {
+    reserve(count + end - begin);
+    const size_t sizeInBytes = (end - begin) * sizeof(float);
+    memcpy(&x[count], &barnesHut.x[begin], sizeInBytes);
+    memcpy(&y[count], &barnesHut.y[begin], sizeInBytes);
+    memcpy(&z[count], &barnesHut.z[begin], sizeInBytes);
+    memcpy(&mass[count], &barnesHut.mass[begin], sizeInBytes);
+    count += end - begin;
+  }
+};
+
+// sum of m * r / (|r|^2 + softening)^1.5 over the sources, count is a multiple of the simd width for the simd path
+static glm::vec3 sumAccelerationScalar(const glm::vec3 &position, const float *x, const float *y, const float *z,
+                                       const float *mass, uint32_t count, float softening) {
+  glm::vec3 acceleration = {};
+  for (uint32_t i = 0; i < count; i++) {
+    const glm::vec3 r = glm::vec3{x[i], y[i], z[i]} - position;
+    const float distanceSquared = glm::dot(r, r) + softening;
+    acceleration += r * (mass[i] / (distanceSquared * std::sqrt(distanceSquared)));
+  }
+  return acceleration;
+}
+
+#if defined(__AVX2__)
+static float horizontalSum(__m256 v) {
+  const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1)));
+}
+
+// Two targets share every load of the sources, which also gives six independent accumulator chains
+static void sumAccelerationsSimd(const glm::vec3 &position0, const glm::vec3 &position1, const float *x, const float *y,
+                                 const float *z, const float *mass, uint32_t count, float softening,
+                                 glm::vec3 *acceleration0, glm::vec3 *acceleration1) {
+  const __m256 eps = _mm256_set1_ps(softening);
+  const __m256 half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f);
+  const auto scale = [&](__m256 rx, __m256 ry, __m256 rz, __m256 m) {
+    const __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)),
+                                                 _mm256_add_ps(_mm256_mul_ps(rz, rz), eps));
+    // rsqrt with one Newton step is accurate to about 1e-7 and much cheaper than sqrt and div
+    __m256 inverse = _mm256_rsqrt_ps(distanceSquared);
+    inverse = _mm256_mul_ps(inverse, _mm256_sub_ps(threeHalves, _mm256_mul_ps(_mm256_mul_ps(half, distanceSquared),
+                                                                             _mm256_mul_ps(inverse, inverse))));
+    return _mm256_mul_ps(m, _mm256_mul_ps(inverse, _mm256_mul_ps(inverse, inverse)));
+  };
+
+  const __m256 px0 = _mm256_set1_ps(position0.x), py0 = _mm256_set1_ps(position0.y), pz0 = _mm256_set1_ps(position0.z);
+  const __m256 px1 = _mm256_set1_ps(position1.x), py1 = _mm256_set1_ps(position1.y), pz1 = _mm256_set1_ps(position1.z);
+  __m256 ax0 = _mm256_setzero_ps(), ay0 = _mm256_setzero_ps(), az0 = _mm256_setzero_ps();
+  __m256 ax1 = _mm256_setzero_ps(), ay1 = _mm256_setzero_ps(), az1 = _mm256_setzero_ps();
+  for (uint32_t i = 0; i < count; i += SIMD_NR_FLOATS) {
+    const __m256 sx = _mm256_loadu_ps(x + i), sy = _mm256_loadu_ps(y + i), sz = _mm256_loadu_ps(z + i);
+    const __m256 m = _mm256_loadu_ps(mass + i);
+
+    const __m256 rx0 = _mm256_sub_ps(sx, px0), ry0 = _mm256_sub_ps(sy, py0), rz0 = _mm256_sub_ps(sz, pz0);
+    const __m256 s0 = scale(rx0, ry0, rz0, m);
+    ax0 = _mm256_add_ps(ax0, _mm256_mul_ps(rx0, s0));
+    ay0 = _mm256_add_ps(ay0, _mm256_mul_ps(ry0, s0));
+    az0 = _mm256_add_ps(az0, _mm256_mul_ps(rz0, s0));
+
+    const __m256 rx1 = _mm256_sub_ps(sx, px1), ry1 = _mm256_sub_ps(sy, py1), rz1 = _mm256_sub_ps(sz, pz1);
+    const __m256 s1 = scale(rx1, ry1, rz1, m);
+    ax1 = _mm256_add_ps(ax1, _mm256_mul_ps(rx1, s1));
+    ay1 = _mm256_add_ps(ay1, _mm256_mul_ps(ry1, s1));
+    az1 = _mm256_add_ps(az1, _mm256_mul_ps(rz1, s1));
+  }
+  *acceleration0 = {horizontalSum(ax0), horizontalSum(ay0), horizontalSum(az0)};
+  *acceleration1 = {horizontalSum(ax1), horizontalSum(ay1), horizontalSum(az1)};
+}
+#endif
+
+static void sumAccelerations(bool useSimd, const glm::vec3 *targets, uint32_t nrOfTargets, const float *x,
+                             const float *y, const float *z, const float *mass, uint32_t count, float softening,
+                             glm::vec3 *accelerations) {
+  uint32_t i = 0;
+#if defined(__AVX2__)
+  if (useSimd) {
+    for (; i + 1 < nrOfTargets; i += 2) {
+      sumAccelerationsSimd(targets[i], targets[i + 1], x, y, z, mass, count, softening, &accelerations[i],
+                           &accelerations[i + 1]);
+    }
+    if (i < nrOfTargets) {
+      glm::vec3 unused;
+      sumAccelerationsSimd(targets[i], targets[i], x, y, z, mass, count, softening, &accelerations[i], &unused);
+    }
+    return;
+  }
+#endif
+  for (; i < nrOfTargets; i++)
+    accelerations[i] = sumAccelerationScalar(targets[i], x, y, z, mass, count, softening);
+}
+
+static float distanceSquaredToBox(const glm::vec3 &point, const glm::vec3 &min, const glm::vec3 &max) {
+  const auto d = point - glm::clamp(point, min, max);
+  return glm::dot(d, d);
+}
+
+void computeBarnesHutAccelerations(BarnesHut *barnesHut, const BarnesHutSettings &settings, BarnesHutStats *stats) {
+  const auto start = Clock::now();
+  const auto &nodes = barnesHut->nodes;
+  const uint32_t nrOfNodes = uint32_t(nodes.size());
+  const float thetaSquared = settings.theta * settings.theta;
+
+  // the highest cells with at most maxParticlesPerGroup particles share one walk
+  std::vector<uint32_t> groups;
+  for (uint32_t i = 0; i < nrOfNodes;) {
+    if (nodes[i].next == i + 1 || nodes[i].end - nodes[i].begin <= settings.maxParticlesPerGroup) {
+      groups.push_back(i);
+      i = nodes[i].next;
+    } else {
+      i++;
+    }
+  }
+  barnesHut->accelerations.resize(barnesHut->particles.size());
+
+  std::vector<uint64_t> threadInteractions(barnesHut->workers->nrOfThreads(), 0);
+  barnesHut->workers->parallelFor(uint32_t(groups.size()), 16, [&](uint32_t begin, uint32_t end, uint32_t threadIndex) {
+    thread_local InteractionList list = {};
+    thread_local std::vector<glm::vec3> targets;
+    for (uint32_t groupIndex = begin; groupIndex < end; groupIndex++) {
+      const auto &group = nodes[groups[groupIndex]];
+      glm::vec3 min = glm::vec3(INFINITY), max = glm::vec3(-INFINITY);
+      targets.clear();
+      for (uint32_t i = group.begin; i < group.end; i++) {
+        targets.push_back({barnesHut->x[i], barnesHut->y[i], barnesHut->z[i]});
+        min = glm::min(min, targets.back());
+        max = glm::max(max, targets.back());
+      }
+
+      // one walk for the whole group, a cell is accepted if it is far enough from every particle in the group
+      list.count = 0;
+      for (uint32_t i = 0; i < nrOfNodes;) {
+        const auto &node = nodes[i];
+        if (node.next == i + 1) {
+          list.pushRange(*barnesHut, node.begin, node.end);
+          i = node.next;
+        } else if (node.sizeSquared < thetaSquared * distanceSquaredToBox(node.centerOfMass, min, max)) {
+          list.push(node.centerOfMass.x, node.centerOfMass.y, node.centerOfMass.z, node.centerOfMass.w);
+          i = node.next;
+        } else {
+          i++;
+        }
+      }
+      threadInteractions[threadIndex] += uint64_t(list.count) * (group.end - group.begin);
+      while (list.count % SIMD_NR_FLOATS)
+        list.push(0.0f, 0.0f, 0.0f, 0.0f);
+
+      sumAccelerations(barnesHut->useSimd, targets.data(), uint32_t(targets.size()), list.x.data(), list.y.data(),
+                       list.z.data(), list.mass.data(), list.count, settings.softening,
+                       &barnesHut->accelerations[group.begin]);
+    }
+  });
+
+  stats->nrOfInteractions = 0;
+  for (const auto interactions : threadInteractions)
+    stats->nrOfInteractions += interactions;
+  stats->forceMs = msSince(start);
+}
+
+BarnesHutStats stepBarnesHut(BarnesHut *barnesHut, const BarnesHutSettings &settings, float dt) {
+  BarnesHutStats stats = {};
+  buildBarnesHutTree(barnesHut, settings, &stats);
+  computeBarnesHutAccelerations(barnesHut, settings, &stats);
+
+  const auto start = Clock::now();
+  const uint32_t count = uint32_t(barnesHut->particles.size());
+  barnesHut->workers->parallelFor(count, 16 * 1024, [&](uint32_t begin, uint32_t end, uint32_t) {
+    for (uint32_t i = begin; i < end; i++) {
+      auto &particle = barnesHut->particles[i];
+      particle.velocity += glm::vec4(settings.G * barnesHut->accelerations[i] * dt, 0.0f);
+      particle.position += dt * particle.velocity;
+    }
+  });
+  stats.integrateMs = msSince(start);
+  return stats;
+}
+
+void directSumAccelerations(const BarnesHut &barnesHut, const BarnesHutSettings &settings,
+                            const std::vector<uint32_t> &indices, glm::vec3 *accelerations) {
+  barnesHut.workers->parallelFor(uint32_t(indices.size()), 2, [&](uint32_t begin, uint32_t end, uint32_t) {
+    glm::vec3 targets[2];
+    for (uint32_t i = begin; i < end; i++) {
+      mgAssert(indices[i] < barnesHut.particles.size());
+      targets[i - begin] = {barnesHut.x[indices[i]], barnesHut.y[indices[i]], barnesHut.z[indices[i]]};
+    }
+    sumAccelerations(barnesHut.useSimd, targets, end - begin, barnesHut.x.data(), barnesHut.y.data(),
+                     barnesHut.z.data(), barnesHut.mass.data(), uint32_t(barnesHut.x.size()), settings.softening,
+                     &accelerations[begin]);
+  });
+}
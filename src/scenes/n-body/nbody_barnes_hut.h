@@ -0,0 +1,55 @@
+#pragma once
+#include "nbody_particles.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+class WorkerPool;
+}
+
+// Barnes-Hut gravity on the cpu. Every step the particles are radix sorted along a Morton curve, an octree is built
+// over the sorted order and the accelerations are summed by walking the tree once per group of nearby particles.
+// Uses the same softened force and constants as simulate_velocities.comp, with theta = 0 it is the direct sum.
+struct BarnesHutSettings {
+  float theta = 0.5f; // opening angle, a cell is approximated when its size / distance is below theta
+  float softening = 0.005f;
+  float G = 0.001f;
+  uint32_t maxParticlesPerLeaf = 16;
+  uint32_t maxParticlesPerGroup = 128; // particles that share one tree walk
+};
+
+struct BarnesHutNode {
+  glm::vec4 centerOfMass; // w is the total mass
+  float sizeSquared;      // squared side length of the cell
+  uint32_t next;          // the node after this subtree, nodes are stored depth first so next == index + 1 for leaves
+  uint32_t begin, end;    // the sorted particles in the cell
+};
+
+struct BarnesHutStats {
+  double sortMs, buildMs, forceMs, integrateMs;
+  uint64_t nrOfInteractions;
+  uint32_t nrOfNodes;
+};
+
+struct BarnesHut {
+  std::vector<Particle> particles; // in Morton order after each build
+  std::vector<Particle> unsortedParticles;
+  std::vector<uint64_t> keys, unsortedKeys; // morton code << 32 | particle index
+  std::vector<BarnesHutNode> nodes;
+  std::vector<float> x, y, z, mass; // sorted positions, padded with massless particles to the simd width
+  std::vector<glm::vec3> accelerations;
+  mg::WorkerPool *workers;
+  bool useSimd;
+};
+
+BarnesHut createBarnesHut(const std::vector<Particle> &particles, mg::WorkerPool *workers, bool useSimd);
+
+void buildBarnesHutTree(BarnesHut *barnesHut, const BarnesHutSettings &settings, BarnesHutStats *stats);
+void computeBarnesHutAccelerations(BarnesHut *barnesHut, const BarnesHutSettings &settings, BarnesHutStats *stats);
+// build, accelerations and the same integration as simulate_velocities.comp and simulate_positions.comp
+BarnesHutStats stepBarnesHut(BarnesHut *barnesHut, const BarnesHutSettings &settings, float dt);
+
+// O(n) per particle reference for the given sorted particles of the last built tree
+void directSumAccelerations(const BarnesHut &barnesHut, const BarnesHutSettings &settings,
+                            const std::vector<uint32_t> &indices, glm::vec3 *accelerations);
@@ -0,0 +1,96 @@
+#include "mg/logger.h"
+#include "mg/workerPool.h"
+#include "nbody_barnes_hut.h"
+#include "nbody_particles.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+// Headless Barnes-Hut benchmark, no window or gpu is needed.
+// nbody-cpu [--particles=N,N,...] [--steps=N] [--theta=F] [--leaf=N] [--group=N] [--samples=N] [--threads=N] [--scalar]
+// The direct sum is timed on --samples particles and scaled to all particles, the same samples give the force error.
+int main(int argc, char **argv) {
+  std::vector<uint32_t> particleCounts = {50'000, 500'000, 5'000'000};
+  uint32_t nrOfSteps = 3;
+  uint32_t nrOfSamples = 512;
+  uint32_t nrOfThreads = 0;
+  bool useSimd = true;
+  BarnesHutSettings settings = {};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--particles=", 0) == 0) {
+      particleCounts.clear();
+      std::stringstream counts(arg.substr(strlen("--particles=")));
+      for (std::string count; std::getline(counts, count, ',');)
+        particleCounts.push_back(uint32_t(std::stoul(count)));
+    } else if (arg.rfind("--steps=", 0) == 0)
+      nrOfSteps = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--steps=")))));
+    else if (arg.rfind("--theta=", 0) == 0)
+      settings.theta = std::stof(arg.substr(strlen("--theta=")));
+    else if (arg.rfind("--leaf=", 0) == 0)
+      settings.maxParticlesPerLeaf = uint32_t(std::stoul(arg.substr(strlen("--leaf="))));
+    else if (arg.rfind("--group=", 0) == 0)
+      settings.maxParticlesPerGroup = uint32_t(std::stoul(arg.substr(strlen("--group="))));
+    else if (arg.rfind("--samples=", 0) == 0)
+      nrOfSamples = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--samples=")))));
+    else if (arg.rfind("--threads=", 0) == 0)
+      nrOfThreads = uint32_t(std::stoul(arg.substr(strlen("--threads="))));
+    else if (arg == "--scalar")
+      useSimd = false;
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  // same time step as the interactive scene at 60 fps
+  constexpr float dt = 1.0f / 60.0f;
+  mg::WorkerPool workers;
+  workers.create(nrOfThreads);
+  for (const auto particleCount : particleCounts) {
+    auto barnesHut = createBarnesHut(createParticles(particleCount), &workers, useSimd);
+    const uint32_t count = uint32_t(barnesHut.particles.size());
+
+    BarnesHutStats best = {};
+    double bestMs = INFINITY;
+    for (uint32_t step = 0; step < nrOfSteps; step++) {
+      const auto stats = stepBarnesHut(&barnesHut, settings, dt);
+      const double ms = stats.sortMs + stats.buildMs + stats.forceMs + stats.integrateMs;
+      if (ms < bestMs) {
+        bestMs = ms;
+        best = stats;
+      }
+    }
+
+    // compare against the direct sum on evenly spaced sorted particles, so the samples cover the whole volume
+    BarnesHutStats stats = {};
+    buildBarnesHutTree(&barnesHut, settings, &stats);
+    computeBarnesHutAccelerations(&barnesHut, settings, &stats);
+    const uint32_t nrOfDirect = std::min(nrOfSamples, count);
+    std::vector<uint32_t> samples(nrOfDirect);
+    for (uint32_t i = 0; i < nrOfDirect; i++)
+      samples[i] = uint32_t(uint64_t(i) * count / nrOfDirect);
+    std::vector<glm::vec3> direct(nrOfDirect);
+    const auto start = std::chrono::high_resolution_clock::now();
+    directSumAccelerations(barnesHut, settings, samples, direct.data());
+    const double directMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                      start).count() * count / nrOfDirect;
+    double sumSquaredError = 0, maxError = 0;
+    for (uint32_t i = 0; i < nrOfDirect; i++) {
+      const auto error = glm::length(barnesHut.accelerations[samples[i]] - direct[i]) /
+                         std::max(glm::length(direct[i]), 1e-20f);
+      sumSquaredError += double(error) * error;
+      maxError = std::max(maxError, double(error));
+    }
+
+    LOG(count << " particles, theta " << settings.theta << ": barnes-hut " << bestMs << " ms (sort " << best.sortMs
+              << ", build " << best.buildMs << ", force " << best.forceMs << ", integrate " << best.integrateMs
+              << "), " << best.nrOfNodes << " nodes, " << double(best.nrOfInteractions) / count
+              << " interactions/particle");
+    LOG("  direct sum " << directMs << " ms (" << nrOfDirect << " samples), speedup " << directMs / bestMs
+                        << ", rms force error " << std::sqrt(sumSquaredError / nrOfDirect) << ", max " << maxError);
+  }
+  return 0;
+}
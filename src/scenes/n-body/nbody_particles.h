@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// same layout as the particles in simulate_velocities.comp, the mass is stored in position.w
+struct Particle {
+  glm::vec4 position;
+  glm::vec4 velocity;
+};
+
+// two rotating galaxies, nrOfParticles is rounded up to a multiple of 2 * 256 for the compute shaders
+std::vector<Particle> createParticles(uint32_t nrOfParticles);
@@ -1,10 +1,16 @@
 #include "nbody_rendering.h"
 #include "mg/camera.h"
+#include "mg/mgAssert.h"
 #include "mg/mgSystem.h"
 #include "mg/window.h"
 #include "nbody_renderpass.h"
 #include "nbody_utils.h"
 #include "rendering/rendering.h"
+#include "shaders/particle.h"
+#include "shaders/simulate_positions.h"
+#include "shaders/simulate_velocities.h"
+#include "shaders/toneMapping.h"
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 
 static void transformVelocities(const ComputeData &computeData, const mg::FrameData &frameData) {
@@ -95,6 +101,39 @@ void simulatePartices(const ComputeData &computeData, const mg::FrameData &frame
   transformPositions(computeData, frameData);
 }
 
+void uploadParticles(const ComputeData &computeData, const std::vector<Particle> &particles) {
+  const auto storage = mg::mgSystem.storageContainer.getStorage(computeData.storageId);
+  const auto sizeInBytes = mg::sizeofContainerInBytes(particles);
+  mgAssert(sizeInBytes == storage.size);
+
+  VkCommandBuffer copyCommandBuffer;
+  VkBuffer stagingBuffer;
+  VkDeviceSize stagingOffset;
+  void *stagingMemory = mg::mgSystem.linearHeapAllocator.allocateStaging(sizeInBytes, 1, &copyCommandBuffer,
+                                                                         &stagingBuffer, &stagingOffset);
+  memcpy(stagingMemory, particles.data(), sizeInBytes);
+
+  // the staging command buffer is submitted after the previous frame, which may still be drawing the particles
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(copyCommandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+  VkBufferCopy region = {};
+  region.srcOffset = stagingOffset;
+  region.dstOffset = 0;
+  region.size = sizeInBytes;
+  vkCmdCopyBuffer(copyCommandBuffer, stagingBuffer, storage.buffer, 1, &region);
+
+  memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(copyCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier,
+                       0, nullptr, 0, nullptr);
+}
+
 void renderParticels(mg::RenderContext &renderContext, const ComputeData &computeData, const mg::Camera &camera) {
   using namespace mg::shaders::particle;
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 
 namespace mg {
 struct RenderContext;
@@ -8,8 +9,11 @@ struct FrameData;
 
 struct ComputeData;
 struct NBodyRenderPass;
+struct Particle;
 
 void simulatePartices(const ComputeData &computeData, const mg::FrameData &frameData);
+// replaces the particle storage with particles simulated on the cpu
+void uploadParticles(const ComputeData &computeData, const std::vector<Particle> &particles);
 void renderParticels(mg::RenderContext &renderContext, const ComputeData &computeData, const mg::Camera &camera);
 void renderToneMapping(const mg::RenderContext &renderContext, const NBodyRenderPass &nBodyRenderPass);
 
@@ -5,6 +5,8 @@
 #include "mg/texts.h"
 #include "mg/tools.h"
 #include "mg/window.h"
+#include "mg/workerPool.h"
+#include "nbody_barnes_hut.h"
 #include "nbody_rendering.h"
 #include "nbody_renderpass.h"
 #include "nbody_utils.h"
@@ -18,6 +20,13 @@ static NBodyRenderPass nbodyRenderPass = {};
 
 static ComputeData computeData = {};
 
+// n simulates with Barnes-Hut on the cpu and m with the direct sum on the gpu. The cpu keeps its own copy of the
+// particles, so switching back to Barnes-Hut continues from where it last left off.
+static mg::WorkerPool workers;
+static BarnesHut barnesHut = {};
+static BarnesHutSettings barnesHutSettings = {};
+static bool useBarnesHut = false;
+
 static void resizeCallback() {
   resizeNBodyRenderPass(&nbodyRenderPass);
   mg::mgSystem.textureContainer.setupDescriptorSets();
@@ -29,7 +38,10 @@ void initScene() {
   computeData.particleId = mg::uploadPngImage("particle2.png");
   camera = mg::create3DCamera(glm::vec3{0.0f, 0.0f, -5.0f}, glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
 
-  initParticles(&computeData);
+  const auto particles = createParticles(256 * 100 * 2);
+  initParticles(&computeData, particles);
+  workers.create(0);
+  barnesHut = createBarnesHut(particles, &workers, true);
   mg::mgSystem.textureContainer.setupDescriptorSets();
   mg::vkContext.swapChain->resizeCallack = resizeCallback;
 }
@@ -38,12 +50,17 @@ void destroyScene() {
   mg::waitForDeviceIdle();
   mg::mgSystem.storageContainer.removeStorage(computeData.storageId);
   destroyNBodyRenderPass(&nbodyRenderPass);
+  workers.destroy();
 }
 
 void updateScene(const mg::FrameData &frameData) {
   if (frameData.keys.r) {
     mg::mgSystem.pipelineContainer.resetPipelineContainer();
   }
+  if (frameData.keys.n)
+    useBarnesHut = true;
+  if (frameData.keys.m)
+    useBarnesHut = false;
   if (frameData.mouse.left)
     mg::handleTools(frameData, &camera);
   mg::setCameraTransformation(&camera);
@@ -52,14 +69,19 @@ void updateScene(const mg::FrameData &frameData) {
 void renderScene(const mg::FrameData &frameData) {
   mg::Texts texts = {};
   char fps[50];
-  snprintf(fps, sizeof(fps), "Fps: %u", uint32_t(frameData.fps));
+  snprintf(fps, sizeof(fps), "Fps: %u, %s", uint32_t(frameData.fps), useBarnesHut ? "barnes-hut" : "direct");
   mg::Text text = {fps};
 
   mg::pushText(&texts, text);
   mg::beginRendering();
   mg::setFullscreenViewport();
 
-  simulatePartices(computeData, frameData);
+  if (useBarnesHut) {
+    stepBarnesHut(&barnesHut, barnesHutSettings, frameData.dt);
+    uploadParticles(computeData, barnesHut.particles);
+  } else {
+    simulatePartices(computeData, frameData);
+  }
 
   beginNBodyRenderPass(nbodyRenderPass);
   mg::RenderContext renderContext = {};
@@ -2,6 +2,7 @@
 #include <cinttypes>
 #include "mg/storageContainer.h"
 #include "mg/textureContainer.h"
+#include "nbody_particles.h"
 
 struct ComputeData {
   uint32_t nrOfParticles;
@@ -10,4 +11,4 @@ struct ComputeData {
   mg::TextureId particleId;
 };
 
-void initParticles(ComputeData *computeData);
+void initParticles(ComputeData *computeData, const std::vector<Particle> &particles);
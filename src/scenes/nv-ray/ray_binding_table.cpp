@@ -0,0 +1,79 @@
+#include "ray_binding_table.h"
+#include "mg/mgAssert.h"
+#include "mg/mgSystem.h"
+#include "mg/mgUtils.h"
+#include <algorithm>
+#include <cstring>
+
+ShaderBindingTable createShaderBindingTable(const mg::Pipeline &pipeline,
+                                            const VkPhysicalDeviceRayTracingPropertiesNV &rayTracingProperties,
+                                            const ShaderBindingTableInfo &info) {
+  mgAssert(!info.missGroups.empty());
+  mgAssert(!info.hitGroupRecords.empty());
+
+  const VkDeviceSize handleSize = rayTracingProperties.shaderGroupHandleSize;
+  const VkDeviceSize baseAlignment = rayTracingProperties.shaderGroupBaseAlignment;
+
+  uint32_t groupCount = info.rayGenGroup + 1;
+  size_t maxRecordDataSize = 0;
+  for (auto group : info.missGroups)
+    groupCount = std::max(groupCount, group + 1);
+  for (const auto &record : info.hitGroupRecords) {
+    groupCount = std::max(groupCount, record.group + 1);
+    maxRecordDataSize = std::max(maxRecordDataSize, record.data.size());
+  }
+
+  ShaderBindingTable shaderBindingTable = {};
+  shaderBindingTable.rayGenOffset = 0;
+  shaderBindingTable.missOffset = mg::alignUpPowerOfTwo(handleSize, baseAlignment);
+  shaderBindingTable.missStride = handleSize;
+  shaderBindingTable.hitGroupOffset = mg::alignUpPowerOfTwo(
+      shaderBindingTable.missOffset + shaderBindingTable.missStride * info.missGroups.size(), baseAlignment);
+  shaderBindingTable.hitGroupStride = mg::alignUpPowerOfTwo(handleSize + maxRecordDataSize, handleSize);
+  mgAssert(shaderBindingTable.hitGroupStride <= rayTracingProperties.maxShaderGroupStride);
+
+  const VkDeviceSize size =
+      shaderBindingTable.hitGroupOffset + shaderBindingTable.hitGroupStride * info.hitGroupRecords.size();
+
+  std::vector<uint8_t> handles(handleSize * groupCount);
+  mg::checkResult(mg::nv::vkGetRayTracingShaderGroupHandlesNV(mg::vkContext.device, pipeline.pipeline, 0, groupCount,
+                                                              handles.size(), handles.data()));
+
+  std::vector<uint8_t> data(size, 0);
+  memcpy(data.data() + shaderBindingTable.rayGenOffset, handles.data() + handleSize * info.rayGenGroup, handleSize);
+  for (size_t i = 0; i < info.missGroups.size(); i++) {
+    memcpy(data.data() + shaderBindingTable.missOffset + shaderBindingTable.missStride * i,
+           handles.data() + handleSize * info.missGroups[i], handleSize);
+  }
+  for (size_t i = 0; i < info.hitGroupRecords.size(); i++) {
+    const auto &record = info.hitGroupRecords[i];
+    uint8_t *dst = data.data() + shaderBindingTable.hitGroupOffset + shaderBindingTable.hitGroupStride * i;
+    memcpy(dst, handles.data() + handleSize * record.group, handleSize);
+    if (!record.data.empty())
+      memcpy(dst + handleSize, record.data.data(), record.data.size());
+  }
+
+  shaderBindingTable.storageId = mg::mgSystem.storageContainer.createStorage(
+      data.data(), mg::sizeofContainerInBytes(data), VK_BUFFER_USAGE_RAY_TRACING_BIT_NV);
+  shaderBindingTable.buffer = mg::mgSystem.storageContainer.getStorage(shaderBindingTable.storageId).buffer;
+  mg::waitForDeviceIdle();
+
+  return shaderBindingTable;
+}
+
+void destroyShaderBindingTable(ShaderBindingTable *shaderBindingTable) {
+  mg::mgSystem.storageContainer.removeStorage(shaderBindingTable->storageId);
+  *shaderBindingTable = {};
+}
+
+void traceRays(VkCommandBuffer commandBuffer, const ShaderBindingTable &shaderBindingTable, uint32_t width,
+               uint32_t height) {
+  const auto buffer = shaderBindingTable.buffer;
+  // clang-format off
+  mg::nv::vkCmdTraceRaysNV(commandBuffer,
+    buffer, shaderBindingTable.rayGenOffset, // raygenShader
+    buffer, shaderBindingTable.missOffset, shaderBindingTable.missStride, // missShader
+    buffer, shaderBindingTable.hitGroupOffset, shaderBindingTable.hitGroupStride, // hitShader
+    VK_NULL_HANDLE, 0, 0, width, height, 1);
+  // clang-format on
+}
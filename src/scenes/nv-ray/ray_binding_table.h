@@ -0,0 +1,33 @@
+#pragma once
+#include "mg/storageContainer.h"
+#include "vulkan/pipelineContainer.h"
+#include <vector>
+
+// A hit group record is the group handle followed by optional data, read in the hit shaders through shaderRecordNV.
+// Record i is selected by instances with instanceOffset i.
+struct HitGroupRecord {
+  uint32_t group;
+  std::vector<uint8_t> data;
+};
+
+struct ShaderBindingTableInfo {
+  uint32_t rayGenGroup;
+  std::vector<uint32_t> missGroups;
+  std::vector<HitGroupRecord> hitGroupRecords;
+};
+
+// Written once into device local memory, it only has to be rebuilt when the pipeline is recreated
+struct ShaderBindingTable {
+  mg::StorageId storageId;
+  VkBuffer buffer;
+  VkDeviceSize rayGenOffset;
+  VkDeviceSize missOffset, missStride;
+  VkDeviceSize hitGroupOffset, hitGroupStride;
+};
+
+ShaderBindingTable createShaderBindingTable(const mg::Pipeline &pipeline,
+                                            const VkPhysicalDeviceRayTracingPropertiesNV &rayTracingProperties,
+                                            const ShaderBindingTableInfo &info);
+void destroyShaderBindingTable(ShaderBindingTable *shaderBindingTable);
+void traceRays(VkCommandBuffer commandBuffer, const ShaderBindingTable &shaderBindingTable, uint32_t width,
+               uint32_t height);
@@ -0,0 +1,211 @@
+#include "ray_clusters.h"
+#include "mg/mgAssert.h"
+#include "ray_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+struct Bounds {
+  glm::vec3 min = glm::vec3(INFINITY);
+  glm::vec3 max = glm::vec3(-INFINITY);
+
+  void grow(const glm::vec3 &p) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+  void grow(const Bounds &b) {
+    min = glm::min(min, b.min);
+    max = glm::max(max, b.max);
+  }
+  float area() const {
+    if (min.x > max.x)
+      return 0;
+    const auto d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+};
+
+Bounds sphereBounds(const glm::vec4 &sphere) {
+  return {glm::vec3(sphere) - sphere.w, glm::vec3(sphere) + sphere.w};
+}
+
+constexpr uint32_t NR_OF_BINS = 16;
+
+// Top down binned SAH over the sphere centers, the split planes are chosen to minimize the summed surface area
+// times sphere count of the two sides until a range fits in one cluster.
+void splitClusters(const World &world, uint32_t maxSpheresPerCluster, uint32_t *begin, uint32_t *end,
+                   std::vector<std::vector<uint32_t>> *clusters) {
+  const uint32_t count = uint32_t(end - begin);
+  if (count <= maxSpheresPerCluster) {
+    clusters->emplace_back(begin, end);
+    return;
+  }
+  Bounds centers;
+  for (auto it = begin; it != end; it++)
+    centers.grow(glm::vec3(world.positions[*it]));
+
+  float bestCost = INFINITY;
+  uint32_t bestAxis = 0, bestBin = 0;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    const float extent = centers.max[axis] - centers.min[axis];
+    if (extent <= 0)
+      continue;
+    Bounds binBounds[NR_OF_BINS];
+    uint32_t binCounts[NR_OF_BINS] = {};
+    for (auto it = begin; it != end; it++) {
+      const auto &sphere = world.positions[*it];
+      const uint32_t bin =
+          std::min(NR_OF_BINS - 1, uint32_t(NR_OF_BINS * (sphere[axis] - centers.min[axis]) / extent));
+      binBounds[bin].grow(sphereBounds(sphere));
+      binCounts[bin]++;
+    }
+    // sweep from the right to get the area and count of every right side, then from the left
+    float rightAreas[NR_OF_BINS];
+    uint32_t rightCounts[NR_OF_BINS];
+    Bounds right;
+    uint32_t rightCount = 0;
+    for (uint32_t i = NR_OF_BINS - 1; i > 0; i--) {
+      right.grow(binBounds[i]);
+      rightCount += binCounts[i];
+      rightAreas[i] = right.area();
+      rightCounts[i] = rightCount;
+    }
+    Bounds left;
+    uint32_t leftCount = 0;
+    for (uint32_t i = 0; i < NR_OF_BINS - 1; i++) {
+      left.grow(binBounds[i]);
+      leftCount += binCounts[i];
+      if (leftCount == 0 || rightCounts[i + 1] == 0)
+        continue;
+      const float cost = left.area() * leftCount + rightAreas[i + 1] * rightCounts[i + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestBin = i;
+      }
+    }
+  }
+
+  // all centers fall in one bin, split at the median instead
+  if (bestCost == INFINITY) {
+    const auto middle = begin + count / 2;
+    std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) {
+      const auto &pa = world.positions[a], &pb = world.positions[b];
+      return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+    });
+    splitClusters(world, maxSpheresPerCluster, begin, middle, clusters);
+    splitClusters(world, maxSpheresPerCluster, middle, end, clusters);
+    return;
+  }
+
+  const float extent = centers.max[bestAxis] - centers.min[bestAxis];
+  const auto middle = std::partition(begin, end, [&](uint32_t i) {
+    const auto &sphere = world.positions[i];
+    const uint32_t bin =
+        std::min(NR_OF_BINS - 1, uint32_t(NR_OF_BINS * (sphere[bestAxis] - centers.min[bestAxis]) / extent));
+    return bin <= bestBin;
+  });
+  mgAssert(middle != begin && middle != end);
+  splitClusters(world, maxSpheresPerCluster, begin, middle, clusters);
+  splitClusters(world, maxSpheresPerCluster, middle, end, clusters);
+}
+
+HitGroupRecord sphereRecord(World::MATERIAL material, uint32_t firstSphere) {
+  HitGroupRecord record = {};
+  record.group = 2 + uint32_t(material);
+  record.data.resize(sizeof(firstSphere));
+  memcpy(record.data.data(), &firstSphere, sizeof(firstSphere));
+  return record;
+}
+
+glm::mat3x4 unitSphereTransform(const glm::vec4 &sphere) {
+  // rows of the 3x4 instance matrix
+  return {sphere.w, 0.0f, 0.0f, sphere.x, 0.0f, sphere.w, 0.0f, sphere.y, 0.0f, 0.0f, sphere.w, sphere.z};
+}
+
+} // namespace
+
+SphereLayout createSphereLayout(const World &world, const SphereClusterSettings &settings) {
+  mgAssert(settings.maxSpheresPerCluster > 0);
+  mgAssert(world.positions.size() == world.albedos.size() && world.positions.size() == world.materials.size());
+  mgAssert(world.positions.size() == world.animated.size());
+
+  SphereLayout layout = {};
+  std::vector<uint32_t> clustered, instanced;
+  for (uint32_t i = 0; i < world.positions.size(); i++) {
+    if (world.animated[i] || world.positions[i].w >= settings.instanceRadius)
+      instanced.push_back(i);
+    else
+      clustered.push_back(i);
+  }
+
+  std::vector<std::vector<uint32_t>> clusters;
+  if (!clustered.empty())
+    splitClusters(world, settings.maxSpheresPerCluster, clustered.data(), clustered.data() + clustered.size(),
+                  &clusters);
+
+  // cluster spheres are stored in world space, sorted by material so every material is one aabb geometry
+  for (auto &cluster : clusters) {
+    std::stable_sort(cluster.begin(), cluster.end(),
+                     [&](uint32_t a, uint32_t b) { return world.materials[a] < world.materials[b]; });
+    SphereInstance instance = {};
+    instance.transform = unitSphereTransform({0, 0, 0, 1});
+    instance.blas = uint32_t(layout.blases.size());
+    instance.firstRecord = uint32_t(layout.hitGroupRecords.size());
+    instance.sphere = ~0u;
+
+    SphereBlas blas = {};
+    for (uint32_t i = 0; i < cluster.size(); i++) {
+      const auto sphereIndex = cluster[i];
+      const auto firstSphere = uint32_t(layout.positions.size());
+      if (i == 0 || world.materials[cluster[i - 1]] != world.materials[sphereIndex]) {
+        blas.geometries.push_back({uint32_t(layout.aabbs.size() / 2), 0});
+        layout.hitGroupRecords.push_back(sphereRecord(world.materials[sphereIndex], firstSphere));
+      }
+      const auto bounds = sphereBounds(world.positions[sphereIndex]);
+      layout.aabbs.push_back(bounds.min);
+      layout.aabbs.push_back(bounds.max);
+      layout.positions.push_back(world.positions[sphereIndex]);
+      layout.albedos.push_back(world.albedos[sphereIndex]);
+      blas.geometries.back().count++;
+    }
+    layout.blases.push_back(std::move(blas));
+    layout.instances.push_back(instance);
+  }
+
+  // one unit sphere blas shared by the rest, each instance has its own record and storage slot for the albedo
+  if (!instanced.empty()) {
+    const auto unitBlas = uint32_t(layout.blases.size());
+    layout.blases.push_back({{{uint32_t(layout.aabbs.size() / 2), 1}}});
+    layout.aabbs.push_back(glm::vec3(-1));
+    layout.aabbs.push_back(glm::vec3(1));
+
+    for (auto sphereIndex : instanced) {
+      if (world.animated[sphereIndex])
+        layout.animatedInstances.push_back(uint32_t(layout.instances.size()));
+      SphereInstance instance = {};
+      instance.transform = unitSphereTransform(world.positions[sphereIndex]);
+      instance.blas = unitBlas;
+      instance.firstRecord = uint32_t(layout.hitGroupRecords.size());
+      instance.sphere = sphereIndex;
+      layout.hitGroupRecords.push_back(
+          sphereRecord(world.materials[sphereIndex], uint32_t(layout.positions.size())));
+      layout.positions.push_back({0, 0, 0, 1});
+      layout.albedos.push_back(world.albedos[sphereIndex]);
+      layout.instances.push_back(instance);
+    }
+  }
+  return layout;
+}
+
+void animateSphereLayout(const World &world, float time, SphereLayout *layout) {
+  for (uint32_t i = 0; i < layout->animatedInstances.size(); i++) {
+    auto &instance = layout->instances[layout->animatedInstances[i]];
+    auto sphere = world.positions[instance.sphere];
+    sphere.y += 0.5f * std::abs(std::sin(2.0f * time + float(i)));
+    instance.transform = unitSphereTransform(sphere);
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ray_binding_table.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct World;
+
+// Groups the procedural spheres into a few bottom level acceleration structures instead of one per sphere.
+// Small spheres are clustered with a binned SAH split over their centers, every cluster is one blas with one aabb
+// geometry per material. Large and animated spheres are instances of a shared unit sphere blas, placed with the
+// instance transform so they can move by refitting the top level only.
+struct SphereClusterSettings {
+  uint32_t maxSpheresPerCluster = 64; // 1 gives the old layout with one blas per sphere
+  float instanceRadius = 0.5f;        // spheres at least this large are unit sphere instances
+};
+
+struct SphereGeometry {
+  uint32_t firstAabb, count;
+};
+
+struct SphereBlas {
+  std::vector<SphereGeometry> geometries;
+};
+
+struct SphereInstance {
+  glm::mat3x4 transform;
+  uint32_t blas;
+  uint32_t firstRecord; // hit group record of the first geometry, the instanceOffset
+  uint32_t sphere;      // index into World for unit sphere instances
+};
+
+// The storage buffer and the aabbs are in blas space, positions[i] and albedos[i] are read by the hit shaders at
+// shader record firstSphere + gl_PrimitiveID.
+struct SphereLayout {
+  std::vector<glm::vec4> positions, albedos;
+  std::vector<glm::vec3> aabbs; // min and max
+  std::vector<SphereBlas> blases;
+  std::vector<SphereInstance> instances;
+  std::vector<HitGroupRecord> hitGroupRecords;
+  std::vector<uint32_t> animatedInstances;
+};
+
+SphereLayout createSphereLayout(const World &world, const SphereClusterSettings &settings);
+// moves the animated unit sphere instances, time in seconds
+void animateSphereLayout(const World &world, float time, SphereLayout *layout);
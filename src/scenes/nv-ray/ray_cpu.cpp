@@ -0,0 +1,608 @@
+#include "ray_cpu.h"
+#include "mg/mgAssert.h"
+#include "mg/workerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t PACKET_SIZE = 8;
+constexpr uint32_t TILE_WIDTH = 32;
+constexpr uint32_t TILE_HEIGHT = 8;
+constexpr uint32_t NR_OF_BINS = 16;
+constexpr uint32_t MAX_STACK_SIZE = 64;
+constexpr int32_t NO_HIT = -1;
+constexpr float T_MIN = 0.001f;
+constexpr float T_MAX = 1000.0f;
+constexpr float PI = 3.14159265358979323846f;
+
+static_assert(TILE_WIDTH % PACKET_SIZE == 0, "a tile row is a whole number of packets");
+
+struct Bounds {
+  glm::vec3 min = glm::vec3(INFINITY);
+  glm::vec3 max = glm::vec3(-INFINITY);
+
+  void grow(const glm::vec3 &p) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+  void grow(const Bounds &b) {
+    min = glm::min(min, b.min);
+    max = glm::max(max, b.max);
+  }
+  float area() const {
+    if (min.x > max.x)
+      return 0;
+    const auto d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+};
+
+Bounds sphereBounds(const glm::vec4 &sphere) {
+  return {glm::vec3(sphere) - sphere.w, glm::vec3(sphere) + sphere.w};
+}
+
+uint32_t binOf(const glm::vec4 &sphere, uint32_t axis, const Bounds &centers) {
+  const float extent = centers.max[axis] - centers.min[axis];
+  return std::min(NR_OF_BINS - 1, uint32_t(NR_OF_BINS * (sphere[axis] - centers.min[axis]) / extent));
+}
+
+// Binned SAH over the sphere centers, the children of a node are allocated together so right == left + 1
+void buildBvhNode(const World &world, uint32_t maxSpheresPerLeaf, uint32_t nodeIndex, uint32_t *spheres,
+                  uint32_t begin, uint32_t end, std::vector<CpuBvhNode> *nodes) {
+  Bounds bounds, centers;
+  for (uint32_t i = begin; i < end; i++) {
+    bounds.grow(sphereBounds(world.positions[spheres[i]]));
+    centers.grow(glm::vec3(world.positions[spheres[i]]));
+  }
+  (*nodes)[nodeIndex].min = bounds.min;
+  (*nodes)[nodeIndex].max = bounds.max;
+
+  const uint32_t count = end - begin;
+  float bestCost = INFINITY;
+  uint32_t bestAxis = 0, bestBin = 0;
+  if (count > maxSpheresPerLeaf) {
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      if (centers.max[axis] <= centers.min[axis])
+        continue;
+      Bounds binBounds[NR_OF_BINS];
+      uint32_t binCounts[NR_OF_BINS] = {};
+      for (uint32_t i = begin; i < end; i++) {
+        const auto &sphere = world.positions[spheres[i]];
+        const uint32_t bin = binOf(sphere, axis, centers);
+        binBounds[bin].grow(sphereBounds(sphere));
+        binCounts[bin]++;
+      }
+      float rightAreas[NR_OF_BINS];
+      uint32_t rightCounts[NR_OF_BINS];
+      Bounds right;
+      uint32_t rightCount = 0;
+      for (uint32_t i = NR_OF_BINS - 1; i > 0; i--) {
+        right.grow(binBounds[i]);
+        rightCount += binCounts[i];
+        rightAreas[i] = right.area();
+        rightCounts[i] = rightCount;
+      }
+      Bounds left;
+      uint32_t leftCount = 0;
+      for (uint32_t i = 0; i < NR_OF_BINS - 1; i++) {
+        left.grow(binBounds[i]);
+        leftCount += binCounts[i];
+        if (leftCount == 0 || rightCounts[i + 1] == 0)
+          continue;
+        const float cost = left.area() * leftCount + rightAreas[i + 1] * rightCounts[i + 1];
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = i;
+        }
+      }
+    }
+  }
+
+  // a leaf when it is small or when all centers are in one bin
+  if (bestCost == INFINITY) {
+    (*nodes)[nodeIndex].leftOrFirst = begin;
+    (*nodes)[nodeIndex].count = count;
+    return;
+  }
+
+  const auto middle = uint32_t(std::partition(spheres + begin, spheres + end, [&](uint32_t sphere) {
+                                 return binOf(world.positions[sphere], bestAxis, centers) <= bestBin;
+                               }) -
+                               spheres);
+  mgAssert(middle != begin && middle != end);
+
+  const auto leftIndex = uint32_t(nodes->size());
+  nodes->resize(nodes->size() + 2);
+  (*nodes)[nodeIndex].leftOrFirst = leftIndex;
+  (*nodes)[nodeIndex].count = 0;
+  (*nodes)[nodeIndex].axis = bestAxis;
+  buildBvhNode(world, maxSpheresPerLeaf, leftIndex, spheres, begin, middle, nodes);
+  buildBvhNode(world, maxSpheresPerLeaf, leftIndex + 1, spheres, middle, end, nodes);
+}
+
+// rayUtils.hglsl
+uint32_t seedRnd(uint32_t k1, uint32_t k2) {
+  uint32_t v = (k1 + k2) * (k1 + k2 + 1) + (k1 * k2);
+  return v >> 1;
+}
+
+float rndFloat(uint32_t *rng) {
+  *rng = 1103515245u * *rng + 12345u;
+  return float(*rng) / float(0xFFFFFFFFu);
+}
+
+glm::vec4 fract(const glm::vec4 &v) { return v - glm::floor(v); }
+
+struct Sobol {
+  uint32_t index;
+  uint32_t table;
+  glm::vec4 offset;
+};
+
+glm::vec4 nextSobol(const CpuRayTracer &rayTracer, Sobol *state) {
+  const auto &sequence = rayTracer.sobol[state->table * rayTracer.sobolCount + state->index % rayTracer.sobolCount];
+  state->index++;
+  return fract(state->offset + sequence);
+}
+
+glm::vec3 randomInUnitSphereSalton(const CpuRayTracer &rayTracer, Sobol *state) {
+  while (true) {
+    const glm::vec3 p = 2.0f * glm::vec3(nextSobol(rayTracer, state)) - 1.0f;
+    if (glm::dot(p, p) < 1)
+      return p;
+  }
+}
+
+glm::vec2 concentricMapping(float radius, float u, float v) {
+  float a = 2 * u - 1;
+  float b = 2 * v - 1;
+  if (b == 0)
+    b = 1;
+  float r, phi;
+  if (a * a > b * b) {
+    r = radius * a;
+    phi = (PI / 4) * (b / a);
+  } else {
+    r = radius * b;
+    phi = (PI / 2.0f) - (PI / 4.0f) * (a / b);
+  }
+  return {r * std::cos(phi), r * std::sin(phi)};
+}
+
+bool refract(const glm::vec3 &v, const glm::vec3 &n, float niOverNt, glm::vec3 *refracted) {
+  const glm::vec3 uv = glm::normalize(v);
+  const float dt = glm::dot(uv, n);
+  const float discriminant = 1.0f - niOverNt * niOverNt * (1 - dt * dt);
+  if (discriminant > 0) {
+    *refracted = niOverNt * (uv - n * dt) - n * std::sqrt(discriminant);
+    return true;
+  }
+  return false;
+}
+
+float schlick(float cosine, float refIdx) {
+  float r0 = (1 - refIdx) / (1 + refIdx);
+  r0 = r0 * r0;
+  return r0 + (1 - r0) * std::pow((1 - cosine), 5.0f);
+}
+
+// The rays of a packet are traced together, a lane that is done has t = 0 so every node and sphere test fails
+struct RayPacket {
+  alignas(32) float ox[PACKET_SIZE], oy[PACKET_SIZE], oz[PACKET_SIZE];
+  alignas(32) float dx[PACKET_SIZE], dy[PACKET_SIZE], dz[PACKET_SIZE];
+  alignas(32) float t[PACKET_SIZE];
+  alignas(32) int32_t sphere[PACKET_SIZE];
+};
+
+void intersectRay(const CpuRayTracer &rayTracer, RayPacket *packet, uint32_t lane) {
+  const glm::vec3 origin = {packet->ox[lane], packet->oy[lane], packet->oz[lane]};
+  const glm::vec3 direction = {packet->dx[lane], packet->dy[lane], packet->dz[lane]};
+  const glm::vec3 inverseDirection = 1.0f / direction;
+  const float a = direction.x * direction.x + direction.y * direction.y + direction.z * direction.z;
+  float t = packet->t[lane];
+  int32_t hitSphere = packet->sphere[lane];
+
+  uint32_t stack[MAX_STACK_SIZE];
+  uint32_t stackSize = 0;
+  uint32_t nodeIndex = 0;
+  while (true) {
+    const auto &node = rayTracer.nodes[nodeIndex];
+    const glm::vec3 t0 = (node.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (node.max - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, T_MIN));
+    const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, t));
+    if (tEnter <= tExit) {
+      if (node.count) {
+        for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+          const glm::vec3 oc = origin - glm::vec3{rayTracer.x[i], rayTracer.y[i], rayTracer.z[i]};
+          const float b = oc.x * direction.x + oc.y * direction.y + oc.z * direction.z;
+          const float c = (oc.x * oc.x + oc.y * oc.y + oc.z * oc.z) - rayTracer.radius[i] * rayTracer.radius[i];
+          const float discriminant = b * b - a * c;
+          if (discriminant >= 0) {
+            const float s = std::sqrt(discriminant);
+            const float t1 = (-b - s) / a;
+            const float t2 = (-b + s) / a;
+            if (T_MIN <= t1 && t1 < t) {
+              t = t1;
+              hitSphere = int32_t(i);
+            } else if (T_MIN <= t2 && t2 < t) {
+              t = t2;
+              hitSphere = int32_t(i);
+            }
+          }
+        }
+      } else {
+        const bool negative = direction[node.axis] < 0;
+        mgAssert(stackSize < MAX_STACK_SIZE);
+        stack[stackSize++] = node.leftOrFirst + (negative ? 0 : 1);
+        nodeIndex = node.leftOrFirst + (negative ? 1 : 0);
+        continue;
+      }
+    }
+    if (stackSize == 0)
+      break;
+    nodeIndex = stack[--stackSize];
+  }
+  packet->t[lane] = t;
+  packet->sphere[lane] = hitSphere;
+}
+
+#if defined(__AVX2__)
+// The same arithmetic as intersectRay in eight lanes, the near child is picked from the first active ray
+void intersectPacket(const CpuRayTracer &rayTracer, RayPacket *packet) {
+  const __m256 ox = _mm256_load_ps(packet->ox), oy = _mm256_load_ps(packet->oy), oz = _mm256_load_ps(packet->oz);
+  const __m256 dx = _mm256_load_ps(packet->dx), dy = _mm256_load_ps(packet->dy), dz = _mm256_load_ps(packet->dz);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 idx = _mm256_div_ps(one, dx), idy = _mm256_div_ps(one, dy), idz = _mm256_div_ps(one, dz);
+  const __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+  const __m256 tMin = _mm256_set1_ps(T_MIN);
+  const __m256 signBit = _mm256_set1_ps(-0.0f);
+  __m256 t = _mm256_load_ps(packet->t);
+  __m256i hitSphere = _mm256_load_si256((const __m256i *)packet->sphere);
+
+  uint32_t stack[MAX_STACK_SIZE];
+  uint32_t stackSize = 0;
+  uint32_t nodeIndex = 0;
+  while (true) {
+    const auto &node = rayTracer.nodes[nodeIndex];
+    const __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.x), ox), idx);
+    const __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.x), ox), idx);
+    const __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.y), oy), idy);
+    const __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.y), oy), idy);
+    const __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.z), oz), idz);
+    const __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.z), oz), idz);
+    const __m256 tEnter = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y)),
+                                        _mm256_max_ps(_mm256_min_ps(t0z, t1z), tMin));
+    const __m256 tExit = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y)),
+                                       _mm256_min_ps(_mm256_max_ps(t0z, t1z), t));
+    const int hitMask = _mm256_movemask_ps(_mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ));
+    if (hitMask) {
+      if (node.count) {
+        for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+          const __m256 ocx = _mm256_sub_ps(ox, _mm256_set1_ps(rayTracer.x[i]));
+          const __m256 ocy = _mm256_sub_ps(oy, _mm256_set1_ps(rayTracer.y[i]));
+          const __m256 ocz = _mm256_sub_ps(oz, _mm256_set1_ps(rayTracer.z[i]));
+          const __m256 b =
+              _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+          const __m256 c = _mm256_sub_ps(
+              _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)),
+              _mm256_set1_ps(rayTracer.radius[i] * rayTracer.radius[i]));
+          const __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+          const __m256 valid = _mm256_cmp_ps(discriminant, _mm256_setzero_ps(), _CMP_GE_OQ);
+          if (!_mm256_movemask_ps(valid))
+            continue;
+          const __m256 s = _mm256_sqrt_ps(_mm256_max_ps(discriminant, _mm256_setzero_ps()));
+          const __m256 minusB = _mm256_xor_ps(b, signBit);
+          const __m256 t1 = _mm256_div_ps(_mm256_sub_ps(minusB, s), a);
+          const __m256 t2 = _mm256_div_ps(_mm256_add_ps(minusB, s), a);
+          const __m256 in1 = _mm256_and_ps(_mm256_cmp_ps(tMin, t1, _CMP_LE_OQ), _mm256_cmp_ps(t1, t, _CMP_LT_OQ));
+          const __m256 in2 = _mm256_and_ps(_mm256_cmp_ps(tMin, t2, _CMP_LE_OQ), _mm256_cmp_ps(t2, t, _CMP_LT_OQ));
+          const __m256 hit = _mm256_and_ps(valid, _mm256_or_ps(in1, in2));
+          t = _mm256_blendv_ps(t, _mm256_blendv_ps(t2, t1, in1), hit);
+          const __m256 sphere = _mm256_castsi256_ps(_mm256_set1_epi32(int32_t(i)));
+          hitSphere = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(hitSphere), sphere, hit));
+        }
+      } else {
+        const uint32_t lane = uint32_t(__builtin_ctz(uint32_t(hitMask)));
+        const float *directions[] = {packet->dx, packet->dy, packet->dz};
+        const bool negative = directions[node.axis][lane] < 0;
+        mgAssert(stackSize < MAX_STACK_SIZE);
+        stack[stackSize++] = node.leftOrFirst + (negative ? 0 : 1);
+        nodeIndex = node.leftOrFirst + (negative ? 1 : 0);
+        continue;
+      }
+    }
+    if (stackSize == 0)
+      break;
+    nodeIndex = stack[--stackSize];
+  }
+  _mm256_store_ps(packet->t, t);
+  _mm256_store_si256((__m256i *)packet->sphere, hitSphere);
+}
+#endif
+
+void intersect(const CpuRayTracer &rayTracer, RayPacket *packet, uint32_t activeMask) {
+#if defined(__AVX2__)
+  if (rayTracer.useSimd) {
+    intersectPacket(rayTracer, packet);
+    return;
+  }
+#endif
+  for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+    if (activeMask & (1u << lane))
+      intersectRay(rayTracer, packet, lane);
+  }
+}
+
+// the payload written by the miss and closest hit shaders
+struct PayLoad {
+  glm::vec4 attenuation;
+  glm::vec4 scatterDirection;
+};
+
+PayLoad shade(const CpuRayTracer &rayTracer, const glm::vec3 &origin, const glm::vec3 &direction, float t,
+              int32_t sphere, Sobol *sobol, uint32_t *seed) {
+  PayLoad payload = {};
+  if (sphere == NO_HIT) {
+    const float s = 0.5f * (glm::normalize(direction).y + 1);
+    payload.attenuation = glm::vec4(glm::mix(glm::vec3(1.0f), glm::vec3(0.5f, 0.7f, 1.0f), s), -1);
+    return payload;
+  }
+
+  const glm::vec3 center = {rayTracer.x[sphere], rayTracer.y[sphere], rayTracer.z[sphere]};
+  const float radius = rayTracer.radius[sphere];
+  const glm::vec4 albedo = rayTracer.albedos[sphere];
+  const glm::vec3 hitPoint = origin + direction * t;
+  const glm::vec3 normal = glm::normalize((hitPoint - center) / radius);
+
+  switch (rayTracer.materials[sphere]) {
+  case World::LAMBERTH: {
+    payload.attenuation = albedo;
+    payload.scatterDirection = glm::vec4(normal + randomInUnitSphereSalton(rayTracer, sobol), t);
+    break;
+  }
+  case World::METAL: {
+    const glm::vec3 reflected = glm::reflect(direction, normal);
+    // the shader draws two numbers it does not use, keep the seed in step
+    rndFloat(seed);
+    rndFloat(seed);
+    payload.attenuation = albedo;
+    payload.scatterDirection = glm::vec4(normal + randomInUnitSphereSalton(rayTracer, sobol) * albedo.w, t);
+    payload.attenuation.w = glm::dot(reflected, normal) > 0 ? 1.0f : -1.0f;
+    break;
+  }
+  case World::DIELECTRIC: {
+    const float refIdx = albedo.w;
+    const glm::vec3 reflected = glm::reflect(direction, normal);
+    glm::vec3 outwardNormal;
+    glm::vec3 refracted(0.0f);
+    float niOverNt, reflectProb, cosine;
+    if (glm::dot(direction, normal) > 0) {
+      outwardNormal = -normal;
+      niOverNt = refIdx;
+      cosine = refIdx * glm::dot(direction, normal) / glm::length(direction);
+    } else {
+      outwardNormal = normal;
+      niOverNt = 1 / refIdx;
+      cosine = -glm::dot(direction, normal) / glm::length(direction);
+    }
+    if (refract(direction, outwardNormal, niOverNt, &refracted)) {
+      reflectProb = schlick(cosine, refIdx);
+    } else {
+      payload.scatterDirection = glm::vec4(reflected, t);
+      reflectProb = 1;
+    }
+    if (rndFloat(seed) < reflectProb)
+      payload.scatterDirection = glm::vec4(reflected, t);
+    else
+      payload.scatterDirection = glm::vec4(refracted, t);
+    payload.attenuation = glm::vec4(1);
+    break;
+  }
+  }
+  return payload;
+}
+
+struct FrameInfo {
+  CpuRayCamera camera;
+  CpuRayTracerSettings settings;
+  uint32_t frameIndex;
+  bool resetAccumulation;
+};
+
+// procedural.ray @gen for the eight pixels starting at (x, y), returns the number of traced rays
+uint64_t tracePacket(CpuRayTracer *rayTracer, const FrameInfo &frameInfo, uint32_t x, uint32_t y) {
+  const auto &settings = frameInfo.settings;
+  const auto &camera = frameInfo.camera;
+  const float focusDistance = glm::distance(camera.position, camera.lookat);
+
+  uint32_t validMask = 0;
+  Sobol sobol[PACKET_SIZE];
+  uint32_t seeds[PACKET_SIZE];
+  glm::vec2 ndc[PACKET_SIZE];
+  glm::vec3 color[PACKET_SIZE] = {};
+  for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+    const uint32_t px = x + lane;
+    if (px >= rayTracer->width)
+      continue;
+    validMask |= 1u << lane;
+    const uint8_t *texel =
+        &rayTracer->blueNoise[4 * ((y % rayTracer->blueNoiseHeight) * rayTracer->blueNoiseWidth +
+                                   px % rayTracer->blueNoiseWidth)];
+    glm::vec4 blueNoise = glm::vec4{texel[0], texel[1], texel[2], texel[3]} / 255.0f;
+    blueNoise = glm::mod(blueNoise * float(frameInfo.frameIndex) * 0.05f, 1.0f);
+    seeds[lane] = seedRnd(seedRnd(px, y), frameInfo.frameIndex);
+    sobol[lane] = {0, seeds[lane] % rayTracer->nrOfSobolTables, blueNoise};
+
+    glm::vec2 uv = (glm::vec2{px, y} + 0.5f) / glm::vec2{rayTracer->width, rayTracer->height};
+    uv.y = 1 - uv.y;
+    ndc[lane] = uv * 2.0f - 1.0f;
+  }
+
+  uint64_t nrOfRays = 0;
+  RayPacket packet;
+  for (uint32_t sample = 0; sample < settings.nrOfSamplesPerFrame; sample++) {
+    glm::vec3 bounceColor[PACKET_SIZE];
+    for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+      bounceColor[lane] = glm::vec3(1);
+      if (!(validMask & (1u << lane)))
+        continue;
+      const glm::vec2 rnd = glm::vec2(nextSobol(*rayTracer, &sobol[lane]));
+      const glm::vec2 offset = concentricMapping(settings.aperture / 2.0f, rnd.x, rnd.y);
+      const glm::vec4 origin = camera.viewInverse * glm::vec4(offset, 0, 1);
+      const glm::vec4 target = camera.projInverse * glm::vec4(ndc[lane].x, ndc[lane].y, 1, 1);
+      const glm::vec4 direction =
+          camera.viewInverse * glm::vec4(glm::normalize(glm::vec3(target) * focusDistance - glm::vec3(offset, 0)), 0);
+      packet.ox[lane] = origin.x, packet.oy[lane] = origin.y, packet.oz[lane] = origin.z;
+      packet.dx[lane] = direction.x, packet.dy[lane] = direction.y, packet.dz[lane] = direction.z;
+    }
+
+    uint32_t activeMask = validMask;
+    for (uint32_t bounce = 0; bounce < settings.nrOfBounces && activeMask; bounce++) {
+      for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+        const bool active = activeMask & (1u << lane);
+        packet.t[lane] = active ? T_MAX : 0.0f;
+        packet.sphere[lane] = NO_HIT;
+        if (!active)
+          packet.ox[lane] = packet.oy[lane] = packet.oz[lane] = packet.dx[lane] = packet.dy[lane] = packet.dz[lane] = 1;
+      }
+      intersect(*rayTracer, &packet, activeMask);
+      nrOfRays += uint64_t(__builtin_popcount(activeMask));
+
+      for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+        if (!(activeMask & (1u << lane)))
+          continue;
+        const glm::vec3 origin = {packet.ox[lane], packet.oy[lane], packet.oz[lane]};
+        const glm::vec3 direction = {packet.dx[lane], packet.dy[lane], packet.dz[lane]};
+        const auto payload =
+            shade(*rayTracer, origin, direction, packet.t[lane], packet.sphere[lane], &sobol[lane], &seeds[lane]);
+        bounceColor[lane] *= glm::vec3(payload.attenuation);
+        if (payload.attenuation.w < 0) {
+          activeMask &= ~(1u << lane);
+          continue;
+        }
+        const glm::vec3 next = origin + direction * payload.scatterDirection.w;
+        packet.ox[lane] = next.x, packet.oy[lane] = next.y, packet.oz[lane] = next.z;
+        packet.dx[lane] = payload.scatterDirection.x;
+        packet.dy[lane] = payload.scatterDirection.y;
+        packet.dz[lane] = payload.scatterDirection.z;
+      }
+    }
+    for (uint32_t lane = 0; lane < PACKET_SIZE; lane++)
+      color[lane] += bounceColor[lane];
+  }
+
+  for (uint32_t lane = 0; lane < PACKET_SIZE; lane++) {
+    if (!(validMask & (1u << lane)))
+      continue;
+    const uint32_t pixel = y * rayTracer->width + x + lane;
+    glm::vec3 average;
+    if (frameInfo.resetAccumulation) {
+      rayTracer->accumulation[pixel] = color[lane];
+      average = color[lane] / float(settings.nrOfSamplesPerFrame);
+    } else {
+      rayTracer->accumulation[pixel] += color[lane];
+      average = rayTracer->accumulation[pixel] / float(rayTracer->totalNrOfSamples);
+    }
+    const glm::vec3 srgb = glm::clamp(glm::sqrt(average), 0.0f, 1.0f);
+    uint8_t *dst = &rayTracer->image[4 * pixel];
+    dst[0] = uint8_t(std::lround(srgb.r * 255.0f));
+    dst[1] = uint8_t(std::lround(srgb.g * 255.0f));
+    dst[2] = uint8_t(std::lround(srgb.b * 255.0f));
+    dst[3] = 255;
+  }
+  return nrOfRays;
+}
+
+} // namespace
+
+CpuRayTracer createCpuRayTracer(const World &world, const CpuRayTracerSettings &settings, uint32_t width,
+                                uint32_t height, std::vector<glm::vec4> sobol, uint32_t nrOfSobolTables,
+                                std::vector<uint8_t> blueNoise, uint32_t blueNoiseWidth, uint32_t blueNoiseHeight,
+                                mg::WorkerPool *workers, bool useSimd) {
+  mgAssert(!world.positions.empty());
+  mgAssert(world.positions.size() == world.albedos.size() && world.positions.size() == world.materials.size());
+  mgAssert(!sobol.empty() && nrOfSobolTables > 0 && sobol.size() % nrOfSobolTables == 0);
+  mgAssert(blueNoise.size() == size_t(4) * blueNoiseWidth * blueNoiseHeight && !blueNoise.empty());
+  mgAssert(settings.maxSpheresPerLeaf > 0);
+
+  CpuRayTracer rayTracer = {};
+  rayTracer.width = width;
+  rayTracer.height = height;
+  rayTracer.workers = workers;
+  rayTracer.threadNrOfRays.resize(workers->nrOfThreads());
+  rayTracer.useSimd = useSimd;
+  rayTracer.sobolCount = uint32_t(sobol.size()) / nrOfSobolTables;
+  rayTracer.nrOfSobolTables = nrOfSobolTables;
+  rayTracer.sobol = std::move(sobol);
+  rayTracer.blueNoise = std::move(blueNoise);
+  rayTracer.blueNoiseWidth = blueNoiseWidth;
+  rayTracer.blueNoiseHeight = blueNoiseHeight;
+  rayTracer.accumulation.resize(size_t(width) * height);
+  rayTracer.image.resize(size_t(4) * width * height);
+
+  const auto nrOfSpheres = uint32_t(world.positions.size());
+  std::vector<uint32_t> spheres(nrOfSpheres);
+  for (uint32_t i = 0; i < nrOfSpheres; i++)
+    spheres[i] = i;
+  rayTracer.nodes.reserve(2 * nrOfSpheres);
+  rayTracer.nodes.resize(1);
+  buildBvhNode(world, settings.maxSpheresPerLeaf, 0, spheres.data(), 0, nrOfSpheres, &rayTracer.nodes);
+
+  for (auto sphere : spheres) {
+    const auto &position = world.positions[sphere];
+    rayTracer.x.push_back(position.x);
+    rayTracer.y.push_back(position.y);
+    rayTracer.z.push_back(position.z);
+    rayTracer.radius.push_back(position.w);
+    rayTracer.albedos.push_back(world.albedos[sphere]);
+    rayTracer.materials.push_back(world.materials[sphere]);
+  }
+  return rayTracer;
+}
+
+CpuRayStats renderCpuFrame(CpuRayTracer *rayTracer, const CpuRayCamera &camera, const CpuRayTracerSettings &settings,
+                           bool resetAccumulation) {
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  // the same counters as traceTriangle
+  rayTracer->frame++;
+  rayTracer->totalNrOfSamples += settings.nrOfSamplesPerFrame;
+  if (resetAccumulation)
+    rayTracer->totalNrOfSamples = settings.nrOfSamplesPerFrame;
+  const FrameInfo frameInfo = {camera, settings, rayTracer->frame, resetAccumulation};
+
+  const uint32_t tilesX = (rayTracer->width + TILE_WIDTH - 1) / TILE_WIDTH;
+  const uint32_t tilesY = (rayTracer->height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  const uint32_t nrOfTiles = tilesX * tilesY;
+  std::fill(rayTracer->threadNrOfRays.begin(), rayTracer->threadNrOfRays.end(), 0);
+
+  rayTracer->workers->parallelFor(nrOfTiles, 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex) {
+    uint64_t rays = 0;
+    for (uint32_t tile = begin; tile < end; tile++) {
+      const uint32_t x0 = (tile % tilesX) * TILE_WIDTH, y0 = (tile / tilesX) * TILE_HEIGHT;
+      const uint32_t x1 = std::min(x0 + TILE_WIDTH, rayTracer->width);
+      const uint32_t y1 = std::min(y0 + TILE_HEIGHT, rayTracer->height);
+      for (uint32_t y = y0; y < y1; y++) {
+        for (uint32_t x = x0; x < x1; x += PACKET_SIZE)
+          rays += tracePacket(rayTracer, frameInfo, x, y);
+      }
+    }
+    rayTracer->threadNrOfRays[threadIndex] += rays;
+  });
+
+  CpuRayStats stats = {};
+  stats.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  stats.nrOfSamples = uint64_t(rayTracer->width) * rayTracer->height * settings.nrOfSamplesPerFrame;
+  for (const auto rays : rayTracer->threadNrOfRays)
+    stats.nrOfRays += rays;
+  return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ray_world.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mg {
+class WorkerPool;
+}
+
+// Software path tracer for the procedural sphere scene, it follows procedural.ray and rayUtils.hglsl step by step so
+// the image can be compared with the gpu one. Spheres are put in a binned SAH bvh, the image is split in tiles that the
+// threads of the worker pool take in turn, and eight neighbouring pixels are traced together as one simd ray packet.
+struct CpuRayTracerSettings {
+  uint32_t nrOfSamplesPerFrame = 10;
+  uint32_t nrOfBounces = 5;
+  float aperture = 0.1f;
+  uint32_t maxSpheresPerLeaf = 4;
+};
+
+// the same values as the Ubo in procedural.ray
+struct CpuRayCamera {
+  glm::mat4 viewInverse;
+  glm::mat4 projInverse;
+  glm::vec3 position;
+  glm::vec3 lookat;
+};
+
+struct CpuBvhNode {
+  glm::vec3 min;
+  uint32_t leftOrFirst; // left child for inner nodes with the right child at leftOrFirst + 1, first sphere for leaves
+  glm::vec3 max;
+  uint32_t count;       // number of spheres, 0 for inner nodes
+  uint32_t axis;        // split axis, the child on the negative side is left
+};
+
+struct CpuRayStats {
+  double ms;
+  uint64_t nrOfSamples; // camera paths
+  uint64_t nrOfRays;    // all traced rays including the bounces
+};
+
+struct CpuRayTracer {
+  uint32_t width, height;
+  mg::WorkerPool *workers;
+  bool useSimd;
+
+  std::vector<CpuBvhNode> nodes;
+  // spheres in bvh order
+  std::vector<float> x, y, z, radius;
+  std::vector<glm::vec4> albedos;
+  std::vector<World::MATERIAL> materials;
+
+  std::vector<glm::vec4> sobol; // nrOfSobolTables tables of sobolCount points
+  uint32_t sobolCount, nrOfSobolTables;
+  std::vector<uint8_t> blueNoise; // rgba8
+  uint32_t blueNoiseWidth, blueNoiseHeight;
+
+  std::vector<glm::vec3> accumulation; // summed samples per pixel
+  std::vector<uint8_t> image;          // rgba8, the square root of the average like the storage image
+  uint32_t frame;
+  uint32_t totalNrOfSamples;
+  std::vector<uint64_t> threadNrOfRays; // rays traced by each thread of the pool in the current frame
+};
+
+CpuRayTracer createCpuRayTracer(const World &world, const CpuRayTracerSettings &settings, uint32_t width,
+                                uint32_t height, std::vector<glm::vec4> sobol, uint32_t nrOfSobolTables,
+                                std::vector<uint8_t> blueNoise, uint32_t blueNoiseWidth, uint32_t blueNoiseHeight,
+                                mg::WorkerPool *workers, bool useSimd);
+
+// adds nrOfSamplesPerFrame samples to every pixel, or starts over when resetAccumulation is set
+CpuRayStats renderCpuFrame(CpuRayTracer *rayTracer, const CpuRayCamera &camera, const CpuRayTracerSettings &settings,
+                           bool resetAccumulation);
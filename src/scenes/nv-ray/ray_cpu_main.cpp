@@ -0,0 +1,109 @@
+#include "mg/camera.h"
+#include "mg/logger.h"
+#include "mg/mgUtils.h"
+#include "mg/workerPool.h"
+#include "ray_cpu.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <lodepng.h>
+#include <string>
+
+// Headless cpu path tracing of the procedural sphere scene, no window or gpu is needed.
+// ray-cpu [--output=file.png] [--size=WxH] [--frames=N] [--samples=N] [--threads=N] [--scalar] [--verify]
+// --verify renders with both the simd and the scalar path and returns 1 if the images differ.
+int main(int argc, char **argv) {
+  std::string outputPath = "ray_cpu.png";
+  uint32_t width = 1280, height = 720;
+  uint32_t nrOfFrames = 5;
+  uint32_t nrOfThreads = 0;
+  bool useSimd = true;
+  bool verify = false;
+  CpuRayTracerSettings settings = {};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--output=", 0) == 0)
+      outputPath = arg.substr(strlen("--output="));
+    else if (arg.rfind("--size=", 0) == 0)
+      sscanf(arg.c_str(), "--size=%ux%u", &width, &height);
+    else if (arg.rfind("--frames=", 0) == 0)
+      nrOfFrames = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--frames=")))));
+    else if (arg.rfind("--samples=", 0) == 0)
+      settings.nrOfSamplesPerFrame = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--samples=")))));
+    else if (arg.rfind("--threads=", 0) == 0)
+      nrOfThreads = uint32_t(std::stoul(arg.substr(strlen("--threads="))));
+    else if (arg == "--scalar")
+      useSimd = false;
+    else if (arg == "--verify")
+      verify = true;
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  World world = {};
+  createRandomSpheres(&world);
+  const auto sobol = createSobolSequence(sobolCount, nrOfSobolTables);
+
+  std::vector<uint8_t> blueNoise;
+  uint32_t blueNoiseWidth, blueNoiseHeight;
+  const auto decodeError =
+      lodepng::decode(blueNoise, blueNoiseWidth, blueNoiseHeight, mg::getTexturePath() + "HDR_RGBA_0.png");
+  if (decodeError) {
+    LOG("decoder error " << decodeError << ": " << lodepng_error_text(decodeError));
+    return 1;
+  }
+
+  // same camera as the interactive scene
+  auto camera = mg::create3DCamera(glm::vec3{12, 4, -4}, glm::vec3{0, 0, 0}, glm::vec3{0, 1, 0});
+  mg::setCameraTransformation(&camera);
+  CpuRayCamera rayCamera = {};
+  rayCamera.projInverse =
+      glm::inverse(glm::perspective(glm::radians(camera.fov), width / float(height), 0.1f, 1000.f));
+  rayCamera.viewInverse = glm::inverse(glm::lookAt(camera.position, camera.aim, camera.up));
+  rayCamera.position = camera.position;
+  rayCamera.lookat = camera.aim;
+
+  mg::WorkerPool workers;
+  workers.create(nrOfThreads);
+  auto render = [&](bool simd) {
+    auto rayTracer = createCpuRayTracer(world, settings, width, height, sobol, nrOfSobolTables, blueNoise,
+                                        blueNoiseWidth, blueNoiseHeight, &workers, simd);
+    LOG(world.positions.size() << " spheres in " << rayTracer.nodes.size() << " bvh nodes");
+    double bestRaysPerSecond = 0;
+    for (uint32_t i = 0; i < nrOfFrames; i++) {
+      const auto stats = renderCpuFrame(&rayTracer, rayCamera, settings, i == 0);
+      const double seconds = stats.ms / 1000.0;
+      bestRaysPerSecond = std::max(bestRaysPerSecond, stats.nrOfRays / seconds);
+      LOG("frame " << i << ": " << stats.ms << " ms, " << stats.nrOfSamples / seconds / 1e6 << " Msamples/s, "
+                   << stats.nrOfRays / seconds / 1e6 << " Mrays/s");
+    }
+    LOG((simd ? "simd" : "scalar") << " best: " << bestRaysPerSecond / 1e6 << " Mrays/s");
+    return rayTracer.image;
+  };
+
+  const auto image = render(useSimd);
+  const auto encodeError = lodepng::encode(outputPath, image, width, height);
+  if (encodeError) {
+    LOG("encoder error " << encodeError << ": " << lodepng_error_text(encodeError));
+    return 1;
+  }
+
+  if (!verify)
+    return 0;
+
+  // both paths do the same float operations per ray, only the bvh traversal order differs
+  const auto reference = render(!useSimd);
+  uint32_t nrOfDifferentPixels = 0;
+  for (size_t i = 0; i < image.size(); i += 4) {
+    for (size_t c = 0; c < 3; c++) {
+      if (std::abs(int(image[i + c]) - int(reference[i + c])) > 1) {
+        nrOfDifferentPixels++;
+        break;
+      }
+    }
+  }
+  LOG(nrOfDifferentPixels << " pixels differ between the simd and the scalar path");
+  return nrOfDifferentPixels > 0 ? 1 : 0;
+}
@@ -3,8 +3,11 @@
 #include "mg/geometryUtils.h"
 #include "mg/mgSystem.h"
 #include "mg/window.h"
+#include "ray_binding_table.h"
 #include "ray_utils.h"
 #include "rendering/rendering.h"
+#include "shaders/imageStorage.h"
+#include "shaders/procedural.h"
 #include "vulkan/shaders.h"
 
 static mg::Pipeline createRayPipeline() {
@@ -45,24 +48,29 @@ static mg::Pipeline createRayPipeline() {
   return pipeline;
 }
 
+void createRayTracingPipeline(RayInfo *rayInfo) {
+  rayInfo->rayTracingPipeline = createRayPipeline();
+
+  // one hit record per instance geometry, pointing at hit group 2, 3 or 4 for lambert, metal and dielectric
+  ShaderBindingTableInfo shaderBindingTableInfo = {};
+  shaderBindingTableInfo.rayGenGroup = 0;
+  shaderBindingTableInfo.missGroups = {1};
+  shaderBindingTableInfo.hitGroupRecords = rayInfo->sphereLayout.hitGroupRecords;
+
+  rayInfo->shaderBindingTable =
+      createShaderBindingTable(rayInfo->rayTracingPipeline, rayInfo->rayTracingProperties, shaderBindingTableInfo);
+}
+
+void destroyRayTracingPipeline(RayInfo *rayInfo) {
+  destroyShaderBindingTable(&rayInfo->shaderBindingTable);
+  rayInfo->rayTracingPipeline = {};
+}
+
 void traceTriangle(const World &world, const mg::Camera &camera, const mg::RenderContext &renderContext,
                    const RayInfo &rayInfo) {
   using namespace mg::shaders::procedural;
 
-  auto pipeline = createRayPipeline();
-  constexpr uint32_t groupCount = 5; // groupCount is the number of shader handles to retrieve
-  const uint32_t shaderGroupHandleSize = rayInfo.rayTracingProperties.shaderGroupHandleSize;
-  const uint32_t bindingTableSize =
-      shaderGroupHandleSize * groupCount; // dataSize must be at least
-                                          // VkPhysicalDeviceRayTracingPropertiesNV::shaderGroupHandleSize  groupCount
-
-  VkBuffer bindingTableBuffer;
-  VkDeviceSize bindingTableOffset;
-  uint8_t *data = (uint8_t *)mg::mgSystem.linearHeapAllocator.allocateBuffer(bindingTableSize, &bindingTableBuffer,
-                                                                             &bindingTableOffset);
-
-  mg::checkResult(mg::nv::vkGetRayTracingShaderGroupHandlesNV(mg::vkContext.device, pipeline.pipeline, 0, groupCount,
-                                                              bindingTableSize, data));
+  const auto &pipeline = rayInfo.rayTracingPipeline;
 
   VkBuffer uniformBuffer;
   uint32_t uniformOffset;
@@ -74,22 +82,23 @@ void traceTriangle(const World &world, const mg::Camera &camera, const mg::Rende
   uint32_t storageOffset;
   VkDescriptorSet storageSet;
 
+  // the storage is sized by the spheres of the layout, it has one element per sphere
+  const auto &sphereLayout = rayInfo.sphereLayout;
+  const auto nrOfSpheres = sphereLayout.positions.size();
   Storage::StorageData *storage = (Storage::StorageData *)mg::mgSystem.linearHeapAllocator.allocateStorage(
-      sizeof(storage) * world.positions.size(), &storageBuffer, &storageOffset, &storageSet);
-  mgAssert(mg::sizeofContainerInBytes(world.positions) <= sizeof(storage->positions));
-  memcpy(storage->positions, world.positions.data(), mg::sizeofContainerInBytes(world.positions));
-  memcpy(storage->albedos, world.albedos.data(), mg::sizeofContainerInBytes(world.positions));
+      sizeof(Storage::StorageData) * nrOfSpheres, &storageBuffer, &storageOffset, &storageSet);
+  for (size_t i = 0; i < nrOfSpheres; i++)
+    storage[i] = {sphereLayout.positions[i], sphereLayout.albedos[i]};
 
   ubo->projInverse = glm::inverse(renderContext.projection);
   ubo->viewInverse = glm::inverse(renderContext.view);
   static uint32_t frame = 0;
   static uint32_t totalNrOfSamples = 0;
-  static const uint32_t nrOfSamplesPerFrame = 10;
   totalNrOfSamples += nrOfSamplesPerFrame;
   if (rayInfo.resetAccumulationImage)
     totalNrOfSamples = nrOfSamplesPerFrame;
 
-  ubo->attrib = {++frame, world.blueNoise.index, nrOfSamplesPerFrame, totalNrOfSamples};
+  ubo->attrib = {++frame, rayInfo.blueNoiseId.index, nrOfSamplesPerFrame, totalNrOfSamples};
   ubo->sobolId = {float(rayInfo.sobolId.index),0,0,0};
   ubo->cameraPosition = {camera.position.x, camera.position.y, camera.position.z,
                          rayInfo.resetAccumulationImage ? 1.0f : 0.0f};
@@ -111,13 +120,8 @@ void traceTriangle(const World &world, const mg::Camera &camera, const mg::Rende
 
   vkCmdBindPipeline(mg::vkContext.commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_NV, pipeline.pipeline);
 
-  // clang-format off
-  mg::nv::vkCmdTraceRaysNV(mg::vkContext.commandBuffer, 
-    bindingTableBuffer, bindingTableOffset, // raygenShader
-    bindingTableBuffer, bindingTableOffset + shaderGroupHandleSize, shaderGroupHandleSize, //missShader
-    bindingTableBuffer, bindingTableOffset + shaderGroupHandleSize * 2, shaderGroupHandleSize, // hitShader
-    VK_NULL_HANDLE, 0, 0, mg::vkContext.screen.width, mg::vkContext.screen.height, 1);
-  // clang-format on
+  traceRays(mg::vkContext.commandBuffer, rayInfo.shaderBindingTable, mg::vkContext.screen.width,
+            mg::vkContext.screen.height);
 }
 
 static mg::Pipeline createImageStoragePipeline(const mg::RenderContext &renderContext) {
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace mg {
 struct RenderContext;
@@ -7,5 +8,10 @@ struct Camera;
 struct World;
 
 struct RayInfo;
+inline constexpr uint32_t nrOfSamplesPerFrame = 10;
+
+// the pipeline and its shader binding table are created once and after every pipeline reset
+void createRayTracingPipeline(RayInfo *rayInfo);
+void destroyRayTracingPipeline(RayInfo *rayInfo);
 void traceTriangle(const World &world, const mg::Camera &camera, const mg::RenderContext &renderContext, const RayInfo &rayInfo);
 void drawImageStorage(const mg::RenderContext &renderContext, const RayInfo &rayInfo);
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "ray_sampler.h"
+#include "mg/logger.h"
+#include "mg/mgAssert.h"
+#include "sobol.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t SIMD_WIDTH = 8;
+constexpr uint32_t NR_OF_BITS = 32;
+constexpr uint32_t CACHE_MAGIC = 0x4c424f53; // "SOBL"
+constexpr uint32_t CACHE_VERSION = 1;
+
+uint32_t hash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+uint32_t hashCombine(uint32_t seed, uint32_t value) {
+  return hash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+uint32_t reverseBits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+// Practical Hash-based Owen Scrambling, Brent Burley 2020
+uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+  return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+}
+
+// the top 24 bits, so the float is exact and never rounds up to 1
+float toUnitFloat(uint32_t x) { return float(x >> 8) * (1.0f / (1u << 24)); }
+
+// generator state padded to whole simd registers, the padding lanes have zero direction numbers
+struct SobolGenerator {
+  uint32_t nrOfDimensions;
+  uint32_t nrOfLanes;
+  std::vector<uint32_t> columns; // direction number of bit b for lane d at [b * nrOfLanes + d]
+};
+
+SobolGenerator createGenerator(const SobolTableInfo &info) {
+  SobolGenerator generator = {};
+  generator.nrOfDimensions = uint32_t(info.dimensions.size());
+  generator.nrOfLanes = (generator.nrOfDimensions + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+  generator.columns.resize(NR_OF_BITS * generator.nrOfLanes, 0);
+  for (uint32_t d = 0; d < generator.nrOfDimensions; d++) {
+    const uint32_t *matrix = &sobol::Matrices::matrices[info.dimensions[d] * sobol::Matrices::size];
+    for (uint32_t bit = 0; bit < NR_OF_BITS; bit++)
+      generator.columns[bit * generator.nrOfLanes + d] = matrix[bit];
+  }
+  return generator;
+}
+
+void generateTableScalar(const SobolGenerator &generator, const SobolTableInfo &info, const uint32_t *seeds,
+                         float *dst) {
+  std::vector<uint32_t> state(generator.nrOfLanes, 0);
+  for (uint32_t i = 0; i < info.count; i++) {
+    if (i > 0) {
+      const uint32_t *column = &generator.columns[uint32_t(__builtin_ctz(i)) * generator.nrOfLanes];
+      for (uint32_t d = 0; d < generator.nrOfDimensions; d++)
+        state[d] ^= column[d];
+    }
+    for (uint32_t d = 0; d < generator.nrOfDimensions; d++) {
+      const uint32_t x = info.scramble ? nestedUniformScramble(state[d], seeds[d]) : state[d];
+      dst[size_t(i) * generator.nrOfDimensions + d] = toUnitFloat(x);
+    }
+  }
+}
+
+#if defined(__AVX2__)
+__m256i reverseBits(__m256i x) {
+  const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+  const __m256i reversedNibbles = _mm256_setr_epi8(0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe, 0x1, 0x9, 0x5, 0xd, 0x3,
+                                                   0xb, 0x7, 0xf, 0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe, 0x1, 0x9,
+                                                   0x5, 0xd, 0x3, 0xb, 0x7, 0xf);
+  const __m256i byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+                                            5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i low = _mm256_shuffle_epi8(reversedNibbles, _mm256_and_si256(x, lowNibbles));
+  const __m256i high = _mm256_shuffle_epi8(reversedNibbles, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowNibbles));
+  // the bits of every byte are reversed, then the bytes of every lane
+  return _mm256_shuffle_epi8(_mm256_or_si256(_mm256_slli_epi16(low, 4), high), byteSwap);
+}
+
+__m256i nestedUniformScramble(__m256i x, __m256i seed) {
+  x = _mm256_add_epi32(reverseBits(x), seed);
+  x = _mm256_xor_si256(x, _mm256_mullo_epi32(x, _mm256_set1_epi32(int32_t(0x6c50b47cu))));
+  x = _mm256_xor_si256(x, _mm256_mullo_epi32(x, _mm256_set1_epi32(int32_t(0xb82f1e52u))));
+  x = _mm256_xor_si256(x, _mm256_mullo_epi32(x, _mm256_set1_epi32(int32_t(0xc7afe638u))));
+  x = _mm256_xor_si256(x, _mm256_mullo_epi32(x, _mm256_set1_epi32(int32_t(0x8d22f6e6u))));
+  return reverseBits(x);
+}
+
+void generateTableSimd(const SobolGenerator &generator, const SobolTableInfo &info, const uint32_t *seeds,
+                       float *dst) {
+  const uint32_t nrOfRegisters = generator.nrOfLanes / SIMD_WIDTH;
+  const __m256 scale = _mm256_set1_ps(1.0f / (1u << 24));
+  std::vector<uint32_t> state(generator.nrOfLanes, 0);
+  alignas(32) float values[SIMD_WIDTH];
+  for (uint32_t i = 0; i < info.count; i++) {
+    const uint32_t *column = i > 0 ? &generator.columns[uint32_t(__builtin_ctz(i)) * generator.nrOfLanes] : nullptr;
+    float *point = dst + size_t(i) * generator.nrOfDimensions;
+    for (uint32_t r = 0; r < nrOfRegisters; r++) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(state.data() + r * SIMD_WIDTH));
+      if (column) {
+        x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i *)(column + r * SIMD_WIDTH)));
+        _mm256_storeu_si256((__m256i *)(state.data() + r * SIMD_WIDTH), x);
+      }
+      if (info.scramble)
+        x = nestedUniformScramble(x, _mm256_loadu_si256((const __m256i *)(seeds + r * SIMD_WIDTH)));
+      const __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)), scale);
+      const uint32_t nrOfValues = std::min(SIMD_WIDTH, generator.nrOfDimensions - r * SIMD_WIDTH);
+      if (nrOfValues == SIMD_WIDTH) {
+        _mm256_storeu_ps(point + r * SIMD_WIDTH, value);
+      } else {
+        _mm256_store_ps(values, value);
+        memcpy(point + r * SIMD_WIDTH, values, nrOfValues * sizeof(float));
+      }
+    }
+  }
+}
+#endif
+
+std::string cacheName(const SobolTableInfo &info) {
+  std::string name = "sobol_d";
+  for (size_t i = 0; i < info.dimensions.size(); i++)
+    name += (i ? "-" : "") + std::to_string(info.dimensions[i]);
+  name += "_n" + std::to_string(info.count) + "_t" + std::to_string(info.nrOfTables);
+  name += info.scramble ? "_s" + std::to_string(info.seed) : "_u";
+  return name + ".bin";
+}
+
+std::vector<uint32_t> cacheHeader(const SobolTableInfo &info) {
+  const uint32_t seed = info.scramble ? info.seed : 0;
+  std::vector<uint32_t> header = {CACHE_MAGIC, CACHE_VERSION, info.count, info.nrOfTables, seed,
+                                  uint32_t(info.scramble), uint32_t(info.dimensions.size())};
+  header.insert(header.end(), info.dimensions.begin(), info.dimensions.end());
+  return header;
+}
+
+} // namespace
+
+std::vector<float> createSobolTable(const SobolTableInfo &info) {
+  mgAssert(!info.dimensions.empty());
+  mgAssert(info.count > 0 && info.nrOfTables > 0);
+  for (auto dimension : info.dimensions)
+    mgAssert(dimension < sobol::Matrices::num_dimensions);
+
+  const auto generator = createGenerator(info);
+  std::vector<uint32_t> seeds(generator.nrOfLanes, 0);
+  std::vector<float> table(size_t(info.nrOfTables) * info.count * generator.nrOfDimensions);
+
+  for (uint32_t t = 0; t < info.nrOfTables; t++) {
+    for (uint32_t d = 0; d < generator.nrOfDimensions; d++)
+      seeds[d] = hashCombine(hashCombine(info.seed, t), info.dimensions[d]);
+    float *dst = table.data() + size_t(t) * info.count * generator.nrOfDimensions;
+#if defined(__AVX2__)
+    if (info.useSimd) {
+      generateTableSimd(generator, info, seeds.data(), dst);
+      continue;
+    }
+#endif
+    generateTableScalar(generator, info, seeds.data(), dst);
+  }
+  return table;
+}
+
+std::vector<float> loadSobolTable(const SobolTableInfo &info, const std::string &cacheDirectory) {
+  const auto path = cacheDirectory + cacheName(info);
+  const auto header = cacheHeader(info);
+  const size_t nrOfValues = size_t(info.nrOfTables) * info.count * info.dimensions.size();
+
+  std::ifstream input(path, std::ios::binary);
+  if (input.good()) {
+    std::vector<uint32_t> fileHeader(header.size());
+    std::vector<float> table(nrOfValues);
+    input.read((char *)fileHeader.data(), fileHeader.size() * sizeof(uint32_t));
+    input.read((char *)table.data(), table.size() * sizeof(float));
+    if (input.good() && fileHeader == header)
+      return table;
+    LOG("sobol cache " << path << " is out of date");
+  }
+
+  auto table = createSobolTable(info);
+  std::ofstream output(path, std::ios::binary);
+  output.write((const char *)header.data(), header.size() * sizeof(uint32_t));
+  output.write((const char *)table.data(), table.size() * sizeof(float));
+  if (!output.good())
+    LOG("could not write sobol cache " << path);
+  return table;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sobol sample tables for the path tracers. Points are enumerated in Gray code order, so every point is the previous
+// one xor a single direction number, and all dimensions of a point are generated together in simd lanes. Each table
+// gets its own nested uniform (Owen) scrambling through the Laine-Karras hash, which keeps the stratification of the
+// sequence but decorrelates tables that are read by neighbouring pixels or frames.
+struct SobolTableInfo {
+  std::vector<uint32_t> dimensions = {0, 1, 2, 3}; // below sobol::Matrices::num_dimensions
+  uint32_t count = 2048;                           // points per table
+  uint32_t nrOfTables = 1;
+  uint32_t seed = 0;
+  bool scramble = true; // false gives the plain Sobol points
+  bool useSimd = true;
+};
+
+// point i of table t in dimension d is at [(t * count + i) * dimensions.size() + d], all values in [0, 1)
+std::vector<float> createSobolTable(const SobolTableInfo &info);
+
+// reads the table from cacheDirectory if it was created with the same info before, otherwise creates and stores it
+std::vector<float> loadSobolTable(const SobolTableInfo &info, const std::string &cacheDirectory);
@@ -9,43 +9,44 @@
 #include "ray_rendering.h"
 #include "ray_utils.h"
 #include "rendering/rendering.h"
-#include "sobol.h"
 #include "vulkan/vkContext.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <random>
 
 static mg::Camera camera = {};
 static RayInfo rayinfo = {};
 static mg::SingleRenderPass singleRenderPass = {};
 static World world = {};
+static bool useClusters = true;
+static float animationTime = 0;
 
-static std::default_random_engine generator;
-
-float rng() { return std::generate_canonical<float, std::numeric_limits<double>::digits>(generator); }
-
-glm::vec4 toVec4(const glm::vec3 &v, float s) { return glm::vec4{v.x, v.y, v.z, s}; }
-
-// http://gruenschloss.org/
 static void generateSobol() {
-  constexpr uint32_t size = 2048 * 4;
-  float sequence[size];
-  for (uint32_t i = 0; i < size; i += 4) {
-    int index = i + 10;
-    sequence[i] = sobol::sample(index, 2);
-    sequence[i + 1] = sobol::sample(index, 3);
-    sequence[i + 2] = sobol::sample(index, 5);
-    sequence[i + 3] = sobol::sample(index, 7);
-  }
+  auto sequence = createSobolSequence(sobolCount, nrOfSobolTables);
   mg::CreateTextureInfo texturInfo = {.id = "sobol",
                                       .type = mg::TEXTURE_TYPE::TEXTURE_2D,
                                       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
-                                      .size = {2048, 1, 1},
-                                      .sizeInBytes = sizeof(sequence),
-                                      .data = sequence};
+                                      .size = {sobolCount, nrOfSobolTables, 1},
+                                      .sizeInBytes = mg::sizeofContainerInBytes(sequence),
+                                      .data = sequence.data()};
 
   rayinfo.sobolId = mg::mgSystem.textureContainer.createTexture(texturInfo);
 }
 
+static void setClusterSettings() {
+  if (useClusters)
+    rayinfo.clusterSettings = {};
+  else
+    rayinfo.clusterSettings = {.maxSpheresPerCluster = 1, .instanceRadius = INFINITY};
+}
+
+static void rebuildAccelerationStructures() {
+  rayinfo.resetAccumulationImage = true;
+  destroyRayTracingPipeline(&rayinfo);
+  destroyAccelerationStructures(&rayinfo);
+  setClusterSettings();
+  createAccelerationStructures(world, &rayinfo);
+  createRayTracingPipeline(&rayinfo);
+}
+
 static void resizeCallback() {
     rayinfo.resetAccumulationImage = true;
     mg::resizeSingleRenderPass(&singleRenderPass);
@@ -54,52 +55,22 @@ static void resizeCallback() {
 
 void initScene() {
   generateSobol();
-  world.blueNoise = mg::uploadPngImage("HDR_RGBA_0.png");
-
-  generator.seed(2);
-
-  addSphere({.world = &world,
-             .position = {0, -1000.0f, 0, 1000.0f},
-             .albedo = {0.5f, 0.5f, 0.5f, 1},
-             .material = World::LAMBERTH});
-
-  for (int32_t a = -11; a < 11; a++) {
-    for (int32_t b = -11; b < 11; b++) {
-      float chooseMat = rng();
-      glm::vec3 center = {a + 0.9 * rng(), 0.2, (b + 0.9 * rng()) * -1.0f};
-
-      if (glm::distance(center, {4, 0.2, 0}) > 0.9f) {
-        if (chooseMat < 0.8) { // diffuse
-          addSphere({.world = &world,
-                     .position = toVec4(center, 0.2f),
-                     .albedo = {rng() * rng(), rng() * rng(), rng() * rng(), 1},
-                     .material = World::LAMBERTH});
-        } else if (chooseMat < 0.95f) { // metal
-          addSphere({.world = &world,
-                     .position = toVec4(center, 0.2f),
-                     .albedo = {0.5f * (1 + rng()), 0.5f * (1 + rng()), 0.5f * (1 + rng()), 0.5f * rng()},
-                     .material = World::METAL});
-        } else { // glass
-          addSphere({.world = &world,
-                     .position = toVec4(center, 0.2f),
-                     .albedo = {1, 1, 1, 1.5f},
-                     .material = World::DIELECTRIC});
-        }
-      }
-    }
-  }
-  addSphere({.world = &world, .position = {0, 1, 0, 1}, .albedo = {0.8, 0.8, 0.8, 1.5}, .material = World::DIELECTRIC});
-  addSphere({.world = &world, .position = {-4, 1, 0, 1}, .albedo = {0.4, 0.2, 0.1, 1}, .material = World::LAMBERTH});
-  addSphere({.world = &world, .position = {4, 1, 0, 1}, .albedo = {0.7, 0.6, 0.5, 0.0}, .material = World::METAL});
+  rayinfo.blueNoiseId = mg::uploadPngImage("HDR_RGBA_0.png");
+
+  createRandomSpheres(&world);
 
   camera = mg::create3DCamera(glm::vec3{12, 4, -4}, glm::vec3{0, 0, 0}, glm::vec3{0, 1, 0});
+  setClusterSettings();
   createRayInfo(world, &rayinfo);
+  createRayTracingPipeline(&rayinfo);
   mg::initSingleRenderPass(&singleRenderPass);
   mg::mgSystem.textureContainer.setupDescriptorSets();
   mg::vkContext.swapChain->resizeCallack = resizeCallback;
 }
 
 void destroyScene() {
+  mg::waitForDeviceIdle();
+  destroyRayTracingPipeline(&rayinfo);
   destroyRayInfo(&rayinfo);
   mg::waitForDeviceIdle();
   destroySingleRenderPass(&singleRenderPass);
@@ -109,6 +80,17 @@ void updateScene(const mg::FrameData &frameData) {
   if (frameData.keys.r) {
     rayinfo.resetAccumulationImage = true;
     mg::mgSystem.pipelineContainer.resetPipelineContainer();
+    destroyRayTracingPipeline(&rayinfo);
+    createRayTracingPipeline(&rayinfo);
+  }
+  // n clusters the spheres into a few bottom levels, m builds one bottom level per sphere, space animates
+  if (frameData.keys.n != frameData.keys.m && useClusters != frameData.keys.n) {
+    useClusters = frameData.keys.n;
+    rebuildAccelerationStructures();
+  }
+  if (frameData.keys.space) {
+    rayinfo.resetAccumulationImage = true;
+    animationTime += frameData.dt;
   }
   if (frameData.mouse.left) {
     rayinfo.resetAccumulationImage = true;
@@ -119,13 +101,19 @@ void updateScene(const mg::FrameData &frameData) {
 
 void renderScene(const mg::FrameData &frameData) {
   mg::Texts texts = {};
-  char fps[50];
-  snprintf(fps, sizeof(fps), "Fps: %u", uint32_t(frameData.fps));
+  // primary rays, the bounces are not counted
+  const float megaRays =
+      float(frameData.fps) * mg::vkContext.screen.width * mg::vkContext.screen.height * nrOfSamplesPerFrame / 1e6f;
+  char fps[100];
+  snprintf(fps, sizeof(fps), "Fps: %u, %.0f Mrays/s, %u blas", uint32_t(frameData.fps), megaRays,
+           rayinfo.accelerationStructureStats.nrOfBottomLevels);
   mg::Text text = {fps};
 
   mg::pushText(&texts, text);
 
   mg::beginRendering();
+  if (frameData.keys.space)
+    refitTopLevelAccelerationStructure(world, animationTime, &rayinfo);
   mg::RenderContext renderContext = {};
 
   renderContext.projection = glm::perspective(
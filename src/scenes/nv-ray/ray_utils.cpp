@@ -1,6 +1,8 @@
 #include "ray_utils.h"
+#include "mg/logger.h"
 #include "mg/meshUtils.h"
 #include "vulkan/vkContext.h"
+#include <chrono>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <mg/mgSystem.h>
@@ -54,7 +56,7 @@ static void destroyStorageImges(RayInfo *rayInfo) {
   mg::mgSystem.storageContainer.removeStorage(rayInfo->storageAccumulationImageID);
 }
 
-static void createAndBindASDeviceMemory(AccelerationStructure *levelAS) {
+static VkDeviceSize createAndBindASDeviceMemory(AccelerationStructure *levelAS) {
 
   VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo = {};
   memoryRequirementsInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV;
@@ -81,41 +83,46 @@ static void createAndBindASDeviceMemory(AccelerationStructure *levelAS) {
 
   mg::checkResult(mg::nv::vkGetAccelerationStructureHandleNV(mg::vkContext.device, levelAS->accelerationStructure,
                                                              sizeof(uint64_t), &levelAS->handle));
+  return memoryRequirements2.memoryRequirements.size;
 }
 
-static void createBottomLevelAccelerationStructureAabb(const World &world, RayInfo *rayInfo) {
-  std::vector<glm::vec3> aabb;
-  aabb.reserve(world.positions.size() * 2);
+static constexpr VkBuildAccelerationStructureFlagsNV bottomLevelFlags =
+    VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_NV;
 
-  for (uint64_t i = 0; i < world.positions.size(); i++) {
-    aabb.push_back(glm::vec3{world.positions[i].x, world.positions[i].y, world.positions[i].z} - world.positions[i].w);
-    aabb.push_back(glm::vec3{world.positions[i].x, world.positions[i].y, world.positions[i].z} + world.positions[i].w);
-  }
+static void createBottomLevelAccelerationStructureAabb(RayInfo *rayInfo) {
+  const auto &layout = rayInfo->sphereLayout;
+  auto aabb = layout.aabbs;
   rayInfo->storageSpheresId =
       mg::mgSystem.storageContainer.createStorage(aabb.data(), mg::sizeofContainerInBytes(aabb));
   auto storage = mg::mgSystem.storageContainer.getStorage(rayInfo->storageSpheresId);
 
   mg::waitForDeviceIdle();
 
-  rayInfo->bottomLevelASs.reserve(world.positions.size());
-  for (uint64_t i = 0; i < world.positions.size(); i++) {
-    VkGeometryNV geometry = {};
-    geometry.sType = VK_STRUCTURE_TYPE_GEOMETRY_NV;
-    geometry.geometryType = VK_GEOMETRY_TYPE_AABBS_NV;
-    geometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_GEOMETRY_TRIANGLES_NV;
-
-    geometry.geometry.aabbs.sType = VK_STRUCTURE_TYPE_GEOMETRY_AABB_NV;
-    geometry.geometry.aabbs.aabbData = storage.buffer;
-    geometry.geometry.aabbs.offset = i * sizeof(glm::vec3) * 2;
-    geometry.geometry.aabbs.numAABBs = 1;
-    geometry.geometry.aabbs.stride = sizeof(glm::vec3) * 2;
-    geometry.flags = VK_GEOMETRY_OPAQUE_BIT_NV;
+  rayInfo->bottomLevelASs.reserve(layout.blases.size());
+  for (const auto &blas : layout.blases) {
+    std::vector<VkGeometryNV> geometries;
+    geometries.reserve(blas.geometries.size());
+    for (const auto &sphereGeometry : blas.geometries) {
+      VkGeometryNV geometry = {};
+      geometry.sType = VK_STRUCTURE_TYPE_GEOMETRY_NV;
+      geometry.geometryType = VK_GEOMETRY_TYPE_AABBS_NV;
+      geometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_GEOMETRY_TRIANGLES_NV;
+
+      geometry.geometry.aabbs.sType = VK_STRUCTURE_TYPE_GEOMETRY_AABB_NV;
+      geometry.geometry.aabbs.aabbData = storage.buffer;
+      geometry.geometry.aabbs.offset = sphereGeometry.firstAabb * sizeof(glm::vec3) * 2;
+      geometry.geometry.aabbs.numAABBs = sphereGeometry.count;
+      geometry.geometry.aabbs.stride = sizeof(glm::vec3) * 2;
+      geometry.flags = VK_GEOMETRY_OPAQUE_BIT_NV;
+      geometries.push_back(geometry);
+    }
 
     VkAccelerationStructureInfoNV accelerationStructureInfo = {};
     accelerationStructureInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
     accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
-    accelerationStructureInfo.geometryCount = 1;
-    accelerationStructureInfo.pGeometries = &geometry;
+    accelerationStructureInfo.flags = bottomLevelFlags;
+    accelerationStructureInfo.geometryCount = uint32_t(geometries.size());
+    accelerationStructureInfo.pGeometries = geometries.data();
 
     VkAccelerationStructureCreateInfoNV accelerationStructureCreateInfo = {};
     accelerationStructureCreateInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_NV;
@@ -124,16 +131,23 @@ static void createBottomLevelAccelerationStructureAabb(const World &world, RayIn
     mg::checkResult(mg::nv::vkCreateAccelerationStructureNV(mg::vkContext.device, &accelerationStructureCreateInfo,
                                                             nullptr, &vkAccelerationStructureNV));
 
-    rayInfo->bottomLevelASs.push_back({.accelerationStructure = vkAccelerationStructureNV, .vkGeometryNV = geometry});
-    createAndBindASDeviceMemory(&rayInfo->bottomLevelASs.back());
+    rayInfo->bottomLevelASs.push_back(
+        {.accelerationStructure = vkAccelerationStructureNV, .geometries = std::move(geometries)});
+    rayInfo->accelerationStructureStats.memory += createAndBindASDeviceMemory(&rayInfo->bottomLevelASs.back());
   }
 }
 
 static void createTopLevelAccelerationStructure(RayInfo *rayInfo) {
+  // only a top level with animated instances is refitted, the others are built once for the fastest trace
+  rayInfo->topLevelFlags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_NV;
+  if (!rayInfo->sphereLayout.animatedInstances.empty())
+    rayInfo->topLevelFlags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_NV;
+
   VkAccelerationStructureInfoNV accelerationStructureInfo = {};
   accelerationStructureInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
   accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_NV;
-  accelerationStructureInfo.instanceCount = uint32_t(rayInfo->bottomLevelASs.size());
+  accelerationStructureInfo.flags = rayInfo->topLevelFlags;
+  accelerationStructureInfo.instanceCount = uint32_t(rayInfo->sphereLayout.instances.size());
 
   VkAccelerationStructureCreateInfoNV accelerationStructureCreateInfo = {};
   accelerationStructureCreateInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_NV;
@@ -141,7 +155,7 @@ static void createTopLevelAccelerationStructure(RayInfo *rayInfo) {
   mg::checkResult(mg::nv::vkCreateAccelerationStructureNV(mg::vkContext.device, &accelerationStructureCreateInfo,
                                                           nullptr, &rayInfo->topLevelAS.accelerationStructure));
 
-  createAndBindASDeviceMemory(&rayInfo->topLevelAS);
+  rayInfo->accelerationStructureStats.memory += createAndBindASDeviceMemory(&rayInfo->topLevelAS);
 
   VkDescriptorSetAllocateInfo vkDescriptorSetAllocateInfo = {};
   vkDescriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -166,66 +180,61 @@ static void createTopLevelAccelerationStructure(RayInfo *rayInfo) {
   vkUpdateDescriptorSets(mg::vkContext.device, 1, &accelerationStructureWrite, 0, VK_NULL_HANDLE);
 }
 
-static Buffer createInstances(const World &world, const RayInfo &info) {
+static Buffer createInstances(const RayInfo &info) {
+  const auto &instances = info.sphereLayout.instances;
   Buffer instanceBuffer = {};
   VkGeometryInstance *instanceData = (VkGeometryInstance *)mg::mgSystem.linearHeapAllocator.allocateBuffer(
-      sizeof(VkGeometryInstance) * info.bottomLevelASs.size(), &instanceBuffer.buffer, &instanceBuffer.offset);
-
-  mgAssert(world.materials.size() == info.bottomLevelASs.size());
-  mgAssert(world.positions.size() == info.bottomLevelASs.size());
+      sizeof(VkGeometryInstance) * instances.size(), &instanceBuffer.buffer, &instanceBuffer.offset);
 
-  for (uint64_t i = 0; i < info.bottomLevelASs.size(); i++) {
+  for (uint64_t i = 0; i < instances.size(); i++) {
     VkGeometryInstance geometryInstance = {};
-    // clang-format off
-    glm::mat3x4 transform = {
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, 1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 1.0f, 0.0f,
-    };
-    // clang-format on
-    geometryInstance.transform = transform;
+    geometryInstance.transform = instances[i].transform;
     geometryInstance.instanceId = i;
     geometryInstance.mask = 0xff;
-    geometryInstance.instanceOffset = world.materials[i];
+    // hit group = instanceOffset + geometry index, so every geometry of the blas gets its own record
+    geometryInstance.instanceOffset = instances[i].firstRecord;
     geometryInstance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_CULL_DISABLE_BIT_NV;
-    geometryInstance.accelerationStructureHandle = info.bottomLevelASs[i].handle;
+    geometryInstance.accelerationStructureHandle = info.bottomLevelASs[instances[i].blas].handle;
 
     memcpy((char *)(instanceData) + i * sizeof(VkGeometryInstance), &geometryInstance, sizeof(VkGeometryInstance));
   }
   return instanceBuffer;
 }
 
+static VkDeviceSize getScratchSize(VkAccelerationStructureNV accelerationStructure,
+                                   VkAccelerationStructureMemoryRequirementsTypeNV type) {
+  VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo{};
+  memoryRequirementsInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV;
+  memoryRequirementsInfo.type = type;
+  memoryRequirementsInfo.accelerationStructure = accelerationStructure;
+
+  VkMemoryRequirements2 memoryRequirements = {};
+  memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  mg::nv::vkGetAccelerationStructureMemoryRequirementsNV(mg::vkContext.device, &memoryRequirementsInfo,
+                                                         &memoryRequirements);
+  return memoryRequirements.memoryRequirements.size;
+}
+
 static ScratchBuffer createScrathMemory(RayInfo *rayInfo) {
   ScratchBuffer scratchBuffer = {};
   scratchBuffer.offsets.reserve(rayInfo->bottomLevelASs.size());
 
   uint64_t scratchBufferBottomLevels = 0;
   for (uint64_t i = 0; i < rayInfo->bottomLevelASs.size(); i++) {
-    VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo{};
-    memoryRequirementsInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV;
-    memoryRequirementsInfo.type = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_NV;
-
-    VkMemoryRequirements2 memReqBottomLevelAS = {};
-    memReqBottomLevelAS.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-    memoryRequirementsInfo.accelerationStructure = rayInfo->bottomLevelASs[i].accelerationStructure;
-    mg::nv::vkGetAccelerationStructureMemoryRequirementsNV(mg::vkContext.device, &memoryRequirementsInfo,
-                                                           &memReqBottomLevelAS);
     scratchBuffer.offsets.push_back(uint32_t(scratchBufferBottomLevels));
-    scratchBufferBottomLevels += memReqBottomLevelAS.memoryRequirements.size;
+    scratchBufferBottomLevels += getScratchSize(rayInfo->bottomLevelASs[i].accelerationStructure,
+                                                VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_NV);
   }
-  VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo{};
-  memoryRequirementsInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV;
-  memoryRequirementsInfo.type = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_NV;
-
-  VkMemoryRequirements2 memReqTopLevelAS = {};
-  memReqTopLevelAS.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-  memoryRequirementsInfo.accelerationStructure = rayInfo->topLevelAS.accelerationStructure;
-  mg::nv::vkGetAccelerationStructureMemoryRequirementsNV(mg::vkContext.device, &memoryRequirementsInfo,
-                                                         &memReqTopLevelAS);
+  const auto scratchBufferTopLevel = getScratchSize(rayInfo->topLevelAS.accelerationStructure,
+                                                    VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_NV);
+  if (rayInfo->topLevelFlags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_NV)
+    rayInfo->topLevelUpdateScratchSize = getScratchSize(
+        rayInfo->topLevelAS.accelerationStructure, VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_UPDATE_SCRATCH_NV);
 
-  const auto scratchBufferSize = std::max(scratchBufferBottomLevels, memReqTopLevelAS.memoryRequirements.size);
+  const auto scratchBufferSize = std::max(scratchBufferBottomLevels, scratchBufferTopLevel);
   mg::mgSystem.linearHeapAllocator.allocateBuffer(scratchBufferSize, &scratchBuffer.buffer.buffer,
                                                   &scratchBuffer.buffer.offset);
+  rayInfo->accelerationStructureStats.scratchMemory = scratchBufferSize;
 
   return scratchBuffer;
 }
@@ -260,8 +269,9 @@ static void buildAccelerationStructures(const RayInfo &rayInfo, const Buffer &in
     VkAccelerationStructureInfoNV accelerationStructureInfo = {};
     accelerationStructureInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
     accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
-    accelerationStructureInfo.geometryCount = 1;
-    accelerationStructureInfo.pGeometries = &rayInfo.bottomLevelASs[i].vkGeometryNV;
+    accelerationStructureInfo.flags = bottomLevelFlags;
+    accelerationStructureInfo.geometryCount = uint32_t(rayInfo.bottomLevelASs[i].geometries.size());
+    accelerationStructureInfo.pGeometries = rayInfo.bottomLevelASs[i].geometries.data();
 
     mg::nv::vkCmdBuildAccelerationStructureNV(commandBuffer, &accelerationStructureInfo, VK_NULL_HANDLE, 0, VK_FALSE,
                                               rayInfo.bottomLevelASs[i].accelerationStructure, VK_NULL_HANDLE,
@@ -281,7 +291,8 @@ static void buildAccelerationStructures(const RayInfo &rayInfo, const Buffer &in
   VkAccelerationStructureInfoNV accelerationStructureInfo = {};
   accelerationStructureInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
   accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_NV;
-  accelerationStructureInfo.instanceCount = uint32_t(rayInfo.bottomLevelASs.size());
+  accelerationStructureInfo.flags = rayInfo.topLevelFlags;
+  accelerationStructureInfo.instanceCount = uint32_t(rayInfo.sphereLayout.instances.size());
 
   mg::nv::vkCmdBuildAccelerationStructureNV(commandBuffer, &accelerationStructureInfo, instanceBuffer.buffer,
                                             instanceBuffer.offset, VK_FALSE, rayInfo.topLevelAS.accelerationStructure,
@@ -319,26 +330,35 @@ static VkPhysicalDeviceRayTracingPropertiesNV getRayTracingProperties(RayInfo *r
   return physicalDeviceRayTracingPropertiesNV;
 }
 
-void createRayInfo(const World &world, RayInfo *rayInfo) {
-  createStorageImages(rayInfo);
-  rayInfo->rayTracingProperties = getRayTracingProperties(rayInfo);
-  createBottomLevelAccelerationStructureAabb(world, rayInfo);
+void createAccelerationStructures(const World &world, RayInfo *rayInfo) {
+  rayInfo->accelerationStructureStats = {};
+  auto &stats = rayInfo->accelerationStructureStats;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  rayInfo->sphereLayout = createSphereLayout(world, rayInfo->clusterSettings);
+  stats.clusterMs =
+      std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+  start = std::chrono::high_resolution_clock::now();
+  createBottomLevelAccelerationStructureAabb(rayInfo);
   createTopLevelAccelerationStructure(rayInfo);
 
-  auto instanceBuffer = createInstances(world, *rayInfo);
+  auto instanceBuffer = createInstances(*rayInfo);
   auto scratchBuffer = createScrathMemory(rayInfo);
 
   buildAccelerationStructures(*rayInfo, instanceBuffer, scratchBuffer);
+  stats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  stats.nrOfBottomLevels = uint32_t(rayInfo->bottomLevelASs.size());
+  stats.nrOfInstances = uint32_t(rayInfo->sphereLayout.instances.size());
+
+  LOG("acceleration structures: " << stats.nrOfBottomLevels << " bottom levels, " << stats.nrOfInstances
+                                  << " instances, cluster " << stats.clusterMs << " ms, build " << stats.buildMs
+                                  << " ms, memory " << stats.memory / 1024 << " kB, scratch "
+                                  << stats.scratchMemory / 1024 << " kB");
 }
 
-void resetSizeStorageImages(RayInfo *rayInfo) {
-  destroyStorageImges(rayInfo);
-  createStorageImages(rayInfo);
-}
-
-void destroyRayInfo(RayInfo *rayInfo) {
+void destroyAccelerationStructures(RayInfo *rayInfo) {
   mg::waitForDeviceIdle();
-  destroyStorageImges(rayInfo);
   mg::mgSystem.storageContainer.removeStorage(rayInfo->storageSpheresId);
 
   for (uint64_t i = 0; i < rayInfo->bottomLevelASs.size(); i++) {
@@ -350,5 +370,65 @@ void destroyRayInfo(RayInfo *rayInfo) {
   mg::nv::vkDestroyAccelerationStructureNV(mg::vkContext.device, rayInfo->topLevelAS.accelerationStructure, nullptr);
   vkFreeDescriptorSets(mg::vkContext.device, mg::vkContext.descriptorPool, 1, &rayInfo->topLevelASDescriptorSet);
 
+  rayInfo->bottomLevelASs.clear();
+  rayInfo->topLevelAS = {};
+  rayInfo->topLevelASDescriptorSet = VK_NULL_HANDLE;
+  rayInfo->sphereLayout = {};
+  rayInfo->topLevelFlags = 0;
+  rayInfo->topLevelUpdateScratchSize = 0;
+}
+
+void refitTopLevelAccelerationStructure(const World &world, float time, RayInfo *rayInfo) {
+  if (rayInfo->sphereLayout.animatedInstances.empty())
+    return;
+  animateSphereLayout(world, time, &rayInfo->sphereLayout);
+  auto instanceBuffer = createInstances(*rayInfo);
+
+  Buffer scratchBuffer = {};
+  mg::mgSystem.linearHeapAllocator.allocateBuffer(rayInfo->topLevelUpdateScratchSize, &scratchBuffer.buffer,
+                                                  &scratchBuffer.offset);
+
+  // the previous frame may still trace against the top level
+  VkMemoryBarrier memoryBarrier = {};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV;
+  memoryBarrier.dstAccessMask =
+      VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV;
+  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV,
+                       VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV, 0, 1, &memoryBarrier, 0, 0, 0, 0);
+
+  VkAccelerationStructureInfoNV accelerationStructureInfo = {};
+  accelerationStructureInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
+  accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_NV;
+  accelerationStructureInfo.flags = rayInfo->topLevelFlags;
+  accelerationStructureInfo.instanceCount = uint32_t(rayInfo->sphereLayout.instances.size());
+
+  mg::nv::vkCmdBuildAccelerationStructureNV(
+      mg::vkContext.commandBuffer, &accelerationStructureInfo, instanceBuffer.buffer, instanceBuffer.offset, VK_TRUE,
+      rayInfo->topLevelAS.accelerationStructure, rayInfo->topLevelAS.accelerationStructure, scratchBuffer.buffer,
+      scratchBuffer.offset);
+
+  memoryBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV;
+  memoryBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV;
+  vkCmdPipelineBarrier(mg::vkContext.commandBuffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
+                       VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, 0, 1, &memoryBarrier, 0, 0, 0, 0);
+}
+
+void createRayInfo(const World &world, RayInfo *rayInfo) {
+  createStorageImages(rayInfo);
+  rayInfo->rayTracingProperties = getRayTracingProperties(rayInfo);
+  createAccelerationStructures(world, rayInfo);
+}
+
+void resetSizeStorageImages(RayInfo *rayInfo) {
+  destroyStorageImges(rayInfo);
+  createStorageImages(rayInfo);
+}
+
+void destroyRayInfo(RayInfo *rayInfo) {
+  mg::waitForDeviceIdle();
+  destroyStorageImges(rayInfo);
+  destroyAccelerationStructures(rayInfo);
+
   *rayInfo = {};
 }
@@ -1,49 +1,49 @@
 #pragma once
 #include "vulkan/vkContext.h"
 #include "mg/mgSystem.h"
+#include "ray_binding_table.h"
+#include "ray_clusters.h"
+#include "ray_world.h"
 
 struct AccelerationStructure {
   mg::DeviceHeapAllocation deviceHeapAllocation;
   VkAccelerationStructureNV accelerationStructure;
-  VkGeometryNV vkGeometryNV;
+  std::vector<VkGeometryNV> geometries;
   uint64_t handle;
 };
 
+struct AccelerationStructureStats {
+  double clusterMs, buildMs; // build includes waiting for the gpu
+  VkDeviceSize memory, scratchMemory;
+  uint32_t nrOfBottomLevels, nrOfInstances;
+};
+
 struct RayInfo {
+  SphereClusterSettings clusterSettings;
+  SphereLayout sphereLayout;
+  AccelerationStructureStats accelerationStructureStats;
   std::vector<AccelerationStructure> bottomLevelASs;
   AccelerationStructure topLevelAS;
+  VkBuildAccelerationStructureFlagsNV topLevelFlags;
+  VkDeviceSize topLevelUpdateScratchSize;
   VkPhysicalDeviceRayTracingPropertiesNV rayTracingProperties;
+  mg::Pipeline rayTracingPipeline;
+  ShaderBindingTable shaderBindingTable;
   mg::StorageId storageImageId;
   mg::StorageId storageAccumulationImageID;
   mg::StorageId storageSpheresId;
   mg::TextureId sobolId;
+  mg::TextureId blueNoiseId;
   VkDescriptorSet topLevelASDescriptorSet;
   mg::MeshId triangleId;
   bool resetAccumulationImage;
 };
 
-struct World {
-  enum MATERIAL { LAMBERTH, METAL, DIELECTRIC };
-  std::vector<glm::vec4> positions;
-  std::vector<glm::vec4> albedos;
-  std::vector<MATERIAL> materials;
-  mg::TextureId blueNoise;
-};
-
-struct Sphere {
-  World *world;
-  const glm::vec4 &position;
-  const glm::vec4 &albedo;
-  World::MATERIAL material;
-
-};
-
-inline void addSphere(const Sphere &sphere) {
-  sphere.world->positions.emplace_back(sphere.position);
-  sphere.world->albedos.emplace_back(sphere.albedo);
-  sphere.world->materials.emplace_back(sphere.material);
-}
-
 void createRayInfo(const World &world, RayInfo *rayInfo);
 void destroyRayInfo(RayInfo *rayInfo);
+// rebuilds the bottom and top levels with rayInfo->clusterSettings, the pipeline must be recreated after
+void createAccelerationStructures(const World &world, RayInfo *rayInfo);
+void destroyAccelerationStructures(RayInfo *rayInfo);
+// moves the animated spheres and refits the top level in the frame command buffer, outside of a render pass
+void refitTopLevelAccelerationStructure(const World &world, float time, RayInfo *rayInfo);
 void resetSizeStorageImages(RayInfo *rayInfo);
@@ -0,0 +1,72 @@
+#include "ray_world.h"
+#include "mg/mgUtils.h"
+#include "ray_sampler.h"
+#include <cstring>
+#include <random>
+
+static std::default_random_engine generator;
+
+static float rng() { return std::generate_canonical<float, std::numeric_limits<double>::digits>(generator); }
+
+static glm::vec4 toVec4(const glm::vec3 &v, float s) { return glm::vec4{v.x, v.y, v.z, s}; }
+
+void createRandomSpheres(World *world) {
+  generator.seed(2);
+
+  addSphere({.world = world,
+             .position = {0, -1000.0f, 0, 1000.0f},
+             .albedo = {0.5f, 0.5f, 0.5f, 1},
+             .material = World::LAMBERTH});
+
+  for (int32_t a = -11; a < 11; a++) {
+    for (int32_t b = -11; b < 11; b++) {
+      float chooseMat = rng();
+      glm::vec3 center = {a + 0.9 * rng(), 0.2, (b + 0.9 * rng()) * -1.0f};
+
+      if (glm::distance(center, {4, 0.2, 0}) > 0.9f) {
+        if (chooseMat < 0.8) { // diffuse
+          addSphere({.world = world,
+                     .position = toVec4(center, 0.2f),
+                     .albedo = {rng() * rng(), rng() * rng(), rng() * rng(), 1},
+                     .material = World::LAMBERTH});
+        } else if (chooseMat < 0.95f) { // metal
+          addSphere({.world = world,
+                     .position = toVec4(center, 0.2f),
+                     .albedo = {0.5f * (1 + rng()), 0.5f * (1 + rng()), 0.5f * (1 + rng()), 0.5f * rng()},
+                     .material = World::METAL});
+        } else { // glass
+          addSphere({.world = world,
+                     .position = toVec4(center, 0.2f),
+                     .albedo = {1, 1, 1, 1.5f},
+                     .material = World::DIELECTRIC});
+        }
+      }
+    }
+  }
+  addSphere({.world = world,
+             .position = {0, 1, 0, 1},
+             .albedo = {0.8, 0.8, 0.8, 1.5},
+             .material = World::DIELECTRIC,
+             .animated = true});
+  addSphere({.world = world,
+             .position = {-4, 1, 0, 1},
+             .albedo = {0.4, 0.2, 0.1, 1},
+             .material = World::LAMBERTH,
+             .animated = true});
+  addSphere({.world = world,
+             .position = {4, 1, 0, 1},
+             .albedo = {0.7, 0.6, 0.5, 0.0},
+             .material = World::METAL,
+             .animated = true});
+}
+
+// http://gruenschloss.org/
+std::vector<glm::vec4> createSobolSequence(uint32_t count, uint32_t nrOfTables) {
+  SobolTableInfo info = {};
+  info.count = count;
+  info.nrOfTables = nrOfTables;
+  const auto table = loadSobolTable(info, mg::getDataPath());
+  std::vector<glm::vec4> sequence(table.size() / 4);
+  memcpy(sequence.data(), table.data(), mg::sizeofContainerInBytes(table));
+  return sequence;
+}
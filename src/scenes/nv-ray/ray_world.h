@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct World {
+  enum MATERIAL { LAMBERTH, METAL, DIELECTRIC };
+  std::vector<glm::vec4> positions;
+  std::vector<glm::vec4> albedos;
+  std::vector<MATERIAL> materials;
+  std::vector<bool> animated;
+};
+
+struct Sphere {
+  World *world;
+  const glm::vec4 &position;
+  const glm::vec4 &albedo;
+  World::MATERIAL material;
+  bool animated;
+};
+
+inline void addSphere(const Sphere &sphere) {
+  sphere.world->positions.emplace_back(sphere.position);
+  sphere.world->albedos.emplace_back(sphere.albedo);
+  sphere.world->materials.emplace_back(sphere.material);
+  sphere.world->animated.push_back(sphere.animated);
+}
+
+// the random sphere scene from Ray Tracing in One Weekend, Peter Shirley
+void createRandomSpheres(World *world);
+// the sobol texture has one differently scrambled table of four dimensional points per row, a pixel reads row
+// seed % nrOfSobolTables so neighbouring pixels and frames get decorrelated samples
+inline constexpr uint32_t sobolCount = 2048;
+inline constexpr uint32_t nrOfSobolTables = 64;
+
+// read by nextSobol in rayUtils.hglsl, cached in the data folder
+std::vector<glm::vec4> createSobolSequence(uint32_t count, uint32_t nrOfTables);
@@ -1,32 +1,19 @@
 #include "allocator.h"
-#include "invaders_utils.h"
 #include <cassert>
-#include <cstdlib>
 
 void LinearAllocator::init(uint32_t size) {
   assert(size > 0);
-  _data = (uint8_t *)aligned_malloc(size, SIMD_ALIGNMENT);
-  _totalSize = size;
+  _arena.create(size);
 }
 void LinearAllocator::destroy() {
   assert(_count == 0);
-  aligned_free(_data);
-  _data = nullptr;
-  _totalSize = 0;
+  _arena.destroy();
 }
 
 void *LinearAllocator::allocate(uint32_t size, uint32_t alignment) {
-  assert(_data != nullptr);
-  assert(_totalSize > 0);
+  assert(_arena.capacity() > 0);
   _count++;
-
-  _currentOffset = alignUpPowerOfTwo(_currentOffset, alignment);
-  const auto realSize = size + alignment;
-  assert((_currentOffset + realSize) <= _totalSize && "allocate more memory for linear allocator");
-
-  const auto oldOffset = _currentOffset;
-  _currentOffset += realSize;
-  return &_data[oldOffset];
+  return _arena.allocate(size, alignment);
 }
 
 void LinearAllocator::deallocate(void *data) {
@@ -35,13 +22,19 @@ void LinearAllocator::deallocate(void *data) {
   assert(_count > 0);
   _count--;
 }
+
+void *LinearAllocator::reallocate(void *data, uint32_t oldSize, uint32_t newSize, uint32_t alignment) {
+  if (data == nullptr)
+    return allocate(newSize, alignment);
+  return _arena.reallocate(data, oldSize, newSize, alignment);
+}
+
 void LinearAllocator::clear() {
   assert(_count == 0);
-  _currentOffset = 0;
+  _arena.reset();
 }
 
 LinearAllocator::~LinearAllocator() {
-  assert(_data == nullptr);
-  assert(_totalSize == 0);
-  assert(_currentOffset == 0);
-}
\ No newline at end of file
+  assert(_arena.capacity() == 0);
+  assert(_count == 0);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "mg/memory.h"
 #include <cinttypes>
 
 struct Allocator {
@@ -7,24 +8,27 @@ struct Allocator {
 
   virtual void *allocate(uint32_t size, uint32_t alignment) = 0;
   virtual void deallocate(void *data) = 0;
+  // grows data in place when the allocator can, otherwise allocates, copies oldSize bytes and deallocates data
+  virtual void *reallocate(void *data, uint32_t oldSize, uint32_t newSize, uint32_t alignment) = 0;
   virtual void clear() = 0;
 
   virtual ~Allocator(){};
 };
 
+// Frees everything at once on clear, a thin layer over mg::Arena. Running out of memory falls back to the heap and the
+// next clear grows the arena instead of failing.
 struct LinearAllocator final : public Allocator {
   virtual void init(uint32_t size) override;
   virtual void destroy() override;
 
   virtual void *allocate(uint32_t size, uint32_t alignment) override;
   virtual void deallocate(void *data) override;
+  virtual void *reallocate(void *data, uint32_t oldSize, uint32_t newSize, uint32_t alignment) override;
   virtual void clear() override;
 
   virtual ~LinearAllocator() override;
 
 private:
-  uint8_t *_data = nullptr;
-  uint32_t _totalSize = 0;
+  mg::Arena _arena;
   uint32_t _count = 0;
-  uint32_t _currentOffset = 0;
 };
@@ -20,6 +20,7 @@ template <typename T> struct Array {
   void pushBack(T t);
 
   T *data();
+  const T *data() const;
   void clear();
   uint32_t size() const;
   T front() const;
@@ -46,7 +47,7 @@ template <typename T> Array<T>::Array(const Array<T> &other) {
   _allocator = other._allocator;
   _capacity = other._capacity;
   _size = other._size;
-  _data = _allocator->allocate(other._size * sizeof(T), SIMD_ALIGNMENT);
+  _data = (T *)_allocator->allocate(other._capacity * sizeof(T), SIMD_ALIGNMENT);
   std::memcpy(_data, other._data, sizeof(T) * other._size);
 }
 
@@ -70,11 +71,8 @@ template <typename T> void Array<T>::reserve(uint32_t capacity) {
   assert(_allocator);
   if (capacity <= _capacity)
     return;
+  _data = (T *)_allocator->reallocate(_data, _capacity * sizeof(T), capacity * sizeof(T), SIMD_ALIGNMENT);
   _capacity = capacity;
-  T *temp = (T *)_allocator->allocate(_capacity * sizeof(T), SIMD_ALIGNMENT);
-  memcpy(temp, _data, sizeof(T) * _size);
-  _allocator->deallocate(_data);
-  _data = temp;
 }
 
 template <typename T> void Array<T>::resize(uint32_t size) {
@@ -99,6 +97,7 @@ template <typename T> void Array<T>::pushBack(T t) {
 template <typename T> void Array<T>::clear() { _size = 0; }
 template <typename T> uint32_t Array<T>::size() const { return _size; }
 template <typename T> T *Array<T>::data() { return _data; }
+template <typename T> const T *Array<T>::data() const { return _data; }
 
 template <typename T> T Array<T>::front() const {
   assert(_size > 0);
@@ -3,20 +3,28 @@
 #include "array.h"
 
 struct Hashmap;
+namespace mg {
+class WorkerPool;
+}
 
 struct CheckCollisionInfo {
+  struct {
+    float radius;
+  } gridObjects;
   struct {
     const float *x;
     const float *y;
     float radius;
     uint32_t size;
-  } gridObjects, collisionObjects;
-  float cellSize;
+  } collisionObjects;
 };
 
 struct CollisionIds {
   Array<uint32_t> gridObjects;
-  Array<uint32_t> collisionObjects;
+  Array<uint32_t> collisionObjects; // in increasing order
 };
 
-void getCollisionIds(const Hashmap &hashmap, const CheckCollisionInfo &checkCollisionInfo, CollisionIds *ids);
+// Every collision object hits at most the first grid object it overlaps and every grid object is hit at most once,
+// by the collision object with the lowest index, the same result for any number of threads.
+void getCollisionIds(mg::WorkerPool *workers, const Hashmap &hashmap, const CheckCollisionInfo &checkCollisionInfo,
+                     CollisionIds *ids);
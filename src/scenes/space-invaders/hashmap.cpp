@@ -1,61 +1,67 @@
 #include "hashmap.h"
+#include "mg/workerPool.h"
 
-void Hashmap::init(Allocator *allocator, uint32_t initialSize) {
-  assert(allocator);
+static constexpr uint32_t HASH_BLOCK_SIZE = 4096;
 
-  _buckets.init(allocator, 0);
-  _entries.init(allocator, 0, 32);
+void Hashmap::init(Allocator *allocator, uint32_t capacity) {
+  assert(allocator);
 
   uint32_t size = HASHMAP_INITAL_SIZE;
-  while (size < initialSize)
+  while (size < 2 * capacity)
     size <<= 1;
-  _buckets.resize(size);
-  _size = 0;
-  memset(_buckets.data(), EMPTY, sizeof(uint32_t) * _buckets.size());
+  _nrOfBuckets = size;
+  _bucketStarts.init(allocator, _nrOfBuckets + 1);
+  _objectBuckets.init(allocator, 0, capacity);
+  _ids.init(allocator, 0, capacity);
+  _x.init(allocator, 0, capacity);
+  _y.init(allocator, 0, capacity);
 }
 
-void Hashmap::getEntries(uint64_t hash, Array<uint32_t> *ids) const {
-  const auto bucket = getBucket(hash);
-  auto entryId = _buckets[bucket];
-  if (entryId == EMPTY)
-    return;
-  auto currentEntry = _entries[entryId];
-  ids->pushBack(currentEntry.id);
-  while (currentEntry.next != EMPTY) {
-    currentEntry = _entries[currentEntry.next];
-    ids->pushBack(currentEntry.id);
-  }
-}
+void Hashmap::build(mg::WorkerPool *workers, const float *x, const float *y, uint32_t size, float cellSize) {
+  assert(workers);
+  assert(x);
+  assert(y);
+  assert(cellSize > 0);
+  _cellSize = cellSize;
+  _objectBuckets.resize(size);
+  _ids.resize(size);
+  _x.resize(size);
+  _y.resize(size);
+
+  uint32_t *objectBuckets = _objectBuckets.data();
+  workers->parallelFor(size, HASH_BLOCK_SIZE, [&](uint32_t begin, uint32_t end, uint32_t) {
+    for (uint32_t i = begin; i < end; i++)
+      objectBuckets[i] = getBucket(gridPosition(x[i], y[i], cellSize));
+  });
+
+  // count, exclusive prefix sum, then scatter in input order so every bucket keeps the original order
+  uint32_t *starts = _bucketStarts.data();
+  memset(starts, 0, sizeof(uint32_t) * (_nrOfBuckets + 1));
+  for (uint32_t i = 0; i < size; i++)
+    starts[objectBuckets[i] + 1]++;
+  for (uint32_t i = 0; i < _nrOfBuckets; i++)
+    starts[i + 1] += starts[i];
 
-void Hashmap::add(uint64_t hash, uint32_t id) {
-  const auto bucket = getBucket(hash);
-  HashmapEntry entry = {};
-  entry.next = EMPTY;
-  entry.id = id;
-  _entries.pushBack(entry);
-
-  if (_buckets[bucket] == EMPTY) {
-    _size++;
-    _buckets[bucket] = _entries.size() - 1;
-  } else {
-    auto entryId = _buckets[bucket];
-    auto *currentEntry = &_entries[entryId];
-    assert(currentEntry->id != id);
-    while (currentEntry->next != EMPTY) {
-      currentEntry = &_entries[currentEntry->next];
-      assert(currentEntry->id != id);
-    }
-    currentEntry->next = _entries.size() - 1;
+  uint32_t *ids = _ids.data();
+  float *sortedX = _x.data();
+  float *sortedY = _y.data();
+  for (uint32_t i = 0; i < size; i++) {
+    const uint32_t index = starts[objectBuckets[i]]++;
+    ids[index] = i;
+    sortedX[index] = x[i];
+    sortedY[index] = y[i];
   }
+  // the scatter moved every start to the end of its bucket, shift them back
+  memmove(starts + 1, starts, sizeof(uint32_t) * _nrOfBuckets);
+  starts[0] = 0;
 }
 
-void Hashmap::clear() {
-  memset(_buckets.data(), EMPTY, sizeof(_buckets.front()) * _buckets.size());
-  _entries.clear();
-  _size = 0;
+HashmapRange Hashmap::getEntries(ivec2 gridCoordinates) const {
+  const auto bucket = getBucket(gridCoordinates);
+  return {_bucketStarts[bucket], _bucketStarts[bucket + 1]};
 }
 
-uint32_t Hashmap::getBucket(uint64_t hash) const {
-  assert(_buckets.size());
-  return uint32_t(hash & (_buckets.size() - 1));
+uint32_t Hashmap::getBucket(ivec2 gridCoordinates) const {
+  assert(_nrOfBuckets);
+  return hashGridPosition(gridCoordinates) & (_nrOfBuckets - 1);
 }
@@ -2,24 +2,37 @@
 #include "array.h"
 #include <cassert>
 
+namespace mg {
+class WorkerPool;
+}
+
 constexpr uint32_t HASHMAP_INITAL_SIZE = 64;
 constexpr uint32_t EMPTY = 0xFFFFFFFFu;
 
-struct HashmapEntry {
-  uint32_t id;
-  uint32_t next;
+struct HashmapRange {
+  uint32_t begin, end;
 };
 
+// Uniform grid spatial hash, rebuilt every frame with a stable counting sort so the objects of a bucket lie next to
+// each other in ids, x and y. Cells are mapped to a power of two number of buckets with hashGridPosition, cells that
+// share a bucket only add candidates that the distance test rejects.
 struct Hashmap {
-  void init(Allocator *allocator, uint32_t initialSize);
+  void init(Allocator *allocator, uint32_t capacity);
+
+  void build(mg::WorkerPool *workers, const float *x, const float *y, uint32_t size, float cellSize);
+  HashmapRange getEntries(ivec2 gridCoordinates) const;
+  uint32_t getBucket(ivec2 gridCoordinates) const;
 
-  void add(uint64_t hash, uint32_t id);
-  void getEntries(uint64_t hash, Array<uint32_t> *ids) const;
-  void clear();
-  uint32_t getBucket(uint64_t hash) const;
+  const uint32_t *ids() const { return _ids.data(); }
+  const float *x() const { return _x.data(); }
+  const float *y() const { return _y.data(); }
+  float cellSize() const { return _cellSize; }
 
 private:
-  Array<uint32_t> _buckets;
-  Array<HashmapEntry> _entries;
-  uint32_t _size = 0;
+  Array<uint32_t> _bucketStarts; // nrOfBuckets + 1 offsets into the sorted arrays
+  Array<uint32_t> _objectBuckets;
+  Array<uint32_t> _ids;
+  Array<float> _x, _y;
+  uint32_t _nrOfBuckets = 0;
+  float _cellSize = 0;
 };
@@ -7,7 +7,8 @@
 #include "rendering/rendering.h"
 #include "transforms.h"
 #include "types.h"
-#include <cstdlib>
+#include <algorithm>
+#include <functional>
 
 void drawSprites(const mg::RenderContext &renderContext, const float *xPositions, const float *yPositions,
                  const glm::vec4 *colors, float size, uint32_t count) {
@@ -23,18 +24,69 @@ void drawSprites(const mg::RenderContext &renderContext, const float *xPositions
   mg::renderSolidBoxes(renderContext, xPositions, yPositions, &color, {size, size}, count, true);
 }
 
+static uint32_t floatsSize(uint32_t count) { return alignUpPowerOfTwo(count * uint32_t(sizeof(float)), SIMD_ALIGNMENT); }
+
+static float *allocateFloats(uint32_t count) {
+  return (float *)device.entityAllocator.allocate(floatsSize(count), SIMD_ALIGNMENT);
+}
+
+static void allocateBullets(Bullets *bullets, uint32_t maxBullets) {
+  bullets->maxBullets = maxBullets;
+  bullets->x = allocateFloats(maxBullets);
+  bullets->y = allocateFloats(maxBullets);
+}
+
+static void freeBullets(Bullets *bullets) {
+  device.entityAllocator.deallocate(bullets->x);
+  device.entityAllocator.deallocate(bullets->y);
+}
+
+uint32_t entityMemorySize(const Settings &settings) {
+  const uint32_t maxAliens = settings.aliensRows * settings.aliensCols;
+  constexpr uint32_t nrOfArrays = 7;
+  return floatsSize(maxAliens) * 2 + maxAliens * uint32_t(sizeof(glm::vec4)) +
+         floatsSize(settings.maxPlayerBullets) * 2 + floatsSize(settings.maxAlienBullets) * 2 +
+         nrOfArrays * (floatsSize(1) + 2 * SIMD_ALIGNMENT);
+}
+
+uint32_t frameMemorySize(const Settings &settings) {
+  // the two hashmaps and the collision results, at most 64 bytes per entity
+  const uint32_t nrOfEntities =
+      settings.aliensRows * settings.aliensCols + settings.maxPlayerBullets + settings.maxAlienBullets;
+  return (1 << 20) + 64 * nrOfEntities;
+}
+
+void freeInvaders(Invaders *invaders) {
+  assert(invaders);
+  device.entityAllocator.deallocate(invaders->aliens.x);
+  device.entityAllocator.deallocate(invaders->aliens.y);
+  device.entityAllocator.deallocate(invaders->aliens.colors);
+  freeBullets(&invaders->playerBullets);
+  freeBullets(&invaders->alienBullets);
+  device.entityAllocator.clear();
+  *invaders = {};
+}
+
 void invadersReset(Invaders *invaders, const Settings &settings) {
   assert(invaders);
-  assert(settings.aliensRows * settings.aliensCols == MAX_ALIENS);
+  assert(settings.aliensRows * settings.aliensCols > 0);
 
-  *invaders = {};
+  freeInvaders(invaders);
   auto &player = invaders->player;
   auto &aliens = invaders->aliens;
   auto &playerBullets = invaders->playerBullets;
   auto &alienBullets = invaders->alienBullets;
 
+  allocateBullets(&playerBullets, settings.maxPlayerBullets);
+  allocateBullets(&alienBullets, settings.maxAlienBullets);
+  aliens.maxAliens = settings.aliensRows * settings.aliensCols;
+  aliens.x = allocateFloats(aliens.maxAliens);
+  aliens.y = allocateFloats(aliens.maxAliens);
+  aliens.colors = (glm::vec4 *)device.entityAllocator.allocate(aliens.maxAliens * sizeof(glm::vec4), SIMD_ALIGNMENT);
+
   // aliens
   aliens.speed = settings.alienSpeed;
+  aliens.randomState = 2463534242u;
   alienBullets.speed = settings.alienBulletSpeed;
   alienBullets.direction = {0, -1};
 
@@ -70,110 +122,107 @@ MinMax transformAliens(const Settings &settings, Aliens *aliens, float dt) {
   return minMax;
 }
 
-void fireAlienBullets(const Settings &settings, const Aliens &aliens, Bullets *bullets) {
+void fireAlienBullets(const Settings &settings, Aliens *aliens, Bullets *bullets) {
+  assert(aliens);
   assert(bullets);
-  const auto alienIndex = rand() % (aliens.nrAliens * 50000);
-  if (alienIndex >= aliens.nrAliens)
+  if (aliens->nrAliens == 0)
     return;
-  assert(bullets->nrBullets < MAX_BULLETS);
-  bullets->x[bullets->nrBullets] = aliens.x[alienIndex];
-  bullets->y[bullets->nrBullets++] = aliens.y[alienIndex] + settings.alienSize / 2.0f;
+  for (uint32_t i = 0; i < settings.alienFireTries && bullets->nrBullets < bullets->maxBullets; i++) {
+    const auto alienIndex = nextRandom(&aliens->randomState) % aliens->nrAliens;
+    if (nextRandom(&aliens->randomState) % settings.alienFireOdds)
+      continue;
+    bullets->x[bullets->nrBullets] = aliens->x[alienIndex];
+    bullets->y[bullets->nrBullets++] = aliens->y[alienIndex] + settings.alienSize / 2.0f;
+  }
+}
+
+// removes from the highest index down, so an entity swapped in from the end is never one that is still to be removed
+static void sortDescending(Array<uint32_t> *ids) {
+  std::sort(ids->data(), ids->data() + ids->size(), std::greater<uint32_t>());
+}
+
+static void removeBullets(Bullets *bullets, Array<uint32_t> *ids) {
+  sortDescending(ids);
+  for (uint32_t i = 0; i < ids->size(); i++) {
+    bullets->x[(*ids)[i]] = bullets->x[--bullets->nrBullets];
+    bullets->y[(*ids)[i]] = bullets->y[bullets->nrBullets];
+  }
+}
+
+static void removeAliens(Aliens *aliens, Array<uint32_t> *ids) {
+  sortDescending(ids);
+  for (uint32_t i = 0; i < ids->size(); i++) {
+    aliens->x[(*ids)[i]] = aliens->x[--aliens->nrAliens];
+    aliens->y[(*ids)[i]] = aliens->y[aliens->nrAliens];
+    aliens->colors[(*ids)[i]] = aliens->colors[aliens->nrAliens];
+  }
 }
 
-void playerBulletsOnAlienCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Bullets *bullets,
-                                   float cellSize) {
+static void initCollisionIds(CollisionIds *ids, uint32_t capacity) {
+  ids->collisionObjects.init(&device.linearAllocator, 0, capacity);
+  ids->gridObjects.init(&device.linearAllocator, 0, capacity);
+}
+
+void playerBulletsOnAlienCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Bullets *bullets) {
   assert(aliens);
   assert(bullets);
 
   CheckCollisionInfo checkCollisionInfo = {};
-  checkCollisionInfo.gridObjects.x = aliens->x;
-  checkCollisionInfo.gridObjects.y = aliens->y;
-  checkCollisionInfo.gridObjects.size = aliens->nrAliens;
   checkCollisionInfo.gridObjects.radius = settings.alienSize / 2.0f;
 
   checkCollisionInfo.collisionObjects.x = bullets->x;
   checkCollisionInfo.collisionObjects.y = bullets->y;
   checkCollisionInfo.collisionObjects.size = bullets->nrBullets;
   checkCollisionInfo.collisionObjects.radius = settings.playerBulletSize / 2.0f;
-  checkCollisionInfo.cellSize = cellSize;
 
   CollisionIds ids = {};
-  ids.collisionObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  ids.gridObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  getCollisionIds(hashmap, checkCollisionInfo, &ids);
+  initCollisionIds(&ids, bullets->nrBullets);
+  getCollisionIds(&device.workers, hashmap, checkCollisionInfo, &ids);
 
-  for (uint32_t i = 0; i < ids.collisionObjects.size(); i++) {
-    bullets->x[ids.collisionObjects[i]] = bullets->x[--bullets->nrBullets];
-    bullets->y[ids.collisionObjects[i]] = bullets->y[bullets->nrBullets];
-  }
-
-  for (uint32_t i = 0; i < ids.gridObjects.size(); i++) {
-    aliens->x[ids.gridObjects[i]] = aliens->x[--aliens->nrAliens];
-    aliens->y[ids.gridObjects[i]] = aliens->y[aliens->nrAliens];
-    aliens->colors[ids.gridObjects[i]] = aliens->colors[aliens->nrAliens];
-  }
+  removeBullets(bullets, &ids.collisionObjects);
+  removeAliens(aliens, &ids.gridObjects);
 }
 
-void alienBulletsOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Player *player, Bullets *bullets,
-                                   float cellSize) {
+void alienBulletsOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Player *player, Bullets *bullets) {
   assert(player);
   assert(bullets);
 
   CheckCollisionInfo checkCollisionInfo = {};
-  checkCollisionInfo.gridObjects.x = bullets->x;
-  checkCollisionInfo.gridObjects.y = bullets->y;
-  checkCollisionInfo.gridObjects.size = bullets->nrBullets;
   checkCollisionInfo.gridObjects.radius = settings.alienBulletSize / 2;
 
   checkCollisionInfo.collisionObjects.x = &player->position.x;
   checkCollisionInfo.collisionObjects.y = &player->position.y;
   checkCollisionInfo.collisionObjects.size = 1;
   checkCollisionInfo.collisionObjects.radius = settings.playerSize / 2.0f;
-  checkCollisionInfo.cellSize = cellSize;
 
   CollisionIds ids = {};
-  ids.collisionObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  ids.gridObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  getCollisionIds(hashmap, checkCollisionInfo, &ids);
+  initCollisionIds(&ids, 1);
+  getCollisionIds(&device.workers, hashmap, checkCollisionInfo, &ids);
 
-  for (uint32_t i = 0; i < ids.gridObjects.size(); i++) {
-    bullets->x[ids.gridObjects[i]] = bullets->x[--bullets->nrBullets];
-    bullets->y[ids.gridObjects[i]] = bullets->y[bullets->nrBullets];
-  }
+  removeBullets(bullets, &ids.gridObjects);
 
   if (ids.collisionObjects.size()) {
     player->health--;
   }
 }
 
-void alienOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Player *player,
-                            float cellSize) {
+void alienOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Player *player) {
   assert(aliens);
   assert(player);
 
   CheckCollisionInfo checkCollisionInfo = {};
-  checkCollisionInfo.gridObjects.x = aliens->x;
-  checkCollisionInfo.gridObjects.y = aliens->y;
-  checkCollisionInfo.gridObjects.size = aliens->nrAliens;
   checkCollisionInfo.gridObjects.radius = settings.alienSize / 2.0f;
-  ;
 
   checkCollisionInfo.collisionObjects.x = &player->position.x;
   checkCollisionInfo.collisionObjects.y = &player->position.y;
   checkCollisionInfo.collisionObjects.size = 1;
   checkCollisionInfo.collisionObjects.radius = settings.playerSize / 2.0f;
-  checkCollisionInfo.cellSize = cellSize;
 
   CollisionIds ids = {};
-  ids.collisionObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  ids.gridObjects.init(&device.linearAllocator, 0, SIMD_ALIGNMENT);
-  getCollisionIds(hashmap, checkCollisionInfo, &ids);
-
-  for (uint32_t i = 0; i < ids.gridObjects.size(); i++) {
-    aliens->x[ids.gridObjects[i]] = aliens->x[--aliens->nrAliens];
-    aliens->y[ids.gridObjects[i]] = aliens->y[aliens->nrAliens];
-    aliens->colors[ids.gridObjects[i]] = aliens->colors[aliens->nrAliens];
-  }
+  initCollisionIds(&ids, 1);
+  getCollisionIds(&device.workers, hashmap, checkCollisionInfo, &ids);
+
+  removeAliens(aliens, &ids.gridObjects);
   player->health -= ids.gridObjects.size();
 }
 
@@ -185,4 +234,4 @@ void removeBulletsOutsideBorders(Bullets *bullets) {
       bullets->y[i] = bullets->y[bullets->nrBullets];
     }
   }
-}
\ No newline at end of file
+}
@@ -20,12 +20,13 @@ void drawSprites(const mg::RenderContext &renderContext, const float *xPositions
 void drawSprites(const mg::RenderContext &renderContext, const float *xPositions, const float *yPositions, const glm::vec4 &color,
                  float size, uint32_t count);
 
+uint32_t entityMemorySize(const Settings &settings);
+uint32_t frameMemorySize(const Settings &settings);
 void invadersReset(Invaders *invaders, const Settings &settings);
+void freeInvaders(Invaders *invaders);
 MinMax transformAliens(const Settings &settings, Aliens *aliens, float dt);
-void fireAlienBullets(const Settings &settings, const Aliens &aliens, Bullets *bullets);
-void playerBulletsOnAlienCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Bullets *bullets,
-                                   float cellSize);
-void alienBulletsOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Player *player, Bullets *bullets,
-                                   float cellSize);
+void fireAlienBullets(const Settings &settings, Aliens *aliens, Bullets *bullets);
+void playerBulletsOnAlienCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Bullets *bullets);
+void alienBulletsOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Player *player, Bullets *bullets);
 void removeBulletsOutsideBorders(Bullets *bullets);
-void alienOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Player *player, float cellSize);
\ No newline at end of file
+void alienOnPlayerCollision(const Hashmap &hashmap, const Settings &settings, Aliens *aliens, Player *player);
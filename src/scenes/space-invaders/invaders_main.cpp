@@ -1,16 +1,73 @@
 #include "invaders_scene.h"
+#include "mg/logger.h"
 #include "mg/window.h"
-#include <chrono>
 #include <cmath>
-#include <thread>
+#include <cstring>
+#include <string>
 
-int main() {
-  mg::initWindow(800, 600); 
-  Invaders invaders = {}; 
-  invadersInit(&invaders);
+// space-invaders [--stress] [--aliens=COLSxROWS] [--bullets=N] [--threads=N] [--isa=scalar|sse4.2|avx2|avx512]
+//                [--frames-in-flight=N] [--swap-chain-images=N] [--present=fifo|mailbox|immediate] [--max-fps=N]
+//                [--wait-for-gpu]
+// --stress starts from createStressSettings, the other arguments override the budgets. --isa caps the instruction
+// set of the simd kernels, the default is the best one the cpu supports. The frame pacing arguments override
+// mg::FramePacingSettings, --max-fps=0 removes the 60 fps cap.
+static SIMD_ISA parseSimdIsa(const std::string &name) {
+  for (uint32_t i = 0; i < uint32_t(SIMD_ISA::SIZE); i++) {
+    if (name == simdIsaName(SIMD_ISA(i)))
+      return SIMD_ISA(i);
+  }
+  LOG("unknown instruction set " << name);
+  return SIMD_ISA::AVX512;
+}
+
+static mg::PRESENT_MODE parsePresentMode(const std::string &name) {
+  if (name == "fifo")
+    return mg::PRESENT_MODE::FIFO;
+  if (name == "immediate")
+    return mg::PRESENT_MODE::IMMEDIATE;
+  if (name != "mailbox")
+    LOG("unknown present mode " << name);
+  return mg::PRESENT_MODE::MAILBOX;
+}
+
+int main(int argc, char **argv) {
+  Settings settings = {};
+  mg::FramePacingSettings framePacingSettings = {};
+  framePacingSettings.maxFps = 60;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--stress")
+      settings = createStressSettings();
+  }
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--stress")
+      continue;
+    else if (arg.rfind("--aliens=", 0) == 0)
+      sscanf(arg.c_str(), "--aliens=%ux%u", &settings.aliensCols, &settings.aliensRows);
+    else if (arg.rfind("--bullets=", 0) == 0)
+      settings.maxPlayerBullets = settings.maxAlienBullets = uint32_t(std::stoul(arg.substr(strlen("--bullets="))));
+    else if (arg.rfind("--threads=", 0) == 0)
+      settings.nrOfThreads = uint32_t(std::stoul(arg.substr(strlen("--threads="))));
+    else if (arg.rfind("--isa=", 0) == 0)
+      settings.maxSimdIsa = parseSimdIsa(arg.substr(strlen("--isa=")));
+    else if (arg.rfind("--frames-in-flight=", 0) == 0)
+      framePacingSettings.framesInFlight = uint32_t(std::stoul(arg.substr(strlen("--frames-in-flight="))));
+    else if (arg.rfind("--swap-chain-images=", 0) == 0)
+      framePacingSettings.swapChainImages = uint32_t(std::stoul(arg.substr(strlen("--swap-chain-images="))));
+    else if (arg.rfind("--present=", 0) == 0)
+      framePacingSettings.presentMode = parsePresentMode(arg.substr(strlen("--present=")));
+    else if (arg.rfind("--max-fps=", 0) == 0)
+      framePacingSettings.maxFps = uint32_t(std::stoul(arg.substr(strlen("--max-fps="))));
+    else if (arg == "--wait-for-gpu")
+      framePacingSettings.waitForGpuBeforeInput = true;
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  mg::initWindow(800, 600, framePacingSettings);
+  Invaders invaders = {};
+  invadersInit(&invaders, settings);
 
-  constexpr float lastFrameMsMin = 16.0f;
-  float startTime = mg::getTime();
   while (mg::startFrame()) {
     if (invaders.aliens.nrAliens == 0 || invaders.player.health <= 0)
       invadersReset(&invaders);
@@ -23,13 +80,6 @@ int main() {
 
       invadersEndFrame();
     }
-    const auto endTime = mg::getTime();
-    const auto lastFrameMs = float((endTime - startTime) * 1000.0);
-    startTime = mg::getTime();
-
-    if (lastFrameMs < lastFrameMsMin) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(uint32_t(lastFrameMsMin - lastFrameMs)));
-    }
     mg::endFrame();
   }
   invadersDestroy(&invaders);
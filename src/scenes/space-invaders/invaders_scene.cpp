@@ -8,11 +8,14 @@
 #include "transforms.h"
 #include "vulkan/singleRenderpass.h"
 #include "mg/texts.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 
 // global
 Device device = {};
-static const Settings settings = {};
+static Settings settings = {};
+static double simulateMs = 0;
 static mg::SingleRenderPass singleRenderPass;
 
 static void resizeCallback() {
@@ -20,11 +23,33 @@ static void resizeCallback() {
   mg::mgSystem.textureContainer.setupDescriptorSets();
 }
 
-void invadersInit(Invaders *invaders) {
+Settings createStressSettings() {
+  Settings stress = {};
+  stress.aliensCols = 500;
+  stress.aliensRows = 200;
+  stress.alienSize = 1.5f;
+  stress.alienBulletSize = 1.5f;
+  stress.playerBulletSize = 1.5f;
+  stress.cellSize = 3.0f;
+  stress.playerFireColdDown = 0.0f;
+  stress.playerAutoFire = true;
+  stress.maxPlayerBullets = 10000;
+  stress.maxAlienBullets = 100000;
+  stress.alienFireTries = 512;
+  stress.alienFireOdds = 1;
+  return stress;
+}
+
+void invadersInit(Invaders *invaders, const Settings &initSettings) {
   mg::initSingleRenderPass(&singleRenderPass);
 
   assert(invaders);
-  device.linearAllocator.init(1024 * 1024);
+  assert(initSettings.alienFireOdds > 0);
+  settings = initSettings;
+  device.linearAllocator.init(frameMemorySize(settings));
+  device.entityAllocator.init(entityMemorySize(settings));
+  device.workers.create(settings.nrOfThreads);
+  selectSimdKernels(settings.maxSimdIsa);
   invadersReset(invaders);
 
   mg::mgSystem.textureContainer.setupDescriptorSets();
@@ -33,7 +58,9 @@ void invadersInit(Invaders *invaders) {
 
 void invadersDestroy(Invaders *invaders) {
   assert(invaders);
-  *invaders = {};
+  freeInvaders(invaders);
+  device.workers.destroy();
+  device.entityAllocator.destroy();
   device.linearAllocator.destroy();
   mg::waitForDeviceIdle();
   destroySingleRenderPass(&singleRenderPass);
@@ -44,16 +71,12 @@ void invadersReset(Invaders *invaders) { invadersReset(invaders, settings); }
 
 void invadersSimulate(Invaders *invaders, const mg::FrameData &frameData, float dt) {
   assert(invaders);
+  const auto startTime = std::chrono::high_resolution_clock::now();
 
   if (frameData.keys.r) {
     mg::mgSystem.pipelineContainer.resetPipelineContainer();
   }
 
-  Hashmap alienHashmap = {};
-  Hashmap alienBulletsHashmap = {};
-  alienHashmap.init(&device.linearAllocator, 512);
-  alienBulletsHashmap.init(&device.linearAllocator, 512);
-
   auto &player = invaders->player;
   auto &aliens = invaders->aliens;
   auto &playerBullets = invaders->playerBullets;
@@ -66,21 +89,25 @@ void invadersSimulate(Invaders *invaders, const mg::FrameData &frameData, float
   transformPositions(alienBullets.x, alienBullets.y, alienBullets.nrBullets, alienBullets.direction, alienBullets.speed, dt);
 
   // fire bullets
-  if (shouldFirePlayerBullet(&player, frameData, dt)) {
-    assert(playerBullets.nrBullets < MAX_BULLETS);
+  if (shouldFirePlayerBullet(&player, frameData, settings.playerAutoFire, dt) &&
+      playerBullets.nrBullets < playerBullets.maxBullets) {
     playerBullets.x[playerBullets.nrBullets] = player.position.x;
     playerBullets.y[playerBullets.nrBullets++] = player.position.y;
   }
-  fireAlienBullets(settings, aliens, &alienBullets);
+  fireAlienBullets(settings, &aliens, &alienBullets);
 
   // add entities to grid
-  addTransformToGrid(aliens.x, aliens.y, aliens.nrAliens, &alienHashmap, settings.cellSize);
-  addTransformToGrid(alienBullets.x, alienBullets.y, alienBullets.nrBullets, &alienBulletsHashmap, settings.cellSize);
+  Hashmap alienHashmap = {};
+  Hashmap alienBulletsHashmap = {};
+  alienHashmap.init(&device.linearAllocator, aliens.maxAliens);
+  alienBulletsHashmap.init(&device.linearAllocator, alienBullets.maxBullets);
+  alienHashmap.build(&device.workers, aliens.x, aliens.y, aliens.nrAliens, settings.cellSize);
+  alienBulletsHashmap.build(&device.workers, alienBullets.x, alienBullets.y, alienBullets.nrBullets, settings.cellSize);
 
   // handle collisions
-  playerBulletsOnAlienCollision(alienHashmap, settings, &aliens, &playerBullets, settings.cellSize);
-  alienBulletsOnPlayerCollision(alienBulletsHashmap, settings, &player, &alienBullets, settings.cellSize);
-  alienOnPlayerCollision(alienHashmap, settings, &aliens, &player, settings.cellSize);
+  playerBulletsOnAlienCollision(alienHashmap, settings, &aliens, &playerBullets);
+  alienBulletsOnPlayerCollision(alienBulletsHashmap, settings, &player, &alienBullets);
+  alienOnPlayerCollision(alienHashmap, settings, &aliens, &player);
 
   // handle borders
   removeBulletsOutsideBorders(&playerBullets);
@@ -88,6 +115,8 @@ void invadersSimulate(Invaders *invaders, const mg::FrameData &frameData, float
 
   const bool isAliensOutSideBorder = minMaxAliens.ymax > (mg::vkContext.screen.height - settings.alienSize);
   player.health *= !isAliensOutSideBorder;
+
+  simulateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 }
 
 void invadersRender(const Invaders &invaders, const mg::FrameData &frameData) {
@@ -103,15 +132,19 @@ void invadersRender(const Invaders &invaders, const mg::FrameData &frameData) {
   const auto &playerBullets = invaders.playerBullets;
   const auto &alienBullets = invaders.alienBullets;
 
-  drawSprites(renderContext, aliens.x, aliens.y, aliens.colors, settings.alienSize, aliens.nrAliens);
+  const auto maxDrawn = settings.maxDrawnSprites;
+  drawSprites(renderContext, aliens.x, aliens.y, aliens.colors, settings.alienSize, std::min(aliens.nrAliens, maxDrawn));
   drawSprites(renderContext, &player.position.x, &player.position.y, {45 / 255.0f, 0 / 255.0f, 38 / 255.0f, 1}, settings.playerSize, 1);
-  drawSprites(renderContext, playerBullets.x, playerBullets.y, {45 / 255.0f, 41 / 255.0f, 0 / 255.0f, 1}, settings.playerBulletSize, playerBullets.nrBullets);
-  drawSprites(renderContext, alienBullets.x, alienBullets.y, {233 / 255.0f, 75 / 255.0f, 60 / 255.0f, 1}, settings.alienBulletSize, alienBullets.nrBullets);
+  drawSprites(renderContext, playerBullets.x, playerBullets.y, {45 / 255.0f, 41 / 255.0f, 0 / 255.0f, 1}, settings.playerBulletSize, std::min(playerBullets.nrBullets, maxDrawn));
+  drawSprites(renderContext, alienBullets.x, alienBullets.y, {233 / 255.0f, 75 / 255.0f, 60 / 255.0f, 1}, settings.alienBulletSize, std::min(alienBullets.nrBullets, maxDrawn));
 
-  char textBuffer[40];
+  char textBuffer[128];
   constexpr auto pointsPerAlien = 10;
-  const auto killScore = (MAX_ALIENS - aliens.nrAliens) * pointsPerAlien;
-  snprintf(textBuffer, sizeof(textBuffer), "Health: %d score: %d", player.health, killScore);
+  const auto killScore = (aliens.maxAliens - aliens.nrAliens) * pointsPerAlien;
+  const auto nrOfEntities = aliens.nrAliens + playerBullets.nrBullets + alienBullets.nrBullets;
+  snprintf(textBuffer, sizeof(textBuffer), "Health: %d score: %d, %u entities, simulate %.2f ms on %u threads %s",
+           player.health, killScore, nrOfEntities, simulateMs, device.workers.nrOfThreads(),
+           simdIsaName(simdKernels().isa));
 
   mg::Texts texts = {};
   mg::Text text = {textBuffer};
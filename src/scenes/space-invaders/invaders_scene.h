@@ -1,7 +1,9 @@
 #pragma once
 
 #include "allocator.h"
+#include "simd_kernels.h"
 #include "types.h"
+#include "mg/workerPool.h"
 
 namespace mg {
   struct FrameData;
@@ -22,23 +24,38 @@ struct Settings {
   float playerSpeed = 1000.0f;
   float playerBulletSpeed = 500.0f;
   float playerFireColdDown = 0.05f;
+  bool playerAutoFire = false;
   uint32_t startHealth = 3;
   float alienSpeed = 150.0f;
   float alienBulletSpeed = 100.0f;
-  float cellSize = 8.0f;
-  uint32_t aliensRows = ALIEN_ROWS;
-  uint32_t aliensCols = ALIEN_COLS;
+  float cellSize = 20.0f; // queries scan more cells when two radii add up to more than a cell
+  uint32_t aliensRows = 10;
+  uint32_t aliensCols = 21;
+  // budgets, firing stops while the bullets are at their budget
+  uint32_t maxPlayerBullets = 1000;
+  uint32_t maxAlienBullets = 1000;
+  // every frame alienFireTries random aliens each fire with a chance of 1 / alienFireOdds
+  uint32_t alienFireTries = 1;
+  uint32_t alienFireOdds = 50000;
+  uint32_t nrOfThreads = 0; // 0 uses all hardware threads
+  SIMD_ISA maxSimdIsa = SIMD_ISA::AVX512; // the best instruction set the cpu supports up to this one is used
+  uint32_t maxDrawnSprites = 250000; // per draw call, bounded by the per frame storage buffer
 };
 
+// 10^5 aliens and up to 10^5 alien bullets on an 800x600 window
+Settings createStressSettings();
+
 struct Device {
   LinearAllocator linearAllocator;
+  LinearAllocator entityAllocator;
+  mg::WorkerPool workers; // jobs must not allocate from the linear allocators, they are not thread safe
 };
 
 extern Device device;
 
-void invadersInit(Invaders *invaders);
+void invadersInit(Invaders *invaders, const Settings &settings);
 void invadersDestroy(Invaders *invaders);
 void invadersReset(Invaders *invaders);
 void invadersSimulate(Invaders *invaders, const mg::FrameData &frameData, float dt);
 void invadersRender(const Invaders &invaders, const mg::FrameData &frameData);
-void invadersEndFrame();
\ No newline at end of file
+void invadersEndFrame();
@@ -1,6 +1,7 @@
 #pragma once
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 
 #if defined(_WIN32)
@@ -11,8 +12,8 @@
 #define aligned_free free
 #endif
 
-static constexpr uint32_t SIMD_ALIGNMENT = 32;
-static constexpr uint32_t SIMD_NR_FLOATS = 8;
+// one avx-512 register, the simd kernels handle any length so the arrays are not padded
+static constexpr uint32_t SIMD_ALIGNMENT = 64;
 
 struct vec2 {
   float x, y;
@@ -32,24 +33,28 @@ inline uint32_t alignUpPowerOfTwo(uint32_t n, uint32_t alignment) { return (n +
 inline float sqrtDistance(vec2 p0, vec2 p1) { return ((p0.x - p1.x) * (p0.x - p1.x) + (p0.y - p1.y) * (p0.y - p1.y)); }
 inline bool inRange(float value, float left, float right) { return ((value - right) * (value - left) <= 0); }
 
-// Fowler-Noll-Vo_hash_function
-// https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
-static constexpr uint64_t FNV_ffset_basis = 14695981039346656037ULL;
-static constexpr uint64_t FNV_prime = 1099511628211ULL;
-
-inline uint64_t hashBytes(const unsigned char *first, const unsigned char *last) {
-  assert(sizeof(size_t) == 8 && "size_t is not 8 bytes, build for 64 bits");
-  assert(uint64_t(last - first) % 8 == 0);
-  uint64_t hash = FNV_ffset_basis;
-  for (; first != last; ++first) {
-    hash = hash ^ static_cast<uint64_t>(*first);
-    hash = hash * FNV_prime;
-  }
+inline ivec2 gridPosition(float x, float y, float cellSize) {
+  return {int32_t(std::floor(x / cellSize)), int32_t(std::floor(y / cellSize))};
+}
+
+// Integer mixing of the two cell coordinates with the murmur3 finalizer, neighbouring cells land in unrelated
+// buckets so rows of aliens do not pile up in a few of them.
+inline uint32_t hashGridPosition(ivec2 gridCoordinates) {
+  uint32_t hash = uint32_t(gridCoordinates.x) * 0x8da6b343u ^ uint32_t(gridCoordinates.y) * 0xd8163841u;
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
   return hash;
 }
 
-inline uint64_t hashGridPosition(ivec2 gridCoordinates) {
-  return hashBytes((const unsigned char *)&gridCoordinates, ((const unsigned char *)&gridCoordinates) + sizeof(gridCoordinates));
+// xorshift32, the state must not be 0
+inline uint32_t nextRandom(uint32_t *state) {
+  assert(*state);
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
 }
 
-uint32_t ctz(uint32_t value);
@@ -11,11 +11,11 @@ void transformPlayer(Player *player, uint32_t screenWidth, float spriteSize, con
   player->position.x = player->position.x < rightMargin ? player->position.x : rightMargin;
 }
 
-bool shouldFirePlayerBullet(Player *player, const mg::FrameData &frameData, float dt) {
+bool shouldFirePlayerBullet(Player *player, const mg::FrameData &frameData, bool autoFire, float dt) {
   assert(player);
   player->msSinceLastFire += dt;
   uint32_t shouldFire = uint32_t(player->msSinceLastFire > player->weaponColdDown);
-  shouldFire *= uint32_t(frameData.keys.space);
+  shouldFire *= uint32_t(frameData.keys.space || autoFire);
   player->msSinceLastFire *= !uint32_t(shouldFire);
   return shouldFire;
 }
@@ -9,4 +9,4 @@ namespace mg {
 struct Player;
 
 void transformPlayer(Player *player, uint32_t screenWidth, float spriteSize, const mg::FrameData &frameData, float dt);
-bool shouldFirePlayerBullet(Player *player, const mg::FrameData &frameData, float dt);
+bool shouldFirePlayerBullet(Player *player, const mg::FrameData &frameData, bool autoFire, float dt);
@@ -0,0 +1,126 @@
+#include "mg/logger.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Runs every simd kernel with every instruction set the cpu supports and reports entities per nanosecond, the results
+// are compared with the scalar kernels.
+// invaders-simd-bench [--entities=N] [--iterations=N] [--range=N]
+// --range is the number of positions per findFirstWithin call, about the number of entities in a hashmap bucket.
+
+namespace {
+
+struct Positions {
+  std::vector<float> x, y;
+};
+
+double nanoseconds(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+template <typename Job> double entitiesPerNanosecond(uint64_t nrOfEntities, uint32_t iterations, Job job) {
+  job(); // warm up the caches
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (uint32_t i = 0; i < iterations; i++)
+    job();
+  return double(nrOfEntities) * iterations / nanoseconds(start);
+}
+
+// query points next to a random position, so about half of the calls find a hit
+std::vector<uint32_t> findReference(const SimdKernels &kernels, const Positions &positions, uint32_t range,
+                                    float squaredRadius) {
+  const uint32_t size = uint32_t(positions.x.size());
+  std::vector<uint32_t> indices;
+  std::mt19937 generator(7);
+  for (uint32_t begin = 0; begin + range <= size; begin += range) {
+    const uint32_t target = begin + generator() % range;
+    const float px = positions.x[target] + (generator() % 2 ? 0.5f : 5.0f);
+    indices.push_back(kernels.findFirstWithin(positions.x.data(), positions.y.data(), begin, begin + range, px,
+                                              positions.y[target], squaredRadius));
+  }
+  return indices;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t nrOfEntities = 100000;
+  uint32_t iterations = 200;
+  uint32_t range = 13;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--entities=", 0) == 0)
+      nrOfEntities = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--entities=")))));
+    else if (arg.rfind("--iterations=", 0) == 0)
+      iterations = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--iterations=")))));
+    else if (arg.rfind("--range=", 0) == 0)
+      range = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--range=")))));
+    else
+      LOG("unknown argument " << arg);
+  }
+  range = std::min(range, nrOfEntities);
+
+  Positions start = {};
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> distribution(0.0f, 800.0f);
+  for (uint32_t i = 0; i < nrOfEntities; i++) {
+    start.x.push_back(distribution(generator));
+    start.y.push_back(distribution(generator));
+  }
+  constexpr float dx = 0.25f, dy = -0.5f, squaredRadius = 1.0f;
+
+  const auto &scalar = *getSimdKernels(SIMD_ISA::SCALAR);
+  Positions reference = start;
+  const auto referenceBounds =
+      scalar.translateBounds(reference.x.data(), reference.y.data(), nrOfEntities, dx, dy);
+  const auto referenceIndices = findReference(scalar, start, range, squaredRadius);
+
+  LOG("cpu supports " << simdIsaName(detectSimdIsa()) << ", " << nrOfEntities << " entities, " << iterations
+                      << " iterations, find range " << range);
+  bool sameResults = true;
+  for (uint32_t i = 0; i < uint32_t(SIMD_ISA::SIZE); i++) {
+    const auto isa = SIMD_ISA(i);
+    const auto kernels = getSimdKernels(isa);
+    if (!kernels) {
+      LOG(simdIsaName(isa) << ": not supported");
+      continue;
+    }
+
+    Positions moved = start;
+    const auto bounds = kernels->translateBounds(moved.x.data(), moved.y.data(), nrOfEntities, dx, dy);
+    const bool sameBounds = bounds.xmin == referenceBounds.xmin && bounds.xmax == referenceBounds.xmax &&
+                            bounds.ymax == referenceBounds.ymax;
+    const bool same = moved.x == reference.x && moved.y == reference.y && sameBounds &&
+                      findReference(*kernels, start, range, squaredRadius) == referenceIndices;
+    sameResults = sameResults && same;
+
+    // the positions go back and forth so they stay in range
+    float sign = 1.0f;
+    const double translate = entitiesPerNanosecond(nrOfEntities, iterations, [&] {
+      kernels->translate(moved.x.data(), moved.y.data(), nrOfEntities, sign * dx, sign * dy);
+      sign = -sign;
+    });
+    volatile float sink = 0;
+    const double translateBounds = entitiesPerNanosecond(nrOfEntities, iterations, [&] {
+      sink = kernels->translateBounds(moved.x.data(), moved.y.data(), nrOfEntities, sign * dx, sign * dy).ymax;
+      sign = -sign;
+    });
+    // the query point is far away so every call scans its whole range
+    const uint32_t nrOfRanges = nrOfEntities / range;
+    const double find = entitiesPerNanosecond(uint64_t(nrOfRanges) * range, iterations, [&] {
+      uint32_t hits = 0;
+      for (uint32_t r = 0; r < nrOfRanges; r++)
+        hits += kernels->findFirstWithin(start.x.data(), start.y.data(), r * range, (r + 1) * range, -1000.0f,
+                                         -1000.0f, squaredRadius) != UINT32_MAX;
+      sink = float(hits);
+    });
+
+    LOG(simdIsaName(isa) << ": translate " << translate << ", translate with bounds " << translateBounds
+                         << ", find " << find << " entities/ns" << (same ? "" : ", DIFFERENT FROM SCALAR"));
+  }
+  return sameResults ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include "simd_kernels.h"
+#include "mg/cpuFeatures.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+
+void translate(float *x, float *y, uint32_t size, float dx, float dy) {
+  for (uint32_t i = 0; i < size; i++) {
+    x[i] += dx;
+    y[i] += dy;
+  }
+}
+
+SimdBounds translateBounds(float *x, float *y, uint32_t size, float dx, float dy) {
+  SimdBounds bounds = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+                       std::numeric_limits<float>::lowest()};
+  for (uint32_t i = 0; i < size; i++) {
+    x[i] += dx;
+    y[i] += dy;
+    bounds.xmin = std::min(bounds.xmin, x[i]);
+    bounds.xmax = std::max(bounds.xmax, x[i]);
+    bounds.ymax = std::max(bounds.ymax, y[i]);
+  }
+  return bounds;
+}
+
+uint32_t findFirstWithin(const float *x, const float *y, uint32_t begin, uint32_t end, float px, float py,
+                         float squaredRadius) {
+  for (uint32_t i = begin; i < end; i++) {
+    if ((px - x[i]) * (px - x[i]) + (py - y[i]) * (py - y[i]) <= squaredRadius)
+      return i;
+  }
+  return UINT32_MAX;
+}
+
+const SimdKernels scalarKernels = {SIMD_ISA::SCALAR, 1, translate, translateBounds, findFirstWithin};
+
+bool isSupported(SIMD_ISA isa) {
+  static const SIMD_ISA detected = detectSimdIsa();
+  return isa <= detected;
+}
+
+const SimdKernels *selected = nullptr;
+const char *isaNames[] = {"scalar", "sse4.2", "avx2", "avx512"};
+static_assert(sizeof(isaNames) / sizeof(isaNames[0]) == size_t(SIMD_ISA::SIZE), "missing instruction set name");
+
+} // namespace
+
+SIMD_ISA detectSimdIsa() {
+  const auto &features = mg::cpuFeatures();
+  if (!features.sse42)
+    return SIMD_ISA::SCALAR;
+  if (!features.avx2)
+    return SIMD_ISA::SSE42;
+  if (!features.avx512)
+    return SIMD_ISA::AVX2;
+  return SIMD_ISA::AVX512;
+}
+
+const char *simdIsaName(SIMD_ISA isa) {
+  assert(isa < SIMD_ISA::SIZE);
+  return isaNames[uint32_t(isa)];
+}
+
+const SimdKernels *getSimdKernels(SIMD_ISA isa) {
+  if (!isSupported(isa))
+    return nullptr;
+  switch (isa) {
+  case SIMD_ISA::SCALAR:
+    return &scalarKernels;
+  case SIMD_ISA::SSE42:
+    return sse42Kernels();
+  case SIMD_ISA::AVX2:
+    return avx2Kernels();
+  case SIMD_ISA::AVX512:
+    return avx512Kernels();
+  default:
+    return nullptr;
+  }
+}
+
+const SimdKernels &selectSimdKernels(SIMD_ISA maxIsa) {
+  assert(maxIsa < SIMD_ISA::SIZE);
+  selected = &scalarKernels;
+  for (int32_t isa = int32_t(maxIsa); isa > int32_t(SIMD_ISA::SCALAR); isa--) {
+    if (const auto kernels = getSimdKernels(SIMD_ISA(isa))) {
+      selected = kernels;
+      break;
+    }
+  }
+  return *selected;
+}
+
+const SimdKernels &simdKernels() {
+  if (!selected)
+    selectSimdKernels(SIMD_ISA::AVX512);
+  return *selected;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// The hot loops over the entity arrays are compiled once per instruction set, each in its own translation unit with
+// its own compiler flags, and the best one the cpu supports is picked at startup with cpuid. The rest of the scene is
+// built for the baseline so the same binary runs on every x86-64 cpu.
+//
+// The per instruction set translation units must only include this header and the intrinsics headers, an inline
+// function from a shared header compiled with -mavx512f could be the copy the linker keeps for everyone.
+enum class SIMD_ISA { SCALAR, SSE42, AVX2, AVX512, SIZE };
+
+struct SimdBounds {
+  float xmin, xmax;
+  float ymax;
+};
+
+struct SimdKernels {
+  SIMD_ISA isa;
+  uint32_t nrOfFloats; // per register
+
+  // adds (dx, dy) to every position
+  void (*translate)(float *x, float *y, uint32_t size, float dx, float dy);
+  // adds (dx, dy) to every position and returns the bounds of the moved positions
+  SimdBounds (*translateBounds)(float *x, float *y, uint32_t size, float dx, float dy);
+  // index of the first position in [begin, end) within sqrt(squaredRadius) of (px, py), or UINT32_MAX
+  uint32_t (*findFirstWithin)(const float *x, const float *y, uint32_t begin, uint32_t end, float px, float py,
+                              float squaredRadius);
+};
+
+SIMD_ISA detectSimdIsa();
+const char *simdIsaName(SIMD_ISA isa); // scalar, sse4.2, avx2 or avx512
+// the kernels for isa, or nullptr if they are not compiled in or the cpu does not support them
+const SimdKernels *getSimdKernels(SIMD_ISA isa);
+// selects the best supported kernels up to maxIsa, call before any worker threads use them
+const SimdKernels &selectSimdKernels(SIMD_ISA maxIsa);
+// the selected kernels, the best supported ones if selectSimdKernels was never called
+const SimdKernels &simdKernels();
+
+// defined in simd_kernels_*.cpp, nullptr when the compiler did not get the flags for the instruction set
+const SimdKernels *sse42Kernels();
+const SimdKernels *avx2Kernels();
+const SimdKernels *avx512Kernels();
+
+// static so every translation unit has its own copy built with its own flags, mask must not be 0
+static inline uint32_t lowestSetBit(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return uint32_t(index);
+#else
+  return uint32_t(__builtin_ctz(mask));
+#endif
+}
@@ -0,0 +1,109 @@
+#include "simd_kernels.h"
+#include "mg/cpuFeatures.h"
+#include <cfloat>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+constexpr uint32_t NR_OF_FLOATS = 8;
+
+float horizontalMin(__m256 v) {
+  __m128 h = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  h = _mm_min_ps(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(2, 3, 0, 1)));
+  h = _mm_min_ps(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(h);
+}
+
+float horizontalMax(__m256 v) {
+  __m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  h = _mm_max_ps(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(2, 3, 0, 1)));
+  h = _mm_max_ps(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(h);
+}
+
+__m256 squaredDistances(__m256 px, __m256 py, __m256 x, __m256 y) {
+  const __m256 dx = _mm256_sub_ps(px, x);
+  const __m256 dy = _mm256_sub_ps(py, y);
+  return _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+}
+
+void translate(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m256 vdx = _mm256_set1_ps(dx);
+  const __m256 vdy = _mm256_set1_ps(dy);
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), vdx));
+    _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), vdy));
+  }
+  if (i < size) {
+    const __m256i mask = mg::tailMask(size - i);
+    _mm256_maskstore_ps(x + i, mask, _mm256_add_ps(_mm256_maskload_ps(x + i, mask), vdx));
+    _mm256_maskstore_ps(y + i, mask, _mm256_add_ps(_mm256_maskload_ps(y + i, mask), vdy));
+  }
+}
+
+SimdBounds translateBounds(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m256 vdx = _mm256_set1_ps(dx);
+  const __m256 vdy = _mm256_set1_ps(dy);
+  const __m256 maxFloat = _mm256_set1_ps(FLT_MAX);
+  const __m256 lowestFloat = _mm256_set1_ps(-FLT_MAX);
+  __m256 vxmin = maxFloat;
+  __m256 vxmax = lowestFloat;
+  __m256 vymax = lowestFloat;
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    const __m256 vx = _mm256_add_ps(_mm256_loadu_ps(x + i), vdx);
+    const __m256 vy = _mm256_add_ps(_mm256_loadu_ps(y + i), vdy);
+    _mm256_storeu_ps(x + i, vx);
+    _mm256_storeu_ps(y + i, vy);
+    vxmin = _mm256_min_ps(vxmin, vx);
+    vxmax = _mm256_max_ps(vxmax, vx);
+    vymax = _mm256_max_ps(vymax, vy);
+  }
+  if (i < size) {
+    const __m256i mask = mg::tailMask(size - i);
+    const __m256 laneMask = _mm256_castsi256_ps(mask);
+    const __m256 vx = _mm256_add_ps(_mm256_maskload_ps(x + i, mask), vdx);
+    const __m256 vy = _mm256_add_ps(_mm256_maskload_ps(y + i, mask), vdy);
+    _mm256_maskstore_ps(x + i, mask, vx);
+    _mm256_maskstore_ps(y + i, mask, vy);
+    vxmin = _mm256_min_ps(vxmin, _mm256_blendv_ps(maxFloat, vx, laneMask));
+    vxmax = _mm256_max_ps(vxmax, _mm256_blendv_ps(lowestFloat, vx, laneMask));
+    vymax = _mm256_max_ps(vymax, _mm256_blendv_ps(lowestFloat, vy, laneMask));
+  }
+  return {horizontalMin(vxmin), horizontalMax(vxmax), horizontalMax(vymax)};
+}
+
+uint32_t findFirstWithin(const float *x, const float *y, uint32_t begin, uint32_t end, float px, float py,
+                         float squaredRadius) {
+  const __m256 vpx = _mm256_set1_ps(px);
+  const __m256 vpy = _mm256_set1_ps(py);
+  const __m256 vr2 = _mm256_set1_ps(squaredRadius);
+  uint32_t i = begin;
+  for (; i + NR_OF_FLOATS <= end; i += NR_OF_FLOATS) {
+    const __m256 d2 = squaredDistances(vpx, vpy, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+    const uint32_t hits = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(d2, vr2, _CMP_LE_OQ)));
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  if (i < end) {
+    const __m256i mask = mg::tailMask(end - i);
+    const __m256 d2 = squaredDistances(vpx, vpy, _mm256_maskload_ps(x + i, mask), _mm256_maskload_ps(y + i, mask));
+    const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(d2, vr2, _CMP_LE_OQ), _mm256_castsi256_ps(mask));
+    const uint32_t hits = uint32_t(_mm256_movemask_ps(inside));
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  return UINT32_MAX;
+}
+
+const SimdKernels kernels = {SIMD_ISA::AVX2, NR_OF_FLOATS, translate, translateBounds, findFirstWithin};
+
+} // namespace
+
+const SimdKernels *avx2Kernels() { return &kernels; }
+#else
+const SimdKernels *avx2Kernels() { return nullptr; }
+#endif
@@ -0,0 +1,99 @@
+#include "simd_kernels.h"
+#include <cfloat>
+
+#if defined(__AVX512F__)
+#if defined(__GNUC__) && !defined(__clang__)
+// gcc 12 takes the undefined registers the avx-512 intrinsics start from for uninitialized variables
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+
+namespace {
+
+constexpr uint32_t NR_OF_FLOATS = 16;
+
+__mmask16 tailMask(uint32_t count) { return __mmask16((1u << count) - 1); }
+
+__m512 squaredDistances(__m512 px, __m512 py, __m512 x, __m512 y) {
+  const __m512 dx = _mm512_sub_ps(px, x);
+  const __m512 dy = _mm512_sub_ps(py, y);
+  return _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+}
+
+void translate(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m512 vdx = _mm512_set1_ps(dx);
+  const __m512 vdy = _mm512_set1_ps(dy);
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    _mm512_storeu_ps(x + i, _mm512_add_ps(_mm512_loadu_ps(x + i), vdx));
+    _mm512_storeu_ps(y + i, _mm512_add_ps(_mm512_loadu_ps(y + i), vdy));
+  }
+  if (i < size) {
+    const __mmask16 mask = tailMask(size - i);
+    _mm512_mask_storeu_ps(x + i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, x + i), vdx));
+    _mm512_mask_storeu_ps(y + i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, y + i), vdy));
+  }
+}
+
+SimdBounds translateBounds(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m512 vdx = _mm512_set1_ps(dx);
+  const __m512 vdy = _mm512_set1_ps(dy);
+  __m512 vxmin = _mm512_set1_ps(FLT_MAX);
+  __m512 vxmax = _mm512_set1_ps(-FLT_MAX);
+  __m512 vymax = _mm512_set1_ps(-FLT_MAX);
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    const __m512 vx = _mm512_add_ps(_mm512_loadu_ps(x + i), vdx);
+    const __m512 vy = _mm512_add_ps(_mm512_loadu_ps(y + i), vdy);
+    _mm512_storeu_ps(x + i, vx);
+    _mm512_storeu_ps(y + i, vy);
+    vxmin = _mm512_min_ps(vxmin, vx);
+    vxmax = _mm512_max_ps(vxmax, vx);
+    vymax = _mm512_max_ps(vymax, vy);
+  }
+  if (i < size) {
+    // the lanes outside the mask keep their running value
+    const __mmask16 mask = tailMask(size - i);
+    const __m512 vx = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, x + i), vdx);
+    const __m512 vy = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, y + i), vdy);
+    _mm512_mask_storeu_ps(x + i, mask, vx);
+    _mm512_mask_storeu_ps(y + i, mask, vy);
+    vxmin = _mm512_mask_min_ps(vxmin, mask, vxmin, vx);
+    vxmax = _mm512_mask_max_ps(vxmax, mask, vxmax, vx);
+    vymax = _mm512_mask_max_ps(vymax, mask, vymax, vy);
+  }
+  return {_mm512_reduce_min_ps(vxmin), _mm512_reduce_max_ps(vxmax), _mm512_reduce_max_ps(vymax)};
+}
+
+uint32_t findFirstWithin(const float *x, const float *y, uint32_t begin, uint32_t end, float px, float py,
+                         float squaredRadius) {
+  const __m512 vpx = _mm512_set1_ps(px);
+  const __m512 vpy = _mm512_set1_ps(py);
+  const __m512 vr2 = _mm512_set1_ps(squaredRadius);
+  uint32_t i = begin;
+  for (; i + NR_OF_FLOATS <= end; i += NR_OF_FLOATS) {
+    const __m512 d2 = squaredDistances(vpx, vpy, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+    const uint32_t hits = _mm512_cmp_ps_mask(d2, vr2, _CMP_LE_OQ);
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  if (i < end) {
+    const __mmask16 mask = tailMask(end - i);
+    const __m512 d2 =
+        squaredDistances(vpx, vpy, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+    const uint32_t hits = _mm512_mask_cmp_ps_mask(mask, d2, vr2, _CMP_LE_OQ);
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  return UINT32_MAX;
+}
+
+const SimdKernels kernels = {SIMD_ISA::AVX512, NR_OF_FLOATS, translate, translateBounds, findFirstWithin};
+
+} // namespace
+
+const SimdKernels *avx512Kernels() { return &kernels; }
+#else
+const SimdKernels *avx512Kernels() { return nullptr; }
+#endif
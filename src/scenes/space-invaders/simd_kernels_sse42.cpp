@@ -0,0 +1,145 @@
+#include "simd_kernels.h"
+#include <cfloat>
+
+#if defined(__SSE4_2__) || defined(_M_X64)
+#include <smmintrin.h>
+
+namespace {
+
+constexpr uint32_t NR_OF_FLOATS = 4;
+
+// sse has no masked loads and stores, the last partial register is put together from 4 and 8 byte moves and the
+// unused lanes are 0
+__m128 loadTail(const float *src, uint32_t count) {
+  switch (count) {
+  case 1:
+    return _mm_load_ss(src);
+  case 2:
+    return _mm_castpd_ps(_mm_load_sd((const double *)src));
+  default:
+    return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double *)src)), _mm_load_ss(src + 2));
+  }
+}
+
+void storeTail(float *dst, __m128 value, uint32_t count) {
+  switch (count) {
+  case 1:
+    _mm_store_ss(dst, value);
+    break;
+  case 2:
+    _mm_storel_pi((__m64 *)dst, value);
+    break;
+  default:
+    _mm_storel_pi((__m64 *)dst, value);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(value, value));
+    break;
+  }
+}
+
+__m128 tailMask(uint32_t count) {
+  return _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(int32_t(count)), _mm_setr_epi32(0, 1, 2, 3)));
+}
+
+float horizontalMin(__m128 v) {
+  v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(v);
+}
+
+float horizontalMax(__m128 v) {
+  v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(v);
+}
+
+__m128 squaredDistances(__m128 px, __m128 py, __m128 x, __m128 y) {
+  const __m128 dx = _mm_sub_ps(px, x);
+  const __m128 dy = _mm_sub_ps(py, y);
+  return _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+}
+
+void translate(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m128 vdx = _mm_set1_ps(dx);
+  const __m128 vdy = _mm_set1_ps(dy);
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), vdx));
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), vdy));
+  }
+  if (i < size) {
+    const uint32_t count = size - i;
+    storeTail(x + i, _mm_add_ps(loadTail(x + i, count), vdx), count);
+    storeTail(y + i, _mm_add_ps(loadTail(y + i, count), vdy), count);
+  }
+}
+
+SimdBounds translateBounds(float *x, float *y, uint32_t size, float dx, float dy) {
+  const __m128 vdx = _mm_set1_ps(dx);
+  const __m128 vdy = _mm_set1_ps(dy);
+  const __m128 maxFloat = _mm_set1_ps(FLT_MAX);
+  const __m128 lowestFloat = _mm_set1_ps(-FLT_MAX);
+  __m128 vxmin = maxFloat;
+  __m128 vxmax = lowestFloat;
+  __m128 vymax = lowestFloat;
+  uint32_t i = 0;
+  for (; i + NR_OF_FLOATS <= size; i += NR_OF_FLOATS) {
+    const __m128 vx = _mm_add_ps(_mm_loadu_ps(x + i), vdx);
+    const __m128 vy = _mm_add_ps(_mm_loadu_ps(y + i), vdy);
+    _mm_storeu_ps(x + i, vx);
+    _mm_storeu_ps(y + i, vy);
+    vxmin = _mm_min_ps(vxmin, vx);
+    vxmax = _mm_max_ps(vxmax, vx);
+    vymax = _mm_max_ps(vymax, vy);
+  }
+  if (i < size) {
+    const uint32_t count = size - i;
+    const __m128 mask = tailMask(count);
+    const __m128 vx = _mm_add_ps(loadTail(x + i, count), vdx);
+    const __m128 vy = _mm_add_ps(loadTail(y + i, count), vdy);
+    storeTail(x + i, vx, count);
+    storeTail(y + i, vy, count);
+    vxmin = _mm_min_ps(vxmin, _mm_blendv_ps(maxFloat, vx, mask));
+    vxmax = _mm_max_ps(vxmax, _mm_blendv_ps(lowestFloat, vx, mask));
+    vymax = _mm_max_ps(vymax, _mm_blendv_ps(lowestFloat, vy, mask));
+  }
+  return {horizontalMin(vxmin), horizontalMax(vxmax), horizontalMax(vymax)};
+}
+
+uint32_t findFirstWithin(const float *x, const float *y, uint32_t begin, uint32_t end, float px, float py,
+                         float squaredRadius) {
+  const __m128 vpx = _mm_set1_ps(px);
+  const __m128 vpy = _mm_set1_ps(py);
+  const __m128 vr2 = _mm_set1_ps(squaredRadius);
+  uint32_t i = begin;
+  for (; i + NR_OF_FLOATS <= end; i += NR_OF_FLOATS) {
+    const __m128 d2 = squaredDistances(vpx, vpy, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i));
+    const uint32_t hits = uint32_t(_mm_movemask_ps(_mm_cmple_ps(d2, vr2)));
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  if (i < end) {
+    const uint32_t count = end - i;
+    uint32_t hits = 0;
+    if (end - begin >= NR_OF_FLOATS) {
+      // the last whole register of the range, its first lanes are already checked
+      const uint32_t last = end - NR_OF_FLOATS;
+      const __m128 d2 = squaredDistances(vpx, vpy, _mm_loadu_ps(x + last), _mm_loadu_ps(y + last));
+      hits = uint32_t(_mm_movemask_ps(_mm_cmple_ps(d2, vr2))) >> (NR_OF_FLOATS - count);
+    } else {
+      const __m128 d2 = squaredDistances(vpx, vpy, loadTail(x + i, count), loadTail(y + i, count));
+      hits = uint32_t(_mm_movemask_ps(_mm_cmple_ps(d2, vr2))) & ((1u << count) - 1);
+    }
+    if (hits)
+      return i + lowestSetBit(hits);
+  }
+  return UINT32_MAX;
+}
+
+const SimdKernels kernels = {SIMD_ISA::SSE42, NR_OF_FLOATS, translate, translateBounds, findFirstWithin};
+
+} // namespace
+
+const SimdKernels *sse42Kernels() { return &kernels; }
+#else
+const SimdKernels *sse42Kernels() { return nullptr; }
+#endif
@@ -0,0 +1,95 @@
+#include "mg/camera.h"
+#include "mg/logger.h"
+#include "mg/workerPool.h"
+#include "volume_cpu_rendering.h"
+#include "volume_data.h"
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <lodepng.h>
+#include <string>
+
+// Headless cpu rendering of the volume scene, no window or gpu is needed.
+// volume-cpu-rendering [--output=file.png] [--golden=file.png] [--size=WxH] [--frames=N] [--threads=N] [--scalar]
+// Returns 1 if the rendered image differs from the golden image.
+int main(int argc, char **argv) {
+  std::string outputPath = "volume_cpu.png";
+  std::string goldenPath;
+  uint32_t width = 1500, height = 1024;
+  uint32_t nrOfFrames = 5;
+  uint32_t nrOfThreads = 0;
+  bool useSimd = true;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--output=", 0) == 0)
+      outputPath = arg.substr(strlen("--output="));
+    else if (arg.rfind("--golden=", 0) == 0)
+      goldenPath = arg.substr(strlen("--golden="));
+    else if (arg.rfind("--size=", 0) == 0)
+      sscanf(arg.c_str(), "--size=%ux%u", &width, &height);
+    else if (arg.rfind("--frames=", 0) == 0)
+      nrOfFrames = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--frames=")))));
+    else if (arg.rfind("--threads=", 0) == 0)
+      nrOfThreads = uint32_t(std::stoul(arg.substr(strlen("--threads="))));
+    else if (arg == "--scalar")
+      useSimd = false;
+    else
+      LOG("unknown argument " << arg);
+  }
+
+  mg::WorkerPool workers;
+  workers.create(nrOfThreads);
+
+  VolumeData volumeData = {};
+  const auto voxels = readDatFile(&volumeData);
+  const auto cpuVolume = createCpuVolume(volumeData, voxels);
+
+  // same camera as the interactive scene
+  auto camera = mg::create3DCamera(glm::vec3{277 / 2.0f, 277 / 2.0f, -400.0f},
+                                   glm::vec3{277 / 2.0f, 277 / 2.0f, 0.0f}, glm::vec3{0, 1, 0});
+  mg::setCameraTransformation(&camera);
+
+  CpuVolumeRenderInfo renderInfo = {};
+  renderInfo.width = width;
+  renderInfo.height = height;
+  renderInfo.projection = glm::perspective(glm::radians(camera.fov), width / float(height), 0.1f, 10000.f);
+  renderInfo.view = glm::lookAt(camera.position, camera.aim, camera.up);
+  renderInfo.cameraPosition = camera.position;
+  renderInfo.isoValue = 50;
+  renderInfo.stepSize = 0.001f;
+  renderInfo.workers = &workers;
+  renderInfo.useSimd = useSimd;
+
+  CpuVolumeImage image = {};
+  double bestRaysPerSecond = 0;
+  for (uint32_t i = 0; i < nrOfFrames; i++) {
+    const auto stats = renderVolumeCpu(cpuVolume, renderInfo, &image);
+    bestRaysPerSecond = std::max(bestRaysPerSecond, stats.raysPerSecond);
+    LOG("frame " << i << ": " << stats.ms << " ms, " << stats.nrOfPrimaryRays << " primary rays, "
+                 << stats.nrOfShadowRays << " shadow rays, " << stats.raysPerSecond / 1e6 << " Mrays/s");
+  }
+  LOG((useSimd ? "simd" : "scalar") << " best: " << bestRaysPerSecond / 1e6 << " Mrays/s");
+
+  const auto encodeError = lodepng::encode(outputPath, image.rgba, image.width, image.height);
+  if (encodeError) {
+    LOG("encoder error " << encodeError << ": " << lodepng_error_text(encodeError));
+    return 1;
+  }
+
+  if (goldenPath.empty())
+    return 0;
+
+  CpuVolumeImage golden = {};
+  const auto decodeError = lodepng::decode(golden.rgba, golden.width, golden.height, goldenPath);
+  if (decodeError || golden.width != image.width || golden.height != image.height) {
+    LOG("could not read golden image " << goldenPath);
+    return 1;
+  }
+  // allow small differences from the linear filtering precision and the simd evaluation order
+  constexpr uint8_t tolerance = 8;
+  const uint32_t maxNrOfDifferentPixels = image.width * image.height / 1000;
+  const auto nrOfDifferentPixels = compareCpuVolumeImages(image, golden, tolerance);
+  LOG(nrOfDifferentPixels << " pixels differ from " << goldenPath);
+  return nrOfDifferentPixels > maxNrOfDifferentPixels ? 1 : 0;
+}
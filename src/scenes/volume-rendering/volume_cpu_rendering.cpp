@@ -0,0 +1,485 @@
+#include "volume_cpu_rendering.h"
+#include "mg/mgAssert.h"
+#include "mg/mgUtils.h"
+#include "mg/workerPool.h"
+#include "volume_data.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static constexpr uint32_t TILE_SIZE = 32;
+static constexpr uint32_t SIMD_NR_FLOATS = 8;
+static constexpr uint32_t BINARY_SEARCH_STEPS = 5;
+static constexpr int32_t SHADOW_START_STEP = 5;
+static constexpr float SHADOW_RAY_STEPS = 500.0f;
+
+struct Frame {
+  const CpuVolume *volume;
+  glm::mat4 inverseViewProjection;
+  glm::mat3 normalToWorld;   // transpose(inverse(mat3(boxToWorld)))
+  glm::mat3 directionToBox;  // inverse(transpose(mat3(worldToBox)))
+  glm::vec3 cameraPosition;
+  glm::vec3 delta;
+  float stepSize, threshold;
+  uint32_t width, height;
+};
+
+struct BoxRay {
+  glm::vec3 start, direction;
+  float length;
+  bool valid;
+};
+
+struct RayHit {
+  glm::vec3 position;
+  bool hit;
+};
+
+struct TileStats {
+  uint64_t nrOfPrimaryRays;
+  uint64_t nrOfShadowRays;
+};
+
+CpuVolume createCpuVolume(const VolumeData &volumeData, const std::vector<uint16_t> &voxels) {
+  const auto size = volumeData.nrOfVoxels;
+  mgAssert(voxels.size() == size_t(size.x) * size_t(size.y) * size_t(size.z));
+
+  CpuVolume volume = {};
+  volume.size = size;
+  volume.paddedSize = size + glm::ivec3{2};
+  volume.boxToWorld = boxToWorldMatrix(volumeData);
+  volume.worldToBox = worldToBoxMatrix(volumeData);
+  volume.min = volumeData.min;
+  volume.max = volumeData.max;
+
+  // the gpu samples with a transparent black border, store it normalized so that no bounds checks are needed
+  const auto borderValue = mg::reinterval(0.0f, volume.min, volume.max, 0.0f, 1.0f);
+  const auto &padded = volume.paddedSize;
+  volume.voxels.assign(size_t(padded.x) * size_t(padded.y) * size_t(padded.z), borderValue);
+
+  for (int32_t z = 0; z < size.z; z++) {
+    for (int32_t y = 0; y < size.y; y++) {
+      const uint16_t *src = &voxels[size_t(z) * size.x * size.y + size_t(y) * size.x];
+      float *dst = &volume.voxels[size_t(z + 1) * padded.x * padded.y + size_t(y + 1) * padded.x + 1];
+      for (int32_t x = 0; x < size.x; x++)
+        dst[x] = mg::reinterval(float(src[x]), volume.min, volume.max, 0.0f, 1.0f);
+    }
+  }
+  return volume;
+}
+
+// texel coordinate in the padded volume, clamped so that the trilinear footprint never leaves the border
+static float texelCoordinate(float position, int32_t size) {
+  return mg::clamp(position * float(size) - 0.5f, -1.0f, float(size) - 0.0001f) + 1.0f;
+}
+
+static float sampleVolume(const CpuVolume &volume, const glm::vec3 &position) {
+  const float x = texelCoordinate(position.x, volume.size.x);
+  const float y = texelCoordinate(position.y, volume.size.y);
+  const float z = texelCoordinate(position.z, volume.size.z);
+  const auto ix = int32_t(x), iy = int32_t(y), iz = int32_t(z);
+  const float tx = x - float(ix), ty = y - float(iy), tz = z - float(iz);
+
+  const size_t strideY = size_t(volume.paddedSize.x);
+  const size_t strideZ = strideY * size_t(volume.paddedSize.y);
+  const float *v = &volume.voxels[size_t(ix) + size_t(iy) * strideY + size_t(iz) * strideZ];
+
+  const float c00 = mg::mix(v[0], v[1], tx);
+  const float c10 = mg::mix(v[strideY], v[strideY + 1], tx);
+  const float c01 = mg::mix(v[strideZ], v[strideZ + 1], tx);
+  const float c11 = mg::mix(v[strideZ + strideY], v[strideZ + strideY + 1], tx);
+  return mg::mix(mg::mix(c00, c10, ty), mg::mix(c01, c11, ty), tz);
+}
+
+static bool isInside(const glm::vec3 &position) {
+  return position.x >= 0 && position.x < 1.0f && position.y >= 0 && position.y < 1.0f && position.z >= 0 &&
+         position.z < 1.0f;
+}
+
+// replaces the front and back face rasterization in frontAndBack.glsl with a ray/box intersection in box space
+static BoxRay createBoxRay(const Frame &frame, uint32_t x, uint32_t y) {
+  const float ndcX = (float(x) + 0.5f) / float(frame.width) * 2.0f - 1.0f;
+  const float ndcY = 1.0f - (float(y) + 0.5f) / float(frame.height) * 2.0f;
+
+  auto nearPoint = frame.inverseViewProjection * glm::vec4{ndcX, ndcY, 0.0f, 1.0f};
+  auto farPoint = frame.inverseViewProjection * glm::vec4{ndcX, ndcY, 1.0f, 1.0f};
+  nearPoint /= nearPoint.w;
+  farPoint /= farPoint.w;
+
+  const auto origin = glm::vec3(frame.volume->worldToBox * nearPoint);
+  const auto direction = glm::vec3(frame.volume->worldToBox * farPoint) - origin;
+
+  const auto inverseDirection = 1.0f / direction;
+  const auto t0 = -origin * inverseDirection;
+  const auto t1 = (glm::vec3{1.0f} - origin) * inverseDirection;
+  const auto tmin = glm::min(t0, t1);
+  const auto tmax = glm::max(t0, t1);
+  const float enter = std::max(std::max(std::max(tmin.x, tmin.y), tmin.z), 0.0f);
+  const float exit = std::min(std::min(tmax.x, tmax.y), tmax.z);
+
+  BoxRay ray = {};
+  if (!(exit > enter))
+    return ray;
+
+  const auto start = origin + direction * enter;
+  const auto stop = origin + direction * exit;
+  ray.start = start;
+  ray.length = glm::length(stop - start);
+  ray.direction = (stop - start) / ray.length;
+  ray.valid = ray.length > 0.0f;
+  return ray;
+}
+
+static RayHit castRay(const CpuVolume &volume, const glm::vec3 &start, const glm::vec3 &direction, float length,
+                      float stepSize, float threshold, int32_t startStep) {
+  const float numOfSteps = length / stepSize;
+  glm::vec3 position = {};
+  for (int32_t i = startStep; float(i) < numOfSteps; i++) {
+    position = start + direction * float(i) * stepSize;
+    if (!isInside(position))
+      continue;
+    if (sampleVolume(volume, position) >= threshold)
+      return {position, true};
+  }
+  return {position, false};
+}
+
+static glm::vec3 binarySearch(const CpuVolume &volume, const glm::vec3 &position, const glm::vec3 &direction,
+                              float stepSize, float threshold) {
+  glm::vec3 left = position - direction * stepSize;
+  glm::vec3 right = position;
+  for (uint32_t i = 0; i < BINARY_SEARCH_STEPS; i++) {
+    const auto middle = (left + right) / 2.0f;
+    if (sampleVolume(volume, middle) > threshold)
+      right = middle;
+    else
+      left = middle;
+  }
+  return (right + left) / 2.0f;
+}
+
+static glm::vec3 computeGradient(const CpuVolume &volume, const glm::vec3 &position, const glm::vec3 &delta) {
+  glm::vec3 gradient;
+  gradient.x = sampleVolume(volume, position + glm::vec3{-delta.x, 0, 0}) -
+               sampleVolume(volume, position + glm::vec3{delta.x, 0, 0});
+  gradient.y = sampleVolume(volume, position + glm::vec3{0, -delta.y, 0}) -
+               sampleVolume(volume, position + glm::vec3{0, delta.y, 0});
+  gradient.z = sampleVolume(volume, position + glm::vec3{0, 0, -delta.z}) -
+               sampleVolume(volume, position + glm::vec3{0, 0, delta.z});
+  return gradient;
+}
+
+static glm::vec3 lightDirectionInBox(const Frame &frame, const glm::vec3 &position) {
+  const auto P = glm::vec3(frame.volume->boxToWorld * glm::vec4(position, 1.0f));
+  const auto L = glm::normalize(frame.cameraPosition - P);
+  return glm::normalize(frame.directionToBox * L);
+}
+
+// same pbr terms as pbr.hglsl, the light is placed at the camera
+static glm::vec3 shade(const Frame &frame, const glm::vec3 &position, const glm::vec3 &gradient, float shadow) {
+  constexpr float pi = 3.141592653589793f;
+  if (glm::length(gradient) == 0.0f)
+    return glm::vec3{0.0f};
+
+  const auto N = glm::normalize(frame.normalToWorld * gradient);
+  const auto P = glm::vec3(frame.volume->boxToWorld * glm::vec4(position, 1.0f));
+  const auto V = glm::normalize(frame.cameraPosition - P);
+  const auto L = glm::normalize(frame.cameraPosition - P);
+  const auto H = glm::normalize(L + V);
+
+  const float NdotL = glm::clamp(glm::dot(N, L), 0.001f, 1.0f);
+  const float NdotV = glm::clamp(std::abs(glm::dot(N, V)), 0.001f, 1.0f);
+  const float NdotH = glm::clamp(glm::dot(N, H), 0.0f, 1.0f);
+  const float VdotH = glm::clamp(glm::dot(V, H), 0.0f, 1.0f);
+
+  const float perceptualRoughness = 0.3f;
+  const float metallic = 0.1f;
+  const float alphaRoughness = perceptualRoughness * perceptualRoughness;
+
+  const glm::vec3 baseColor = {0.1f, 0.6f, 0.1f};
+  const glm::vec3 f0 = glm::vec3{0.04f};
+  const auto diffuseColor = baseColor * (glm::vec3{1.0f} - f0) * (1.0f - metallic);
+  const auto specularColor = glm::mix(f0, baseColor, metallic);
+  const auto reflectance0 = specularColor;
+  const auto reflectance90 = glm::vec3{1.0f};
+
+  const auto F = reflectance0 + (reflectance90 - reflectance0) * std::pow(glm::clamp(1.0f - VdotH, 0.0f, 1.0f), 5.0f);
+  const float r2 = alphaRoughness * alphaRoughness;
+  const float attenuationL = 2.0f * NdotL / (NdotL + std::sqrt(r2 + (1.0f - r2) * (NdotL * NdotL)));
+  const float attenuationV = 2.0f * NdotV / (NdotV + std::sqrt(r2 + (1.0f - r2) * (NdotV * NdotV)));
+  const float G = attenuationL * attenuationV;
+  const float f = (NdotH * r2 - NdotH) * NdotH + 1.0f;
+  const float D = r2 / (pi * f * f);
+
+  const auto diffuseContrib = (glm::vec3{1.0f} - F) * diffuseColor / pi;
+  const auto specContrib = F * G * D / (4.0f * NdotL * NdotV);
+
+  const glm::vec3 sky = glm::vec3{135.0f, 206.0f, 250.0f} / 255.0f;
+  const glm::vec3 ground = glm::vec3{87.0f, 59.0f, 12.0f} / 255.0f;
+  const glm::vec3 up = {0.0f, 0.0f, -1.0f};
+  const auto lightColor = glm::mix(ground, sky, 0.5f * glm::dot(N, up) + 0.5f);
+
+  return NdotL * lightColor * (diffuseContrib + specContrib) * shadow;
+}
+
+static void writePixel(CpuVolumeImage *image, uint32_t x, uint32_t y, const glm::vec3 &color) {
+  const auto gammaCorrected = glm::clamp(glm::pow(color, glm::vec3{0.45f}), 0.0f, 1.0f);
+  uint8_t *pixel = &image->rgba[(size_t(y) * image->width + x) * 4];
+  pixel[0] = uint8_t(gammaCorrected.r * 255.0f + 0.5f);
+  pixel[1] = uint8_t(gammaCorrected.g * 255.0f + 0.5f);
+  pixel[2] = uint8_t(gammaCorrected.b * 255.0f + 0.5f);
+  pixel[3] = 255;
+}
+
+static glm::vec3 renderPixel(const Frame &frame, const BoxRay &ray, TileStats *stats) {
+  const auto &volume = *frame.volume;
+  stats->nrOfPrimaryRays++;
+  const auto rayHit = castRay(volume, ray.start, ray.direction, ray.length, frame.stepSize, frame.threshold, 0);
+  if (!rayHit.hit)
+    return glm::vec3{0.0f};
+
+  const auto position = binarySearch(volume, rayHit.position, ray.direction, frame.stepSize, frame.threshold);
+  const auto gradient = computeGradient(volume, position, frame.delta);
+
+  stats->nrOfShadowRays++;
+  const auto boxL = lightDirectionInBox(frame, position);
+  const auto shadowHit = castRay(volume, position, boxL, frame.stepSize * SHADOW_RAY_STEPS, frame.stepSize,
+                                 frame.threshold, SHADOW_START_STEP);
+  return shade(frame, position, gradient, shadowHit.hit ? 0.3f : 1.0f);
+}
+
+static void renderTileScalar(const Frame &frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                             CpuVolumeImage *image, TileStats *stats) {
+  for (uint32_t y = y0; y < y1; y++) {
+    for (uint32_t x = x0; x < x1; x++) {
+      const auto ray = createBoxRay(frame, x, y);
+      writePixel(image, x, y, ray.valid ? renderPixel(frame, ray, stats) : glm::vec3{0.0f});
+    }
+  }
+}
+
+#if defined(__AVX2__)
+
+struct RayPacket {
+  __m256 ox, oy, oz;
+  __m256 dx, dy, dz;
+  __m256 numOfSteps;
+};
+
+struct PacketHit {
+  __m256 x, y, z;
+  __m256 hit;
+};
+
+static __m256 lerp8(__m256 a, __m256 b, __m256 t) { return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t)); }
+
+static __m256 texelCoordinate8(__m256 position, int32_t size) {
+  const __m256 coordinate = _mm256_sub_ps(_mm256_mul_ps(position, _mm256_set1_ps(float(size))), _mm256_set1_ps(0.5f));
+  const __m256 clamped = _mm256_max_ps(_mm256_min_ps(coordinate, _mm256_set1_ps(float(size) - 0.0001f)),
+                                       _mm256_set1_ps(-1.0f));
+  return _mm256_add_ps(clamped, _mm256_set1_ps(1.0f));
+}
+
+static __m256 sampleVolume8(const CpuVolume &volume, __m256 px, __m256 py, __m256 pz) {
+  const __m256 x = texelCoordinate8(px, volume.size.x);
+  const __m256 y = texelCoordinate8(py, volume.size.y);
+  const __m256 z = texelCoordinate8(pz, volume.size.z);
+  const __m256 fx = _mm256_floor_ps(x), fy = _mm256_floor_ps(y), fz = _mm256_floor_ps(z);
+  const __m256 tx = _mm256_sub_ps(x, fx), ty = _mm256_sub_ps(y, fy), tz = _mm256_sub_ps(z, fz);
+
+  const int32_t strideY = volume.paddedSize.x;
+  const int32_t strideZ = strideY * volume.paddedSize.y;
+  const __m256i index = _mm256_add_epi32(
+      _mm256_cvttps_epi32(fx),
+      _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(fy), _mm256_set1_epi32(strideY)),
+                       _mm256_mullo_epi32(_mm256_cvttps_epi32(fz), _mm256_set1_epi32(strideZ))));
+
+  const float *v = volume.voxels.data();
+  const auto gather = [v, index](int32_t offset) {
+    return _mm256_i32gather_ps(v, _mm256_add_epi32(index, _mm256_set1_epi32(offset)), sizeof(float));
+  };
+  const __m256 c00 = lerp8(gather(0), gather(1), tx);
+  const __m256 c10 = lerp8(gather(strideY), gather(strideY + 1), tx);
+  const __m256 c01 = lerp8(gather(strideZ), gather(strideZ + 1), tx);
+  const __m256 c11 = lerp8(gather(strideZ + strideY), gather(strideZ + strideY + 1), tx);
+  return lerp8(lerp8(c00, c10, ty), lerp8(c01, c11, ty), tz);
+}
+
+static __m256 isInside8(__m256 x, __m256 y, __m256 z) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 insideX = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ), _mm256_cmp_ps(x, one, _CMP_LT_OQ));
+  const __m256 insideY = _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_GE_OQ), _mm256_cmp_ps(y, one, _CMP_LT_OQ));
+  const __m256 insideZ = _mm256_and_ps(_mm256_cmp_ps(z, zero, _CMP_GE_OQ), _mm256_cmp_ps(z, one, _CMP_LT_OQ));
+  return _mm256_and_ps(insideX, _mm256_and_ps(insideY, insideZ));
+}
+
+// marches 8 rays in lock step, lanes are retired when they hit the iso-surface or run out of steps
+static PacketHit castRay8(const CpuVolume &volume, const RayPacket &ray, __m256 active, float stepSize,
+                          float threshold, int32_t startStep) {
+  const __m256 vthreshold = _mm256_set1_ps(threshold);
+  const __m256 vstepSize = _mm256_set1_ps(stepSize);
+  PacketHit res = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+  for (int32_t i = startStep; _mm256_movemask_ps(active); i++) {
+    const __m256 step = _mm256_set1_ps(float(i));
+    active = _mm256_and_ps(active, _mm256_cmp_ps(step, ray.numOfSteps, _CMP_LT_OQ));
+
+    const __m256 x = _mm256_add_ps(ray.ox, _mm256_mul_ps(_mm256_mul_ps(ray.dx, step), vstepSize));
+    const __m256 y = _mm256_add_ps(ray.oy, _mm256_mul_ps(_mm256_mul_ps(ray.dy, step), vstepSize));
+    const __m256 z = _mm256_add_ps(ray.oz, _mm256_mul_ps(_mm256_mul_ps(ray.dz, step), vstepSize));
+    const __m256 inside = _mm256_and_ps(active, isInside8(x, y, z));
+    if (!_mm256_movemask_ps(inside))
+      continue;
+
+    const __m256 value = sampleVolume8(volume, x, y, z);
+    const __m256 hit = _mm256_and_ps(inside, _mm256_cmp_ps(value, vthreshold, _CMP_GE_OQ));
+    res.x = _mm256_blendv_ps(res.x, x, hit);
+    res.y = _mm256_blendv_ps(res.y, y, hit);
+    res.z = _mm256_blendv_ps(res.z, z, hit);
+    res.hit = _mm256_or_ps(res.hit, hit);
+    active = _mm256_andnot_ps(hit, active);
+  }
+  return res;
+}
+
+static void renderTileSimd(const Frame &frame, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                           CpuVolumeImage *image, TileStats *stats) {
+  const auto &volume = *frame.volume;
+
+  alignas(32) float ox[SIMD_NR_FLOATS], oy[SIMD_NR_FLOATS], oz[SIMD_NR_FLOATS];
+  alignas(32) float dx[SIMD_NR_FLOATS], dy[SIMD_NR_FLOATS], dz[SIMD_NR_FLOATS];
+  alignas(32) float numOfSteps[SIMD_NR_FLOATS];
+  alignas(32) float hx[SIMD_NR_FLOATS], hy[SIMD_NR_FLOATS], hz[SIMD_NR_FLOATS];
+  alignas(32) int32_t active[SIMD_NR_FLOATS];
+  glm::vec3 positions[SIMD_NR_FLOATS], gradients[SIMD_NR_FLOATS];
+
+  for (uint32_t y = y0; y < y1; y++) {
+    for (uint32_t x = x0; x < x1; x += SIMD_NR_FLOATS) {
+      // primary rays
+      for (uint32_t lane = 0; lane < SIMD_NR_FLOATS; lane++) {
+        const auto ray = (x + lane < x1) ? createBoxRay(frame, x + lane, y) : BoxRay{};
+        ox[lane] = ray.start.x, oy[lane] = ray.start.y, oz[lane] = ray.start.z;
+        dx[lane] = ray.direction.x, dy[lane] = ray.direction.y, dz[lane] = ray.direction.z;
+        numOfSteps[lane] = ray.valid ? ray.length / frame.stepSize : 0.0f;
+        active[lane] = ray.valid ? -1 : 0;
+        stats->nrOfPrimaryRays += ray.valid;
+      }
+      RayPacket packet = {_mm256_load_ps(ox), _mm256_load_ps(oy), _mm256_load_ps(oz),        _mm256_load_ps(dx),
+                          _mm256_load_ps(dy), _mm256_load_ps(dz), _mm256_load_ps(numOfSteps)};
+      const __m256 activeMask = _mm256_castsi256_ps(_mm256_load_si256((const __m256i *)active));
+      const auto primaryHit = castRay8(volume, packet, activeMask, frame.stepSize, frame.threshold, 0);
+      const int32_t primaryHitMask = _mm256_movemask_ps(primaryHit.hit);
+
+      // refine the hits and set up the shadow rays
+      _mm256_store_ps(hx, primaryHit.x);
+      _mm256_store_ps(hy, primaryHit.y);
+      _mm256_store_ps(hz, primaryHit.z);
+      for (uint32_t lane = 0; lane < SIMD_NR_FLOATS; lane++) {
+        if (!(primaryHitMask & (1 << lane)))
+          continue;
+        const glm::vec3 direction = {dx[lane], dy[lane], dz[lane]};
+        positions[lane] =
+            binarySearch(volume, glm::vec3{hx[lane], hy[lane], hz[lane]}, direction, frame.stepSize, frame.threshold);
+        gradients[lane] = computeGradient(volume, positions[lane], frame.delta);
+
+        const auto boxL = lightDirectionInBox(frame, positions[lane]);
+        ox[lane] = positions[lane].x, oy[lane] = positions[lane].y, oz[lane] = positions[lane].z;
+        dx[lane] = boxL.x, dy[lane] = boxL.y, dz[lane] = boxL.z;
+        numOfSteps[lane] = (frame.stepSize * SHADOW_RAY_STEPS) / frame.stepSize;
+        stats->nrOfShadowRays++;
+      }
+
+      PacketHit shadowHit = {};
+      if (primaryHitMask) {
+        packet = {_mm256_load_ps(ox), _mm256_load_ps(oy), _mm256_load_ps(oz),        _mm256_load_ps(dx),
+                  _mm256_load_ps(dy), _mm256_load_ps(dz), _mm256_load_ps(numOfSteps)};
+        shadowHit = castRay8(volume, packet, primaryHit.hit, frame.stepSize, frame.threshold, SHADOW_START_STEP);
+      }
+      const int32_t shadowHitMask = primaryHitMask ? _mm256_movemask_ps(shadowHit.hit) : 0;
+
+      for (uint32_t lane = 0; lane < SIMD_NR_FLOATS && x + lane < x1; lane++) {
+        glm::vec3 color = glm::vec3{0.0f};
+        if (primaryHitMask & (1 << lane)) {
+          const float shadow = (shadowHitMask & (1 << lane)) ? 0.3f : 1.0f;
+          color = shade(frame, positions[lane], gradients[lane], shadow);
+        }
+        writePixel(image, x + lane, y, color);
+      }
+    }
+  }
+}
+
+#endif
+
+CpuVolumeRenderStats renderVolumeCpu(const CpuVolume &volume, const CpuVolumeRenderInfo &renderInfo,
+                                     CpuVolumeImage *image) {
+  mgAssert(image);
+  mgAssert(renderInfo.width && renderInfo.height);
+  mgAssert(renderInfo.stepSize > 0.0f);
+
+  const auto startTime = std::chrono::high_resolution_clock::now();
+
+  Frame frame = {};
+  frame.volume = &volume;
+  frame.inverseViewProjection = glm::inverse(renderInfo.projection * renderInfo.view);
+  frame.normalToWorld = glm::transpose(glm::inverse(glm::mat3(volume.boxToWorld)));
+  frame.directionToBox = glm::inverse(glm::transpose(glm::mat3(volume.worldToBox)));
+  frame.cameraPosition = renderInfo.cameraPosition;
+  frame.delta = 1.0f / glm::vec3(volume.size);
+  frame.stepSize = renderInfo.stepSize;
+  frame.threshold = mg::reinterval(renderInfo.isoValue, volume.min, volume.max, 0.0f, 1.0f);
+  frame.width = renderInfo.width;
+  frame.height = renderInfo.height;
+
+  image->width = renderInfo.width;
+  image->height = renderInfo.height;
+  image->rgba.resize(size_t(image->width) * image->height * 4);
+
+  auto renderTile = renderTileScalar;
+#if defined(__AVX2__)
+  if (renderInfo.useSimd)
+    renderTile = renderTileSimd;
+#endif
+
+  const uint32_t nrOfTilesX = (renderInfo.width + TILE_SIZE - 1) / TILE_SIZE;
+  const uint32_t nrOfTilesY = (renderInfo.height + TILE_SIZE - 1) / TILE_SIZE;
+  const uint32_t nrOfTiles = nrOfTilesX * nrOfTilesY;
+  std::vector<TileStats> threadStats(renderInfo.workers->nrOfThreads());
+  renderInfo.workers->parallelFor(nrOfTiles, 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex) {
+    for (uint32_t tile = begin; tile < end; tile++) {
+      const uint32_t x0 = (tile % nrOfTilesX) * TILE_SIZE;
+      const uint32_t y0 = (tile / nrOfTilesX) * TILE_SIZE;
+      const uint32_t x1 = std::min(x0 + TILE_SIZE, renderInfo.width);
+      const uint32_t y1 = std::min(y0 + TILE_SIZE, renderInfo.height);
+      renderTile(frame, x0, y0, x1, y1, image, &threadStats[threadIndex]);
+    }
+  });
+
+  CpuVolumeRenderStats stats = {};
+  for (const auto &threadStat : threadStats) {
+    stats.nrOfPrimaryRays += threadStat.nrOfPrimaryRays;
+    stats.nrOfShadowRays += threadStat.nrOfShadowRays;
+  }
+  const auto endTime = std::chrono::high_resolution_clock::now();
+  stats.ms = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+  stats.raysPerSecond = double(stats.nrOfPrimaryRays + stats.nrOfShadowRays) / (stats.ms / 1000.0);
+  return stats;
+}
+
+uint32_t compareCpuVolumeImages(const CpuVolumeImage &a, const CpuVolumeImage &b, uint8_t tolerance) {
+  mgAssert(a.width == b.width && a.height == b.height);
+  mgAssert(a.rgba.size() == b.rgba.size());
+  uint32_t nrOfDifferentPixels = 0;
+  for (size_t i = 0; i < a.rgba.size(); i += 4) {
+    bool different = false;
+    for (size_t c = 0; c < 4; c++)
+      different |= std::abs(int32_t(a.rgba[i + c]) - int32_t(b.rgba[i + c])) > tolerance;
+    nrOfDifferentPixels += different;
+  }
+  return nrOfDifferentPixels;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct VolumeData;
+namespace mg {
+class WorkerPool;
+}
+
+// Cpu version of the iso-surface ray caster in volume.glsl, used for headless golden image tests,
+// benchmarking and as a fallback renderer when no gpu is available.
+struct CpuVolume {
+  // voxels normalized with the volume min/max, padded with one voxel of border color on each side
+  std::vector<float> voxels;
+  glm::ivec3 size;
+  glm::ivec3 paddedSize;
+  glm::mat4 boxToWorld, worldToBox;
+  float min, max;
+};
+
+struct CpuVolumeRenderInfo {
+  uint32_t width, height;
+  glm::mat4 projection, view;
+  glm::vec3 cameraPosition;
+  float isoValue;
+  float stepSize;
+  mg::WorkerPool *workers; // the tiles are spread over its threads
+  bool useSimd;
+};
+
+struct CpuVolumeImage {
+  uint32_t width, height;
+  std::vector<uint8_t> rgba;
+};
+
+struct CpuVolumeRenderStats {
+  uint64_t nrOfPrimaryRays;
+  uint64_t nrOfShadowRays;
+  double ms;
+  double raysPerSecond;
+};
+
+CpuVolume createCpuVolume(const VolumeData &volumeData, const std::vector<uint16_t> &voxels);
+CpuVolumeRenderStats renderVolumeCpu(const CpuVolume &volume, const CpuVolumeRenderInfo &renderInfo,
+                                     CpuVolumeImage *image);
+
+// number of pixels where any channel differs more than tolerance
+uint32_t compareCpuVolumeImages(const CpuVolumeImage &a, const CpuVolumeImage &b, uint8_t tolerance);
@@ -0,0 +1,43 @@
+#include "volume_data.h"
+#include "mg/mgUtils.h"
+#include <algorithm>
+#include <fstream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <limits>
+
+std::vector<uint16_t> readDatFile(VolumeData *volumeData) {
+  const auto filePath = mg::getDataPath() + "stagbeetle_dat/stagbeetle277x277x164.dat";
+  auto stream = std::ifstream(filePath, std::fstream::binary);
+  uint16_t sizeX, sizeY, sizeZ;
+  stream.read((char *)&sizeX, sizeof(uint16_t));
+  stream.read((char *)&sizeY, sizeof(uint16_t));
+  stream.read((char *)&sizeZ, sizeof(uint16_t));
+
+  std::vector<uint16_t> data(sizeX * sizeY * sizeZ);
+  stream.read((char *)data.data(), mg::sizeofContainerInBytes(data));
+
+  *volumeData = {};
+  volumeData->corner = {0, 0, 0};
+  volumeData->voxelSize = {1, 1, 1};
+  volumeData->nrOfVoxels = {277, 277, 164};
+  volumeData->min = std::numeric_limits<uint16_t>::max();
+  volumeData->max = std::numeric_limits<uint16_t>::min();
+  volumeData->size = {
+      volumeData->nrOfVoxels.x * volumeData->voxelSize.x,
+      volumeData->nrOfVoxels.y * volumeData->voxelSize.y,
+      volumeData->nrOfVoxels.z * volumeData->voxelSize.z,
+  };
+  for (uint32_t i = 0; i < uint32_t(data.size()); i++) {
+    volumeData->min = std::min(volumeData->min, data[i]);
+    volumeData->max = std::max(volumeData->max, data[i]);
+  }
+  return data;
+}
+
+glm::mat4 worldToBoxMatrix(const VolumeData &volumeData) { return glm::inverse(boxToWorldMatrix(volumeData)); }
+
+glm::mat4 boxToWorldMatrix(const VolumeData &volumeData) {
+  const auto scale = glm::scale(glm::mat4{1}, volumeData.size);
+  const auto transform = glm::translate(glm::mat4{1}, volumeData.corner);
+  return transform * scale;
+}
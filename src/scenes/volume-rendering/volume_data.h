@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// the voxel grid of the stag beetle, shared by the gpu scene and the headless cpu renderer
+struct VolumeData {
+  glm::vec3 corner;
+  glm::ivec3 nrOfVoxels;
+  glm::vec3 voxelSize;
+  glm::vec3 size;
+  uint16_t min, max;
+};
+
+// reads the voxels from disc
+std::vector<uint16_t> readDatFile(VolumeData *volumeData);
+
+glm::mat4 worldToBoxMatrix(const VolumeData &volumeData);
+glm::mat4 boxToWorldMatrix(const VolumeData &volumeData);
@@ -4,6 +4,9 @@
 #include "mg/mgSystem.h"
 #include "mg/window.h"
 #include "rendering/rendering.h"
+#include "shaders/denoise.h"
+#include "shaders/frontAndBack.h"
+#include "shaders/volume.h"
 #include "volume_renderpass.h"
 #include "volume_utils.h"
 
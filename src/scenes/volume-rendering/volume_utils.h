@@ -1,18 +1,13 @@
 #pragma once
+#include "volume_data.h"
 #include <glm/glm.hpp>
 #include <mg/textureContainer.h>
 #include <mg/meshUtils.h>
+#include <vector>
 
-struct VolumeInfo {
-  glm::vec3 corner;
-  glm::ivec3 nrOfVoxels;
-  glm::vec3 voxelSize;
-  glm::vec3 size;
-  uint16_t min, max;
+struct VolumeInfo : VolumeData {
   mg::TextureId textureId;
 };
 
+// reads the voxels and uploads them into a 3d texture
 VolumeInfo parseDatFile();
-
-glm::mat4 worldToBoxMatrix(const VolumeInfo &volumeInfo);
-glm::mat4 boxToWorldMatrix(const VolumeInfo &volumeInfo);
@@ -0,0 +1,66 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+// The bumpy sphere and the cameras around it of mg-meshlet-bench and the meshlets test.
+
+namespace fixtures {
+
+constexpr uint32_t NR_OF_FLOATS = 3;
+
+struct Mesh {
+  std::vector<float> vertices;
+  std::vector<uint32_t> indices;
+  glm::vec3 position(uint32_t vertex) const {
+    return {vertices[vertex * NR_OF_FLOATS], vertices[vertex * NR_OF_FLOATS + 1], vertices[vertex * NR_OF_FLOATS + 2]};
+  }
+};
+
+// a unit sphere with bumps, the triangles wind counter clockwise seen from outside
+inline Mesh createMesh(uint32_t rings) {
+  Mesh mesh;
+  const uint32_t segments = rings * 2;
+  for (uint32_t r = 0; r <= rings; r++) {
+    for (uint32_t s = 0; s <= segments; s++) {
+      const float theta = glm::pi<float>() * r / rings, phi = glm::two_pi<float>() * s / segments;
+      const float radius = 1.0f + 0.05f * std::sin(theta * 13.0f) * std::cos(phi * 7.0f);
+      mesh.vertices.insert(mesh.vertices.end(), {radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta),
+                                                 -radius * std::sin(theta) * std::sin(phi)});
+    }
+  }
+  for (uint32_t r = 0; r < rings; r++) {
+    for (uint32_t s = 0; s < segments; s++) {
+      const uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+      mesh.indices.insert(mesh.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+    }
+  }
+  return mesh;
+}
+
+struct Cameras {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::mat4> viewProjections;
+};
+
+// cameras outside of the sphere looking at its center
+inline Cameras createCameras(uint32_t nrOfCameras) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  Cameras cameras;
+  const auto projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  while (cameras.positions.size() < nrOfCameras) {
+    const glm::vec3 direction = {unit(random), unit(random), unit(random)};
+    if (glm::length(direction) < 0.1f || glm::length(direction) > 1.0f)
+      continue;
+    cameras.positions.push_back(glm::normalize(direction) * (1.5f + 2.0f * std::abs(unit(random))));
+    const glm::vec3 aim = {0.5f * unit(random), 0.5f * unit(random), 0.5f * unit(random)};
+    cameras.viewProjections.push_back(projection * glm::lookAt(cameras.positions.back(), aim, glm::vec3(0, 1, 0)));
+  }
+  return cameras;
+}
+
+} // namespace fixtures
@@ -0,0 +1,193 @@
+#pragma once
+#include "mg/frustumCulling.h"
+#include "mg/geometryQueries.h"
+#include "mg/geometryUtils.h"
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+// The random elements and queries of mg-geometry-bench and the geometry-queries test, and a runner that calls the
+// kernels with the inputs the public functions pass to them.
+
+namespace fixtures {
+
+struct Spheres {
+  std::vector<float> x, y, z, radius;
+  mg::SphereArrays arrays() const { return {x.data(), y.data(), z.data(), radius.data(), uint32_t(x.size())}; }
+  glm::vec3 center(uint32_t i) const { return {x[i], y[i], z[i]}; }
+};
+
+struct Aabbs {
+  std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+  mg::AabbArrays arrays() const {
+    return {minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data(), uint32_t(minX.size())};
+  }
+  glm::vec3 minimum(uint32_t i) const { return {minX[i], minY[i], minZ[i]}; }
+  glm::vec3 maximum(uint32_t i) const { return {maxX[i], maxY[i], maxZ[i]}; }
+};
+
+struct Triangles {
+  std::vector<float> x1, y1, z1, x2, y2, z2, x3, y3, z3;
+  mg::TriangleArrays arrays() const {
+    return {x1.data(), y1.data(), z1.data(), x2.data(), y2.data(),
+            z2.data(), x3.data(), y3.data(), z3.data(), uint32_t(x1.size())};
+  }
+  mg::Triangle triangle(uint32_t i) const {
+    return {{x1[i], y1[i], z1[i]}, {x2[i], y2[i], z2[i]}, {x3[i], y3[i], z3[i]}};
+  }
+};
+
+struct Queries {
+  std::vector<mg::Ray> rays;
+  std::vector<mg::Frustum> frustums;
+  std::vector<mg::Plane> planes;
+  std::vector<glm::vec4> spheres;
+};
+
+struct Scene {
+  Spheres spheres;
+  Aabbs aabbs;
+  Triangles triangles;
+  Queries queries;
+};
+
+// the result of one query with one instruction set
+struct Result {
+  std::vector<uint32_t> mask, secondMask;
+  std::vector<float> distances;
+  bool operator==(const Result &other) const {
+    // memcmp so NaN distances would compare too, the kernels never write them
+    return mask == other.mask && secondMask == other.secondMask && distances.size() == other.distances.size() &&
+           std::memcmp(distances.data(), other.distances.data(), distances.size() * sizeof(float)) == 0;
+  }
+};
+
+enum class QUERY { RAY_SPHERES, RAY_AABBS, RAY_TRIANGLES, FRUSTUM_SPHERES, FRUSTUM_AABBS, CLASSIFY_SPHERES,
+                    SPHERE_SPHERES, SIZE };
+inline const char *queryNames[] = {"ray spheres",    "ray aabbs",        "ray triangles", "frustum spheres",
+                                   "frustum aabbs", "classify spheres", "sphere spheres"};
+static_assert(sizeof(queryNames) / sizeof(queryNames[0]) == size_t(QUERY::SIZE), "missing query name");
+
+inline mg::QueryRay toQueryRay(const mg::Ray &ray) {
+  const auto inverseDirection = 1.0f / ray.direction;
+  return {{ray.origin.x, ray.origin.y, ray.origin.z},
+          {ray.direction.x, ray.direction.y, ray.direction.z},
+          {inverseDirection.x, inverseDirection.y, inverseDirection.z},
+          ray.maxDistance};
+}
+
+// runs query number q of a kind, result keeps its buffers between runs so the bench timings have no allocations
+inline void runQuery(const mg::GeometryQueryKernels &kernels, const Scene &scene, QUERY query, uint32_t q,
+                     Result *result) {
+  const auto &queries = scene.queries;
+  const auto words = [](uint32_t size) { return mg::bitmaskWords(size); };
+  switch (query) {
+  case QUERY::RAY_SPHERES:
+    result->mask.resize(words(uint32_t(scene.spheres.x.size())));
+    result->distances.resize(scene.spheres.x.size());
+    kernels.raySpheres(toQueryRay(queries.rays[q]), scene.spheres.arrays(), result->mask.data(),
+                       result->distances.data());
+    break;
+  case QUERY::RAY_AABBS:
+    result->mask.resize(words(uint32_t(scene.aabbs.minX.size())));
+    result->distances.resize(scene.aabbs.minX.size());
+    kernels.rayAabbs(toQueryRay(queries.rays[q]), scene.aabbs.arrays(), result->mask.data(),
+                     result->distances.data());
+    break;
+  case QUERY::RAY_TRIANGLES:
+    result->mask.resize(words(uint32_t(scene.triangles.x1.size())));
+    result->distances.resize(scene.triangles.x1.size());
+    kernels.rayTriangles(toQueryRay(queries.rays[q]), scene.triangles.arrays(), result->mask.data(),
+                         result->distances.data());
+    break;
+  case QUERY::FRUSTUM_SPHERES:
+    result->mask.resize(words(uint32_t(scene.spheres.x.size())));
+    kernels.frustumSpheres(&queries.frustums[q].planes[0].x, scene.spheres.arrays(), result->mask.data());
+    break;
+  case QUERY::FRUSTUM_AABBS:
+    result->mask.resize(words(uint32_t(scene.aabbs.minX.size())));
+    kernels.frustumAabbs(&queries.frustums[q].planes[0].x, scene.aabbs.arrays(), result->mask.data());
+    break;
+  case QUERY::CLASSIFY_SPHERES: {
+    const auto &plane = queries.planes[q];
+    const float normalDistance[4] = {plane.normal.x, plane.normal.y, plane.normal.z,
+                                     glm::dot(plane.position, plane.normal)};
+    result->mask.resize(words(uint32_t(scene.spheres.x.size())));
+    result->secondMask.resize(result->mask.size());
+    kernels.classifySpheres(normalDistance, scene.spheres.arrays(), result->mask.data(), result->secondMask.data());
+    break;
+  }
+  case QUERY::SPHERE_SPHERES:
+    result->mask.resize(words(uint32_t(scene.spheres.x.size())));
+    kernels.sphereSpheres(&queries.spheres[q].x, scene.spheres.arrays(), result->mask.data());
+    break;
+  default:
+    break;
+  }
+}
+
+inline Result runQuery(const mg::GeometryQueryKernels &kernels, const Scene &scene, QUERY query, uint32_t q) {
+  Result result;
+  runQuery(kernels, scene, query, q, &result);
+  return result;
+}
+
+inline Scene createScene(uint32_t nrOfElements, uint32_t nrOfQueries) {
+  Scene scene;
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> size(0.1f, 5.0f);
+  std::uniform_real_distribution<float> offset(-5.0f, 5.0f);
+  const auto randomPosition = [&] { return glm::vec3(position(generator), position(generator), position(generator)); };
+  const auto randomOffset = [&] { return glm::vec3(offset(generator), offset(generator), offset(generator)); };
+  const auto randomDirection = [&] {
+    glm::vec3 direction;
+    do {
+      direction = randomOffset();
+    } while (glm::length(direction) < 0.1f);
+    return glm::normalize(direction);
+  };
+
+  for (uint32_t i = 0; i < nrOfElements; i++) {
+    const auto center = randomPosition();
+    scene.spheres.x.push_back(center.x);
+    scene.spheres.y.push_back(center.y);
+    scene.spheres.z.push_back(center.z);
+    scene.spheres.radius.push_back(size(generator));
+
+    const auto minimum = randomPosition();
+    const glm::vec3 maximum = minimum + glm::vec3(size(generator), size(generator), size(generator));
+    scene.aabbs.minX.push_back(minimum.x);
+    scene.aabbs.minY.push_back(minimum.y);
+    scene.aabbs.minZ.push_back(minimum.z);
+    scene.aabbs.maxX.push_back(maximum.x);
+    scene.aabbs.maxY.push_back(maximum.y);
+    scene.aabbs.maxZ.push_back(maximum.z);
+
+    const auto p1 = randomPosition(), p2 = p1 + randomOffset(), p3 = p1 + randomOffset();
+    auto &t = scene.triangles;
+    t.x1.push_back(p1.x), t.y1.push_back(p1.y), t.z1.push_back(p1.z);
+    t.x2.push_back(p2.x), t.y2.push_back(p2.y), t.z2.push_back(p2.z);
+    t.x3.push_back(p3.x), t.y3.push_back(p3.y), t.z3.push_back(p3.z);
+  }
+
+  for (uint32_t q = 0; q < nrOfQueries; q++) {
+    // half of the rays are aimed at an element so there are hits
+    const auto origin = randomPosition();
+    const auto target = q % 2 ? scene.spheres.center(q % nrOfElements) : origin + randomDirection();
+    const auto direction = glm::length(target - origin) > 0.0f ? glm::normalize(target - origin) : randomDirection();
+    scene.queries.rays.push_back({origin, direction, 400.0f});
+
+    const auto eye = randomPosition();
+    const auto view = glm::lookAt(eye, eye + randomDirection(), glm::vec3(0, 1, 0));
+    const auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    scene.queries.frustums.push_back(mg::createFrustum(projection * view));
+
+    scene.queries.planes.push_back({randomPosition(), randomDirection()});
+    scene.queries.spheres.push_back({randomPosition(), 20.0f * size(generator)});
+  }
+  return scene;
+}
+
+} // namespace fixtures
@@ -0,0 +1,56 @@
+#include "mg/logger.h"
+#include "tests.h"
+#include <cstring>
+#include <string>
+
+// Runs the cpu reference checks, ctest runs every test on its own.
+// mg-tests [test name], without a name all tests run
+// Returns 1 when a check fails.
+
+namespace {
+
+// a check in a loop can fail for many elements, the ones after these are only counted
+constexpr uint32_t maxLoggedFailures = 32;
+uint32_t nrOfLoggedFailures = 0;
+
+struct Test {
+  const char *name;
+  uint32_t (*run)();
+};
+
+const Test tests[] = {
+    {"frustum-culling", testFrustumCulling},
+    {"geometry-queries", testGeometryQueries},
+    {"instance-culling", testInstanceCulling},
+    {"light-clusters", testLightClusters},
+    {"memory", testMemory},
+    {"mesh-simplification", testMeshSimplification},
+    {"meshlets", testMeshlets},
+};
+
+} // namespace
+
+uint32_t checkCondition(bool condition, const char *expression, const char *file, int line) {
+  if (condition)
+    return 0;
+  if (nrOfLoggedFailures++ < maxLoggedFailures)
+    mg::logInfo((std::string("check failed: ") + expression).c_str(), file, line);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  uint32_t nrOfTests = 0, nrOfFailures = 0;
+  for (const auto &test : tests) {
+    if (argc > 1 && std::strcmp(argv[1], test.name) != 0)
+      continue;
+    const uint32_t failures = test.run();
+    LOG(test.name << ": " << failures << " failures");
+    nrOfFailures += failures;
+    nrOfTests++;
+  }
+  if (nrOfTests == 0) {
+    LOG("unknown test " << argv[1]);
+    return 1;
+  }
+  return nrOfFailures == 0 ? 0 : 1;
+}
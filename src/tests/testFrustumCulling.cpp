@@ -0,0 +1,94 @@
+#include "mg/frustumCulling.h"
+#include "mg/logger.h"
+#include "tests.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Checks the cpu frustum culling that cullDraws.comp follows: the planes of createFrustum bound the clip space box,
+// cullSpheres keeps the same spheres as isSphereInFrustum in ascending order, and computeMeshBounds contains its
+// vertices.
+
+namespace {
+
+constexpr float epsilon = 1e-3f;
+
+glm::vec3 unproject(const glm::mat4 &inverseViewProjection, const glm::vec3 &ndc) {
+  const auto position = inverseViewProjection * glm::vec4(ndc, 1.0f);
+  return glm::vec3(position) / position.w;
+}
+
+} // namespace
+
+uint32_t testFrustumCulling() {
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f), ndc(-1.0f, 1.0f), position(-100.0f, 100.0f);
+  const auto randomPosition = [&] { return glm::vec3(position(generator), position(generator), position(generator)); };
+  uint32_t failures = 0, nrOfVisible = 0, nrOfSpheres = 0;
+
+  for (uint32_t camera = 0; camera < 64; camera++) {
+    const auto eye = randomPosition();
+    const auto view = glm::lookAt(eye, randomPosition(), glm::vec3(0, 1, 0));
+    const auto viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f) * view;
+    const auto inverseViewProjection = glm::inverse(viewProjection);
+    const auto frustum = mg::createFrustum(viewProjection);
+    for (const auto &plane : frustum.planes)
+      failures += CHECK(std::abs(glm::length(glm::vec3(plane)) - 1.0f) <= epsilon);
+
+    // points in the clip space box are inside, points beyond one of its sides are not
+    for (uint32_t i = 0; i < 256; i++) {
+      const glm::vec3 inside = {ndc(generator) * 0.99f, ndc(generator) * 0.99f, ndc(generator) * 0.99f};
+      failures += CHECK(mg::isSphereInFrustum(frustum, glm::vec4(unproject(inverseViewProjection, inside), 0.0f)));
+      auto outside = inside;
+      outside[i % 3] = (i & 4 ? 1.0f : -1.0f) * (1.01f + unit(generator));
+      failures += CHECK(!mg::isSphereInFrustum(frustum, glm::vec4(unproject(inverseViewProjection, outside), 0.0f)));
+    }
+
+    // a sphere outside of a plane is culled when its radius does not reach the plane, one around a point inside is not
+    for (uint32_t i = 0; i < 64; i++) {
+      const auto &plane = frustum.planes[i % 6];
+      const glm::vec3 inside = {ndc(generator) * 0.5f, ndc(generator) * 0.5f, ndc(generator) * 0.5f};
+      const auto point = unproject(inverseViewProjection, inside);
+      const float distance = glm::dot(glm::vec3(plane), point) + plane.w;
+      const float offset = distance + 1.0f + 10.0f * unit(generator);
+      const auto center = point - glm::vec3(plane) * offset;
+      failures += CHECK(!mg::isSphereInFrustum(frustum, glm::vec4(center, offset - distance - epsilon)));
+      failures += CHECK(mg::isSphereInFrustum(frustum, glm::vec4(center, offset * (1.0f + epsilon))));
+    }
+
+    // the four wide path and the tail give the spheres of isSphereInFrustum
+    const uint32_t nrOfBounds = 1 + camera * 13;
+    std::vector<mg::MeshBounds> bounds(nrOfBounds);
+    for (auto &b : bounds)
+      b.sphere = glm::vec4(randomPosition(), 20.0f * unit(generator));
+    std::vector<uint32_t> visible(nrOfBounds), expected;
+    visible.resize(mg::cullSpheres(frustum, bounds.data(), nrOfBounds, visible.data()));
+    for (uint32_t i = 0; i < nrOfBounds; i++) {
+      if (mg::isSphereInFrustum(frustum, bounds[i].sphere))
+        expected.push_back(i);
+    }
+    failures += CHECK(visible == expected);
+    nrOfVisible += uint32_t(visible.size());
+    nrOfSpheres += nrOfBounds;
+  }
+
+  // the vertices have a normal after the position, the bounds are the box of the positions and a sphere around it
+  std::vector<float> vertices;
+  for (uint32_t i = 0; i < 1000; i++) {
+    const auto p = randomPosition();
+    vertices.insert(vertices.end(), {p.x, p.y, p.z, 0.0f, 1.0f, 0.0f});
+  }
+  const uint32_t nrOfVertices = uint32_t(vertices.size() / 6);
+  const auto meshBounds = mg::computeMeshBounds(vertices.data(), nrOfVertices, 6 * sizeof(float));
+  glm::vec3 minimum(1e30f), maximum(-1e30f);
+  for (uint32_t i = 0; i < nrOfVertices; i++) {
+    const glm::vec3 p = {vertices[i * 6], vertices[i * 6 + 1], vertices[i * 6 + 2]};
+    minimum = glm::min(minimum, p);
+    maximum = glm::max(maximum, p);
+    failures += CHECK(glm::distance(glm::vec3(meshBounds.sphere), p) <= meshBounds.sphere.w * (1.0f + epsilon));
+  }
+  failures += CHECK(glm::vec3(meshBounds.minimum) == minimum && glm::vec3(meshBounds.maximum) == maximum);
+
+  LOG("frustum culling: " << nrOfVisible << " of " << nrOfSpheres << " spheres in the frustum");
+  return failures;
+}
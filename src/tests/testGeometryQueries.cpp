@@ -0,0 +1,137 @@
+#include "geometryQueryScene.h"
+#include "mg/logger.h"
+#include "tests.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Checks the scalar geometry query kernels against the scalar functions of geometryUtils and frustumCulling, and
+// that every instruction set the cpu supports gives the same bits and distances as the scalar kernels.
+
+namespace {
+
+using fixtures::QUERY;
+using fixtures::Scene;
+using fixtures::runQuery;
+
+// Compares the scalar kernels with the scalar functions the engine already had, and checks properties of the queries
+// with none. Returns the number of elements that fail.
+uint32_t checkScalar(const Scene &scene, uint32_t q) {
+  const auto &kernels = *mg::getGeometryQueryKernels(mg::GEOMETRY_ISA::SCALAR);
+  const auto &spheres = scene.spheres;
+  const auto &aabbs = scene.aabbs;
+  const uint32_t n = uint32_t(spheres.x.size());
+  const auto &ray = scene.queries.rays[q];
+  const auto &frustum = scene.queries.frustums[q];
+  const auto &plane = scene.queries.planes[q];
+  const auto &sphere = scene.queries.spheres[q];
+  uint32_t failures = 0;
+
+  const auto frustumSpheres = runQuery(kernels, scene, QUERY::FRUSTUM_SPHERES, q);
+  for (uint32_t i = 0; i < n; i++)
+    failures += CHECK(mg::isBitSet(frustumSpheres.mask.data(), i) ==
+                      mg::isSphereInFrustum(frustum, glm::vec4(spheres.center(i), spheres.radius[i])));
+
+  // straddling is intersectionPlaneSpheres, and front or back is farther from the plane than the radius
+  const auto classify = runQuery(kernels, scene, QUERY::CLASSIFY_SPHERES, q);
+  std::vector<glm::vec3> centers;
+  for (uint32_t i = 0; i < n; i++)
+    centers.push_back(spheres.center(i));
+  const auto intersected = mg::intersectionPlaneSpheres(plane, centers, spheres.radius);
+  for (uint32_t i = 0; i < n; i++) {
+    const bool front = mg::isBitSet(classify.mask.data(), i), back = mg::isBitSet(classify.secondMask.data(), i);
+    failures += CHECK(!(front && back) && intersected[i] != (front || back) &&
+                      (front || back) == (mg::distancePointToPlane(centers[i], plane) > spheres.radius[i]));
+  }
+
+  // a box is outside when the 8 corners are behind one plane
+  const auto frustumAabbs = runQuery(kernels, scene, QUERY::FRUSTUM_AABBS, q);
+  for (uint32_t i = 0; i < n; i++) {
+    bool outside = false;
+    for (const auto &p : frustum.planes) {
+      bool allBehind = true;
+      for (uint32_t corner = 0; corner < 8; corner++) {
+        const glm::vec3 c = {corner & 1 ? aabbs.maxX[i] : aabbs.minX[i], corner & 2 ? aabbs.maxY[i] : aabbs.minY[i],
+                             corner & 4 ? aabbs.maxZ[i] : aabbs.minZ[i]};
+        allBehind = allBehind && p.x * c.x + p.y * c.y + p.z * c.z + p.w < 0.0f;
+      }
+      outside = outside || allBehind;
+    }
+    failures += CHECK(mg::isBitSet(frustumAabbs.mask.data(), i) != outside);
+  }
+
+  // the hit points are on the spheres, the boxes and the triangle planes, and a missed box misses the sphere inside it
+  const auto raySpheres = runQuery(kernels, scene, QUERY::RAY_SPHERES, q);
+  const auto rayAabbs = runQuery(kernels, scene, QUERY::RAY_AABBS, q);
+  const auto rayTriangles = runQuery(kernels, scene, QUERY::RAY_TRIANGLES, q);
+  constexpr float epsilon = 1e-3f;
+  for (uint32_t i = 0; i < n; i++) {
+    if (mg::isBitSet(raySpheres.mask.data(), i)) {
+      const auto hit = ray.origin + ray.direction * raySpheres.distances[i];
+      const bool inside = glm::distance(ray.origin, spheres.center(i)) < spheres.radius[i];
+      failures += CHECK(inside || std::abs(glm::distance(hit, spheres.center(i)) - spheres.radius[i]) <= epsilon);
+    }
+
+    const auto minimum = aabbs.minimum(i), maximum = aabbs.maximum(i);
+    if (mg::isBitSet(rayAabbs.mask.data(), i)) {
+      const auto hit = ray.origin + ray.direction * rayAabbs.distances[i];
+      failures += CHECK(glm::all(glm::greaterThanEqual(hit, minimum - epsilon)) &&
+                        glm::all(glm::lessThanEqual(hit, maximum + epsilon)));
+    } else {
+      const auto center = (minimum + maximum) * 0.5f;
+      const auto halfExtent = (maximum - minimum) * 0.5f;
+      const float radius = std::min(std::min(halfExtent.x, halfExtent.y), halfExtent.z);
+      const auto closest = ray.origin + ray.direction * glm::clamp(glm::dot(center - ray.origin, ray.direction), 0.0f,
+                                                                   ray.maxDistance);
+      failures += CHECK(glm::distance(closest, center) >= radius - epsilon);
+    }
+
+    const auto triangle = scene.triangles.triangle(i);
+    if (mg::isBitSet(rayTriangles.mask.data(), i)) {
+      const mg::Plane trianglePlane = {
+          triangle.position1,
+          glm::normalize(glm::cross(triangle.position2 - triangle.position1, triangle.position3 - triangle.position1))};
+      const auto hit = ray.origin + ray.direction * rayTriangles.distances[i];
+      glm::vec3 lineHit;
+      const mg::Line line = {ray.origin, ray.origin + ray.direction * ray.maxDistance};
+      failures += CHECK(mg::distancePointToPlane(hit, trianglePlane) <= epsilon &&
+                        mg::intersectionLinePlane(&lineHit, line, trianglePlane) &&
+                        glm::distance(lineHit, hit) <= epsilon * 10.0f);
+    }
+  }
+
+  // the same as comparing the distance of the centers with the sum of the radii, unless the spheres barely touch
+  const auto sphereSpheres = runQuery(kernels, scene, QUERY::SPHERE_SPHERES, q);
+  for (uint32_t i = 0; i < n; i++) {
+    const float margin = glm::distance(glm::vec3(sphere), spheres.center(i)) - (sphere.w + spheres.radius[i]);
+    failures += CHECK(std::abs(margin) <= epsilon || mg::isBitSet(sphereSpheres.mask.data(), i) == (margin <= 0.0f));
+  }
+  return failures;
+}
+
+} // namespace
+
+uint32_t testGeometryQueries() {
+  constexpr uint32_t nrOfElements = 10007; // not a multiple of 8 so the masked tails run
+  constexpr uint32_t nrOfQueries = 16;
+  const auto scene = fixtures::createScene(nrOfElements, nrOfQueries);
+  uint32_t failures = 0;
+  for (uint32_t q = 0; q < nrOfQueries; q++)
+    failures += checkScalar(scene, q);
+
+  const auto &scalar = *mg::getGeometryQueryKernels(mg::GEOMETRY_ISA::SCALAR);
+  for (uint32_t i = 0; i < uint32_t(mg::GEOMETRY_ISA::SIZE); i++) {
+    const auto isa = mg::GEOMETRY_ISA(i);
+    const auto kernels = mg::getGeometryQueryKernels(isa);
+    if (!kernels) {
+      LOG("geometry queries: " << mg::geometryIsaName(isa) << " is not supported");
+      continue;
+    }
+    for (uint32_t query = 0; query < uint32_t(QUERY::SIZE); query++) {
+      for (uint32_t q = 0; q < nrOfQueries; q++)
+        failures += CHECK(runQuery(*kernels, scene, QUERY(query), q) == runQuery(scalar, scene, QUERY(query), q));
+    }
+  }
+  LOG("geometry queries: " << mg::geometryIsaName(mg::geometryQueryKernels().isa) << " is used");
+  return failures;
+}
@@ -0,0 +1,91 @@
+#include "mg/instanceCulling.h"
+#include "mg/logger.h"
+#include "tests.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+// Checks the cpu version of cullInstances.comp: the sphere of a primitive reaches exactly to its farthest corner, an
+// instance with a corner in the frustum is kept and a kept instance has the sphere around its corners touch the
+// frustum. The streams are tested with and without z and sizes.
+
+namespace {
+
+constexpr float epsilon = 1e-3f;
+
+// the corners of the primitives of size 1 at the origin
+std::vector<glm::vec3> primitiveCorners(mg::PRIMITIVE primitive) {
+  if (primitive == mg::PRIMITIVE::QUAD)
+    return {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  std::vector<glm::vec3> corners;
+  for (uint32_t corner = 0; corner < 8; corner++)
+    corners.push_back({corner & 1 ? 0.5f : -0.5f, corner & 2 ? 0.5f : -0.5f, corner & 4 ? 0.5f : -0.5f});
+  return corners;
+}
+
+} // namespace
+
+uint32_t testInstanceCulling() {
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f), position(-100.0f, 100.0f);
+  const auto randomPosition = [&] { return glm::vec3(position(generator), position(generator), position(generator)); };
+  uint32_t failures = 0, nrOfVisible = 0, nrOfInstances = 0;
+
+  for (uint32_t p = 0; p < uint32_t(mg::PRIMITIVE::COUNT); p++) {
+    const auto primitive = mg::PRIMITIVE(p);
+    const auto bounds = mg::primitiveBounds(primitive);
+    const auto corners = primitiveCorners(primitive);
+    float radius = 0.0f;
+    for (const auto &corner : corners)
+      radius = std::max(radius, glm::distance(corner, glm::vec3(bounds)));
+    failures += CHECK(std::abs(radius - bounds.w) <= epsilon);
+
+    for (uint32_t camera = 0; camera < 32; camera++) {
+      const auto eye = randomPosition();
+      const auto view = glm::lookAt(eye, randomPosition(), glm::vec3(0, 1, 0));
+      const auto frustum = mg::createFrustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f) * view);
+
+      const uint32_t count = 1000 + camera;
+      std::vector<float> x(count), y(count), z(count), sizes(count);
+      for (uint32_t i = 0; i < count; i++) {
+        const auto instance = randomPosition();
+        x[i] = instance.x, y[i] = instance.y, z[i] = instance.z;
+        sizes[i] = 0.1f + 20.0f * unit(generator);
+      }
+      mg::InstanceStreams streams = {};
+      streams.x = x.data(), streams.y = y.data(), streams.count = count;
+      // the odd cameras leave out z and every other pair of cameras the sizes
+      streams.z = camera & 1 ? nullptr : z.data();
+      streams.sizes = camera & 2 ? nullptr : sizes.data();
+      streams.size = 5.0f;
+
+      std::vector<uint32_t> visible(count);
+      visible.resize(mg::cullInstances(frustum, primitive, streams, visible.data()));
+      failures += CHECK(std::is_sorted(visible.begin(), visible.end()) &&
+                        std::adjacent_find(visible.begin(), visible.end()) == visible.end());
+      for (uint32_t i = 0; i < count; i++) {
+        const glm::vec3 position = {x[i], y[i], streams.z ? z[i] : 0.0f};
+        const float size = streams.sizes ? sizes[i] : streams.size;
+        const bool isVisible = std::binary_search(visible.begin(), visible.end(), i);
+        bool isCornerInside = false;
+        glm::vec3 minimum(1e30f), maximum(-1e30f);
+        for (const auto &corner : corners) {
+          const auto point = position + corner * size;
+          isCornerInside = isCornerInside || mg::isSphereInFrustum(frustum, glm::vec4(point, 0.0f));
+          minimum = glm::min(minimum, point);
+          maximum = glm::max(maximum, point);
+        }
+        const auto center = (minimum + maximum) * 0.5f;
+        const float sphereRadius = glm::distance(center, maximum) * (1.0f + epsilon) + epsilon;
+        failures += CHECK(!isCornerInside || isVisible);
+        failures += CHECK(!isVisible || mg::isSphereInFrustum(frustum, glm::vec4(center, sphereRadius)));
+      }
+      nrOfVisible += uint32_t(visible.size());
+      nrOfInstances += count;
+    }
+  }
+  LOG("instance culling: " << nrOfVisible << " of " << nrOfInstances << " instances in the frustum");
+  return failures;
+}
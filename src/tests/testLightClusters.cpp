@@ -0,0 +1,108 @@
+#include "mg/lightClusters.h"
+#include "mg/logger.h"
+#include "tests.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Checks the cpu versions of the cluster shaders: a pixel finds the cluster whose tile and slice it is in, the bounds
+// contain every point of their cluster, and every light that reaches a point is in the list of its cluster.
+
+namespace {
+
+constexpr float epsilon = 1e-4f;
+
+std::vector<mg::PointLight> createLights(uint32_t nrOfLights, std::mt19937 &generator) {
+  std::uniform_real_distribution<float> side(-200.0f, 200.0f), depth(-10.0f, 600.0f), range(0.5f, 40.0f);
+  std::vector<mg::PointLight> lights(nrOfLights);
+  for (auto &light : lights) {
+    light.positionRange = {side(generator), side(generator), depth(generator), range(generator)};
+    light.colorIntensity = {1.0f, 1.0f, 1.0f, 1.0f};
+  }
+  return lights;
+}
+
+// a box that does not touch the sphere is farther than the radius on at least one axis
+bool isSphereTouchingBox(const glm::vec4 &sphere, const mg::ClusterBounds &box) {
+  float squaredDistance = 0.0f;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    const float outside = std::max(std::max(box.minimum[axis] - sphere[axis], sphere[axis] - box.maximum[axis]), 0.0f);
+    squaredDistance += outside * outside;
+  }
+  return squaredDistance <= sphere.w * sphere.w;
+}
+
+} // namespace
+
+uint32_t testLightClusters() {
+  mg::ClusterGridInfo info = {};
+  info.maxLightsPerCluster = 512;
+  const auto grid = mg::createClusterGrid(info);
+  const auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, info.nearDepth, info.farDepth);
+  const auto bounds = mg::computeClusterBounds(grid, projection);
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  uint32_t failures = 0;
+
+  // the middle of every tile and slice, and random points in the cluster, are in the cluster and in its bounds
+  for (uint32_t cluster = 0; cluster < mg::nrOfClusters(grid); cluster++) {
+    const glm::uvec3 coordinate = {cluster % grid.size.x, (cluster / grid.size.x) % grid.size.y,
+                                   cluster / (grid.size.x * grid.size.y)};
+    const float depthRatio = info.farDepth / info.nearDepth;
+    const float nearDepth = info.nearDepth * std::pow(depthRatio, float(coordinate.z) / grid.size.z);
+    const float farDepth = info.nearDepth * std::pow(depthRatio, float(coordinate.z + 1) / grid.size.z);
+    const float middleDepth = std::sqrt(nearDepth * farDepth);
+    const glm::vec2 tileSize = 1.0f / glm::vec2(grid.size.x, grid.size.y);
+    const glm::vec2 tileMiddle = (glm::vec2(coordinate.x, coordinate.y) + 0.5f) * tileSize;
+    failures += CHECK(mg::clusterOfPixel(tileMiddle, middleDepth, grid) == cluster);
+
+    const auto &box = bounds[cluster];
+    for (uint32_t i = 0; i < 16; i++) {
+      const glm::vec2 uv = (glm::vec2(coordinate.x, coordinate.y) + glm::vec2(unit(generator), unit(generator))) *
+                           tileSize;
+      const auto position = mg::viewPosition(uv, glm::mix(nearDepth, farDepth, unit(generator)), projection);
+      const auto tolerance = epsilon * std::max(1.0f, glm::length(position));
+      failures += CHECK(glm::all(glm::greaterThanEqual(position, glm::vec3(box.minimum) - tolerance)) &&
+                        glm::all(glm::lessThanEqual(position, glm::vec3(box.maximum) + tolerance)));
+    }
+  }
+  // depths outside the grid go to the first and the last slice
+  failures += CHECK(mg::clusterOfPixel({0.0f, 0.0f}, info.nearDepth * 0.5f, grid) == 0);
+  failures += CHECK(mg::clusterOfPixel({1.0f, 1.0f}, info.farDepth * 2.0f, grid) == mg::nrOfClusters(grid) - 1);
+
+  const auto lights = createLights(info.maxLightsPerCluster, generator);
+  std::vector<uint32_t> counts, indices;
+  mg::assignLightsToClusters(grid, bounds, lights.data(), uint32_t(lights.size()), &counts, &indices);
+
+  // the list of a cluster is the lights that touch its bounds in ascending order, none are dropped at this count
+  for (uint32_t cluster = 0; cluster < mg::nrOfClusters(grid); cluster++) {
+    const auto first = indices.begin() + size_t(cluster) * grid.size.w;
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < lights.size(); i++) {
+      if (isSphereTouchingBox(lights[i].positionRange, bounds[cluster]))
+        expected.push_back(i);
+    }
+    failures += CHECK(counts[cluster] == expected.size() && std::equal(expected.begin(), expected.end(), first));
+  }
+
+  // a pixel lit by a light finds the light in the list of its cluster
+  uint32_t nrOfLitPoints = 0;
+  for (uint32_t i = 0; i < 100000; i++) {
+    const glm::vec2 uv = {unit(generator), unit(generator)};
+    const float depth = info.nearDepth * std::pow(info.farDepth / info.nearDepth, unit(generator));
+    const auto position = mg::viewPosition(uv, depth, projection);
+    const uint32_t cluster = mg::clusterOfPixel(uv, depth, grid);
+    const auto first = indices.begin() + size_t(cluster) * grid.size.w;
+    const auto last = first + counts[cluster];
+    for (uint32_t l = 0; l < lights.size(); l++) {
+      if (glm::distance(position, glm::vec3(lights[l].positionRange)) >= lights[l].positionRange.w * (1.0f - epsilon))
+        continue;
+      nrOfLitPoints++;
+      failures += CHECK(std::binary_search(first, last, l));
+    }
+  }
+  LOG("light clusters: " << mg::nrOfClusters(grid) << " clusters, " << lights.size() << " lights, " << nrOfLitPoints
+                         << " lit points");
+  return failures;
+}
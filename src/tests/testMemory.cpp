@@ -0,0 +1,161 @@
+#include "mg/logger.h"
+#include "mg/memory.h"
+#include "tests.h"
+#include <cstring>
+#include <vector>
+
+// Checks the allocators of memory.h: a rewind frees the overflow blocks allocated after its mark, the latest
+// allocation grows in place, a reset grows the block to the high water mark so the same allocations stop
+// overflowing, a pool hands out its freed blocks first and an ArenaVector keeps its elements while it grows.
+
+namespace {
+
+constexpr size_t capacity = 256;
+
+bool isAligned(const void *data, size_t alignment) { return (uintptr_t(data) & (alignment - 1)) == 0; }
+
+uint32_t testRewind() {
+  uint32_t failures = 0;
+  mg::Arena arena;
+  arena.create(capacity);
+  arena.allocate(100);
+  const auto mark = arena.mark();
+  const size_t used = arena.used();
+  auto first = (uint8_t *)arena.allocate(64);
+  arena.allocate(1000);
+  arena.allocate(500, 128);
+  failures += CHECK(arena.nrOfOverflows() == 2);
+  failures += CHECK(arena.used() >= used + 64 + 1000 + 500);
+  arena.rewind(mark);
+  failures += CHECK(arena.used() == used);
+  failures += CHECK(arena.allocate(64) == first);
+
+  // a scope that overflows the scratch arena of its thread leaves it as it was
+  mg::ScratchScope outer;
+  outer.allocate<uint8_t>(16);
+  const size_t scratchUsed = outer.arena().used();
+  const uint32_t scratchOverflows = outer.arena().nrOfOverflows();
+  {
+    mg::ScratchScope inner;
+    auto data = inner.allocate<uint32_t>(1 << 20);
+    data[(1 << 20) - 1] = 1;
+    failures += CHECK(inner.arena().nrOfOverflows() == scratchOverflows + 1);
+  }
+  failures += CHECK(outer.arena().used() == scratchUsed);
+  return failures;
+}
+
+uint32_t testReallocate() {
+  uint32_t failures = 0;
+  mg::Arena arena;
+  arena.create(capacity);
+  auto data = (uint8_t *)arena.allocate(16);
+  memset(data, 7, 16);
+  const size_t used = arena.used();
+  failures += CHECK(arena.reallocate(data, 16, 64) == data);
+  failures += CHECK(arena.used() == used + 48);
+  failures += CHECK(arena.nrOfOverflows() == 0);
+
+  // once another allocation follows it the data is copied
+  arena.allocate(8);
+  auto moved = (uint8_t *)arena.reallocate(data, 64, 128);
+  failures += CHECK(moved != data);
+  failures += CHECK(moved[0] == 7 && moved[15] == 7);
+
+  // the latest allocation can be given back, an older one stays until the arena is rewound
+  const size_t usedBeforeLast = arena.used();
+  auto last = arena.allocate(32);
+  arena.deallocate(moved, 128);
+  failures += CHECK(arena.used() == usedBeforeLast + 32);
+  arena.deallocate(last, 32);
+  failures += CHECK(arena.used() == usedBeforeLast);
+  return failures;
+}
+
+uint32_t testReset() {
+  uint32_t failures = 0;
+  mg::Arena arena;
+  arena.create(capacity);
+  const auto frame = [&] {
+    for (uint32_t i = 0; i < 16; i++)
+      arena.allocate(100);
+  };
+  frame();
+  const uint32_t nrOfOverflows = arena.nrOfOverflows();
+  failures += CHECK(nrOfOverflows > 0);
+  failures += CHECK(arena.highWaterMark() >= 1600);
+  arena.reset();
+  failures += CHECK(arena.used() == 0);
+  failures += CHECK(arena.capacity() >= arena.highWaterMark());
+  failures += CHECK((arena.capacity() & (arena.capacity() - 1)) == 0);
+  frame();
+  failures += CHECK(arena.nrOfOverflows() == nrOfOverflows);
+
+  // a reset without an overflow keeps the block
+  const size_t grownCapacity = arena.capacity();
+  arena.reset();
+  failures += CHECK(arena.capacity() == grownCapacity);
+  return failures;
+}
+
+uint32_t testPool() {
+  uint32_t failures = 0;
+  mg::Pool pool;
+  pool.create(24, 16, 4);
+  std::vector<void *> blocks;
+  for (uint32_t i = 0; i < 6; i++) {
+    blocks.push_back(pool.allocate());
+    failures += CHECK(isAligned(blocks.back(), 16));
+  }
+  failures += CHECK(pool.nrOfAllocatedBlocks() == 6);
+  // the blocks of a chunk come in address order, apart by the block size rounded up to the alignment
+  failures += CHECK((uint8_t *)blocks[1] - (uint8_t *)blocks[0] == 32);
+
+  pool.deallocate(blocks[2]);
+  pool.deallocate(blocks[4]);
+  failures += CHECK(pool.nrOfAllocatedBlocks() == 4);
+  failures += CHECK(pool.allocate() == blocks[4]);
+  failures += CHECK(pool.allocate() == blocks[2]);
+  failures += CHECK(pool.nrOfAllocatedBlocks() == 6);
+
+  struct Object {
+    uint32_t value;
+    explicit Object(uint32_t value) : value(value) {}
+  };
+  mg::ObjectPool<Object> objects;
+  objects.create(8);
+  auto object = objects.construct(5u);
+  failures += CHECK(object->value == 5 && objects.size() == 1);
+  objects.destruct(object);
+  failures += CHECK(objects.construct(6u) == object && object->value == 6);
+  return failures;
+}
+
+uint32_t testArenaVector() {
+  uint32_t failures = 0;
+  mg::Arena arena;
+  arena.create(capacity);
+  mg::ArenaVector<uint32_t> vector{mg::ArenaAllocator<uint32_t>(&arena)};
+  for (uint32_t i = 0; i < 1000; i++)
+    vector.push_back(i * 3);
+  bool isEqual = true;
+  for (uint32_t i = 0; i < 1000; i++)
+    isEqual &= vector[i] == i * 3;
+  failures += CHECK(isEqual);
+  failures += CHECK(arena.used() >= 1000 * sizeof(uint32_t));
+  failures += CHECK(arena.nrOfOverflows() > 0);
+  return failures;
+}
+
+} // namespace
+
+uint32_t testMemory() {
+  uint32_t failures = 0;
+  failures += testRewind();
+  failures += testReallocate();
+  failures += testReset();
+  failures += testPool();
+  failures += testArenaVector();
+  LOG("memory: arenas, scratch scopes and pools");
+  return failures;
+}
@@ -0,0 +1,205 @@
+#include "mg/logger.h"
+#include "mg/meshSimplification.h"
+#include "tests.h"
+#include <array>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <map>
+#include <vector>
+
+// Checks the levels of detail of createMeshLods: a closed sphere with a uv seam stays closed at every level, the uv
+// seam and the material boundary of a grid stay edges of the triangles on both of their sides, every level has about
+// half the triangles of the one before it, and selectMeshLod picks coarser levels farther away.
+
+namespace {
+
+constexpr uint32_t NR_OF_FLOATS = 5; // position and uv
+constexpr float epsilon = 1e-4f;
+
+struct Mesh {
+  std::vector<float> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<uint32_t> groups;
+  glm::vec3 position(uint32_t vertex) const {
+    return {vertices[vertex * NR_OF_FLOATS], vertices[vertex * NR_OF_FLOATS + 1], vertices[vertex * NR_OF_FLOATS + 2]};
+  }
+  uint32_t addVertex(const glm::vec3 &position, const glm::vec2 &uv) {
+    vertices.insert(vertices.end(), {position.x, position.y, position.z, uv.x, uv.y});
+    return uint32_t(vertices.size() / NR_OF_FLOATS - 1);
+  }
+  mg::MeshGeometry geometry() const {
+    return {vertices.data(), uint32_t(vertices.size() / NR_OF_FLOATS), NR_OF_FLOATS, indices.data(),
+            uint32_t(indices.size()), groups.empty() ? nullptr : groups.data()};
+  }
+};
+
+// a bumpy uv sphere, the vertices of the first and the last segment and of the poles share their positions with
+// different uvs
+Mesh createSphere(uint32_t rings, uint32_t segments) {
+  Mesh mesh;
+  // the last vertex of a ring copies the position of its first
+  for (uint32_t r = 1; r < rings; r++) {
+    glm::vec3 first(0.0f);
+    for (uint32_t s = 0; s <= segments; s++) {
+      const float theta = glm::pi<float>() * r / rings, phi = glm::two_pi<float>() * s / segments;
+      const float radius = 1.0f + 0.05f * std::sin(theta * 5.0f) * std::cos(phi * 3.0f);
+      const glm::vec3 position = radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta),
+                                                    -std::sin(theta) * std::sin(phi));
+      if (s == 0)
+        first = position;
+      mesh.addVertex(s < segments ? position : first, {float(s) / segments, float(r) / rings});
+    }
+  }
+  const auto ring = [&](uint32_t r, uint32_t s) { return (r - 1) * (segments + 1) + s; };
+  for (uint32_t s = 0; s < segments; s++) {
+    const float u = (s + 0.5f) / segments;
+    const uint32_t top = mesh.addVertex({0.0f, 1.0f, 0.0f}, {u, 0.0f});
+    const uint32_t bottom = mesh.addVertex({0.0f, -1.0f, 0.0f}, {u, 1.0f});
+    mesh.indices.insert(mesh.indices.end(), {top, ring(1, s), ring(1, s + 1)});
+    mesh.indices.insert(mesh.indices.end(), {ring(rings - 1, s), bottom, ring(rings - 1, s + 1)});
+  }
+  for (uint32_t r = 1; r + 1 < rings; r++) {
+    for (uint32_t s = 0; s < segments; s++) {
+      const uint32_t a = ring(r, s), b = ring(r + 1, s);
+      mesh.indices.insert(mesh.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+    }
+  }
+  return mesh;
+}
+
+constexpr uint32_t n = 32;
+
+// an n by n grid of quads on a bumpy [0, 1] square, the column at x 0.5 is a uv seam and the triangles above y 0.5
+// are material 1, a row has n + 2 vertices with the copy for the right side of the seam after the vertex on the seam
+Mesh createGrid() {
+  Mesh mesh;
+  const auto position = [](uint32_t i, uint32_t j) {
+    const float x = float(i) / n, y = float(j) / n;
+    return glm::vec3(x, y, 0.05f * std::sin(x * 7.0f) * std::cos(y * 5.0f));
+  };
+  std::vector<uint32_t> left((n + 1) * (n + 1)), right((n + 1) * (n + 1));
+  for (uint32_t j = 0; j <= n; j++) {
+    for (uint32_t i = 0; i <= n; i++) {
+      const uint32_t v = j * (n + 1) + i;
+      left[v] = right[v] = mesh.addVertex(position(i, j), {float(i) / n, float(j) / n});
+      if (i == n / 2)
+        right[v] = mesh.addVertex(position(i, j), {float(i) / n + 1.0f, float(j) / n});
+    }
+  }
+  for (uint32_t j = 0; j < n; j++) {
+    for (uint32_t i = 0; i < n; i++) {
+      const uint32_t a = right[j * (n + 1) + i], b = left[j * (n + 1) + i + 1];
+      const uint32_t c = right[(j + 1) * (n + 1) + i], d = left[(j + 1) * (n + 1) + i + 1];
+      mesh.indices.insert(mesh.indices.end(), {a, b, c, c, b, d});
+      const uint32_t group = j < n / 2 ? 0 : 1;
+      mesh.groups.insert(mesh.groups.end(), {group, group});
+    }
+  }
+  return mesh;
+}
+
+bool isSeamCopy(uint32_t vertex) { return vertex % (n + 2) == n / 2 + 1; }
+
+// every edge between two positions is used once in each direction and no triangle has two corners at one position
+bool isClosed(const Mesh &mesh, const std::vector<uint32_t> &indices) {
+  std::map<std::array<float, 3>, uint32_t> positionIds;
+  const auto positionId = [&](uint32_t vertex) {
+    const auto p = mesh.position(vertex);
+    return positionIds.emplace(std::array<float, 3>{p.x, p.y, p.z}, uint32_t(positionIds.size())).first->second;
+  };
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> edges;
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    const uint32_t p[3] = {positionId(indices[t]), positionId(indices[t + 1]), positionId(indices[t + 2])};
+    if (p[0] == p[1] || p[1] == p[2] || p[2] == p[0])
+      return false;
+    for (uint32_t corner = 0; corner < 3; corner++)
+      edges[{p[corner], p[(corner + 1) % 3]}]++;
+  }
+  for (const auto &edge : edges) {
+    const auto reverse = edges.find({edge.first.second, edge.first.first});
+    if (edge.second != 1 || reverse == edges.end() || reverse->second != 1)
+      return false;
+  }
+  return true;
+}
+
+// the triangles on each side of the line coordinate[axis] == 0.5 have no corner beyond it and their edges on the line
+// cover it, the corners on the line of the triangles above it are the vertices isAbove gives
+uint32_t checkBoundary(const Mesh &mesh, const std::vector<uint32_t> &indices, uint32_t axis,
+                       bool (*isAbove)(uint32_t vertex)) {
+  uint32_t failures = 0;
+  float length[2] = {};
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    const glm::vec3 p[3] = {mesh.position(indices[t]), mesh.position(indices[t + 1]), mesh.position(indices[t + 2])};
+    const uint32_t side = (p[0][axis] + p[1][axis] + p[2][axis]) / 3.0f > 0.5f ? 1 : 0;
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      const auto &p0 = p[corner], &p1 = p[(corner + 1) % 3];
+      failures += CHECK(side == 1 ? p0[axis] >= 0.5f : p0[axis] <= 0.5f);
+      if (p0[axis] == 0.5f && isAbove)
+        failures += CHECK(isAbove(indices[t + corner]) == (side == 1));
+      if (p0[axis] == 0.5f && p1[axis] == 0.5f)
+        length[side] += std::abs(p1[1 - axis] - p0[1 - axis]);
+    }
+  }
+  failures += CHECK(std::abs(length[0] - 1.0f) < epsilon && std::abs(length[1] - 1.0f) < epsilon);
+  return failures;
+}
+
+// about half, the target of every level, with room for the collapses that would break a seam or a boundary
+uint32_t checkHalving(const std::vector<mg::MeshLod> &lods) {
+  uint32_t failures = 0;
+  for (size_t i = 1; i < lods.size(); i++) {
+    failures += CHECK(lods[i].indices.size() * 10 <= lods[i - 1].indices.size() * 6);
+    failures += CHECK(lods[i].error >= lods[i - 1].error);
+  }
+  return failures;
+}
+
+} // namespace
+
+uint32_t testMeshSimplification() {
+  uint32_t failures = 0;
+
+  const auto sphere = createSphere(48, 96);
+  failures += CHECK(isClosed(sphere, sphere.indices));
+  const auto sphereLods = mg::createMeshLods(sphere.geometry(), 64);
+  failures += CHECK(sphereLods.size() == mg::MAX_MESH_LODS);
+  failures += checkHalving(sphereLods);
+  for (const auto &lod : sphereLods)
+    failures += CHECK(isClosed(sphere, lod.indices));
+
+  const auto grid = createGrid();
+  const auto gridLods = mg::createMeshLods(grid.geometry(), 32);
+  failures += CHECK(gridLods.size() == mg::MAX_MESH_LODS);
+  failures += checkHalving(gridLods);
+  for (const auto &lod : gridLods) {
+    failures += checkBoundary(grid, lod.indices, 0, isSeamCopy);
+    failures += checkBoundary(grid, lod.indices, 1, nullptr);
+  }
+
+  // farther away the same sphere never gets a finer level, at 0 pixels it is always level 0
+  std::vector<float> errors;
+  for (const auto &lod : sphereLods)
+    errors.push_back(lod.error);
+  mg::LodSelection lodSelection = {};
+  lodSelection.scale = mg::lodScale(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f), 1080);
+  lodSelection.threshold = 1.0f;
+  uint32_t lod = 0;
+  for (float distance = 0.0f; distance < 10000.0f; distance = distance * 1.1f + 0.01f) {
+    const glm::vec4 bounds = {0.0f, 0.0f, distance, 1.0f};
+    const uint32_t next = mg::selectMeshLod(lodSelection, bounds, errors.data(), uint32_t(errors.size()));
+    failures += CHECK(next >= lod);
+    lod = next;
+  }
+  failures += CHECK(lod == errors.size() - 1);
+  lodSelection.threshold = 0.0f;
+  failures += CHECK(mg::selectMeshLod(lodSelection, {0.0f, 0.0f, 10000.0f, 1.0f}, errors.data(),
+                                      uint32_t(errors.size())) == 0);
+
+  LOG("mesh simplification: sphere " << sphereLods.front().indices.size() / 3 << " to "
+                                     << sphereLods.back().indices.size() / 3 << " triangles, grid "
+                                     << gridLods.front().indices.size() / 3 << " to "
+                                     << gridLods.back().indices.size() / 3 << " triangles");
+  return failures;
+}
@@ -0,0 +1,114 @@
+#include "bumpySphere.h"
+#include "mg/frustumCulling.h"
+#include "mg/logger.h"
+#include "mg/meshlets.h"
+#include "tests.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// Builds the meshlets of a bumpy sphere and checks the limits, that every triangle is in exactly one meshlet, that
+// the index ranges and the index stream are the triangles in meshlet order, that the spheres contain their vertices
+// and that a meshlet the cone test culls has no triangle facing the camera. cullMeshlets, the cpu version of
+// cullMeshlets.comp without the hi-z, is compared with the sphere and cone tests one by one from random cameras.
+
+namespace {
+
+using fixtures::Mesh;
+
+std::vector<std::array<uint32_t, 3>> sortedTriangles(const uint32_t *indices, size_t nrOfIndices) {
+  std::vector<std::array<uint32_t, 3>> triangles(nrOfIndices / 3);
+  for (size_t i = 0; i < triangles.size(); i++)
+    triangles[i] = {indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]};
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+uint32_t checkMeshlets(const Mesh &mesh, const mg::Meshlets &meshlets, const std::vector<uint32_t> &ordered) {
+  uint32_t failures = 0;
+  uint32_t nextIndex = 0;
+  for (const auto &meshlet : meshlets.meshlets) {
+    failures += CHECK(meshlet.vertexCount <= mg::MAX_MESHLET_VERTICES &&
+                      meshlet.triangleCount <= mg::MAX_MESHLET_TRIANGLES && meshlet.triangleCount > 0);
+    failures += CHECK(meshlet.firstIndex == nextIndex);
+    nextIndex += meshlet.triangleCount * 3;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+      const auto p = mesh.position(meshlets.vertices[meshlet.firstVertex + i]);
+      failures += CHECK(glm::distance(p, glm::vec3(meshlet.sphere)) <= meshlet.sphere.w * 1.0001f + 1e-6f);
+    }
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+      const uint32_t triangle = meshlets.triangles[meshlet.firstTriangle + t];
+      for (uint32_t corner = 0; corner < 3; corner++)
+        failures += CHECK(((triangle >> (corner * 8)) & 0xff) < meshlet.vertexCount);
+    }
+  }
+  failures += CHECK(nextIndex == mesh.indices.size());
+  failures += CHECK(sortedTriangles(ordered.data(), ordered.size()) ==
+                    sortedTriangles(mesh.indices.data(), mesh.indices.size()));
+
+  std::vector<uint32_t> all(meshlets.meshlets.size()), written(mesh.indices.size());
+  for (uint32_t i = 0; i < all.size(); i++)
+    all[i] = i;
+  const auto nrOfWritten = mg::writeMeshletIndices(meshlets, all.data(), uint32_t(all.size()), written.data());
+  failures += CHECK(nrOfWritten == written.size());
+  failures += CHECK(written == ordered);
+  return failures;
+}
+
+// a meshlet facing away may not have a triangle whose front the camera sees
+uint32_t checkCones(const Mesh &mesh, const mg::Meshlets &meshlets, const std::vector<uint32_t> &ordered,
+                    const std::vector<glm::vec3> &cameras, uint32_t *nrOfBackFacing) {
+  uint32_t failures = 0;
+  *nrOfBackFacing = 0;
+  for (const auto &camera : cameras) {
+    for (const auto &meshlet : meshlets.meshlets) {
+      if (!mg::isMeshletBackFacing(meshlet, camera))
+        continue;
+      (*nrOfBackFacing)++;
+      for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.triangleCount * 3; i += 3) {
+        const auto p0 = mesh.position(ordered[i]);
+        const auto normal = glm::cross(mesh.position(ordered[i + 1]) - p0, mesh.position(ordered[i + 2]) - p0);
+        failures += CHECK(glm::dot(normal, camera - p0) <= 1e-6f);
+      }
+    }
+  }
+  return failures;
+}
+
+} // namespace
+
+uint32_t testMeshlets() {
+  const auto mesh = fixtures::createMesh(64);
+  mg::Meshlets meshlets;
+  std::vector<uint32_t> ordered(mesh.indices.size());
+  mg::buildMeshlets(mesh.vertices.data(), fixtures::NR_OF_FLOATS, mesh.indices.data(), uint32_t(mesh.indices.size()),
+                    0, 0, &meshlets, ordered.data());
+  const auto nrOfMeshlets = uint32_t(meshlets.meshlets.size());
+  uint32_t failures = checkMeshlets(mesh, meshlets, ordered);
+
+  const auto camerasAround = fixtures::createCameras(64);
+  const auto &cameras = camerasAround.positions;
+  const auto &viewProjections = camerasAround.viewProjections;
+
+  uint32_t nrOfBackFacing = 0;
+  failures += checkCones(mesh, meshlets, ordered, cameras, &nrOfBackFacing);
+
+  uint64_t nrOfVisible = 0;
+  std::vector<uint32_t> visible(nrOfMeshlets);
+  for (uint32_t c = 0; c < cameras.size(); c++) {
+    const auto frustum = mg::createFrustum(viewProjections[c]);
+    const auto n = mg::cullMeshlets(frustum, cameras[c], meshlets.meshlets.data(), nrOfMeshlets, visible.data());
+    nrOfVisible += n;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < nrOfMeshlets; i++) {
+      const auto &meshlet = meshlets.meshlets[i];
+      if (mg::isSphereInFrustum(frustum, meshlet.sphere) && !mg::isMeshletBackFacing(meshlet, cameras[c]))
+        failures += CHECK(next < n && visible[next++] == i);
+    }
+    failures += CHECK(next == n);
+  }
+  LOG("meshlets: " << mesh.indices.size() / 3 << " triangles in " << nrOfMeshlets << " meshlets, "
+                   << 100.0 * nrOfBackFacing / (double(nrOfMeshlets) * cameras.size()) << " % facing away, "
+                   << 100.0 * nrOfVisible / (double(nrOfMeshlets) * cameras.size()) << " % visible");
+  return failures;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// The cpu reference checks of the engine. A test returns its number of failed checks, CHECK logs the ones that fail.
+#define CHECK(...) checkCondition(bool(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+// returns 1 and logs the file, the line and the expression of a check that fails, 0 when it holds
+uint32_t checkCondition(bool condition, const char *expression, const char *file, int line);
+
+uint32_t testFrustumCulling();
+uint32_t testGeometryQueries();
+uint32_t testInstanceCulling();
+uint32_t testLightClusters();
+uint32_t testMemory();
+uint32_t testMeshSimplification();
+uint32_t testMeshlets();
@@ -0,0 +1,64 @@
+#include "geometryQueryScene.h"
+#include "mg/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+// Reports the elements per nanosecond of the geometry queries for every instruction set, mg-tests checks their results.
+// mg-geometry-bench [--elements=N] [--iterations=N] [--queries=N]
+
+namespace {
+
+double nanoseconds(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+template <typename Job> double elementsPerNanosecond(uint64_t nrOfElements, uint32_t iterations, Job job) {
+  job(); // warm up the caches
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (uint32_t i = 0; i < iterations; i++)
+    job();
+  return double(nrOfElements) * iterations / nanoseconds(start);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t nrOfElements = 100003; // not a multiple of 8 so the masked tails run
+  uint32_t iterations = 100;
+  uint32_t nrOfQueries = 16;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--elements=", 0) == 0)
+      nrOfElements = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--elements=")))));
+    else if (arg.rfind("--iterations=", 0) == 0)
+      iterations = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--iterations=")))));
+    else if (arg.rfind("--queries=", 0) == 0)
+      nrOfQueries = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--queries=")))));
+    else
+      LOG("unknown argument " << arg);
+  }
+  const auto scene = fixtures::createScene(nrOfElements, nrOfQueries);
+
+  LOG("queries use " << mg::geometryIsaName(mg::geometryQueryKernels().isa) << ", " << nrOfElements << " elements, "
+                     << nrOfQueries << " queries, " << iterations << " iterations");
+  for (uint32_t i = 0; i < uint32_t(mg::GEOMETRY_ISA::SIZE); i++) {
+    const auto isa = mg::GEOMETRY_ISA(i);
+    const auto kernels = mg::getGeometryQueryKernels(isa);
+    if (!kernels) {
+      LOG(mg::geometryIsaName(isa) << ": not supported");
+      continue;
+    }
+    for (uint32_t query = 0; query < uint32_t(fixtures::QUERY::SIZE); query++) {
+      uint32_t q = 0;
+      fixtures::Result result;
+      const double throughput = elementsPerNanosecond(nrOfElements, iterations, [&] {
+        fixtures::runQuery(*kernels, scene, fixtures::QUERY(query), q, &result);
+        q = (q + 1) % nrOfQueries;
+      });
+      LOG(mg::geometryIsaName(isa) << " " << fixtures::queryNames[query] << ": " << throughput << " elements/ns");
+    }
+  }
+  return 0;
+}
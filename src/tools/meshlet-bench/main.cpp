@@ -0,0 +1,80 @@
+#include "bumpySphere.h"
+#include "mg/frustumCulling.h"
+#include "mg/logger.h"
+#include "mg/meshlets.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Builds the meshlets of a bumpy sphere and reports the fill of the meshlets, how many the cone test culls from random
+// cameras and the throughput of building and culling them, mg-tests checks them.
+// mg-meshlet-bench [--rings=N] [--cameras=N] [--iterations=N]
+
+namespace {
+
+double nanoseconds(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t rings = 512;
+  uint32_t nrOfCameras = 64;
+  uint32_t iterations = 100;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--rings=", 0) == 0)
+      rings = std::max(2u, uint32_t(std::stoul(arg.substr(strlen("--rings=")))));
+    else if (arg.rfind("--cameras=", 0) == 0)
+      nrOfCameras = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--cameras=")))));
+    else if (arg.rfind("--iterations=", 0) == 0)
+      iterations = std::max(1u, uint32_t(std::stoul(arg.substr(strlen("--iterations=")))));
+    else
+      LOG("unknown argument " << arg);
+  }
+  const auto mesh = fixtures::createMesh(rings);
+  const auto nrOfTriangles = uint32_t(mesh.indices.size() / 3);
+
+  mg::Meshlets meshlets;
+  std::vector<uint32_t> ordered(mesh.indices.size());
+  const auto buildStart = std::chrono::high_resolution_clock::now();
+  mg::buildMeshlets(mesh.vertices.data(), fixtures::NR_OF_FLOATS, mesh.indices.data(), uint32_t(mesh.indices.size()),
+                    0, 0, &meshlets, ordered.data());
+  const double buildNanoseconds = nanoseconds(buildStart);
+  const auto nrOfMeshlets = uint32_t(meshlets.meshlets.size());
+  LOG(nrOfTriangles << " triangles in " << nrOfMeshlets << " meshlets, "
+                    << double(nrOfTriangles) / nrOfMeshlets << " triangles and "
+                    << double(meshlets.vertices.size()) / nrOfMeshlets << " vertices each, built in "
+                    << buildNanoseconds / 1e6 << " ms, " << nrOfTriangles / buildNanoseconds * 1e3
+                    << " triangles/us");
+
+  const auto cameras = fixtures::createCameras(nrOfCameras);
+  const auto &positions = cameras.positions;
+  const auto &viewProjections = cameras.viewProjections;
+
+  uint32_t nrOfBackFacing = 0;
+  uint64_t nrOfVisible = 0;
+  std::vector<uint32_t> visible(nrOfMeshlets);
+  for (uint32_t c = 0; c < nrOfCameras; c++) {
+    for (const auto &meshlet : meshlets.meshlets)
+      nrOfBackFacing += mg::isMeshletBackFacing(meshlet, positions[c]);
+    nrOfVisible += mg::cullMeshlets(mg::createFrustum(viewProjections[c]), positions[c], meshlets.meshlets.data(),
+                                    nrOfMeshlets, visible.data());
+  }
+
+  uint32_t c = 0;
+  const auto cullStart = std::chrono::high_resolution_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    mg::cullMeshlets(mg::createFrustum(viewProjections[c]), positions[c], meshlets.meshlets.data(), nrOfMeshlets,
+                     visible.data());
+    c = (c + 1) % nrOfCameras;
+  }
+  const double cullNanoseconds = nanoseconds(cullStart);
+  LOG(100.0 * nrOfBackFacing / (double(nrOfMeshlets) * nrOfCameras) << " % of the meshlets face away, "
+      << 100.0 * nrOfVisible / (double(nrOfMeshlets) * nrOfCameras) << " % visible, culled "
+      << double(nrOfMeshlets) * iterations / cullNanoseconds << " meshlets/ns");
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include "glslSource.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Section {
+  std::string tag; // vert, proc-chit lambert, empty for the shared part
+  uint32_t firstLine;
+  std::vector<std::string> lines;
+};
+
+bool readLines(const fs::path &path, std::vector<std::string> *lines) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    return false;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    lines->push_back(line);
+  }
+  return true;
+}
+
+std::string trim(const std::string &string) {
+  const auto first = string.find_first_not_of(" \t");
+  if (first == std::string::npos)
+    return "";
+  const auto last = string.find_last_not_of(" \t");
+  return string.substr(first, last - first + 1);
+}
+
+// the file name of an #include "file" line
+bool includeFileName(const std::string &line, std::string *fileName) {
+  const auto trimmed = trim(line);
+  if (trimmed.rfind("#include", 0) != 0)
+    return false;
+  const auto first = trimmed.find('"');
+  const auto last = trimmed.rfind('"');
+  if (first == std::string::npos || last == first)
+    return false;
+  *fileName = trimmed.substr(first + 1, last - first - 1);
+  return true;
+}
+
+// #line with a file name needs GL_GOOGLE_cpp_style_line_directive, glslc then reports errors in the .hglsl files
+std::string lineDirective(uint32_t line, const fs::path &path) {
+  return "#line " + std::to_string(line) + " \"" + path.generic_string() + "\"";
+}
+
+class Preprocessor {
+public:
+  Preprocessor(std::set<std::string> *dependencies) : _dependencies(dependencies) {}
+
+  bool append(const std::vector<std::string> &lines, uint32_t firstLine, const fs::path &path, std::string *error) {
+    for (uint32_t i = 0; i < lines.size(); i++) {
+      std::string includeName;
+      if (!includeFileName(lines[i], &includeName)) {
+        _out << lines[i] << "\n";
+        if (trim(lines[i]).rfind("#version", 0) == 0)
+          _out << "#extension GL_GOOGLE_cpp_style_line_directive : require\n"
+               << lineDirective(firstLine + i + 1, path) << "\n";
+        continue;
+      }
+      const auto includePath = fs::weakly_canonical(path.parent_path() / includeName);
+      if (_included.insert(includePath.generic_string()).second) {
+        std::vector<std::string> includeLines;
+        if (!readLines(includePath, &includeLines)) {
+          *error = path.generic_string() + ":" + std::to_string(firstLine + i) + ": could not open " +
+                   includePath.generic_string();
+          return false;
+        }
+        _dependencies->insert(includePath.generic_string());
+        _out << lineDirective(1, includePath) << "\n";
+        if (!append(includeLines, 1, includePath, error))
+          return false;
+      }
+      _out << lineDirective(firstLine + i + 1, path) << "\n";
+    }
+    return true;
+  }
+
+  std::string source() const { return _out.str(); }
+
+private:
+  std::set<std::string> *_dependencies;
+  std::set<std::string> _included;
+  std::ostringstream _out;
+};
+
+// glslc stage and file name suffix of a section tag
+bool stageOfTag(const std::string &tag, std::string *stage, std::string *suffix) {
+  std::istringstream words(tag);
+  std::string kind, name;
+  words >> kind >> name;
+
+  std::string prefix = name.empty() ? "" : name + ".";
+  if (kind.rfind("proc-", 0) == 0) {
+    kind = kind.substr(std::string("proc-").size());
+    prefix += "proc.";
+  }
+  static const std::pair<const char *, const char *> stages[] = {
+      {"vert", "vert"}, {"frag", "frag"}, {"gen", "rgen"}, {"miss", "rmiss"}, {"int", "rint"}, {"chit", "rchit"},
+  };
+  for (const auto &candidate : stages) {
+    if (kind == candidate.first) {
+      *stage = candidate.second;
+      *suffix = prefix + candidate.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+bool loadGlslSource(const std::string &path, GlslSource *source, std::string *error) {
+  const auto filePath = fs::weakly_canonical(path);
+  const auto name = filePath.stem().generic_string();
+  const auto extension = filePath.extension().generic_string();
+  std::vector<std::string> lines;
+  if (!readLines(filePath, &lines)) {
+    *error = "could not open " + filePath.generic_string();
+    return false;
+  }
+
+  std::vector<Section> sections(1);
+  sections[0].firstLine = 1;
+  for (uint32_t i = 0; i < lines.size(); i++) {
+    const auto trimmed = trim(lines[i]);
+    if (extension != ".comp" && !trimmed.empty() && trimmed[0] == '@') {
+      sections.push_back({trimmed.substr(1), i + 2, {}});
+      continue;
+    }
+    sections.back().lines.push_back(lines[i]);
+  }
+  if (extension == ".comp")
+    sections.push_back({"comp", 1, {}});
+  if (sections.size() == 1) {
+    *error = filePath.generic_string() + " has no @ stages";
+    return false;
+  }
+
+  std::set<std::string> dependencies = {filePath.generic_string()};
+  *source = {};
+  for (size_t i = 1; i < sections.size(); i++) {
+    const auto &section = sections[i];
+    GlslStage stage = {};
+    std::string suffix = "comp";
+    stage.stage = "comp";
+    if (extension != ".comp" && !stageOfTag(section.tag, &stage.stage, &suffix)) {
+      *error = filePath.generic_string() + ":" + std::to_string(section.firstLine - 1) + ": unknown stage @" +
+               section.tag;
+      return false;
+    }
+    stage.fileName = name + "." + suffix + ".spv";
+
+    Preprocessor preprocessor(&dependencies);
+    if (!preprocessor.append(sections[0].lines, 1, filePath, error))
+      return false;
+    if (extension != ".comp") {
+      std::vector<std::string> sectionLines = {lineDirective(section.firstLine, filePath)};
+      sectionLines.insert(sectionLines.end(), section.lines.begin(), section.lines.end());
+      if (!preprocessor.append(sectionLines, section.firstLine - 1, filePath, error))
+        return false;
+    }
+    stage.source = preprocessor.source();
+    source->stages.push_back(std::move(stage));
+  }
+  source->dependencies.assign(dependencies.begin(), dependencies.end());
+  return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct GlslStage {
+  std::string fileName; // solid.vert.spv, procedural.lambert.proc.rchit.spv
+  std::string stage;    // the glslc -fshader-stage name
+  std::string source;   // the shared part of the file, then the stage, includes resolved
+};
+
+struct GlslSource {
+  std::vector<GlslStage> stages;
+  std::vector<std::string> dependencies; // the file and every .hglsl it includes
+};
+
+// Splits name.glsl at its @vert and @frag lines and name.ray at @gen, @miss, @int, @chit, @proc-int and @proc-chit
+// name lines, the part before the first @ is shared by every stage. A .comp file is one compute stage. #include
+// "file.hglsl" is replaced by the file, relative to the including file, once per stage.
+bool loadGlslSource(const std::string &path, GlslSource *source, std::string *error);
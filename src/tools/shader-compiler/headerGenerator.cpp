@@ -0,0 +1,252 @@
+#include "headerGenerator.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+
+std::string scalarName(SCALAR_TYPE scalar) {
+  switch (scalar) {
+  case SCALAR_TYPE::FLOAT:
+    return "float";
+  case SCALAR_TYPE::INT:
+    return "int32_t";
+  case SCALAR_TYPE::DOUBLE:
+    return "double";
+  case SCALAR_TYPE::UINT:
+  case SCALAR_TYPE::BOOL: // a bool is 4 bytes in a block
+    return "uint32_t";
+  }
+  return "";
+}
+
+std::string vectorPrefix(SCALAR_TYPE scalar) {
+  switch (scalar) {
+  case SCALAR_TYPE::FLOAT:
+    return "";
+  case SCALAR_TYPE::INT:
+    return "i";
+  case SCALAR_TYPE::DOUBLE:
+    return "d";
+  case SCALAR_TYPE::UINT:
+  case SCALAR_TYPE::BOOL:
+    return "u";
+  }
+  return "";
+}
+
+// the type of one array element
+std::string cppType(const MemberType &type) {
+  if (type.structType)
+    return type.structType->name;
+  if (type.columns > 1) {
+    const auto prefix = "glm::" + vectorPrefix(type.scalar) + "mat";
+    if (type.columns == type.rows)
+      return prefix + std::to_string(type.columns);
+    return prefix + std::to_string(type.columns) + "x" + std::to_string(type.rows);
+  }
+  if (type.rows > 1)
+    return "glm::" + vectorPrefix(type.scalar) + "vec" + std::to_string(type.rows);
+  return scalarName(type.scalar);
+}
+
+bool isRuntimeArray(const MemberType &type) { return !type.arraySizes.empty() && type.arraySizes[0] == 0; }
+
+std::string indent(uint32_t depth) { return std::string(depth * 2, ' '); }
+
+class Writer {
+public:
+  Writer(const std::string &sourceFileName) : _message(" does not match its layout in " + sourceFileName) {}
+
+  void structDefinition(const StructType &structType, bool isBlock, uint32_t depth) {
+    _out << indent(depth) << "struct " << structType.name << " {\n";
+    std::set<std::string> nested;
+    for (const auto &member : structType.members) {
+      const auto &type = member.type.structType;
+      if (type && nested.insert(type->name).second)
+        structDefinition(*type, false, depth + 1);
+    }
+    for (const auto &member : structType.members) {
+      _out << indent(depth + 1) << cppType(member.type);
+      if (isBlock && isRuntimeArray(member.type)) {
+        _out << "* " << member.name << " = nullptr;\n";
+        continue;
+      }
+      _out << " " << member.name;
+      for (const auto size : member.type.arraySizes)
+        _out << "[" << size << "]";
+      _out << ";\n";
+    }
+    _out << indent(depth) << "};\n";
+  }
+
+  // size is the array stride when the struct is an array element
+  void layoutAsserts(const std::string &qualifiedName, const StructType &structType, uint32_t size) {
+    bool hasRuntimeArray = false;
+    for (const auto &member : structType.members) {
+      if (isRuntimeArray(member.type)) {
+        hasRuntimeArray = true;
+        // a struct element is checked against the stride below
+        if (!member.type.structType && member.type.arraySizes.size() == 1)
+          assertion("sizeof(" + cppType(member.type) + ") == " + std::to_string(member.type.arrayStride),
+                    qualifiedName + "::" + member.name);
+        continue;
+      }
+      assertion("offsetof(" + qualifiedName + ", " + member.name + ") == " + std::to_string(member.offset),
+                qualifiedName + "::" + member.name);
+    }
+    if (!hasRuntimeArray)
+      assertion("sizeof(" + qualifiedName + ") == " + std::to_string(size), qualifiedName);
+
+    std::set<std::string> nested;
+    for (const auto &member : structType.members) {
+      const auto &type = member.type.structType;
+      if (!type || !nested.insert(type->name).second)
+        continue;
+      const bool isArray = !member.type.arraySizes.empty();
+      layoutAsserts(qualifiedName + "::" + type->name, *type, isArray ? member.type.arrayStride : type->size);
+    }
+  }
+
+  std::ostringstream &out() { return _out; }
+
+private:
+  void assertion(const std::string &condition, const std::string &what) {
+    _out << "static_assert(" << condition << ", \"" << what << _message << "\");\n";
+  }
+
+  std::string _message;
+  std::ostringstream _out;
+};
+
+bool vertexFormat(const VertexInput &input, std::string *format) {
+  static const char *channels[] = {"R32", "R32G32", "R32G32B32", "R32G32B32A32"};
+  if (input.components < 1 || input.components > 4)
+    return false;
+  switch (input.scalar) {
+  case SCALAR_TYPE::FLOAT:
+    *format = std::string("VK_FORMAT_") + channels[input.components - 1] + "_SFLOAT";
+    return true;
+  case SCALAR_TYPE::INT:
+    *format = std::string("VK_FORMAT_") + channels[input.components - 1] + "_SINT";
+    return true;
+  case SCALAR_TYPE::UINT:
+    *format = std::string("VK_FORMAT_") + channels[input.components - 1] + "_UINT";
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+bool generateHeader(const std::string &name, const std::string &sourceFileName, const std::vector<ShaderStage> &stages,
+                    std::string *header, std::string *error) {
+  // the stages share most resources, the first stage that declares a binding or a block wins
+  std::map<std::pair<uint32_t, uint32_t>, Resource> bindings;
+  std::map<std::string, const Resource *> uniformBlocks, pushConstants, storageBlocks;
+  std::vector<VertexInput> vertexInputs;
+  for (const auto &stage : stages) {
+    for (const auto &resource : stage.reflection.resources) {
+      if (resource.type != RESOURCE_TYPE::PUSH_CONSTANT)
+        bindings.insert({{resource.set, resource.binding}, resource});
+    }
+    if (stage.reflection.isVertexShader)
+      vertexInputs = stage.reflection.vertexInputs;
+  }
+  for (const auto &stage : stages) {
+    for (const auto &resource : stage.reflection.resources) {
+      if (!resource.block)
+        continue;
+      if (resource.type == RESOURCE_TYPE::UNIFORM_BUFFER)
+        uniformBlocks.insert({resource.block->name, &resource});
+      else if (resource.type == RESOURCE_TYPE::PUSH_CONSTANT)
+        pushConstants.insert({resource.block->name, &resource});
+      else if (resource.type == RESOURCE_TYPE::STORAGE_BUFFER)
+        storageBlocks.insert({resource.block->name, &resource});
+    }
+  }
+
+  Writer writer(sourceFileName);
+  auto &out = writer.out();
+  out << "#pragma once\n\n";
+  out << "// Generated by mg-shader-compiler from " << sourceFileName << ", do not edit\n\n";
+  out << "#include \"vulkan/shaderPipelineInput.h\"\n";
+  out << "#include <cstddef>\n\n";
+  out << "namespace mg {\n";
+  out << "namespace shaders {\n";
+  out << "namespace " << name << " {\n\n";
+
+  for (const auto blocks : {&uniformBlocks, &pushConstants, &storageBlocks}) {
+    for (const auto &block : *blocks) {
+      const auto &structType = *block.second->block;
+      writer.structDefinition(structType, true, 0);
+      writer.layoutAsserts(structType.name, structType, structType.size);
+    }
+  }
+
+  if (!vertexInputs.empty()) {
+    out << "namespace InputAssembler {\n";
+    out << "  static VertexInputState vertexInputState[" << vertexInputs.size() << "] = {\n";
+    uint32_t offset = 0;
+    for (const auto &input : vertexInputs) {
+      std::string format;
+      if (!vertexFormat(input, &format)) {
+        *error = "vertex input " + input.name + " has no vertex format";
+        return false;
+      }
+      const uint32_t size = input.components * 4;
+      out << "    { " << format << ", " << input.location << ", " << offset << ", 0, " << size << " },\n";
+      offset += size;
+    }
+    out << "  };\n";
+    out << "  struct VertexInputData {\n";
+    for (const auto &input : vertexInputs) {
+      MemberType type = {};
+      type.scalar = input.scalar;
+      type.rows = input.components;
+      out << "    " << cppType(type) << " " << input.name << ";\n";
+    }
+    out << "  };\n";
+    out << "}\n";
+  }
+
+  // one descriptor set per set index, named after its first binding, buffers before images before samplers
+  std::map<uint32_t, const Resource *> sets;
+  for (const auto &binding : bindings) {
+    const auto &resource = binding.second;
+    auto &set = sets[resource.set];
+    if (!set || resource.type < set->type)
+      set = &resource;
+  }
+  if (!sets.empty()) {
+    out << "union DescriptorSets {\n";
+    out << "  struct {\n";
+    for (const auto &set : sets)
+      out << "    VkDescriptorSet " << set.second->name << ";\n";
+    out << "  };\n";
+    out << "  VkDescriptorSet values[" << sets.size() << "];\n";
+    out << "};\n";
+  }
+
+  std::vector<std::string> fileNames;
+  for (const auto &stage : stages)
+    fileNames.push_back(stage.fileName);
+  std::sort(std::begin(fileNames), std::end(fileNames));
+  out << "constexpr struct {\n";
+  for (const auto &fileName : fileNames) {
+    auto member = fileName.substr(0, fileName.size() - std::string(".spv").size());
+    std::replace(std::begin(member), std::end(member), '.', '_');
+    out << "  const char *" << member << " = \"" << fileName << "\";\n";
+  }
+  out << "} files = {};\n";
+  out << "constexpr const char *shader = \"" << name << "\";\n\n";
+
+  out << "} // namespace " << name << "\n";
+  out << "} // namespace shaders\n";
+  out << "} // namespace mg\n";
+  *header = out.str();
+  return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "spirvReflection.h"
+#include <string>
+#include <vector>
+
+struct ShaderStage {
+  std::string fileName; // solid.vert.spv
+  SpirvReflection reflection;
+};
+
+// The C++ side of one shader, namespace mg::shaders::name with the blocks, the descriptor sets, the vertex input and
+// the file names. Every block gets static_asserts that its size and member offsets match the std140/std430 layout
+// in the SPIR-V, a vec3 or a float array in a uniform block fails the build instead of reading garbage on the gpu.
+bool generateHeader(const std::string &name, const std::string &sourceFileName, const std::vector<ShaderStage> &stages,
+                    std::string *header, std::string *error);
@@ -0,0 +1,207 @@
+#include "glslSource.h"
+#include "headerGenerator.h"
+#include "shaderArchive.h"
+#include "spirvReflection.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Builds one shader source file for the mg-shaders target:
+// mg-shader-compiler --spirv-dir=DIR --header-dir=DIR --work-dir=DIR [--glslc=PATH] [--target-env=ENV] file
+// Every stage is compiled with glslc into DIR/name.stage.spv and the SPIR-V is reflected into DIR/name.h, which is
+// only written when it changed so the C++ files that include it are not rebuilt for a change inside a function.
+// work-dir gets the preprocessed stages, name.d with the included files for the build system and name.stamp.
+// Without --glslc the SPIR-V already in spirv-dir is reflected.
+// mg-shader-compiler --pack=FILE --spirv-dir=DIR stamp...
+// Packs the stages listed in the stamps of the compiled files into the shader archive FILE.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+  std::string glslc;
+  std::string targetEnv = "vulkan1.0";
+  fs::path spirvDir, headerDir, workDir, pack;
+  std::vector<std::string> inputs;
+};
+
+bool parseOptions(int argc, char **argv, Options *options) {
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const auto value = [&](const char *option, std::string *result) {
+      if (arg.rfind(option, 0) != 0)
+        return false;
+      *result = arg.substr(strlen(option));
+      return true;
+    };
+    std::string path;
+    if (value("--glslc=", &options->glslc) || value("--target-env=", &options->targetEnv))
+      continue;
+    if (value("--spirv-dir=", &path))
+      options->spirvDir = path;
+    else if (value("--header-dir=", &path))
+      options->headerDir = path;
+    else if (value("--work-dir=", &path))
+      options->workDir = path;
+    else if (value("--pack=", &path))
+      options->pack = path;
+    else if (arg.rfind("--", 0) == 0)
+      return false;
+    else
+      options->inputs.push_back(arg);
+  }
+  if (!options->pack.empty())
+    return !options->spirvDir.empty() && !options->inputs.empty();
+  return !options->spirvDir.empty() && !options->headerDir.empty() && !options->workDir.empty() &&
+         options->inputs.size() == 1;
+}
+
+bool readFile(const fs::path &path, std::string *content) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  *content = stream.str();
+  return true;
+}
+
+bool writeFile(const fs::path &path, const std::string &content) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << content;
+  return bool(file);
+}
+
+std::string quote(const std::string &string) { return "\"" + string + "\""; }
+
+bool compile(const Options &options, const GlslStage &stage, const fs::path &spirvPath) {
+  const auto stageSource = options.workDir / (spirvPath.stem().generic_string() + ".glsl");
+  if (!writeFile(stageSource, stage.source)) {
+    fprintf(stderr, "could not write %s\n", stageSource.generic_string().c_str());
+    return false;
+  }
+  auto command = quote(options.glslc) + " -fshader-stage=" + stage.stage + " --target-env=" + options.targetEnv +
+                 " -o " + quote(spirvPath.generic_string()) + " " + quote(stageSource.generic_string());
+#if defined(_WIN32)
+  // cmd strips the outer quotes of a command that starts with a quote
+  command = quote(command);
+#endif
+  return std::system(command.c_str()) == 0;
+}
+
+bool loadSpirv(const fs::path &path, std::vector<uint32_t> *words) {
+  std::string bytes;
+  if (!readFile(path, &bytes) || bytes.size() % sizeof(uint32_t) != 0)
+    return false;
+  words->resize(bytes.size() / sizeof(uint32_t));
+  memcpy(words->data(), bytes.data(), bytes.size());
+  return true;
+}
+
+std::string escapeDependency(const std::string &path) {
+  std::string escaped;
+  for (const auto c : path) {
+    if (c == ' ')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+// the stamps list the stages of their source, a stage of a source that was removed is not packed
+int pack(const Options &options) {
+  std::vector<std::string> fileNames;
+  for (const auto &stampPath : options.inputs) {
+    std::string stamp;
+    if (!readFile(stampPath, &stamp)) {
+      fprintf(stderr, "could not read %s\n", stampPath.c_str());
+      return 1;
+    }
+    std::istringstream lines(stamp);
+    for (std::string fileName; std::getline(lines, fileName);) {
+      if (!fileName.empty())
+        fileNames.push_back(fileName);
+    }
+  }
+  std::string error;
+  if (!packShaderArchive(options.spirvDir, fileNames, options.pack, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parseOptions(argc, argv, &options)) {
+    fprintf(stderr, "usage: mg-shader-compiler --spirv-dir=DIR --header-dir=DIR --work-dir=DIR [--glslc=PATH] "
+                    "[--target-env=ENV] file\n"
+                    "       mg-shader-compiler --pack=FILE --spirv-dir=DIR stamp...\n");
+    return 1;
+  }
+  if (!options.pack.empty())
+    return pack(options);
+  std::error_code errorCode;
+  for (const auto &directory : {options.spirvDir, options.headerDir, options.workDir})
+    fs::create_directories(directory, errorCode);
+
+  std::string error;
+  GlslSource source;
+  const auto &sourceFile = options.inputs.front();
+  if (!loadGlslSource(sourceFile, &source, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const auto sourcePath = fs::path(sourceFile);
+  const auto name = sourcePath.stem().generic_string();
+
+  std::vector<ShaderStage> stages;
+  for (const auto &glslStage : source.stages) {
+    const auto spirvPath = options.spirvDir / glslStage.fileName;
+    if (!options.glslc.empty() && !compile(options, glslStage, spirvPath)) {
+      fprintf(stderr, "%s: compiling %s failed\n", sourceFile.c_str(), glslStage.fileName.c_str());
+      return 1;
+    }
+    std::vector<uint32_t> words;
+    ShaderStage stage = {glslStage.fileName, {}};
+    if (!loadSpirv(spirvPath, &words) || !reflectSpirv(words, &stage.reflection, &error)) {
+      fprintf(stderr, "%s: %s %s\n", sourceFile.c_str(), spirvPath.generic_string().c_str(),
+              error.empty() ? "could not be read" : error.c_str());
+      return 1;
+    }
+    stages.push_back(std::move(stage));
+  }
+
+  std::string header;
+  if (!generateHeader(name, sourcePath.filename().generic_string(), stages, &header, &error)) {
+    fprintf(stderr, "%s: %s\n", sourceFile.c_str(), error.c_str());
+    return 1;
+  }
+  const auto headerPath = options.headerDir / (name + ".h");
+  std::string oldHeader;
+  if ((!readFile(headerPath, &oldHeader) || oldHeader != header) && !writeFile(headerPath, header)) {
+    fprintf(stderr, "could not write %s\n", headerPath.generic_string().c_str());
+    return 1;
+  }
+
+  const auto stampPath = options.workDir / (name + ".stamp");
+  std::string depfile = escapeDependency(fs::absolute(stampPath).generic_string()) + ":";
+  for (const auto &dependency : source.dependencies)
+    depfile += " \\\n  " + escapeDependency(dependency);
+  std::string stamp;
+  for (const auto &stage : stages)
+    stamp += stage.fileName + "\n";
+  if (!writeFile(options.workDir / (name + ".d"), depfile + "\n") || !writeFile(stampPath, stamp)) {
+    fprintf(stderr, "could not write to %s\n", options.workDir.generic_string().c_str());
+    return 1;
+  }
+  return 0;
+}
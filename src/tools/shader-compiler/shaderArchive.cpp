@@ -0,0 +1,73 @@
+#include "shaderArchive.h"
+
+#include "vulkan/shaderArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint32_t alignToWord(uint32_t size) { return (size + uint32_t(sizeof(uint32_t)) - 1) & ~uint32_t(sizeof(uint32_t) - 1); }
+
+} // namespace
+
+bool packShaderArchive(const fs::path &spirvDir, std::vector<std::string> fileNames, const fs::path &archivePath,
+                       std::string *error) {
+  std::sort(std::begin(fileNames), std::end(fileNames));
+  fileNames.erase(std::unique(std::begin(fileNames), std::end(fileNames)), std::end(fileNames));
+
+  std::vector<std::string> codes;
+  std::vector<mg::ShaderArchiveEntry> entries(fileNames.size());
+  uint32_t offset = uint32_t(sizeof(mg::ShaderArchiveHeader) + sizeof(mg::ShaderArchiveEntry) * fileNames.size());
+  for (size_t i = 0; i < fileNames.size(); i++) {
+    if (fileNames[i].size() >= sizeof(entries[i].fileName)) {
+      *error = "shader file name too long " + fileNames[i];
+      return false;
+    }
+    const auto path = spirvDir / fileNames[i];
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      *error = "could not read " + path.generic_string();
+      return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    codes.push_back(stream.str());
+
+    entries[i] = {};
+    strncpy(entries[i].fileName, fileNames[i].c_str(), sizeof(entries[i].fileName) - 1);
+    entries[i].offset = offset;
+    entries[i].size = uint32_t(codes[i].size());
+    offset = alignToWord(offset + entries[i].size);
+  }
+
+  const mg::ShaderArchiveHeader header = {mg::shaderArchiveMagic, mg::shaderArchiveVersion, uint32_t(entries.size()),
+                                          0};
+  auto tempPath = archivePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)entries.data(), std::streamsize(sizeof(mg::ShaderArchiveEntry) * entries.size()));
+    const char padding[sizeof(uint32_t)] = {};
+    for (size_t i = 0; i < codes.size(); i++) {
+      out.write(codes[i].data(), std::streamsize(codes[i].size()));
+      out.write(padding, std::streamsize(alignToWord(entries[i].size) - entries[i].size));
+    }
+    if (!out) {
+      *error = "could not write " + tempPath.generic_string();
+      return false;
+    }
+  }
+  std::error_code errorCode;
+  fs::rename(tempPath, archivePath, errorCode);
+  if (errorCode) {
+    *error = "could not write " + archivePath.generic_string() + ": " + errorCode.message();
+    return false;
+  }
+  return true;
+}
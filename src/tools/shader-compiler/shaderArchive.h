@@ -0,0 +1,10 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Packs the stages spirvDir/fileNames into the shaders.pack of vulkan/shaderArchive.h that the engine maps at startup.
+// The archive is written next to archivePath and renamed, a running engine keeps its mapping of the old one.
+bool packShaderArchive(const std::filesystem::path &spirvDir, std::vector<std::string> fileNames,
+                       const std::filesystem::path &archivePath, std::string *error);
@@ -0,0 +1,367 @@
+#include "spirvReflection.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr uint32_t HEADER_WORDS = 5;
+
+enum OP : uint32_t {
+  OP_NAME = 5,
+  OP_MEMBER_NAME = 6,
+  OP_ENTRY_POINT = 15,
+  OP_TYPE_BOOL = 20,
+  OP_TYPE_INT = 21,
+  OP_TYPE_FLOAT = 22,
+  OP_TYPE_VECTOR = 23,
+  OP_TYPE_MATRIX = 24,
+  OP_TYPE_IMAGE = 25,
+  OP_TYPE_SAMPLER = 26,
+  OP_TYPE_SAMPLED_IMAGE = 27,
+  OP_TYPE_ARRAY = 28,
+  OP_TYPE_RUNTIME_ARRAY = 29,
+  OP_TYPE_STRUCT = 30,
+  OP_TYPE_POINTER = 32,
+  OP_CONSTANT = 43,
+  OP_FUNCTION = 54,
+  OP_VARIABLE = 59,
+  OP_DECORATE = 71,
+  OP_MEMBER_DECORATE = 72,
+  OP_TYPE_ACCELERATION_STRUCTURE = 5341,
+};
+
+enum DECORATION : uint32_t {
+  DECORATION_BUFFER_BLOCK = 3,
+  DECORATION_ARRAY_STRIDE = 6,
+  DECORATION_MATRIX_STRIDE = 7,
+  DECORATION_BUILT_IN = 11,
+  DECORATION_LOCATION = 30,
+  DECORATION_BINDING = 33,
+  DECORATION_DESCRIPTOR_SET = 34,
+  DECORATION_OFFSET = 35,
+};
+
+enum STORAGE_CLASS : uint32_t {
+  STORAGE_CLASS_UNIFORM_CONSTANT = 0,
+  STORAGE_CLASS_INPUT = 1,
+  STORAGE_CLASS_UNIFORM = 2,
+  STORAGE_CLASS_PUSH_CONSTANT = 9,
+  STORAGE_CLASS_STORAGE_BUFFER = 12,
+};
+
+constexpr uint32_t EXECUTION_MODEL_VERTEX = 0;
+constexpr uint32_t IMAGE_SAMPLED_STORAGE = 2;
+
+using Decorations = std::unordered_map<uint32_t, uint32_t>;
+
+struct Instruction {
+  uint32_t op;
+  std::vector<uint32_t> operands;
+};
+
+struct Module {
+  std::unordered_map<uint32_t, std::string> names;
+  std::unordered_map<uint32_t, std::vector<std::string>> memberNames;
+  std::unordered_map<uint32_t, Decorations> decorations;
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, Decorations>> memberDecorations;
+  std::unordered_map<uint32_t, Instruction> types; // by result id
+  std::unordered_map<uint32_t, uint32_t> constants;
+  std::vector<Instruction> variables;
+  bool isVertexShader = false;
+
+  std::unordered_map<uint32_t, std::shared_ptr<const StructType>> structs;
+};
+
+std::string readString(const std::vector<uint32_t> &operands, size_t first) {
+  std::string string;
+  for (size_t i = first; i < operands.size(); i++) {
+    for (uint32_t byte = 0; byte < 4; byte++) {
+      const char c = char((operands[i] >> (byte * 8)) & 0xff);
+      if (c == '\0')
+        return string;
+      string += c;
+    }
+  }
+  return string;
+}
+
+bool hasDecoration(const Module &module, uint32_t id, uint32_t decoration) {
+  const auto it = module.decorations.find(id);
+  return it != module.decorations.end() && it->second.count(decoration);
+}
+
+uint32_t decoration(const Module &module, uint32_t id, uint32_t decoration) {
+  const auto it = module.decorations.find(id);
+  if (it == module.decorations.end())
+    return 0;
+  const auto value = it->second.find(decoration);
+  return value == it->second.end() ? 0 : value->second;
+}
+
+uint32_t memberDecoration(const Module &module, uint32_t id, uint32_t member, uint32_t decoration) {
+  const auto it = module.memberDecorations.find(id);
+  if (it == module.memberDecorations.end())
+    return 0;
+  const auto memberIt = it->second.find(member);
+  if (memberIt == it->second.end())
+    return 0;
+  const auto value = memberIt->second.find(decoration);
+  return value == memberIt->second.end() ? 0 : value->second;
+}
+
+const Instruction &type(const Module &module, uint32_t id) { return module.types.at(id); }
+
+// strips array and pointer types
+uint32_t baseType(const Module &module, uint32_t id) {
+  for (;;) {
+    const auto &instruction = type(module, id);
+    if (instruction.op == OP_TYPE_POINTER)
+      id = instruction.operands[2];
+    else if (instruction.op == OP_TYPE_ARRAY || instruction.op == OP_TYPE_RUNTIME_ARRAY)
+      id = instruction.operands[1];
+    else
+      return id;
+  }
+}
+
+bool scalarType(const Module &module, uint32_t id, SCALAR_TYPE *scalar) {
+  const auto &instruction = type(module, id);
+  switch (instruction.op) {
+  case OP_TYPE_BOOL:
+    *scalar = SCALAR_TYPE::BOOL;
+    return true;
+  case OP_TYPE_INT:
+    *scalar = instruction.operands[2] ? SCALAR_TYPE::INT : SCALAR_TYPE::UINT;
+    return true;
+  case OP_TYPE_FLOAT:
+    *scalar = instruction.operands[1] == 64 ? SCALAR_TYPE::DOUBLE : SCALAR_TYPE::FLOAT;
+    return true;
+  default:
+    return false;
+  }
+}
+
+std::shared_ptr<const StructType> structType(Module &module, uint32_t id);
+
+MemberType memberType(Module &module, uint32_t structId, uint32_t member, uint32_t id) {
+  MemberType memberType = {};
+  memberType.matrixStride = memberDecoration(module, structId, member, DECORATION_MATRIX_STRIDE);
+  for (;;) {
+    const auto &instruction = type(module, id);
+    if (instruction.op == OP_TYPE_ARRAY || instruction.op == OP_TYPE_RUNTIME_ARRAY) {
+      if (memberType.arraySizes.empty())
+        memberType.arrayStride = decoration(module, id, DECORATION_ARRAY_STRIDE);
+      const bool isRuntime = instruction.op == OP_TYPE_RUNTIME_ARRAY;
+      memberType.arraySizes.push_back(isRuntime ? 0 : module.constants.at(instruction.operands[2]));
+      id = instruction.operands[1];
+    } else if (instruction.op == OP_TYPE_MATRIX) {
+      memberType.columns = instruction.operands[2];
+      id = instruction.operands[1];
+    } else if (instruction.op == OP_TYPE_VECTOR) {
+      memberType.rows = instruction.operands[2];
+      id = instruction.operands[1];
+    } else if (instruction.op == OP_TYPE_STRUCT) {
+      memberType.structType = structType(module, id);
+      return memberType;
+    } else {
+      scalarType(module, id, &memberType.scalar);
+      return memberType;
+    }
+  }
+}
+
+uint32_t memberSize(const MemberType &type) {
+  if (type.arraySizes.empty())
+    return elementSize(type);
+  uint32_t count = 1;
+  for (const auto size : type.arraySizes)
+    count *= size;
+  return count == 0 ? 0 : type.arrayStride * type.arraySizes[0];
+}
+
+std::shared_ptr<const StructType> structType(Module &module, uint32_t id) {
+  const auto it = module.structs.find(id);
+  if (it != module.structs.end())
+    return it->second;
+
+  auto result = std::make_shared<StructType>();
+  result->name = module.names[id];
+  result->size = 0;
+  const auto &memberIds = type(module, id).operands;
+  const auto &memberNames = module.memberNames[id];
+  for (uint32_t i = 1; i < memberIds.size(); i++) {
+    StructMember member = {};
+    const uint32_t index = i - 1;
+    member.name = index < memberNames.size() ? memberNames[index] : "member" + std::to_string(index);
+    member.type = memberType(module, id, index, memberIds[i]);
+    member.offset = memberDecoration(module, id, index, DECORATION_OFFSET);
+    member.size = memberSize(member.type);
+    result->size = std::max(result->size, member.offset + member.size);
+    result->members.push_back(std::move(member));
+  }
+  module.structs[id] = result;
+  return result;
+}
+
+bool parse(const std::vector<uint32_t> &words, Module *module, std::string *error) {
+  if (words.size() < HEADER_WORDS || words[0] != SPIRV_MAGIC) {
+    *error = "not a SPIR-V module";
+    return false;
+  }
+  for (size_t i = HEADER_WORDS; i < words.size();) {
+    const uint32_t wordCount = words[i] >> 16;
+    const uint32_t op = words[i] & 0xffff;
+    if (wordCount == 0 || i + wordCount > words.size()) {
+      *error = "truncated SPIR-V instruction";
+      return false;
+    }
+    // every declaration comes before the first function
+    if (op == OP_FUNCTION)
+      break;
+    Instruction instruction = {op, std::vector<uint32_t>(words.begin() + i + 1, words.begin() + i + wordCount)};
+    const auto &operands = instruction.operands;
+    i += wordCount;
+
+    switch (op) {
+    case OP_NAME:
+      module->names[operands[0]] = readString(operands, 1);
+      break;
+    case OP_MEMBER_NAME: {
+      auto &names = module->memberNames[operands[0]];
+      names.resize(std::max(size_t(operands[1] + 1), names.size()));
+      names[operands[1]] = readString(operands, 2);
+      break;
+    }
+    case OP_ENTRY_POINT:
+      module->isVertexShader = module->isVertexShader || operands[0] == EXECUTION_MODEL_VERTEX;
+      break;
+    case OP_DECORATE:
+      module->decorations[operands[0]][operands[1]] = operands.size() > 2 ? operands[2] : 0;
+      break;
+    case OP_MEMBER_DECORATE:
+      module->memberDecorations[operands[0]][operands[1]][operands[2]] = operands.size() > 3 ? operands[3] : 0;
+      break;
+    case OP_TYPE_BOOL:
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+    case OP_TYPE_VECTOR:
+    case OP_TYPE_MATRIX:
+    case OP_TYPE_IMAGE:
+    case OP_TYPE_SAMPLER:
+    case OP_TYPE_SAMPLED_IMAGE:
+    case OP_TYPE_ARRAY:
+    case OP_TYPE_RUNTIME_ARRAY:
+    case OP_TYPE_STRUCT:
+    case OP_TYPE_POINTER:
+    case OP_TYPE_ACCELERATION_STRUCTURE:
+      module->types[operands[0]] = std::move(instruction);
+      break;
+    case OP_CONSTANT:
+      module->constants[operands[1]] = operands[2];
+      break;
+    case OP_VARIABLE:
+      module->variables.push_back(std::move(instruction));
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+bool classifyResource(const Module &module, uint32_t storageClass, uint32_t pointee, RESOURCE_TYPE *resourceType) {
+  const auto &instruction = type(module, pointee);
+  switch (storageClass) {
+  case STORAGE_CLASS_UNIFORM:
+    *resourceType = hasDecoration(module, pointee, DECORATION_BUFFER_BLOCK) ? RESOURCE_TYPE::STORAGE_BUFFER
+                                                                             : RESOURCE_TYPE::UNIFORM_BUFFER;
+    return true;
+  case STORAGE_CLASS_STORAGE_BUFFER:
+    *resourceType = RESOURCE_TYPE::STORAGE_BUFFER;
+    return true;
+  case STORAGE_CLASS_PUSH_CONSTANT:
+    *resourceType = RESOURCE_TYPE::PUSH_CONSTANT;
+    return true;
+  case STORAGE_CLASS_UNIFORM_CONSTANT:
+    switch (instruction.op) {
+    case OP_TYPE_SAMPLED_IMAGE:
+      *resourceType = RESOURCE_TYPE::SAMPLED_IMAGE;
+      return true;
+    case OP_TYPE_IMAGE:
+      *resourceType = instruction.operands[6] == IMAGE_SAMPLED_STORAGE ? RESOURCE_TYPE::STORAGE_IMAGE
+                                                                       : RESOURCE_TYPE::SEPARATE_IMAGE;
+      return true;
+    case OP_TYPE_SAMPLER:
+      *resourceType = RESOURCE_TYPE::SEPARATE_SAMPLER;
+      return true;
+    case OP_TYPE_ACCELERATION_STRUCTURE:
+      *resourceType = RESOURCE_TYPE::ACCELERATION_STRUCTURE;
+      return true;
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+uint32_t elementSize(const MemberType &type) {
+  if (type.structType)
+    return type.structType->size;
+  const uint32_t scalarSize = type.scalar == SCALAR_TYPE::DOUBLE ? 8 : 4;
+  if (type.columns > 1)
+    return type.columns * (type.matrixStride ? type.matrixStride : type.rows * scalarSize);
+  return type.rows * scalarSize;
+}
+
+bool reflectSpirv(const std::vector<uint32_t> &words, SpirvReflection *reflection, std::string *error) {
+  Module module;
+  if (!parse(words, &module, error))
+    return false;
+
+  *reflection = {};
+  reflection->isVertexShader = module.isVertexShader;
+  for (const auto &variable : module.variables) {
+    const uint32_t id = variable.operands[1];
+    const uint32_t storageClass = variable.operands[2];
+    const uint32_t pointee = baseType(module, variable.operands[0]);
+
+    if (storageClass == STORAGE_CLASS_INPUT) {
+      SCALAR_TYPE scalar;
+      if (!module.isVertexShader || hasDecoration(module, id, DECORATION_BUILT_IN) ||
+          !hasDecoration(module, id, DECORATION_LOCATION))
+        continue;
+      const auto &instruction = type(module, pointee);
+      const bool isVector = instruction.op == OP_TYPE_VECTOR;
+      if (!scalarType(module, isVector ? instruction.operands[1] : pointee, &scalar)) {
+        *error = "vertex input " + module.names[id] + " is not a scalar or a vector";
+        return false;
+      }
+      reflection->vertexInputs.push_back(
+          {module.names[id], decoration(module, id, DECORATION_LOCATION), scalar, isVector ? instruction.operands[2] : 1});
+      continue;
+    }
+
+    RESOURCE_TYPE resourceType;
+    if (!classifyResource(module, storageClass, pointee, &resourceType))
+      continue;
+    Resource resource = {};
+    resource.type = resourceType;
+    resource.name = module.names[id];
+    resource.set = decoration(module, id, DECORATION_DESCRIPTOR_SET);
+    resource.binding = decoration(module, id, DECORATION_BINDING);
+    if (type(module, pointee).op == OP_TYPE_STRUCT)
+      resource.block = structType(module, pointee);
+    // a block without an instance name, uniform Ubo { } ;
+    if (resource.name.empty() && resource.block)
+      resource.name = resource.block->name;
+    reflection->resources.push_back(std::move(resource));
+  }
+  std::sort(std::begin(reflection->vertexInputs), std::end(reflection->vertexInputs),
+            [](const auto &a, const auto &b) { return a.location < b.location; });
+  return true;
+}
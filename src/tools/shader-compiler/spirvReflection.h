@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The parts of a SPIR-V module the generated headers are made from. Only the instructions for names, decorations,
+// types and global variables are read, function bodies are skipped.
+
+enum class SCALAR_TYPE { FLOAT, INT, UINT, BOOL, DOUBLE };
+
+struct StructType;
+
+struct MemberType {
+  SCALAR_TYPE scalar;
+  uint32_t rows = 1;    // vector size, or rows of a matrix
+  uint32_t columns = 1; // columns of a matrix
+  uint32_t matrixStride = 0;
+  std::shared_ptr<const StructType> structType; // when the member is a struct
+  std::vector<uint32_t> arraySizes;             // outermost first, 0 for a runtime array
+  uint32_t arrayStride = 0;
+};
+
+struct StructMember {
+  std::string name;
+  MemberType type;
+  uint32_t offset;
+  uint32_t size; // bytes the member covers in the buffer, 0 for a runtime array
+};
+
+struct StructType {
+  std::string name;
+  std::vector<StructMember> members;
+  uint32_t size; // end of the last member, the layout's alignment padding is not included
+};
+
+enum class RESOURCE_TYPE {
+  UNIFORM_BUFFER,
+  STORAGE_BUFFER,
+  STORAGE_IMAGE,
+  SAMPLED_IMAGE,
+  ACCELERATION_STRUCTURE,
+  SEPARATE_IMAGE,
+  SEPARATE_SAMPLER,
+  PUSH_CONSTANT,
+};
+
+struct Resource {
+  RESOURCE_TYPE type;
+  std::string name; // the variable, ubo in uniform Ubo {} ubo
+  uint32_t set;
+  uint32_t binding;
+  std::shared_ptr<const StructType> block; // uniform, storage and push constant blocks
+};
+
+struct VertexInput {
+  std::string name;
+  uint32_t location;
+  SCALAR_TYPE scalar;
+  uint32_t components;
+};
+
+struct SpirvReflection {
+  bool isVertexShader;
+  std::vector<Resource> resources;
+  std::vector<VertexInput> vertexInputs; // sorted by location
+};
+
+// false and an error message if the words are not a SPIR-V module
+bool reflectSpirv(const std::vector<uint32_t> &words, SpirvReflection *reflection, std::string *error);
+
+// size in bytes of one element of a member, arrays not included
+uint32_t elementSize(const MemberType &type);